@@ -37,7 +37,10 @@
 #endif
 
 #include <QAbstractItemModel>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
 #include <QIODevice>
 #include <QLabel>
 #include <QModelIndex>
@@ -145,15 +148,38 @@ void startGpgProcess(QProcess *p, const QStringList &args, QIODevice::OpenModeFl
     p->start(gpgExecutable(), getDefaultEncryptCommandArguments(keys.pub) + args, mode);
 }
 
+/// Size and modification time of private key file last imported successfully.
+QString &importedKeyStats()
+{
+    static QString stats;
+    return stats;
+}
+
+QString keyFileStats(const QString &path)
+{
+    const QFileInfo info(path);
+    if ( !info.exists() )
+        return QString();
+
+    return QString::number(info.size()) + ":"
+            + QString::number(info.lastModified().toMSecsSinceEpoch());
+}
+
 QString importGpgKey()
 {
     KeyPairPaths keys;
 
+    // Avoid starting GnuPG before each decryption if the key was already imported.
+    const QString stats = keyFileStats(keys.sec);
+    if ( !stats.isEmpty() && stats == importedKeyStats() )
+        return QString();
+
     QProcess p;
     p.start(gpgExecutable(), getDefaultEncryptCommandArguments(keys.pub) << "--import" << keys.sec);
     if ( !verifyProcess(&p) )
         return "Failed to import private key (see log).";
 
+    importedKeyStats() = stats;
     return QString();
 }
 
@@ -254,6 +280,7 @@ QString exportImportGpgKeys()
     if ( !error.isEmpty() )
         return error;
 
+    importedKeyStats().clear();
     return importGpgKey();
 }
 
@@ -319,11 +346,23 @@ bool ItemEncryptedSaver::saveItems(const QString &, const QAbstractItemModel &mo
         }
     }
 
-    bytes = readGpgOutput(QStringList("--encrypt"), bytes);
-    if ( bytes.isEmpty() ) {
-        emitEncryptFailed();
-        COPYQ_LOG("ItemEncrypt ERROR: Failed to read encrypted data");
-        return false;
+    // Avoid encrypting again if nothing changed since last save.
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(bytes);
+    hash.addData( keyFileStats(KeyPairPaths().pub).toUtf8() );
+    const QByteArray dataHash = hash.result();
+
+    if ( dataHash == m_savedDataHash ) {
+        bytes = m_savedEncryptedBytes;
+    } else {
+        bytes = readGpgOutput(QStringList("--encrypt"), bytes);
+        if ( bytes.isEmpty() ) {
+            emitEncryptFailed();
+            COPYQ_LOG("ItemEncrypt ERROR: Failed to read encrypted data");
+            return false;
+        }
+        m_savedDataHash = dataHash;
+        m_savedEncryptedBytes = bytes;
     }
 
     QDataStream stream(file);
@@ -59,6 +59,11 @@ signals:
 
 private:
     void emitEncryptFailed();
+
+    /// Hash of last saved unencrypted data (including public key file stats).
+    QByteArray m_savedDataHash;
+    /// Last saved encrypted data.
+    QByteArray m_savedEncryptedBytes;
 };
 
 class ItemEncryptedScriptable : public ItemScriptable
@@ -65,6 +65,12 @@ public:
         connect( editor, &QTextEdit::cursorPositionChanged,
                  this, &TextEditWidget::onSelectionChanged );
 
+        // Only matches in visible part of document are highlighted.
+        connect( editor->verticalScrollBar(), &QScrollBar::valueChanged,
+                 this, &TextEditWidget::updateSearchSelection );
+        connect( editor->document(), &QTextDocument::contentsChanged,
+                 this, &TextEditWidget::updateSearchSelection );
+
         setLineWrappingEnabled(true);
 
         editor->viewport()->installEventFilter(this);
@@ -80,6 +86,9 @@ public:
 
     bool eventFilter(QObject *, QEvent *ev) override
     {
+        if ( ev->type() == QEvent::Resize )
+            updateSearchSelection();
+
         if ( ev->type() != QEvent::Paint )
             return false;
 
@@ -161,39 +170,8 @@ public:
 
     void highlightMatches(const QString &pattern)
     {
-        QTextCursor cur = editor()->textCursor();
-
-        Selection selection;
-        selection.format.setBackground(Qt::yellow);
-        selection.format.setForeground(Qt::black);
-
-        // Highlight matches.
-        QTextDocument *doc = editor()->document();
-        QRegExp re(pattern);
-        cur = doc->find(re);
-
-        m_searchSelection.clear();
-
-        int a = cur.position();
-        while ( !cur.isNull() ) {
-            if ( cur.hasSelection() ) {
-                selection.cursor = cur;
-                m_searchSelection.append(selection);
-            } else {
-                cur.movePosition(QTextCursor::NextCharacter);
-            }
-            cur = doc->find(re, cur);
-            int b = cur.position();
-            if (a == b) {
-                cur.movePosition(QTextCursor::NextCharacter);
-                cur = doc->find(re, cur);
-                b = cur.position();
-                if (a == b) break;
-            }
-            a = b;
-        }
-
-        updateSelections();
+        m_searchPattern = pattern;
+        updateSearchSelection();
     }
 
     void setBlockSelection(bool on)
@@ -250,6 +228,44 @@ private:
         editor()->document()->documentLayout()->draw(painter, m_context);
     }
 
+    void updateSearchSelection()
+    {
+        m_searchSelection.clear();
+
+        if ( !m_searchPattern.isEmpty() ) {
+            Selection selection;
+            selection.format.setBackground(Qt::yellow);
+            selection.format.setForeground(Qt::black);
+
+            // Highlight matches in visible blocks (matches don't span multiple blocks).
+            const QRegExp re(m_searchPattern);
+            const QRect rect = editor()->viewport()->rect();
+            const int begin = editor()->cursorForPosition(rect.topLeft()).position();
+            const int end = editor()->cursorForPosition(rect.bottomRight()).position();
+
+            QTextDocument *doc = editor()->document();
+            for ( auto block = doc->findBlock(begin);
+                  block.isValid() && block.position() <= end;
+                  block = block.next() )
+            {
+                const QString text = block.text();
+                int i = re.indexIn(text);
+                while (i != -1) {
+                    const int length = re.matchedLength();
+                    if (length > 0) {
+                        selection.cursor = QTextCursor(block);
+                        selection.cursor.setPosition(block.position() + i);
+                        selection.cursor.setPosition(block.position() + i + length, QTextCursor::KeepAnchor);
+                        m_searchSelection.append(selection);
+                    }
+                    i = re.indexIn(text, i + qMax(1, length));
+                }
+            }
+        }
+
+        updateSelections();
+    }
+
     void updateSelections()
     {
         m_context.selections.clear();
@@ -268,6 +284,7 @@ private:
     using SelectionList = QVector<Selection>;
     SelectionList m_searchSelection;
     SelectionList m_selection;
+    QString m_searchPattern;
 
     QAbstractTextDocumentLayout::PaintContext m_context;
 };
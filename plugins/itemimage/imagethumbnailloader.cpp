@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "imagethumbnailloader.h"
+
+#include "common/log.h"
+#include "common/textdata.h"
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QRunnable>
+
+namespace {
+
+/// Memory for cached thumbnails in KiB.
+const int maxThumbnailCacheCost = 64 * 1024;
+
+class DecodeThumbnailTask final : public QRunnable
+{
+public:
+    DecodeThumbnailTask(
+            ImageThumbnailLoader *receiver, quint64 key,
+            const QByteArray &data, const QString &mime, QSize maxSize)
+        : m_receiver(receiver)
+        , m_key(key)
+        , m_data(data)
+        , m_mime(mime)
+        , m_maxSize(maxSize)
+    {
+    }
+
+    void run() override
+    {
+        setCurrentThreadName("image");
+
+        QBuffer buffer(&m_data);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader( &buffer, m_mime.toLatin1() );
+
+        // Let the image reader scale while decoding if possible
+        // (JPEG or SVG images need not be decoded in full size).
+        const QSize originalSize = reader.size();
+        if ( originalSize.isValid() ) {
+            const QSize size = scaledImageSize(originalSize, m_maxSize);
+            if (size != originalSize)
+                reader.setScaledSize(size);
+        }
+
+        QImage image = reader.read();
+
+        const QSize size = scaledImageSize(image.size(), m_maxSize);
+        if ( !image.isNull() && size != image.size() )
+            image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+
+        // Receiver waits for all tasks before it is destroyed.
+        QMetaObject::invokeMethod(
+                    m_receiver, "onThumbnailDecoded", Qt::QueuedConnection,
+                    Q_ARG(quint64, m_key), Q_ARG(QImage, image) );
+    }
+
+private:
+    ImageThumbnailLoader *m_receiver;
+    quint64 m_key;
+    QByteArray m_data;
+    QString m_mime;
+    QSize m_maxSize;
+};
+
+} // namespace
+
+ImageThumbnailLoader::ImageThumbnailLoader(QObject *parent)
+    : QObject(parent)
+    , m_cache(maxThumbnailCacheCost)
+{
+}
+
+ImageThumbnailLoader::~ImageThumbnailLoader()
+{
+    m_pool.waitForDone();
+}
+
+quint64 ImageThumbnailLoader::thumbnailKey(const QByteArray &data, QSize maxSize)
+{
+    const quint64 seed = (static_cast<quint64>(maxSize.width()) << 32)
+            | static_cast<quint32>(maxSize.height());
+    return contentHash(data, seed);
+}
+
+QImage ImageThumbnailLoader::thumbnail(
+        quint64 key, const QByteArray &data, const QString &mime, QSize maxSize)
+{
+    const QImage *image = m_cache.object(key);
+    if (image)
+        return *image;
+
+    if ( !m_pending.contains(key) ) {
+        m_pending.insert(key);
+        m_pool.start( new DecodeThumbnailTask(this, key, data, mime, maxSize) );
+    }
+
+    return QImage();
+}
+
+void ImageThumbnailLoader::onThumbnailDecoded(quint64 key, const QImage &thumbnail)
+{
+    m_pending.remove(key);
+
+    if ( !thumbnail.isNull() )
+        m_cache.insert( key, new QImage(thumbnail), qMax(1, thumbnail.byteCount() / 1024) );
+
+    emit thumbnailReady(key, thumbnail);
+}
+
+QSize scaledImageSize(QSize size, QSize maxSize)
+{
+    const int w = maxSize.width();
+    const int h = maxSize.height();
+
+    if ( w > 0 && size.width() > w && (h <= 0 || 1.0 * size.width()/w > 1.0 * size.height()/h) )
+        return QSize( w, qMax(1, qRound(1.0 * size.height() * w / size.width())) );
+
+    if ( h > 0 && size.height() > h )
+        return QSize( qMax(1, qRound(1.0 * size.width() * h / size.height())), h );
+
+    return size;
+}
+
+QSize imageSize(const QByteArray &data, const QString &mime)
+{
+    QBuffer buffer;
+    buffer.setData(data);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader( &buffer, mime.toLatin1() );
+    return reader.size();
+}
@@ -0,0 +1,78 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef IMAGETHUMBNAILLOADER_H
+#define IMAGETHUMBNAILLOADER_H
+
+#include <QCache>
+#include <QImage>
+#include <QObject>
+#include <QSet>
+#include <QThreadPool>
+
+class QByteArray;
+class QString;
+
+/**
+ * Decodes and scales images in background and caches the results.
+ *
+ * Thumbnails are cached by image data and size, so they are shared between
+ * item widgets in all tabs. Memory used by the cache is limited and least
+ * recently used thumbnails are dropped first.
+ */
+class ImageThumbnailLoader final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageThumbnailLoader(QObject *parent = nullptr);
+
+    /** Waits for running tasks to finish. */
+    ~ImageThumbnailLoader();
+
+    /** Return key for image scaled down to fit @a maxSize (zero width/height is unlimited). */
+    static quint64 thumbnailKey(const QByteArray &data, QSize maxSize);
+
+    /**
+     * Return cached thumbnail.
+     *
+     * If thumbnail is not cached, returns null image, starts decoding
+     * the image in background and emits thumbnailReady() when done.
+     */
+    QImage thumbnail(quint64 key, const QByteArray &data, const QString &mime, QSize maxSize);
+
+signals:
+    /** Emitted when image is decoded (thumbnail is null if the image cannot be decoded). */
+    void thumbnailReady(quint64 key, const QImage &thumbnail);
+
+private:
+    Q_INVOKABLE void onThumbnailDecoded(quint64 key, const QImage &thumbnail);
+
+    QThreadPool m_pool;
+    QCache<quint64, QImage> m_cache;
+    QSet<quint64> m_pending;
+};
+
+/** Return size of image scaled down to fit @a maxSize (zero width/height is unlimited). */
+QSize scaledImageSize(QSize size, QSize maxSize);
+
+/** Return size of image without decoding it or invalid size if it cannot be determined. */
+QSize imageSize(const QByteArray &data, const QString &mime);
+
+#endif // IMAGETHUMBNAILLOADER_H
@@ -20,12 +20,15 @@
 #include "itemimage.h"
 #include "ui_itemimagesettings.h"
 
+#include "imagethumbnailloader.h"
+
 #include "common/contenttype.h"
 #include "common/mimetypes.h"
 #include "item/itemeditor.h"
 
 #include <QBuffer>
 #include <QHBoxLayout>
+#include <QImage>
 #include <QModelIndex>
 #include <QMovie>
 #include <QPainter>
@@ -78,22 +81,10 @@ bool getAnimatedImageData(const QVariantMap &dataMap, QByteArray *data, QByteArr
     return false;
 }
 
-bool getPixmapFromData(const QVariantMap &dataMap, QPixmap *pix)
-{
-    QString mime;
-    QByteArray data;
-    if ( !getImageData(dataMap, &data, &mime) )
-        return false;
-
-    pix->loadFromData( data, mime.toLatin1() );
-
-    return true;
-}
-
 } // namespace
 
 ItemImage::ItemImage(
-        const QPixmap &pix,
+        QSize imageSize,
         const QByteArray &animationData, const QByteArray &animationFormat,
         const QString &imageEditor, const QString &svgEditor,
         QWidget *parent)
@@ -101,13 +92,25 @@ ItemImage::ItemImage(
     , ItemWidget(this)
     , m_editor(imageEditor)
     , m_svgEditor(svgEditor)
-    , m_pixmap(pix)
+    , m_imageSize(imageSize)
     , m_animationData(animationData)
     , m_animationFormat(animationFormat)
     , m_animation(nullptr)
 {
     setMargin(4);
-    setPixmap(pix);
+}
+
+void ItemImage::setThumbnail(const QImage &image)
+{
+    m_pixmap = QPixmap::fromImage(image);
+    m_pixmap.setDevicePixelRatio( devicePixelRatio() );
+    if (!movie())
+        setPixmap(m_pixmap);
+
+    if ( m_imageSize != m_pixmap.size() ) {
+        m_imageSize = m_pixmap.size();
+        updateFixedSize();
+    }
 }
 
 QObject *ItemImage::createExternalEditor(const QModelIndex &index, QWidget *parent) const
@@ -125,45 +128,29 @@ QObject *ItemImage::createExternalEditor(const QModelIndex &index, QWidget *pare
 
 void ItemImage::updateSize(QSize, int)
 {
-    const auto m2 = 2 * margin();
-    const int ratio = devicePixelRatio();
-    const int w = (m_pixmap.width() + 1) / ratio + m2;
-    const int h = (m_pixmap.height() + 1) / ratio + m2;
-    setFixedSize( QSize(w, h) );
+    updateFixedSize();
 }
 
 void ItemImage::setCurrent(bool current)
 {
-    if (current) {
-        if ( !m_animationData.isEmpty() ) {
-            if (!m_animation) {
-                QBuffer *stream = new QBuffer(&m_animationData, this);
-                m_animation = new QMovie(stream, m_animationFormat, this);
-                m_animation->setScaledSize( m_pixmap.size() );
-            }
-
-            if (m_animation) {
-                setMovie(m_animation);
-                startAnimation();
-                m_animation->start();
-            }
-        }
-    } else {
-        stopAnimation();
-        setPixmap(m_pixmap);
-    }
+    m_isCurrent = current;
+    if (current)
+        playAnimation();
+    else
+        releaseAnimation();
 }
 
 void ItemImage::showEvent(QShowEvent *event)
 {
-    startAnimation();
+    if (m_isCurrent)
+        playAnimation();
     QLabel::showEvent(event);
 }
 
 void ItemImage::hideEvent(QHideEvent *event)
 {
     QLabel::hideEvent(event);
-    stopAnimation();
+    releaseAnimation();
 }
 
 void ItemImage::paintEvent(QPaintEvent *event)
@@ -180,19 +167,47 @@ void ItemImage::paintEvent(QPaintEvent *event)
     }
 }
 
-void ItemImage::startAnimation()
+void ItemImage::playAnimation()
+{
+    if ( m_animationData.isEmpty() )
+        return;
+
+    if (!m_animation) {
+        QBuffer *stream = new QBuffer(&m_animationData, this);
+        m_animation = new QMovie(stream, m_animationFormat, this);
+        m_animation->setScaledSize(m_imageSize);
+    }
+
+    if ( movie() != m_animation )
+        setMovie(m_animation);
+    m_animation->start();
+}
+
+void ItemImage::releaseAnimation()
 {
-    if (movie())
-        movie()->start();
+    if (!m_animation)
+        return;
+
+    // Free decoded frames, only the static thumbnail is shown
+    // until the item is current and visible again.
+    setPixmap(m_pixmap);
+    QIODevice *stream = m_animation->device();
+    delete m_animation;
+    m_animation = nullptr;
+    delete stream;
 }
 
-void ItemImage::stopAnimation()
+void ItemImage::updateFixedSize()
 {
-    if (movie())
-        movie()->stop();
+    const auto m2 = 2 * margin();
+    const int ratio = devicePixelRatio();
+    const int w = (m_imageSize.width() + 1) / ratio + m2;
+    const int h = (m_imageSize.height() + 1) / ratio + m2;
+    setFixedSize( QSize(w, h) );
 }
 
 ItemImageLoader::ItemImageLoader()
+    : m_thumbnailLoader(new ImageThumbnailLoader)
 {
 }
 
@@ -203,30 +218,42 @@ ItemWidget *ItemImageLoader::create(const QVariantMap &data, QWidget *parent, bo
     if ( data.value(mimeHidden).toBool() )
         return nullptr;
 
-    // TODO: Just check if image provided and load it in different thread.
-    QPixmap pix;
-    if ( !getPixmapFromData(data, &pix) )
+    QString mime;
+    QByteArray imageData;
+    if ( !getImageData(data, &imageData, &mime) )
         return nullptr;
 
-    pix.setDevicePixelRatio( parent->devicePixelRatio() );
-
-    // scale pixmap
     const int w = preview ? 0 : m_settings.value("max_image_width", 320).toInt();
     const int h = preview ? 0 : m_settings.value("max_image_height", 240).toInt();
-    if ( w > 0 && pix.width() > w && (h <= 0 || 1.0 * pix.width()/w > 1.0 * pix.height()/h) ) {
-        pix = pix.scaledToWidth(w, Qt::SmoothTransformation);
-    } else if (h > 0 && pix.height() > h) {
-        pix = pix.scaledToHeight(h, Qt::SmoothTransformation);
-    }
+    const QSize maxSize(w, h);
+
+    // Image is decoded and scaled in background unless it's cached.
+    const auto key = ImageThumbnailLoader::thumbnailKey(imageData, maxSize);
+    const QImage thumbnail = m_thumbnailLoader->thumbnail(key, imageData, mime, maxSize);
+    const QSize size = thumbnail.isNull()
+            ? scaledImageSize(imageSize(imageData, mime), maxSize)
+            : thumbnail.size();
 
     QByteArray animationData;
     QByteArray animationFormat;
     getAnimatedImageData(data, &animationData, &animationFormat);
 
-    return new ItemImage(pix,
-                         animationData, animationFormat,
-                         m_settings.value("image_editor").toString(),
-                         m_settings.value("svg_editor").toString(), parent);
+    auto item = new ItemImage(size,
+                              animationData, animationFormat,
+                              m_settings.value("image_editor").toString(),
+                              m_settings.value("svg_editor").toString(), parent);
+
+    if ( thumbnail.isNull() ) {
+        connect( m_thumbnailLoader.get(), &ImageThumbnailLoader::thumbnailReady,
+                 item, [item, key](quint64 readyKey, const QImage &image) {
+                     if (readyKey == key && !image.isNull())
+                         item->setThumbnail(image);
+                 });
+    } else {
+        item->setThumbnail(thumbnail);
+    }
+
+    return item;
 }
 
 QStringList ItemImageLoader::formatsToSave() const
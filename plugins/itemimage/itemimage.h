@@ -28,6 +28,7 @@
 
 #include <memory>
 
+class ImageThumbnailLoader;
 class QMovie;
 
 namespace Ui {
@@ -39,12 +40,20 @@ class ItemImage : public QLabel, public ItemWidget
     Q_OBJECT
 
 public:
+    /**
+     * Create image item with given pixel size.
+     *
+     * Nothing is drawn until setThumbnail() is called.
+     */
     ItemImage(
-            const QPixmap &pix,
+            QSize imageSize,
             const QByteArray &animationData, const QByteArray &animationFormat,
             const QString &imageEditor, const QString &svgEditor,
             QWidget *parent);
 
+    /** Set scaled image to display. */
+    void setThumbnail(const QImage &image);
+
     QWidget *createEditor(QWidget *) const override { return nullptr; }
 
     QObject *createExternalEditor(const QModelIndex &index, QWidget *parent) const override;
@@ -59,15 +68,18 @@ protected:
     void paintEvent(QPaintEvent *event) override;
 
 private:
-    void startAnimation();
-    void stopAnimation();
+    void playAnimation();
+    void releaseAnimation();
+    void updateFixedSize();
 
     QString m_editor;
     QString m_svgEditor;
+    QSize m_imageSize;
     QPixmap m_pixmap;
     QByteArray m_animationData;
     QByteArray m_animationFormat;
     QMovie *m_animation;
+    bool m_isCurrent = false;
 };
 
 class ItemImageLoader : public QObject, public ItemLoaderInterface
@@ -101,6 +113,7 @@ public:
 private:
     QVariantMap m_settings;
     std::unique_ptr<Ui::ItemImageSettings> ui;
+    std::unique_ptr<ImageThumbnailLoader> m_thumbnailLoader;
 };
 
 #endif // ITEMIMAGE_H
@@ -2,13 +2,16 @@ include(../plugins_common.pri)
 
 HEADERS += \
     itemimage.h \
+    imagethumbnailloader.h \
     ../../src/item/itemeditor.h
 SOURCES += \
     itemimage.cpp \
+    imagethumbnailloader.cpp \
     ../../src/item/itemeditor.cpp \
     ../../src/common/log.cpp \
     ../../src/common/mimetypes.cpp \
-    ../../src/common/temporaryfile.cpp
+    ../../src/common/temporaryfile.cpp \
+    ../../src/common/textdata.cpp
 FORMS   += itemimagesettings.ui
 TARGET   = $$qtLibraryTarget(itemimage)
 
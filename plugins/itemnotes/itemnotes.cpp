@@ -26,14 +26,14 @@
 #include "gui/iconfont.h"
 #include "gui/iconwidget.h"
 
+#include <QAbstractTextDocumentLayout>
 #include <QBoxLayout>
 #include <QLabel>
 #include <QModelIndex>
-#include <QMouseEvent>
 #include <QPainter>
+#include <QPaintEvent>
 #include <QTextCursor>
 #include <QTextDocument>
-#include <QTextEdit>
 #include <QTimer>
 #include <QToolTip>
 #include <QtPlugin>
@@ -74,11 +74,65 @@ QWidget *createIconWidget(const QByteArray &icon, QWidget *parent)
 
 } // namespace
 
+/**
+ * Read-only notes painted directly from text document.
+ *
+ * This is much cheaper to create and lay out than QTextEdit
+ * (no scroll area, viewport or text cursor handling).
+ */
+class NotesLabel final : public QWidget
+{
+public:
+    NotesLabel(const QString &text, QWidget *parent)
+        : QWidget(parent)
+    {
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+        m_document.setUndoRedoEnabled(false);
+        m_document.setPlainText(text);
+    }
+
+    const QTextDocument &document() const { return m_document; }
+
+    void setSelections(const QVector<QAbstractTextDocumentLayout::Selection> &selections)
+    {
+        m_selections = selections;
+        update();
+    }
+
+    void updateSize(int maximumWidth)
+    {
+        ensurePolished();
+        m_document.setDefaultFont(font());
+        m_document.setTextWidth(maximumWidth);
+        setFixedSize(
+                    static_cast<int>(m_document.idealWidth()) + 16,
+                    static_cast<int>(m_document.size().height()) );
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        QPainter painter(this);
+
+        QAbstractTextDocumentLayout::PaintContext context;
+        context.palette = palette();
+        context.palette.setColor( QPalette::Text, palette().color(foregroundRole()) );
+        context.clip = event->rect();
+        context.selections = m_selections;
+
+        m_document.documentLayout()->draw(&painter, context);
+    }
+
+private:
+    QTextDocument m_document;
+    QVector<QAbstractTextDocumentLayout::Selection> m_selections;
+};
+
 ItemNotes::ItemNotes(ItemWidget *childItem, const QString &text, const QByteArray &icon,
                      NotesPosition notesPosition, bool showToolTip)
     : QWidget( childItem->widget()->parentWidget() )
     , ItemWidget(this)
-    , m_notes(new QTextEdit(this))
+    , m_notes(new NotesLabel(text.left(defaultMaxBytes), this))
     , m_icon(nullptr)
     , m_childItem(childItem)
     , m_timerShowToolTip(nullptr)
@@ -95,18 +149,7 @@ ItemNotes::ItemNotes(ItemWidget *childItem, const QString &text, const QByteArra
     m_notes->setObjectName("item_child");
     m_notes->setProperty("CopyQ_item_type", "notes");
 
-    m_notes->setReadOnly(true);
-    m_notes->setUndoRedoEnabled(false);
-
-    m_notes->setFocusPolicy(Qt::NoFocus);
-    m_notes->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_notes->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    m_notes->setFrameStyle(QFrame::NoFrame);
-    m_notes->setContextMenuPolicy(Qt::NoContextMenu);
-
-    m_notes->viewport()->installEventFilter(this);
-
-    m_notes->setPlainText( text.left(defaultMaxBytes) );
+    m_notes->installEventFilter(this);
 
     if (notesPosition == NotesBeside)
         layout = new QHBoxLayout(this);
@@ -167,15 +210,16 @@ void ItemNotes::highlight(const QRegExp &re, const QFont &highlightFont, const Q
     m_childItem->setHighlight(re, highlightFont, highlightPalette);
 
     if (m_notes != nullptr) {
-        QList<QTextEdit::ExtraSelection> selections;
+        QVector<QAbstractTextDocumentLayout::Selection> selections;
 
         if ( !re.isEmpty() ) {
-            QTextEdit::ExtraSelection selection;
+            QAbstractTextDocumentLayout::Selection selection;
             selection.format.setBackground( highlightPalette.base() );
             selection.format.setForeground( highlightPalette.text() );
             selection.format.setFont(highlightFont);
 
-            QTextCursor cur = m_notes->document()->find(re);
+            const QTextDocument &document = m_notes->document();
+            QTextCursor cur = document.find(re);
             int a = cur.position();
             while ( !cur.isNull() ) {
                 if ( cur.hasSelection() ) {
@@ -184,11 +228,11 @@ void ItemNotes::highlight(const QRegExp &re, const QFont &highlightFont, const Q
                 } else {
                     cur.movePosition(QTextCursor::NextCharacter);
                 }
-                cur = m_notes->document()->find(re, cur);
+                cur = document.find(re, cur);
                 int b = cur.position();
                 if (a == b) {
                     cur.movePosition(QTextCursor::NextCharacter);
-                    cur = m_notes->document()->find(re, cur);
+                    cur = document.find(re, cur);
                     b = cur.position();
                     if (a == b) break;
                 }
@@ -196,7 +240,7 @@ void ItemNotes::highlight(const QRegExp &re, const QFont &highlightFont, const Q
             }
         }
 
-        m_notes->setExtraSelections(selections);
+        m_notes->setSelections(selections);
     }
 
     update();
@@ -235,14 +279,8 @@ void ItemNotes::updateSize(QSize maximumSize, int idealWidth)
 {
     setMaximumSize(maximumSize);
 
-    if (m_notes) {
-        const int w = maximumSize.width() - 2 * notesIndent - 8;
-        QTextDocument *doc = m_notes->document();
-        doc->setTextWidth(w);
-        m_notes->setFixedSize(
-                    static_cast<int>(doc->idealWidth()) + 16,
-                    static_cast<int>(doc->size().height()) );
-    }
+    if (m_notes)
+        m_notes->updateSize( maximumSize.width() - 2 * notesIndent - 8 );
 
     if (m_childItem != nullptr)
         m_childItem->updateSize(maximumSize, idealWidth);
@@ -275,7 +313,7 @@ bool ItemNotes::eventFilter(QObject *, QEvent *event)
     if ( event->type() == QEvent::Show && m_timerShowToolTip && m_isCurrent )
         m_timerShowToolTip->start();
 
-    return ItemWidget::filterMouseEvents(m_notes, event);
+    return false;
 }
 
 void ItemNotes::showToolTip()
@@ -348,6 +386,7 @@ ItemWidget *ItemNotesLoader::transform(ItemWidget *itemWidget, const QVariantMap
 
 bool ItemNotesLoader::matches(const QModelIndex &index, const QRegExp &re) const
 {
+    // Items without notes are known from stored formats without decoding item data.
     const QString text = index.data(contentType::notes).toString();
-    return re.indexIn(text) != -1;
+    return !text.isEmpty() && matchesFilter(re, text);
 }
@@ -31,7 +31,7 @@ namespace Ui {
 class ItemNotesSettings;
 }
 
-class QTextEdit;
+class NotesLabel;
 class QTimer;
 
 enum NotesPosition {
@@ -74,7 +74,7 @@ protected:
 private:
     void showToolTip();
 
-    QTextEdit *m_notes;
+    NotesLabel *m_notes;
     QWidget *m_icon;
     std::unique_ptr<ItemWidget> m_childItem;
     QTimer *m_timerShowToolTip;
@@ -207,6 +207,8 @@ ItemPinnedSaver::ItemPinnedSaver(QAbstractItemModel *model, QVariantMap &setting
              this, &ItemPinnedSaver::onRowsMoved );
     connect( model, &QAbstractItemModel::dataChanged,
              this, &ItemPinnedSaver::onDataChanged );
+    connect( model, &QAbstractItemModel::layoutChanged,
+             this, &ItemPinnedSaver::onLayoutChanged );
 
     updateLastPinned( 0, m_model->rowCount() );
 }
@@ -216,9 +218,24 @@ bool ItemPinnedSaver::saveItems(const QString &tabName, const QAbstractItemModel
     return m_saver->saveItems(tabName, model, file);
 }
 
+bool ItemPinnedSaver::canSaveItemsToJournal() const
+{
+    return m_saver->canSaveItemsToJournal();
+}
+
+bool ItemPinnedSaver::canSaveItemsInBackground() const
+{
+    return m_saver->canSaveItemsInBackground();
+}
+
 bool ItemPinnedSaver::canRemoveItems(const QList<QModelIndex> &indexList, QString *error)
 {
-    if ( !containsPinnedItems(indexList) )
+    // No need to check items below last pinned one.
+    const bool belowLastPinned = std::all_of(
+                std::begin(indexList), std::end(indexList),
+                [this](const QModelIndex &index) { return index.row() > m_lastPinned; } );
+
+    if ( belowLastPinned || !containsPinnedItems(indexList) )
         return m_saver->canRemoveItems(indexList, error);
 
     if (error) {
@@ -337,6 +354,15 @@ void ItemPinnedSaver::onDataChanged(const QModelIndex &topLeft, const QModelInde
     updateLastPinned( topLeft.row(), bottomRight.row() );
 }
 
+void ItemPinnedSaver::onLayoutChanged()
+{
+    if (!m_model)
+        return;
+
+    m_lastPinned = -1;
+    updateLastPinned( 0, m_model->rowCount() - 1 );
+}
+
 void ItemPinnedSaver::moveRow(int from, int to)
 {
     m_model->moveRow(QModelIndex(), from, QModelIndex(), to);
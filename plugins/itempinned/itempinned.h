@@ -79,6 +79,10 @@ public:
 
     bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file) override;
 
+    bool canSaveItemsToJournal() const override;
+
+    bool canSaveItemsInBackground() const override;
+
     bool canRemoveItems(const QList<QModelIndex> &indexList, QString *error) override;
 
     bool canMoveItems(const QList<QModelIndex> &indexList) override;
@@ -92,6 +96,7 @@ private:
     void onRowsRemoved(const QModelIndex &parent, int start, int end);
     void onRowsMoved(const QModelIndex &, int start, int end, const QModelIndex &, int destinationRow);
     void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void onLayoutChanged();
 
     void moveRow(int from, int to);
     void updateLastPinned(int from, int to);
@@ -0,0 +1,342 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsqlite.h"
+#include "ui_itemsqlitesettings.h"
+
+#include "common/config.h"
+#include "common/contenttype.h"
+#include "common/log.h"
+#include "item/serialize.h"
+
+#ifdef HAS_TESTS
+#   include "tests/itemsqlitetests.h"
+#endif
+
+#include <QAbstractItemModel>
+#include <QDataStream>
+#include <QIODevice>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QUuid>
+#include <QVector>
+
+namespace {
+
+const char dataFileHeader[] = "CopyQ_sqlite_tab";
+
+const char connectionName[] = "CopyQ_itemsqlite";
+
+const char configSqliteTabs[] = "sqlite_tabs";
+
+void logSqlError(const QString &message, const QSqlError &error)
+{
+    log( QString("ItemSqlite: %1: %2").arg(message, error.text()), LogError );
+}
+
+bool execQuery(QSqlQuery *query)
+{
+    if ( query->exec() )
+        return true;
+
+    logSqlError("Query failed", query->lastError());
+    return false;
+}
+
+/**
+ * Returns database shared by all tabs, creates tables if needed.
+ *
+ * Items of all tabs are in single table ordered by row, data of each item
+ * format are stored only once for all items with the same hash.
+ */
+QSqlDatabase openDatabase()
+{
+    if ( QSqlDatabase::contains(connectionName) )
+        return QSqlDatabase::database(connectionName);
+
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+    db.setDatabaseName( getConfigurationFilePath("_items.sqlite") );
+    if ( !db.open() ) {
+        logSqlError("Failed to open database", db.lastError());
+        return db;
+    }
+
+    QSqlQuery query(db);
+    const char *statements[] = {
+        "PRAGMA journal_mode=WAL",
+        "CREATE TABLE IF NOT EXISTS items ("
+            "tab TEXT NOT NULL, row INTEGER NOT NULL, hash INTEGER NOT NULL,"
+            " created INTEGER NOT NULL, last_used INTEGER NOT NULL,"
+            " PRIMARY KEY (tab, row))",
+        "CREATE INDEX IF NOT EXISTS items_hash ON items (hash)",
+        "CREATE TABLE IF NOT EXISTS formats ("
+            "hash INTEGER NOT NULL, mime TEXT NOT NULL, data BLOB NOT NULL,"
+            " PRIMARY KEY (hash, mime))",
+    };
+    for (const auto statement : statements) {
+        if ( !query.exec(QLatin1String(statement)) ) {
+            logSqlError("Failed to initialize database", query.lastError());
+            db.close();
+            break;
+        }
+    }
+
+    return db;
+}
+
+bool readTabId(QIODevice *file, QString *tabId)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    QString header;
+    stream >> header >> *tabId;
+
+    return stream.status() == QDataStream::Ok
+            && header == dataFileHeader
+            && !tabId->isEmpty();
+}
+
+} // namespace
+
+ItemSqliteSaver::ItemSqliteSaver(const QString &tabId, const QSet<quint64> &storedHashes)
+    : m_tabId(tabId)
+    , m_storedHashes(storedHashes)
+{
+}
+
+bool ItemSqliteSaver::saveItems(const QString &, const QAbstractItemModel &model, QIODevice *file)
+{
+    QSqlDatabase db = openDatabase();
+    if ( !db.isOpen() )
+        return false;
+
+    if ( !db.transaction() ) {
+        logSqlError("Failed to start transaction", db.lastError());
+        return false;
+    }
+
+    const int length = model.rowCount();
+    QSet<quint64> hashes;
+    hashes.reserve(length);
+
+    const auto updateItems = [&]() {
+        // Item order is always rewritten, it's fast since it doesn't contain item data.
+        QSqlQuery removeItems(db);
+        removeItems.prepare("DELETE FROM items WHERE tab = ?");
+        removeItems.addBindValue(m_tabId);
+        if ( !execQuery(&removeItems) )
+            return false;
+
+        QSqlQuery insertItem(db);
+        insertItem.prepare("INSERT INTO items (tab, row, hash, created, last_used) VALUES (?, ?, ?, ?, ?)");
+
+        QSqlQuery insertFormat(db);
+        insertFormat.prepare("INSERT OR IGNORE INTO formats (hash, mime, data) VALUES (?, ?, ?)");
+
+        for (int row = 0; row < length; ++row) {
+            const QModelIndex index = model.index(row, 0);
+            const quint64 hash = index.data(contentType::hash).toULongLong();
+            const qint64 storedHash = static_cast<qint64>(hash);
+
+            insertItem.bindValue(0, m_tabId);
+            insertItem.bindValue(1, row);
+            insertItem.bindValue(2, storedHash);
+            insertItem.bindValue(3, index.data(contentType::createdTime).toLongLong());
+            insertItem.bindValue(4, index.data(contentType::lastUsedTime).toLongLong());
+            if ( !execQuery(&insertItem) )
+                return false;
+
+            // Data of items loaded or saved earlier are already in database.
+            const bool isNewItem = !m_storedHashes.contains(hash) && !hashes.contains(hash);
+            hashes.insert(hash);
+            if (!isNewItem)
+                continue;
+
+            const QVariantMap data = index.data(contentType::data).toMap();
+            for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+                insertFormat.bindValue(0, storedHash);
+                insertFormat.bindValue(1, it.key());
+                insertFormat.bindValue(2, it.value().toByteArray());
+                if ( !execQuery(&insertFormat) )
+                    return false;
+            }
+        }
+
+        // Remove data not referenced by any tab only if some items were removed.
+        for (const auto hash : m_storedHashes) {
+            if ( hashes.contains(hash) )
+                continue;
+
+            QSqlQuery removeFormats(db);
+            if ( !removeFormats.exec("DELETE FROM formats WHERE hash NOT IN (SELECT hash FROM items)") ) {
+                logSqlError("Failed to remove item data", removeFormats.lastError());
+                return false;
+            }
+            break;
+        }
+
+        return true;
+    };
+
+    if ( !updateItems() ) {
+        db.rollback();
+        return false;
+    }
+
+    if ( !db.commit() ) {
+        logSqlError("Failed to commit transaction", db.lastError());
+        db.rollback();
+        return false;
+    }
+
+    m_storedHashes = hashes;
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << QString(dataFileHeader) << m_tabId;
+
+    return stream.status() == QDataStream::Ok;
+}
+
+ItemSqliteLoader::ItemSqliteLoader()
+{
+}
+
+ItemSqliteLoader::~ItemSqliteLoader()
+{
+    if ( QSqlDatabase::contains(connectionName) )
+        QSqlDatabase::removeDatabase(connectionName);
+}
+
+QVariantMap ItemSqliteLoader::applySettings()
+{
+    Q_ASSERT(ui != nullptr);
+    m_settings.insert( configSqliteTabs, ui->plainTextEditSqliteTabs->toPlainText().split('\n') );
+    return m_settings;
+}
+
+QWidget *ItemSqliteLoader::createSettingsWidget(QWidget *parent)
+{
+    ui.reset(new Ui::ItemSqliteSettings);
+    QWidget *w = new QWidget(parent);
+    ui->setupUi(w);
+
+    ui->plainTextEditSqliteTabs->setPlainText(
+                m_settings.value(configSqliteTabs).toStringList().join("\n") );
+
+    return w;
+}
+
+bool ItemSqliteLoader::canLoadItems(QIODevice *file) const
+{
+    QString tabId;
+    return readTabId(file, &tabId);
+}
+
+bool ItemSqliteLoader::canSaveItems(const QString &tabName) const
+{
+    const auto sqliteTabNames = m_settings.value(configSqliteTabs).toStringList();
+    return !tabName.isEmpty() && sqliteTabNames.contains(tabName);
+}
+
+ItemSaverPtr ItemSqliteLoader::loadItems(const QString &, QAbstractItemModel *model, QIODevice *file, int maxItems)
+{
+    QString tabId;
+    if ( !readTabId(file, &tabId) )
+        return nullptr;
+
+    QSqlDatabase db = openDatabase();
+    if ( !db.isOpen() )
+        return nullptr;
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    query.prepare(
+        "SELECT items.row, items.hash, items.created, items.last_used, formats.mime, formats.data"
+        " FROM items LEFT JOIN formats ON formats.hash = items.hash"
+        " WHERE items.tab = ? AND items.row < ?"
+        " ORDER BY items.row");
+    query.addBindValue(tabId);
+    query.addBindValue(maxItems - model->rowCount());
+    if ( !execQuery(&query) )
+        return nullptr;
+
+    // Items are decoded lazily as if loaded from tab file.
+    QVector<SerializedItemData> items;
+    QSet<quint64> hashes;
+    SerializedItemData item;
+    QVariantMap data;
+    int lastRow = -1;
+    const auto addItem = [&]() {
+        item.bytes = serializeData(data);
+        items.append(item);
+        data.clear();
+    };
+
+    while ( query.next() ) {
+        const int row = query.value(0).toInt();
+        if (row != lastRow) {
+            if (lastRow != -1)
+                addItem();
+            lastRow = row;
+
+            item = SerializedItemData();
+            item.hash = static_cast<quint64>( query.value(1).toLongLong() );
+            item.createdTime = query.value(2).toLongLong();
+            item.lastUsedTime = query.value(3).toLongLong();
+            hashes.insert(item.hash);
+        }
+
+        if ( !query.value(4).isNull() )
+            data.insert( query.value(4).toString(), query.value(5).toByteArray() );
+    }
+
+    if (lastRow != -1)
+        addItem();
+
+    if ( !items.isEmpty() && !model->insertRows(0, items.size()) )
+        return nullptr;
+
+    for (int i = 0; i < items.size(); ++i)
+        model->setData( model->index(i, 0), QVariant::fromValue(items[i]), contentType::serializedData );
+
+    return std::make_shared<ItemSqliteSaver>(tabId, hashes);
+}
+
+ItemSaverPtr ItemSqliteLoader::initializeTab(const QString &, QAbstractItemModel *, int)
+{
+    return std::make_shared<ItemSqliteSaver>( QUuid::createUuid().toString() );
+}
+
+QObject *ItemSqliteLoader::tests(const TestInterfacePtr &test) const
+{
+#ifdef HAS_TESTS
+    QVariantMap settings;
+    settings[configSqliteTabs] = QStringList() << ItemSqliteTests::testTabName();
+
+    QObject *tests = new ItemSqliteTests(test);
+    tests->setProperty("CopyQ_test_settings", settings);
+    return tests;
+#else
+    Q_UNUSED(test);
+    return nullptr;
+#endif
+}
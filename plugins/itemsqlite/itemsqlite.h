@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMSQLITE_H
+#define ITEMSQLITE_H
+
+#include "item/itemwidget.h"
+#include "gui/icons.h"
+
+#include <QSet>
+#include <QVariantMap>
+
+#include <memory>
+
+namespace Ui {
+class ItemSqliteSettings;
+}
+
+/**
+ * Saves items of a tab to SQLite database.
+ *
+ * Tab file contains only ID of the tab in database. Item data are stored
+ * in a table shared by all tabs and indexed by item hash, so only data of
+ * new items need to be written when saving.
+ */
+class ItemSqliteSaver final : public ItemSaverInterface
+{
+public:
+    explicit ItemSqliteSaver(const QString &tabId, const QSet<quint64> &storedHashes = QSet<quint64>());
+
+    bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file) override;
+
+private:
+    QString m_tabId;
+    /// Hashes of items of the tab which are already stored in database.
+    QSet<quint64> m_storedHashes;
+};
+
+class ItemSqliteLoader : public QObject, public ItemLoaderInterface
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID COPYQ_PLUGIN_ITEM_LOADER_ID)
+    Q_INTERFACES(ItemLoaderInterface)
+
+public:
+    ItemSqliteLoader();
+
+    ~ItemSqliteLoader();
+
+    QString id() const override { return "itemsqlite"; }
+    QString name() const override { return tr("SQLite Storage"); }
+    QString author() const override { return QString(); }
+    QString description() const override { return tr("Store items of selected tabs in SQLite database."); }
+    QVariant icon() const override { return QVariant(IconDatabase); }
+
+    QVariantMap applySettings() override;
+
+    void loadSettings(const QVariantMap &settings) override { m_settings = settings; }
+
+    QWidget *createSettingsWidget(QWidget *parent) override;
+
+    bool canLoadItems(QIODevice *file) const override;
+
+    bool canSaveItems(const QString &tabName) const override;
+
+    ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel *model, QIODevice *file, int maxItems) override;
+
+    ItemSaverPtr initializeTab(const QString &tabName, QAbstractItemModel *model, int maxItems) override;
+
+    QObject *tests(const TestInterfacePtr &test) const override;
+
+private:
+    QVariantMap m_settings;
+    std::unique_ptr<Ui::ItemSqliteSettings> ui;
+};
+
+#endif // ITEMSQLITE_H
@@ -0,0 +1,18 @@
+include(../plugins_common.pri)
+
+HEADERS += itemsqlite.h
+SOURCES += itemsqlite.cpp \
+    ../../src/common/config.cpp \
+    ../../src/common/log.cpp \
+    ../../src/common/mimetypes.cpp \
+    ../../src/common/textdata.cpp \
+    ../../src/item/serialize.cpp
+FORMS   += itemsqlitesettings.ui
+TARGET   = $$qtLibraryTarget(itemsqlite)
+
+QT += sql
+
+CONFIG(debug, debug|release) {
+    SOURCES += tests/itemsqlitetests.cpp
+    HEADERS += tests/itemsqlitetests.h
+}
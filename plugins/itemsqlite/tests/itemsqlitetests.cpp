@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsqlitetests.h"
+
+#include "tests/test_utils.h"
+
+ItemSqliteTests::ItemSqliteTests(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+QString ItemSqliteTests::testTabName()
+{
+    return testTab(1);
+}
+
+void ItemSqliteTests::initTestCase()
+{
+    TEST(m_test->initTestCase());
+}
+
+void ItemSqliteTests::cleanupTestCase()
+{
+    TEST(m_test->cleanupTestCase());
+}
+
+void ItemSqliteTests::init()
+{
+    TEST(m_test->init());
+}
+
+void ItemSqliteTests::cleanup()
+{
+    TEST( m_test->cleanup() );
+}
+
+void ItemSqliteTests::restoreItems()
+{
+    const auto tab = testTabName();
+    const Args args = Args("tab") << tab;
+
+    RUN(args << "add" << "C" << "B" << "A", "");
+    RUN(args << "write" << "1" << "text/plain" << "X" << "application/x-copyq-test" << "DATA", "");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "A\nX\nB\nC");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    RUN(args << "read" << "0" << "1" << "2" << "3", "A\nX\nB\nC");
+    RUN(args << "read" << "application/x-copyq-test" << "1", "DATA");
+}
+
+void ItemSqliteTests::removeItems()
+{
+    const auto tab = testTabName();
+    const Args args = Args("tab") << tab;
+
+    RUN(args << "add" << "C" << "B" << "A", "");
+    RUN(args << "remove" << "1", "");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    RUN(args << "read" << "0" << "1" << "2", "A\nC\n");
+    RUN(args << "add" << "B", "");
+    RUN(args << "read" << "0" << "1" << "2", "B\nA\nC");
+}
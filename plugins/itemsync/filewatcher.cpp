@@ -21,12 +21,17 @@
 
 #include "common/contenttype.h"
 #include "common/log.h"
+#include "common/textdata.h"
 #include "item/serialize.h"
 
 #include <QAbstractItemModel>
-#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDir>
+#include <QFileInfo>
+#include <QHash>
 #include <QMimeData>
+#include <QSet>
+#include <QtEndian>
 #include <QUrl>
 
 const char mimeExtensionMap[] = COPYQ_MIME_PREFIX_ITEMSYNC "mime-to-extension-map";
@@ -62,10 +67,47 @@ namespace {
 const char dataFileSuffix[] = "_copyq.dat";
 const char noteFileSuffix[] = "_note.txt";
 
-const int updateItemsIntervalMs = 5000; // Interval to update items after a file has changed.
+// Interval to check files if changes cannot be watched.
+const int updateItemsIntervalMs = 5000;
+// Interval to check files even if changes are watched (notifications can be lost).
+const int rescanItemsIntervalMs = 60000;
+// Delay update after change notification so multiple changes are handled at once.
+const int updateItemsAfterChangeMs = 500;
+// Delay writing item files so repeated changes of an item are written at once.
+const int writeItemFilesDelayMs = 500;
+// Avoid exhausting system limits for watched files.
+const int maxWatchedFiles = 1000;
+
+void startUpdateTimer(QTimer *timer, int intervalMs)
+{
+    // Periodic rescans don't need to be precise,
+    // let the system coalesce these with other wakeups.
+    timer->setTimerType(
+        intervalMs >= updateItemsIntervalMs ? Qt::VeryCoarseTimer : Qt::CoarseTimer);
+    timer->start(intervalMs);
+}
+// Number of items created at once; rest is created later so the tab is shown quickly.
+const int createItemsBatchSize = 100;
 
 const qint64 sizeLimit = 10 << 20;
 
+/// Returns sizes and modification times of files of an item (without reading the files).
+QString fileStats(const QDir &dir, const BaseNameExtensions &baseNameWithExts)
+{
+    const QString basePath = dir.absoluteFilePath(baseNameWithExts.baseName);
+
+    QString result;
+    for (const auto &ext : baseNameWithExts.exts) {
+        const QFileInfo info(basePath + ext.extension);
+        result.append( QString("%1:%2:%3\n")
+                       .arg(ext.extension)
+                       .arg(info.size())
+                       .arg(info.lastModified().toMSecsSinceEpoch()) );
+    }
+
+    return result;
+}
+
 FileFormat getFormatSettingsFromFileName(const QString &fileName,
                                          const QList<FileFormat> &formatSettings,
                                          QString *foundExt = nullptr)
@@ -180,18 +222,11 @@ Ext findByExtension(const QString &fileName, const QList<FileFormat> &formatSett
     return hasUserFormat ? Ext(QString(), mimeNoFormat) : Ext();
 }
 
-bool saveItemFile(const QString &filePath, const QByteArray &bytes,
-                  QStringList *existingFiles, bool hashChanged = true)
+void saveItemFile(const QString &filePath, const QByteArray &bytes,
+                  QStringList *existingFiles, FileWriter *writer, bool hashChanged = true)
 {
-    if ( !existingFiles->removeOne(filePath) || hashChanged ) {
-        QFile f(filePath);
-        if ( !f.open(QIODevice::WriteOnly) || f.write(bytes) == -1 ) {
-            log( QString("ItemSync: %1").arg(f.errorString()), LogError );
-            return false;
-        }
-    }
-
-    return true;
+    if ( !existingFiles->removeOne(filePath) || hashChanged )
+        writer->write(filePath, bytes);
 }
 
 bool canUseFile(QFileInfo &info)
@@ -359,39 +394,55 @@ bool FileWatcher::isOwnBaseName(const QString &baseName)
     return re.exactMatch(baseName);
 }
 
-void FileWatcher::removeFilesForRemovedIndex(const QString &tabPath, const QModelIndex &index)
+void FileWatcher::removeFilesForRemovedIndexes(const QString &tabPath, const QList<QModelIndex> &indexes)
 {
-    const QAbstractItemModel *model = index.model();
-    if (!model)
+    if ( indexes.isEmpty() )
         return;
 
-    const QString baseName = FileWatcher::getBaseName(index);
-    if ( baseName.isEmpty() )
+    // Avoid re-creating removed files later.
+    FileWriter::flushAll();
+
+    const QAbstractItemModel *model = indexes.first().model();
+    if (!model)
         return;
 
-    // Check if item is still present in list (drag'n'drop).
-    bool remove = true;
-    for (int i = 0; i < model->rowCount(); ++i) {
-        const QModelIndex index2 = model->index(i, 0);
-        if ( index2 != index && baseName == FileWatcher::getBaseName(index2) ) {
-            remove = false;
-            break;
-        }
+    // Collect files of all removed items first so the model is scanned only once.
+    QSet<int> removedRows;
+    QHash<QString, QVariantMap> baseNameToExtensions;
+    for (const auto &index : indexes) {
+        if ( index.model() != model )
+            continue;
+
+        removedRows.insert(index.row());
+
+        const QVariantMap itemData = index.data(contentType::data).toMap();
+        const QString baseName = FileWatcher::getBaseName(itemData);
+        if ( !baseName.isEmpty() )
+            baseNameToExtensions.insert( baseName, itemData.value(mimeExtensionMap).toMap() );
     }
-    if (!remove)
-        return;
 
-    const QVariantMap itemData = index.data(contentType::data).toMap();
-    const QVariantMap mimeToExtension = itemData.value(mimeExtensionMap).toMap();
-    if ( mimeToExtension.isEmpty() )
-        QFile::remove(tabPath + '/' + baseName);
-    else
-        removeFormatFiles(tabPath + '/' + baseName, mimeToExtension);
+    // Keep files of items still present in list (drag'n'drop).
+    for (int row = 0; row < model->rowCount() && !baseNameToExtensions.isEmpty(); ++row) {
+        if ( !removedRows.contains(row) )
+            baseNameToExtensions.remove( FileWatcher::getBaseName(model->index(row, 0)) );
+    }
+
+    for (auto it = baseNameToExtensions.constBegin(); it != baseNameToExtensions.constEnd(); ++it) {
+        const QString &baseName = it.key();
+        const QVariantMap &mimeToExtension = it.value();
+        if ( mimeToExtension.isEmpty() )
+            QFile::remove(tabPath + '/' + baseName);
+        else
+            removeFormatFiles(tabPath + '/' + baseName, mimeToExtension);
+    }
 }
 
 Hash FileWatcher::calculateHash(const QByteArray &bytes)
 {
-    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha1);
+    const quint64 hash = contentHash(bytes);
+    Hash result(sizeof(hash), Qt::Uninitialized);
+    qToLittleEndian(hash, reinterpret_cast<uchar *>(result.data()));
+    return result;
 }
 
 FileWatcher::FileWatcher(
@@ -409,18 +460,32 @@ FileWatcher::FileWatcher(
     , m_indexData()
     , m_maxItems(maxItems)
 {
-    m_updateTimer.setInterval(updateItemsIntervalMs);
-    m_updateTimer.setSingleShot(true);
+    // Use kernel notifications for changes in directory (new, removed and
+    // renamed files) and in item files, full rescan is just a fallback.
+    const bool watching = m_watcher.addPath(path);
+    m_rescanIntervalMs = watching ? rescanItemsIntervalMs : updateItemsIntervalMs;
+    m_updateAfterChangeMs = updateItemsAfterChangeMs;
+    m_writer.setDelay(writeItemFilesDelayMs);
 
 #ifdef HAS_TESTS
     // Use smaller update interval for tests.
-    if ( !qEnvironmentVariableIsEmpty("COPYQ_TEST_ID") )
-        m_updateTimer.setInterval(100);
+    if ( !qEnvironmentVariableIsEmpty("COPYQ_TEST_ID") ) {
+        m_rescanIntervalMs = 100;
+        m_updateAfterChangeMs = 100;
+    }
 #endif
 
+    m_updateTimer.setInterval(m_rescanIntervalMs);
+    m_updateTimer.setSingleShot(true);
+
     connect( &m_updateTimer, &QTimer::timeout,
              this, &FileWatcher::updateItems );
 
+    connect( &m_watcher, &QFileSystemWatcher::directoryChanged,
+             this, &FileWatcher::onFileSystemChanged );
+    connect( &m_watcher, &QFileSystemWatcher::fileChanged,
+             this, &FileWatcher::onFileSystemChanged );
+
     connect( m_model.data(), &QAbstractItemModel::rowsInserted,
              this, &FileWatcher::onRowsInserted );
     connect( m_model.data(), &QAbstractItemModel::rowsAboutToBeRemoved,
@@ -449,7 +514,23 @@ bool FileWatcher::lock()
 void FileWatcher::unlock()
 {
     m_valid = true;
-    m_updateTimer.start();
+    if ( !m_pendingFiles.isEmpty() )
+        startUpdateTimer(&m_updateTimer, 0);
+    else
+        startUpdateTimer(&m_updateTimer, m_changedWhileLocked ? m_updateAfterChangeMs : m_rescanIntervalMs);
+    m_changedWhileLocked = false;
+}
+
+bool FileWatcher::writePendingFiles(QString *error)
+{
+    m_writer.flush();
+
+    const QStringList errors = m_writer.takeErrors();
+    if ( errors.isEmpty() )
+        return true;
+
+    *error = errors.join("\n");
+    return false;
 }
 
 bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions &baseNameWithExts, int targetRow)
@@ -457,13 +538,14 @@ bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions
     QVariantMap dataMap;
     QVariantMap mimeToExtension;
 
+    const QString stats = fileStats(dir, baseNameWithExts);
     updateDataAndWatchFile(dir, baseNameWithExts, &dataMap, &mimeToExtension);
 
     if ( !mimeToExtension.isEmpty() ) {
         dataMap.insert( mimeBaseName, QFileInfo(baseNameWithExts.baseName).fileName() );
         dataMap.insert(mimeExtensionMap, mimeToExtension);
 
-        if ( !createItem(dataMap, targetRow) )
+        if ( !createItem(dataMap, targetRow, stats) )
             return false;
     }
 
@@ -472,12 +554,38 @@ bool FileWatcher::createItemFromFiles(const QDir &dir, const BaseNameExtensions
 
 void FileWatcher::createItemsFromFiles(const QDir &dir, const BaseNameExtensionsList &fileList)
 {
-    for (const auto &baseNameWithExts : fileList) {
-        if ( !createItemFromFiles(dir, baseNameWithExts, 0)
-             || m_model->rowCount() >= m_maxItems )
-        {
+    Q_UNUSED(dir);
+
+    // Items are inserted in reversed order (last file on top) and only
+    // the first ones fitting into the tab are created.
+    const int freeRows = m_maxItems - m_model->rowCount();
+    if (freeRows <= 0)
+        return;
+
+    m_pendingFiles = fileList.mid(0, freeRows);
+    m_pendingFilesTargetRow = 0;
+    createPendingItems();
+}
+
+void FileWatcher::createPendingItems()
+{
+    // Create top items first so these are visible as soon as possible.
+    const QDir dir(m_path);
+    for ( int i = 0; i < createItemsBatchSize && !m_pendingFiles.isEmpty(); ++i ) {
+        if ( m_model->rowCount() >= m_maxItems ) {
+            m_pendingFiles.clear();
             break;
         }
+
+        const int rowCount = m_model->rowCount();
+        const int targetRow = qMin(m_pendingFilesTargetRow, rowCount);
+        if ( !createItemFromFiles(dir, m_pendingFiles.takeLast(), targetRow) ) {
+            m_pendingFiles.clear();
+            break;
+        }
+
+        if ( m_model->rowCount() > rowCount )
+            m_pendingFilesTargetRow = targetRow + 1;
     }
 }
 
@@ -486,6 +594,17 @@ void FileWatcher::updateItems()
     if ( !lock() )
         return;
 
+    // Finish creating items from previous update before looking for changes,
+    // otherwise files not yet added would be treated as new.
+    if ( !m_pendingFiles.isEmpty() ) {
+        createPendingItems();
+        unlock();
+        return;
+    }
+
+    // Compare items with files written so far.
+    m_writer.flush();
+
     const QDir dir(m_path);
     const QStringList files = listFiles(dir, QDir::Time | QDir::Reversed);
     BaseNameExtensionsList fileList = listFiles(files, m_formatSettings);
@@ -499,8 +618,16 @@ void FileWatcher::updateItems()
 
         QVariantMap dataMap;
         QVariantMap mimeToExtension;
+        QString stats;
 
         if ( i < fileList.size() ) {
+            // Avoid reading files which haven't changed since last time.
+            stats = fileStats(dir, fileList[i]);
+            if ( !stats.isEmpty() && stats == indexData(index).fileStats ) {
+                fileList.removeAt(i);
+                continue;
+            }
+
             updateDataAndWatchFile(dir, fileList[i], &dataMap, &mimeToExtension);
             fileList.removeAt(i);
         }
@@ -511,6 +638,7 @@ void FileWatcher::updateItems()
             dataMap.insert(mimeBaseName, baseName);
             dataMap.insert(mimeExtensionMap, mimeToExtension);
             updateIndexData(index, dataMap);
+            indexData(index).fileStats = stats;
         }
     }
 
@@ -519,6 +647,37 @@ void FileWatcher::updateItems()
     unlock();
 }
 
+void FileWatcher::onFileSystemChanged(const QString &path)
+{
+    // Removed or replaced files are no longer watched.
+    if ( m_watchedFiles.remove(path) )
+        m_watcher.removePath(path);
+
+    // Files written by this object are replaced so these need to be watched again.
+    if ( m_writer.isOwnChange(path) ) {
+        if (path != m_path)
+            watchFile(path);
+        return;
+    }
+
+    if (!m_valid) {
+        m_changedWhileLocked = true;
+        return;
+    }
+
+    if ( !m_updateTimer.isActive() || m_updateTimer.remainingTime() > m_updateAfterChangeMs )
+        startUpdateTimer(&m_updateTimer, m_updateAfterChangeMs);
+}
+
+void FileWatcher::watchFile(const QString &filePath)
+{
+    if ( m_watchedFiles.size() >= maxWatchedFiles || m_watchedFiles.contains(filePath) )
+        return;
+
+    if ( m_watcher.addPath(filePath) )
+        m_watchedFiles.insert(filePath);
+}
+
 void FileWatcher::onRowsInserted(const QModelIndex &, int first, int last)
 {
     saveItems(first, last);
@@ -531,14 +690,17 @@ void FileWatcher::onDataChanged(const QModelIndex &a, const QModelIndex &b)
 
 void FileWatcher::onRowsRemoved(const QModelIndex &, int first, int last)
 {
+    QList<QModelIndex> indexesToRemoveFiles;
     for ( const auto &index : indexList(first, last) ) {
         Q_ASSERT(index.isValid());
         IndexDataList::iterator it = findIndexData(index);
         Q_ASSERT( it != m_indexData.end() );
         if ( isOwnBaseName(it->baseName) )
-            removeFilesForRemovedIndex(m_path, index);
+            indexesToRemoveFiles.append(index);
         m_indexData.erase(it);
     }
+
+    removeFilesForRemovedIndexes(m_path, indexesToRemoveFiles);
 }
 
 FileWatcher::IndexDataList::iterator FileWatcher::findIndexData(const QModelIndex &index)
@@ -554,12 +716,13 @@ FileWatcher::IndexData &FileWatcher::indexData(const QModelIndex &index)
     return *it;
 }
 
-bool FileWatcher::createItem(const QVariantMap &dataMap, int targetRow)
+bool FileWatcher::createItem(const QVariantMap &dataMap, int targetRow, const QString &fileStats)
 {
     const int row = qMax( 0, qMin(targetRow, m_model->rowCount()) );
     if ( m_model->insertRow(row) ) {
         const QModelIndex &index = m_model->index(row, 0);
         updateIndexData(index, dataMap);
+        indexData(index).fileStats = fileStats;
         return true;
     }
 
@@ -651,8 +814,7 @@ void FileWatcher::saveItems(int first, int last)
             } else {
                 mimeToExtension.insert(format, ext);
                 const Hash oldHash = indexData(index).formatHash.value(format);
-                if ( !saveItemFile(filePath + ext, bytes, &existingFiles, hash != oldHash) )
-                    return;
+                saveItemFile(filePath + ext, bytes, &existingFiles, &m_writer, hash != oldHash);
             }
         }
 
@@ -666,8 +828,7 @@ void FileWatcher::saveItems(int first, int last)
         if ( mimeToExtension.isEmpty() || !dataMapUnknown.isEmpty() ) {
             mimeToExtension.insert(mimeUnknownFormats, dataFileSuffix);
             QByteArray data = serializeData(dataMapUnknown);
-            if ( !saveItemFile(filePath + dataFileSuffix, data, &existingFiles) )
-                return;
+            saveItemFile(filePath + dataFileSuffix, data, &existingFiles, &m_writer);
         }
 
         if ( !noSaveData.isEmpty() || mimeToExtension != oldMimeToExtension ) {
@@ -680,7 +841,10 @@ void FileWatcher::saveItems(int first, int last)
             updateIndexData(index, itemData);
 
             // Remove files of removed formats.
-            removeFormatFiles(filePath, oldMimeToExtension);
+            if ( !oldMimeToExtension.isEmpty() ) {
+                m_writer.flush();
+                removeFormatFiles(filePath, oldMimeToExtension);
+            }
         }
     }
 
@@ -703,6 +867,8 @@ bool FileWatcher::renameMoveCopy(const QDir &dir, const QList<QPersistentModelIn
         bool newItem = olderBaseName.isEmpty();
         bool itemRenamed = olderBaseName != baseName;
         if ( newItem || itemRenamed ) {
+            // Unique name is based on existing files.
+            m_writer.flush();
             if ( !renameToUnique(dir, baseNames, &baseName, m_formatSettings) )
                 return false;
             itemRenamed = olderBaseName != baseName;
@@ -714,6 +880,10 @@ bool FileWatcher::renameMoveCopy(const QDir &dir, const QList<QPersistentModelIn
         bool copyFilesFromOtherTab = !syncPath.isEmpty() && syncPath != m_path;
 
         if (copyFilesFromOtherTab || itemRenamed) {
+            // Copy or move complete files.
+            if (copyFilesFromOtherTab)
+                FileWriter::flushAll();
+
             const QVariantMap mimeToExtension = itemData.value(mimeExtensionMap).toMap();
             const QString newBasePath = m_path + '/' + baseName;
 
@@ -753,6 +923,8 @@ void FileWatcher::updateDataAndWatchFile(const QDir &dir, const BaseNameExtensio
         if ( !f.open(QIODevice::ReadOnly) )
             continue;
 
+        watchFile( f.fileName() );
+
         if ( ext.extension == dataFileSuffix && deserializeData(dataMap, f.readAll()) ) {
             mimeToExtension->insert(mimeUnknownFormats, dataFileSuffix);
         } else if ( f.size() > sizeLimit || ext.format.startsWith(mimeNoFormat)
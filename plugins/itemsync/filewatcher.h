@@ -20,11 +20,15 @@
 #ifndef FILEWATCHER_H
 #define FILEWATCHER_H
 
+#include "filewriter.h"
+
 #include "common/mimetypes.h"
 
+#include <QFileSystemWatcher>
 #include <QObject>
 #include <QPointer>
 #include <QPersistentModelIndex>
+#include <QSet>
 #include <QStringList>
 #include <QTimer>
 #include <QVector>
@@ -67,7 +71,10 @@ public:
      */
     static bool isOwnBaseName(const QString &baseName);
 
-    static void removeFilesForRemovedIndex(const QString &tabPath, const QModelIndex &index);
+    /**
+     * Remove files of multiple removed items, scanning the model only once.
+     */
+    static void removeFilesForRemovedIndexes(const QString &tabPath, const QList<QModelIndex> &indexes);
 
     static Hash calculateHash(const QByteArray &bytes);
 
@@ -84,6 +91,13 @@ public:
 
     void unlock();
 
+    /**
+     * Write queued item files and wait for writing to finish.
+     *
+     * Returns false and sets @a error if writing any file failed since last call.
+     */
+    bool writePendingFiles(QString *error);
+
     bool createItemFromFiles(const QDir &dir, const BaseNameExtensions &baseNameWithExts, int targetRow);
 
     void createItemsFromFiles(const QDir &dir, const BaseNameExtensionsList &fileList);
@@ -100,10 +114,18 @@ private:
 
     void onRowsRemoved(const QModelIndex &, int first, int last);
 
+    void onFileSystemChanged(const QString &path);
+
+    void watchFile(const QString &filePath);
+
+    void createPendingItems();
+
     struct IndexData {
         QPersistentModelIndex index;
         QString baseName;
         QMap<QString, Hash> formatHash;
+        /// Sizes and modification times of item files when last read.
+        QString fileStats;
 
         IndexData() {}
         explicit IndexData(const QModelIndex &index) : index(index) {}
@@ -116,7 +138,7 @@ private:
 
     IndexData &indexData(const QModelIndex &index);
 
-    bool createItem(const QVariantMap &dataMap, int targetRow);
+    bool createItem(const QVariantMap &dataMap, int targetRow, const QString &fileStats);
 
     void updateIndexData(const QModelIndex &index, const QVariantMap &itemData);
 
@@ -134,11 +156,20 @@ private:
 
     QPointer<QAbstractItemModel> m_model;
     QTimer m_updateTimer;
+    int m_rescanIntervalMs;
+    int m_updateAfterChangeMs;
+    bool m_changedWhileLocked = false;
+    QFileSystemWatcher m_watcher;
+    QSet<QString> m_watchedFiles;
+    FileWriter m_writer;
     const QList<FileFormat> &m_formatSettings;
     QString m_path;
     bool m_valid;
     IndexDataList m_indexData;
     int m_maxItems;
+    /// Files for items which will be created in next update (last file is inserted first).
+    BaseNameExtensionsList m_pendingFiles;
+    int m_pendingFilesTargetRow = 0;
 };
 
 #endif // FILEWATCHER_H
@@ -0,0 +1,211 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filewriter.h"
+
+#include "common/log.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
+
+namespace {
+
+// Change notifications for written files are ignored for this long after writing.
+const int ownChangesIntervalMs = 1000;
+
+QThreadPool *writeThreadPool()
+{
+    static QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    return &pool;
+}
+
+QList<FileWriter*> &fileWriters()
+{
+    static QList<FileWriter*> writers;
+    return writers;
+}
+
+QString normalizedPath(const QString &path)
+{
+    return QFileInfo(path).absoluteFilePath();
+}
+
+class WriteFilesTask final : public QRunnable
+{
+public:
+    WriteFilesTask(FileWriter *receiver, const QMap<QString, QByteArray> &files)
+        : m_receiver(receiver)
+        , m_files(files)
+    {
+    }
+
+    void run() override
+    {
+        setCurrentThreadName("itemsync");
+
+        QStringList errors;
+        for (auto it = m_files.constBegin(); it != m_files.constEnd(); ++it) {
+            QSaveFile f( it.key() );
+            if ( !f.open(QIODevice::WriteOnly) || f.write(it.value()) == -1 || !f.commit() ) {
+                const QString error = QString("Failed to write \"%1\": %2")
+                        .arg(it.key(), f.errorString());
+                log( QString("ItemSync: %1").arg(error), LogError );
+                errors.append(error);
+            }
+        }
+
+        m_receiver->taskFinished(errors);
+    }
+
+private:
+    FileWriter *m_receiver;
+    QMap<QString, QByteArray> m_files;
+};
+
+} // namespace
+
+FileWriter::FileWriter(QObject *parent)
+    : QObject(parent)
+{
+    fileWriters().append(this);
+
+    m_timerWrite.setSingleShot(true);
+    connect( &m_timerWrite, &QTimer::timeout,
+             this, &FileWriter::startWriting );
+
+    m_timerOwnChanges.setSingleShot(true);
+    m_timerOwnChanges.setInterval(ownChangesIntervalMs);
+    connect( &m_timerOwnChanges, &QTimer::timeout,
+             this, &FileWriter::onOwnChangesTimeout );
+}
+
+FileWriter::~FileWriter()
+{
+    fileWriters().removeOne(this);
+    m_timerWrite.stop();
+    startWriting();
+    waitForTasks();
+}
+
+void FileWriter::write(const QString &filePath, const QByteArray &bytes)
+{
+    m_pendingFiles[filePath] = bytes;
+
+    if (m_delayMs <= 0)
+        flush();
+    else if ( !m_timerWrite.isActive() )
+        m_timerWrite.start(m_delayMs);
+}
+
+void FileWriter::flush()
+{
+    m_timerWrite.stop();
+    startWriting();
+    waitForTasks();
+    onTaskFinished();
+}
+
+void FileWriter::flushAll()
+{
+    for (auto writer : fileWriters())
+        writer->flush();
+}
+
+QStringList FileWriter::takeErrors()
+{
+    QMutexLocker lock(&m_mutex);
+    QStringList errors;
+    errors.swap(m_errors);
+    return errors;
+}
+
+bool FileWriter::isOwnChange(const QString &path) const
+{
+    return m_ownChangePaths.contains( normalizedPath(path) );
+}
+
+void FileWriter::taskFinished(const QStringList &errors)
+{
+    QMutexLocker lock(&m_mutex);
+    --m_runningTasks;
+    m_errors.append(errors);
+
+    // Object is valid until the waiting destructor gets the lock.
+    QMetaObject::invokeMethod(this, "onTaskFinished", Qt::QueuedConnection);
+    m_taskFinished.wakeAll();
+}
+
+void FileWriter::startWriting()
+{
+    if ( m_pendingFiles.isEmpty() )
+        return;
+
+    for (auto it = m_pendingFiles.constBegin(); it != m_pendingFiles.constEnd(); ++it) {
+        const QString filePath = normalizedPath( it.key() );
+        m_ownChangePaths.insert(filePath);
+        m_ownChangePaths.insert( QFileInfo(filePath).absolutePath() );
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        ++m_runningTasks;
+    }
+
+    COPYQ_LOG_VERBOSE( QString("ItemSync: Writing %1 files").arg(m_pendingFiles.size()) );
+
+    writeThreadPool()->start( new WriteFilesTask(this, m_pendingFiles) );
+    m_pendingFiles.clear();
+}
+
+void FileWriter::waitForTasks()
+{
+    QMutexLocker lock(&m_mutex);
+    while (m_runningTasks > 0)
+        m_taskFinished.wait(&m_mutex);
+}
+
+void FileWriter::onTaskFinished()
+{
+    if ( m_ownChangePaths.isEmpty() )
+        return;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_runningTasks > 0)
+            return;
+    }
+
+    // Keep ignoring notifications for a while since these can arrive late.
+    m_timerOwnChanges.start();
+}
+
+void FileWriter::onOwnChangesTimeout()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_runningTasks > 0)
+            return;
+    }
+
+    m_ownChangePaths.clear();
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEWRITER_H
+#define FILEWRITER_H
+
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QTimer>
+#include <QWaitCondition>
+
+/**
+ * Writes item files in a separate thread.
+ *
+ * Files are written after a short delay so repeated changes of a file are
+ * written only once. Each file is written to a temporary file which then
+ * replaces the original so other applications never see partial content.
+ *
+ * All files are written in single thread in the order these were queued.
+ */
+class FileWriter final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileWriter(QObject *parent = nullptr);
+
+    /** Writes remaining files and waits for writing to finish. */
+    ~FileWriter();
+
+    /**
+     * Set delay before writing queued files.
+     *
+     * If zero, files are written before write() returns.
+     */
+    void setDelay(int delayMs) { m_delayMs = delayMs; }
+
+    /** Queue writing @a bytes to @a filePath (replaces previously queued content). */
+    void write(const QString &filePath, const QByteArray &bytes);
+
+    /** Write all queued files and block until finished. */
+    void flush();
+
+    /** Write queued files of all writers and block until finished. */
+    static void flushAll();
+
+    /**
+     * Return errors of failed writes since last call.
+     *
+     * Files are written in other thread so this is the only way for caller to
+     * find out that writing failed.
+     */
+    QStringList takeErrors();
+
+    /**
+     * Return true if change notification for @a path (a file or its directory)
+     * is likely caused by files written recently by this object.
+     */
+    bool isOwnChange(const QString &path) const;
+
+    /** Called from writing thread (do not call directly). */
+    void taskFinished(const QStringList &errors);
+
+private:
+    void startWriting();
+
+    void waitForTasks();
+
+    Q_INVOKABLE void onTaskFinished();
+
+    void onOwnChangesTimeout();
+
+    // Accessed only from main thread.
+    int m_delayMs = 0;
+    QTimer m_timerWrite;
+    QTimer m_timerOwnChanges;
+    QMap<QString, QByteArray> m_pendingFiles;
+    QSet<QString> m_ownChangePaths;
+
+    // Guarded by mutex.
+    QMutex m_mutex;
+    QWaitCondition m_taskFinished;
+    int m_runningTasks = 0;
+    QStringList m_errors;
+};
+
+#endif // FILEWRITER_H
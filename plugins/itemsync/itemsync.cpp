@@ -25,6 +25,7 @@
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/contenttype.h"
+#include "common/textdata.h"
 #include "gui/iconselectbutton.h"
 #include "gui/icons.h"
 #include "gui/iconfont.h"
@@ -516,6 +517,15 @@ bool ItemSyncSaver::saveItems(const QString &tabName, const QAbstractItemModel &
         return false;
     }
 
+    // Item files are written in background.
+    QString error;
+    if ( !m_watcher->writePendingFiles(&error) ) {
+        log( tr("Failed to save files of tab \"%1\" to directory \"%2\": %3")
+             .arg(tabName, path, error),
+             LogError );
+        return false;
+    }
+
     QDir dir(path);
 
     for (int row = 0; row < model.rowCount(); ++row) {
@@ -564,8 +574,7 @@ void ItemSyncSaver::itemsRemovedByUser(const QList<QModelIndex> &indexList)
         return;
 
     // Remove unneeded files (remaining records in the hash map).
-    for (const auto &index : indexList)
-        FileWatcher::removeFilesForRemovedIndex(m_tabPath, index);
+    FileWatcher::removeFilesForRemovedIndexes(m_tabPath, indexList);
 }
 
 QVariantMap ItemSyncSaver::copyItem(const QAbstractItemModel &, const QVariantMap &itemData)
@@ -787,7 +796,7 @@ bool ItemSyncLoader::matches(const QModelIndex &index, const QRegExp &re) const
 {
     const QVariantMap dataMap = index.data(contentType::data).toMap();
     const QString text = dataMap.value(mimeBaseName).toString();
-    return re.indexIn(text) != -1;
+    return matchesFilter(re, text);
 }
 
 QObject *ItemSyncLoader::tests(const TestInterfacePtr &test) const
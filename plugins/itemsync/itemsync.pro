@@ -3,6 +3,7 @@ include(../plugins_common.pri)
 HEADERS += \
     itemsync.h \
     filewatcher.h \
+    filewriter.h \
     ../../src/gui/iconselectbutton.h \
     ../../src/gui/iconselectdialog.h \
     ../../src/gui/iconwidget.h
@@ -10,9 +11,11 @@ HEADERS += \
 SOURCES += \
     itemsync.cpp \
     filewatcher.cpp \
+    filewriter.cpp \
     ../../src/common/config.cpp \
     ../../src/common/log.cpp \
     ../../src/common/mimetypes.cpp \
+    ../../src/common/textdata.cpp \
     ../../src/gui/iconfont.cpp \
     ../../src/gui/iconselectbutton.cpp \
     ../../src/gui/iconselectdialog.cpp \
@@ -20,6 +20,7 @@
 #include "itemsynctests.h"
 
 #include "common/mimetypes.h"
+#include "common/sleeptimer.h"
 #include "tests/test_utils.h"
 
 #include <QDir>
@@ -114,6 +115,29 @@ QByteArray createFile(const TestDir &dir, const QString &fileName, const QByteAr
     return "";
 }
 
+/// Wait for item files which are written in background.
+QString waitForFiles(const TestDir &dir, const QString &expectedFiles)
+{
+    SleepTimer t(8000);
+    QString files;
+    do {
+        files = dir.files().join(sep);
+    } while (files != expectedFiles && t.sleep());
+    return files;
+}
+
+/// Wait for content of an item file which is written in background.
+QByteArray waitForFileContent(const TestDir &dir, const QString &fileName, const QByteArray &expectedContent)
+{
+    SleepTimer t(8000);
+    QByteArray content;
+    do {
+        FilePtr file = dir.file(fileName);
+        content = file->open(QIODevice::ReadOnly) ? file->readAll() : QByteArray();
+    } while (content != expectedContent && t.sleep());
+    return content;
+}
+
 } // namespace
 
 ItemSyncTests::ItemSyncTests(const TestInterfacePtr &test, QObject *parent)
@@ -205,8 +229,9 @@ void ItemSyncTests::itemsToFiles()
     RUN(args << "read" << "0" << "1" << "2", "C\nB\nA");
     RUN(args << "size", "3\n");
 
-    QCOMPARE( dir1.files().join(sep),
-              fileNameForId(0) + sep + fileNameForId(1) + sep + fileNameForId(2) );
+    const QString expectedFiles =
+            fileNameForId(0) + sep + fileNameForId(1) + sep + fileNameForId(2);
+    QCOMPARE( waitForFiles(dir1, expectedFiles), expectedFiles );
 }
 
 void ItemSyncTests::filesToItems()
@@ -248,12 +273,12 @@ void ItemSyncTests::removeOwnItems()
     const QString fileC = fileNameForId(2);
     const QString fileD = fileNameForId(3);
 
-    QCOMPARE( dir1.files().join(sep),
-              fileA
-              + sep + fileB
-              + sep + fileC
-              + sep + fileD
-              );
+    const QString expectedFiles =
+            fileA
+            + sep + fileB
+            + sep + fileC
+            + sep + fileD;
+    QCOMPARE( waitForFiles(dir1, expectedFiles), expectedFiles );
 
     // Move to test tab and select second and third item.
     RUN("setCurrentTab" << tab1, "");
@@ -352,12 +377,12 @@ void ItemSyncTests::removeFiles()
     const QString fileC = fileNameForId(2);
     const QString fileD = fileNameForId(3);
 
-    QCOMPARE( dir1.files().join(sep),
-              fileA
-              + sep + fileB
-              + sep + fileC
-              + sep + fileD
-              );
+    const QString expectedFiles =
+            fileA
+            + sep + fileB
+            + sep + fileC
+            + sep + fileD;
+    QCOMPARE( waitForFiles(dir1, expectedFiles), expectedFiles );
 
     FilePtr file = dir1.file(fileC);
     QVERIFY(file->open(QIODevice::ReadOnly));
@@ -385,19 +410,13 @@ void ItemSyncTests::modifyItems()
     RUN(args << "add" << "A" << "B" << "C" << "D", "");
 
     const QString fileC = fileNameForId(2);
-    FilePtr file = dir1.file(fileC);
-    QVERIFY(file->open(QIODevice::ReadOnly));
-    QCOMPARE(file->readAll().data(), QByteArray("C").data());
-    file->close();
+    QCOMPARE( waitForFileContent(dir1, fileC, "C").data(), QByteArray("C").data() );
 
     RUN(args << "keys" << "HOME" << "DOWN" << "F2" << ":XXX" << "F2", "");
     RUN(args << "size", "4\n");
     RUN(args << "read" << "0" << "1" << "2" << "3", "D,XXX,B,A");
 
-    file = dir1.file(fileC);
-    QVERIFY(file->open(QIODevice::ReadOnly));
-    QCOMPARE(file->readAll().data(), QByteArray("XXX").data());
-    file->close();
+    QCOMPARE( waitForFileContent(dir1, fileC, "XXX").data(), QByteArray("XXX").data() );
 }
 
 void ItemSyncTests::modifyFiles()
@@ -415,12 +434,12 @@ void ItemSyncTests::modifyFiles()
     const QString fileC = fileNameForId(2);
     const QString fileD = fileNameForId(3);
 
-    QCOMPARE( dir1.files().join(sep),
-              fileA
-              + sep + fileB
-              + sep + fileC
-              + sep + fileD
-              );
+    const QString expectedFiles =
+            fileA
+            + sep + fileB
+            + sep + fileC
+            + sep + fileD;
+    QCOMPARE( waitForFiles(dir1, expectedFiles), expectedFiles );
 
     FilePtr file = dir1.file(fileC);
     QVERIFY(file->open(QIODevice::ReadWrite));
@@ -454,18 +473,23 @@ void ItemSyncTests::notes()
 
     const QStringList files1 = QStringList() << fileTest1 << fileTest2 << fileTest3;
 
-    QCOMPARE( dir1.files().join(sep), files1.join(sep) );
+    QCOMPARE( waitForFiles(dir1, files1.join(sep)), files1.join(sep) );
 
     RUN(args << "keys" << "HOME" << "DOWN" << "SHIFT+F2" << ":NOTE1" << "F2", "");
     RUN(args << "read" << mimeItemNotes << "0" << "1" << "2", ";NOTE1;");
 
     // One new file for notes.
-    const QStringList files2 = dir1.files();
+    QStringList files2;
+    SleepTimer t(8000);
+    do {
+        files2 = dir1.files();
+    } while (files2.size() == files1.size() && t.sleep());
     const QSet<QString> filesDiff = files2.toSet() - files1.toSet();
     QCOMPARE( filesDiff.size(), 1 );
     const QString fileNote = *filesDiff.begin();
 
     // Read file with the notes.
+    QCOMPARE( waitForFileContent(dir1, fileNote, "NOTE1").data(), QByteArray("NOTE1").data() );
     FilePtr file = dir1.file(fileNote);
     QVERIFY(file->open(QIODevice::ReadWrite));
     QCOMPARE(file->readAll().data(), QByteArray("NOTE1").data());
@@ -561,6 +585,7 @@ void ItemSyncTests::customFormats()
     const QString fileData = QString(fileNameForId(0)).replace("txt", "zzz");
 
     // Check data
+    QCOMPARE( waitForFileContent(dir1, fileData, "NEW_ITEM").data(), "NEW_ITEM" );
     file = dir1.file(fileData);
     QVERIFY(file->exists());
     QVERIFY(file->open(QIODevice::ReadWrite));
@@ -51,6 +51,8 @@ const char configTags[] = "tags";
 
 const char propertyColor[] = "CopyQ_color";
 
+const int maxCachedTags = 1000;
+
 namespace tagsTableColumns {
 enum {
     name,
@@ -626,6 +628,7 @@ QStringList ItemTagsLoader::formatsToSave() const
 QVariantMap ItemTagsLoader::applySettings()
 {
     m_tags.clear();
+    m_tagCache.clear();
 
     QStringList tags;
 
@@ -647,6 +650,7 @@ void ItemTagsLoader::loadSettings(const QVariantMap &settings)
     m_settings = settings;
 
     m_tags.clear();
+    m_tagCache.clear();
     for (const auto &tagField : m_settings.value(configTags).toStringList()) {
         Tag tag = deserializeTag(tagField);
         if (isTagValid(tag))
@@ -694,7 +698,7 @@ bool ItemTagsLoader::matches(const QModelIndex &index, const QRegExp &re) const
     const QByteArray tagsData =
             index.data(contentType::data).toMap().value(mimeTags).toByteArray();
     const auto tags = getTextData(tagsData);
-    return re.indexIn(tags) != -1;
+    return matchesFilter(re, tags);
 }
 
 QObject *ItemTagsLoader::tests(const TestInterfacePtr &test) const
@@ -836,6 +840,13 @@ ItemTagsLoader::Tags ItemTagsLoader::toTags(const QStringList &tagList)
 
     for (const auto &tagText : tagList) {
         QString tagName = tagText.trimmed();
+
+        const auto it = m_tagCache.constFind(tagName);
+        if ( it != m_tagCache.constEnd() ) {
+            tags.append(it.value());
+            continue;
+        }
+
         Tag tag = findMatchingTag(tagName, m_tags);
 
         if (isTagValid(tag)) {
@@ -853,6 +864,10 @@ ItemTagsLoader::Tags ItemTagsLoader::toTags(const QStringList &tagList)
             tag.color = settings.value("Theme/num_fg").toString();
         }
 
+        if ( m_tagCache.size() >= maxCachedTags )
+            m_tagCache.clear();
+        m_tagCache.insert(tagName, tag);
+
         tags.append(tag);
     }
 
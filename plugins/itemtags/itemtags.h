@@ -23,6 +23,7 @@
 #include "gui/icons.h"
 #include "item/itemwidget.h"
 
+#include <QHash>
 #include <QVariant>
 #include <QVector>
 #include <QWidget>
@@ -173,6 +174,8 @@ private:
 
     QVariantMap m_settings;
     Tags m_tags;
+    /// Tags for trimmed tag texts, avoids matching regular expressions for each item.
+    QHash<QString, Tag> m_tagCache;
     std::unique_ptr<Ui::ItemTagsSettings> ui;
 
     bool m_blockDataChange;
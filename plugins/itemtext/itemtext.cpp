@@ -33,6 +33,7 @@
 #include <QTextBlock>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QTextFrame>
 #include <QtPlugin>
 
 namespace {
@@ -54,6 +55,10 @@ const char optionMaximumHeight[] = "max_height";
 
 const char mimeRichText[] = "text/richtext";
 
+// Parsing large HTML is slow, so parsed documents are reused when
+// items are displayed again (e.g. after scrolling or in preview).
+const int maxCachedRichTexts = 100;
+
 // Some applications insert \0 teminator at the end of text data.
 // It needs to be removed because QTextBrowser can render the character.
 void removeTrailingNull(QString *text)
@@ -98,6 +103,18 @@ QString normalizeText(QString text)
     return text.left(maxCharacters);
 }
 
+/// Return position of line break after given number of lines or -1.
+int lineBreakPosition(const QString &text, int lineCount)
+{
+    int i = -1;
+    for (int line = 0; line < lineCount; ++line) {
+        i = text.indexOf('\n', i + 1);
+        if (i == -1)
+            break;
+    }
+    return i;
+}
+
 void insertEllipsis(QTextCursor *tc)
 {
     tc->insertHtml( " &nbsp;"
@@ -108,7 +125,7 @@ void insertEllipsis(QTextCursor *tc)
 
 } // namespace
 
-ItemText::ItemText(const QString &text, const QString &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent)
+ItemText::ItemText(const QString &text, const ItemRichText &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent)
     : QTextEdit(parent)
     , ItemWidget(this)
     , m_textDocument()
@@ -126,18 +143,32 @@ ItemText::ItemText(const QString &text, const QString &richText, int maxLines, i
 
     setContextMenuPolicy(Qt::NoContextMenu);
 
-    if ( !richText.isEmpty() ) {
-        m_textDocument.setHtml(richText);
+    if ( !richText.fragment.isEmpty() ) {
+        m_textDocument.rootFrame()->setFrameFormat(richText.rootFrameFormat);
+        QTextCursor(&m_textDocument).insertFragment(richText.fragment);
         // Use plain text instead if rendering HTML fails or result is empty.
         m_isRichText = !m_textDocument.isEmpty();
     }
 
-    if (!m_isRichText)
-        m_textDocument.setPlainText(text);
+    if (!m_isRichText) {
+        // Avoid creating document blocks for lines which would be elided anyway.
+        const int i = maxLines > 0 ? lineBreakPosition(text, maxLines) : -1;
+        if (i == -1) {
+            m_textDocument.setPlainText(text);
+        } else {
+            m_textDocument.setPlainText( text.left(i) );
+            m_elidedText = text.mid(i);
+        }
+    }
 
     m_textDocument.setDocumentMargin(0);
 
-    if (maxLines > 0) {
+    if ( !m_elidedText.isEmpty() ) {
+        QTextCursor tc(&m_textDocument);
+        tc.movePosition(QTextCursor::End);
+        m_ellipsisPosition = tc.position();
+        insertEllipsis(&tc);
+    } else if (maxLines > 0) {
         QTextBlock block = m_textDocument.findBlockByLineNumber(maxLines);
         if (block.isValid()) {
             QTextCursor tc(&m_textDocument);
@@ -209,23 +240,38 @@ void ItemText::updateSize(QSize maximumSize, int idealWidth)
 {
     const int scrollBarWidth = verticalScrollBar()->isVisible() ? verticalScrollBar()->width() : 0;
     setMaximumHeight( maximumSize.height() );
-    setFixedWidth(idealWidth);
-    m_textDocument.setTextWidth(idealWidth - scrollBarWidth);
 
-    QTextOption option = m_textDocument.defaultTextOption();
+    const int textWidth = idealWidth - scrollBarWidth;
     const QTextOption::WrapMode wrapMode = maximumSize.width() > idealWidth
             ? QTextOption::NoWrap : QTextOption::WrapAtWordBoundaryOrAnywhere;
-    if (wrapMode != option.wrapMode()) {
-        option.setWrapMode(wrapMode);
-        m_textDocument.setDefaultTextOption(option);
-    }
 
-    const QRectF rect = m_textDocument.documentLayout()->frameBoundingRect(m_textDocument.rootFrame());
-    setFixedWidth( static_cast<int>(rect.right()) );
+    // Laying out the document is expensive, reuse the size if text width is the same
+    // (this is common when items are resized only vertically or updated repeatedly).
+    if (textWidth != m_layoutTextWidth || wrapMode != m_layoutWrapMode) {
+        m_layoutTextWidth = textWidth;
+        m_layoutWrapMode = wrapMode;
 
-    QTextCursor tc(&m_textDocument);
-    tc.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
-    const auto h = static_cast<int>( cursorRect(tc).bottom() + 2 * logicalDpiY() / 96.0 );
+        setFixedWidth(idealWidth);
+        m_textDocument.setTextWidth(textWidth);
+
+        QTextOption option = m_textDocument.defaultTextOption();
+        if (wrapMode != option.wrapMode()) {
+            option.setWrapMode(wrapMode);
+            m_textDocument.setDefaultTextOption(option);
+        }
+
+        const QRectF rect = m_textDocument.documentLayout()->frameBoundingRect(m_textDocument.rootFrame());
+        setFixedWidth( static_cast<int>(rect.right()) );
+
+        QTextCursor tc(&m_textDocument);
+        tc.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
+        const auto h = static_cast<int>( cursorRect(tc).bottom() + 2 * logicalDpiY() / 96.0 );
+        m_layoutSize = QSize( static_cast<int>(rect.right()), h );
+    } else {
+        setFixedWidth( m_layoutSize.width() );
+    }
+
+    const int h = m_layoutSize.height();
     if (0 < m_maximumHeight && m_maximumHeight < h) {
         setFixedHeight(m_maximumHeight);
         setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
@@ -259,19 +305,34 @@ QMimeData *ItemText::createMimeDataFromSelection() const
     return data;
 }
 
+void ItemText::changeEvent(QEvent *event)
+{
+    if (event->type() == QEvent::FontChange)
+        invalidateLayoutSize();
+
+    QTextEdit::changeEvent(event);
+}
+
 void ItemText::onSelectionChanged()
 {
     // Expand the ellipsis if selected.
     if ( m_ellipsisPosition == -1 || textCursor().selectionEnd() <= m_ellipsisPosition )
         return;
 
+    invalidateLayoutSize();
+
     QTextCursor tc(&m_textDocument);
     tc.setPosition(m_ellipsisPosition);
     m_ellipsisPosition = -1;
     tc.movePosition(QTextCursor::End, QTextCursor::KeepAnchor);
 
-    tc.insertFragment(m_elidedFragment);
-    m_elidedFragment = QTextDocumentFragment();
+    if ( m_elidedText.isEmpty() ) {
+        tc.insertFragment(m_elidedFragment);
+        m_elidedFragment = QTextDocumentFragment();
+    } else {
+        tc.insertText(m_elidedText);
+        m_elidedText.clear();
+    }
 }
 
 ItemTextLoader::ItemTextLoader()
@@ -295,25 +356,45 @@ ItemWidget *ItemTextLoader::create(const QVariantMap &data, QWidget *parent, boo
     if (!isRichText && !isPlainText)
         return nullptr;
 
-    richText = normalizeText(richText);
     text = normalizeText(text);
+    const ItemRichText parsedRichText = isRichText
+            ? cachedRichText( normalizeText(richText) ) : ItemRichText();
 
     ItemText *item = nullptr;
     // Always limit text size for performance reasons.
     if (preview) {
-        item = new ItemText(text, richText, maxLineCountInPreview, maxLineLengthInPreview, 0, parent);
+        item = new ItemText(text, parsedRichText, maxLineCountInPreview, maxLineLengthInPreview, 0, parent);
     } else {
         int maxLines = m_settings.value(optionMaximumLines, maxLineCount).toInt();
         if (maxLines <= 0 || maxLines > maxLineCount)
             maxLines = maxLineCount;
         const int maxHeight = m_settings.value(optionMaximumHeight, 0).toInt();
-        item = new ItemText(text, richText, maxLines, maxLineLength, maxHeight, parent);
+        item = new ItemText(text, parsedRichText, maxLines, maxLineLength, maxHeight, parent);
         item->viewport()->installEventFilter(item);
     }
 
     return item;
 }
 
+const ItemRichText &ItemTextLoader::cachedRichText(const QString &html) const
+{
+    const quint64 htmlHash = hashFormat( mimeHtml, html.toUtf8() );
+    const auto it = m_richTextCache.constFind(htmlHash);
+    if ( it != m_richTextCache.constEnd() )
+        return it.value();
+
+    if ( m_richTextCache.size() >= maxCachedRichTexts )
+        m_richTextCache.clear();
+
+    QTextDocument document;
+    document.setHtml(html);
+
+    ItemRichText &richText = m_richTextCache[htmlHash];
+    richText.fragment = QTextDocumentFragment(&document);
+    richText.rootFrameFormat = document.rootFrame()->frameFormat();
+    return richText;
+}
+
 QStringList ItemTextLoader::formatsToSave() const
 {
     return m_settings.value(optionUseRichText, true).toBool()
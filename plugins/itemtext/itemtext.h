@@ -23,9 +23,12 @@
 #include "gui/icons.h"
 #include "item/itemwidget.h"
 
+#include <QHash>
 #include <QTextDocument>
 #include <QTextDocumentFragment>
 #include <QTextEdit>
+#include <QTextFormat>
+#include <QTextOption>
 
 #include <memory>
 
@@ -33,12 +36,18 @@ namespace Ui {
 class ItemTextSettings;
 }
 
+/// HTML parsed once so it can be inserted into item documents without parsing again.
+struct ItemRichText {
+    QTextDocumentFragment fragment;
+    QTextFrameFormat rootFrameFormat;
+};
+
 class ItemText : public QTextEdit, public ItemWidget
 {
     Q_OBJECT
 
 public:
-    ItemText(const QString &text, const QString &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent);
+    ItemText(const QString &text, const ItemRichText &richText, int maxLines, int lineLength, int maximumHeight, QWidget *parent);
 
 protected:
     void highlight(const QRegExp &re, const QFont &highlightFont,
@@ -50,14 +59,24 @@ protected:
 
     QMimeData *createMimeDataFromSelection() const override;
 
+    void changeEvent(QEvent *event) override;
+
 private:
     void onSelectionChanged();
 
+    void invalidateLayoutSize() { m_layoutTextWidth = -1; }
+
     QTextDocument m_textDocument;
     QTextDocumentFragment m_elidedFragment;
+    QString m_elidedText;
     int m_ellipsisPosition = -1;
     int m_maximumHeight;
     bool m_isRichText = false;
+
+    /// Document layout size for last text width and wrap mode (see updateSize()).
+    int m_layoutTextWidth = -1;
+    QTextOption::WrapMode m_layoutWrapMode = QTextOption::NoWrap;
+    QSize m_layoutSize;
 };
 
 class ItemTextLoader : public QObject, public ItemLoaderInterface
@@ -87,8 +106,12 @@ public:
     QWidget *createSettingsWidget(QWidget *parent) override;
 
 private:
+    /// Returns parsed HTML, cached for item data hash.
+    const ItemRichText &cachedRichText(const QString &html) const;
+
     QVariantMap m_settings;
     std::unique_ptr<Ui::ItemTextSettings> ui;
+    mutable QHash<quint64, ItemRichText> m_richTextCache;
 };
 
 #endif // ITEMTEXT_H
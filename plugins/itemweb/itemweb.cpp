@@ -30,6 +30,7 @@
 #include <QPalette>
 #include <QtPlugin>
 #include <QtWebKit/QWebHistory>
+#include <QtWebKit/QWebSettings>
 #include <QtWebKitWidgets/QWebFrame>
 #include <QtWebKitWidgets/QWebPage>
 #include <QVariant>
@@ -38,6 +39,10 @@ namespace {
 
 const char optionMaximumHeight[] = "max_height";
 
+// Memory cache limits shared by all web pages.
+const int maxDeadObjectCacheBytes = 2 << 20;
+const int maxObjectCacheBytes = 8 << 20;
+
 bool getHtml(const QVariantMap &data, QString *text)
 {
     *text = getTextData(data, mimeHtml);
@@ -212,6 +217,10 @@ QSize ItemWeb::sizeHint() const
 
 ItemWebLoader::ItemWebLoader()
 {
+    // Items don't use back/forward navigation, so avoid keeping closed pages
+    // in memory and limit resources cached for every item in the history.
+    QWebSettings::setMaximumPagesInCache(0);
+    QWebSettings::setObjectCacheCapacities(0, maxDeadObjectCacheBytes, maxObjectCacheBytes);
 }
 
 ItemWebLoader::~ItemWebLoader() = default;
@@ -7,6 +7,7 @@ SUBDIRS  = \
            itemimage \
            itemnotes \
            itempinned \
+           itemsqlite \
            itemtags \
            itemtext \
            itemsync \
@@ -36,6 +36,7 @@
 #   include <qpa/qplatformnativeinterface.h>
 #   include <xcb/xcb.h>
 #endif
+#include <QHash>
 #include <QVector>
 #include <QWidget>
 #include <X11/keysym.h>
@@ -119,23 +120,41 @@ private:
 
 bool QxtX11ErrorHandler::error = false;
 
-class QxtX11Data {
-public:
-    QxtX11Data()
-        : m_display(nullptr)
-    {
+Display *x11Display()
+{
+    static Display *display = nullptr;
+    if (!display) {
         createFirstWindow();
 
 #if QT_VERSION < QT_VERSION_CHECK(5,0,0)
-        m_display = QX11Info::display();
+        display = QX11Info::display();
 #else
         QPlatformNativeInterface *native = qApp->platformNativeInterface();
-        void *display = native->nativeResourceForScreen(QByteArray("display"),
-                                                        QGuiApplication::primaryScreen());
-        m_display = reinterpret_cast<Display *>(display);
+        void *nativeDisplay = native->nativeResourceForScreen(QByteArray("display"),
+                                                              QGuiApplication::primaryScreen());
+        display = reinterpret_cast<Display *>(nativeDisplay);
 #endif
     }
 
+    return display;
+}
+
+/**
+ * Key codes for Qt keys, cleared only when keyboard mapping changes.
+ */
+QHash<int, quint32> &keycodeCache()
+{
+    static QHash<int, quint32> cache;
+    return cache;
+}
+
+class QxtX11Data {
+public:
+    QxtX11Data()
+        : m_display(x11Display())
+    {
+    }
+
     bool isValid()
     {
         return m_display != nullptr;
@@ -200,13 +219,38 @@ KeySym qtKeyToXKeySym(Qt::Key key)
     return static_cast<ushort>(key);
 }
 
+/**
+ * Refreshes keyboard mapping cached by Xlib and drops cached key codes.
+ *
+ * Events are received by Qt so Xlib wouldn't otherwise notice the change.
+ */
+void refreshKeyboardMapping(int request, int firstKeycode, int count)
+{
+    Display *display = x11Display();
+    if (!display)
+        return;
+
+    XMappingEvent event{};
+    event.type = MappingNotify;
+    event.display = display;
+    event.request = request;
+    event.first_keycode = firstKeycode;
+    event.count = count;
+    XRefreshKeyboardMapping(&event);
+
+    keycodeCache().clear();
+}
+
 } // namespace
 
 #if QT_VERSION < QT_VERSION_CHECK(5,0,0)
 bool QxtGlobalShortcutPrivate::eventFilter(void* message)
 {
     XEvent *event = static_cast<XEvent *>(message);
-    if (event->type == KeyPress)
+    if (event->type == MappingNotify) {
+        const XMappingEvent &mapping = event->xmapping;
+        refreshKeyboardMapping(mapping.request, mapping.first_keycode, mapping.count);
+    } else if (event->type == KeyPress)
     {
         XKeyEvent* key = reinterpret_cast<XKeyEvent *>(event);
         unsigned int keycode = key->keycode;
@@ -220,8 +264,13 @@ bool QxtGlobalShortcutPrivate::nativeEventFilter(const QByteArray & eventType,
     xcb_key_press_event_t *kev = nullptr;
     if (eventType == "xcb_generic_event_t") {
         xcb_generic_event_t* ev = static_cast<xcb_generic_event_t *>(message);
-        if ((ev->response_type & 127) == XCB_KEY_PRESS)
+        const auto responseType = ev->response_type & 127;
+        if (responseType == XCB_KEY_PRESS) {
             kev = static_cast<xcb_key_press_event_t *>(message);
+        } else if (responseType == XCB_MAPPING_NOTIFY) {
+            const auto mev = static_cast<xcb_mapping_notify_event_t *>(message);
+            refreshKeyboardMapping(mev->request, mev->first_keycode, mev->count);
+        }
     }
 
     if (kev != nullptr) {
@@ -265,12 +314,19 @@ quint32 QxtGlobalShortcutPrivate::nativeModifiers(Qt::KeyboardModifiers modifier
 
 quint32 QxtGlobalShortcutPrivate::nativeKeycode(Qt::Key key)
 {
+    auto &cache = keycodeCache();
+    const auto it = cache.constFind(key);
+    if ( it != cache.constEnd() )
+        return it.value();
+
     QxtX11Data x11;
     if (!x11.isValid())
         return 0;
 
     const KeySym keysym = qtKeyToXKeySym(key);
-    return XKeysymToKeycode(x11.display(), keysym);
+    const quint32 keycode = XKeysymToKeycode(x11.display(), keysym);
+    cache.insert(key, keycode);
+    return keycode;
 }
 
 bool QxtGlobalShortcutPrivate::registerShortcut(quint32 nativeKey, quint32 nativeMods)
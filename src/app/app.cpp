@@ -92,15 +92,20 @@ void installTranslator()
     const QString translationPrefix = createPlatformNativeInterface()->translationPrefix();
 #endif
 
+    // Texts are in English so avoid looking up translation files needlessly.
+    const bool isEnglish = locale == "C" || locale.startsWith("en");
+
     QStringList translationDirectories;
     translationDirectories.prepend(translationPrefix);
 
-    // 1. Qt translations
-    installTranslator("qt_" + locale, translationPrefix);
-    installTranslator("qt_" + locale, QLibraryInfo::location(QLibraryInfo::TranslationsPath));
+    if (!isEnglish) {
+        // 1. Qt translations
+        installTranslator("qt_" + locale, translationPrefix);
+        installTranslator("qt_" + locale, QLibraryInfo::location(QLibraryInfo::TranslationsPath));
 
-    // 2. installed translations
-    installTranslator("copyq_" + locale, translationPrefix);
+        // 2. installed translations
+        installTranslator("copyq_" + locale, translationPrefix);
+    }
 
     // 3. custom translations
     const QByteArray customPath = qgetenv("COPYQ_TRANSLATION_PREFIX");
@@ -113,7 +118,8 @@ void installTranslator()
     // 4. compiled, non-installed translations in debug builds
 #ifdef COPYQ_DEBUG
     const QString compiledTranslations = QCoreApplication::applicationDirPath() + "/src";
-    installTranslator("copyq_" + locale, compiledTranslations);
+    if (!isEnglish)
+        installTranslator("copyq_" + locale, compiledTranslations);
     translationDirectories.prepend(compiledTranslations);
 #endif
 
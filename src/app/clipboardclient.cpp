@@ -46,6 +46,8 @@ QString messageCodeToString(int code)
         return "CommandFunctionCallReturnValue";
     case CommandInputDialogFinished:
         return "CommandInputDialogFinished";
+    case CommandPersistentCommandFinished:
+        return "CommandPersistentCommandFinished";
     case CommandStop:
         return "CommandStop";
     default:
@@ -93,11 +95,12 @@ ClipboardClient::ClipboardClient(int &argc, char **argv, const QStringList &argu
     : App(createClientApplication(argc, argv, arguments), sessionName)
     , m_inputReaderThread(nullptr)
 {
-    restoreSettings();
-
+    // Connect to server before loading settings and translations.
     const auto serverName = clipboardServerName();
     m_socket = new ClientSocket(serverName, this);
 
+    restoreSettings();
+
     connect( m_socket, &ClientSocket::messageReceived,
              this, &ClipboardClient::onMessageReceived );
     connect( m_socket, &ClientSocket::disconnected,
@@ -129,6 +132,10 @@ void ClipboardClient::onMessageReceived(const QByteArray &data, int messageCode)
         break;
     }
 
+    case CommandPersistentCommandFinished:
+        emit persistentCommandFinished(data);
+        break;
+
     case CommandStop: {
         emit stopEventLoops();
 
@@ -236,6 +243,8 @@ void ClipboardClient::start(const QStringList &arguments)
              &scriptableProxy, &ScriptableProxy::setFunctionCallReturnValue );
     connect( this, &ClipboardClient::inputDialogFinished,
              &scriptableProxy, &ScriptableProxy::setInputDialogResult );
+    connect( this, &ClipboardClient::persistentCommandFinished,
+             &scriptableProxy, &ScriptableProxy::setPersistentCommandResult );
 
     connect( m_socket, &ClientSocket::disconnected,
              &scriptable, &Scriptable::abort );
@@ -66,6 +66,7 @@ signals:
     void functionCallResultReceived(const QByteArray &returnValue);
     void inputReceived(const QByteArray &input);
     void inputDialogFinished(const QByteArray &data);
+    void persistentCommandFinished(const QByteArray &data);
     void stopEventLoops();
     void scriptableFinished();
 
@@ -33,25 +33,31 @@
 
 namespace {
 
-bool hasSameData(const QVariantMap &data, const QVariantMap &lastData)
+using FormatFingerprints = QHash<QString, QPair<int, quint64>>;
+
+FormatFingerprints formatFingerprints(const QVariantMap &data)
 {
-    for (auto it = lastData.constBegin(); it != lastData.constEnd(); ++it) {
+    FormatFingerprints formats;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
         const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX)
-             && !data.contains(format) )
-        {
-            return false;
+        if ( !format.startsWith(COPYQ_MIME_PREFIX) ) {
+            const QByteArray bytes = it.value().toByteArray();
+            formats.insert( format, qMakePair(bytes.size(), contentHash(bytes)) );
         }
     }
+    return formats;
+}
 
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX)
-             && !data[format].toByteArray().isEmpty()
-             && data[format] != lastData.value(format) )
-        {
+bool hasSameData(const FormatFingerprints &formats, const FormatFingerprints &lastFormats)
+{
+    for (auto it = lastFormats.constBegin(); it != lastFormats.constEnd(); ++it) {
+        if ( !formats.contains(it.key()) )
+            return false;
+    }
+
+    for (auto it = formats.constBegin(); it != formats.constEnd(); ++it) {
+        if ( it.value().first != 0 && it.value() != lastFormats.value(it.key()) )
             return false;
-        }
     }
 
     return true;
@@ -72,6 +78,10 @@ ClipboardMonitor::ClipboardMonitor(const QStringList &formats)
     m_storeClipboard = config.option<Config::check_clipboard>();
     m_clipboardTab = config.option<Config::clipboard_tab>();
 
+    const QString ignoredWindows = config.option<Config::ignored_windows>();
+    if ( !ignoredWindows.isEmpty() )
+        m_ignoredWindows = QRegExp(ignoredWindows);
+
     m_clipboard->setFormats(formats);
     connect( m_clipboard.get(), &PlatformClipboard::changed,
              this, &ClipboardMonitor::onClipboardChanged );
@@ -82,6 +92,9 @@ ClipboardMonitor::ClipboardMonitor(const QStringList &formats)
     m_clipboardToSelection = config.option<Config::copy_clipboard>();
     m_selectionToClipboard = config.option<Config::copy_selection>();
 
+    m_clipboard->setSelectionSettleInterval(
+                config.option<Config::selection_settle_interval_ms>() );
+
     onClipboardChanged(ClipboardMode::Selection);
 #endif
     onClipboardChanged(ClipboardMode::Clipboard);
@@ -89,17 +102,37 @@ ClipboardMonitor::ClipboardMonitor(const QStringList &formats)
 
 void ClipboardMonitor::onClipboardChanged(ClipboardMode mode)
 {
+    // Check window title first to avoid fetching data from ignored windows.
+    PlatformWindowPtr currentWindow;
+    QString windowTitle;
+    if ( !m_ignoredWindows.isEmpty() ) {
+        PlatformPtr platform = createPlatformNativeInterface();
+        currentWindow = platform->getCurrentWindow();
+        if (currentWindow)
+            windowTitle = currentWindow->getTitle();
+
+        if ( m_ignoredWindows.indexIn(windowTitle) != -1 ) {
+            COPYQ_LOG( QString("Ignoring %1 change in window \"%2\"")
+                       .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection", windowTitle) );
+            return;
+        }
+    }
+
     QVariantMap data = m_clipboard->data(mode, m_formats);
     auto clipboardData = mode == ClipboardMode::Clipboard
             ? &m_clipboardData : &m_selectionData;
 
-    if ( hasSameData(data, *clipboardData) ) {
+    auto formats = formatFingerprints(data);
+    if ( hasSameData(formats, clipboardData->formats) ) {
         COPYQ_LOG( QString("Ignoring unchanged %1")
                    .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
         return;
     }
 
-    *clipboardData = data;
+    // Decode text only once, it can be large.
+    const auto text = getTextData(data);
+    clipboardData->formats = std::move(formats);
+    clipboardData->textHash = qHash(text);
 
     COPYQ_LOG( QString("%1 changed, owner is \"%2\"")
                .arg(mode == ClipboardMode::Clipboard ? "Clipboard" : "Selection",
@@ -114,22 +147,24 @@ void ClipboardMonitor::onClipboardChanged(ClipboardMode mode)
 
     // add window title of clipboard owner
     if ( !data.contains(mimeOwner) && !data.contains(mimeWindowTitle) ) {
-        PlatformPtr platform = createPlatformNativeInterface();
-        PlatformWindowPtr currentWindow = platform->getCurrentWindow();
+        if ( m_ignoredWindows.isEmpty() ) {
+            PlatformPtr platform = createPlatformNativeInterface();
+            currentWindow = platform->getCurrentWindow();
+            if (currentWindow)
+                windowTitle = currentWindow->getTitle();
+        }
         if (currentWindow)
-            data.insert( mimeWindowTitle, currentWindow->getTitle().toUtf8() );
+            data.insert( mimeWindowTitle, windowTitle.toUtf8() );
     }
 
 #ifdef HAS_MOUSE_SELECTIONS
     if ( (mode == ClipboardMode::Clipboard ? m_clipboardToSelection : m_selectionToClipboard)
         && !data.contains(mimeOwner) )
     {
-        const auto text = getTextData(data);
         if ( !text.isEmpty() ) {
             const auto targetData = mode == ClipboardMode::Clipboard
                     ? &m_selectionData : &m_clipboardData;
-            const auto targetText = getTextData(*targetData);
-            emit synchronizeSelection(mode, text, qHash(targetText));
+            emit synchronizeSelection(mode, text, targetData->textHash);
         }
     }
 #endif
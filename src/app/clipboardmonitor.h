@@ -24,6 +24,9 @@
 #include "platform/platformnativeinterface.h"
 #include "platform/platformclipboard.h"
 
+#include <QHash>
+#include <QPair>
+#include <QRegExp>
 #include <QVariantMap>
 
 enum class ClipboardOwnership {
@@ -44,10 +47,18 @@ signals:
     void synchronizeSelection(ClipboardMode sourceMode, const QString &text, uint targetTextHash);
 
 private:
+    /// Sizes and hashes of last clipboard data to avoid keeping a copy of the data.
+    struct DataFingerprint {
+        /// Non-internal formats with data size and hash.
+        QHash<QString, QPair<int, quint64>> formats;
+        /// Hash of text used to synchronize clipboard and selection.
+        uint textHash = qHash(QString());
+    };
+
     void onClipboardChanged(ClipboardMode mode);
 
-    QVariantMap m_clipboardData;
-    QVariantMap m_selectionData;
+    DataFingerprint m_clipboardData;
+    DataFingerprint m_selectionData;
 
     PlatformClipboardPtr m_clipboard;
     QStringList m_formats;
@@ -55,6 +66,9 @@ private:
     QString m_clipboardTab;
     bool m_storeClipboard;
 
+    /// Titles of windows to ignore, checked before clipboard data are requested.
+    QRegExp m_ignoredWindows;
+
 #ifdef HAS_MOUSE_SELECTIONS
     bool m_storeSelection;
     bool m_clipboardToSelection;
@@ -25,9 +25,12 @@
 #include "common/commandstatus.h"
 #include "common/display.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/shortcuts.h"
 #include "common/sleeptimer.h"
+#include "common/startupphases.h"
+#include "common/timer.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/commanddialog.h"
 #include "gui/configtabshortcuts.h"
@@ -79,7 +82,10 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     setCurrentThreadName("Server");
 
     const QString serverName = clipboardServerName();
-    m_server = new Server(serverName, this);
+    {
+        StartupPhase phase("server");
+        m_server = new Server(serverName, this);
+    }
 
     if ( m_server->isListening() ) {
         ::createSessionMutex();
@@ -98,15 +104,27 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     QApplication::setQuitOnLastWindowClosed(false);
 
     m_itemFactory = new ItemFactory(this);
-    m_wnd = new MainWindow(m_itemFactory);
+    {
+        StartupPhase phase("main window");
+        m_wnd = new MainWindow(m_itemFactory);
+    }
 
-    m_itemFactory->loadPlugins();
+    {
+        StartupPhase phase("plugins");
+        m_itemFactory->loadPlugins();
+    }
     if ( !m_itemFactory->hasLoaders() )
         log("No plugins loaded", LogNote);
 
-    m_wnd->loadSettings();
-    m_wnd->setCurrentTab(0);
-    m_wnd->enterBrowseMode();
+    {
+        StartupPhase phase("window settings");
+        m_wnd->loadSettings();
+    }
+    {
+        StartupPhase phase("first tab");
+        m_wnd->setCurrentTab(0);
+        m_wnd->enterBrowseMode();
+    }
 
     connect( m_server, &Server::newConnection,
              this, &ClipboardServer::onClientNewConnection );
@@ -125,7 +143,10 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     connect( m_wnd, &MainWindow::disableClipboardStoringRequest,
              this, &ClipboardServer::onDisableClipboardStoringRequest );
 
-    loadSettings();
+    {
+        StartupPhase phase("server settings");
+        loadSettings();
+    }
 
     // notify window if configuration changes
     connect( m_wnd, &MainWindow::configurationChanged,
@@ -133,7 +154,10 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
 
     connect( m_wnd, &MainWindow::commandsSaved,
              this, &ClipboardServer::onCommandsSaved );
-    onCommandsSaved();
+    // Registering global shortcuts can be slow, do it after monitor starts.
+    m_monitorCommandsStateHash = monitorCommandStateHash( loadEnabledCommands() );
+    initSingleShotTimer( &m_timerUpdateGlobalShortcuts, 0, this, &ClipboardServer::onCommandsSaved );
+    m_timerUpdateGlobalShortcuts.start();
 
     qApp->installEventFilter(this);
 
@@ -143,7 +167,18 @@ ClipboardServer::ClipboardServer(QApplication *app, const QString &sessionName)
     m_ignoreKeysTimer.setInterval(100);
     m_ignoreKeysTimer.setSingleShot(true);
 
-    startMonitoring();
+    if ( !metricsFileName().isEmpty() ) {
+        m_timerExportMetrics.setInterval(10000);
+        connect( &m_timerExportMetrics, &QTimer::timeout, exportMetrics );
+        m_timerExportMetrics.start();
+    }
+
+    {
+        StartupPhase phase("clipboard monitor");
+        startMonitoring();
+    }
+
+    finishStartupPhases();
 }
 
 ClipboardServer::~ClipboardServer()
@@ -361,6 +396,8 @@ void ClipboardServer::onClientNewConnection(const ClientSocketPtr &client)
         return;
     }
 
+    countMetric("script_executions");
+
     auto proxy = new ScriptableProxy(m_wnd);
     connect( client.get(), &ClientSocket::destroyed,
              proxy, &ScriptableProxy::safeDeleteLater );
@@ -401,6 +438,9 @@ void ClipboardServer::onClientMessageReceived(
 
 void ClipboardServer::onClientDisconnected(ClientSocketId clientId)
 {
+    const auto it = m_clients.find(clientId);
+    if ( it != m_clients.end() && it->elapsed.isValid() )
+        addMetricDuration( "script_execution", it->elapsed.nsecsElapsed() / 1000 );
     m_clients.remove(clientId);
 }
 
@@ -469,6 +509,8 @@ bool ClipboardServer::eventFilter(QObject *object, QEvent *ev)
         }
     } else if (type == QEvent::Paint) {
         setActivePaintDevice(object);
+    } else if (type == QEvent::Timer) {
+        countMetric("timer_wakeups");
     }
 
     return false;
@@ -25,6 +25,7 @@
 #include "common/server.h"
 #include "common/clientsocket.h"
 
+#include <QElapsedTimer>
 #include <QMap>
 #include <QPointer>
 #include <QTimer>
@@ -127,6 +128,8 @@ private:
     bool m_ignoreNewConnections = false;
     QMap<QxtGlobalShortcut*, Command> m_shortcutActions;
     QTimer m_ignoreKeysTimer;
+    QTimer m_timerUpdateGlobalShortcuts;
+    QTimer m_timerExportMetrics;
     ItemFactory *m_itemFactory;
     uint m_monitorCommandsStateHash = 0;
 
@@ -136,6 +139,7 @@ private:
             : client(client)
             , proxy(proxy)
         {
+            elapsed.start();
         }
 
         bool isValid() const
@@ -145,6 +149,7 @@ private:
 
         ClientSocketPtr client;
         ScriptableProxy *proxy = nullptr;
+        QElapsedTimer elapsed;
     };
     QMap<ClientSocketId, ClientData> m_clients;
 };
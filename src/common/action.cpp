@@ -36,6 +36,9 @@
 
 namespace {
 
+/// Size of input chunks written to command so it's not buffered again in whole.
+const qint64 inputChunkSize = 64 * 1024;
+
 void startProcess(QProcess *process, const QStringList &args, QIODevice::OpenModeFlag mode)
 {
     QString executable = args.value(0);
@@ -230,6 +233,9 @@ void Action::setInputWithFormat(const QVariantMap &data, const QString &inputFor
 
 void Action::start()
 {
+    if (m_currentLine == -1)
+        m_timer.start();
+
     closeSubCommands();
 
     if ( m_currentLine + 1 >= m_cmds.size() ) {
@@ -242,7 +248,9 @@ void Action::start()
 
     Q_ASSERT( !cmds.isEmpty() );
 
-    QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+    QProcessEnvironment env = m_environment.isEmpty()
+            ? QProcessEnvironment::systemEnvironment()
+            : m_environment;
     if (m_id != -1)
         env.insert("COPYQ_ACTION_ID", QString::number(m_id));
     if ( !m_name.isEmpty() )
@@ -307,7 +315,10 @@ bool Action::waitForFinished(int msecs)
     QPointer<QObject> self(this);
     QEventLoop loop;
     QTimer t;
-    connectProcessFinished(m_processes.back(), &loop, &QEventLoop::quit);
+    if (m_runningWithoutProcess)
+        connect(this, &Action::actionFinished, &loop, &QEventLoop::quit);
+    else
+        connectProcessFinished(m_processes.back(), &loop, &QEventLoop::quit);
     connect(&t, &QTimer::timeout, &loop, &QEventLoop::quit);
     t.start(msecs);
     loop.exec(QEventLoop::ExcludeUserInputEvents);
@@ -317,9 +328,32 @@ bool Action::waitForFinished(int msecs)
 
 bool Action::isRunning() const
 {
+    if (m_runningWithoutProcess)
+        return true;
+
     return !m_processes.empty() && m_processes.back()->state() != QProcess::NotRunning;
 }
 
+void Action::startWithoutProcess()
+{
+    m_timer.start();
+    m_startLatencyMs = 0;
+    m_bytesWritten = m_input.size();
+    m_currentLine = m_cmds.size() - 1;
+    m_runningWithoutProcess = true;
+    emit actionStarted(this);
+}
+
+void Action::finishWithoutProcess(int exitCode)
+{
+    if (!m_runningWithoutProcess)
+        return;
+
+    m_runningWithoutProcess = false;
+    m_exitCode = exitCode;
+    finish();
+}
+
 void Action::setData(const QVariantMap &data)
 {
     m_data = data;
@@ -332,8 +366,10 @@ const QVariantMap &Action::data() const
 
 void Action::appendOutput(const QByteArray &output)
 {
-    if ( !output.isEmpty() )
+    if ( !output.isEmpty() ) {
+        m_bytesRead += output.size();
         emit actionOutput(output);
+    }
 }
 
 void Action::appendErrorOutput(const QByteArray &errorOutput)
@@ -360,8 +396,10 @@ void Action::onSubProcessError(QProcess::ProcessError error)
 
 void Action::onSubProcessStarted()
 {
-    if (m_currentLine == 0)
+    if (m_currentLine == 0) {
+        m_startLatencyMs = m_timer.elapsed();
         emit actionStarted(this);
+    }
 }
 
 void Action::onSubProcessFinished()
@@ -396,20 +434,45 @@ void Action::writeInput()
 
     QProcess *p = m_processes.front();
 
-    if (m_input.isEmpty())
-        p->closeWriteChannel();
-    else
-        p->write(m_input);
+    m_inputPosition = 0;
+    writeInputChunk(p);
 }
 
 void Action::onBytesWritten()
 {
     if ( !m_processes.empty() )
-        m_processes.front()->closeWriteChannel();
+        writeInputChunk(m_processes.front());
+}
+
+void Action::writeInputChunk(QProcess *p)
+{
+    // Write next chunk only after the previous one was mostly written.
+    if ( p->bytesToWrite() > inputChunkSize / 2 )
+        return;
+
+    if ( m_inputPosition >= m_input.size() ) {
+        p->closeWriteChannel();
+        return;
+    }
+
+    const qint64 size = qMin(inputChunkSize, m_input.size() - m_inputPosition);
+    const qint64 written = p->write(m_input.constData() + m_inputPosition, size);
+    if (written <= 0) {
+        p->closeWriteChannel();
+        return;
+    }
+
+    m_inputPosition += written;
+    m_bytesWritten += written;
 }
 
 void Action::terminate()
 {
+    if (m_runningWithoutProcess) {
+        emit terminationRequested();
+        return;
+    }
+
     if (m_processes.empty())
         return;
 
@@ -437,8 +500,19 @@ void Action::closeSubCommands()
     m_processes.clear();
 }
 
+qint64 Action::elapsedMs() const
+{
+    if (m_elapsedMs != -1)
+        return m_elapsedMs;
+
+    return m_timer.isValid() ? m_timer.elapsed() : 0;
+}
+
 void Action::finish()
 {
+    if ( m_timer.isValid() )
+        m_elapsedMs = m_timer.elapsed();
+
     closeSubCommands();
     emit actionFinished(this);
 }
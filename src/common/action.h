@@ -20,8 +20,10 @@
 #ifndef ACTION_H
 #define ACTION_H
 
+#include <QElapsedTimer>
 #include <QModelIndex>
 #include <QProcess>
+#include <QProcessEnvironment>
 #include <QStringList>
 #include <QVariantMap>
 
@@ -73,6 +75,9 @@ public:
     /** Set working directory path (default is empty so it doesn't change working directory). */
     void setWorkingDirectory(const QString &path) { m_workingDirectoryPath = path; }
 
+    /** Set environment for processes (default is empty so system environment is used). */
+    void setEnvironment(const QProcessEnvironment &environment) { m_environment = environment; }
+
     /** Execute command. */
     void start();
 
@@ -82,6 +87,18 @@ public:
 
     bool isRunning() const;
 
+    /**
+     * Mark action as started while its command is executed by other means
+     * than a process (e.g. script run in the server).
+     *
+     * Calling terminate() emits terminationRequested() until
+     * finishWithoutProcess() is called.
+     */
+    void startWithoutProcess();
+
+    /** Finish action started with startWithoutProcess(). */
+    void finishWithoutProcess(int exitCode);
+
     /** Set human-readable name for action. */
     void setName(const QString &actionName) { m_name = actionName; }
 
@@ -106,6 +123,18 @@ public:
     /** Terminate (kill) process. */
     void terminate();
 
+    /** Return milliseconds from start until first process started (-1 if not yet started). */
+    qint64 startLatencyMs() const { return m_startLatencyMs; }
+
+    /** Return milliseconds from start until finished (or until now if still running). */
+    qint64 elapsedMs() const;
+
+    /** Return number of bytes written to standard input. */
+    qint64 bytesWritten() const { return m_bytesWritten; }
+
+    /** Return number of bytes read from standard output. */
+    qint64 bytesRead() const { return m_bytesRead; }
+
 signals:
     /** Emitted when finished. */
     void actionFinished(Action *act);
@@ -114,6 +143,9 @@ signals:
 
     void actionOutput(const QByteArray &output);
 
+    /** Emitted by terminate() for action started with startWithoutProcess(). */
+    void terminationRequested();
+
 private:
     void onSubProcessError(QProcess::ProcessError error);
     void onSubProcessStarted();
@@ -122,17 +154,21 @@ private:
     void onSubProcessErrorOutput();
     void writeInput();
     void onBytesWritten();
+    void writeInputChunk(QProcess *p);
 
     void closeSubCommands();
     void finish();
 
     QByteArray m_input;
+    qint64 m_inputPosition = 0;
     QList< QList<QStringList> > m_cmds;
     QStringList m_inputFormats;
     QString m_workingDirectoryPath;
+    QProcessEnvironment m_environment;
     QByteArray m_errorOutput;
     bool m_failed;
     bool m_readOutput = false;
+    bool m_runningWithoutProcess = false;
     int m_currentLine;
     QString m_name;
     QVariantMap m_data;
@@ -142,6 +178,12 @@ private:
     QString m_errorString;
 
     int m_id = -1;
+
+    QElapsedTimer m_timer;
+    qint64 m_startLatencyMs = -1;
+    qint64 m_elapsedMs = -1;
+    qint64 m_bytesWritten = 0;
+    qint64 m_bytesRead = 0;
 };
 
 #endif // ACTION_H
@@ -23,15 +23,21 @@
 #include "common/contenttype.h"
 #include "common/mimetypes.h"
 #include "common/textdata.h"
+#include "common/timer.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/mainwindow.h"
 #include "item/serialize.h"
 
 #include <QObject>
 #include <QPersistentModelIndex>
+#include <QTimer>
 
 namespace {
 
+// Add parsed output items in batches instead of one at a time.
+const int addOutputItemsIntervalMs = 100;
+const int maxPendingOutputItems = 1000;
+
 template <typename ActionOutput>
 void connectActionOutput(Action *action, ActionOutput *actionOutput)
 {
@@ -59,6 +65,9 @@ public:
         , m_sep(itemSeparator)
     {
         connectActionOutput(action, this);
+
+        initSingleShotTimer(
+            &m_timerAddItems, addOutputItemsIntervalMs, this, &ActionOutputItems::addPendingItems );
     }
 
     void onActionOutput(const QByteArray &output)
@@ -66,22 +75,34 @@ public:
         m_lastOutput.append( getTextData(output) );
         auto items = m_lastOutput.split(m_sep);
         m_lastOutput = items.takeLast();
-        if ( !items.isEmpty() )
-            addItems(items);
+        for (const auto &item : items)
+            m_pendingItems.prepend( createDataMap(m_outputFormat, item) );
+
+        if ( m_pendingItems.size() >= maxPendingOutputItems )
+            addPendingItems();
+        else if ( !m_pendingItems.isEmpty() && !m_timerAddItems.isActive() )
+            m_timerAddItems.start();
     }
 
     void onActionFinished(Action *)
     {
         if ( !m_lastOutput.isEmpty() )
-            addItems(QStringList() << m_lastOutput);
+            m_pendingItems.prepend( createDataMap(m_outputFormat, m_lastOutput) );
+        addPendingItems();
     }
 
 private:
-    void addItems(const QStringList &items)
+    void addPendingItems()
     {
+        m_timerAddItems.stop();
+        if ( m_pendingItems.isEmpty() )
+            return;
+
+        // Last output item is on top as if items were added one by one.
         ClipboardBrowser *c = m_tab.isEmpty() ? m_wnd->browser() : m_wnd->tab(m_tab);
-        for (const auto &item : items)
-            c->add( createDataMap(m_outputFormat, item) );
+        if (c)
+            c->add(m_pendingItems);
+        m_pendingItems.clear();
     }
 
     MainWindow *m_wnd;
@@ -89,6 +110,8 @@ private:
     QString m_tab;
     QRegExp m_sep;
     QString m_lastOutput;
+    QList<QVariantMap> m_pendingItems;
+    QTimer m_timerAddItems;
 };
 
 class ActionOutputItem : public QObject
@@ -292,6 +292,41 @@ struct autocompletion : Config<bool> {
     static Value defaultValue() { return true; }
 };
 
+struct item_data_threshold : Config<int> {
+    static QString name() { return "item_data_threshold"; }
+    static Value defaultValue() { return 256 * 1024; }
+};
+
+struct items_in_memory : Config<int> {
+    static QString name() { return "items_in_memory"; }
+    static Value defaultValue() { return 1000; }
+};
+
+struct max_background_commands : Config<int> {
+    static QString name() { return "max_background_commands"; }
+    static Value defaultValue() { return 4; }
+    static Value value(Value v) { return qMax(1, v); }
+};
+
+/// Maximum number of tabs with items loaded (least recently used are unloaded; zero for no limit).
+struct max_loaded_tabs : Config<int> {
+    static QString name() { return "max_loaded_tabs"; }
+    static Value defaultValue() { return 0; }
+    static Value value(Value v) { return qMax(0, v); }
+};
+
+/// Regular expression matching titles of windows to ignore clipboard changes from (empty to disable).
+struct ignored_windows : Config<QString> {
+    static QString name() { return "ignored_windows"; }
+};
+
+/// Time to wait for mouse selection to stop changing before fetching it (0 to disable).
+struct selection_settle_interval_ms : Config<int> {
+    static QString name() { return "selection_settle_interval_ms"; }
+    static Value defaultValue() { return 100; }
+    static Value value(Value v) { return qBound(0, v, 5000); }
+};
+
 } // namespace Config
 
 class AppConfig
@@ -311,8 +346,10 @@ public:
     template <typename T>
     typename T::Value option() const
     {
-        typename T::Value value = option(T::name(), T::defaultValue());
-        return T::value(value);
+        // Default value can be expensive to get (e.g. checking autostart),
+        // so avoid it if the option is set.
+        const QVariant value = option(T::name());
+        return T::value( value.isValid() ? value.value<typename T::Value>() : T::defaultValue() );
     }
 
     void setOption(const QString &name, const QVariant &value);
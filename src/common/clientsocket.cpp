@@ -36,6 +36,17 @@ ClientSocketId lastSocketId = 0;
 const quint32 protocolMagicNumber = 0x0C090701;
 const quint32 protocolVersion = 1;
 
+// Flag in protocol version field marking compressed message payload.
+const quint32 compressedMessageFlag = 0x80000000;
+// Compress only messages at least this big.
+const int minCompressedMessageSize = 64 * 1024;
+
+bool compressMessages()
+{
+    static const bool compress = !qgetenv("COPYQ_COMPRESS_MESSAGES").isEmpty();
+    return compress;
+}
+
 template <typename T>
 int doStreamDataSize(T value)
 {
@@ -66,29 +77,58 @@ int headerDataSize()
     return bytes.length();
 }
 
-template <typename T>
-bool readValue(T *value, QByteArray *message)
+QByteArray compressMessage(const QByteArray &message, qint32 messageCode)
 {
-    QDataStream stream(*message);
-    stream.setVersion(QDataStream::Qt_5_0);
-    stream >> *value;
-    message->remove(0, streamDataSize(*value));
-    return stream.status() == QDataStream::Ok;
-}
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream.setVersion(QDataStream::Qt_5_0);
+        stream << messageCode;
+        stream.writeRawData( message.constData(), message.length() );
+    }
 
-bool writeMessage(QLocalSocket *socket, const QByteArray &msg)
-{
-    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes).").arg(msg.size()) );
+    const QByteArray compressed = qCompress(bytes, 1);
 
-    if (msg.size() > bigMessageThreshold)
-        COPYQ_LOG( QString("Sending big message: %1 MiB").arg(msg.size() / 1024 / 1024) );
+    // Skip compression if it doesn't save at least a quarter of the size.
+    if ( compressed.length() > bytes.length() - bytes.length() / 4 )
+        return QByteArray();
 
+    return compressed;
+}
+
+bool writeMessage(QLocalSocket *socket, const QByteArray &message, qint32 messageCode)
+{
+    QByteArray compressed;
+    if ( compressMessages() && message.length() >= minCompressedMessageSize )
+        compressed = compressMessage(message, messageCode);
+
+    const bool isCompressed = !compressed.isEmpty();
+    const int length = isCompressed
+            ? compressed.length()
+            : streamDataSize(messageCode) + message.length();
+    COPYQ_LOG_VERBOSE( QString("Write message (%1 bytes%2).")
+                       .arg(length)
+                       .arg(isCompressed ? QString(", compressed") : QString()) );
+
+    if (length > bigMessageThreshold)
+        COPYQ_LOG( QString("Sending big message: %1 MiB").arg(length / 1024 / 1024) );
+
+    const quint32 version = isCompressed
+            ? protocolVersion | compressedMessageFlag
+            : protocolVersion;
+
+    // Message code and data are written directly to socket
+    // to avoid copying possibly big data to a temporary buffer.
     QDataStream out(socket);
     out.setVersion(QDataStream::Qt_5_0);
-    // length is serialized as a quint32, followed by msg
-    const auto length = static_cast<quint32>(msg.length());
-    out << protocolMagicNumber << protocolVersion;
-    out.writeBytes( msg.constData(), length );
+    // length is serialized as a quint32, followed by message code and data
+    out << protocolMagicNumber << version << static_cast<quint32>(length);
+    if (isCompressed) {
+        out.writeRawData( compressed.constData(), compressed.length() );
+    } else {
+        out << messageCode;
+        out.writeRawData( message.constData(), message.length() );
+    }
 
     if (out.status() != QDataStream::Ok) {
         COPYQ_LOG("Cannot write message!");
@@ -193,12 +233,7 @@ void ClientSocket::sendMessage(const QByteArray &message, int messageCode)
     } else if (m_closed) {
         SOCKET_LOG("Client disconnected!");
     } else {
-        QByteArray msg;
-        QDataStream out(&msg, QIODevice::WriteOnly);
-        out.setVersion(QDataStream::Qt_5_0);
-        out << static_cast<qint32>(messageCode);
-        out.writeRawData( message.constData(), message.length() );
-        if ( writeMessage(m_socket, msg) )
+        if ( writeMessage(m_socket, message, static_cast<qint32>(messageCode)) )
             SOCKET_LOG("Message sent to client.");
         else
             SOCKET_LOG("Failed to send message to client!");
@@ -228,14 +263,17 @@ void ClientSocket::onReadyRead()
     const qint64 available = m_socket->bytesAvailable();
     m_message.append( m_socket->read(available) );
 
-    while ( !m_message.isEmpty() ) {
+    // Avoid copying rest of the buffer after each message, processed
+    // messages are removed from the buffer at once after reading all of them.
+    int offset = 0;
+    while ( offset < m_message.length() ) {
         if (!m_hasMessageLength) {
             const int preambleSize = headerDataSize() + streamDataSize(m_messageLength);
-            if ( m_message.length() < preambleSize )
+            if ( m_message.length() - offset < preambleSize )
                 break;
 
             {
-                QDataStream stream(m_message);
+                QDataStream stream( QByteArray::fromRawData(m_message.constData() + offset, preambleSize) );
                 stream.setVersion(QDataStream::Qt_5_0);
                 quint32 magicNumber;
                 quint32 version;
@@ -250,13 +288,15 @@ void ClientSocket::onReadyRead()
                     return;
                 }
 
-                if (version != protocolVersion) {
+                if ( (version & ~compressedMessageFlag) != protocolVersion ) {
                     error("Unexpected message version from client!");
                     return;
                 }
+
+                m_isMessageCompressed = (version & compressedMessageFlag) != 0;
             }
 
-            m_message.remove(0, preambleSize);
+            offset += preambleSize;
             m_hasMessageLength = true;
 
             if (m_messageLength > bigMessageThreshold)
@@ -264,22 +304,53 @@ void ClientSocket::onReadyRead()
         }
 
         const auto length = static_cast<int>(m_messageLength);
-        if ( m_message.length() < length )
+        if ( m_message.length() - offset < length )
             break;
 
-        QByteArray msg = m_message.mid(0, length);
-        qint32 messageCode;
+        const auto readMessageCode = [](const char *data, int size, qint32 *messageCode) {
+            QDataStream stream( QByteArray::fromRawData(data, size) );
+            stream.setVersion(QDataStream::Qt_5_0);
+            stream >> *messageCode;
+            return stream.status() == QDataStream::Ok;
+        };
 
-        if ( !readValue(&messageCode, &msg) ) {
-            error("Failed to read message code from client!");
-            return;
+        QByteArray msg;
+        qint32 messageCode = 0;
+        const int messageCodeSize = streamDataSize(messageCode);
+        if (m_isMessageCompressed) {
+            msg = qUncompress(
+                reinterpret_cast<const uchar*>(m_message.constData() + offset), length);
+            offset += length;
+            if ( msg.isEmpty() ) {
+                error("Failed to uncompress message from client!");
+                return;
+            }
+            if ( !readMessageCode(msg.constData(), msg.length(), &messageCode) ) {
+                error("Failed to read message code from client!");
+                return;
+            }
+            msg.remove(0, messageCodeSize);
+        } else {
+            // Read message code in place and copy only the rest of the message.
+            if ( !readMessageCode(m_message.constData() + offset, length, &messageCode) ) {
+                error("Failed to read message code from client!");
+                return;
+            }
+            msg = m_message.mid(offset + messageCodeSize, length - messageCodeSize);
+            offset += length;
         }
 
         m_hasMessageLength = false;
-        m_message = m_message.mid(length);
 
         emit messageReceived(msg, messageCode, id());
     }
+
+    if (offset > 0)
+        m_message.remove(0, offset);
+
+    // Allocate whole message at once instead of growing the buffer gradually.
+    if (m_hasMessageLength)
+        m_message.reserve( static_cast<int>(m_messageLength) );
 }
 
 void ClientSocket::onError(QLocalSocket::LocalSocketError error)
@@ -92,6 +92,7 @@ private:
 
     bool m_hasMessageLength = false;
     quint32 m_messageLength = 0;
+    bool m_isMessageCompressed = false;
     QByteArray m_message;
 };
 
@@ -71,6 +71,8 @@ struct Command {
         , globalShortcuts()
         , tab()
         , outputTab()
+        , persistent(false)
+        , parallel(false)
         {}
 
     bool operator==(const Command &other) const {
@@ -96,7 +98,9 @@ struct Command {
             && shortcuts == other.shortcuts
             && globalShortcuts == other.globalShortcuts
             && tab == other.tab
-            && outputTab == other.outputTab;
+            && outputTab == other.outputTab
+            && persistent == other.persistent
+            && parallel == other.parallel;
     }
 
     bool operator!=(const Command &other) const {
@@ -203,6 +207,19 @@ struct Command {
 
     /** Tab for output items. */
     QString outputTab;
+
+    /**
+     * If true, program is kept running and receives matched items one by one
+     * (only for automatic and display commands, see PersistentProcess).
+     */
+    bool persistent;
+
+    /**
+     * If true, automatic command is not waited for before running next commands.
+     *
+     * Command must not change the data or call CopyQ (remove and transform are ignored).
+     */
+    bool parallel;
 };
 
 #endif // COMMAND_H
@@ -40,6 +40,8 @@ enum CommandStatus {
     CommandStop = 10,
 
     CommandInputDialogFinished = 11,
+
+    CommandPersistentCommandFinished = 12,
 };
 
 #endif // COMMANDSTATUS_H
@@ -26,6 +26,8 @@
 #include "common/temporarysettings.h"
 #include "common/textdata.h"
 
+#include <QDateTime>
+#include <QFileInfo>
 #include <QSettings>
 #include <QString>
 
@@ -66,6 +68,8 @@ void loadCommand(const QSettings &settings, CommandFilter filter, Commands *comm
     c.outputTab = settings.value("OutputTab").toString();
     c.inMenu = settings.value("InMenu").toBool();
     c.isScript = settings.value("IsScript").toBool();
+    c.persistent = settings.value("Persistent").toBool();
+    c.parallel = settings.value("Parallel").toBool();
 
     const auto globalShortcutsOption = settings.value("IsGlobalShortcut");
     if ( globalShortcutsOption.isValid() ) {
@@ -133,6 +137,8 @@ void saveCommand(const Command &c, QSettings *settings)
     saveNewValue("GlobalShortcut", c, &Command::globalShortcuts, settings);
     saveNewValue("Tab", c, &Command::tab, settings);
     saveNewValue("OutputTab", c, &Command::outputTab, settings);
+    saveNewValue("Persistent", c, &Command::persistent, settings);
+    saveNewValue("Parallel", c, &Command::parallel, settings);
 }
 
 Commands importCommands(QSettings *settings)
@@ -148,24 +154,67 @@ Commands importCommands(QSettings *settings)
     return commands;
 }
 
+/// Commands loaded from application settings, valid until settings file changes.
+struct CommandCache {
+    bool valid = false;
+    QString fileName;
+    QDateTime lastModified;
+    qint64 size = -1;
+    Commands commands;
+};
+
+CommandCache &commandCache()
+{
+    static CommandCache cache;
+    return cache;
+}
+
+const Commands &cachedCommands()
+{
+    QSettings settings;
+    const QFileInfo info( settings.fileName() );
+
+    auto &cache = commandCache();
+    if ( !cache.valid
+         || cache.fileName != settings.fileName()
+         || cache.lastModified != info.lastModified()
+         || cache.size != info.size() )
+    {
+        cache.commands = loadCommands(&settings, AllCommands);
+        cache.fileName = settings.fileName();
+        cache.lastModified = info.lastModified();
+        cache.size = info.size();
+        cache.valid = true;
+    }
+
+    return cache.commands;
+}
+
 } // namespace
 
 Commands loadEnabledCommands()
 {
-    QSettings settings;
-    return loadCommands(&settings, EnabledCommands);
+    Commands commands;
+    for (const auto &command : cachedCommands()) {
+        if (command.enable)
+            commands.append(command);
+    }
+    return commands;
 }
 
 Commands loadAllCommands()
 {
-    QSettings settings;
-    return loadCommands(&settings, AllCommands);
+    return cachedCommands();
 }
 
 void saveCommands(const Commands &commands)
 {
-    Settings settings;
-    saveCommands(commands, settings.settingsData());
+    {
+        Settings settings;
+        saveCommands(commands, settings.settingsData());
+    }
+
+    commandCache().valid = false;
 }
 
 Commands loadCommands(QSettings *settings, CommandFilter filter)
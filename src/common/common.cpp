@@ -31,6 +31,7 @@
 #include <QDropEvent>
 #include <QElapsedTimer>
 #include <QImage>
+#include <QImageReader>
 #include <QImageWriter>
 #include <QKeyEvent>
 #include <QMimeData>
@@ -38,9 +39,13 @@
 #include <QObject>
 #include <QPoint>
 #include <QProcess>
+#include <QRunnable>
+#include <QSemaphore>
 #include <QTextCodec>
 #include <QThread>
+#include <QThreadPool>
 #include <QUrl>
+#include <QVector>
 #include <QWidget>
 
 #include <algorithm>
@@ -50,6 +55,26 @@ namespace {
 
 const int maxElidedTextLineLength = 512;
 
+/**
+ * Returns beginning of UTF-8 text long enough to create label with given
+ * number of lines (see elideText()) without decoding huge text.
+ */
+QString textPrefixForLabel(const QByteArray &bytes, int maxLines)
+{
+    // Each character takes at most 4 bytes in UTF-8.
+    const qint64 maxBytes = 4LL * (maxElidedTextLineLength + 1) * qMax(1, maxLines);
+    if (bytes.size() <= maxBytes)
+        return getTextData(bytes);
+
+    // Avoid splitting multi-byte character.
+    int size = static_cast<int>(maxBytes);
+    while ( size > 0 && (static_cast<uchar>(bytes[size]) & 0xC0) == 0x80 )
+        --size;
+
+    // Trailing new line makes elideText() append triple dot.
+    return QString::fromUtf8(bytes.constData(), size) + '\n';
+}
+
 // Avoids accessing old clipboard/drag'n'drop data.
 class ClipboardDataGuard {
 public:
@@ -147,16 +172,11 @@ QString getImageFormatFromMime(const QString &mime)
  * Sometimes only Qt internal image data are available in cliboard,
  * so this tries to convert the image data (if available) to given format.
  */
-void cloneImageData(
-        const QImage &image, const QString &format,
-        const QString &mime, QVariantMap *dataMap)
+QByteArray imageToBytes(const QImage &image, const QString &format)
 {
-    if (image.isNull())
-        return;
-
     // Omit converting unsupported formats (takes too much time and still fails).
     if ( !QImageWriter::supportedImageFormats().contains(format.toUtf8()) )
-        return;
+        return QByteArray();
 
     QBuffer buffer;
     bool saved = image.save(&buffer, format.toUtf8().constData());
@@ -165,11 +185,68 @@ void cloneImageData(
                .arg(format,
                     saved ? "Done" : "Failed") );
 
-    if (saved)
-        dataMap->insert(mime, buffer.buffer());
+    return saved ? buffer.buffer() : QByteArray();
 }
 
-bool setImageData(const QVariantMap &data, const QString &mime, QMimeData *mimeData)
+/// Converts image to given format in a thread pool.
+class ConvertImageTask final : public QRunnable
+{
+public:
+    ConvertImageTask(const QImage &image, const QString &format, QByteArray *bytes, QSemaphore *finished)
+        : m_image(image)
+        , m_format(format)
+        , m_bytes(bytes)
+        , m_finished(finished)
+    {
+    }
+
+    void run() override
+    {
+        *m_bytes = imageToBytes(m_image, m_format);
+        m_finished->release();
+    }
+
+private:
+    QImage m_image;
+    QString m_format;
+    QByteArray *m_bytes;
+    QSemaphore *m_finished;
+};
+
+void cloneImageData(const QImage &image, const QStringList &mimes, QVariantMap *dataMap)
+{
+    if (image.isNull())
+        return;
+
+    QStringList targetMimes;
+    QStringList formats;
+    for (const auto &mime : mimes) {
+        const QString format = getImageFormatFromMime(mime);
+        if ( !format.isEmpty() ) {
+            targetMimes.append(mime);
+            formats.append(format);
+        }
+    }
+
+    // Encoding large images takes a while, so convert to multiple formats in parallel.
+    QVector<QByteArray> results( formats.size() );
+    if ( formats.size() == 1 ) {
+        results[0] = imageToBytes(image, formats[0]);
+    } else if ( formats.size() > 1 ) {
+        QSemaphore finished;
+        for (int i = 0; i < formats.size(); ++i)
+            QThreadPool::globalInstance()->start( new ConvertImageTask(image, formats[i], &results[i], &finished) );
+        finished.acquire( formats.size() );
+    }
+
+    for (int i = 0; i < results.size(); ++i) {
+        if ( !results[i].isNull() )
+            dataMap->insert(targetMimes[i], results[i]);
+    }
+}
+
+/// Returns true only if data contain a static image which can be decoded.
+bool canReadStaticImage(const QVariantMap &data, const QString &mime)
 {
     if ( !data.contains(mime) )
         return false;
@@ -181,18 +258,60 @@ bool setImageData(const QVariantMap &data, const QString &mime, QMimeData *mimeD
     QByteArray bytes = data.value(mime).toByteArray();
 
     // Omit converting animated images to static ones.
+    {
+        QBuffer buffer(&bytes);
+        QMovie animatedImage( &buffer, imageFormat.toUtf8().constData() );
+        if ( animatedImage.frameCount() > 1 )
+            return false;
+    }
+
     QBuffer buffer(&bytes);
-    QMovie animatedImage( &buffer, imageFormat.toUtf8().constData() );
-    if ( animatedImage.frameCount() > 1 )
-        return false;
+    QImageReader reader( &buffer, imageFormat.toUtf8() );
+    return reader.canRead();
+}
 
-    const QImage image = QImage::fromData( bytes, imageFormat.toUtf8().constData() );
-    if ( image.isNull() )
-        return false;
+/**
+ * Clipboard and drag'n'drop data which decode image only if requested.
+ *
+ * Platform clipboard asks for the data only when pasted so the image
+ * conversions happen only for the format a target application wants.
+ */
+class ClipboardMimeData final : public QMimeData {
+public:
+    explicit ClipboardMimeData(const QString &imageMime)
+        : m_imageMime(imageMime)
+    {
+    }
 
-    mimeData->setImageData(image);
-    return true;
-}
+    QStringList formats() const override
+    {
+        QStringList result = QMimeData::formats();
+        if ( !m_imageMime.isEmpty() && !result.contains(mimeQtImage) )
+            result.append(mimeQtImage);
+        return result;
+    }
+
+protected:
+    QVariant retrieveData(const QString &mime, QVariant::Type type) const override
+    {
+        if ( mime != mimeQtImage || m_imageMime.isEmpty() || QMimeData::formats().contains(mime) )
+            return QMimeData::retrieveData(mime, type);
+
+        if ( m_image.isNull() ) {
+            const QString imageFormat = getImageFormatFromMime(m_imageMime);
+            m_image = QImage::fromData( data(m_imageMime), imageFormat.toUtf8().constData() );
+        }
+
+        return m_image;
+    }
+
+private:
+    static const QString mimeQtImage;
+    QString m_imageMime;
+    mutable QImage m_image;
+};
+
+const QString ClipboardMimeData::mimeQtImage = QStringLiteral("application/x-qt-image");
 
 QTextCodec *codecForText(const QByteArray &bytes)
 {
@@ -261,6 +380,13 @@ QVariantMap cloneData(const QMimeData &rawData, QStringList formats)
 
     QVariantMap newdata;
 
+    // Fetch available formats (TARGETS on X11) and small internal formats first.
+    const QStringList availableFormats = data.formats();
+    for (const auto &internalMime : internalMimeTypes) {
+        if ( availableFormats.contains(internalMime) )
+            newdata.insert( internalMime, data.data(internalMime) );
+    }
+
     /*
      Some apps provide images even when copying huge spreadsheet, this can
      block those apps while generating and providing the data.
@@ -270,8 +396,8 @@ QVariantMap cloneData(const QMimeData &rawData, QStringList formats)
      Images in SVG and other XML formats are expected to be relatively small
      so these doesn't have to be ignored.
      */
-    if ( formats.contains(mimeText) && data.hasFormat(mimeText) ) {
-        const QString mimeImagePrefix = "image/";
+    const QString mimeImagePrefix = "image/";
+    if ( formats.contains(mimeText) && availableFormats.contains(mimeText) ) {
         const auto first = std::remove_if(
                     std::begin(formats), std::end(formats),
                     [&mimeImagePrefix](const QString &format) {
@@ -284,28 +410,28 @@ QVariantMap cloneData(const QMimeData &rawData, QStringList formats)
 
     QStringList imageFormats;
     for (const auto &mime : formats) {
+        if ( newdata.contains(mime) )
+            continue;
+
+        // Avoid requesting formats which are not provided by the owner,
+        // images can still be converted from other image formats.
+        if ( !availableFormats.isEmpty() && !availableFormats.contains(mime) ) {
+            if ( mime.startsWith(mimeImagePrefix) )
+                imageFormats.append(mime);
+            continue;
+        }
+
         const QByteArray bytes = data.getUtf8Data(mime);
         if ( bytes.isEmpty() )
             imageFormats.append(mime);
         else
-            newdata.insert(mime, bytes);
-    }
-
-    for (const auto &internalMime : internalMimeTypes) {
-        if ( data.hasFormat(internalMime) )
-            newdata.insert( internalMime, data.data(internalMime) );
+            newdata.insert( internMime(mime), bytes );
     }
 
     // Retrieve images last since this can take a while.
     if ( !imageFormats.isEmpty() ) {
         const QImage image = data.getImageData();
-        if ( !image.isNull() ) {
-            for (const auto &mime : imageFormats) {
-                const QString format = getImageFormatFromMime(mime);
-                if ( !format.isEmpty() )
-                    cloneImageData(image, format, mime, &newdata);
-            }
-        }
+        cloneImageData(image, imageFormats, &newdata);
     }
 
     if ( hasLogLevel(LogTrace) ) {
@@ -337,7 +463,18 @@ QMimeData* createMimeData(const QVariantMap &data)
     QStringList copyFormats = data.keys();
     copyFormats.removeOne(mimeClipboardMode);
 
-    std::unique_ptr<QMimeData> newClipboardData(new QMimeData);
+    // Find image to provide (image is decoded only when requested).
+    QString imageMime;
+    const QStringList formats =
+            QStringList() << "image/png" << "image/bmp" << "application/x-qt-image" << data.keys();
+    for (const auto &imageFormat : formats) {
+        if ( canReadStaticImage(data, imageFormat) ) {
+            imageMime = imageFormat;
+            break;
+        }
+    }
+
+    std::unique_ptr<QMimeData> newClipboardData(new ClipboardMimeData(imageMime));
 
     for ( const auto &format : copyFormats )
         newClipboardData->setData( format, data[format].toByteArray() );
@@ -345,14 +482,6 @@ QMimeData* createMimeData(const QVariantMap &data)
     if ( !copyFormats.contains(mimeOwner) )
         newClipboardData->setData( mimeOwner, makeClipboardOwnerData() );
 
-    // Set image data.
-    const QStringList formats =
-            QStringList() << "image/png" << "image/bmp" << "application/x-qt-image" << data.keys();
-    for (const auto &imageFormat : formats) {
-        if ( setImageData(data, imageFormat, newClipboardData.get()) )
-            break;
-    }
-
     return newClipboardData.release();
 }
 
@@ -367,22 +496,56 @@ QString elideText(const QString &text, const QFont &font, const QString &format,
     if (maxWidthPixels <= 0)
         maxWidthPixels = smallIconSize() * 20;
 
-    QStringList lines = text.split('\n');
+    // Take only the lines to show instead of splitting whole text,
+    // ignore empty lines at beginning and end.
+    QStringList lines;
+    int lastLine = -1;
+    int lastLineEnd = 0;
+    bool hasLinesBefore = false;
+    for ( int start = 0; start <= text.size() && lines.size() < qMax(1, maxLines); ) {
+        int end = text.indexOf('\n', start);
+        if (end == -1)
+            end = text.size();
+
+        int indentEnd = start;
+        while ( indentEnd < end && text[indentEnd].isSpace() )
+            ++indentEnd;
+        const bool isEmpty = indentEnd == end;
+
+        if ( isEmpty && lines.isEmpty() ) {
+            hasLinesBefore = true;
+        } else {
+            // Long lines are shortened below anyway.
+            const int maxLength = (isEmpty ? 0 : indentEnd - start) + maxElidedTextLineLength + 1;
+            lines.append( text.mid(start, qMin(end - start, maxLength)) );
+            if (!isEmpty) {
+                lastLine = lines.size() - 1;
+                lastLineEnd = end;
+            }
+        }
+
+        start = end + 1;
+    }
+
+    if (lastLine == -1) {
+        // Text contains only white space.
+        hasLinesBefore = false;
+        lastLineEnd = text.indexOf('\n');
+        if (lastLineEnd == -1)
+            lastLineEnd = text.size();
+        lines = QStringList( text.left(qMin(lastLineEnd, maxElidedTextLineLength + 1)) );
+        lastLine = 0;
+    }
 
-    // Ignore empty lines at beginning.
-    static const QRegExp reNonEmpty(".*\\S.*");
-    const int firstLine = qMax(0, lines.indexOf(reNonEmpty));
-    const int lastLine = qMax(0, lines.lastIndexOf(reNonEmpty, firstLine + maxLines - 1));
+    lines.erase( lines.begin() + lastLine + 1, lines.end() );
 
     // If empty lines are at beginning, prepend triple dot.
-    if (firstLine != 0)
-        lines[firstLine].prepend("...");
+    if (hasLinesBefore)
+        lines.first().prepend("...");
 
     // If there are too many lines, append triple dot.
-    if (lastLine + 1 != lines.size())
-        lines[lastLine].append("...");
-
-    lines = lines.mid(firstLine, lastLine - firstLine + 1);
+    if (lastLineEnd < text.size())
+        lines.last().append("...");
 
     QFontMetrics fm(font);
     const int formatWidth = format.isEmpty() ? 0 : fm.width(format.arg(QString()));
@@ -433,8 +596,11 @@ QString textLabelForData(const QVariantMap &data, const QFont &font, const QStri
     if ( data.contains(mimeHidden) ) {
         label = QObject::tr("<HIDDEN>", "Label for hidden/secret clipboard content");
     } else if ( data.contains(mimeText) || data.contains(mimeUriList) ) {
-        const QString text = getTextData(data);
-        const int n = text.count(QChar('\n')) + 1;
+        // Decode only beginning of text, new line bytes cannot be part of
+        // multi-byte characters in UTF-8 so lines are counted without decoding.
+        const QByteArray bytes = data.value( data.contains(mimeText) ? mimeText : mimeUriList ).toByteArray();
+        const QString text = textPrefixForLabel(bytes, maxLines);
+        const int n = bytes.count('\n') + 1;
 
         if (n > 1)
             label = QObject::tr("%1 (%n lines)", "Label for multi-line text in clipboard", n);
@@ -480,7 +646,7 @@ void renameToUnique(QString *name, const QStringList &names)
         *name = baseName + " (" + QString::number(++i) + ')';
 }
 
-QString dataToText(const QByteArray &bytes, const QString &mime)
+QTextCodec *codecForData(const QByteArray &bytes, const QString &mime)
 {
     auto codec = (mime == mimeHtml)
             ? QTextCodec::codecForHtml(bytes, nullptr)
@@ -489,7 +655,12 @@ QString dataToText(const QByteArray &bytes, const QString &mime)
     if (!codec)
         codec = codecForText(bytes);
 
-    return codec->toUnicode(bytes);
+    return codec;
+}
+
+QString dataToText(const QByteArray &bytes, const QString &mime)
+{
+    return codecForData(bytes, mime)->toUnicode(bytes);
 }
 
 bool isClipboardData(const QVariantMap &data)
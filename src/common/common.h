@@ -37,6 +37,7 @@ class QPoint;
 class QProcess;
 class QString;
 class QStringList;
+class QTextCodec;
 class QWidget;
 
 #if !defined(COPYQ_WS_X11) && !defined(Q_OS_WIN) && !defined(Q_OS_MAC)
@@ -104,6 +105,9 @@ QString textLabelForData(const QVariantMap &data);
 
 void renameToUnique(QString *name, const QStringList &names);
 
+/// Return codec to decode text data in given format.
+QTextCodec *codecForData(const QByteArray &bytes, const QString &mime);
+
 QString dataToText(const QByteArray &bytes, const QString &mime);
 
 bool isClipboardData(const QVariantMap &data);
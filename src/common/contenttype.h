@@ -59,7 +59,18 @@ enum {
     color,
 
     /// If true, hide content of item (not notes, tags etc.).
-    isHidden
+    isHidden,
+
+    /**
+     * Set serialized item data (SerializedItemData) to decode only when item data are needed.
+     */
+    serializedData,
+
+    /// Time when item was created (milliseconds since epoch).
+    createdTime,
+
+    /// Time when item was last copied to clipboard or created (milliseconds since epoch).
+    lastUsedTime
 };
 
 }
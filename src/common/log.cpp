@@ -23,6 +23,9 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QString>
 #include <QSystemSemaphore>
 #include <QThread>
@@ -262,11 +265,24 @@ QString logFileName()
     if (!fileName.isEmpty())
         return QDir::fromNativeSeparators(fileName);
 
+    // Avoid looking up and creating log directory for each message.
+    // The path depends on application and organization name which are changed on start.
+    static QMutex mutex;
+    static QString cachedAppName;
+    static QString cachedFileName;
+    const QString appName =
+            QCoreApplication::organizationName() + '/' + QCoreApplication::applicationName();
+    QMutexLocker lock(&mutex);
+    if ( !cachedFileName.isEmpty() && appName == cachedAppName )
+        return cachedFileName;
+
     const QString path = getDefaultLogFilePath();
     QDir dir(path);
     dir.mkpath(".");
 
-    return path + "/copyq.log";
+    cachedAppName = appName;
+    cachedFileName = path + "/copyq.log";
+    return cachedFileName;
 }
 
 QString readLogFile(int maxReadSize)
@@ -320,13 +336,19 @@ void log(const QString &text, const LogLevel level)
     if ( !hasLogLevel(level) )
         return;
 
-    SystemMutexLocker lock(getSessionMutex());
-
     const auto msgText = text.toUtf8();
     const auto msg = createLogMessage(msgText, level);
 
+    // Unbuffered append of a message is single atomic write with O_APPEND
+    // on POSIX systems, so processes need to be synchronized only for rotating
+    // log files.
+#ifdef Q_OS_WIN
+    SystemMutexLocker lock(getSessionMutex());
+#endif
+
     QFile f( logFileName() );
-    const bool writtenToLogFile = f.open(QIODevice::Append) && f.write(msg);
+    const bool writtenToLogFile =
+            f.open(QIODevice::Append | QIODevice::Unbuffered) && f.write(msg);
     if (writtenToLogFile)
         f.close();
 
@@ -338,8 +360,14 @@ void log(const QString &text, const LogLevel level)
         ferr.write(simpleMsg);
     }
 
-    if ( writtenToLogFile && f.size() > logFileSize )
-        rotateLogFiles();
+    if ( writtenToLogFile && f.size() > logFileSize ) {
+#ifndef Q_OS_WIN
+        SystemMutexLocker lock(getSessionMutex());
+#endif
+        // Other process could have rotated the files already.
+        if ( QFileInfo(f.fileName()).size() > logFileSize )
+            rotateLogFiles();
+    }
 }
 
 void setCurrentThreadName(const QString &name)
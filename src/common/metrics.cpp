@@ -0,0 +1,149 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "metrics.h"
+
+#include "common/log.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QString>
+
+#include <map>
+
+namespace {
+
+/// Upper bounds of histogram buckets in microseconds.
+const qint64 bucketBoundsUs[] = {
+    1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000 };
+const int bucketCount = sizeof(bucketBoundsUs) / sizeof(bucketBoundsUs[0]);
+
+struct Histogram {
+    qint64 buckets[bucketCount] = {};
+    qint64 count = 0;
+    qint64 sumUs = 0;
+};
+
+struct Metrics {
+    QMutex mutex;
+    std::map<QByteArray, qint64> counters;
+    std::map<QByteArray, Histogram> histograms;
+};
+
+Metrics &metrics()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+QString seconds(qint64 us)
+{
+    return QString::number(us / 1e6, 'g', 10);
+}
+
+} // namespace
+
+void countMetric(const char *name, qint64 value)
+{
+    auto &m = metrics();
+    QMutexLocker lock(&m.mutex);
+    m.counters[QByteArray::fromRawData(name, static_cast<int>(qstrlen(name)))] += value;
+}
+
+void addMetricDuration(const char *name, qint64 durationUs)
+{
+    auto &m = metrics();
+    QMutexLocker lock(&m.mutex);
+    auto &histogram = m.histograms[QByteArray::fromRawData(name, static_cast<int>(qstrlen(name)))];
+    for (int i = 0; i < bucketCount; ++i) {
+        if (durationUs <= bucketBoundsUs[i])
+            ++histogram.buckets[i];
+    }
+    ++histogram.count;
+    histogram.sumUs += durationUs;
+}
+
+MetricTimer::MetricTimer(const char *name)
+    : m_name(name)
+{
+    m_timer.start();
+}
+
+MetricTimer::~MetricTimer()
+{
+    addMetricDuration(m_name, m_timer.nsecsElapsed() / 1000);
+}
+
+QString metricsText()
+{
+    auto &m = metrics();
+    QMutexLocker lock(&m.mutex);
+
+    QString text;
+    for (const auto &counter : m.counters) {
+        const QString name = "copyq_" + QString::fromLatin1(counter.first) + "_total";
+        text.append( QString("# TYPE %1 counter\n").arg(name) );
+        text.append( QString("%1 %2\n").arg(name).arg(counter.second) );
+    }
+
+    for (const auto &it : m.histograms) {
+        const QString name = "copyq_" + QString::fromLatin1(it.first) + "_seconds";
+        const auto &histogram = it.second;
+        text.append( QString("# TYPE %1 histogram\n").arg(name) );
+        for (int i = 0; i < bucketCount; ++i) {
+            text.append( QString("%1_bucket{le=\"%2\"} %3\n")
+                         .arg(name, seconds(bucketBoundsUs[i]))
+                         .arg(histogram.buckets[i]) );
+        }
+        text.append( QString("%1_bucket{le=\"+Inf\"} %2\n").arg(name).arg(histogram.count) );
+        text.append( QString("%1_sum %2\n").arg(name, seconds(histogram.sumUs)) );
+        text.append( QString("%1_count %2\n").arg(name).arg(histogram.count) );
+    }
+
+    return text;
+}
+
+QString metricsFileName()
+{
+    return QString::fromLocal8Bit( qgetenv("COPYQ_METRICS_FILE") );
+}
+
+void exportMetrics()
+{
+    const QString fileName = metricsFileName();
+    if ( fileName.isEmpty() )
+        return;
+
+    // Replace the file atomically so it's never read incomplete.
+    QSaveFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        log( QString("Failed to export metrics to \"%1\": %2")
+             .arg(fileName, file.errorString()), LogError );
+        return;
+    }
+
+    file.write( metricsText().toUtf8() );
+    if ( !file.commit() ) {
+        log( QString("Failed to export metrics to \"%1\": %2")
+             .arg(fileName, file.errorString()), LogError );
+    }
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QElapsedTimer>
+#include <QtGlobal>
+
+class QString;
+
+/// Increase counter with given name (names must be static strings).
+void countMetric(const char *name, qint64 value = 1);
+
+/// Add duration sample to histogram with given name.
+void addMetricDuration(const char *name, qint64 durationUs);
+
+/**
+ * Adds duration from construction to destruction to histogram with given name.
+ */
+class MetricTimer final {
+public:
+    explicit MetricTimer(const char *name);
+    ~MetricTimer();
+
+    MetricTimer(const MetricTimer &) = delete;
+    MetricTimer &operator=(const MetricTimer &) = delete;
+
+private:
+    const char *m_name;
+    QElapsedTimer m_timer;
+};
+
+/// Return counters and histograms in Prometheus text format.
+QString metricsText();
+
+/**
+ * Return file to periodically export metrics to (COPYQ_METRICS_FILE
+ * environment variable) or empty string.
+ */
+QString metricsFileName();
+
+/// Write metricsText() to metricsFileName().
+void exportMetrics();
+
+#endif // METRICS_H
@@ -19,6 +19,18 @@
 
 #include "mimetypes.h"
 
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+
+namespace {
+
+// Avoid growing without limit if unique formats are used.
+const int maxInternedMimeCount = 4096;
+
+} // namespace
+
 const char mimeText[] = "text/plain";
 const char mimeHtml[] = "text/html";
 const char mimeUriList[] = "text/uri-list";
@@ -34,3 +46,21 @@ const char mimeHidden[] = COPYQ_MIME_PREFIX "hidden";
 const char mimeShortcut[] = COPYQ_MIME_PREFIX "shortcut";
 const char mimeColor[] = COPYQ_MIME_PREFIX "color";
 const char mimeOutputTab[] = COPYQ_MIME_PREFIX "output-tab";
+const char mimeMissingData[] = COPYQ_MIME_PREFIX "missing-data";
+
+QString internMime(const QString &mime)
+{
+    static QMutex mutex;
+    static QSet<QString> mimes;
+
+    QMutexLocker lock(&mutex);
+
+    const auto it = mimes.constFind(mime);
+    if ( it != mimes.constEnd() )
+        return *it;
+
+    if ( mimes.size() < maxInternedMimeCount )
+        mimes.insert(mime);
+
+    return mime;
+}
@@ -20,6 +20,8 @@
 #ifndef MIMETYPES_H
 #define MIMETYPES_H
 
+class QString;
+
 #define COPYQ_MIME_PREFIX "application/x-copyq-"
 extern const char mimeText[];
 extern const char mimeHtml[];
@@ -36,5 +38,14 @@ extern const char mimeHidden[];
 extern const char mimeShortcut[];
 extern const char mimeColor[];
 extern const char mimeOutputTab[];
+extern const char mimeMissingData[];
+
+/**
+ * Return shared instance of MIME type string.
+ *
+ * Item formats repeat a lot, so storing interned strings avoids allocating
+ * the same string for every item. Safe to call from any thread.
+ */
+QString internMime(const QString &mime);
 
 #endif // MIMETYPES_H
@@ -0,0 +1,281 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "persistentprocess.h"
+
+#include "common/log.h"
+#include "common/processsignals.h"
+
+#include <QCoreApplication>
+
+namespace {
+
+/// Time to wait for the program to start and for each reply.
+const int timeoutMs = 30000;
+
+/// Time to wait for stopped program to exit after closing its input.
+const int stopTimeoutMs = 1000;
+
+/// Frame header contains only size of data, longer header is invalid.
+const int maxHeaderSize = 20;
+
+/// Keep only end of standard error output for error messages.
+const int maxErrorOutputSize = 4096;
+
+QByteArray toFrame(const QByteArray &data)
+{
+    return QByteArray::number(data.size()) + '\n' + data;
+}
+
+} // namespace
+
+PersistentProcess::PersistentProcess(const QStringList &arguments, QObject *parent)
+    : QObject(parent)
+    , m_arguments(arguments)
+{
+    m_timerReply.setSingleShot(true);
+    m_timerReply.setInterval(timeoutMs);
+    connect( &m_timerReply, &QTimer::timeout,
+             this, &PersistentProcess::onTimeout );
+}
+
+PersistentProcess::~PersistentProcess()
+{
+    m_timerReply.stop();
+
+    const auto requests = m_requests;
+    m_requests.clear();
+    for (const auto &request : requests)
+        emit itemProcessed(request.id, false, QByteArray(), "Program stopped");
+
+    stopProcess(false);
+}
+
+int PersistentProcess::process(const QByteArray &input)
+{
+    static int lastRequestId = 0;
+    const int requestId = ++lastRequestId;
+    m_requests.append( Request{requestId, input, false} );
+
+    // Caller gets the request ID before the reply can be passed.
+    QMetaObject::invokeMethod(this, "processNext", Qt::QueuedConnection);
+
+    return requestId;
+}
+
+void PersistentProcess::processNext()
+{
+    if ( m_waitingForReply || m_requests.isEmpty() )
+        return;
+
+    if (!m_process) {
+        startProcess();
+        return;
+    }
+
+    // Continues after the program starts.
+    if ( m_process->state() != QProcess::Running )
+        return;
+
+    m_waitingForReply = true;
+    m_timerReply.start();
+
+    const QByteArray frame = toFrame( m_requests.first().input );
+    if ( m_process->write(frame) != frame.size() )
+        failRequest( errorWithOutput(m_process->errorString()) );
+}
+
+void PersistentProcess::startProcess()
+{
+    m_buffer.clear();
+    m_errorOutput.clear();
+
+    QString executable = m_arguments.value(0);
+
+    // Replace "copyq" command with full application path.
+    if (executable == "copyq")
+        executable = QCoreApplication::applicationFilePath();
+
+    COPYQ_LOG( QString("Starting program \"%1\"").arg(m_arguments.join(" ")) );
+
+    m_process = new QProcess(this);
+    connect( m_process, &QProcess::started,
+             this, &PersistentProcess::onStarted );
+    connect( m_process, &QProcess::readyReadStandardOutput,
+             this, &PersistentProcess::onReadyRead );
+    connect( m_process, &QProcess::readyReadStandardError,
+             this, &PersistentProcess::onErrorOutput );
+    connectProcessFinished( m_process, this, &PersistentProcess::onFinished );
+    connectProcessError( m_process, this, &PersistentProcess::onError );
+
+    // Starting the program counts to the time for reply.
+    m_timerReply.start();
+    m_process->start(executable, m_arguments.mid(1), QIODevice::ReadWrite);
+}
+
+void PersistentProcess::stopProcess(bool kill)
+{
+    if (!m_process)
+        return;
+
+    QProcess *process = m_process;
+    m_process = nullptr;
+    m_buffer.clear();
+    process->disconnect(this);
+
+    if ( process->state() == QProcess::NotRunning ) {
+        process->deleteLater();
+        return;
+    }
+
+    // Don't wait for the program to exit, it's deleted later.
+    process->setParent(nullptr);
+    const auto processFinishedSignal = static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished);
+    connect( process, processFinishedSignal, process, &QObject::deleteLater );
+
+    if (kill) {
+        process->kill();
+    } else {
+        // Program should exit after its input is closed.
+        process->closeWriteChannel();
+        QTimer::singleShot( stopTimeoutMs, process, SLOT(kill()) );
+    }
+}
+
+void PersistentProcess::finishRequest(bool ok, const QByteArray &output, const QString &error)
+{
+    m_waitingForReply = false;
+    m_timerReply.stop();
+
+    if ( m_requests.isEmpty() )
+        return;
+
+    const int requestId = m_requests.takeFirst().id;
+    emit itemProcessed(requestId, ok, output, error);
+
+    processNext();
+}
+
+void PersistentProcess::failRequest(const QString &error)
+{
+    m_waitingForReply = false;
+    m_timerReply.stop();
+    stopProcess(true);
+
+    if ( m_requests.isEmpty() )
+        return;
+
+    // Try once more with the program started again.
+    Request &request = m_requests.first();
+    if (!request.restarted) {
+        COPYQ_LOG( QString("Restarting program \"%1\": %2").arg(m_arguments.join(" "), error) );
+        request.restarted = true;
+        processNext();
+        return;
+    }
+
+    finishRequest(false, QByteArray(), error);
+}
+
+void PersistentProcess::onStarted()
+{
+    m_timerReply.stop();
+    processNext();
+}
+
+void PersistentProcess::onReadyRead()
+{
+    // Keep output until it's expected.
+    if (!m_waitingForReply) {
+        m_buffer.append( m_process->readAllStandardOutput() );
+        return;
+    }
+
+    QByteArray output;
+    const ReplyStatus status = readReply(&output);
+    if (status == ReplyStatus::Complete)
+        finishRequest(true, output, QString());
+    else if (status == ReplyStatus::Invalid)
+        failRequest( errorWithOutput("Invalid reply") );
+}
+
+void PersistentProcess::onFinished(int exitCode, QProcess::ExitStatus)
+{
+    const QString error = errorWithOutput( QString("Exited with code %1").arg(exitCode) );
+    stopProcess(false);
+
+    // Only queued items are affected, an idle program is started again for next item.
+    if ( !m_requests.isEmpty() )
+        failRequest(error);
+}
+
+void PersistentProcess::onError(QProcess::ProcessError error)
+{
+    // Other errors are followed by finished signal or handled by timeout.
+    if (error != QProcess::FailedToStart)
+        return;
+
+    const QString errorString = errorWithOutput( m_process->errorString() );
+    stopProcess(true);
+    if ( !m_requests.isEmpty() )
+        failRequest(errorString);
+}
+
+void PersistentProcess::onErrorOutput()
+{
+    m_errorOutput.append( m_process->readAllStandardError() );
+    if (m_errorOutput.size() > maxErrorOutputSize)
+        m_errorOutput.remove(0, m_errorOutput.size() - maxErrorOutputSize);
+}
+
+void PersistentProcess::onTimeout()
+{
+    failRequest( errorWithOutput(m_waitingForReply ? "Timed out waiting for reply" : "Timed out starting program") );
+}
+
+PersistentProcess::ReplyStatus PersistentProcess::readReply(QByteArray *output)
+{
+    m_buffer.append( m_process->readAllStandardOutput() );
+
+    const int headerEnd = m_buffer.indexOf('\n');
+    if (headerEnd == -1)
+        return m_buffer.size() > maxHeaderSize ? ReplyStatus::Invalid : ReplyStatus::Incomplete;
+
+    bool ok;
+    const int size = m_buffer.left(headerEnd).trimmed().toInt(&ok);
+    if (!ok || size < 0 || headerEnd > maxHeaderSize)
+        return ReplyStatus::Invalid;
+
+    const int dataStart = headerEnd + 1;
+    if (m_buffer.size() - dataStart < size)
+        return ReplyStatus::Incomplete;
+
+    *output = m_buffer.mid(dataStart, size);
+    m_buffer.remove(0, dataStart + size);
+    return ReplyStatus::Complete;
+}
+
+QString PersistentProcess::errorWithOutput(const QString &error) const
+{
+    if ( m_errorOutput.isEmpty() )
+        return error;
+
+    return error + "\n" + QString::fromUtf8(m_errorOutput);
+}
@@ -0,0 +1,107 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef PERSISTENTPROCESS_H
+#define PERSISTENTPROCESS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+
+/**
+ * Long-running program which processes items one by one (see Command::persistent).
+ *
+ * Each item is written to standard input of the program as a frame: size of
+ * the data in bytes as decimal number followed by new line and the data.
+ * The program must reply with a frame in the same format on its standard
+ * output before it receives next item.
+ *
+ * The program is started on first use and restarted if it exits or fails
+ * to reply.
+ *
+ * Nothing blocks: items are queued and each reply is passed with
+ * itemProcessed() signal.
+ */
+class PersistentProcess final : public QObject
+{
+    Q_OBJECT
+public:
+    /// Create process for program given by @a arguments (first is the executable).
+    explicit PersistentProcess(const QStringList &arguments, QObject *parent = nullptr);
+
+    /// Fails queued items and lets the program exit after its input is closed.
+    ~PersistentProcess();
+
+    /// Return program and arguments.
+    const QStringList &arguments() const { return m_arguments; }
+
+    /**
+     * Queue @a input for the program.
+     *
+     * @return request ID passed to itemProcessed() (unique for all processes)
+     */
+    int process(const QByteArray &input);
+
+signals:
+    /**
+     * Emitted when processing of an item finishes.
+     *
+     * If @a ok is false, the program failed to start or reply (details in @a error).
+     */
+    void itemProcessed(int requestId, bool ok, const QByteArray &output, const QString &error);
+
+private:
+    enum class ReplyStatus { Incomplete, Complete, Invalid };
+
+    struct Request {
+        int id;
+        QByteArray input;
+        bool restarted;
+    };
+
+    Q_INVOKABLE void processNext();
+    void startProcess();
+    void stopProcess(bool kill);
+    void finishRequest(bool ok, const QByteArray &output, const QString &error);
+    void failRequest(const QString &error);
+
+    void onStarted();
+    void onReadyRead();
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onError(QProcess::ProcessError error);
+    void onErrorOutput();
+    void onTimeout();
+
+    ReplyStatus readReply(QByteArray *output);
+    QString errorWithOutput(const QString &error) const;
+
+    QStringList m_arguments;
+    QProcess *m_process = nullptr;
+    QList<Request> m_requests;
+    bool m_waitingForReply = false;
+    QTimer m_timerReply;
+    QByteArray m_buffer;
+    QByteArray m_errorOutput;
+};
+
+#endif // PERSISTENTPROCESS_H
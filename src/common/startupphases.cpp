@@ -0,0 +1,143 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "startupphases.h"
+
+#include "common/log.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+namespace {
+
+struct Phase {
+    const char *name;
+    int depth;
+    qint64 startUs;
+    qint64 durationUs;
+};
+
+struct StartupPhases {
+    StartupPhases() { timer.start(); }
+
+    QElapsedTimer timer;
+    QVector<Phase> phases;
+    int depth = 0;
+    bool finished = false;
+    qint64 totalUs = 0;
+};
+
+StartupPhases &startupPhases()
+{
+    static StartupPhases phases;
+    return phases;
+}
+
+qint64 elapsedUs(const QElapsedTimer &timer)
+{
+    return timer.nsecsElapsed() / 1000;
+}
+
+void saveChromeTrace(const QString &fileName, const QVector<Phase> &phases, qint64 totalUs)
+{
+    QJsonArray events;
+    for (const auto &phase : QVector<Phase>{Phase{"startup", -1, 0, totalUs}} + phases) {
+        QJsonObject event;
+        event["name"] = QString::fromLatin1(phase.name);
+        event["ph"] = QString("X");
+        event["ts"] = static_cast<double>(phase.startUs);
+        event["dur"] = static_cast<double>(phase.durationUs);
+        event["pid"] = 1;
+        event["tid"] = 1;
+        events.append(event);
+    }
+
+    QFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        log( QString("Failed to save startup trace to \"%1\": %2")
+             .arg(fileName, file.errorString()), LogError );
+        return;
+    }
+
+    file.write( QJsonDocument(events).toJson() );
+}
+
+} // namespace
+
+StartupPhase::StartupPhase(const char *name)
+    : m_index(-1)
+{
+    auto &d = startupPhases();
+    if (d.finished)
+        return;
+
+    m_index = d.phases.size();
+    d.phases.append( Phase{name, d.depth, elapsedUs(d.timer), 0} );
+    ++d.depth;
+}
+
+StartupPhase::~StartupPhase()
+{
+    if (m_index == -1)
+        return;
+
+    auto &d = startupPhases();
+    auto &phase = d.phases[m_index];
+    phase.durationUs = elapsedUs(d.timer) - phase.startUs;
+    --d.depth;
+
+    COPYQ_LOG_VERBOSE( QString("Startup phase \"%1\": %2 ms")
+                       .arg(phase.name)
+                       .arg(phase.durationUs / 1000.0, 0, 'f', 1) );
+}
+
+void finishStartupPhases()
+{
+    auto &d = startupPhases();
+    if (d.finished)
+        return;
+
+    d.finished = true;
+    d.totalUs = elapsedUs(d.timer);
+
+    COPYQ_LOG( QString("Started in %1 ms").arg(d.totalUs / 1000.0, 0, 'f', 1) );
+
+    const QString fileName = QString::fromLocal8Bit( qgetenv("COPYQ_STARTUP_TRACE") );
+    if ( !fileName.isEmpty() )
+        saveChromeTrace(fileName, d.phases, d.totalUs);
+}
+
+QString startupPhasesText()
+{
+    const auto &d = startupPhases();
+
+    QString text = QString("startup: %1 ms").arg(d.totalUs / 1000.0, 0, 'f', 1);
+    for (const auto &phase : d.phases) {
+        text.append( QString("\n%1%2: %3 ms")
+                     .arg(QString(2 * (phase.depth + 1), ' '), QString::fromLatin1(phase.name))
+                     .arg(phase.durationUs / 1000.0, 0, 'f', 1) );
+    }
+
+    return text;
+}
@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STARTUPPHASES_H
+#define STARTUPPHASES_H
+
+class QString;
+
+/**
+ * Records time spent in a named application startup phase (from construction to destruction).
+ *
+ * Phases can be nested. Recording stops after finishStartupPhases() is called.
+ */
+class StartupPhase final {
+public:
+    explicit StartupPhase(const char *name);
+    ~StartupPhase();
+
+    StartupPhase(const StartupPhase &) = delete;
+    StartupPhase &operator=(const StartupPhase &) = delete;
+
+private:
+    int m_index;
+};
+
+/**
+ * Stop recording startup phases.
+ *
+ * If COPYQ_STARTUP_TRACE environment variable is set, phases are written
+ * to the file in Chrome trace format (open in chrome://tracing).
+ */
+void finishStartupPhases();
+
+/// Return summary of recorded startup phases.
+QString startupPhasesText();
+
+#endif // STARTUPPHASES_H
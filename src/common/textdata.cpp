@@ -22,11 +22,66 @@
 #include "common/mimetypes.h"
 
 #include <QLocale>
+#include <QRegExp>
 #include <QString>
+#include <QStringList>
+#include <QThreadStorage>
+#include <QtEndian>
 #include <Qt>
 
 namespace {
 
+const quint64 prime64_1 = Q_UINT64_C(0x9E3779B185EBCA87);
+const quint64 prime64_2 = Q_UINT64_C(0xC2B2AE3D27D4EB4F);
+const quint64 prime64_3 = Q_UINT64_C(0x165667B19E3779F9);
+const quint64 prime64_4 = Q_UINT64_C(0x85EBCA77C2B2AE63);
+const quint64 prime64_5 = Q_UINT64_C(0x27D4EB2F165667C5);
+
+quint64 rotateLeft(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+quint64 xxhRound(quint64 acc, quint64 input)
+{
+    acc += input * prime64_2;
+    acc = rotateLeft(acc, 31);
+    return acc * prime64_1;
+}
+
+quint64 xxhMergeRound(quint64 acc, quint64 value)
+{
+    acc ^= xxhRound(0, value);
+    return acc * prime64_1 + prime64_4;
+}
+
+/// Literal words split from filter pattern (see splitWordsPattern()).
+struct FilterWords {
+    bool cached = false;
+    QString pattern;
+    bool isWordsPattern = false;
+    QStringList words;
+};
+
+/**
+ * Returns words for filter pattern.
+ *
+ * The pattern is split only if it differs from the last one in current thread
+ * so it's not done again for each filtered item.
+ */
+const FilterWords &filterWords(const QString &pattern)
+{
+    static QThreadStorage<FilterWords> cache;
+    FilterWords &filterWords = cache.localData();
+    if ( !filterWords.cached || filterWords.pattern != pattern ) {
+        filterWords.cached = true;
+        filterWords.pattern = pattern;
+        filterWords.words.clear();
+        filterWords.isWordsPattern = splitWordsPattern(pattern, &filterWords.words);
+    }
+    return filterWords;
+}
+
 QString escapeHtmlSpaces(const QString &str)
 {
     QString str2 = str;
@@ -37,22 +92,89 @@ QString escapeHtmlSpaces(const QString &str)
 
 } // namespace
 
-uint hash(const QVariantMap &data)
+quint64 contentHash(const char *data, int size, quint64 seed)
 {
-    uint hash = 0;
+    const auto *p = reinterpret_cast<const uchar *>(data);
+    const auto *end = p + size;
+    quint64 h;
 
-    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &mime = it.key();
+    if (size >= 32) {
+        const auto *limit = end - 32;
+        quint64 v1 = seed + prime64_1 + prime64_2;
+        quint64 v2 = seed + prime64_2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - prime64_1;
 
-        // Skip some special data.
-        if (mime == mimeWindowTitle || mime == mimeOwner || mime == mimeClipboardMode)
-            continue;
-        hash ^= qHash(data[mime].toByteArray()) + qHash(mime);
+        do {
+            v1 = xxhRound(v1, qFromLittleEndian<quint64>(p));
+            v2 = xxhRound(v2, qFromLittleEndian<quint64>(p + 8));
+            v3 = xxhRound(v3, qFromLittleEndian<quint64>(p + 16));
+            v4 = xxhRound(v4, qFromLittleEndian<quint64>(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        h = xxhMergeRound(h, v1);
+        h = xxhMergeRound(h, v2);
+        h = xxhMergeRound(h, v3);
+        h = xxhMergeRound(h, v4);
+    } else {
+        h = seed + prime64_5;
     }
 
+    h += static_cast<quint64>(size);
+
+    for (; p + 8 <= end; p += 8) {
+        h ^= xxhRound(0, qFromLittleEndian<quint64>(p));
+        h = rotateLeft(h, 27) * prime64_1 + prime64_4;
+    }
+
+    if (p + 4 <= end) {
+        h ^= static_cast<quint64>(qFromLittleEndian<quint32>(p)) * prime64_1;
+        h = rotateLeft(h, 23) * prime64_2 + prime64_3;
+        p += 4;
+    }
+
+    for (; p < end; ++p) {
+        h ^= static_cast<quint64>(*p) * prime64_5;
+        h = rotateLeft(h, 11) * prime64_1;
+    }
+
+    h ^= h >> 33;
+    h *= prime64_2;
+    h ^= h >> 29;
+    h *= prime64_3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+quint64 contentHash(const QByteArray &bytes, quint64 seed)
+{
+    return contentHash(bytes.constData(), bytes.size(), seed);
+}
+
+quint64 hash(const QVariantMap &data)
+{
+    quint64 hash = 0;
+
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it)
+        hash ^= hashFormat( it.key(), it.value().toByteArray() );
+
     return hash;
 }
 
+quint64 hashFormat(const QString &mime, const QByteArray &bytes)
+{
+    // Skip some special data.
+    if (mime == mimeWindowTitle || mime == mimeOwner || mime == mimeClipboardMode)
+        return 0;
+
+    const auto mimeData = reinterpret_cast<const char *>( mime.constData() );
+    const quint64 mimeHash = contentHash( mimeData, mime.size() * static_cast<int>(sizeof(QChar)) );
+    return contentHash(bytes, mimeHash);
+}
+
 QString quoteString(const QString &str)
 {
     return QLocale().quoteString(str);
@@ -63,6 +185,119 @@ QString escapeHtml(const QString &str)
     return escapeHtmlSpaces(str.toHtmlEscaped());
 }
 
+bool splitWordsPattern(const QString &pattern, QStringList *words)
+{
+    QString word;
+
+    for ( int i = 0; i < pattern.size(); ++i ) {
+        const QChar c = pattern[i];
+        if (c == '\\') {
+            ++i;
+            if ( i == pattern.size() || pattern[i].isLetterOrNumber() )
+                return false;
+            word.append(pattern[i]);
+        } else if (c == '.') {
+            ++i;
+            if ( i == pattern.size() || pattern[i] != '*' )
+                return false;
+            if (words && !word.isEmpty())
+                words->append(word);
+            word.clear();
+        } else if ( QString("$()*+?[]^{}|").contains(c) ) {
+            return false;
+        } else {
+            word.append(c);
+        }
+    }
+
+    if (words && !word.isEmpty())
+        words->append(word);
+
+    return true;
+}
+
+bool matchesFilter(const QRegExp &re, const QString &text)
+{
+    const QString pattern = re.pattern();
+    const auto cs = re.caseSensitivity();
+
+    if (re.patternSyntax() == QRegExp::FixedString)
+        return text.contains(pattern, cs);
+
+    if (re.patternSyntax() != QRegExp::RegExp && re.patternSyntax() != QRegExp::RegExp2)
+        return re.indexIn(text) != -1;
+
+    const FilterWords &words = filterWords(pattern);
+    if (!words.isWordsPattern)
+        return re.indexIn(text) != -1;
+
+    // Find words in order, each after the previous one.
+    int i = 0;
+    for (const auto &word : words.words) {
+        i = text.indexOf(word, i, cs);
+        if (i == -1)
+            return false;
+        i += word.size();
+    }
+
+    return true;
+}
+
+int fuzzyMatchScore(const QString &pattern, const QString &text, Qt::CaseSensitivity cs)
+{
+    const auto fold = [cs](QChar c) {
+        return cs == Qt::CaseInsensitive ? c.toCaseFolded() : c;
+    };
+
+    QString needle;
+    needle.reserve( pattern.size() );
+    for (const auto &c : pattern) {
+        if ( !c.isSpace() )
+            needle.append( fold(c) );
+    }
+
+    if ( needle.isEmpty() )
+        return 0;
+
+    // Find end of the first match.
+    int end = 0;
+    for (int i = 0; end < text.size(); ++end) {
+        if ( fold(text[end]) == needle[i] && ++i == needle.size() )
+            break;
+    }
+
+    if ( end == text.size() )
+        return -1;
+
+    // Find the shortest match ending there.
+    int start = end;
+    for (int i = needle.size() - 1; ; --start) {
+        if ( fold(text[start]) == needle[i] && --i < 0 )
+            break;
+    }
+
+    // Score characters matched greedily from the start of the shortest match.
+    int score = 0;
+    int last = -2;
+    for (int i = 0, j = start; i < needle.size(); ++j) {
+        if ( fold(text[j]) != needle[i] )
+            continue;
+
+        score += 16;
+        if (last == j - 1)
+            score += 8;
+        else if (last >= 0)
+            score -= j - last - 1;
+        if ( j == 0 || !text[j - 1].isLetterOrNumber() )
+            score += 8;
+
+        last = j;
+        ++i;
+    }
+
+    return qMax(0, score - qMin(start, 16) / 4);
+}
+
 QString getTextData(const QByteArray &bytes)
 {
     // QString::fromUtf8(bytes) ends string at first '\0'.
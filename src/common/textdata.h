@@ -23,9 +23,55 @@
 #include <QVariantMap>
 
 class QByteArray;
+class QRegExp;
 class QString;
+class QStringList;
 
-uint hash(const QVariantMap &data);
+/**
+ * Return fast non-cryptographic 64-bit hash of data (xxHash64 algorithm).
+ */
+quint64 contentHash(const char *data, int size, quint64 seed = 0);
+
+quint64 contentHash(const QByteArray &bytes, quint64 seed = 0);
+
+/** Return hash identifying item data (combines hashes of formats). */
+quint64 hash(const QVariantMap &data);
+
+/**
+ * Return hash of single item format.
+ *
+ * Item hash is combination of hashes of all its formats (see hash()),
+ * so changing single format requires only rehashing the format.
+ */
+quint64 hashFormat(const QString &mime, const QByteArray &bytes);
+
+/**
+ * Split regular expression to literal words if it contains only literal
+ * characters and ".*" (as created by filter from words).
+ *
+ * @return false if the pattern contains any other special characters
+ */
+bool splitWordsPattern(const QString &pattern, QStringList *words = nullptr);
+
+/**
+ * Return true if @a text matches filter expression.
+ *
+ * Fixed strings and words joined with ".*" are searched for directly
+ * which is much faster than using the regular expression engine.
+ * Words are split from the pattern only when it changes.
+ */
+bool matchesFilter(const QRegExp &re, const QString &text);
+
+/**
+ * Return score of fuzzy match of @a pattern in @a text.
+ *
+ * All characters of pattern (except white space) must be found in text
+ * in the same order. Consecutive characters and characters at the beginning
+ * of words get higher score, gaps between matched characters lower it.
+ *
+ * @return -1 if text doesn't match
+ */
+int fuzzyMatchScore(const QString &pattern, const QString &text, Qt::CaseSensitivity cs);
 
 QString quoteString(const QString &str);
 
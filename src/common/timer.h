@@ -3,11 +3,16 @@
 
 #include <QTimer>
 
+/// Timers with at least this interval can be delayed to coalesce wakeups.
+constexpr int veryCoarseTimerMinIntervalMs = 5000;
+
 template <typename Receiver, typename Slot>
 void initSingleShotTimer(QTimer *timer, int milliseconds, const Receiver *receiver, Slot slot)
 {
     timer->setSingleShot(true);
     timer->setInterval(milliseconds);
+    timer->setTimerType(
+        milliseconds >= veryCoarseTimerMinIntervalMs ? Qt::VeryCoarseTimer : Qt::CoarseTimer);
 
     Q_ASSERT(receiver);
     if (receiver)
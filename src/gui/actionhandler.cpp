@@ -25,7 +25,9 @@
 #include "common/contenttype.h"
 #include "common/display.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
+#include "common/persistentprocess.h"
 #include "common/textdata.h"
 #include "gui/icons.h"
 #include "gui/notification.h"
@@ -41,6 +43,9 @@
 
 namespace {
 
+/// Maximum number of background actions waiting in queue.
+const int maxQueuedActions = 100;
+
 QString actionDescription(const Action &action)
 {
     const auto name = action.name();
@@ -76,6 +81,12 @@ QVariantMap ActionHandler::actionData(int id) const
     return action ? action->data() : QVariantMap();
 }
 
+QString ActionHandler::actionName(int id) const
+{
+    const auto action = m_actions.value(id);
+    return action ? action->name() : QString();
+}
+
 void ActionHandler::setActionData(int id, const QVariantMap &data)
 {
     const auto action = m_actions.value(id);
@@ -95,6 +106,37 @@ bool ActionHandler::isInternalActionId(int id) const
     return m_internalActions.contains(id);
 }
 
+void ActionHandler::queueInternalAction(Action *action)
+{
+    const QueuedAction queuedAction{action, hash(action->data())};
+    for (const auto &otherAction : m_queuedActions) {
+        if ( otherAction.dataHash == queuedAction.dataHash
+             && otherAction.action->commandLine() == action->commandLine() )
+        {
+            COPYQ_LOG( QString("Skipping already queued: %1").arg(actionDescription(*action)) );
+            action->deleteLater();
+            return;
+        }
+    }
+
+    if ( m_queuedActions.size() >= maxQueuedActions ) {
+        log( QString("Skipping, too many queued actions: %1").arg(actionDescription(*action)), LogWarning );
+        action->deleteLater();
+        return;
+    }
+
+    action->setParent(this);
+    m_queuedActions.append(queuedAction);
+    m_activeActionDialog->actionQueued(action);
+    startQueuedActions();
+}
+
+void ActionHandler::setMaxBackgroundActions(int count)
+{
+    m_maxBackgroundActions = count;
+    startQueuedActions();
+}
+
 void ActionHandler::action(Action *action)
 {
     action->setParent(this);
@@ -110,7 +152,52 @@ void ActionHandler::action(Action *action)
 
     m_activeActionDialog->actionAboutToStart(action);
     COPYQ_LOG( QString("Executing: %1").arg(actionDescription(*action)) );
-    action->start();
+
+    // Run scripts in the server instead of starting new client process.
+    if ( ScriptableWorker::canRunAction(*action) ) {
+        auto worker = new ScriptableWorker(m_wnd, action);
+        worker->start();
+    } else {
+        action->start();
+    }
+}
+
+PersistentProcess *ActionHandler::persistentProcess(const QString &commandLine, QString *error)
+{
+    auto process = m_persistentProcesses.value(commandLine);
+    if (!process) {
+        Action action;
+        action.setCommand(commandLine);
+        const auto &cmds = action.command();
+        if ( cmds.size() != 1 || cmds[0].size() != 1 ) {
+            *error = "Only single program without pipes can be kept running";
+            return nullptr;
+        }
+
+        const QStringList &arguments = cmds[0][0];
+        if ( arguments.value(0) == "copyq" ) {
+            *error = "CopyQ commands cannot be kept running";
+            return nullptr;
+        }
+
+        process = new PersistentProcess(arguments, this);
+        m_persistentProcesses.insert(commandLine, process);
+    }
+
+    return process;
+}
+
+void ActionHandler::setPersistentCommands(const QStringList &commandLines)
+{
+    for (auto it = m_persistentProcesses.begin(); it != m_persistentProcesses.end(); ) {
+        if ( commandLines.contains(it.key()) ) {
+            ++it;
+        } else {
+            // Queued items fail and the program is stopped.
+            it.value()->deleteLater();
+            it = m_persistentProcesses.erase(it);
+        }
+    }
 }
 
 void ActionHandler::actionStarted(Action *action)
@@ -123,6 +210,8 @@ void ActionHandler::closeAction(Action *action)
 {
     m_actions.remove(action->id());
     m_internalActions.remove(action->id());
+    if ( m_backgroundActions.remove(action->id()) )
+        startQueuedActions();
 
     if ( action->actionFailed() ) {
         const auto msg = tr("Error: %1").arg(action->errorString());
@@ -139,6 +228,19 @@ void ActionHandler::closeAction(Action *action)
         showActionErrors(action, msg, IconTimesCircle);
     }
 
+    COPYQ_LOG( QString("Finished in %1 ms (started in %2 ms, input %3 B, output %4 B): %5")
+               .arg(action->elapsedMs())
+               .arg(action->startLatencyMs())
+               .arg(action->bytesWritten())
+               .arg(action->bytesRead())
+               .arg(actionDescription(*action)) );
+
+    countMetric("actions_finished");
+    if ( action->actionFailed() || action->exitCode() != 0 )
+        countMetric("actions_failed");
+    if ( action->elapsedMs() >= 0 )
+        addMetricDuration( "action", action->elapsedMs() * 1000 );
+
     m_activeActionDialog->actionFinished(action);
     Q_ASSERT(runningActionCount() >= 0);
 
@@ -147,6 +249,16 @@ void ActionHandler::closeAction(Action *action)
     action->deleteLater();
 }
 
+void ActionHandler::startQueuedActions()
+{
+    while ( !m_queuedActions.isEmpty() && m_backgroundActions.size() < m_maxBackgroundActions ) {
+        const auto action = m_queuedActions.takeFirst().action;
+        internalAction(action);
+        if ( m_actions.contains(action->id()) )
+            m_backgroundActions.insert(action->id());
+    }
+}
+
 void ActionHandler::showActionErrors(Action *action, const QString &message, ushort icon)
 {
     const auto notificationId = qHash(action->commandLine()) ^ qHash(message);
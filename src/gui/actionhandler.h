@@ -23,6 +23,7 @@
 #include "common/command.h"
 
 #include <QDateTime>
+#include <QList>
 #include <QMenu>
 #include <QObject>
 #include <QPointer>
@@ -31,6 +32,7 @@
 
 class Action;
 class ActionDialog;
+class PersistentProcess;
 class ProcessManagerDialog;
 class QDialog;
 class MainWindow;
@@ -53,14 +55,38 @@ public:
     void addFinishedAction(const QString &name);
 
     QVariantMap actionData(int id) const;
+    QString actionName(int id) const;
     void setActionData(int id, const QVariantMap &data);
 
     void internalAction(Action *action);
     bool isInternalActionId(int id) const;
 
+    /**
+     * Execute internal action triggered in background (e.g. on clipboard change).
+     *
+     * Only limited number of these actions run at a time, others wait in queue
+     * (listed in process manager). Action with same command and data as
+     * already queued one is dropped, as well as any action if queue is full.
+     */
+    void queueInternalAction(Action *action);
+
+    void setMaxBackgroundActions(int count);
+
     /** Execute action. */
     void action(Action *action);
 
+    /**
+     * Return program of a command which is kept running (see Command::persistent).
+     *
+     * The program is started when it gets first item.
+     *
+     * @return nullptr if the command cannot be kept running (details in @a error)
+     */
+    PersistentProcess *persistentProcess(const QString &commandLine, QString *error);
+
+    /// Stop programs of commands which are no longer kept running.
+    void setPersistentCommands(const QStringList &commandLines);
+
 signals:
     /** Emitted new action starts or ends. */
     void runningActionsCountChanged();
@@ -74,11 +100,22 @@ private:
 
     void showActionErrors(Action *action, const QString &message, ushort icon);
 
+    void startQueuedActions();
+
     MainWindow *m_wnd;
     ProcessManagerDialog *m_activeActionDialog;
     QHash<int, Action*> m_actions;
     QSet<int> m_internalActions;
+    struct QueuedAction {
+        Action *action;
+        /// Hash of action data, to skip same actions without comparing data.
+        quint64 dataHash;
+    };
+    QList<QueuedAction> m_queuedActions;
+    QSet<int> m_backgroundActions;
+    int m_maxBackgroundActions = 1;
     int m_lastActionId = -1;
+    QHash<QString, PersistentProcess*> m_persistentProcesses;
 };
 
 #endif // ACTIONHANDLER_H
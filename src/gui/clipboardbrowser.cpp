@@ -22,6 +22,7 @@
 #include "common/common.h"
 #include "common/contenttype.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
 #include "common/temporaryfile.h"
 #include "common/textdata.h"
@@ -38,7 +39,9 @@
 #include "item/persistentdisplayitem.h"
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDrag>
+#include <QFontMetrics>
 #include <QKeyEvent>
 #include <QMimeData>
 #include <QPushButton>
@@ -60,6 +63,24 @@
 
 namespace {
 
+/// Property of dragged mime data with items as serialized data where possible.
+const char propertyDraggedItems[] = "CopyQ_dragged_items";
+
+/// Number of items laid out at once when a tab is loaded (rest is laid out from event loop).
+const int layoutBatchSize = 100;
+
+/// Items in bigger tabs are matched in background when filtering.
+const int minItemsToFilterInBackground = 2000;
+
+/// Widgets of items farther from viewport (in viewport heights) are removed.
+const int keepItemWidgetsInViewports = 2;
+
+/// Maximum time for creating item widgets in a batch when prefetching items.
+const int prefetchBatchMilliseconds = 10;
+
+/// Delay for saving updated text index after items are saved (index is saved whole).
+const int saveTextIndexDelayMsec = 5 * 60 * 1000;
+
 enum class MoveType {
     Absolute,
     Relative
@@ -149,18 +170,6 @@ private:
     QString m_filePath;
 };
 
-bool alphaSort(const QModelIndex &lhs, const QModelIndex &rhs)
-{
-    const QString lhsText = lhs.data(contentType::text).toString();
-    const QString rhsText = rhs.data(contentType::text).toString();
-    return lhsText.localeAwareCompare(rhsText) < 0;
-}
-
-bool reverseSort(const QModelIndex &lhs, const QModelIndex &rhs)
-{
-    return lhs.row() > rhs.row();
-}
-
 QModelIndex indexNear(const QListView *view, int offset)
 {
     const int s = view->spacing();
@@ -183,6 +192,108 @@ void appendTextData(const QVariantMap &data, const QString &mime, QByteArray *li
     lines->append(text.toUtf8());
 }
 
+/**
+ * Drag'n'drop data for multiple items.
+ *
+ * Serializing items and concatenating their texts is postponed until
+ * a drop target actually requests the format.
+ */
+class ItemsMimeData final : public QMimeData {
+public:
+    explicit ItemsMimeData(const QVector<QVariantMap> &items)
+        : m_items(items)
+    {
+        QSet<QString> usedFormats;
+        for (const auto &itemData : m_items) {
+            for (auto it = itemData.constBegin(); it != itemData.constEnd(); ++it) {
+                const auto &format = it.key();
+                if ( usedFormats.contains(format) ) {
+                    if ( format.startsWith(COPYQ_MIME_PREFIX) )
+                        m_data[format].clear();
+                    else
+                        m_data.remove(format);
+                } else {
+                    m_data[format] = it.value();
+                    usedFormats.insert(format);
+                }
+            }
+
+            m_hasText = m_hasText || !itemData.value(mimeText).toByteArray().isEmpty();
+            m_hasUriList = m_hasUriList || !itemData.value(mimeUriList).toByteArray().isEmpty();
+        }
+
+        m_data.remove(mimeText);
+        m_data.remove(mimeUriList);
+        m_data.remove(mimeClipboardMode);
+        if (m_hasText)
+            m_data.remove(mimeHtml);
+
+        if ( !m_data.contains(mimeOwner) )
+            setData( mimeOwner, makeClipboardOwnerData() );
+    }
+
+    QStringList formats() const override
+    {
+        QStringList result = QMimeData::formats();
+        result.append( m_data.keys() );
+        result.append(mimeItems);
+        if (m_hasText)
+            result.append(mimeText);
+        if (m_hasUriList && !result.contains(mimeUriList))
+            result.append(mimeUriList);
+        for (const auto &format : m_data.keys()) {
+            if ( format.startsWith("image/") ) {
+                result.append("application/x-qt-image");
+                break;
+            }
+        }
+        return result;
+    }
+
+protected:
+    QVariant retrieveData(const QString &mime, QVariant::Type type) const override
+    {
+        if ( QMimeData::formats().contains(mime) )
+            return QMimeData::retrieveData(mime, type);
+
+        if ( m_data.contains(mime) )
+            return m_data[mime];
+
+        auto it = m_cache.constFind(mime);
+        if ( it != m_cache.constEnd() )
+            return it.value();
+
+        QVariant value;
+        if (mime == mimeItems) {
+            QByteArray bytes;
+            QDataStream stream(&bytes, QIODevice::WriteOnly);
+            for (const auto &itemData : m_items)
+                stream << itemData;
+            value = bytes;
+        } else if ( (mime == mimeText && m_hasText) || (mime == mimeUriList && m_hasUriList) ) {
+            QByteArray lines;
+            for (const auto &itemData : m_items)
+                appendTextData(itemData, mime, &lines);
+            value = lines;
+        } else if (mime == "application/x-qt-image") {
+            const std::unique_ptr<QMimeData> imageData( createMimeData(m_data) );
+            value = imageData->imageData();
+        } else {
+            return QVariant();
+        }
+
+        m_cache.insert(mime, value);
+        return value;
+    }
+
+private:
+    QVector<QVariantMap> m_items;
+    QVariantMap m_data;
+    mutable QVariantMap m_cache;
+    bool m_hasText = false;
+    bool m_hasUriList = false;
+};
+
 
 QList<QPersistentModelIndex> toPersistentModelIndexList(const QList<QModelIndex> &indexes)
 {
@@ -197,40 +308,24 @@ QList<QPersistentModelIndex> toPersistentModelIndexList(const QList<QModelIndex>
     return result;
 }
 
-int removeIndexes(const QModelIndexList &indexes, QAbstractItemModel *model)
+int removeIndexes(const QModelIndexList &indexes, ClipboardModel *model)
 {
-    auto toRemove = toPersistentModelIndexList(indexes);
-    std::sort( std::begin(toRemove), std::end(toRemove) );
-
-    const auto first = toRemove.value(0).row();
-
-    // Remove ranges of rows instead of a single rows.
-    for (auto it1 = std::begin(toRemove); it1 != std::end(toRemove); ) {
-        if ( it1->isValid() ) {
-            const auto firstRow = it1->row();
-            auto rowCount = 0;
-
-            for ( ++it1, ++rowCount; it1 != std::end(toRemove)
-                  && it1->isValid()
-                  && it1->row() == firstRow + rowCount; ++it1, ++rowCount ) {}
-
-            model->removeRows(firstRow, rowCount);
-        } else {
-            ++it1;
-        }
-    }
+    const RowRanges ranges = toRowRanges(indexes);
+    if ( ranges.isEmpty() )
+        return -1;
 
-    return first;
+    model->removeRowRanges(ranges);
+    return ranges.first().row;
 }
 
-void moveIndexes(QList<QPersistentModelIndex> &indexesToMove, int targetRow, ClipboardModel *model, MoveType moveType)
+void moveIndexes(const QModelIndexList &indexesToMove, int targetRow, ClipboardModel *model, MoveType moveType)
 {
-    if ( indexesToMove.isEmpty() )
+    const RowRanges ranges = toRowRanges(indexesToMove);
+    if ( ranges.isEmpty() )
         return;
 
-    const auto minMaxPair = std::minmax_element( std::begin(indexesToMove), std::end(indexesToMove) );
-    const auto start = minMaxPair.first->row();
-    const auto end = minMaxPair.second->row();
+    const auto start = ranges.first().row;
+    const auto end = ranges.last().row + ranges.last().count - 1;
 
     if (moveType == MoveType::Relative) {
         if (targetRow < 0 && start == 0)
@@ -243,37 +338,7 @@ void moveIndexes(QList<QPersistentModelIndex> &indexesToMove, int targetRow, Cli
             targetRow += end + 1;
     }
 
-    if (start < targetRow)
-        std::sort( std::begin(indexesToMove), std::end(indexesToMove) );
-    else if (targetRow < end)
-        std::sort( std::begin(indexesToMove), std::end(indexesToMove), std::not2(std::less<QModelIndex>()) );
-    else
-        return;
-
-    // Move ranges of rows instead of a single rows.
-    for (auto it = std::begin(indexesToMove); it != std::end(indexesToMove); ) {
-        if ( it->isValid() ) {
-            const auto row = it->row();
-            auto rowCount = 0;
-
-            for ( ++it, ++rowCount; it != std::end(indexesToMove)
-                  && it->isValid()
-                  && std::abs(it->row() - row) == rowCount; ++it, ++rowCount ) {}
-
-            if (row < targetRow)
-                model->moveRows(QModelIndex(), row, rowCount, QModelIndex(), targetRow);
-            else
-                model->moveRows(QModelIndex(), row - rowCount + 1, rowCount, QModelIndex(), targetRow);
-        } else {
-            ++it;
-        }
-    }
-}
-
-void moveIndexes(const QModelIndexList &indexesToMove, int targetRow, ClipboardModel *model, MoveType moveType)
-{
-    auto indexesToMove2 = toPersistentModelIndexList(indexesToMove);
-    moveIndexes(indexesToMove2, targetRow, model, moveType);
+    model->moveRowRanges(ranges, targetRow);
 }
 
 } // namespace
@@ -287,6 +352,10 @@ ClipboardBrowser::ClipboardBrowser(
     , m_tabName(tabName)
     , m(this)
     , d(this, sharedData)
+    , m_journal(&m)
+    , m_textIndex(&m)
+    , m_backgroundSaver(this)
+    , m_backgroundFilter(this)
     , m_editor(nullptr)
     , m_sharedData(sharedData)
     , m_dragTargetRow(-1)
@@ -294,8 +363,7 @@ ClipboardBrowser::ClipboardBrowser(
 {
     setObjectName("ClipboardBrowser");
 
-    setLayoutMode(QListView::Batched);
-    setBatchSize(1);
+    setBatchSize(layoutBatchSize);
     setFrameShape(QFrame::NoFrame);
     setTabKeyNavigation(false);
     setSelectionMode(QAbstractItemView::ExtendedSelection);
@@ -305,9 +373,14 @@ ClipboardBrowser::ClipboardBrowser(
     setAlternatingRowColors(true);
 
     initSingleShotTimer( &m_timerSave, 30000, this, &ClipboardBrowser::saveItems );
+    initSingleShotTimer( &m_timerSaveTextIndex, saveTextIndexDelayMsec, this, &ClipboardBrowser::saveTextIndex );
+    connect( &m_backgroundSaver, &ItemBackgroundSaver::finished,
+             this, &ClipboardBrowser::onBackgroundSaveFinished );
     initSingleShotTimer( &m_timerEmitItemCount, 0, this, &ClipboardBrowser::emitItemCount );
     initSingleShotTimer( &m_timerUpdateSizes, 0, this, &ClipboardBrowser::updateSizes );
     initSingleShotTimer( &m_timerUpdateCurrent, 0, this, &ClipboardBrowser::updateCurrent );
+    initSingleShotTimer( &m_timerFinishBatchedLayout, 0, this, &ClipboardBrowser::finishBatchedLayout );
+    initSingleShotTimer( &m_timerPrefetch, 0, this, &ClipboardBrowser::prefetchItems );
 
     m_timerDragDropScroll.setInterval(20);
     connect( &m_timerDragDropScroll, &QTimer::timeout,
@@ -316,6 +389,9 @@ ClipboardBrowser::ClipboardBrowser(
     // ScrollPerItem doesn't work well with hidden items
     setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
 
+    connect( verticalScrollBar(), &QScrollBar::valueChanged,
+             this, &ClipboardBrowser::onScrolled );
+
     setAttribute(Qt::WA_MacShowFocusRect, false);
 
     setAcceptDrops(true);
@@ -332,12 +408,13 @@ ClipboardBrowser::~ClipboardBrowser()
     saveUnsavedItems();
 }
 
-bool ClipboardBrowser::moveToTop(uint itemHash)
+bool ClipboardBrowser::moveToTop(quint64 itemHash)
 {
     const int row = m.findItem(itemHash);
     if (row < 0)
         return false;
 
+    m.setData( index(row), QDateTime::currentMSecsSinceEpoch(), contentType::lastUsedTime );
     moveToTop( index(row) );
     return true;
 }
@@ -397,7 +474,19 @@ QVariantMap ClipboardBrowser::itemData(const QModelIndex &index) const
 bool ClipboardBrowser::hideFiltered(int row)
 {
     const bool hide = isFiltered(row);
+    setRowFiltered(row, hide);
+    return hide;
+}
+
+bool ClipboardBrowser::hideFiltered(const QModelIndex &index)
+{
+    return hideFiltered(index.row());
+}
+
+void ClipboardBrowser::setRowFiltered(int row, bool hide)
+{
     setRowHidden(row, hide);
+    invalidateVisibleRows();
 
     auto w = d.cacheOrNull(row);
     if (w) {
@@ -406,13 +495,78 @@ bool ClipboardBrowser::hideFiltered(int row)
         else
             d.highlightMatches(w);
     }
+}
 
-    return hide;
+bool ClipboardBrowser::filterCandidateRows(const QRegExp &re, QVector<int> *rows)
+{
+    if ( !ItemTextIndex::canFindCandidates(re) )
+        return false;
+
+    if ( !m_textIndex.isBuilt() ) {
+        if ( !m_tabName.isEmpty() )
+            loadItemTextIndex(m_tabName, &m_textIndex);
+        m_textIndex.build();
+    }
+
+    return m_textIndex.candidateRows(re, rows);
 }
 
-bool ClipboardBrowser::hideFiltered(const QModelIndex &index)
+QVector<int> ClipboardBrowser::searchCandidateRows(const QRegExp &re)
 {
-    return hideFiltered(index.row());
+    QVector<int> rows;
+    if ( !filterCandidateRows(re, &rows) ) {
+        rows.clear();
+        rows.reserve( length() );
+        for (int row = 0; row < length(); ++row)
+            rows.append(row);
+    }
+    return rows;
+}
+
+void ClipboardBrowser::startBackgroundFilter(const QRegExp &re, const QVector<int> &rows, int currentRow)
+{
+    m_pendingCurrentRow = currentRow;
+    m_backgroundFilter.start(
+                re, m_sharedData->itemFactory->matchingLoaders(), rows, m.itemsSnapshot(rows) );
+}
+
+void ClipboardBrowser::restartBackgroundFilter()
+{
+    if ( !m_backgroundFilter.isRunning() )
+        return;
+
+    QVector<int> rows;
+    rows.reserve( length() );
+    for (int row = 0; row < length(); ++row)
+        rows.append(row);
+
+    startBackgroundFilter( d.searchExpression(), rows, m_pendingCurrentRow == -1 ? -1 : length() );
+}
+
+void ClipboardBrowser::onBackgroundFilterRowsMatched(const QVector<int> &rows, const QVector<bool> &matched)
+{
+    for (int i = 0; i < rows.size(); ++i) {
+        const int row = rows[i];
+        setRowFiltered(row, !matched[i]);
+        if ( matched[i] && row < m_pendingCurrentRow )
+            m_pendingCurrentRow = row;
+    }
+
+    // Select first visible row once all rows above it are matched.
+    if ( m_pendingCurrentRow != -1 && rows.last() >= m_pendingCurrentRow ) {
+        setCurrent(m_pendingCurrentRow);
+        m_pendingCurrentRow = -1;
+    }
+}
+
+void ClipboardBrowser::onBackgroundFilterFinished()
+{
+    addFilterMetric();
+
+    if (m_pendingCurrentRow != -1) {
+        setCurrent(m_pendingCurrentRow);
+        m_pendingCurrentRow = -1;
+    }
 }
 
 bool ClipboardBrowser::startEditor(QObject *editor, bool changeClipboard)
@@ -556,6 +710,18 @@ void ClipboardBrowser::connectModelAndDelegate()
     // delegate for rendering and editing items
     setItemDelegate(&d);
 
+    // Visible rows change with model (rows are filtered when inserted).
+    connect( &m, &QAbstractItemModel::rowsInserted,
+             this, &ClipboardBrowser::invalidateVisibleRows );
+    connect( &m, &QAbstractItemModel::rowsRemoved,
+             this, &ClipboardBrowser::invalidateVisibleRows );
+    connect( &m, &QAbstractItemModel::rowsMoved,
+             this, &ClipboardBrowser::invalidateVisibleRows );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             this, &ClipboardBrowser::invalidateVisibleRows );
+    connect( &m, &QAbstractItemModel::modelReset,
+             this, &ClipboardBrowser::invalidateVisibleRows );
+
     // Delegate receives model signals first to update internal item list.
     connect( &m, &QAbstractItemModel::rowsInserted,
              &d, &ItemDelegate::rowsInserted );
@@ -563,6 +729,16 @@ void ClipboardBrowser::connectModelAndDelegate()
              &d, &ItemDelegate::rowsRemoved );
     connect( &m, &QAbstractItemModel::rowsAboutToBeMoved,
              &d, &ItemDelegate::rowsMoved );
+    connect( &m, &QAbstractItemModel::rowsRemoved,
+             &d, &ItemDelegate::invalidateCachedRows );
+    connect( &m, &QAbstractItemModel::rowsMoved,
+             &d, &ItemDelegate::invalidateCachedRows );
+    connect( &m, &QAbstractItemModel::modelReset,
+             &d, &ItemDelegate::invalidateCachedRows );
+    connect( &m, &QAbstractItemModel::layoutAboutToBeChanged,
+             &d, &ItemDelegate::layoutAboutToBeChanged );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             &d, &ItemDelegate::layoutChanged );
     connect( &m, &QAbstractItemModel::dataChanged,
              &d, &ItemDelegate::dataChanged );
 
@@ -584,11 +760,32 @@ void ClipboardBrowser::connectModelAndDelegate()
              this, &ClipboardBrowser::delayedSaveItems );
     connect( &m, &QAbstractItemModel::rowsMoved,
              this, &ClipboardBrowser::delayedSaveItems );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             this, &ClipboardBrowser::delayedSaveItems );
     connect( &m, &QAbstractItemModel::dataChanged,
              this, &ClipboardBrowser::delayedSaveItems );
 
     connect( &d, &ItemDelegate::itemWidgetCreated,
              this, &ClipboardBrowser::itemWidgetCreated );
+
+    // Rows matched in background are outdated if model changes.
+    connect( &m, &QAbstractItemModel::rowsInserted,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+    connect( &m, &QAbstractItemModel::rowsRemoved,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+    connect( &m, &QAbstractItemModel::rowsMoved,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+    connect( &m, &QAbstractItemModel::layoutChanged,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+    connect( &m, &QAbstractItemModel::modelReset,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+    connect( &m, &QAbstractItemModel::dataChanged,
+             this, &ClipboardBrowser::restartBackgroundFilter );
+
+    connect( &m_backgroundFilter, &ItemBackgroundFilter::rowsMatched,
+             this, &ClipboardBrowser::onBackgroundFilterRowsMatched );
+    connect( &m_backgroundFilter, &ItemBackgroundFilter::finished,
+             this, &ClipboardBrowser::onBackgroundFilterFinished );
 }
 
 void ClipboardBrowser::updateItemMaximumSize()
@@ -624,30 +821,105 @@ void ClipboardBrowser::focusEditedIndex()
 
 int ClipboardBrowser::findNextVisibleRow(int row)
 {
-    while ( row < length() && isRowHidden(row) ) { ++row; }
-    return row < length() ? row : -1;
+    if ( row >= length() )
+        return -1;
+    if ( !isRowHidden(row) )
+        return row;
+
+    const auto &rows = visibleRows();
+    const auto it = std::lower_bound( std::begin(rows), std::end(rows), row );
+    return it == std::end(rows) ? -1 : *it;
 }
 
 int ClipboardBrowser::findPreviousVisibleRow(int row)
 {
-    while ( row >= 0 && isRowHidden(row) ) { --row; }
-    return row >= 0 ? row : -1;
+    if ( row < 0 )
+        return -1;
+    if ( !isRowHidden(row) )
+        return row;
+
+    const auto &rows = visibleRows();
+    const auto it = std::upper_bound( std::begin(rows), std::end(rows), row );
+    return it == std::begin(rows) ? -1 : *(it - 1);
+}
+
+int ClipboardBrowser::findVisibleRow(int row, int direction)
+{
+    return direction > 0 ? findNextVisibleRow(row) : findPreviousVisibleRow(row);
+}
+
+const QVector<int> &ClipboardBrowser::visibleRows()
+{
+    // Filtering changes visibility of all rows anyway, so the list is
+    // rebuilt at most once after each change and navigating among few
+    // matching items skips hidden rows quickly.
+    if (!m_visibleRowsValid) {
+        m_visibleRows.clear();
+        for (int row = 0; row < length(); ++row) {
+            if ( !isRowHidden(row) )
+                m_visibleRows.append(row);
+        }
+        m_visibleRowsValid = true;
+    }
+
+    return m_visibleRows;
 }
 
 void ClipboardBrowser::preload(int pixels, bool above, const QModelIndex &start)
 {
+    if ( !start.isValid() )
+        return;
+
     const int s = 2 * spacing();
     const int direction = above ? -1 : 1;
-    int row = start.row();
-    QModelIndex ind = index(row);
     int y = 0;
 
-    for ( ; ind.isValid() && y < pixels; ind = index(row) ) {
-        if ( !isRowHidden(row) ) {
+    for ( int row = findVisibleRow(start.row(), direction);
+          row != -1 && y < pixels; row = findVisibleRow(row + direction, direction) )
+    {
+        const QModelIndex ind = index(row);
+        d.cache(ind);
+        y += s + d.sizeHint(ind).height();
+    }
+}
+
+void ClipboardBrowser::onScrolled(int value)
+{
+    if (value != m_lastScrollValue)
+        m_scrollDirection = value > m_lastScrollValue ? 1 : -1;
+    m_lastScrollValue = value;
+    m_timerPrefetch.start();
+}
+
+void ClipboardBrowser::prefetchItems()
+{
+    if ( !isVisible() )
+        return;
+
+    const int h = viewport()->contentsRect().height();
+    const auto start = m_scrollDirection > 0 ? indexNear(h - 3 * spacing()) : indexNear(0);
+    if ( !start.isValid() )
+        return;
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    // Prefetch items for a viewport height in scrolling direction.
+    const int s = 2 * spacing();
+    int y = 0;
+    for ( int row = findVisibleRow(start.row() + m_scrollDirection, m_scrollDirection);
+          row != -1 && y < h; row = findVisibleRow(row + m_scrollDirection, m_scrollDirection) )
+    {
+        const auto ind = index(row);
+        if ( !d.hasCache(ind) ) {
+            if ( elapsed.elapsed() > prefetchBatchMilliseconds ) {
+                m_timerPrefetch.start();
+                return;
+            }
             d.cache(ind);
-            y += s + d.sizeHint(ind).height();
         }
-        row += direction;
+
+        y += s + d.sizeHint(ind).height();
     }
 }
 
@@ -830,13 +1102,50 @@ void ClipboardBrowser::paste(const QVariantMap &data, int destinationRow)
     saveItems();
 }
 
+bool ClipboardBrowser::pasteDraggedItems(const QMimeData &data, int destinationRow)
+{
+    const QVariantList items = data.property(propertyDraggedItems).toList();
+    if ( items.isEmpty() )
+        return false;
+
+    if ( !isLoaded() ) {
+        loadItems();
+        if ( !isLoaded() )
+            return true;
+    }
+
+    if ( !allocateSpaceForNewItems(items.size()) ) {
+        QMessageBox::information(
+                    this, tr("Cannot Add New Items"),
+                    tr("Tab is full. Failed to remove any items.") );
+        return true;
+    }
+
+    const int newRow = destinationRow < 0 ? m.rowCount() : qMin(destinationRow, m.rowCount());
+    m.insertItems(items, newRow);
+
+    saveItems();
+    return true;
+}
+
 QPixmap ClipboardBrowser::renderItemPreview(const QModelIndexList &indexes, int maxWidth, int maxHeight)
 {
-    int h = 0;
+    // Render only the visible items that fit the preview; off-screen items
+    // would render blank and measuring all of them makes drag start slow.
     const int s = spacing();
+    const QRect viewportRect = viewport()->rect();
+    QVector<QRect> itemRects;
+    int h = 0;
     for (const auto &index : indexes) {
-        if ( !isIndexHidden(index) )
-            h += visualRect(index).height() + s;
+        if ( isIndexHidden(index) )
+            continue;
+        const QRect itemRect = visualRect(index);
+        if ( !itemRect.intersects(viewportRect) )
+            continue;
+        itemRects.append(itemRect);
+        h += itemRect.height() + s;
+        if (h >= maxHeight)
+            break;
     }
 
     if (h == 0)
@@ -856,13 +1165,11 @@ QPixmap ClipboardBrowser::renderItemPreview(const QModelIndexList &indexes, int
 
     h = frameLineWidth;
     const QPoint pos = viewport()->pos();
-    for (const auto &index : indexes) {
-        if ( isIndexHidden(index) )
-            continue;
+    for (const auto &itemRect : itemRects) {
         const QPoint position(frameLineWidth, h);
-        const auto rect = visualRect(index).translated(pos).adjusted(-s, -s, 2 * s, 2 * s);
+        const auto rect = itemRect.translated(pos).adjusted(-s, -s, 2 * s, 2 * s);
         render(&p, position, rect);
-        h += visualRect(index).height() + s;
+        h += itemRect.height() + s;
         if ( h > height )
             break;
     }
@@ -880,12 +1187,27 @@ QPixmap ClipboardBrowser::renderItemPreview(const QModelIndexList &indexes, int
     p.setPen(pen);
     p.drawRect( rect.adjusted(x, x, -x, -x) );
 
+    // Show number of dragged items if not all are in the preview.
+    if ( indexes.size() > itemRects.size() ) {
+        const QString count = QString::number(indexes.size());
+        const QFontMetrics fm(p.font());
+        const int margin = fm.height() / 4;
+        const QSize badgeSize(fm.width(count) + 2 * margin, fm.height() + margin);
+        const QRect badgeRect(
+                    QPoint(width - badgeSize.width() - 2 * x, height - badgeSize.height() - 2 * x),
+                    badgeSize);
+        p.setPen(Qt::white);
+        p.setBrush(Qt::black);
+        p.drawRect(badgeRect);
+        p.drawText(badgeRect, Qt::AlignCenter, count);
+    }
+
     return pix;
 }
 
 void ClipboardBrowser::onDataChanged(const QModelIndex &, const QModelIndex &)
 {
-    emit itemsChanged(this);
+    emitItemsChanged();
 }
 
 void ClipboardBrowser::onRowsInserted(const QModelIndex &, int first, int last)
@@ -910,10 +1232,20 @@ void ClipboardBrowser::onRowsInserted(const QModelIndex &, int first, int last)
 
 void ClipboardBrowser::onItemCountChanged()
 {
-    if (!m_timerEmitItemCount.isActive())
+    if (m_transactionDepth > 0)
+        m_itemCountChangedInTransaction = true;
+    else if (!m_timerEmitItemCount.isActive())
         m_timerEmitItemCount.start();
 }
 
+void ClipboardBrowser::emitItemsChanged()
+{
+    if (m_transactionDepth > 0)
+        m_itemsChangedInTransaction = true;
+    else
+        emit itemsChanged(this);
+}
+
 void ClipboardBrowser::onEditorSave()
 {
     Q_ASSERT(!m_editor.isNull());
@@ -950,7 +1282,7 @@ void ClipboardBrowser::onEditorNeedsChangeClipboard(const QByteArray &bytes, con
 
 void ClipboardBrowser::contextMenuEvent(QContextMenuEvent *event)
 {
-    if ( isInternalEditorOpen() || selectedIndexes().isEmpty() )
+    if ( isInternalEditorOpen() || !selectionModel()->hasSelection() )
         return;
 
     QPoint pos = event->globalPos();
@@ -973,10 +1305,14 @@ void ClipboardBrowser::resizeEvent(QResizeEvent *event)
 
 void ClipboardBrowser::showEvent(QShowEvent *event)
 {
-    if ( m.rowCount() > 0 && !d.hasCache(index(0)) )
+    // Keep scroll position of previously shown browser with cached items.
+    if ( m.rowCount() > 0 && !d.hasCache(index(0)) && d.cachedItemCount() == 0 )
         scrollToTop();
 
     QListView::showEvent(event);
+
+    if (m_sizesOutdated)
+        updateSizes();
 }
 
 void ClipboardBrowser::currentChanged(const QModelIndex &current, const QModelIndex &previous)
@@ -993,10 +1329,18 @@ void ClipboardBrowser::selectionChanged(const QItemSelection &selected,
                                         const QItemSelection &deselected)
 {
     QListView::selectionChanged(selected, deselected);
-    for ( auto index : selected.indexes() )
-        d.setItemWidgetSelected(index, true);
-    for ( auto index : deselected.indexes() )
-        d.setItemWidgetSelected(index, false);
+
+    // Walk through ranges instead of creating list of indexes,
+    // selection can contain all items in large tabs.
+    for ( const auto &range : selected ) {
+        for ( int row = range.top(); row <= range.bottom(); ++row )
+            d.setItemWidgetSelected(row, true);
+    }
+    for ( const auto &range : deselected ) {
+        for ( int row = range.top(); row <= range.bottom(); ++row )
+            d.setItemWidgetSelected(row, false);
+    }
+
     emit itemSelectionChanged(this);
 }
 
@@ -1053,23 +1397,37 @@ void ClipboardBrowser::dropEvent(QDropEvent *event)
 
 void ClipboardBrowser::paintEvent(QPaintEvent *e)
 {
-    // Hide items outside viewport.
+    // Hide items outside viewport and remove widgets far from it
+    // (these are created again when needed).
+    const int h = viewport()->contentsRect().height();
+    const int maxDistance = keepItemWidgetsInViewports * h;
+    const auto current = currentIndex();
+    const auto hideItemWidget = [&](int row, int *distance) {
+        const auto ind = index(row);
+        if ( *distance <= maxDistance && !isRowHidden(row) )
+            *distance += d.sizeHint(ind).height() + 2 * spacing();
+
+        auto w = d.cacheOrNull(row);
+        if (!w)
+            return;
+
+        if (*distance > maxDistance && ind != current)
+            d.removeCache(ind);
+        else
+            w->widget()->hide();
+    };
+
     const auto firstVisibleIndex = indexNear(0);
     if ( firstVisibleIndex.isValid() ) {
-        for (int row = firstVisibleIndex.row() - 1; row >= 0; --row) {
-            auto w = d.cacheOrNull(row);
-            if (w)
-                w->widget()->hide();
-        }
+        int distance = 0;
+        for (int row = firstVisibleIndex.row() - 1; row >= 0; --row)
+            hideItemWidget(row, &distance);
     }
-    const int h = viewport()->contentsRect().height();
     const auto lastVisibleIndex = indexNear(h - 3 * spacing());
     if ( lastVisibleIndex.isValid() ) {
-        for (int row = lastVisibleIndex.row() + 1; row < m.rowCount(); ++row) {
-            auto w = d.cacheOrNull(row);
-            if (w)
-                w->widget()->hide();
-        }
+        int distance = 0;
+        for (int row = lastVisibleIndex.row() + 1; row < m.rowCount(); ++row)
+            hideItemWidget(row, &distance);
     }
 
     const bool canUpdate = updatesEnabled();
@@ -1151,10 +1509,28 @@ void ClipboardBrowser::mouseMoveEvent(QMouseEvent *event)
         selected.append(targetIndex);
     }
 
-    QVariantMap data = copyIndexes(selected);
+    QMimeData *mimeData;
+    if (selected.size() == 1) {
+        mimeData = createMimeData( copyIndex(selected.first()) );
+    } else {
+        QVector<QVariantMap> items;
+        items.reserve( selected.size() );
+        for (const auto &index : selected)
+            items.append( copyIndex(index) );
+        mimeData = new ItemsMimeData(items);
+    }
+
+    // Items dropped to other tabs are inserted without decoding or copying data.
+    QVariantList draggedItems;
+    draggedItems.reserve( selected.size() );
+    for (const auto &index : selected) {
+        const QVariant serializedData = index.data(contentType::serializedData);
+        draggedItems.append( serializedData.isValid() ? serializedData : copyIndex(index) );
+    }
+    mimeData->setProperty(propertyDraggedItems, draggedItems);
 
     auto drag = new QDrag(this);
-    drag->setMimeData( createMimeData(data) );
+    drag->setMimeData(mimeData);
     drag->setPixmap( renderItemPreview(selected, 150, 150) );
 
     TemporaryDragAndDropImage *temporaryImage =
@@ -1179,7 +1555,7 @@ void ClipboardBrowser::mouseMoveEvent(QMouseEvent *event)
 
         // Move items only if target is this app.
         if (target == this || target == viewport()) {
-            moveIndexes(indexesToRemove, m_dragTargetRow, &m, MoveType::Absolute);
+            moveIndexes(selected, m_dragTargetRow, &m, MoveType::Absolute);
         } else if ( target && target->window() == window()
                     && m_itemSaver->canMoveItems(selected) )
         {
@@ -1224,9 +1600,10 @@ void ClipboardBrowser::doItemsLayout()
 
     QListView::doItemsLayout();
 
+    // With batched layout, the item may not be laid out yet.
     const auto rectAfter = visualRect(index);
     const auto offset = rectAfter.top() - rectBefore.top();
-    if (offset != 0) {
+    if (offset != 0 && rectAfter.isValid()) {
         QScrollBar *v = verticalScrollBar();
         v->setValue(v->value() + offset);
     }
@@ -1276,9 +1653,12 @@ bool ClipboardBrowser::openEditor(const QModelIndex &index)
 
 void ClipboardBrowser::addItems(const QStringList &items)
 {
-    for(int i=items.count()-1; i>=0; --i) {
-        add(items[i]);
-    }
+    QList<QVariantMap> dataList;
+    dataList.reserve( items.size() );
+    for (const auto &item : items)
+        dataList.append( createDataMap(mimeText, item) );
+
+    add(dataList);
 }
 
 void ClipboardBrowser::showItemContent()
@@ -1327,18 +1707,79 @@ void ClipboardBrowser::filterItems(const QRegExp &re)
     }
 
     // Do nothing if same regexp was already set or both are empty (don't compare regexp options).
-    if ( (d.searchExpression().isEmpty() && re.isEmpty()) || d.searchExpression() == re )
+    const QRegExp previousRe = d.searchExpression();
+    if ( (previousRe.isEmpty() && re.isEmpty()) || previousRe == re )
         return;
 
     d.setSearch(re);
+    m_filterTimer.start();
+
+    // Results of matching with previous expression are no longer needed,
+    // but hidden rows may not correspond to the previous expression then.
+    const bool previousFilterFinished = !m_backgroundFilter.isRunning();
+    m_backgroundFilter.cancel();
+    m_pendingCurrentRow = -1;
 
     // If search string is a number, highlight item in that row.
+    const int previousFilterRow = m_filterRow;
     bool filterByRowNumber = !m_sharedData->numberSearch;
     if (filterByRowNumber)
         m_filterRow = re.pattern().toInt(&filterByRowNumber);
     if (!filterByRowNumber)
         m_filterRow = -1;
 
+    // If the filter is only narrowed, hidden items stay hidden;
+    // if it's only widened, visible items stay visible.
+    const bool canFilterIncrementally = m_sharedData->itemFactory
+            && m_itemSaver && m_filterRow == -1 && previousFilterRow == -1
+            && previousFilterFinished;
+    const bool narrowed = canFilterIncrementally
+            && m_sharedData->itemFactory->isFilterNarrowed(previousRe, re);
+    const bool widened = canFilterIncrementally && !narrowed
+            && m_sharedData->itemFactory->isFilterNarrowed(re, previousRe);
+
+    // Items not found in text index are hidden without matching.
+    QVector<int> candidateRows;
+    const bool hasCandidateRows = m_sharedData->itemFactory && m_itemSaver
+            && !filterByRowNumber && !re.isEmpty() && filterCandidateRows(re, &candidateRows);
+    auto nextCandidateRow = candidateRows.constBegin();
+    const auto isCandidateRow = [&](int row) {
+        while ( nextCandidateRow != candidateRows.constEnd() && *nextCandidateRow < row )
+            ++nextCandidateRow;
+        return nextCandidateRow != candidateRows.constEnd() && *nextCandidateRow == row;
+    };
+
+    // Items in big tabs are matched in worker threads so typing is not blocked.
+    const bool matchInBackground = m_sharedData->itemFactory && !filterByRowNumber
+            && !re.isEmpty() && length() >= minItemsToFilterInBackground
+            && m_sharedData->itemFactory->canMatchInBackground();
+    QVector<int> rowsToMatch;
+
+    const auto updateFiltered = [&](int row) {
+        if ( narrowed && isRowHidden(row) )
+            return true;
+
+        if ( hasCandidateRows && !isCandidateRow(row) ) {
+            if ( !isRowHidden(row) )
+                setRowFiltered(row, true);
+            return true;
+        }
+
+        if ( widened && !isRowHidden(row) ) {
+            auto w = d.cacheOrNull(row);
+            if (w)
+                d.highlightMatches(w);
+            return false;
+        }
+
+        if (matchInBackground) {
+            rowsToMatch.append(row);
+            return true;
+        }
+
+        return hideFiltered(row);
+    };
+
     int row = 0;
 
     if ( re.isEmpty() ) {
@@ -1347,16 +1788,35 @@ void ClipboardBrowser::filterItems(const QRegExp &re)
 
         scrollTo(currentIndex(), PositionAtCenter);
     } else {
-        for ( ; row < length() && hideFiltered(row); ++row ) {}
+        for ( ; row < length() && updateFiltered(row); ++row ) {}
 
-        setCurrent(row);
+        // Wait for matching of rows above the first visible one.
+        const int firstVisibleRow = row;
+        const bool setCurrentLater = !rowsToMatch.isEmpty();
+        if (!setCurrentLater)
+            setCurrent(row);
 
         for ( ; row < length(); ++row )
-            hideFiltered(row);
+            updateFiltered(row);
+
+        if ( !rowsToMatch.isEmpty() )
+            startBackgroundFilter(re, rowsToMatch, setCurrentLater ? firstVisibleRow : -1);
 
         if ( filterByRowNumber && m_filterRow >= 0 && m_filterRow < m.rowCount() )
             setCurrent(m_filterRow);
     }
+
+    if ( !m_backgroundFilter.isRunning() )
+        addFilterMetric();
+}
+
+void ClipboardBrowser::addFilterMetric()
+{
+    if ( !m_filterTimer.isValid() )
+        return;
+
+    addMetricDuration( "filter", m_filterTimer.nsecsElapsed() / 1000 );
+    m_filterTimer.invalidate();
 }
 
 void ClipboardBrowser::moveToClipboard(const QModelIndex &ind)
@@ -1369,6 +1829,10 @@ void ClipboardBrowser::moveToClipboard(const QModelIndexList &indexes)
 {
     const auto data = copyIndexes(indexes);
 
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (const auto &index : indexes)
+        m.setData(index, now, contentType::lastUsedTime);
+
     if ( m_sharedData->moveItemOnReturnKey
          && m_itemSaver && m_itemSaver->canMoveItems(indexes) )
     {
@@ -1511,25 +1975,18 @@ void ClipboardBrowser::setCurrent(int row, bool keepSelection, bool setCurrentOn
     const int direction = cur <= row ? 1 : -1;
 
     // select first visible
-    int i = std::max(0, std::min(row, m.rowCount() - 1));
-    cur = i;
-    while ( 0 <= i && i < length() && isRowHidden(i) ) {
-        i = std::max(0, std::min(i + direction, m.rowCount() - 1));
-        if ( i == 0 || i == m.rowCount() - 1 || i == cur)
-            break;
-    }
-    if ( i < 0 || i >= length() || isRowHidden(i) )
+    const int i = findVisibleRow( std::max(0, std::min(row, m.rowCount() - 1)), direction );
+    if (i == -1)
         return;
 
     if (keepSelection) {
         auto sel = selectionModel();
         const bool currentSelected = sel->isSelected(prev);
-        for ( int j = prev.row(); j != i + direction; j += direction ) {
+        for ( int j = findVisibleRow(prev.row(), direction);
+              j != -1 && j * direction <= i * direction;
+              j = findVisibleRow(j + direction, direction) )
+        {
             const auto ind = index(j);
-            if ( !ind.isValid() )
-                break;
-            if ( isRowHidden(j) )
-                continue;
 
             if (!setCurrentOnly) {
                 if ( currentIndex() != ind && sel->isSelected(ind) && sel->isSelected(prev) )
@@ -1569,14 +2026,14 @@ void ClipboardBrowser::remove()
         setCurrent(currentRow);
 }
 
-void ClipboardBrowser::sortItems(const QModelIndexList &indexes)
+void ClipboardBrowser::sortItems(const QModelIndexList &indexes, ItemSortKey key)
 {
-    m.sortItems(indexes, &alphaSort);
+    m.sortItems(indexes, key);
 }
 
 void ClipboardBrowser::reverseItems(const QModelIndexList &indexes)
 {
-    m.sortItems(indexes, &reverseSort);
+    m.reverseItems(indexes);
 }
 
 bool ClipboardBrowser::allocateSpaceForNewItems(int newItemCount)
@@ -1588,6 +2045,16 @@ bool ClipboardBrowser::allocateSpaceForNewItems(int newItemCount)
 
     QModelIndexList indexesToRemove;
     QString error;
+
+    // Usually the last items can be removed, so check all of them at once first.
+    for (int row = m.rowCount() - toRemove; row < m.rowCount(); ++row)
+        indexesToRemove.append( m.index(row) );
+    if ( m_itemSaver->canRemoveItems(indexesToRemove, &error) ) {
+        dropIndexes(indexesToRemove);
+        return true;
+    }
+    indexesToRemove.clear();
+
     for (int row = m.rowCount() - 1; row >= 0 && indexesToRemove.size() < toRemove; --row) {
         const auto index = m.index(row);
         if ( m_itemSaver->canRemoveItems(QModelIndexList() << index, &error) )
@@ -1601,6 +2068,44 @@ bool ClipboardBrowser::allocateSpaceForNewItems(int newItemCount)
     return true;
 }
 
+int ClipboardBrowser::removeItemsUnusedSince(qint64 time, int maxCount)
+{
+    if ( !isLoaded() || !m_itemSaver )
+        return 0;
+
+    // Item times are available without decoding item data.
+    QModelIndexList indexesToRemove;
+    for (int row = m.rowCount() - 1; row >= 0; --row) {
+        const auto index = m.index(row);
+        if ( index.data(contentType::lastUsedTime).toLongLong() < time )
+            indexesToRemove.append(index);
+    }
+
+    if ( indexesToRemove.isEmpty() )
+        return 0;
+
+    // Usually none of the items is pinned, so check all of them at once first.
+    QString error;
+    if ( !m_itemSaver->canRemoveItems(indexesToRemove, &error) ) {
+        const auto cannotRemove = [&](const QModelIndex &index) {
+            return !m_itemSaver->canRemoveItems(QModelIndexList() << index, &error);
+        };
+        indexesToRemove.erase(
+            std::remove_if(std::begin(indexesToRemove), std::end(indexesToRemove), cannotRemove),
+            std::end(indexesToRemove) );
+    }
+
+    // Remove the oldest (bottom) items first if there are more.
+    if ( indexesToRemove.size() > maxCount )
+        indexesToRemove.erase( indexesToRemove.begin() + maxCount, indexesToRemove.end() );
+
+    if ( indexesToRemove.isEmpty() )
+        return 0;
+
+    dropIndexes(indexesToRemove);
+    return indexesToRemove.size();
+}
+
 bool ClipboardBrowser::add(const QString &txt, int row)
 {
     return add( createDataMap(mimeText, txt), row );
@@ -1631,32 +2136,67 @@ bool ClipboardBrowser::add(const QVariantMap &data, int row)
     return true;
 }
 
+bool ClipboardBrowser::add(const QList<QVariantMap> &dataList, int row)
+{
+    if ( dataList.isEmpty() )
+        return true;
+
+    if ( !isLoaded() ) {
+        loadItems();
+        if ( !isLoaded() )
+            return false;
+    }
+
+    // list size limit
+    if ( !allocateSpaceForNewItems(dataList.size()) ) {
+        QMessageBox::information(
+                    this, tr("Cannot Add New Items"),
+                    tr("Tab is full. Failed to remove any items.") );
+        return false;
+    }
+
+    const int newRow = row < 0 ? m.rowCount() : qMin(row, m.rowCount());
+    m.insertItems(dataList, newRow);
+
+    delayedSaveItems();
+
+    return true;
+}
+
 void ClipboardBrowser::addUnique(const QVariantMap &data, ClipboardMode mode)
 {
-    if ( moveToTop(hash(data)) ) {
+    addUnique( data, mode, hash(data) );
+}
+
+void ClipboardBrowser::addUnique(const QVariantMap &data, ClipboardMode mode, quint64 dataHash)
+{
+    countMetric("clipboard_changes");
+
+    if ( moveToTop(dataHash) ) {
         COPYQ_LOG("New item: Moving existing to top");
+        countMetric("clipboard_changes_existing");
         return;
     }
 
     // When selecting text under X11, clipboard data may change whenever selection changes.
     // Instead of adding item for each selection change, this updates previously added item.
     // Also update previous item if the same selected text is copied to clipboard afterwards.
-    if ( data.contains(mimeText) ) {
-        const auto firstIndex = firstUnpinnedIndex();
+    const auto firstIndex = data.contains(mimeText) ? firstUnpinnedIndex() : QModelIndex();
+    if ( firstIndex.isValid()
+         // Don't update edited item.
+         && (!isInternalEditorOpen() || currentIndex() != firstIndex) )
+    {
         const QVariantMap previousData = copyIndex(firstIndex);
 
-        if ( firstIndex.isValid()
-             && previousData.contains(mimeText)
-             // Don't update edited item.
-             && (!isInternalEditorOpen() || currentIndex() != firstIndex) )
-        {
+        if ( previousData.contains(mimeText) ) {
             const auto newText = getTextData(data);
             const auto oldText = getTextData(previousData);
             if ( (mode == ClipboardMode::Clipboard)
                  ? (newText == oldText)
-                 : getTextData(data).contains(getTextData(previousData)) )
+                 : newText.contains(oldText) )
             {
                 COPYQ_LOG("New item: Merging with top item");
+                countMetric("clipboard_changes_merged");
 
                 const QSet<QString> formatsToAdd = previousData.keys().toSet() - data.keys().toSet();
 
@@ -1673,7 +2213,8 @@ void ClipboardBrowser::addUnique(const QVariantMap &data, ClipboardMode mode)
 
     COPYQ_LOG("New item: Adding");
 
-    add(data);
+    if ( add(data) )
+        countMetric("clipboard_changes_stored");
 }
 
 bool ClipboardBrowser::loadItems()
@@ -1683,13 +2224,25 @@ bool ClipboardBrowser::loadItems()
 
     m_timerSave.stop();
 
+    MetricTimer metricTimer("tab_load");
     m.blockSignals(true);
     m_itemSaver = ::loadItems(m_tabName, m, m_sharedData->itemFactory, m_sharedData->maxItems);
     m.blockSignals(false);
 
+    m.setItemsInMemory(m_sharedData->itemsInMemory);
+    m.setMinItemBlobSize(m_sharedData->minItemBlobSize);
+
     if ( !isLoaded() )
         return false;
 
+    m_journal.reset();
+
+    // Show first page of items immediately and lay out the rest in batches.
+    if ( m.rowCount() > layoutBatchSize ) {
+        setLayoutMode(QListView::Batched);
+        m_timerFinishBatchedLayout.start();
+    }
+
     d.rowsInserted(QModelIndex(), 0, m.rowCount());
     if ( hasFocus() )
         setCurrent(0);
@@ -1705,7 +2258,37 @@ bool ClipboardBrowser::saveItems()
     if ( !isLoaded() || m_tabName.isEmpty() )
         return false;
 
-    return ::saveItems(m_tabName, m, m_itemSaver);
+    // Save the latest changes once the current background save finishes.
+    if ( m_backgroundSaver.isSaving() ) {
+        m_saveAgain = true;
+        return true;
+    }
+
+    m_saveAgain = false;
+
+    MetricTimer metricTimer("tab_save");
+    if ( !m_itemSaver->canSaveItemsToJournal() || !saveItemJournal(m_tabName, m_journal) ) {
+        if ( m_itemSaver->canSaveItemsInBackground() )
+            m_backgroundSaver.save(m_tabName, m, m_itemSaver);
+        else if ( !::saveItems(m_tabName, m, m_itemSaver) )
+            return false;
+    }
+
+    m_journal.reset();
+
+    // Keep saved index up to date so it's not rebuilt after crash.
+    if ( m_textIndex.isModified() && !m_timerSaveTextIndex.isActive() )
+        m_timerSaveTextIndex.start();
+
+    return true;
+}
+
+void ClipboardBrowser::saveTextIndex()
+{
+    m_timerSaveTextIndex.stop();
+
+    if ( isLoaded() && !m_tabName.isEmpty() )
+        saveItemTextIndex(m_tabName, &m_textIndex);
 }
 
 void ClipboardBrowser::moveToClipboard()
@@ -1721,11 +2304,16 @@ void ClipboardBrowser::delayedSaveItems()
     if ( !m_timerSave.isActive() )
         m_timerSave.start();
 
-    emit itemsChanged(this);
+    emitItemsChanged();
 }
 
 void ClipboardBrowser::updateSizes()
 {
+    // Resize item widgets in hidden browser only once it's shown.
+    m_sizesOutdated = !isVisible();
+    if (m_sizesOutdated)
+        return;
+
     updateItemMaximumSize();
     updateEditorGeometry();
 }
@@ -1742,10 +2330,67 @@ void ClipboardBrowser::updateCurrent()
         d.setItemWidgetCurrent(current, true);
 }
 
+void ClipboardBrowser::onBackgroundSaveFinished(bool saved)
+{
+    if (!saved) {
+        // Changes since last successful save are not in tab file or journal.
+        m_journal.invalidate();
+        m_saveAgain = false;
+        m_timerSave.start();
+    } else if (m_saveAgain) {
+        saveItems();
+    }
+}
+
+void ClipboardBrowser::waitForBackgroundSave()
+{
+    // Finishing a save can start saving newer changes.
+    while ( m_backgroundSaver.isSaving() )
+        m_backgroundSaver.waitForFinished();
+}
+
+void ClipboardBrowser::finishBatchedLayout()
+{
+    // Items are laid out only if the last one has valid geometry.
+    const int lastRow = m.rowCount() - 1;
+    if ( lastRow >= 0 && !rectForIndex(index(lastRow)).isValid() ) {
+        m_timerFinishBatchedLayout.start();
+        return;
+    }
+
+    // Later relayouts (e.g. after filtering or resizing) must keep position of current item.
+    setLayoutMode(QListView::SinglePass);
+}
+
 void ClipboardBrowser::saveUnsavedItems()
 {
     if ( m_timerSave.isActive() )
         saveItems();
+
+    waitForBackgroundSave();
+    saveTextIndex();
+}
+
+void ClipboardBrowser::beginTransaction()
+{
+    ++m_transactionDepth;
+}
+
+void ClipboardBrowser::commitTransaction()
+{
+    Q_ASSERT(m_transactionDepth > 0);
+    if (m_transactionDepth <= 0 || --m_transactionDepth > 0)
+        return;
+
+    if (m_itemCountChangedInTransaction) {
+        m_itemCountChangedInTransaction = false;
+        onItemCountChanged();
+    }
+
+    if (m_itemsChangedInTransaction) {
+        m_itemsChangedInTransaction = false;
+        emit itemsChanged(this);
+    }
 }
 
 void ClipboardBrowser::purgeItems()
@@ -1753,8 +2398,11 @@ void ClipboardBrowser::purgeItems()
     if ( tabName().isEmpty() )
         return;
 
+    waitForBackgroundSave();
     removeItems(tabName());
     m_timerSave.stop();
+    m_timerSaveTextIndex.stop();
+    m_journal.invalidate();
 }
 
 const QString ClipboardBrowser::selectedText() const
@@ -1770,7 +2418,9 @@ const QString ClipboardBrowser::selectedText() const
 
 void ClipboardBrowser::setTabName(const QString &tabName)
 {
+    waitForBackgroundSave();
     m_tabName = tabName;
+    m_journal.invalidate();
     saveItems();
 }
 
@@ -1849,6 +2499,24 @@ bool ClipboardBrowser::isLoaded() const
     return !m_sharedData->itemFactory || m_itemSaver || tabName().isEmpty();
 }
 
+QString ClipboardBrowser::memoryUsage() const
+{
+    const auto bytesPerFormat = m.dataSizes();
+    QList<QString> formats = bytesPerFormat.keys();
+    std::sort( std::begin(formats), std::end(formats), [&](const QString &lhs, const QString &rhs) {
+        return bytesPerFormat.value(lhs) > bytesPerFormat.value(rhs);
+    });
+
+    QStringList result;
+    result.append( QString("items: %1").arg(length()) );
+    result.append( QString("item widgets: %1").arg(d.cachedItemCount()) );
+    result.append( QString("text index: %1 bytes").arg(m_textIndex.byteCount()) );
+    for (const auto &format : formats)
+        result.append( QString("%1: %2 bytes").arg(format).arg(bytesPerFormat.value(format)) );
+
+    return result.join('\n');
+}
+
 bool ClipboardBrowser::maybeCloseEditors()
 {
     if ( (isInternalEditorOpen() && m_editor->hasChanges())
@@ -26,9 +26,14 @@
 #include "gui/configtabshortcuts.h"
 #include "gui/theme.h"
 #include "item/clipboardmodel.h"
+#include "item/itembackgroundfilter.h"
+#include "item/itembackgroundsaver.h"
 #include "item/itemdelegate.h"
+#include "item/itemjournal.h"
+#include "item/itemtextindex.h"
 #include "item/itemwidget.h"
 
+#include <QElapsedTimer>
 #include <QListView>
 #include <QPointer>
 #include <QTimer>
@@ -40,6 +45,7 @@
 class ItemEditorWidget;
 class ItemFactory;
 class PersistentDisplayItem;
+class QMimeData;
 class QProgressBar;
 class QPushButton;
 
@@ -62,10 +68,10 @@ class ClipboardBrowser : public QListView
          *
          * @return true only if item exists
          */
-        bool moveToTop(uint itemHash);
+        bool moveToTop(quint64 itemHash);
 
         /** Sort selected items. */
-        void sortItems(const QModelIndexList &indexes);
+        void sortItems(const QModelIndexList &indexes, ItemSortKey key = ItemSortKey::Text);
 
         /** Reverse order of selected items. */
         void reverseItems(const QModelIndexList &indexes);
@@ -119,12 +125,33 @@ class ClipboardBrowser : public QListView
         /** Paste items. */
         void paste(const QVariantMap &data, int destinationRow);
 
+        /**
+         * Paste items dragged from a tab in this application.
+         *
+         * Items are inserted with serialized data from the source tab so
+         * these don't need to be decoded and data in blob directory are
+         * not copied.
+         *
+         * @return false if @a data were not dragged from a tab
+         */
+        bool pasteDraggedItems(const QMimeData &data, int destinationRow);
+
         /** Render preview image with items. */
         QPixmap renderItemPreview(const QModelIndexList &indexes, int maxWidth, int maxHeight);
 
         /** Removes items from end of list without notifying plugins. */
         bool allocateSpaceForNewItems(int newItemCount);
 
+        /**
+         * Removes at most @a maxCount items last used before @a time
+         * (milliseconds since epoch) without notifying plugins.
+         *
+         * Items which plugins don't allow to remove (e.g. pinned) are kept.
+         *
+         * @return number of removed items
+         */
+        int removeItemsUnusedSince(qint64 time, int maxCount);
+
         /** Add new item to the browser. */
         bool add(
                 const QString &txt, //!< Text of new item.
@@ -140,11 +167,27 @@ class ClipboardBrowser : public QListView
                 int row = 0 //!< Target row for the new item (negative to append item).
                 );
 
+        /**
+         * Add new items to the browser at once.
+         * First item in the list is placed to the target row.
+         */
+        bool add(
+                const QList<QVariantMap> &dataList, //!< Data for new items.
+                int row = 0 //!< Target row for the new items (negative to append items).
+                );
+
         /**
          * Add item and remove duplicates.
          */
         void addUnique(const QVariantMap &data, ClipboardMode mode);
 
+        /**
+         * Add item and remove duplicates.
+         *
+         * Uses @a dataHash, computed with hash(), to find duplicate item.
+         */
+        void addUnique(const QVariantMap &data, ClipboardMode mode, quint64 dataHash);
+
         /** Number of items in list. */
         int length() const { return m.rowCount(); }
 
@@ -156,6 +199,15 @@ class ClipboardBrowser : public QListView
         void moveToClipboard(const QModelIndexList &indexes);
         /** Show only items matching the regular expression. */
         void filterItems(const QRegExp &re);
+        /**
+         * Return rows which can match the regular expression (see ItemTextIndex).
+         * Returns all rows if text index cannot be used.
+         */
+        QVector<int> searchCandidateRows(const QRegExp &re);
+        /** Return rows of items with data @a itemHash. */
+        QVector<int> findItems(quint64 itemHash) const { return m.findItems(itemHash); }
+        /** Return path to blob file with item data or empty string if not stored in blob. */
+        QString itemBlobFilePath(int row, const QString &mime) const { return m.itemBlobFilePath(row, mime); }
         /** Open editor. */
         bool openEditor(const QByteArray &textData, bool changeClipboard = false);
         /** Open editor for an item. */
@@ -171,6 +223,19 @@ class ClipboardBrowser : public QListView
          */
         void saveUnsavedItems();
 
+        /**
+         * Start bulk changes.
+         *
+         * Notifications about changed items and item count are deferred
+         * until the outermost transaction is committed.
+         *
+         * @see ClipboardBrowserTransaction
+         */
+        void beginTransaction();
+
+        /** Finish bulk changes and emit deferred notifications once. */
+        void commitTransaction();
+
         /**
          * Clear all items from configuration.
          * @see setID, loadItems, saveItems
@@ -216,12 +281,21 @@ class ClipboardBrowser : public QListView
 
         bool isLoaded() const;
 
+        /**
+         * Return memory used by items, item widgets and text index
+         * (one value per line).
+         */
+        QString memoryUsage() const;
+
         /**
          * Save items to configuration.
          * @see setID, loadItems, purgeItems
          */
         bool saveItems();
 
+        /** Save text index of items if it changed. */
+        void saveTextIndex();
+
         /** Move current item to clipboard. */
         void moveToClipboard();
 
@@ -310,6 +384,8 @@ class ClipboardBrowser : public QListView
 
         void onItemCountChanged();
 
+        void emitItemsChanged();
+
         void onEditorSave();
 
         void onEditorCancel();
@@ -330,6 +406,15 @@ class ClipboardBrowser : public QListView
 
         void updateCurrent();
 
+        void onScrolled(int value);
+
+        /**
+         * Create widgets for items about to be scrolled into view.
+         *
+         * Widgets are created in short batches so events can be processed in between.
+         */
+        void prefetchItems();
+
         /**
          * Hide row if filtered out, otherwise show.
          * @return true only if hidden
@@ -337,6 +422,33 @@ class ClipboardBrowser : public QListView
         bool hideFiltered(int row);
         bool hideFiltered(const QModelIndex &index);
 
+        /// Hide or show row and its item widget.
+        void setRowFiltered(int row, bool hide);
+
+        /**
+         * Find rows which can match filter using text index (built on first use).
+         * @return false if all rows need to be checked
+         */
+        bool filterCandidateRows(const QRegExp &re, QVector<int> *rows);
+
+        /**
+         * Match items in given rows in background and hide unmatched ones.
+         *
+         * If @a currentRow is not -1, first visible row from matched rows
+         * or @a currentRow is selected once rows above are matched.
+         */
+        void startBackgroundFilter(const QRegExp &re, const QVector<int> &rows, int currentRow);
+
+        /// Match all items again if model changes while matching in background.
+        void restartBackgroundFilter();
+
+        void onBackgroundFilterRowsMatched(const QVector<int> &rows, const QVector<bool> &matched);
+
+        void onBackgroundFilterFinished();
+
+        /** Record time since filtering started (see filterItems()). */
+        void addFilterMetric();
+
         /**
          * Connects signals and starts external editor.
          */
@@ -373,6 +485,12 @@ class ClipboardBrowser : public QListView
 
         int findNextVisibleRow(int row);
         int findPreviousVisibleRow(int row);
+        int findVisibleRow(int row, int direction);
+
+        /// Returns sorted rows not hidden by filter (rebuilt only after changes).
+        const QVector<int> &visibleRows();
+
+        void invalidateVisibleRows() { m_visibleRowsValid = false; }
 
         void preload(int pixels, bool above, const QModelIndex &start);
 
@@ -386,19 +504,40 @@ class ClipboardBrowser : public QListView
 
         void dragDropScroll();
 
+        /// Switch back to single pass layout once batched layout of loaded items finishes.
+        void finishBatchedLayout();
+
+        void onBackgroundSaveFinished(bool saved);
+
+        /// Block until items (including any newer changes) are saved in background.
+        void waitForBackgroundSave();
+
         void setCurrentIndex(const QModelIndex &index);
 
         ItemSaverPtr m_itemSaver;
         QString m_tabName;
         ClipboardModel m;
         ItemDelegate d;
+        ItemJournal m_journal;
+        ItemTextIndex m_textIndex;
+        ItemBackgroundSaver m_backgroundSaver;
+        ItemBackgroundFilter m_backgroundFilter;
+        int m_pendingCurrentRow = -1;
+        QElapsedTimer m_filterTimer;
+        bool m_saveAgain = false;
         QTimer m_timerSave;
+        QTimer m_timerSaveTextIndex;
         QTimer m_timerEmitItemCount;
         QTimer m_timerUpdateSizes;
         QTimer m_timerUpdateCurrent;
+        QTimer m_timerFinishBatchedLayout;
         QTimer m_timerDragDropScroll;
+        QTimer m_timerPrefetch;
+        int m_lastScrollValue = 0;
+        int m_scrollDirection = 1;
         bool m_ignoreMouseMoveWithButtonPressed = false;
         bool m_resizing = false;
+        bool m_sizesOutdated = false;
 
         QPointer<ItemEditorWidget> m_editor;
         int m_externalEditorsOpen = 0;
@@ -409,6 +548,36 @@ class ClipboardBrowser : public QListView
         QPoint m_dragStartPosition;
 
         int m_filterRow = -1;
+
+        QVector<int> m_visibleRows;
+        bool m_visibleRowsValid = false;
+
+        int m_transactionDepth = 0;
+        bool m_itemsChangedInTransaction = false;
+        bool m_itemCountChangedInTransaction = false;
+};
+
+/// Defers side effects of item changes in a browser until destroyed.
+class ClipboardBrowserTransaction final
+{
+public:
+    explicit ClipboardBrowserTransaction(ClipboardBrowser *browser)
+        : m_browser(browser)
+    {
+        m_browser->beginTransaction();
+    }
+
+    ~ClipboardBrowserTransaction()
+    {
+        if (m_browser)
+            m_browser->commitTransaction();
+    }
+
+    ClipboardBrowserTransaction(const ClipboardBrowserTransaction &) = delete;
+    ClipboardBrowserTransaction &operator=(const ClipboardBrowserTransaction &) = delete;
+
+private:
+    QPointer<ClipboardBrowser> m_browser;
 };
 
 #endif // CLIPBOARDBROWSER_H
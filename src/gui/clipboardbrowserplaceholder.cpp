@@ -32,6 +32,12 @@
 
 #include <memory>
 
+namespace {
+
+quint64 accessCounter = 0;
+
+} // namespace
+
 ClipboardBrowserPlaceholder::ClipboardBrowserPlaceholder(
         const QString &tabName, const ClipboardBrowserSharedPtr &shared, QWidget *parent)
     : QWidget(parent)
@@ -47,6 +53,8 @@ ClipboardBrowserPlaceholder::ClipboardBrowserPlaceholder(
 
 ClipboardBrowser *ClipboardBrowserPlaceholder::createBrowser()
 {
+    m_lastAccess = ++accessCounter;
+
     if (m_browser)
         return m_browser;
 
@@ -65,6 +65,9 @@ public:
     /// Unload browser and data.
     void expire();
 
+    /// Returns value which increases with each access to the browser (for unloading least recently used).
+    quint64 lastAccess() const { return m_lastAccess; }
+
 signals:
     void browserCreated(ClipboardBrowser *browser);
 
@@ -86,6 +89,7 @@ private:
     bool isEditorOpen() const;
 
     ClipboardBrowser *m_browser = nullptr;
+    quint64 m_lastAccess = 0;
     QPushButton *m_loadButton = nullptr;
 
     QString m_tabName;
@@ -21,7 +21,11 @@
 
 #include "gui/theme.h"
 
+#include <QHash>
+#include <QPair>
+#include <QSize>
 #include <QString>
+#include <QVariantMap>
 
 #include <memory>
 
@@ -30,6 +34,8 @@ class ItemFactory;
 struct ClipboardBrowserShared {
     QString editor;
     int maxItems = 100;
+    int itemsInMemory = 0;
+    int minItemBlobSize = 0;
     bool textWrap = true;
     bool viMode = false;
     bool saveOnReturnKey = false;
@@ -39,6 +45,12 @@ struct ClipboardBrowserShared {
     int minutesToExpire = 0;
     ItemFactory *itemFactory = nullptr;
     Theme theme;
+
+    /// Size hints of rendered items by item hash and width (see ItemDelegate::sizeHint()).
+    QHash<QPair<quint64, int>, QSize> itemSizeHints;
+
+    /// Item data modified by display commands by hash of original data (see MainWindow::setDisplayData()).
+    QHash<quint64, QVariantMap> displayDataCache;
 };
 
 using ClipboardBrowserSharedPtr = std::shared_ptr<ClipboardBrowserShared>;
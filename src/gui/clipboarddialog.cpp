@@ -33,10 +33,12 @@
 #include <QListWidgetItem>
 #include <QMovie>
 #include <QScrollBar>
+#include <QTextCodec>
+#include <QTextCursor>
 #include <QUrl>
 
-// Limit number of characters to load at once - performance reasons.
-static const int batchLoadCharacters = 4096;
+// Limit number of bytes to decode and show at once - performance reasons.
+static const int batchLoadBytes = 16 * 1024;
 
 ClipboardDialog::ClipboardDialog(QWidget *parent)
     : QDialog(parent)
@@ -90,6 +92,8 @@ void ClipboardDialog::onListWidgetFormatsCurrentItemChanged(
     const QByteArray bytes = m_data.value(mime).toByteArray();
 
     m_timerTextLoad.stop();
+    m_dataToShow.clear();
+    m_textDecoder.reset();
 
     if (hasAnimation) {
         if (m_animation)
@@ -113,7 +117,9 @@ void ClipboardDialog::onListWidgetFormatsCurrentItemChanged(
         pix.loadFromData( bytes, mime.toLatin1() );
         ui->labelImage->setPixmap(pix);
     } else {
-        m_textToShow = dataToText(bytes, mime);
+        m_dataToShow = bytes;
+        m_dataToShowPosition = 0;
+        m_textDecoder.reset( codecForData(bytes, mime)->makeDecoder() );
         addText();
     }
 
@@ -148,15 +154,43 @@ void ClipboardDialog::onDataChanged(const QModelIndex &topLeft, const QModelInde
 
 void ClipboardDialog::addText()
 {
+    if ( !m_textDecoder || m_dataToShowPosition >= m_dataToShow.size() )
+        return;
+
     const int scrollValue = ui->textEdit->verticalScrollBar()->value();
 
-    ui->textEdit->appendPlainText( m_textToShow.left(batchLoadCharacters) );
-    m_textToShow.remove(0, batchLoadCharacters);
+    const int size = qMin(batchLoadBytes, m_dataToShow.size() - m_dataToShowPosition);
+    const QString text = m_textDecoder->toUnicode(m_dataToShow.constData() + m_dataToShowPosition, size);
+    m_dataToShowPosition += size;
 
-    if ( !m_textToShow.isEmpty() )
-        m_timerTextLoad.start();
+    QTextCursor cursor( ui->textEdit->document() );
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text);
 
     ui->textEdit->verticalScrollBar()->setValue(scrollValue);
+
+    if ( m_dataToShowPosition >= m_dataToShow.size() ) {
+        m_dataToShow.clear();
+        m_textDecoder.reset();
+    } else if ( needsMoreText() ) {
+        m_timerTextLoad.start();
+    }
+}
+
+bool ClipboardDialog::needsMoreText() const
+{
+    if ( !m_textDecoder || m_dataToShowPosition >= m_dataToShow.size() )
+        return false;
+
+    // Keep few pages of text below the visible part.
+    const QScrollBar *scrollBar = ui->textEdit->verticalScrollBar();
+    return scrollBar->maximum() - scrollBar->value() < 4 * qMax(1, scrollBar->pageStep());
+}
+
+void ClipboardDialog::onTextScrolled()
+{
+    if ( !m_timerTextLoad.isActive() && needsMoreText() )
+        m_timerTextLoad.start();
 }
 
 void ClipboardDialog::init()
@@ -170,6 +204,8 @@ void ClipboardDialog::init()
             this, &ClipboardDialog::onListWidgetFormatsCurrentItemChanged);
     connect(ui->actionRemove_Format, &QAction::triggered,
             this, &ClipboardDialog::onActionRemoveFormatTriggered);
+    connect(ui->textEdit->verticalScrollBar(), &QScrollBar::valueChanged,
+            this, &ClipboardDialog::onTextScrolled);
 
     setWindowIcon(appIcon());
 
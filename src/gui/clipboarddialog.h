@@ -26,9 +26,12 @@
 #include <QVariantMap>
 #include <QTimer>
 
+#include <memory>
+
 class QBuffer;
 class QListWidgetItem;
 class QMovie;
+class QTextDecoder;
 
 namespace Ui {
     class ClipboardDialog;
@@ -64,6 +67,11 @@ private:
 
     void addText();
 
+    /// Return true if text view needs more text to fill it or scroll further.
+    bool needsMoreText() const;
+
+    void onTextScrolled();
+
     void init();
 
     void setData(const QVariantMap &data);
@@ -72,7 +80,10 @@ private:
     QPointer<QAbstractItemModel> m_model;
     QPersistentModelIndex m_index;
     QVariantMap m_data;
-    QString m_textToShow;
+    // Text is decoded and shown gradually as needed.
+    QByteArray m_dataToShow;
+    int m_dataToShowPosition = 0;
+    std::unique_ptr<QTextDecoder> m_textDecoder;
     QTimer m_timerTextLoad;
 
     QBuffer *m_animationBuffer = nullptr;
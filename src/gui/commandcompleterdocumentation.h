@@ -35,10 +35,13 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("paste", "paste()", "Pastes current clipboard.");
     addDocumentation("tab", "String[] tab()", "Returns array of tab names.");
     addDocumentation("tab", "tab(tabName)", "Sets current tab for the script.");
+    addDocumentation("findItem", "Object[] findItem(hash)", "Returns items with given data hash in all tabs.");
     addDocumentation("removeTab", "removeTab(tabName)", "Removes tab.");
     addDocumentation("renameTab", "renameTab(tabName, newTabName)", "Renames tab.");
     addDocumentation("tabIcon", "String tabIcon(tabName)", "Returns path to icon for tab.");
     addDocumentation("tabIcon", "tabIcon(tabName, iconPath)", "Sets icon for tab.");
+    addDocumentation("tabExpiry", "int tabExpiry(tabName)", "Returns number of days after which unused items are removed from tab.");
+    addDocumentation("tabExpiry", "tabExpiry(tabName, days)", "Removes items not used for given number of days from tab.");
     addDocumentation("count", "count(), length(), size()", "Returns amount of items in current tab.");
     addDocumentation("select", "select(row)", "Copies item in the row to clipboard.");
     addDocumentation("next", "next()", "Copies next item from current tab to clipboard.");
@@ -59,8 +62,8 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("notification", "notification(...)", "Shows popup message with icon and buttons.");
     addDocumentation("exportTab", "exportTab(fileName)", "Exports current tab into file.");
     addDocumentation("importTab", "importTab(fileName)", "Imports items from file to a new tab.");
-    addDocumentation("exportData", "exportData(fileName)", "Exports all tabs and configuration into file.");
-    addDocumentation("importData", "importData(fileName)", "Imports all tabs and configuration from file.");
+    addDocumentation("exportData", "exportData(fileName, [baseFileName])", "Exports all tabs and configuration into file.");
+    addDocumentation("importData", "importData(fileName, [mode])", "Imports all tabs and configuration from file.");
     addDocumentation("config", "String config()", "Returns help with list of available application options.");
     addDocumentation("config", "String config(optionName)", "Returns value of given application option.");
     addDocumentation("config", "String config(optionName, value)", "Sets application option and returns new value.");
@@ -68,6 +71,7 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("toggleConfig", "bool toggleConfig(optionName)", "Toggles an option (true to false and vice versa) and returns the new value.");
     addDocumentation("info", "String info([pathName])", "Returns paths and flags used by the application.");
     addDocumentation("eval", "Value eval(script)", "Evaluates script and returns result.");
+    addDocumentation("evalLines", "evalLines()", "Evaluates scripts read from standard input, one per line, until end of input.");
     addDocumentation("source", "Value source(fileName)", "Evaluates script file and returns result of last expression in the script.");
     addDocumentation("currentPath", "currentPath([path])", "Set current path.");
     addDocumentation("currentPath", "String currentPath()", "Get current path.");
@@ -97,13 +101,16 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("unpack", "Item unpack(data)", "Returns deserialized object from serialized items.");
     addDocumentation("pack", "ByteArray pack(item)", "Returns serialized item.");
     addDocumentation("getItem", "Item getItem(row)", "Returns an item in current tab.");
+    addDocumentation("getItems", "Item[] getItems([row=0, [count]], [mimeType, ...])", "Returns items in current tab.");
+    addDocumentation("snapshot", "Object snapshot([tabName, ...])", "Returns items of tabs copied at once.");
     addDocumentation("setItem", "setItem(row, text|item)", "Inserts item to current tab.");
     addDocumentation("toBase64", "String toBase64(data)", "Returns base64-encoded data.");
     addDocumentation("fromBase64", "ByteArray fromBase64(base64String)", "Returns base64-decoded data.");
-    addDocumentation("md5sum", "ByteArray md5sum(data)", "Returns MD5 checksum of data.");
-    addDocumentation("sha1sum", "ByteArray sha1sum(data)", "Returns SHA1 checksum of data.");
-    addDocumentation("sha256sum", "ByteArray sha256sum(data)", "Returns SHA256 checksum of data.");
-    addDocumentation("sha512sum", "ByteArray sha512sum(data)", "Returns SHA512 checksum of data.");
+    addDocumentation("md5sum", "ByteArray md5sum(data|row, mimeType)", "Returns MD5 checksum of data.");
+    addDocumentation("sha1sum", "ByteArray sha1sum(data|row, mimeType)", "Returns SHA1 checksum of data.");
+    addDocumentation("sha256sum", "ByteArray sha256sum(data|row, mimeType)", "Returns SHA256 checksum of data.");
+    addDocumentation("sha512sum", "ByteArray sha512sum(data|row, mimeType)", "Returns SHA512 checksum of data.");
+    addDocumentation("itemHash", "String itemHash(row)", "Returns hash of item data in current tab.");
     addDocumentation("open", "bool open(url, ...)", "Tries to open URLs in appropriate applications.");
     addDocumentation("execute", "FinishedCommand execute(argument, ..., null, stdinData, ...)", "Executes a command.");
     addDocumentation("currentWindowTitle", "String currentWindowTitle()", "Returns window title of currently focused window.");
@@ -122,6 +129,7 @@ void addDocumentation(AddDocumentationCallback addDocumentation)
     addDocumentation("setEnv", "bool setEnv(name, value)", "Sets environment variable with given name to given value.");
     addDocumentation("sleep", "sleep(time)", "Wait for given time in milliseconds.");
     addDocumentation("afterMilliseconds", "afterMilliseconds(time, function)", "Executes function after given time in milliseconds.");
+    addDocumentation("transaction", "transaction(function)", "Calls function and defers updates for changed items until it returns.");
     addDocumentation("screenNames", "String[] screenNames()", "Returns list of available screen names.");
     addDocumentation("screenshot", "ByteArray screenshot(format='png', [screenName])", "Returns image data with screenshot.");
     addDocumentation("screenshotSelect", "ByteArray screenshotSelect(format='png', [screenName])", "Same as `screenshot()` but allows to select an area on screen.");
@@ -22,6 +22,7 @@
 #include "gui/iconfactory.h"
 #include "scriptable/scriptable.h"
 
+#include <QHash>
 #include <QMetaMethod>
 #include <QMetaObject>
 #include <QPalette>
@@ -60,11 +61,37 @@ QRegExp commandLabelRegExp()
                 );
 }
 
-QRegExp createRegExp(const QStringList &list)
+enum class WordType {
+    Object,
+    Property,
+    Function,
+    Keyword
+};
+
+using WordTypes = QHash<QString, WordType>;
+
+void addWordTypes(const QStringList &words, WordType type, WordTypes *wordTypes)
+{
+    for (const auto &word : words)
+        wordTypes->insert(word, type);
+}
+
+/// Returns type of known words (built only once; later types take precedence).
+const WordTypes &wordTypes()
 {
-    QRegExp re;
-    re.setPattern("\\b" + list.join("\\b|\\b") + "\\b");
-    return re;
+    static WordTypes wordTypes;
+    if ( wordTypes.isEmpty() ) {
+        addWordTypes(scriptableObjects(), WordType::Object, &wordTypes);
+        addWordTypes(scriptableProperties(), WordType::Property, &wordTypes);
+        addWordTypes(scriptableFunctions(), WordType::Function, &wordTypes);
+        addWordTypes(scriptableKeywords(), WordType::Keyword, &wordTypes);
+    }
+    return wordTypes;
+}
+
+bool isWordCharacter(QChar c)
+{
+    return c.isLetterOrNumber() || c == '_';
 }
 
 int mixColorComponent(int a, int b)
@@ -88,10 +115,7 @@ public:
     explicit CommandSyntaxHighlighter(QWidget *editor, QTextDocument *parent)
         : QSyntaxHighlighter(parent)
         , m_editor(editor)
-        , m_reObjects(createRegExp(scriptableObjects()))
-        , m_reProperties(createRegExp(scriptableProperties()))
-        , m_reFunctions(createRegExp(scriptableFunctions()))
-        , m_reKeywords(createRegExp(scriptableKeywords()))
+        , m_wordTypes(wordTypes())
         , m_reLabels(commandLabelRegExp())
         , m_reNumbers("(?:\\b|%)\\d+")
     {
@@ -102,22 +126,7 @@ protected:
     {
         m_bgColor = getDefaultIconColor(*m_editor);
 
-        QTextCharFormat objectsFormat;
-        objectsFormat.setForeground(mixColor(m_bgColor, 40, -60, 40));
-        objectsFormat.setToolTip("Object");
-        highlight(text, m_reObjects, objectsFormat);
-
-        QTextCharFormat propertyFormat;
-        propertyFormat.setForeground(mixColor(m_bgColor, -60, 40, 40));
-        highlight(text, m_reProperties, propertyFormat);
-
-        QTextCharFormat functionFormat;
-        functionFormat.setForeground(mixColor(m_bgColor, -40, -40, 40));
-        highlight(text, m_reFunctions, functionFormat);
-
-        QTextCharFormat keywordFormat;
-        keywordFormat.setFontWeight(QFont::Bold);
-        highlight(text, m_reKeywords, keywordFormat);
+        highlightWords(text);
 
         QTextCharFormat labelsFormat;
         labelsFormat.setFontWeight(QFont::Bold);
@@ -151,6 +160,53 @@ private:
         }
     }
 
+    /// Highlights known words using single pass and hash lookup for each word.
+    void highlightWords(const QString &text)
+    {
+        QTextCharFormat objectsFormat;
+        objectsFormat.setForeground(mixColor(m_bgColor, 40, -60, 40));
+        objectsFormat.setToolTip("Object");
+
+        QTextCharFormat propertyFormat;
+        propertyFormat.setForeground(mixColor(m_bgColor, -60, 40, 40));
+
+        QTextCharFormat functionFormat;
+        functionFormat.setForeground(mixColor(m_bgColor, -40, -40, 40));
+
+        QTextCharFormat keywordFormat;
+        keywordFormat.setFontWeight(QFont::Bold);
+
+        for (int i = 0; i < text.size(); ) {
+            if ( !isWordCharacter(text[i]) ) {
+                ++i;
+                continue;
+            }
+
+            const int start = i;
+            while ( i < text.size() && isWordCharacter(text[i]) )
+                ++i;
+
+            const auto it = m_wordTypes.constFind( text.mid(start, i - start) );
+            if ( it == m_wordTypes.constEnd() )
+                continue;
+
+            switch (it.value()) {
+            case WordType::Object:
+                setFormat(start, i - start, objectsFormat);
+                break;
+            case WordType::Property:
+                setFormat(start, i - start, propertyFormat);
+                break;
+            case WordType::Function:
+                setFormat(start, i - start, functionFormat);
+                break;
+            case WordType::Keyword:
+                setFormat(start, i - start, keywordFormat);
+                break;
+            }
+        }
+    }
+
     void format(int a, int b)
     {
         QTextCharFormat format;
@@ -242,10 +298,7 @@ private:
     }
 
     QWidget *m_editor;
-    QRegExp m_reObjects;
-    QRegExp m_reProperties;
-    QRegExp m_reFunctions;
-    QRegExp m_reKeywords;
+    const WordTypes &m_wordTypes;
     QRegExp m_reLabels;
     QRegExp m_reNumbers;
     QColor m_bgColor;
@@ -288,7 +341,9 @@ QStringList scriptableKeywords()
 
 QStringList scriptableProperties()
 {
-    QStringList result;
+    static QStringList result;
+    if ( !result.isEmpty() )
+        return result;
 
     QMetaObject scriptableMetaObject = Scriptable::staticMetaObject;
     for (int i = 0; i < scriptableMetaObject.propertyCount(); ++i) {
@@ -303,7 +358,9 @@ QStringList scriptableProperties()
 
 QStringList scriptableFunctions()
 {
-    QStringList result;
+    static QStringList result;
+    if ( !result.isEmpty() )
+        return result;
 
     QMetaObject scriptableMetaObject = Scriptable::staticMetaObject;
     for (int i = 0; i < scriptableMetaObject.methodCount(); ++i) {
@@ -322,7 +379,11 @@ QStringList scriptableFunctions()
 
 QStringList scriptableObjects()
 {
-    QStringList result;
+    // Creating script engine is slow so the list is created only once.
+    static QStringList result;
+    if ( !result.isEmpty() )
+        return result;
+
     result.append("ByteArray");
     result.append("Dir");
     result.append("File");
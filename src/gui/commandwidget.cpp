@@ -154,6 +154,8 @@ Command CommandWidget::command() const
     c.globalShortcuts = serializeShortcuts( ui->shortcutButtonGlobalShortcut->shortcuts() );
     c.tab    = ui->comboBoxCopyToTab->currentText();
     c.outputTab = ui->comboBoxOutputTab->currentText();
+    c.persistent = ui->checkBoxPersistent->isChecked();
+    c.parallel = ui->checkBoxParallel->isChecked();
 
     return c;
 }
@@ -184,6 +186,8 @@ void CommandWidget::setCommand(const Command &c)
                 ui->shortcutButtonGlobalShortcut);
     ui->comboBoxCopyToTab->setEditText(c.tab);
     ui->comboBoxOutputTab->setEditText(c.outputTab);
+    ui->checkBoxPersistent->setChecked(c.persistent);
+    ui->checkBoxParallel->setChecked(c.parallel);
 
     if (c.cmd.isEmpty())
         ui->tabWidget->setCurrentWidget(ui->tabAdvanced);
@@ -311,6 +315,10 @@ QString CommandWidget::description() const
 
     if (cmd.wait) {
         description.append("<div><b>shows action dialog</b></div>");
+    } else if ( cmd.persistent && !cmd.cmd.isEmpty() && (cmd.automatic || cmd.display) ) {
+        description.append("<div><b>keeps program running</b></div>");
+    } else if ( cmd.parallel && !cmd.cmd.isEmpty() && cmd.automatic ) {
+        description.append("<div><b>runs in parallel</b></div>");
     } else if ( !cmd.cmd.isEmpty() && isAutomaticOrMenu ) {
         if ( !cmd.output.isEmpty() )
             description.append( QString("<div><b>output format:</b> %1</div>").arg(cmd.output) );
@@ -255,11 +255,17 @@ void ConfigurationManager::initOptions()
 
     /* other options */
     bind<Config::command_history_size>();
+    bind<Config::item_data_threshold>();
+    bind<Config::items_in_memory>();
+    bind<Config::max_background_commands>();
+    bind<Config::max_loaded_tabs>();
+    bind<Config::ignored_windows>();
 #ifdef HAS_MOUSE_SELECTIONS
     /* X11 clipboard selection monitoring and synchronization */
     bind<Config::check_selection>(ui->checkBoxSel);
     bind<Config::copy_clipboard>(ui->checkBoxCopyClip);
     bind<Config::copy_selection>(ui->checkBoxCopySel);
+    bind<Config::selection_settle_interval_ms>();
 #else
     ui->checkBoxCopySel->hide();
     ui->checkBoxSel->hide();
@@ -118,6 +118,9 @@ FilterLineEdit::FilterLineEdit(QWidget *parent)
 
     m_actionCaseInsensitive = menu->addAction(tr("Case Insensitive"));
     m_actionCaseInsensitive->setCheckable(true);
+
+    m_actionFuzzy = menu->addAction(tr("Fuzzy Match"));
+    m_actionFuzzy->setCheckable(true);
 }
 
 QRegExp FilterLineEdit::filter() const
@@ -126,7 +129,15 @@ QRegExp FilterLineEdit::filter() const
             m_actionCaseInsensitive->isChecked() ? Qt::CaseInsensitive : Qt::CaseSensitive;
 
     QString pattern;
-    if (m_actionRe->isChecked()) {
+    if ( isFuzzy() ) {
+        for ( const auto &c : text() ) {
+            if ( c.isSpace() )
+                continue;
+            if ( !pattern.isEmpty() )
+                pattern.append(".*");
+            pattern.append( QRegExp::escape(c) );
+        }
+    } else if (m_actionRe->isChecked()) {
         pattern = text();
     } else {
         for ( const auto &str : text().split(QRegExp("\\s+"), QString::SkipEmptyParts) ) {
@@ -139,6 +150,11 @@ QRegExp FilterLineEdit::filter() const
     return QRegExp(pattern, sensitivity, QRegExp::RegExp2);
 }
 
+bool FilterLineEdit::isFuzzy() const
+{
+    return m_actionFuzzy->isChecked();
+}
+
 void FilterLineEdit::loadSettings()
 {
     AppConfig appConfig;
@@ -149,6 +165,10 @@ void FilterLineEdit::loadSettings()
     const bool filterCaseSensitive = appConfig.option("filter_case_insensitive", true);
     m_actionCaseInsensitive->setChecked(filterCaseSensitive);
 
+    const bool filterFuzzy = appConfig.option("filter_fuzzy", false);
+    m_actionFuzzy->setChecked(filterFuzzy);
+    m_actionRe->setEnabled(!filterFuzzy);
+
     // KDE has custom icons for this. Notice that icon namings are counter intuitive.
     // If these icons are not available we use the freedesktop standard name before
     // falling back to a bundled resource.
@@ -210,6 +230,8 @@ void FilterLineEdit::onMenuAction()
     AppConfig appConfig;
     appConfig.setOption("filter_regular_expression", m_actionRe->isChecked());
     appConfig.setOption("filter_case_insensitive", m_actionCaseInsensitive->isChecked());
+    appConfig.setOption("filter_fuzzy", m_actionFuzzy->isChecked());
+    m_actionRe->setEnabled( !m_actionFuzzy->isChecked() );
 
     const QRegExp re = filter();
     if ( !re.isEmpty() )
@@ -44,6 +44,9 @@ public:
 
     QRegExp filter() const;
 
+    /** Return true if characters of filter are matched as subsequence. */
+    bool isFuzzy() const;
+
     void loadSettings();
 
 signals:
@@ -63,6 +66,7 @@ private:
     QTimer *m_timerSearch;
     QAction *m_actionRe;
     QAction *m_actionCaseInsensitive;
+    QAction *m_actionFuzzy;
 };
 
 } // namespace Utils
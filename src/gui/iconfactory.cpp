@@ -385,7 +385,22 @@ private:
 
     QPixmap taggedIcon(QPixmap *pix)
     {
+        if ( m_tag.isEmpty() )
+            return *pix;
+
+        const auto cacheKey = QString("tag:%1|%2|%3")
+                .arg(pix->cacheKey())
+                .arg(m_tag)
+                .arg(m_tagColor.rgba());
+
+        {
+            QPixmap pixmap;
+            if ( QPixmapCache::find(cacheKey, &pixmap) )
+                return pixmap;
+        }
+
         tagIcon(pix, m_tag, m_tagColor);
+        QPixmapCache::insert(cacheKey, *pix);
         return *pix;
     }
 
@@ -512,14 +527,25 @@ public:
         const bool running = m_iconType == AppIconRunning;
         const auto suffix = running ? QLatin1String("-busy") : QLatin1String("");
 
-        auto pix = appPixmap(suffix, size);
-
         // If copyq-normal icon exist in theme, omit changing color.
-        if ( !hasNormalIcon() ) {
-            const auto sessionColor = sessionIconColor();
-            if ( sessionColor.isValid() )
-                replaceColor(&pix, suffix, sessionColor);
-        }
+        const auto sessionColor = hasNormalIcon() ? QColor() : sessionIconColor();
+
+        const auto cacheKey = QString("app:%1|%2x%3|%4")
+                .arg(suffix)
+                .arg(size.width())
+                .arg(size.height())
+                .arg(sessionColor.isValid() ? sessionColor.rgba() : 0);
+
+        QPixmap pix;
+        if ( QPixmapCache::find(cacheKey, &pix) )
+            return pix;
+
+        pix = appPixmap(suffix, size);
+
+        if ( sessionColor.isValid() )
+            replaceColor(&pix, suffix, sessionColor);
+
+        QPixmapCache::insert(cacheKey, pix);
 
         return pix;
     }
@@ -24,18 +24,139 @@
 #include "gui/icons.h"
 #include "gui/icon_list.h"
 
+#include <QAbstractListModel>
+#include <QColor>
 #include <QDialogButtonBox>
 #include <QFileDialog>
+#include <QItemSelectionModel>
 #include <QKeyEvent>
-#include <QListWidget>
+#include <QListView>
 #include <QLineEdit>
 #include <QPushButton>
 #include <QVBoxLayout>
+#include <QVector>
 
-class IconListWidget : public QListWidget {
+namespace {
+
+/**
+ * Model with icons from icon font.
+ *
+ * Icon glyphs are rendered only for visible rows by the view and the search
+ * index is created only when filtering items for the first time.
+ */
+class IconListModel final : public QAbstractListModel {
+public:
+    IconListModel(const QSize &itemSize, QObject *parent)
+        : QAbstractListModel(parent)
+        , m_itemSize(itemSize)
+    {
+        // First row with no icon.
+        m_rows.append(-1);
+        for ( int i = 0; i < iconCount(); ++i )
+            m_rows.append(i);
+    }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        return parent.isValid() ? 0 : m_rows.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const override
+    {
+        if ( !index.isValid() || index.row() >= m_rows.size() )
+            return QVariant();
+
+        if (role == Qt::SizeHintRole)
+            return m_itemSize;
+
+        const int i = m_rows[index.row()];
+        if (i == -1)
+            return role == Qt::DisplayRole ? QString("") : QVariant();
+
+        const Icon &icon = iconList[i];
+        switch (role) {
+        case Qt::DisplayRole:
+            return iconText(icon);
+        case Qt::ToolTipRole:
+            return searchText(icon);
+        case Qt::BackgroundRole:
+            if (icon.isBrand)
+                return QColor(90,90,90,50);
+            break;
+        }
+
+        return QVariant();
+    }
+
+    /// Show only icons with search terms containing @a text.
+    void setFilter(const QString &text)
+    {
+        if ( m_searchTexts.isEmpty() ) {
+            m_searchTexts.reserve( iconCount() );
+            for (const Icon &icon : iconList)
+                m_searchTexts.append( searchText(icon) );
+        }
+
+        // Only currently shown icons can match if previous filter text was extended.
+        QVector<int> rows;
+        if ( !m_filter.isEmpty() && text.startsWith(m_filter) ) {
+            for (int i : m_rows) {
+                if ( i != -1 && m_searchTexts[i].contains(text) )
+                    rows.append(i);
+            }
+        } else {
+            if ( text.isEmpty() )
+                rows.append(-1);
+            for ( int i = 0; i < iconCount(); ++i ) {
+                if ( m_searchTexts[i].contains(text) )
+                    rows.append(i);
+            }
+        }
+
+        beginResetModel();
+        m_filter = text;
+        m_rows = rows;
+        endResetModel();
+    }
+
+    int rowForIcon(const QString &text) const
+    {
+        for ( int row = 0; row < m_rows.size(); ++row ) {
+            const int i = m_rows[row];
+            if ( i != -1 && iconText(iconList[i]) == text )
+                return row;
+        }
+        return -1;
+    }
+
+private:
+    static int iconCount()
+    {
+        return static_cast<int>( sizeof(iconList) / sizeof(iconList[0]) );
+    }
+
+    static QString iconText(const Icon &icon)
+    {
+        return QString( QChar(static_cast<ushort>(icon.unicode)) );
+    }
+
+    static QString searchText(const Icon &icon)
+    {
+        return QString::fromUtf8(icon.searchTerms).split('|').join(", ");
+    }
+
+    QSize m_itemSize;
+    QVector<int> m_rows;
+    QVector<QString> m_searchTexts;
+    QString m_filter;
+};
+
+} // namespace
+
+class IconListWidget : public QListView {
 public:
     explicit IconListWidget(QWidget *parent)
-        : QListWidget(parent)
+        : QListView(parent)
     {
         const int gridSize = iconFontSizePixels() + 8;
         const QSize size(gridSize, gridSize);
@@ -44,34 +165,31 @@ public:
 
         setFont( iconFont() );
         setGridSize(size);
+        setUniformItemSizes(true);
         setResizeMode(QListView::Adjust);
         setSelectionMode(QAbstractItemView::SingleSelection);
         setDragDropMode(QAbstractItemView::NoDragDrop);
 
-        addItem( QString("") );
-        item(0)->setSizeHint(size);
+        m_model = new IconListModel(size, this);
+        setModel(m_model);
     }
 
-    QString addIcon(ushort unicode, bool isBrand, const QStringList &searchTerms)
+    QString icon(const QModelIndex &index) const
     {
-        const QString icon(unicode);
-        auto item = new QListWidgetItem(icon, this);
-        item->setSizeHint( gridSize() );
-        item->setToolTip( searchTerms.join(", ") );
-        if (isBrand)
-            item->setBackgroundColor( QColor(90,90,90,50) );
-        return icon;
+        return index.data(Qt::DisplayRole).toString();
     }
 
-    QString icon(const QModelIndex &index) const
+    void setCurrentIcon(const QString &icon)
     {
-        return item(index.row())->text();
+        const int row = m_model->rowForIcon(icon);
+        if (row != -1)
+            setCurrentIndex( m_model->index(row) );
     }
 
     bool isIconSelected() const
     {
         const QModelIndex index = currentIndex();
-        return index.isValid() && item(index.row())->isSelected();
+        return index.isValid() && selectionModel()->isSelected(index);
     }
 
     void keyboardSearch(const QString &search) override
@@ -111,7 +229,7 @@ protected:
 
     void resizeEvent(QResizeEvent *event) override
     {
-        QListWidget::resizeEvent(event);
+        QListView::resizeEvent(event);
         if (m_search)
             updateSearchPosition();
     }
@@ -136,14 +254,9 @@ private:
 
     void search(const QString &text)
     {
-        setCurrentItem(nullptr);
-        for (int row = 0; row < count(); ++row) {
-            auto item = this->item(row);
-            const bool matches = item->toolTip().contains(text);
-            item->setHidden(!matches);
-            if (matches && currentItem() == nullptr)
-                setCurrentItem(item);
-        }
+        m_model->setFilter(text);
+        if ( m_model->rowCount() > 0 )
+            setCurrentIndex( m_model->index(0) );
     }
 
     void stopSearch()
@@ -157,6 +270,7 @@ private:
         setFocus();
     }
 
+    IconListModel *m_model;
     QLineEdit *m_search = nullptr;
 };
 
@@ -170,7 +284,7 @@ IconSelectDialog::IconSelectDialog(const QString &defaultIcon, QWidget *parent)
     connect( m_iconList, &QAbstractItemView::activated,
              this, &IconSelectDialog::onIconListItemActivated );
 
-    addIcons();
+    m_iconList->setCurrentIcon(m_selectedIcon);
 
     QPushButton *browseButton = new QPushButton(tr("Browse..."), this);
     if ( m_selectedIcon.size() > 2 )
@@ -233,13 +347,3 @@ void IconSelectDialog::onAcceptCurrent()
     else
         reject();
 }
-
-void IconSelectDialog::addIcons()
-{
-    for (const Icon &icon : iconList) {
-        const auto searchTerms = QString(icon.searchTerms).split('|');
-        const auto iconText = m_iconList->addIcon(icon.unicode, icon.isBrand, searchTerms);
-        if (m_selectedIcon == iconText)
-            m_iconList->setCurrentRow(m_iconList->count() - 1);
-    }
-}
@@ -47,8 +47,6 @@ private:
 
     void onAcceptCurrent();
 
-    void addIcons();
-
     IconListWidget *m_iconList;
     QString m_selectedIcon;
 };
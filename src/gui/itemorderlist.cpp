@@ -88,6 +88,7 @@ void ItemOrderList::clearItems()
     for (const auto &pair : m_items)
         deleteWidget(pair.widget);
     m_items.clear();
+    m_listItemsWidth = 0;
 }
 
 void ItemOrderList::appendItem(const QString &label, bool checked, const QIcon &icon, const ItemPtr &item)
@@ -107,10 +108,17 @@ void ItemOrderList::insertItem(const QString &label, bool checked, const QIcon &
     list->insertItem(row, listItem);
 
     // Resize list to minimal size.
+    // Only the new item is measured, calling sizeHintForColumn() here would
+    // go through all items again which is slow for long command lists.
     if ( !isVisible() ) {
-        const int w = list->sizeHintForColumn(0)
-                    + list->verticalScrollBar()->sizeHint().width() + 4;
-        list->resize( w, list->height() );
+        const QModelIndex index = list->model()->index(row, 0);
+        const int itemWidth = list->sizeHintForIndex(index).width();
+        if (itemWidth > m_listItemsWidth) {
+            m_listItemsWidth = itemWidth;
+            const int w = m_listItemsWidth
+                        + list->verticalScrollBar()->sizeHint().width() + 4;
+            list->resize( w, list->height() );
+        }
     }
 
     if ( list->currentItem() == nullptr )
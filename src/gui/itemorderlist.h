@@ -139,6 +139,7 @@ private:
 
     Ui::ItemOrderList *ui;
     QMap<QListWidgetItem*, ItemWidgetPair> m_items;
+    int m_listItemsWidth = 0;
 
     QRegExp m_dragAndDropRe;
 };
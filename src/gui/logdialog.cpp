@@ -37,18 +37,16 @@ namespace {
 const int maxDisplayLogSize = 128 * 1024;
 const auto logLinePrefix = "CopyQ ";
 
-void showLogLines(QString *content, bool show, LogLevel level)
+LogLevel logLineLevel(const QString &line)
 {
-    if (show)
-        return;
-
-    const QString label = logLinePrefix + logLevelLabel(level);
-
-    const QRegExp re("\n" + label + "[^\n]*");
-    content->remove(re);
+    for (const auto level : {LogError, LogWarning, LogNote, LogDebug, LogTrace}) {
+        const QString label = logLinePrefix + logLevelLabel(level);
+        if ( line.startsWith(label) )
+            return level;
+    }
 
-    const QRegExp re2("^" + label + "[^\n]*\n");
-    content->remove(re2);
+    // Unknown lines are always shown.
+    return LogAlways;
 }
 
 } // namespace
@@ -247,6 +245,7 @@ LogDialog::LogDialog(QWidget *parent)
     addFilterCheckBox(LogTrace, &LogDialog::showTrace);
     ui->layoutFilters->addStretch(1);
 
+    loadLog();
     updateLog();
 }
 
@@ -255,7 +254,7 @@ LogDialog::~LogDialog()
     delete ui;
 }
 
-void LogDialog::updateLog()
+void LogDialog::loadLog()
 {
     QString content = readLogFile(maxDisplayLogSize);
 
@@ -265,19 +264,48 @@ void LogDialog::updateLog()
         content.remove(0, i + 1);
     }
 
-    showLogLines(&content, m_showError, LogError);
-    showLogLines(&content, m_showWarning, LogWarning);
-    showLogLines(&content, m_showNote, LogNote);
-    showLogLines(&content, m_showDebug, LogDebug);
-    showLogLines(&content, m_showTrace, LogTrace);
-
-    // Remove common prefix.
+    // Classify lines only once so filtering doesn't need to read and parse the log again.
     const QString prefix = logLinePrefix;
-    if ( content.startsWith(prefix) )
-        content.remove( 0, prefix.size() );
-    content.replace("\n" + prefix, "\n");
+    const auto lines = content.split('\n');
+    m_logLines.clear();
+    m_logLines.reserve( lines.size() );
+    for (const auto &line : lines) {
+        const LogLevel level = logLineLevel(line);
+        // Remove common prefix.
+        m_logLines.append( LogLine{level, level == LogAlways ? line : line.mid(prefix.size())} );
+    }
+}
+
+bool LogDialog::isLogLevelShown(LogLevel level) const
+{
+    switch (level) {
+    case LogError:
+        return m_showError;
+    case LogWarning:
+        return m_showWarning;
+    case LogNote:
+        return m_showNote;
+    case LogDebug:
+        return m_showDebug;
+    case LogTrace:
+        return m_showTrace;
+    case LogAlways:
+        break;
+    }
+
+    return true;
+}
+
+void LogDialog::updateLog()
+{
+    QStringList lines;
+    lines.reserve( m_logLines.size() );
+    for (const auto &line : m_logLines) {
+        if ( isLogLevelShown(line.level) )
+            lines.append(line.text);
+    }
 
-    ui->textBrowserLog->setPlainText(content);
+    ui->textBrowserLog->setPlainText( lines.join('\n') );
 
     ui->textBrowserLog->moveCursor(QTextCursor::End);
 
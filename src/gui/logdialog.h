@@ -22,6 +22,8 @@
 #include "common/log.h"
 
 #include <QDialog>
+#include <QString>
+#include <QVector>
 
 namespace Ui {
 class LogDialog;
@@ -40,6 +42,17 @@ public:
 private:
     using FilterCheckBoxSlot = void (LogDialog::*)(bool);
 
+    struct LogLine {
+        LogLevel level;
+        QString text;
+    };
+
+    /** Read log file and split it to lines. */
+    void loadLog();
+
+    bool isLogLevelShown(LogLevel level) const;
+
+    /** Show lines with enabled log levels. */
     void updateLog();
 
     void showError(bool show);
@@ -56,6 +69,8 @@ private:
     Decorator *m_stringDecorator;
     Decorator *m_threadNameDecorator;
 
+    QVector<LogLine> m_logLines;
+
     bool m_showError;
     bool m_showWarning;
     bool m_showNote;
@@ -32,6 +32,7 @@
 #include "common/log.h"
 #include "common/mimetypes.h"
 #include "common/shortcuts.h"
+#include "common/startupphases.h"
 #include "common/textdata.h"
 #include "common/timer.h"
 #include "gui/aboutdialog.h"
@@ -60,6 +61,8 @@
 #include "gui/traymenu.h"
 #include "gui/windowgeometryguard.h"
 #include "item/itemfactory.h"
+#include "item/itemsearch.h"
+#include "item/itemstore.h"
 #include "item/serialize.h"
 #include "platform/platformclipboard.h"
 #include "platform/platformnativeinterface.h"
@@ -71,9 +74,12 @@
 
 #include <QAction>
 #include <QCloseEvent>
+#include <QDateTime>
 #include <QDesktopServices>
+#include <QDir>
 #include <QFile>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QFlags>
 #include <QMenu>
 #include <QMenuBar>
@@ -81,6 +87,7 @@
 #include <QMimeData>
 #include <QModelIndex>
 #include <QPushButton>
+#include <QSaveFile>
 #include <QTimer>
 #include <QToolBar>
 #include <QUrl>
@@ -93,6 +100,17 @@ namespace {
 const int contextMenuUpdateIntervalMsec = 100;
 const int trayMenuUpdateIntervalMsec = 100;
 
+const int maxCachedMenuMatchCommandResults = 1000;
+const int maxCachedDisplayData = 1000;
+// Display data from finished commands are applied in batches,
+// roughly once per frame.
+const int displayDataUpdateIntervalMsec = 16;
+
+const int expiredItemsCheckIntervalMsec = 60 * 1000;
+// Expired items are removed in batches to keep the UI responsive.
+const int maxExpiredItemsRemovedAtOnce = 100;
+const qint64 msecsPerDay = 24 * 60 * 60 * 1000;
+
 const QIcon iconClipboard() { return getIcon("clipboard", IconPaste); }
 const QIcon iconTabIcon() { return getIconFromResources("tab_icon"); }
 const QIcon iconTabNew() { return getIconFromResources("tab_new"); }
@@ -216,6 +234,25 @@ QVariantMap addSelectionData(
     return result;
 }
 
+/// Returns hash of data passed to menu filter commands, including selected rows.
+quint64 menuFilterDataHash(const QVariantMap &data)
+{
+    quint64 hash = 0;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        hash = contentHash(it.key().toUtf8(), hash);
+        if (it.key() == mimeCurrentItem) {
+            const auto index = it.value().value<QPersistentModelIndex>();
+            hash = contentHash(QByteArray::number(index.row()), hash);
+        } else if (it.key() == mimeSelectedItems) {
+            for ( const auto &index : it.value().value<QList<QPersistentModelIndex>>() )
+                hash = contentHash(QByteArray::number(index.row()), hash);
+        } else {
+            hash = contentHash(it.value().toByteArray(), hash);
+        }
+    }
+    return hash;
+}
+
 QVariantMap addSelectionData(const ClipboardBrowser &c)
 {
     const QModelIndexList selectedIndexes = c.selectionModel()->selectedIndexes();
@@ -223,6 +260,325 @@ QVariantMap addSelectionData(const ClipboardBrowser &c)
     return addSelectionData(c, current, selectedIndexes);
 }
 
+QStringList tabNamesFromList(const QVariantList &tabsList)
+{
+    QStringList tabs;
+    tabs.reserve( tabsList.size() );
+    for (const auto &tabMapValue : tabsList)
+        tabs.append( tabMapValue.toMap().value("name").toString() );
+    return tabs;
+}
+
+bool skipItemV4(QDataStream *in)
+{
+    quint32 size;
+    *in >> size;
+    if ( size != 0xffffffff && in->skipRawData(static_cast<int>(size)) != static_cast<int>(size) )
+        in->setStatus(QDataStream::ReadPastEnd);
+    return in->status() == QDataStream::Ok;
+}
+
+/**
+ * Opens exported data file and reads its header.
+ *
+ * Base export path is resolved relative to the file.
+ */
+bool openExportedDataV4(QFile *file, QDataStream *in, QVariantMap *data, QString *basePath)
+{
+    if ( !file->open(QIODevice::ReadOnly) )
+        return false;
+
+    in->setDevice(file);
+    in->setVersion(QDataStream::Qt_4_7);
+
+    QByteArray header;
+    (*in) >> header;
+    if ( !header.startsWith("CopyQ v4") )
+        return false;
+
+    (*in) >> *data;
+
+    const auto base = data->value("base").toString();
+    if ( !base.isEmpty() )
+        *basePath = QFileInfo(file->fileName()).absoluteDir().absoluteFilePath(base);
+
+    return in->status() == QDataStream::Ok;
+}
+
+/// Returns canonical path if file exists, otherwise absolute path.
+QString exportedDataFilePath(const QString &fileName)
+{
+    const QFileInfo info(fileName);
+    const auto path = info.canonicalFilePath();
+    return path.isEmpty() ? info.absoluteFilePath() : path;
+}
+
+/**
+ * Returns paths of exported data file and all its base files.
+ *
+ * Fails if a file cannot be read or the base files refer back to a file in the chain.
+ */
+bool readExportedDataChainV4(const QString &fileName, QStringList *paths)
+{
+    QString path = exportedDataFilePath(fileName);
+    while ( !path.isEmpty() ) {
+        if ( paths->contains(path) ) {
+            log( QString("Cyclic base export \"%1\"").arg(path), LogError );
+            return false;
+        }
+        paths->append(path);
+
+        QFile file(path);
+        QDataStream in;
+        QVariantMap data;
+        QString basePath;
+        if ( !openExportedDataV4(&file, &in, &data, &basePath) )
+            return false;
+
+        path = basePath.isEmpty() ? QString() : exportedDataFilePath(basePath);
+    }
+
+    return true;
+}
+
+/// Returns hashes of all items which can be restored from exported data file.
+bool readExportedItemHashesV4(const QString &fileName, QSet<quint64> *hashes)
+{
+    QFile file(fileName);
+    QDataStream in;
+    QVariantMap data;
+    QString basePath;
+    if ( !openExportedDataV4(&file, &in, &data, &basePath) )
+        return false;
+
+    const int tabCount = data.value("tabs").toList().size();
+    for (int tab = 0; tab < tabCount; ++tab) {
+        qint32 length;
+        in >> length;
+        for (qint32 i = 0; i < length && in.status() == QDataStream::Ok; ++i) {
+            quint64 hash;
+            in >> hash;
+            hashes->insert(hash);
+            skipItemV4(&in);
+        }
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+/**
+ * Reads items with given hashes from exported data file and its base files.
+ *
+ * Found items are removed from @a hashes.
+ *
+ * Paths of files already read are added to @a visitedPaths.
+ */
+bool readExportedItemsV4(
+        const QString &fileName, QSet<quint64> *hashes, QHash<quint64, QVariantMap> *items,
+        QStringList *visitedPaths)
+{
+    const auto path = exportedDataFilePath(fileName);
+    if ( visitedPaths->contains(path) ) {
+        log( QString("Cyclic base export \"%1\"").arg(fileName), LogError );
+        return false;
+    }
+    visitedPaths->append(path);
+
+    QFile file(fileName);
+    QDataStream in;
+    QVariantMap data;
+    QString basePath;
+    if ( !openExportedDataV4(&file, &in, &data, &basePath) ) {
+        log( QString("Failed to open base export \"%1\"").arg(fileName), LogError );
+        return false;
+    }
+
+    const int tabCount = data.value("tabs").toList().size();
+    for (int tab = 0; tab < tabCount && !hashes->isEmpty(); ++tab) {
+        qint32 length;
+        in >> length;
+        for (qint32 i = 0; i < length && in.status() == QDataStream::Ok; ++i) {
+            quint64 hash;
+            in >> hash;
+            if ( !hashes->contains(hash) ) {
+                skipItemV4(&in);
+                continue;
+            }
+
+            QByteArray bytes;
+            in >> bytes;
+            // Item stored in base file.
+            if ( bytes.isNull() )
+                continue;
+
+            QVariantMap itemData;
+            if ( !deserializeData(&itemData, bytes) )
+                return false;
+
+            items->insert(hash, itemData);
+            hashes->remove(hash);
+        }
+    }
+
+    if ( in.status() != QDataStream::Ok )
+        return false;
+
+    if ( hashes->isEmpty() )
+        return true;
+
+    if ( basePath.isEmpty() ) {
+        log( QString("Missing items in exported data \"%1\"").arg(fileName), LogError );
+        return false;
+    }
+
+    return readExportedItemsV4(basePath, hashes, items, visitedPaths);
+}
+
+/**
+ * Writes items one by one so the whole tab is never serialized in memory.
+ *
+ * Items with hashes in @a baseHashes are not written, only referenced.
+ */
+bool serializeItemsV4(const QAbstractItemModel &model, QDataStream *out, const QSet<quint64> &baseHashes)
+{
+    const qint32 length = model.rowCount();
+    *out << length;
+
+    for (qint32 row = 0; row < length && out->status() == QDataStream::Ok; ++row) {
+        const auto index = model.index(row, 0);
+        const quint64 hash = index.data(contentType::hash).toULongLong();
+        *out << hash;
+        if ( baseHashes.contains(hash) )
+            *out << QByteArray();
+        else
+            *out << serializeData( index.data(contentType::data).toMap() );
+    }
+
+    return out->status() == QDataStream::Ok;
+}
+
+/**
+ * Reads items and adds them to model in batches.
+ *
+ * If model is null or maximum number of items was reached,
+ * the remaining items are skipped without decoding.
+ *
+ * Items not stored in the file are read from @a basePath file.
+ *
+ * If @a merge is true, items already in model are skipped and the new
+ * items are inserted to the top, otherwise items are appended.
+ */
+bool deserializeItemsV4(
+        QAbstractItemModel *model, QDataStream *in, int maxItems, const QString &basePath, bool merge)
+{
+    qint32 length;
+    *in >> length;
+    if ( in->status() != QDataStream::Ok )
+        return false;
+
+    if (length < 0) {
+        in->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    const int itemsToLoad = model ? qMax(0, maxItems - model->rowCount()) : 0;
+
+    QSet<quint64> knownHashes;
+    if (merge && itemsToLoad > 0) {
+        for (int row = 0; row < model->rowCount(); ++row)
+            knownHashes.insert( model->index(row, 0).data(contentType::hash).toULongLong() );
+    }
+
+    // Find items stored only in base files first.
+    QHash<quint64, QVariantMap> baseItems;
+    if ( itemsToLoad > 0 && !basePath.isEmpty() ) {
+        const auto start = in->device()->pos();
+        auto hashesToLoad = knownHashes;
+        QSet<quint64> hashes;
+        for ( qint32 i = 0;
+              i < length && in->status() == QDataStream::Ok
+              && hashesToLoad.size() - knownHashes.size() < itemsToLoad;
+              ++i )
+        {
+            quint64 hash;
+            *in >> hash;
+            const bool isNew = !merge || !hashesToLoad.contains(hash);
+            const auto pos = in->device()->pos();
+            quint32 size;
+            *in >> size;
+            if (isNew && size == 0xffffffff)
+                hashes.insert(hash);
+            else if ( !in->device()->seek(pos) || !skipItemV4(in) )
+                return false;
+
+            if (isNew)
+                hashesToLoad.insert(hash);
+        }
+
+        if ( in->status() != QDataStream::Ok || !in->device()->seek(start) )
+            return false;
+
+        QStringList visitedPaths;
+        if ( !hashes.isEmpty() && !readExportedItemsV4(basePath, &hashes, &baseItems, &visitedPaths) )
+            return false;
+    }
+
+    const int batchSize = 100;
+    QList<QVariantMap> batch;
+    int insertedCount = 0;
+
+    const auto insertBatch = [&]() {
+        const int row = merge ? insertedCount : model->rowCount();
+        if ( !model->insertRows(row, batch.size()) )
+            return false;
+        for (int i = 0; i < batch.size(); ++i)
+            model->setData( model->index(row + i, 0), batch[i], contentType::data );
+        insertedCount += batch.size();
+        batch.clear();
+        return true;
+    };
+
+    int loadedCount = 0;
+    for (qint32 i = 0; i < length && in->status() == QDataStream::Ok; ++i) {
+        quint64 hash;
+        *in >> hash;
+
+        if ( loadedCount >= itemsToLoad || (merge && knownHashes.contains(hash)) ) {
+            skipItemV4(in);
+            continue;
+        }
+
+        QByteArray bytes;
+        *in >> bytes;
+
+        QVariantMap data;
+        if ( bytes.isNull() ) {
+            const auto it = baseItems.constFind(hash);
+            if ( it == baseItems.constEnd() ) {
+                in->setStatus(QDataStream::ReadCorruptData);
+                return false;
+            }
+            data = it.value();
+        } else if ( !deserializeData(&data, bytes) ) {
+            in->setStatus(QDataStream::ReadCorruptData);
+            return false;
+        }
+
+        if (merge)
+            knownHashes.insert(hash);
+        ++loadedCount;
+
+        batch.append(data);
+        if ( batch.size() == batchSize && !insertBatch() )
+            return false;
+    }
+
+    if ( !batch.isEmpty() && !insertBatch() )
+        return false;
+
+    return in->status() == QDataStream::Ok;
+}
+
 QMenu *findSubMenu(const QString &name, const QMenu &menu)
 {
     for (auto action : menu.actions()) {
@@ -445,7 +801,10 @@ MainWindow::MainWindow(ItemFactory *itemFactory, QWidget *parent)
     initSingleShotTimer( &m_timerTrayAvailable, 1000, this, [this]() { setTrayEnabled(); } );
     initSingleShotTimer( &m_timerTrayIconSnip, 500, this, &MainWindow::updateIconSnipTimeout );
     initSingleShotTimer( &m_timerSaveTabPositions, 1000, this, &MainWindow::doSaveTabPositions );
+    initSingleShotTimer( &m_timerPreloadTabs, 1000, this, &MainWindow::preloadTabs );
     initSingleShotTimer( &m_timerRaiseLastWindowAfterMenuClosed, 50, this, &MainWindow::raiseLastWindowAfterMenuClosed);
+    initSingleShotTimer( &m_timerRemoveExpiredItems, expiredItemsCheckIntervalMsec, this, &MainWindow::removeExpiredItems );
+    initSingleShotTimer( &m_timerUpdateDisplayItems, displayDataUpdateIntervalMsec, this, &MainWindow::updateDisplayItems );
     enableHideWindowOnUnfocus();
 
     m_trayMenu->setObjectName("TrayMenu");
@@ -729,6 +1088,8 @@ void MainWindow::updateIconSnipTimeout()
 
 void MainWindow::updateContextMenuTimeout()
 {
+    m_lastContextMenuUpdate.start();
+
     updateItemPreview();
 
     auto c = getPlaceholder()->createBrowser();
@@ -896,7 +1257,7 @@ void MainWindow::onTabWidgetDropItems(const QString &tabName, const QMimeData *d
 {
     auto browser = tab(tabName);
 
-    if (browser) {
+    if ( browser && !browser->pasteDraggedItems(*data, 0) ) {
         const QVariantMap dataMap = data->hasFormat(mimeItems)
                 ? cloneData(*data, QStringList() << mimeItems) : cloneData(*data);
         browser->paste(dataMap, 0);
@@ -979,6 +1340,8 @@ void MainWindow::moveToBottom()
 
 void MainWindow::onBrowserCreated(ClipboardBrowser *browser)
 {
+    unloadLeastRecentlyUsedTabs();
+
     connect( browser, &ClipboardBrowser::changeClipboard,
              this, &MainWindow::setClipboardAndSelection );
     connect( browser, &ClipboardBrowser::requestShow,
@@ -1005,14 +1368,64 @@ void MainWindow::onBrowserCreated(ClipboardBrowser *browser)
              this, &MainWindow::onItemWidgetCreated );
 }
 
+void MainWindow::unloadLeastRecentlyUsedTabs()
+{
+    if (m_options.maxLoadedTabs <= 0)
+        return;
+
+    const int current = ui->tabWidget->currentIndex();
+    QVector<ClipboardBrowserPlaceholder*> loaded;
+    int loadedCount = 0;
+    for ( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        const auto placeholder = getPlaceholder(i);
+        if ( placeholder->isDataLoaded() ) {
+            ++loadedCount;
+            if (i != current)
+                loaded.append(placeholder);
+        }
+    }
+
+    // One more tab is being loaded.
+    int toUnload = loadedCount + 1 - m_options.maxLoadedTabs;
+    if (toUnload <= 0)
+        return;
+
+    std::sort( loaded.begin(), loaded.end(),
+               [](const ClipboardBrowserPlaceholder *lhs, const ClipboardBrowserPlaceholder *rhs) {
+                   return lhs->lastAccess() < rhs->lastAccess();
+               } );
+
+    for (auto placeholder : loaded) {
+        if (toUnload <= 0)
+            break;
+
+        // Tabs which are visible or edited are kept.
+        placeholder->expire();
+        if ( !placeholder->isDataLoaded() ) {
+            COPYQ_LOG( QString("Tab \"%1\": Unloaded least recently used").arg(placeholder->tabName()) );
+            --toUnload;
+        }
+    }
+}
+
 void MainWindow::onItemSelectionChanged(const ClipboardBrowser *browser)
 {
-    if (browser == this->browser())
-        updateContextMenu(0);
+    if (browser == this->browser()) {
+        // Avoid rebuilding the menu for each step while the selection changes
+        // quickly, e.g. when holding arrow keys.
+        const bool changedRecently = m_lastContextMenuUpdate.isValid()
+                && !m_lastContextMenuUpdate.hasExpired(contextMenuUpdateIntervalMsec);
+        updateContextMenu(changedRecently ? contextMenuUpdateIntervalMsec : 0);
+    }
 }
 
 void MainWindow::onItemsChanged(const ClipboardBrowser *browser)
 {
+    if (browser == m_menuSearchCache.browser)
+        m_menuSearchCache = MenuSearchCache();
+    if (browser == m_trayMenuSearchCache.browser)
+        m_trayMenuSearchCache = MenuSearchCache();
+
     if (browser == this->browser())
         updateContextMenu(contextMenuUpdateIntervalMsec);
     if (browser == getTabForTrayMenu())
@@ -1094,6 +1507,17 @@ void MainWindow::clearHiddenDisplayData()
     }
 }
 
+void MainWindow::updateDisplayItems()
+{
+    const auto items = m_displayItemsToUpdate;
+    m_displayItemsToUpdate.clear();
+
+    for (const auto &itemData : items) {
+        auto item = itemData.first;
+        item.setData(itemData.second);
+    }
+}
+
 void MainWindow::reloadBrowsers()
 {
     for( int i = 0; i < ui->tabWidget->count(); ++i )
@@ -1263,6 +1687,46 @@ void MainWindow::updateTabIcon(const QString &newName, const QString &oldName)
         setIconNameForTabName(newName, icon);
 }
 
+void MainWindow::updateTabItemExpiry(const QString &newName, const QString &oldName)
+{
+    const int days = m_tabItemExpiryDays.value(oldName, 0);
+    if (days > 0) {
+        setTabItemExpiryDays(oldName, 0);
+        setTabItemExpiryDays(newName, days);
+    }
+}
+
+void MainWindow::removeExpiredItems()
+{
+    if ( m_tabItemExpiryDays.isEmpty() )
+        return;
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    bool removeNextBatch = false;
+
+    for (auto it = m_tabItemExpiryDays.constBegin(); it != m_tabItemExpiryDays.constEnd(); ++it) {
+        const int i = findTabIndexExactMatch( it.key() );
+        const auto placeholder = i == -1 ? nullptr : getPlaceholder(i);
+        const auto c = placeholder ? placeholder->browser() : nullptr;
+
+        // Items are removed from tabs which are not loaded once these are opened.
+        if ( !c || !c->isLoaded() )
+            continue;
+
+        const qint64 time = now - it.value() * msecsPerDay;
+        const int removed = c->removeItemsUnusedSince(time, maxExpiredItemsRemovedAtOnce);
+        if (removed > 0) {
+            COPYQ_LOG( QString("Tab \"%1\": Removed %2 expired items")
+                       .arg(it.key()).arg(removed) );
+        }
+
+        if (removed == maxExpiredItemsRemovedAtOnce)
+            removeNextBatch = true;
+    }
+
+    m_timerRemoveExpiredItems.start(removeNextBatch ? 0 : expiredItemsCheckIntervalMsec);
+}
+
 template <typename Receiver, typename ReturnType>
 QAction *MainWindow::addItemAction(int id, Receiver *receiver, ReturnType (Receiver::* slot)())
 {
@@ -1296,6 +1760,7 @@ void MainWindow::addCommandsToItemMenu(ClipboardBrowser *c)
 
     const auto data = addSelectionData(*c);
     const auto commands = commandsForMenu(data, c->tabName());
+    m_itemMenuMatchCommands.dataHash = menuFilterDataHash(data);
 
     QList<QKeySequence> usedShortcuts = m_disabledShortcuts;
     QList<QKeySequence> uniqueShortcuts;
@@ -1354,6 +1819,7 @@ void MainWindow::addCommandsToTrayMenu(const QVariantMap &clipboardData)
         data.insert( mimeWindowTitle, m_lastWindow->getTitle() );
 
     const auto commands = commandsForMenu(data, c->tabName());
+    m_trayMenuMatchCommands.dataHash = menuFilterDataHash(data);
 
     for (const auto &command : commands) {
         QString name = command.name;
@@ -1372,6 +1838,17 @@ void MainWindow::addCommandsToTrayMenu(const QVariantMap &clipboardData)
 void MainWindow::addMenuMatchCommand(MenuMatchCommands *menuMatchCommands, const QString &matchCommand, QAction *act)
 {
     if ( !matchCommand.isEmpty() ) {
+        // Avoid running filter again for the same data.
+        const auto key = qMakePair(matchCommand, menuMatchCommands->dataHash);
+        const auto it = m_menuMatchCommandResults.constFind(key);
+        if ( it != m_menuMatchCommandResults.constEnd() ) {
+            if ( !it.value() ) {
+                act->setDisabled(true);
+                act->deleteLater();
+            }
+            return;
+        }
+
         act->setDisabled(true);
         menuMatchCommands->matchCommands.append(matchCommand);
         menuMatchCommands->actions.append(act);
@@ -1534,7 +2011,9 @@ QAction *MainWindow::actionForMenuItem(int id, QWidget *parent, Qt::ShortcutCont
     return action;
 }
 
-void MainWindow::addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText)
+void MainWindow::addMenuItems(
+        TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText,
+        MenuSearchCache *searchCache)
 {
     WidgetSizeGuard sizeGuard(menu);
     menu->clearClipboardItems();
@@ -1543,16 +2022,92 @@ void MainWindow::addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCo
         return;
 
     const int current = c->currentIndex().row();
-    int itemCount = 0;
-    for ( int i = 0; i < c->length() && itemCount < maxItemCount; ++i ) {
-        const QModelIndex index = c->model()->index(i, 0);
-        if ( !searchText.isEmpty() ) {
-            const QString itemText = index.data(contentType::text).toString().toLower();
-            if ( !itemText.contains(searchText.toLower()) )
-                continue;
+    const bool fuzzy = ui->searchBar->isFuzzy();
+
+    // Extended search text can only match a subset of previously matching rows.
+    const bool refine = !searchText.isEmpty()
+            && searchCache->browser == c
+            && searchCache->fuzzy == fuzzy
+            && !searchCache->searchText.isEmpty()
+            && searchCache->scannedRowCount <= c->length()
+            && searchText.startsWith(searchCache->searchText, Qt::CaseInsensitive);
+
+    QVector<int> candidateRows;
+    int scannedRowCount = 0;
+    if (refine) {
+        candidateRows = searchCache->rows;
+        scannedRowCount = searchCache->scannedRowCount;
+    }
+
+    searchCache->browser = c;
+    searchCache->searchText = searchText;
+    searchCache->fuzzy = fuzzy;
+    searchCache->rows.clear();
+    searchCache->scannedRowCount = 0;
+
+    if (searchText.isEmpty()) {
+        for ( int i = 0; i < c->length() && i < maxItemCount; ++i ) {
+            const QModelIndex index = c->model()->index(i, 0);
+            menu->addClipboardItemAction(index, m_options.trayImages, i == current);
         }
-        menu->addClipboardItemAction(index, m_options.trayImages, i == current);
+        return;
+    }
+
+    if (fuzzy) {
+        // Show best matching items first.
+        QVector<QPair<int, int>> scoredRows;
+        const auto addScoredRow = [&](int row) {
+            const QModelIndex index = c->model()->index(row, 0);
+            const QString itemText = index.data(contentType::text).toString();
+            const int score = fuzzyMatchScore(searchText, itemText, Qt::CaseInsensitive);
+            if (score != -1) {
+                scoredRows.append( qMakePair(score, row) );
+                searchCache->rows.append(row);
+            }
+        };
+
+        for (const int row : candidateRows)
+            addScoredRow(row);
+        for ( int i = scannedRowCount; i < c->length(); ++i )
+            addScoredRow(i);
+        searchCache->scannedRowCount = c->length();
+
+        std::stable_sort( scoredRows.begin(), scoredRows.end(),
+            [](const QPair<int, int> &lhs, const QPair<int, int> &rhs) {
+                return lhs.first > rhs.first;
+            });
+
+        const int itemCount = qMin(maxItemCount, scoredRows.size());
+        for ( int i = 0; i < itemCount; ++i ) {
+            const int row = scoredRows[i].second;
+            const QModelIndex index = c->model()->index(row, 0);
+            menu->addClipboardItemAction(index, m_options.trayImages, row == current);
+        }
+        return;
+    }
+
+    int itemCount = 0;
+    const auto addMatchingRow = [&](int row) {
+        const QModelIndex index = c->model()->index(row, 0);
+        const QString itemText = index.data(contentType::text).toString();
+        if ( !itemText.contains(searchText, Qt::CaseInsensitive) )
+            return;
+        searchCache->rows.append(row);
+        menu->addClipboardItemAction(index, m_options.trayImages, row == current);
         ++itemCount;
+    };
+
+    for ( int i = 0; i < candidateRows.size() && itemCount < maxItemCount; ++i )
+        addMatchingRow(candidateRows[i]);
+
+    if (itemCount < maxItemCount) {
+        for ( ; scannedRowCount < c->length() && itemCount < maxItemCount; ++scannedRowCount )
+            addMatchingRow(scannedRowCount);
+        searchCache->scannedRowCount = scannedRowCount;
+    } else {
+        // Remaining candidates were not checked, so only rows before the
+        // last checked candidate are fully scanned.
+        searchCache->scannedRowCount = searchCache->rows.isEmpty() ? 0 : searchCache->rows.last() + 1;
     }
 }
 
@@ -1603,59 +2158,62 @@ bool MainWindow::toggleMenu(TrayMenu *menu)
     return toggleMenu(menu, QCursor::pos());
 }
 
-bool MainWindow::exportDataFrom(const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands)
+bool MainWindow::exportDataFrom(const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands, const QString &baseFileName)
 {
-    QFile file(fileName);
-    if ( !file.open(QIODevice::WriteOnly | QIODevice::Truncate) )
+    QSet<quint64> baseHashes;
+    QString base;
+    if ( !baseFileName.isEmpty() ) {
+        // Overwriting a file in the base chain would lose the items or create a cycle.
+        QStringList basePaths;
+        if ( !readExportedDataChainV4(baseFileName, &basePaths)
+             || !readExportedItemHashesV4(baseFileName, &baseHashes) )
+        {
+            log( QString("Failed to read base export \"%1\"").arg(baseFileName), LogError );
+            return false;
+        }
+
+        if ( basePaths.contains(exportedDataFilePath(fileName)) ) {
+            log( QString("Base export \"%1\" refers to exported file \"%2\"")
+                 .arg(baseFileName, fileName), LogError );
+            return false;
+        }
+
+        base = QFileInfo(fileName).absoluteDir().relativeFilePath(baseFileName);
+    }
+
+    // Replace the file only after everything is written.
+    QSaveFile file(fileName);
+    if ( !file.open(QIODevice::WriteOnly) )
         return false;
 
     QDataStream out(&file);
-    return exportDataV3(&out, tabs, exportConfiguration, exportCommands);
+    if ( !exportDataV4(&out, tabs, exportConfiguration, exportCommands, base, baseHashes) ) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
 }
 
-bool MainWindow::exportDataV3(QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands)
+bool MainWindow::exportDataV4(
+        QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+        const QString &base, const QSet<quint64> &baseHashes)
 {
     QVariantList tabsList;
+    QList<int> tabIndexes;
     for (const auto &tab : tabs) {
         const auto i = findTabIndex(tab);
         if (i == -1)
             continue;
 
-        auto placeholder = getPlaceholder(i);
-        const bool wasLoaded = placeholder->isDataLoaded();
-        auto c = placeholder->createBrowserAgain();
-        if (!c) {
-            log(QString("Failed to open tab \"%s\" for export").arg(tab), LogError);
-            return false;
-        }
-
-        const auto &tabName = c->tabName();
-
-        bool saved = false;
-        QByteArray tabBytes;
-        {
-            QDataStream tabOut(&tabBytes, QIODevice::WriteOnly);
-            tabOut.setVersion(QDataStream::Qt_4_7);
-            saved = serializeData(*c->model(), &tabOut);
-        }
-
-        if (!wasLoaded)
-            placeholder->expire();
-
-        if (!saved) {
-            log(QString("Failed to export tab \"%s\"").arg(tab), LogError);
-            return false;
-        }
-
-        const auto iconName = getIconNameForTabName(tabName);
-
         QVariantMap tabMap;
-        tabMap["name"] = tabName;
-        tabMap["data"] = tabBytes;
+        tabMap["name"] = tab;
+        const auto iconName = getIconNameForTabName(tab);
         if ( !iconName.isEmpty() )
             tabMap["icon"] = iconName;
 
         tabsList.append(tabMap);
+        tabIndexes.append(i);
     }
 
     QVariantMap settingsMap;
@@ -1687,6 +2245,8 @@ bool MainWindow::exportDataV3(QDataStream *out, const QStringList &tabs, bool ex
         settings.endArray();
     }
 
+    // Header contains everything needed to select what to import,
+    // tab items follow tab by tab and item by item.
     QVariantMap data;
     if ( !tabsList.isEmpty() )
         data["tabs"] = tabsList;
@@ -1694,20 +2254,42 @@ bool MainWindow::exportDataV3(QDataStream *out, const QStringList &tabs, bool ex
         data["settings"] = settingsMap;
     if ( !commandsList.isEmpty() )
         data["commands"] = commandsList;
+    if ( !base.isEmpty() )
+        data["base"] = base;
 
     out->setVersion(QDataStream::Qt_4_7);
-    (*out) << QByteArray("CopyQ v3");
+    (*out) << QByteArray("CopyQ v4");
     (*out) << data;
 
+    for (int i : tabIndexes) {
+        auto placeholder = getPlaceholder(i);
+        const bool wasLoaded = placeholder->isDataLoaded();
+        auto c = placeholder->createBrowserAgain();
+        if (!c) {
+            log(QString("Failed to open tab \"%s\" for export").arg(placeholder->tabName()), LogError);
+            return false;
+        }
+
+        const bool saved = serializeItemsV4(*c->model(), out, baseHashes);
+
+        if (!wasLoaded)
+            placeholder->expire();
+
+        if (!saved) {
+            log(QString("Failed to export tab \"%s\"").arg(placeholder->tabName()), LogError);
+            return false;
+        }
+    }
+
     return out->status() == QDataStream::Ok;
 }
 
 bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
 {
-    QByteArray header;
-    (*in) >> header;
-    if ( !header.startsWith("CopyQ v3") )
+    if (options == ImportOptions::Merge) {
+        log("Merging is not supported for data exported by older versions", LogError);
         return false;
+    }
 
     QVariantMap data;
     (*in) >> data;
@@ -1715,73 +2297,164 @@ bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
         return false;
 
     const auto tabsList = data.value("tabs").toList();
-
-    QStringList tabs;
-    tabs.reserve( tabsList.size() );
-    for (const auto &tabMapValue : tabsList) {
-        const auto tabMap = tabMapValue.toMap();
-        const auto oldTabName = tabMap["name"].toString();
-        tabs.append(oldTabName);
-    }
-
     const auto settingsMap = data.value("settings").toMap();
     const auto commandsList = data.value("commands").toList();
 
+    QStringList tabs = tabNamesFromList(tabsList);
     bool importConfiguration = true;
     bool importCommands = true;
-
-    if (options == ImportOptions::Select) {
-        ImportExportDialog importDialog(this);
-        importDialog.setWindowTitle( tr("CopyQ Options for Import") );
-        importDialog.setTabs(tabs);
-        importDialog.setHasConfiguration( !settingsMap.isEmpty() );
-        importDialog.setHasCommands( !commandsList.isEmpty() );
-        importDialog.setConfigurationEnabled(true);
-        importDialog.setCommandsEnabled(true);
-        if ( importDialog.exec() != QDialog::Accepted )
-            return true;
-
-        tabs = importDialog.selectedTabs();
-        importConfiguration = importDialog.isConfigurationEnabled();
-        importCommands = importDialog.isCommandsEnabled();
+    if ( options == ImportOptions::Select
+         && !selectDataToImport(&tabs, !settingsMap.isEmpty(), !commandsList.isEmpty(),
+                                &importConfiguration, &importCommands) )
+    {
+        return true;
     }
 
+    // Don't read items based on current value of "maxitems" option since
+    // the option can be later also imported.
+    const int maxItems = importConfiguration ? Config::maxItems : m_sharedData->maxItems;
+
     for (const auto &tabMapValue : tabsList) {
         const auto tabMap = tabMapValue.toMap();
         const auto oldTabName = tabMap["name"].toString();
         if ( !tabs.contains(oldTabName) )
             continue;
 
-        auto tabName = oldTabName;
-        renameToUnique( &tabName, ui->tabWidget->tabs() );
-
-        const auto iconName = tabMap.value("icon").toString();
-        if ( !iconName.isEmpty() )
-            setIconNameForTabName(tabName, iconName);
-
-        auto c = createTab(tabName, MatchExactTabName)->createBrowser();
-        if (!c) {
-            log(QString("Failed to create tab \"%s\" for import").arg(tabName), LogError);
+        auto c = createTabForImport(tabMap);
+        if (!c)
             return false;
-        }
 
         const auto tabBytes = tabMap.value("data").toByteArray();
         QDataStream tabIn(tabBytes);
         tabIn.setVersion(QDataStream::Qt_4_7);
 
-        // Don't read items based on current value of "maxitems" option since
-        // the option can be later also imported.
-        const int maxItems = importConfiguration ? Config::maxItems : m_sharedData->maxItems;
         if ( !deserializeData( c->model(), &tabIn, maxItems ) ) {
-            log(QString("Failed to import tab \"%s\"").arg(tabName), LogError);
+            log(QString("Failed to import tab \"%s\"").arg(c->tabName()), LogError);
             return false;
         }
 
-        const auto i = findTabIndex(tabName);
+        const auto i = findTabIndex(c->tabName());
         if (i != -1)
             getPlaceholder(i)->expire();
     }
 
+    if ( !importConfigurationAndCommands(
+             settingsMap, commandsList, importConfiguration, importCommands) )
+    {
+        return false;
+    }
+
+    return in->status() == QDataStream::Ok;
+}
+
+bool MainWindow::importDataV4(QDataStream *in, ImportOptions options)
+{
+    QVariantMap data;
+    (*in) >> data;
+    if ( in->status() != QDataStream::Ok )
+        return false;
+
+    // Incremental export contains only items missing in base export.
+    QString basePath;
+    const auto base = data.value("base").toString();
+    const auto file = qobject_cast<QFile*>(in->device());
+    if ( !base.isEmpty() && file )
+        basePath = QFileInfo(file->fileName()).absoluteDir().absoluteFilePath(base);
+
+    const auto tabsList = data.value("tabs").toList();
+    const auto settingsMap = data.value("settings").toMap();
+    const auto commandsList = data.value("commands").toList();
+
+    // Merging only synchronizes items.
+    const bool merge = options == ImportOptions::Merge;
+    QStringList tabs = tabNamesFromList(tabsList);
+    bool importConfiguration = !merge;
+    bool importCommands = !merge;
+    if ( options == ImportOptions::Select
+         && !selectDataToImport(&tabs, !settingsMap.isEmpty(), !commandsList.isEmpty(),
+                                &importConfiguration, &importCommands) )
+    {
+        return true;
+    }
+
+    // Don't read items based on current value of "maxitems" option since
+    // the option can be later also imported.
+    const int maxItems = importConfiguration ? Config::maxItems : m_sharedData->maxItems;
+
+    for (const auto &tabMapValue : tabsList) {
+        const auto tabMap = tabMapValue.toMap();
+        const auto oldTabName = tabMap["name"].toString();
+        if ( !tabs.contains(oldTabName) ) {
+            if ( !deserializeItemsV4(nullptr, in, 0, QString(), false) )
+                return false;
+            continue;
+        }
+
+        auto c = merge
+                ? createTab(oldTabName, MatchExactTabName)->createBrowser()
+                : createTabForImport(tabMap);
+        if (!c)
+            return false;
+
+        if ( !deserializeItemsV4(c->model(), in, maxItems, basePath, merge) ) {
+            log(QString("Failed to import tab \"%s\"").arg(c->tabName()), LogError);
+            return false;
+        }
+
+        const auto i = findTabIndex(c->tabName());
+        if (i != -1)
+            getPlaceholder(i)->expire();
+    }
+
+    if ( !importConfigurationAndCommands(
+             settingsMap, commandsList, importConfiguration, importCommands) )
+    {
+        return false;
+    }
+
+    return in->status() == QDataStream::Ok;
+}
+
+bool MainWindow::selectDataToImport(
+        QStringList *tabs, bool hasConfiguration, bool hasCommands,
+        bool *importConfiguration, bool *importCommands)
+{
+    ImportExportDialog importDialog(this);
+    importDialog.setWindowTitle( tr("CopyQ Options for Import") );
+    importDialog.setTabs(*tabs);
+    importDialog.setHasConfiguration(hasConfiguration);
+    importDialog.setHasCommands(hasCommands);
+    importDialog.setConfigurationEnabled(true);
+    importDialog.setCommandsEnabled(true);
+    if ( importDialog.exec() != QDialog::Accepted )
+        return false;
+
+    *tabs = importDialog.selectedTabs();
+    *importConfiguration = importDialog.isConfigurationEnabled();
+    *importCommands = importDialog.isCommandsEnabled();
+    return true;
+}
+
+ClipboardBrowser *MainWindow::createTabForImport(const QVariantMap &tabMap)
+{
+    auto tabName = tabMap["name"].toString();
+    renameToUnique( &tabName, ui->tabWidget->tabs() );
+
+    const auto iconName = tabMap.value("icon").toString();
+    if ( !iconName.isEmpty() )
+        setIconNameForTabName(tabName, iconName);
+
+    auto c = createTab(tabName, MatchExactTabName)->createBrowser();
+    if (!c)
+        log(QString("Failed to create tab \"%s\" for import").arg(tabName), LogError);
+
+    return c;
+}
+
+bool MainWindow::importConfigurationAndCommands(
+        const QVariantMap &settingsMap, const QVariantList &commandsList,
+        bool importConfiguration, bool importCommands)
+{
     if (importConfiguration) {
         // Configuration dialog shouldn't be open.
         if (cm) {
@@ -1829,7 +2502,7 @@ bool MainWindow::importDataV3(QDataStream *in, ImportOptions options)
         onCommandDialogSaved();
     }
 
-    return in->status() == QDataStream::Ok;
+    return true;
 }
 
 void MainWindow::updateCommands()
@@ -1837,13 +2510,18 @@ void MainWindow::updateCommands()
     m_automaticCommands.clear();
     m_menuCommands.clear();
     m_scriptCommands.clear();
+    m_menuMatchCommandResults.clear();
 
     QVector<Command> displayCommands;
+    QStringList persistentCommands;
 
     const auto commands = loadEnabledCommands();
     for (const auto &command : commands) {
         const auto type = command.type();
 
+        if ( command.persistent && (type & (CommandType::Automatic | CommandType::Display)) )
+            persistentCommands.append(command.cmd);
+
         if (type & CommandType::Automatic)
             m_automaticCommands.append(command);
 
@@ -1857,8 +2535,12 @@ void MainWindow::updateCommands()
             m_scriptCommands.append(command);
     }
 
+    m_actionHandler->setPersistentCommands(persistentCommands);
+
     if (m_displayCommands != displayCommands) {
         m_displayItemList.clear();
+        m_displayItemsToUpdate.clear();
+        m_sharedData->displayDataCache.clear();
         m_displayCommands = displayCommands;
         reloadBrowsers();
     }
@@ -2127,15 +2809,19 @@ void MainWindow::loadSettings()
     QSettings settings;
     m_sharedData->itemFactory->loadItemFactorySettings(&settings);
 
-    settings.beginGroup("Theme");
-    m_sharedData->theme.loadTheme(settings);
-    settings.endGroup();
+    {
+        StartupPhase phase("theme");
 
-    theme().decorateMainWindow(this);
-    ui->scrollAreaItemPreview->setObjectName("ClipboardBrowser");
-    theme().decorateItemPreview(ui->scrollAreaItemPreview);
+        settings.beginGroup("Theme");
+        m_sharedData->theme.loadTheme(settings);
+        settings.endGroup();
 
-    setUseSystemIcons( theme().useSystemIcons() );
+        theme().decorateMainWindow(this);
+        ui->scrollAreaItemPreview->setObjectName("ClipboardBrowser");
+        theme().decorateItemPreview(ui->scrollAreaItemPreview);
+
+        setUseSystemIcons( theme().useSystemIcons() );
+    }
 
     AppConfig appConfig;
 
@@ -2190,19 +2876,36 @@ void MainWindow::loadSettings()
     // shared data for browsers
     m_sharedData->editor = appConfig.option<Config::editor>();
     m_sharedData->maxItems = appConfig.option<Config::maxitems>();
+    m_sharedData->itemsInMemory = appConfig.option<Config::items_in_memory>();
+    m_sharedData->minItemBlobSize = appConfig.option<Config::item_data_threshold>();
+    m_actionHandler->setMaxBackgroundActions( appConfig.option<Config::max_background_commands>() );
+    m_options.maxLoadedTabs = appConfig.option<Config::max_loaded_tabs>();
     m_sharedData->textWrap = appConfig.option<Config::text_wrap>();
     m_sharedData->viMode = appConfig.option<Config::vi>();
     m_sharedData->saveOnReturnKey = !appConfig.option<Config::edit_ctrl_return>();
     m_sharedData->moveItemOnReturnKey = appConfig.option<Config::move>();
     m_sharedData->showSimpleItems = appConfig.option<Config::show_simple_items>();
     m_sharedData->minutesToExpire = appConfig.option<Config::expire_tab>();
+    m_sharedData->itemSizeHints.clear();
+
+    m_tabItemExpiryDays = tabItemExpiryDays();
+    if ( !m_tabItemExpiryDays.isEmpty() )
+        m_timerRemoveExpiredItems.start(expiredItemsCheckIntervalMsec);
 
     reloadBrowsers();
 
     // create tabs
     const QStringList tabs = savedTabs();
-    for (const auto &name : tabs)
+    const QStringList oldTabs = ui->tabWidget->tabs();
+    QStringList newTabs;
+    for (const auto &name : tabs) {
+        if ( !oldTabs.contains(name) )
+            newTabs.append(name);
         createTab(name, MatchExactTabName);
+    }
+
+    // Read items of new tabs in parallel so that opening the tabs is fast.
+    preloadItems(newTabs);
 
     Q_ASSERT( ui->tabWidget->count() > 0 );
     setTabs(tabs); // Save any tabs loaded from new tab files.
@@ -2448,6 +3151,8 @@ void MainWindow::tabChanged(int current, int)
 
     if (m_options.trayCurrentTab)
         updateTrayMenu();
+
+    m_timerPreloadTabs.start();
 }
 
 void MainWindow::saveTabPositions()
@@ -2460,6 +3165,34 @@ void MainWindow::doSaveTabPositions()
     setTabs( ui->tabWidget->tabs() );
 }
 
+void MainWindow::preloadTabs()
+{
+    const int current = ui->tabWidget->currentIndex();
+    if (current == -1)
+        return;
+
+    QStringList tabNames;
+    const auto addTab = [&](int index) {
+        const auto placeholder = getPlaceholder(index);
+        if ( placeholder && !placeholder->isDataLoaded() && !tabNames.contains(placeholder->tabName()) )
+            tabNames.append( placeholder->tabName() );
+    };
+
+    addTab(current + 1);
+    addTab(current - 1);
+
+    for (const auto &command : m_automaticCommands) {
+        if ( !command.outputTab.isEmpty() ) {
+            const int i = findTabIndexExactMatch(command.outputTab);
+            if (i != -1)
+                addTab(i);
+        }
+    }
+
+    // Only files are read in background, items are loaded when the tab is opened.
+    preloadItems(tabNames);
+}
+
 void MainWindow::tabsMoved(const QString &oldPrefix, const QString &newPrefix)
 {
     const QStringList tabs = ui->tabWidget->tabs();
@@ -2477,6 +3210,7 @@ void MainWindow::tabsMoved(const QString &oldPrefix, const QString &newPrefix)
         if ( (oldTabName == oldPrefix || oldTabName.startsWith(prefix)) && newPrefix != oldPrefix) {
             const QString newName = newPrefix + oldTabName.mid(oldPrefix.size());
             updateTabIcon(newName, placeholder->tabName());
+            updateTabItemExpiry(newName, placeholder->tabName());
             placeholder->setTabName(newName);
             auto c = placeholder->browser();
             if (c)
@@ -2558,6 +3292,11 @@ QVariantMap MainWindow::actionData(int id) const
     return m_actionHandler->actionData(id);
 }
 
+QString MainWindow::actionName(int id) const
+{
+    return m_actionHandler->actionName(id);
+}
+
 void MainWindow::setActionData(int id, const QVariantMap &data)
 {
     m_actionHandler->setActionData(id, data);
@@ -2600,6 +3339,38 @@ QString MainWindow::sessionIconTag() const
     return ::sessionIconTag();
 }
 
+QString MainWindow::memoryUsage() const
+{
+    QStringList result;
+
+    for ( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        const auto placeholder = getPlaceholder(i);
+        const auto c = placeholder->browser();
+        if (c) {
+            result.append( QString("tab %1:").arg(placeholder->tabName()) );
+            for ( const auto &line : c->memoryUsage().split('\n') )
+                result.append("  " + line);
+        } else {
+            result.append( QString("tab %1: not loaded").arg(placeholder->tabName()) );
+        }
+    }
+
+    result.append( QString("item size hints: %1").arg(m_sharedData->itemSizeHints.size()) );
+    result.append( QString("cached display data: %1").arg(m_sharedData->displayDataCache.size()) );
+
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if ( status.open(QIODevice::ReadOnly) ) {
+        for ( const auto &line : status.readAll().split('\n') ) {
+            if ( line.startsWith("VmRSS:") || line.startsWith("VmHWM:") )
+                result.append( QString::fromLatin1(line.simplified()) );
+        }
+    }
+#endif
+
+    return result.join('\n');
+}
+
 QColor MainWindow::sessionIconTagColor() const
 {
     return ::sessionIconTagColor();
@@ -2634,6 +3405,12 @@ bool MainWindow::setMenuItemEnabled(int actionId, int menuItemMatchCommandIndex,
     if (menuMatchCommands.actions.size() <= menuItemMatchCommandIndex)
         return false;
 
+    if ( m_menuMatchCommandResults.size() >= maxCachedMenuMatchCommandResults )
+        m_menuMatchCommandResults.clear();
+    const auto key = qMakePair(
+        menuMatchCommands.matchCommands[menuItemMatchCommandIndex], menuMatchCommands.dataHash);
+    m_menuMatchCommandResults.insert(key, enabled);
+
     auto action = menuMatchCommands.actions[menuItemMatchCommandIndex];
     if (!action)
         return true;
@@ -2666,7 +3443,16 @@ QVariantMap MainWindow::setDisplayData(int actionId, const QVariantMap &data)
     if (!m_currentDisplayAction || m_currentDisplayAction->id() != actionId)
         return QVariantMap();
 
-    m_currentDisplayItem.setData(data);
+    if ( !data.isEmpty() ) {
+        auto &displayDataCache = m_sharedData->displayDataCache;
+        if ( displayDataCache.size() >= maxCachedDisplayData )
+            displayDataCache.clear();
+        displayDataCache.insert( hash(m_currentDisplayItem.data()), data );
+
+        m_displayItemsToUpdate.append( qMakePair(m_currentDisplayItem, data) );
+        if ( !m_timerUpdateDisplayItems.isActive() )
+            m_timerUpdateDisplayItems.start();
+    }
 
     clearHiddenDisplayData();
 
@@ -2799,6 +3585,58 @@ QStringList MainWindow::tabs() const
     return ui->tabWidget->tabs();
 }
 
+QVector<ItemSearchHit> MainWindow::searchItems(const QRegExp &re)
+{
+    QVector<ItemSearchHit> hits;
+
+    for ( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        const auto placeholder = getPlaceholder(i);
+        if (!placeholder)
+            continue;
+
+        const auto c = placeholder->browser();
+        if ( c && c->isLoaded() ) {
+            addItemSearchHits(
+                        c->tabName(), *c->model(), c->searchCandidateRows(re), re,
+                        *m_sharedData->itemFactory, &hits );
+        } else if ( !searchItemsInTabFile(
+                        placeholder->tabName(), re, m_sharedData->itemFactory,
+                        m_sharedData->maxItems, &hits) )
+        {
+            COPYQ_LOG( QString("Tab \"%1\": Skipping search in tab which is not loaded")
+                       .arg(placeholder->tabName()) );
+        }
+    }
+
+    sortItemSearchHits(&hits);
+    return hits;
+}
+
+QVector<ItemSearchHit> MainWindow::findItems(quint64 hash)
+{
+    QVector<ItemSearchHit> hits;
+
+    for ( int i = 0; i < ui->tabWidget->count(); ++i ) {
+        const auto placeholder = getPlaceholder(i);
+        if (!placeholder)
+            continue;
+
+        const auto c = placeholder->browser();
+        if ( c && c->isLoaded() ) {
+            for ( const int row : c->findItems(hash) )
+                hits.append( ItemSearchHit{c->tabName(), row, hash, -1} );
+        } else if ( !findItemsInTabFile(
+                        placeholder->tabName(), hash, m_sharedData->itemFactory,
+                        m_sharedData->maxItems, &hits) )
+        {
+            COPYQ_LOG( QString("Tab \"%1\": Skipping search in tab which is not loaded")
+                       .arg(placeholder->tabName()) );
+        }
+    }
+
+    return hits;
+}
+
 ClipboardBrowser *MainWindow::getTabForMenu()
 {
     const auto i = findTabIndex(m_menuTabName);
@@ -2970,12 +3808,12 @@ void MainWindow::updateTrayMenuTimeout()
 
 void MainWindow::filterMenuItems(const QString &searchText)
 {
-    addMenuItems(m_menu, getTabForMenu(), m_menuMaxItemCount, searchText);
+    addMenuItems(m_menu, getTabForMenu(), m_menuMaxItemCount, searchText, &m_menuSearchCache);
 }
 
 void MainWindow::filterTrayMenuItems(const QString &searchText)
 {
-    addMenuItems(m_trayMenu, getTabForTrayMenu(), m_options.trayItems, searchText);
+    addMenuItems(m_trayMenu, getTabForTrayMenu(), m_options.trayItems, searchText, &m_trayMenuSearchCache);
     m_trayMenu->markItemInClipboard(m_clipboardData);
 }
 
@@ -3282,16 +4120,23 @@ bool MainWindow::importDataFrom(const QString &fileName, ImportOptions options)
     QDataStream in(&file);
     in.setVersion(QDataStream::Qt_4_7);
 
-    return importDataV3(&in, options);
+    QByteArray header;
+    in >> header;
+    if ( header.startsWith("CopyQ v4") )
+        return importDataV4(&in, options);
+    if ( header.startsWith("CopyQ v3") )
+        return importDataV3(&in, options);
+
+    return false;
 }
 
-bool MainWindow::exportAllData(const QString &fileName)
+bool MainWindow::exportAllData(const QString &fileName, const QString &baseFileName)
 {
     const auto tabs = ui->tabWidget->tabs();
     const bool exportConfiguration = true;
     const bool exportCommands = true;
 
-    return exportDataFrom(fileName, tabs, exportConfiguration, exportCommands);
+    return exportDataFrom(fileName, tabs, exportConfiguration, exportCommands, baseFileName);
 }
 
 bool MainWindow::importData()
@@ -3363,6 +4208,16 @@ void MainWindow::runInternalAction(Action *action)
     m_actionHandler->internalAction(action);
 }
 
+void MainWindow::queueInternalAction(Action *action)
+{
+    m_actionHandler->queueInternalAction(action);
+}
+
+PersistentProcess *MainWindow::persistentProcess(const QString &commandLine, QString *error)
+{
+    return m_actionHandler->persistentProcess(commandLine, error);
+}
+
 bool MainWindow::isInternalActionId(int id) const
 {
     return m_actionHandler->isInternalActionId(id);
@@ -3445,6 +4300,7 @@ void MainWindow::renameTab(const QString &name, int tabIndex)
     auto placeholder = getPlaceholder(tabIndex);
     if (placeholder) {
         updateTabIcon(name, placeholder->tabName());
+        updateTabItemExpiry(name, placeholder->tabName());
         placeholder->setTabName(name);
         ui->tabWidget->setTabName(tabIndex, name);
         saveTabPositions();
@@ -3542,6 +4398,13 @@ void MainWindow::setTabIcon(const QString &tabName, const QString &icon)
     }
 }
 
+void MainWindow::setTabItemExpiryDays(const QString &tabName, int days)
+{
+    setItemExpiryDaysForTabName(tabName, days);
+    m_tabItemExpiryDays = tabItemExpiryDays();
+    m_timerRemoveExpiredItems.start(0);
+}
+
 MainWindow::~MainWindow()
 {
     disconnect();
@@ -29,9 +29,12 @@
 
 #include "platform/platformnativeinterface.h"
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QModelIndex>
 #include <QPointer>
+#include <QPair>
+#include <QSet>
 #include <QSystemTrayIcon>
 #include <QTimer>
 #include <QVector>
@@ -47,11 +50,13 @@ class ConfigurationManager;
 class ItemFactory;
 class Notification;
 class NotificationDaemon;
+class PersistentProcess;
 class QAction;
 class QMimeData;
 class Theme;
 class TrayMenu;
 struct MainWindowOptions;
+struct ItemSearchHit;
 struct NotificationButton;
 
 Q_DECLARE_METATYPE(QPersistentModelIndex)
@@ -73,7 +78,9 @@ enum class ImportOptions {
     /// Select what to import/export in dialog.
     Select,
     /// Import/export everything without asking.
-    All
+    All,
+    /// Add only missing items to tabs with same name (configuration is not imported).
+    Merge
 };
 
 struct MainWindowOptions {
@@ -104,6 +111,8 @@ struct MainWindowOptions {
     bool trayItemPaste = true;
 
     QString clipboardTab;
+
+    int maxLoadedTabs = 0;
 };
 
 /**
@@ -207,6 +216,9 @@ public:
 
     void setTabIcon(const QString &tabName, const QString &icon);
 
+    /** Set number of days after which unused items are removed from tab (0 to disable). */
+    void setTabItemExpiryDays(const QString &tabName, int days);
+
     /**
      * Save all items in tab to file.
      * @return True only if all items were successfully saved.
@@ -233,9 +245,13 @@ public:
 
     /**
      * Export tabs, settings etc.
+     *
+     * If @a baseFileName is set, items already exported in that file
+     * (or in its base files) are only referenced.
+     *
      * @return True only if all data were successfully saved.
      */
-    bool exportAllData(const QString &fileName);
+    bool exportAllData(const QString &fileName, const QString &baseFileName = QString());
 
     /** Temporarily disable monitoring (i.e. adding new clipboard content to the first tab). */
     void disableClipboardStoring(bool disable);
@@ -245,11 +261,28 @@ public:
 
     QStringList tabs() const;
 
+    /**
+     * Return items matching @a re in all tabs, the most relevant first.
+     *
+     * Tabs which are not loaded yet are searched without creating them
+     * (see searchItemsInTabFile()).
+     */
+    QVector<ItemSearchHit> searchItems(const QRegExp &re);
+
+    /**
+     * Return items with data @a hash in all tabs.
+     *
+     * Tabs which are not loaded yet are searched using item hashes stored
+     * in tab files (see findItemsInTabFile()).
+     */
+    QVector<ItemSearchHit> findItems(quint64 hash);
+
     /// Used by config() command.
     QVariant config(const QStringList &nameValue);
 
     QVariantMap actionData(int id) const;
     void setActionData(int id, const QVariantMap &data);
+    QString actionName(int id) const;
 
     void setCommands(const QVector<Command> &commands);
 
@@ -263,6 +296,9 @@ public:
 
     QString sessionIconTag() const;
 
+    /** Return memory used by loaded tabs, shared caches and the process. */
+    QString memoryUsage() const;
+
     QColor sessionIconTagColor() const;
 
     void setTrayTooltip(const QString &tooltip);
@@ -353,8 +389,12 @@ public:
             const QModelIndex &outputIndex);
 
     void runInternalAction(Action *action);
+    void queueInternalAction(Action *action);
     bool isInternalActionId(int id) const;
 
+    /// Return program of a command which is kept running (see ActionHandler).
+    PersistentProcess *persistentProcess(const QString &commandLine, QString *error);
+
     void setClipboard(const QVariantMap &data, ClipboardMode mode);
     void setClipboardAndSelection(const QVariantMap &data);
     void moveToClipboard(ClipboardBrowser *c, int row);
@@ -445,6 +485,9 @@ private:
     void tabChanged(int current, int previous);
     void saveTabPositions();
     void doSaveTabPositions();
+
+    /// Read files of tabs likely to be opened next (adjacent or automatic command output tabs).
+    void preloadTabs();
     void tabsMoved(const QString &oldPrefix, const QString &newPrefix);
     void tabBarMenuRequested(QPoint pos, int tab);
     void tabTreeMenuRequested(QPoint pos, const QString &groupPath);
@@ -495,6 +538,9 @@ private:
 
     void onBrowserCreated(ClipboardBrowser *browser);
 
+    /// Unload least recently used tabs so a new one can be loaded (see Config::max_loaded_tabs).
+    void unloadLeastRecentlyUsedTabs();
+
     void onItemSelectionChanged(const ClipboardBrowser *browser);
     void onItemsChanged(const ClipboardBrowser *browser);
     void onInternalEditorStateChanged(const ClipboardBrowser *self);
@@ -523,14 +569,26 @@ private:
 
     struct MenuMatchCommands {
         int actionId = -1;
+        quint64 dataHash = 0;
         QStringList matchCommands;
         QVector< QPointer<QAction> > actions;
         QMenu *menu = nullptr;
     };
 
+    /// Rows matching the last menu search, refined as the search text grows.
+    struct MenuSearchCache {
+        const ClipboardBrowser *browser = nullptr;
+        QString searchText;
+        bool fuzzy = false;
+        /// Matching rows found in first scannedRowCount rows.
+        QVector<int> rows;
+        int scannedRowCount = 0;
+    };
+
     void runDisplayCommands();
 
     void clearHiddenDisplayData();
+    void updateDisplayItems();
 
     void reloadBrowsers();
 
@@ -587,6 +645,11 @@ private:
 
     void updateTabIcon(const QString &newName, const QString &oldName);
 
+    void updateTabItemExpiry(const QString &newName, const QString &oldName);
+
+    /// Remove items not used for longer than set for the tab (see setTabItemExpiryDays()).
+    void removeExpiredItems();
+
     template <typename Receiver, typename ReturnType>
     QAction *addItemAction(int id, Receiver *receiver, ReturnType (Receiver::* slot)());
 
@@ -616,14 +679,28 @@ private:
 
     QAction *actionForMenuItem(int id, QWidget *parent, Qt::ShortcutContext context);
 
-    void addMenuItems(TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText);
+    void addMenuItems(
+            TrayMenu *menu, ClipboardBrowser *c, int maxItemCount, const QString &searchText,
+            MenuSearchCache *searchCache);
     void activateMenuItem(ClipboardBrowser *c, const QVariantMap &data, bool omitPaste);
     bool toggleMenu(TrayMenu *menu, QPoint pos);
     bool toggleMenu(TrayMenu *menu);
 
-    bool exportDataFrom(const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands);
-    bool exportDataV3(QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands);
+    bool exportDataFrom(
+            const QString &fileName, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+            const QString &baseFileName = QString());
+    bool exportDataV4(
+            QDataStream *out, const QStringList &tabs, bool exportConfiguration, bool exportCommands,
+            const QString &base, const QSet<quint64> &baseHashes);
     bool importDataV3(QDataStream *in, ImportOptions options);
+    bool importDataV4(QDataStream *in, ImportOptions options);
+    bool selectDataToImport(
+            QStringList *tabs, bool hasConfiguration, bool hasCommands,
+            bool *importConfiguration, bool *importCommands);
+    ClipboardBrowser *createTabForImport(const QVariantMap &tabMap);
+    bool importConfigurationAndCommands(
+            const QVariantMap &settingsMap, const QVariantList &commandsList,
+            bool importConfiguration, bool importCommands);
 
     const Theme &theme() const;
 
@@ -656,12 +733,19 @@ private:
 
     QTimer m_timerUpdateFocusWindows;
     QTimer m_timerUpdateContextMenu;
+    QElapsedTimer m_lastContextMenuUpdate;
     QTimer m_timerUpdateTrayMenu;
     QTimer m_timerTrayAvailable;
     QTimer m_timerTrayIconSnip;
     QTimer m_timerSaveTabPositions;
+    QTimer m_timerPreloadTabs;
     QTimer m_timerHideWindowIfNotActive;
     QTimer m_timerRaiseLastWindowAfterMenuClosed;
+    QTimer m_timerRemoveExpiredItems;
+    QTimer m_timerUpdateDisplayItems;
+
+    /// Days after which unused items are removed for tab names.
+    QHash<QString, int> m_tabItemExpiryDays;
 
     NotificationDaemon *m_notifications;
 
@@ -691,11 +775,18 @@ private:
 
     QList<PersistentDisplayItem> m_displayItemList;
     PersistentDisplayItem m_currentDisplayItem;
+    QList< QPair<PersistentDisplayItem, QVariantMap> > m_displayItemsToUpdate;
     QPointer<Action> m_currentDisplayAction;
 
+    MenuSearchCache m_menuSearchCache;
+    MenuSearchCache m_trayMenuSearchCache;
+
     MenuMatchCommands m_trayMenuMatchCommands;
     MenuMatchCommands m_itemMenuMatchCommands;
 
+    /// Cached results of menu filter commands for command and data hash.
+    QHash<QPair<QString, quint64>, bool> m_menuMatchCommandResults;
+
     ClipboardManager m_clipboardManager;
 
     bool m_isActiveWindow = false;
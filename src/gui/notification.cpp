@@ -121,6 +121,13 @@ void Notification::setTitle(const QString &title)
 
 void Notification::setMessage(const QString &msg, Qt::TextFormat format)
 {
+    // Keep the label unchanged if notification is updated with same content.
+    if ( m_msgLabel->textFormat() == format && m_msgLabel->text() == msg
+         && m_msgLabel->isVisibleTo(this) == !msg.isEmpty() )
+    {
+        return;
+    }
+
     m_msgLabel->setTextFormat(format);
     m_msgLabel->setText(msg);
     m_msgLabel->setVisible( !msg.isEmpty() );
@@ -128,6 +135,10 @@ void Notification::setMessage(const QString &msg, Qt::TextFormat format)
 
 void Notification::setPixmap(const QPixmap &pixmap)
 {
+    const QPixmap *currentPixmap = m_msgLabel->pixmap();
+    if ( currentPixmap && currentPixmap->cacheKey() == pixmap.cacheKey() )
+        return;
+
     m_msgLabel->setPixmap(pixmap);
 }
 
@@ -199,6 +210,16 @@ void Notification::updateIcon()
     m_iconLabel->resize(pixmap.size());
 }
 
+void Notification::reset()
+{
+    m_timer.stop();
+    m_timer.setInterval(0);
+    setTitle(QString());
+    setMessage(QString());
+    setIcon(QString());
+    setButtons(NotificationButtons());
+}
+
 void Notification::adjust()
 {
     m_body->adjustSize();
@@ -47,6 +47,9 @@ public:
 
     void updateIcon();
 
+    /** Clear content and stop timer so the widget can be reused. */
+    void reset();
+
     void adjust();
 
     void mousePressEvent(QMouseEvent *event) override;
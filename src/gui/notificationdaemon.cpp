@@ -32,10 +32,15 @@
 #include <QPoint>
 #include <QVariant>
 
+#include <algorithm>
+
 namespace {
 
 const int notificationMarginPoints = 10;
 
+// Closed notification widgets kept for reuse.
+const int maxPooledNotifications = 4;
+
 int notificationMargin()
 {
     return pointsToPixels(notificationMarginPoints);
@@ -98,14 +103,26 @@ void NotificationDaemon::removeNotification(const QString &id)
 
 void NotificationDaemon::onNotificationClose(Notification *notification)
 {
-    for (auto it = std::begin(m_notifications); it != std::end(m_notifications); ++it) {
-        if (it->notification == notification) {
-            m_notifications.erase(it);
-            break;
-        }
+    const auto it = std::find_if(
+        std::begin(m_notifications), std::end(m_notifications),
+        [notification](const NotificationData &data) {
+            return data.notification == notification;
+        });
+
+    // Hiding notification below emits close signal again.
+    if ( it == std::end(m_notifications) )
+        return;
+
+    m_notifications.erase(it);
+
+    if (m_pool.size() < maxPooledNotifications) {
+        notification->hide();
+        notification->reset();
+        m_pool.append(notification);
+    } else {
+        notification->deleteLater();
     }
 
-    notification->deleteLater();
     updateNotifications();
 }
 
@@ -118,11 +135,22 @@ void NotificationDaemon::doUpdateNotifications()
     for (auto &notificationData : m_notifications) {
         auto notification = notificationData.notification;
         notification->setOpacity(m_opacity);
-        notification->setStyleSheet(m_styleSheet);
+        // Re-polishing the widgets is expensive.
+        if (notification->styleSheet() != m_styleSheet)
+            notification->setStyleSheet(m_styleSheet);
         notification->updateIcon();
         notification->adjust();
         notification->setMaximumSize( pointsToPixels(m_maximumWidthPoints), pointsToPixels(m_maximumHeightPoints) );
 
+        // Keep new notifications hidden until there is space for them on screen.
+        if ( !notification->isVisible() ) {
+            const bool fits = (m_position & Top)
+                    ? y + notification->height() <= screen.bottom()
+                    : y - notification->height() >= screen.top();
+            if (!fits)
+                continue;
+        }
+
         int x;
         if (m_position & Left)
             x = offsetX();
@@ -162,12 +190,16 @@ Notification *NotificationDaemon::createNotification(const QString &id)
         notification = findNotification(id);
 
     if (notification == nullptr) {
-        notification = new Notification();
-        connect(this, &QObject::destroyed, notification, &QObject::deleteLater);
-        connect( notification, &Notification::closeNotification,
-                 this, &NotificationDaemon::onNotificationClose );
-        connect( notification, &Notification::buttonClicked,
-                 this, &NotificationDaemon::notificationButtonClicked );
+        if ( !m_pool.isEmpty() ) {
+            notification = m_pool.takeLast();
+        } else {
+            notification = new Notification();
+            connect(this, &QObject::destroyed, notification, &QObject::deleteLater);
+            connect( notification, &Notification::closeNotification,
+                     this, &NotificationDaemon::onNotificationClose );
+            connect( notification, &Notification::buttonClicked,
+                     this, &NotificationDaemon::notificationButtonClicked );
+        }
 
         m_notifications.append(NotificationData{id, notification});
     }
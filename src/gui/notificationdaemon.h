@@ -86,6 +86,7 @@ private:
 
     Position m_position;
     QList<NotificationData> m_notifications;
+    QList<Notification*> m_pool;
     qreal m_opacity;
     int m_horizontalOffsetPoints;
     int m_verticalOffsetPoints;
@@ -22,6 +22,7 @@
 
 #include "common/action.h"
 #include "common/shortcuts.h"
+#include "common/timer.h"
 #include "gui/iconfont.h"
 #include "gui/icons.h"
 #include "gui/windowgeometryguard.h"
@@ -36,6 +37,7 @@
 namespace {
 
 const int maxNumberOfProcesses = 100;
+const int updateTableDelayMsec = 100;
 const auto dateTimeFormat = "yyyy-MM-dd HH:mm:ss.zzz";
 
 namespace statusItemData {
@@ -118,6 +120,12 @@ public:
     {
     }
 
+    TableRow(QTableWidgetItem *statusItem, QTableWidget *table)
+        : m_table(table)
+        , m_item(statusItem)
+    {
+    }
+
     QTableWidgetItem *item(int column)
     {
         return m_table->item(row(), column);
@@ -162,6 +170,8 @@ ProcessManagerDialog::ProcessManagerDialog(QWidget *parent)
     connect( act, &QAction::triggered,
              this, &ProcessManagerDialog::onDeleteShortcut );
     addAction(act);
+
+    initSingleShotTimer( &m_timerUpdateTable, updateTableDelayMsec, this, &ProcessManagerDialog::resizeTableColumns );
 }
 
 ProcessManagerDialog::~ProcessManagerDialog()
@@ -169,8 +179,36 @@ ProcessManagerDialog::~ProcessManagerDialog()
     delete ui;
 }
 
+void ProcessManagerDialog::actionQueued(Action *action)
+{
+    actionAboutToStart(action);
+
+    auto tableRow = tableRowForAction(action);
+    tableRow.item(tableCommandsColumns::status)->setText(tr("Queued"));
+
+    // Action cannot be terminated before it starts.
+    QToolButton *button = tableRow.button(tableCommandsColumns::action);
+    if (button)
+        button->setEnabled(false);
+}
+
 void ProcessManagerDialog::actionAboutToStart(Action *action)
 {
+    // Queued action is already listed.
+    if ( m_statusItems.contains(action) ) {
+        QTableWidget *t = ui->tableWidgetCommands;
+        SortingGuard sortGuard(t);
+
+        auto tableRow = tableRowForAction(action);
+        tableRow.item(tableCommandsColumns::status)->setText(tr("Starting"));
+        tableRow.item(tableCommandsColumns::beginTime)->setText(currentTime());
+        QToolButton *button = tableRow.button(tableCommandsColumns::action);
+        if (button)
+            button->setEnabled(true);
+        updateTable();
+        return;
+    }
+
     const QString name = action->name();
     const QString command = action->commandLine();
 
@@ -182,16 +220,7 @@ void ProcessManagerDialog::actionAboutToStart(Action *action)
     QTableWidgetItem *statusItem = tableRow.item(tableCommandsColumns::status);
     statusItem->setData(statusItemData::actionId, id);
     statusItem->setData(statusItemData::status, QProcess::Starting);
-
-    // Limit rows in table.
-    QTableWidget *t = ui->tableWidgetCommands;
-    if (t->rowCount() > maxNumberOfProcesses) {
-        for ( int row = t->rowCount() - 1;
-              row >= 0 && (!removeIfNotRunning(row) || t->rowCount() > maxNumberOfProcesses);
-              --row )
-        {
-        }
-    }
+    m_statusItems.insert(action, statusItem);
 }
 
 void ProcessManagerDialog::actionStarted(Action *action)
@@ -233,6 +262,12 @@ void ProcessManagerDialog::actionFinished(Action *action)
     if (days)
         endTimeText.prepend( QString("%1d ").arg(days) );
     tableRow.item(tableCommandsColumns::endTime)->setText(endTimeText);
+    tableRow.item(tableCommandsColumns::endTime)->setToolTip(
+        tr("Started in %1 ms, finished in %2 ms\nInput: %3 bytes\nOutput: %4 bytes")
+            .arg(action->startLatencyMs())
+            .arg(action->elapsedMs())
+            .arg(action->bytesWritten())
+            .arg(action->bytesRead()) );
 
     if (button) {
         button->setToolTip( tr("Remove") );
@@ -246,17 +281,19 @@ void ProcessManagerDialog::actionFinished(Action *action)
 
     // Reset action ID so it can be used again.
     tableRow.item(tableCommandsColumns::status)->setData(statusItemData::actionId, 0);
+    m_statusItems.remove(action);
 }
 
 void ProcessManagerDialog::actionFinished(const QString &name)
 {
-    createTableRow(name);
+    auto tableRow = createTableRow(name);
+    tableRow.item(tableCommandsColumns::status)->setData(statusItemData::status, QProcess::NotRunning);
 }
 
 void ProcessManagerDialog::showEvent(QShowEvent *event)
 {
     QDialog::showEvent(event);
-    updateTable();
+    resizeTableColumns();
 }
 
 void ProcessManagerDialog::onRemoveActionButtonClicked()
@@ -290,15 +327,10 @@ void ProcessManagerDialog::onDeleteShortcut()
 ProcessManagerDialog::TableRow ProcessManagerDialog::tableRowForAction(Action *action) const
 {
     QTableWidget *t = ui->tableWidgetCommands;
-    const auto id = actionId(action);
-    for (int row = 0; row < t->rowCount(); ++row) {
-        const auto item = t->item(row, tableCommandsColumns::status);
-        if ( item->data(statusItemData::actionId) == id )
-            return TableRow(row, t);
-    }
-
-    Q_ASSERT(false);
-    return TableRow(0, t);
+    const auto statusItem = m_statusItems.value(action);
+    Q_ASSERT(statusItem);
+    Q_ASSERT(statusItem->data(statusItemData::actionId) == actionId(action));
+    return statusItem ? TableRow(statusItem, t) : TableRow(0, t);
 }
 
 ProcessManagerDialog::TableRow ProcessManagerDialog::tableRowForActionButton(QObject *button) const
@@ -323,8 +355,27 @@ bool ProcessManagerDialog::removeIfNotRunning(int row)
     return true;
 }
 
+void ProcessManagerDialog::limitRows()
+{
+    // Remove oldest finished actions.
+    QTableWidget *t = ui->tableWidgetCommands;
+    for ( int row = t->rowCount() - 1;
+          row >= 0 && t->rowCount() > maxNumberOfProcesses;
+          --row )
+    {
+        removeIfNotRunning(row);
+    }
+}
+
 void ProcessManagerDialog::updateTable()
 {
+    if ( isVisible() && !m_timerUpdateTable.isActive() )
+        m_timerUpdateTable.start();
+}
+
+void ProcessManagerDialog::resizeTableColumns()
+{
+    m_timerUpdateTable.stop();
     if (isVisible())
         ui->tableWidgetCommands->resizeColumnsToContents();
 }
@@ -342,6 +393,7 @@ ProcessManagerDialog::TableRow ProcessManagerDialog::createTableRow(const QStrin
     t->setItem( 0, tableCommandsColumns::beginTime, new QTableWidgetItem(currentTime()) );
     t->setItem( 0, tableCommandsColumns::endTime, new QTableWidgetItem(action ? "-" : "00:00:00.000") );
     t->setCellWidget( 0, tableCommandsColumns::action, createRemoveButton(action) );
+    limitRows();
     updateTable();
 
     return TableRow(0, t);
@@ -21,8 +21,11 @@
 #define PROCESSMANAGERDIALOG_H
 
 #include <QDialog>
+#include <QHash>
+#include <QTimer>
 
 class Action;
+class QTableWidgetItem;
 
 namespace Ui {
 class ProcessManagerDialog;
@@ -37,6 +40,8 @@ public:
 
     ~ProcessManagerDialog();
 
+    /// Lists action waiting to be started (see actionAboutToStart()).
+    void actionQueued(Action *action);
     void actionAboutToStart(Action *action);
     void actionStarted(Action *action);
     void actionFinished(Action *action);
@@ -53,11 +58,19 @@ private:
     TableRow tableRowForAction(Action *action) const;
     TableRow tableRowForActionButton(QObject *button) const;
     bool removeIfNotRunning(int row);
+    void limitRows();
     void updateTable();
+    void resizeTableColumns();
     TableRow createTableRow(const QString &name, Action *action = nullptr);
     QWidget *createRemoveButton(Action *action = nullptr);
 
     Ui::ProcessManagerDialog *ui;
+
+    /// Status items of running actions (see actionAboutToStart()).
+    QHash<const Action*, QTableWidgetItem*> m_statusItems;
+
+    /// Resizing columns is postponed so many actions cause only single update.
+    QTimer m_timerUpdateTable;
 };
 
 #endif // PROCESSMANAGERDIALOG_H
@@ -126,36 +126,21 @@ ShortcutsWidget::~ShortcutsWidget()
 
 void ShortcutsWidget::loadShortcuts(const QSettings &settings)
 {
-    MenuItems items = menuItems();
-    ::loadShortcuts(&items, settings);
+    m_pendingMenuItems = menuItems();
+    ::loadShortcuts(&m_pendingMenuItems, settings);
+    m_pendingCommands.clear();
+    m_rowsPending = true;
 
-    m_actions.clear();
-    m_shortcuts.clear();
-
-    QTableWidget *table = ui->tableWidget;
-    while (table->rowCount() > 0)
-        table->removeRow(0);
-
-    for (const auto &item : items) {
-        MenuAction action;
-        action.iconName = item.iconName;
-        action.iconId = item.iconId;
-        action.text = item.text;
-        action.settingsKey = item.settingsKey;
-
-        addShortcutRow(action);
-
-        action.shortcutButton->setDefaultShortcut(item.defaultShortcut);
-        for (const auto &shortcut : item.shortcuts)
-            action.shortcutButton->addShortcut(shortcut);
-    }
-
-    addCommands( loadAllCommands() );
-    addCommands( predefinedCommands() );
+    if ( isVisible() )
+        createShortcutRows();
 }
 
 void ShortcutsWidget::saveShortcuts(QSettings *settings)
 {
+    // Nothing could have been changed if the rows were not created yet.
+    if (m_rowsPending)
+        return;
+
     auto commands = loadAllCommands();
     bool needSaveCommands = false;
 
@@ -197,24 +182,17 @@ void ShortcutsWidget::saveShortcuts(QSettings *settings)
 
 void ShortcutsWidget::addCommands(const QVector<Command> &commands)
 {
-    for ( const auto &command : commands ) {
-        if ( canAddCommandAction(command, m_actions) ) {
-            MenuAction action;
-            action.iconId = toIconId(command.icon);
-            action.text = command.name;
-            action.command = command;
-            addShortcutRow(action);
-
-            if (command.enable) {
-                for (const auto &shortcut : shortcuts(command))
-                    action.shortcutButton->addShortcut(shortcut);
-            }
-        }
-    }
+    if (m_rowsPending)
+        m_pendingCommands += commands;
+    else
+        addCommandRows(commands);
 }
 
 void ShortcutsWidget::showEvent(QShowEvent *event)
 {
+    if (m_rowsPending)
+        createShortcutRows();
+
     for (auto &action : m_actions) {
         if ( action.tableItem->icon().isNull() )
             action.tableItem->setIcon( getIcon(action.iconName, action.iconId) );
@@ -312,3 +290,54 @@ void ShortcutsWidget::addShortcutRow(MenuAction &action)
     connect( action.shortcutButton, &ShortcutButton::shortcutRemoved,
              this, &ShortcutsWidget::onShortcutRemoved );
 }
+
+void ShortcutsWidget::addCommandRows(const QVector<Command> &commands)
+{
+    for ( const auto &command : commands ) {
+        if ( canAddCommandAction(command, m_actions) ) {
+            MenuAction action;
+            action.iconId = toIconId(command.icon);
+            action.text = command.name;
+            action.command = command;
+            addShortcutRow(action);
+
+            if (command.enable) {
+                for (const auto &shortcut : shortcuts(command))
+                    action.shortcutButton->addShortcut(shortcut);
+            }
+        }
+    }
+}
+
+void ShortcutsWidget::createShortcutRows()
+{
+    m_rowsPending = false;
+
+    m_actions.clear();
+    m_shortcuts.clear();
+
+    QTableWidget *table = ui->tableWidget;
+    while (table->rowCount() > 0)
+        table->removeRow(0);
+
+    for (const auto &item : m_pendingMenuItems) {
+        MenuAction action;
+        action.iconName = item.iconName;
+        action.iconId = item.iconId;
+        action.text = item.text;
+        action.settingsKey = item.settingsKey;
+
+        addShortcutRow(action);
+
+        action.shortcutButton->setDefaultShortcut(item.defaultShortcut);
+        for (const auto &shortcut : item.shortcuts)
+            action.shortcutButton->addShortcut(shortcut);
+    }
+
+    addCommandRows( loadAllCommands() );
+    addCommandRows( predefinedCommands() );
+    addCommandRows(m_pendingCommands);
+
+    m_pendingMenuItems.clear();
+    m_pendingCommands.clear();
+}
@@ -21,6 +21,7 @@
 #define SHORTCUTSWIDGET_H
 
 #include "common/command.h"
+#include "gui/menuitems.h"
 
 #include <QIcon>
 #include <QTimer>
@@ -59,7 +60,11 @@ public:
 
     ~ShortcutsWidget();
 
-    /** Load shortcuts from settings file. */
+    /**
+     * Load shortcuts from settings file.
+     *
+     * Table rows are created only once the widget is shown.
+     */
     void loadShortcuts(const QSettings &settings);
     /** Save shortcuts to settings file. */
     void saveShortcuts(QSettings *settings);
@@ -80,12 +85,18 @@ private:
     void onLineEditFilterTextChanged(const QString &text);
 
     void addShortcutRow(MenuAction &action);
+    void addCommandRows(const QVector<Command> &commands);
+    void createShortcutRows();
 
     Ui::ShortcutsWidget *ui;
     QTimer m_timerCheckAmbiguous;
 
     QVector<MenuAction> m_actions;
     QList<QKeySequence> m_shortcuts;
+
+    bool m_rowsPending = false;
+    MenuItems m_pendingMenuItems;
+    QVector<Command> m_pendingCommands;
 };
 
 #endif // SHORTCUTSWIDGET_H
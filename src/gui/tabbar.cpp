@@ -93,6 +93,8 @@ void TabBar::setTabItemCount(const QString &tabName, const QString &itemCount)
         return;
 
     QWidget *tabCountLabel = tabButton(i, QTabBar::RightSide);
+    if ( tabCountLabel && tabCountLabel->property("text").toString() == itemCount )
+        return;
 
     if ( itemCount.isEmpty() ) {
         if (tabCountLabel) {
@@ -141,8 +143,9 @@ void TabBar::moveTab(int from, int to)
 
 void TabBar::updateTabIcons()
 {
+    const QHash<QString, QString> icons = tabIcons();
     for (int i = 0; i < count(); ++i)
-        ::updateTabIcon(i, this);
+        setTabIcon( i, iconFromTabIconName(icons.value(tabName(i))) );
 }
 
 void TabBar::nextTab()
@@ -30,25 +30,6 @@
 #include <QHash>
 #include <QIcon>
 
-namespace {
-
-QHash<QString, QString> tabIcons()
-{
-    QHash<QString, QString> icons;
-
-    Settings settings;
-    const int size = settings.beginReadArray("Tabs");
-    for(int i = 0; i < size; ++i) {
-        settings.setArrayIndex(i);
-        icons.insert(settings.value("name").toString(),
-                     settings.value("icon").toString());
-    }
-
-    return icons;
-}
-
-} // namespace
-
 QStringList tabs()
 {
     QStringList tabs = AppConfig().option<Config::tabs>();
@@ -87,6 +68,21 @@ QStringList savedTabs()
     return tabs;
 }
 
+QHash<QString, QString> tabIcons()
+{
+    QHash<QString, QString> icons;
+
+    Settings settings;
+    const int size = settings.beginReadArray("Tabs");
+    for(int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        icons.insert(settings.value("name").toString(),
+                     settings.value("icon").toString());
+    }
+
+    return icons;
+}
+
 QString getIconNameForTabName(const QString &tabName)
 {
     Settings settings;
@@ -120,8 +116,50 @@ void setIconNameForTabName(const QString &name, const QString &icon)
 
 QIcon getIconForTabName(const QString &tabName)
 {
-    const QString fileName = getIconNameForTabName(tabName);
-    return fileName.isEmpty() ? QIcon() : iconFromFile(fileName);
+    return iconFromTabIconName( getIconNameForTabName(tabName) );
+}
+
+QIcon iconFromTabIconName(const QString &iconName)
+{
+    return iconName.isEmpty() ? QIcon() : iconFromFile(iconName);
+}
+
+QHash<QString, int> tabItemExpiryDays()
+{
+    QHash<QString, int> expiryDays;
+
+    Settings settings;
+    const int size = settings.beginReadArray("TabItemExpiry");
+    for(int i = 0; i < size; ++i) {
+        settings.setArrayIndex(i);
+        const int days = settings.value("days").toInt();
+        if (days > 0)
+            expiryDays.insert(settings.value("name").toString(), days);
+    }
+
+    return expiryDays;
+}
+
+void setItemExpiryDaysForTabName(const QString &name, int days)
+{
+    QHash<QString, int> expiryDays = tabItemExpiryDays();
+    if (days > 0)
+        expiryDays[name] = days;
+    else
+        expiryDays.remove(name);
+
+    Settings settings;
+    settings.remove("TabItemExpiry");
+    settings.beginWriteArray( "TabItemExpiry", expiryDays.size() );
+    int i = 0;
+
+    for (auto it = expiryDays.constBegin(); it != expiryDays.constEnd(); ++it) {
+        settings.setArrayIndex(i++);
+        settings.setValue("name", it.key());
+        settings.setValue("days", it.value());
+    }
+
+    settings.endArray();
 }
 
 void initTabComboBox(QComboBox *comboBox)
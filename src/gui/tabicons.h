@@ -19,6 +19,8 @@
 #ifndef TABICONS_H
 #define TABICONS_H
 
+#include <QHash>
+
 class QIcon;
 class QComboBox;
 class QString;
@@ -32,12 +34,25 @@ void setTabs(const QStringList &tabs);
 /** Return list of saved tabs (ordered by "tabs" option if possible). */
 QStringList savedTabs();
 
+/** Return icon names for all tabs with icon set (tab name -> icon name). */
+QHash<QString, QString> tabIcons();
+
 QString getIconNameForTabName(const QString &tabName);
 
 void setIconNameForTabName(const QString &name, const QString &icon);
 
 QIcon getIconForTabName(const QString &tabName);
 
+QIcon iconFromTabIconName(const QString &iconName);
+
+/**
+ * Return number of days after which unused items are removed for each tab
+ * (only tabs with the limit set are included).
+ */
+QHash<QString, int> tabItemExpiryDays();
+
+void setItemExpiryDaysForTabName(const QString &name, int days);
+
 void initTabComboBox(QComboBox *comboBox);
 
 void setDefaultTabItemCounterStyle(QWidget *widget);
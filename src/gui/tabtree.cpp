@@ -40,7 +40,8 @@ namespace {
 
 enum {
     DataText = Qt::UserRole,
-    DataItemCount
+    DataItemCount,
+    DataIconName
 };
 
 void updateItemSize(QTreeWidgetItem *item)
@@ -312,6 +313,7 @@ void TabTree::setTabName(int tabIndex, const QString &tabName)
 
     // Remove old item if it's an empty group.
     m_tabs.removeOne(item);
+    invalidateTabIndexCache();
     if ( isEmptyTabGroup(item) )
         deleteItem(item);
 
@@ -332,6 +334,9 @@ void TabTree::setTabItemCount(const QString &tabName, const QString &itemCount)
     if (!item)
         return;
 
+    if ( item->data(0, DataItemCount).toString() == itemCount )
+        return;
+
     item->setData(0, DataItemCount, itemCount);
 
     ItemLabel *label = itemLabel(item);
@@ -348,8 +353,9 @@ void TabTree::updateTabIcon(const QString &tabName)
     if (!item)
         return;
 
-    const QIcon icon = getIconForTabName(tabName);
-    item->setIcon(0, icon);
+    const QString iconName = getIconNameForTabName(tabName);
+    item->setData(0, DataIconName, iconName);
+    item->setIcon(0, iconFromTabIconName(iconName));
     updateItemSize(item);
     updateSize();
 }
@@ -390,14 +396,17 @@ void TabTree::insertTab(int index, const QString &path)
         item->setExpanded(true);
         item->setData(0, DataText, text);
 
-        const QIcon icon = getIconForTabName( getTabPath(item) );
-        item->setIcon(0, icon);
+        const QString iconName = getIconNameForTabName( getTabPath(item) );
+        item->setData(0, DataIconName, iconName);
+        item->setIcon(0, iconFromTabIconName(iconName));
 
         labelItem(item);
     }
 
     Q_ASSERT(item != nullptr);
     m_tabs.insert(index, item);
+    invalidateTabIndexCache();
+    invalidateTabPathCache();
 
     if (selectTab)
         setCurrentItem(item);
@@ -412,6 +421,7 @@ void TabTree::removeTab(int index)
         return;
 
     m_tabs.removeOne(item);
+    invalidateTabIndexCache();
     if (item->childCount() == 0)
         deleteItem(item);
 
@@ -429,6 +439,7 @@ void TabTree::moveTab(int from, int to)
 
     m_tabs.removeOne(item);
     m_tabs.insert(to, item);
+    invalidateTabIndexCache();
 }
 
 void TabTree::updateCollapsedTabs(QStringList *tabs) const
@@ -452,8 +463,23 @@ void TabTree::setCollapsedTabs(const QStringList &collapsedPaths)
 
 void TabTree::updateTabIcons()
 {
-    for ( QTreeWidgetItemIterator it(topLevelItem(0)); *it; ++it )
-        updateTabIcon( getTabPath(*it) );
+    const QHash<QString, QString> icons = tabIcons();
+    bool changed = false;
+
+    for ( QTreeWidgetItemIterator it(topLevelItem(0)); *it; ++it ) {
+        QTreeWidgetItem *item = *it;
+        const QString iconName = icons.value( getTabPath(item) );
+        if ( item->data(0, DataIconName).toString() == iconName )
+            continue;
+
+        item->setData(0, DataIconName, iconName);
+        item->setIcon(0, iconFromTabIconName(iconName));
+        updateItemSize(item);
+        changed = true;
+    }
+
+    if (changed)
+        updateSize();
 }
 
 void TabTree::nextTab()
@@ -507,14 +533,29 @@ QTreeWidgetItem *TabTree::findTreeItem(int index) const
 
 QTreeWidgetItem *TabTree::findTreeItem(const QString &path) const
 {
-    QStringList pathComponents = path.split('/');
-    QTreeWidgetItem *parentItem = findLastTreeItem(*this, &pathComponents);
-    return pathComponents.isEmpty() ? parentItem : nullptr;
+    if ( m_tabPathCache.isEmpty() ) {
+        for ( QTreeWidgetItemIterator it(topLevelItem(0)); *it; ++it ) {
+            const QString itemPath = getTabPath(*it);
+            if ( !m_tabPathCache.contains(itemPath) )
+                m_tabPathCache.insert(itemPath, *it);
+        }
+    }
+
+    return m_tabPathCache.value(path);
 }
 
 int TabTree::getTabIndex(const QTreeWidgetItem *item) const
 {
-    return (item == nullptr) ? -1 : m_tabs.indexOf( const_cast<QTreeWidgetItem*>(item) );
+    if (item == nullptr)
+        return -1;
+
+    if ( m_tabIndexCache.isEmpty() ) {
+        m_tabIndexCache.reserve( m_tabs.size() );
+        for (int i = 0; i < m_tabs.size(); ++i)
+            m_tabIndexCache.insert(m_tabs[i], i);
+    }
+
+    return m_tabIndexCache.value(item, -1);
 }
 
 QString TabTree::getTabPath(const QTreeWidgetItem *item) const
@@ -591,6 +632,7 @@ void TabTree::dropEvent(QDropEvent *event)
 
         blockSignals(true);
         QTreeWidget::dropEvent(event);
+        invalidateTabPathCache();
         setCurrentItem(current);
         setItemWidgetSelected(current);
         blockSignals(false);
@@ -609,6 +651,7 @@ void TabTree::dropEvent(QDropEvent *event)
             renameToUnique(&newPrefix, uniqueTabNames);
             const QString text = newPrefix.mid( newPrefix.lastIndexOf(QChar('/')) + 1 );
             current->setData(0, DataText, text);
+            invalidateTabPathCache();
             labelItem(current);
         }
 
@@ -629,6 +672,7 @@ void TabTree::dropEvent(QDropEvent *event)
         }
 
         m_tabs = std::move(newTabs);
+        invalidateTabIndexCache();
         emit tabsMoved(oldPrefix, newPrefix, indexes);
 
         updateSize();
@@ -724,4 +768,15 @@ void TabTree::deleteItem(QTreeWidgetItem *item)
     }
 
     delete item;
+    invalidateTabPathCache();
+}
+
+void TabTree::invalidateTabIndexCache()
+{
+    m_tabIndexCache.clear();
+}
+
+void TabTree::invalidateTabPathCache()
+{
+    m_tabPathCache.clear();
 }
@@ -22,6 +22,7 @@
 
 #include "gui/tabswidgetinterface.h"
 
+#include <QHash>
 #include <QList>
 #include <QString>
 #include <QTimer>
@@ -106,8 +107,15 @@ private:
     void requestTabMenu(QPoint itemPosition, QPoint menuPosition);
     void deleteItem(QTreeWidgetItem *item);
 
+    /// Drops cached lookups, these are rebuilt on first use.
+    void invalidateTabIndexCache();
+    void invalidateTabPathCache();
+
     QTimer m_timerUpdate;
     QList<QTreeWidgetItem*> m_tabs;
+
+    mutable QHash<const QTreeWidgetItem*, int> m_tabIndexCache;
+    mutable QHash<QString, QTreeWidgetItem*> m_tabPathCache;
 };
 
 #endif // TABTREE_H
@@ -22,6 +22,7 @@
 #include "tabtree.h"
 
 #include "common/config.h"
+#include "common/timer.h"
 
 #include <QAction>
 #include <QBoxLayout>
@@ -35,6 +36,9 @@
 
 namespace {
 
+/// Minimum interval for updating item counters in tabs.
+const int updateItemCountersIntervalMs = 100;
+
 QString getTabWidgetConfigurationFilePath()
 {
     return getConfigurationFilePath("_tabs.ini");
@@ -86,6 +90,9 @@ TabWidget::TabWidget(QWidget *parent)
     addTabAction(this, QKeySequence::PreviousChild, this, &TabWidget::previousTab);
     addTabAction(this, QKeySequence::NextChild, this, &TabWidget::nextTab);
 
+    initSingleShotTimer( &m_timerUpdateItemCounters, updateItemCountersIntervalMs,
+                         this, &TabWidget::updateOutdatedTabItemCounters );
+
     loadTabInfo();
 }
 
@@ -335,7 +342,14 @@ void TabWidget::setTabItemCount(const QString &tabName, int itemCount)
 
     m_tabItemCounters[tabName] = itemCount;
 
-    updateTabItemCount(tabName);
+    // Avoid updating tab layout too often if items change quickly
+    // (e.g. many items are added from a script).
+    if ( m_timerUpdateItemCounters.isActive() ) {
+        m_tabsWithOutdatedItemCount.insert(tabName);
+    } else {
+        updateTabItemCount(tabName);
+        m_timerUpdateItemCounters.start();
+    }
 }
 
 bool TabWidget::eventFilter(QObject *, QEvent *event)
@@ -482,6 +496,19 @@ void TabWidget::updateTabItemCount(const QString &name)
     m_tabs->adjustSize();
 }
 
+void TabWidget::updateOutdatedTabItemCounters()
+{
+    if ( m_tabsWithOutdatedItemCount.isEmpty() )
+        return;
+
+    for (const auto &name : m_tabsWithOutdatedItemCount)
+        m_tabs->setTabItemCount(name, itemCountLabel(name));
+    m_tabsWithOutdatedItemCount.clear();
+    m_tabs->adjustSize();
+
+    m_timerUpdateItemCounters.start();
+}
+
 QString TabWidget::itemCountLabel(const QString &name)
 {
     if (!m_showTabItemCount)
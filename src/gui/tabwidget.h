@@ -21,7 +21,9 @@
 #define TABWIDGET_H
 
 #include <QMap>
+#include <QSet>
 #include <QTabBar>
+#include <QTimer>
 #include <QWidget>
 
 #include <memory>
@@ -121,6 +123,7 @@ private:
     void createTabTree();
     void updateToolBar();
     void updateTabItemCount(const QString &name);
+    void updateOutdatedTabItemCounters();
     QString itemCountLabel(const QString &name);
 
     QToolBar *m_toolBar;
@@ -133,6 +136,8 @@ private:
 
     QStringList m_collapsedTabs;
     QMap<QString, int> m_tabItemCounters;
+    QSet<QString> m_tabsWithOutdatedItemCount;
+    QTimer m_timerUpdateItemCounters;
 
     bool m_showTabItemCount;
 
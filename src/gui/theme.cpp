@@ -388,6 +388,8 @@ bool Theme::isAntialiasingEnabled() const
 
 void Theme::resetTheme()
 {
+    m_browserStyleSheet.clear();
+
     QString name;
     QPalette p;
     name = serializeColor( p.color(QPalette::Base) );
@@ -531,6 +533,8 @@ void Theme::resetTheme()
 
 void Theme::updateTheme()
 {
+    m_browserStyleSheet.clear();
+
     const auto margin = itemMargin();
     m_margins = QSize(margin + 2, margin);
 
@@ -558,6 +562,19 @@ void Theme::decorateBrowser(QAbstractScrollArea *c) const
 {
     decorateScrollArea(c);
 
+    // Style sheet is created only once unless options are read from configuration dialog.
+    if (ui != nullptr) {
+        c->setStyleSheet( browserStyleSheet() );
+        return;
+    }
+
+    if ( m_browserStyleSheet.isEmpty() )
+        m_browserStyleSheet = browserStyleSheet();
+    c->setStyleSheet(m_browserStyleSheet);
+}
+
+QString Theme::browserStyleSheet() const
+{
     const QColor bg = color("bg");
     QColor unfocusedSelectedBg = color("sel_bg");
     unfocusedSelectedBg.setRgb(
@@ -572,7 +589,7 @@ void Theme::decorateBrowser(QAbstractScrollArea *c) const
     unfocusedTheme.m_theme["sel_bg"].setValue( serializeColor(unfocusedSelectedBg) );
 
     // colors and font
-    c->setStyleSheet(
+    return
         "#ClipboardBrowser,#item,#item_child{"
           + getFontStyleSheet( value("font").toString() ) +
           "color:" + themeColorString("fg") + ";"
@@ -614,8 +631,7 @@ void Theme::decorateBrowser(QAbstractScrollArea *c) const
 
         "#item_child[CopyQ_item_type=\"notes\"] {"
           + getFontStyleSheet( value("notes_font").toString() ) +
-        "}"
-    );
+        "}";
 }
 
 bool Theme::isMainWindowThemeEnabled() const
@@ -107,6 +107,8 @@ public:
 private:
     void decorateBrowser(QAbstractScrollArea *c) const;
 
+    QString browserStyleSheet() const;
+
     bool isMainWindowThemeEnabled() const;
 
     /** Return style sheet with given @a name. */
@@ -133,6 +135,8 @@ private:
 
     bool m_antialiasing = true;
     QSize m_margins;
+
+    mutable QString m_browserStyleSheet;
 };
 
 QString serializeColor(const QColor &color);
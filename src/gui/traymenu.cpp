@@ -29,6 +29,8 @@
 
 #include <QAction>
 #include <QApplication>
+#include <QBuffer>
+#include <QImageReader>
 #include <QKeyEvent>
 #include <QModelIndex>
 #include <QPixmap>
@@ -110,25 +112,10 @@ void TrayMenu::addClipboardItemAction(const QModelIndex &index, bool showImages,
 
     // Menu item icon from image.
     if (showImages) {
-        const QStringList formats = data.keys();
-        const int imageIndex = formats.indexOf( QRegExp("^image/.*") );
-        if (imageIndex != -1) {
-            const auto &mime = formats[imageIndex];
-            QPixmap pix;
-            pix.loadFromData( data.value(mime).toByteArray(), mime.toLatin1().data() );
-            const int iconSize = smallIconSize();
-            int x = 0;
-            int y = 0;
-            if (pix.width() > pix.height()) {
-                pix = pix.scaledToHeight(iconSize);
-                x = (pix.width() - iconSize) / 2;
-            } else {
-                pix = pix.scaledToWidth(iconSize);
-                y = (pix.height() - iconSize) / 2;
-            }
-            pix = pix.copy(x, y, iconSize, iconSize);
-            act->setIcon(pix);
-        }
+        const auto itemHash = index.data(contentType::hash).toULongLong();
+        const QIcon icon = imageIcon(itemHash, data);
+        if ( !icon.isNull() )
+            act->setIcon(icon);
     }
 
     connect(act, &QAction::triggered, this, &TrayMenu::onClipboardItemActionTriggered);
@@ -144,11 +131,16 @@ void TrayMenu::clearClipboardItems()
     for ( auto action : actions() ) {
         if (action->isSeparator())
             break;
-        if (action != m_searchAction)
+        if (action != m_searchAction) {
             removeAction(action);
+            action->deleteLater();
+        }
     }
     m_clipboardItemActionCount = 0;
 
+    m_previousImageIcons.swap(m_imageIcons);
+    m_imageIcons.clear();
+
     // Show search text at top of the menu.
     if ( !m_searchText.isEmpty() )
         setSearchMenuItem(m_searchText);
@@ -333,6 +325,53 @@ void TrayMenu::setSearchMenuItem(const QString &text)
     }
 }
 
+QIcon TrayMenu::imageIcon(quint64 itemHash, const QVariantMap &data)
+{
+    auto it = m_imageIcons.constFind(itemHash);
+    if ( it != m_imageIcons.constEnd() )
+        return *it;
+
+    QIcon icon = m_previousImageIcons.value(itemHash);
+    if ( icon.isNull() ) {
+        const QStringList formats = data.keys();
+        const int imageIndex = formats.indexOf( QRegExp("^image/.*") );
+        if (imageIndex == -1)
+            return QIcon();
+
+        const auto &mime = formats[imageIndex];
+        const int iconSize = smallIconSize();
+
+        // Decode downscaled image directly if supported by the format.
+        QByteArray bytes = data.value(mime).toByteArray();
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        QImageReader reader( &buffer, mime.toLatin1() );
+        const QSize size = reader.size();
+        if ( size.isValid() && size.width() > iconSize && size.height() > iconSize ) {
+            const int minSide = qMin(size.width(), size.height());
+            reader.setScaledSize( QSize(
+                qMax(iconSize, size.width() * iconSize / minSide),
+                qMax(iconSize, size.height() * iconSize / minSide) ) );
+        }
+
+        QPixmap pix = QPixmap::fromImage( reader.read() );
+        int x = 0;
+        int y = 0;
+        if (pix.width() > pix.height()) {
+            pix = pix.scaledToHeight(iconSize);
+            x = (pix.width() - iconSize) / 2;
+        } else {
+            pix = pix.scaledToWidth(iconSize);
+            y = (pix.height() - iconSize) / 2;
+        }
+        pix = pix.copy(x, y, iconSize, iconSize);
+        icon = QIcon(pix);
+    }
+
+    m_imageIcons.insert(itemHash, icon);
+    return icon;
+}
+
 void TrayMenu::onClipboardItemActionTriggered()
 {
     QAction *act = qobject_cast<QAction *>(sender());
@@ -20,6 +20,8 @@
 #ifndef TRAYMENU_H
 #define TRAYMENU_H
 
+#include <QHash>
+#include <QIcon>
 #include <QMenu>
 #include <QPointer>
 #include <QTimer>
@@ -83,6 +85,9 @@ private:
     void resetSeparators();
     void setSearchMenuItem(const QString &text);
 
+    /// Return icon rendered from item image (cached by item hash).
+    QIcon imageIcon(quint64 itemHash, const QVariantMap &data);
+
     QPointer<QAction> m_clipboardItemActionsSeparator;
     QPointer<QAction> m_customActionsSeparator;
     QPointer<QAction> m_searchAction;
@@ -95,6 +100,11 @@ private:
     QString m_searchText;
 
     QTimer m_timerUpdateActiveAction;
+
+    // Image icons for current and previous clipboard item actions,
+    // so items kept in menu after update don't need to be rendered again.
+    QHash<quint64, QIcon> m_imageIcons;
+    QHash<quint64, QIcon> m_previousImageIcons;
 };
 
 #endif // TRAYMENU_H
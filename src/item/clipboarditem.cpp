@@ -26,31 +26,49 @@
 
 #include <QBrush>
 #include <QByteArray>
+#include <QDateTime>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
 
+#include <algorithm>
+
 namespace {
 
-void clearDataExceptInternal(QVariantMap *data)
+bool isInternalFormat(const QString &mime)
 {
-    for ( const auto &format : data->keys() ) {
-        if ( !format.startsWith(COPYQ_MIME_PREFIX) )
-            data->remove(format);
-    }
+    return mime.startsWith(COPYQ_MIME_PREFIX);
+}
+
+bool mimeLessThan(const ClipboardItemFormat &format, const QString &mime)
+{
+    return format.mime < mime;
 }
 
 } // namespace
 
+ClipboardItemFormat::ClipboardItemFormat(const QString &mime, const QByteArray &bytes)
+    : mime(internMime(mime))
+    , bytes(bytes)
+    , hash(hashFormat(mime, bytes))
+{
+}
+
 ClipboardItem::ClipboardItem()
-    : m_data()
+    : m_formats()
     , m_hash(0)
+    , m_dataDecoded(true)
+    , m_createdTime( QDateTime::currentMSecsSinceEpoch() )
+    , m_lastUsedTime(m_createdTime)
 {
 }
 
 ClipboardItem::ClipboardItem(const QVariantMap &data)
-    : m_data(data)
+    : m_formats( toFormats(data) )
     , m_hash(0)
+    , m_dataDecoded(true)
+    , m_createdTime( QDateTime::currentMSecsSinceEpoch() )
+    , m_lastUsedTime(m_createdTime)
 {
 }
 
@@ -61,128 +79,386 @@ bool ClipboardItem::operator ==(const ClipboardItem &item) const
 
 void ClipboardItem::setText(const QString &text)
 {
-    for ( const auto &format : m_data.keys() ) {
-        if ( format.startsWith("text/") )
-            m_data.remove(format);
-    }
+    decodeData();
+
+    const auto isTextFormat = [](const ClipboardItemFormat &format) {
+        return format.mime.startsWith("text/");
+    };
+    m_formats.erase(
+        std::remove_if(std::begin(m_formats), std::end(m_formats), isTextFormat),
+        std::end(m_formats) );
 
-    setTextData(&m_data, text);
+    insertFormat( mimeText, text.toUtf8() );
 
-    invalidateDataHash();
+    invalidateCachedData();
 }
 
 bool ClipboardItem::setData(const QVariantMap &data)
 {
-    if (m_data == data)
+    decodeData();
+
+    const Formats formats = toFormats(data);
+    if (m_formats == formats)
         return false;
 
-    m_data = data;
-    invalidateDataHash();
+    m_formats = formats;
+    invalidateCachedData();
     return true;
 }
 
+void ClipboardItem::setSerializedData(const SerializedItemData &data)
+{
+    m_formats.clear();
+    m_serializedData = data;
+    m_hash = data.hash;
+    if (data.createdTime != 0) {
+        m_createdTime = data.createdTime;
+        m_lastUsedTime = qMax(data.createdTime, data.lastUsedTime);
+    }
+    m_dataDecoded = false;
+    m_text = QString();
+    m_textCached = false;
+    m_dataInBlobs = false;
+}
+
 bool ClipboardItem::updateData(const QVariantMap &data)
 {
-    const int oldSize = m_data.size();
+    decodeData();
+
+    const int oldSize = m_formats.size();
     for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
-        const auto &format = it.key();
-        if ( !format.startsWith(COPYQ_MIME_PREFIX) ) {
-            clearDataExceptInternal(&m_data);
+        if ( !isInternalFormat(it.key()) ) {
+            const auto isNonInternalFormat = [](const ClipboardItemFormat &format) {
+                return !isInternalFormat(format.mime);
+            };
+            m_formats.erase(
+                std::remove_if(std::begin(m_formats), std::end(m_formats), isNonInternalFormat),
+                std::end(m_formats) );
             break;
         }
     }
 
-    bool changed = (oldSize != m_data.size());
+    bool changed = (oldSize != m_formats.size());
 
     for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
         const auto &format = it.key();
         const auto &value = it.value();
         if ( !value.isValid() ) {
-            m_data.remove(format);
-            changed = true;
-        } else if ( m_data.value(format) != value ) {
-            m_data.insert(format, value);
+            removeFormat(format);
             changed = true;
+        } else {
+            const QByteArray bytes = value.toByteArray();
+            const int i = formatIndex(format);
+            if (i == -1 || m_formats[i].bytes != bytes) {
+                insertFormat(format, bytes);
+                changed = true;
+            }
         }
     }
 
-    invalidateDataHash();
+    invalidateCachedData();
 
     return changed;
 }
 
 void ClipboardItem::removeData(const QString &mimeType)
 {
-    m_data.remove(mimeType);
-    invalidateDataHash();
+    decodeData();
+    removeFormat(mimeType);
+    invalidateCachedData();
 }
 
 bool ClipboardItem::removeData(const QStringList &mimeTypeList)
 {
+    decodeData();
+
     bool removed = false;
 
     for (const auto &mimeType : mimeTypeList) {
-        if ( m_data.contains(mimeType) ) {
-            m_data.remove(mimeType);
+        if ( removeFormat(mimeType) )
             removed = true;
-        }
     }
 
     if (removed)
-        invalidateDataHash();
+        invalidateCachedData();
 
     return removed;
 }
 
 void ClipboardItem::setData(const QString &mimeType, const QByteArray &data)
 {
-    m_data.insert(mimeType, data);
-    invalidateDataHash();
+    decodeData();
+    insertFormat(mimeType, data);
+    invalidateCachedData();
 }
 
 QVariant ClipboardItem::data(int role) const
 {
+    // Hash and times can be known without decoding data.
+    if (role == contentType::hash)
+        return dataHash();
+    if (role == contentType::createdTime)
+        return m_createdTime;
+    if (role == contentType::lastUsedTime)
+        return m_lastUsedTime;
+
+    // Serialized data can be passed to other models without decoding,
+    // data in blob directory are only referenced.
+    if (role == contentType::serializedData) {
+        if ( m_serializedData.bytes.isNull() )
+            return QVariant();
+
+        SerializedItemData serializedData = m_serializedData;
+        serializedData.hash = dataHash();
+        serializedData.createdTime = m_createdTime;
+        serializedData.lastUsedTime = m_lastUsedTime;
+        return QVariant::fromValue(serializedData);
+    }
+
+    // Stored list of formats is enough to check for a format.
+    if ( !m_dataDecoded && m_serializedData.hasFormats ) {
+        switch(role) {
+        case contentType::hasText:
+            return hasSerializedFormat(mimeText) || hasSerializedFormat(mimeUriList);
+        case contentType::hasHtml:
+            return hasSerializedFormat(mimeHtml);
+        case contentType::isHidden:
+            return hasSerializedFormat(mimeHidden);
+        case contentType::notes:
+            if ( !hasSerializedFormat(mimeItemNotes) )
+                return QString();
+            break;
+        }
+    }
+
+    decodeData();
+
     switch(role) {
     case Qt::DisplayRole:
     case Qt::EditRole:
-        if ( m_data.contains(mimeText) )
-            return getTextData(m_data);
-        if ( m_data.contains(mimeUriList) )
-            return getTextData(m_data, mimeUriList);
+        if ( hasFormat(mimeText) || hasFormat(mimeUriList) )
+            return cachedText();
         break;
 
     case contentType::data:
-        return m_data; // copy-on-write, so this should be fast
-    case contentType::hash:
-        return dataHash();
+        return toDataMap();
     case contentType::hasText:
-        return m_data.contains(mimeText) || m_data.contains(mimeUriList);
+        return hasFormat(mimeText) || hasFormat(mimeUriList);
     case contentType::hasHtml:
-        return m_data.contains(mimeHtml);
+        return hasFormat(mimeHtml);
     case contentType::text:
-        return getTextData(m_data);
+        return cachedText();
     case contentType::html:
-        return getTextData(m_data, mimeHtml);
+        return textData(mimeHtml);
     case contentType::notes:
-        return getTextData(m_data, mimeItemNotes);
+        return textData(mimeItemNotes);
     case contentType::color:
-        return getTextData(m_data, mimeColor);
+        return textData(mimeColor);
     case contentType::isHidden:
-        return m_data.contains(mimeHidden);
+        return hasFormat(mimeHidden);
     }
 
     return QVariant();
 }
 
-unsigned int ClipboardItem::dataHash() const
+quint64 ClipboardItem::dataHash() const
 {
-    if (m_hash == 0)
-        m_hash = hash(m_data);
+    if (m_hash == 0) {
+        decodeData();
+        for (const auto &format : formats())
+            m_hash ^= format.hash;
+    }
 
     return m_hash;
 }
 
-void ClipboardItem::invalidateDataHash()
+bool ClipboardItem::releaseDecodedData()
+{
+    if ( !m_dataDecoded || m_serializedData.bytes.isNull() )
+        return false;
+
+    // Keep the hash so duplicates can be found without decoding.
+    dataHash();
+
+    m_formats = Formats();
+    m_dataDecoded = false;
+    m_text = QString();
+    m_textCached = false;
+    return true;
+}
+
+bool ClipboardItem::releaseCachedText()
+{
+    if (!m_textCached)
+        return false;
+
+    m_text = QString();
+    m_textCached = false;
+    return true;
+}
+
+bool ClipboardItem::moveLargeDataToBlobs(int minBlobSize)
+{
+    if ( minBlobSize <= 0 || !m_dataDecoded || !m_serializedData.bytes.isNull() )
+        return false;
+
+    const auto isLarge = [minBlobSize](const ClipboardItemFormat &format) {
+        return format.bytes.size() >= minBlobSize;
+    };
+    if ( std::none_of(std::begin(m_formats), std::end(m_formats), isLarge) )
+        return false;
+
+    const quint64 hash = dataHash();
+    SerializedItemData serializedData = serializeItemData(toDataMap(), minBlobSize);
+
+    // Keep decoded data if storing blobs failed.
+    if (!serializedData.owner)
+        return false;
+
+    serializedData.hash = hash;
+    m_serializedData = serializedData;
+    m_dataInBlobs = true;
+    return releaseDecodedData();
+}
+
+void ClipboardItem::addDataSizes(QHash<QString, qint64> *bytesPerFormat) const
+{
+    if (!m_dataDecoded) {
+        (*bytesPerFormat)[QStringLiteral("(serialized)")] += m_serializedData.bytes.size();
+        return;
+    }
+
+    for (const auto &format : formats())
+        (*bytesPerFormat)[format.mime] += format.bytes.size();
+}
+
+QString ClipboardItem::blobFilePath(const QString &mime) const
+{
+    return m_serializedData.bytes.isNull()
+            ? QString()
+            : itemBlobFilePath(m_serializedData.bytes, mime);
+}
+
+ClipboardItem::Formats ClipboardItem::toFormats(const QVariantMap &data)
+{
+    // Map is already sorted by MIME type.
+    Formats formats;
+    formats.reserve( data.size() );
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it)
+        formats.append( ClipboardItemFormat(it.key(), it.value().toByteArray()) );
+    return formats;
+}
+
+ClipboardItem::Formats ClipboardItem::toFormats(const DataFormats &data)
+{
+    Formats formats;
+    formats.reserve( data.size() );
+    for (const auto &format : data)
+        formats.append( ClipboardItemFormat(format.first, format.second) );
+
+    // Formats are usually stored sorted already.
+    const auto lessThan = [](const ClipboardItemFormat &lhs, const ClipboardItemFormat &rhs) {
+        return lhs.mime < rhs.mime;
+    };
+    if ( !std::is_sorted(std::begin(formats), std::end(formats), lessThan) )
+        std::stable_sort(std::begin(formats), std::end(formats), lessThan);
+
+    // Keep the last of duplicate formats same as QVariantMap::insert().
+    int count = 0;
+    for (int i = 0; i < formats.size(); ++i) {
+        if ( count > 0 && formats[count - 1].mime == formats[i].mime )
+            formats[count - 1] = formats[i];
+        else if (count != i)
+            formats[count++] = formats[i];
+        else
+            ++count;
+    }
+    formats.resize(count);
+
+    return formats;
+}
+
+QVariantMap ClipboardItem::toDataMap() const
+{
+    QVariantMap data;
+    for (const auto &format : formats())
+        data.insert( data.constEnd(), format.mime, format.bytes );
+    return data;
+}
+
+int ClipboardItem::formatIndex(const QString &mime) const
+{
+    const Formats &formats = this->formats();
+    const auto it = std::lower_bound(
+        std::begin(formats), std::end(formats), mime, mimeLessThan);
+    if ( it == std::end(formats) || it->mime != mime )
+        return -1;
+    return static_cast<int>( it - std::begin(formats) );
+}
+
+QString ClipboardItem::textData(const QString &mime) const
+{
+    const int i = formatIndex(mime);
+    return i == -1 ? QString() : getTextData(m_formats.at(i).bytes);
+}
+
+QString ClipboardItem::textData() const
+{
+    for (const auto &mime : {mimeText, mimeUriList}) {
+        const int i = formatIndex(mime);
+        if (i != -1)
+            return getTextData(m_formats.at(i).bytes);
+    }
+
+    return QString();
+}
+
+bool ClipboardItem::hasSerializedFormat(const QString &mime) const
+{
+    const auto &formats = m_serializedData.formats;
+    return std::any_of( std::begin(formats), std::end(formats), [&](const SerializedFormatInfo &format) {
+        return format.mime == mime;
+    });
+}
+
+void ClipboardItem::insertFormat(const QString &mime, const QByteArray &bytes)
+{
+    const auto it = std::lower_bound(
+        std::begin(m_formats), std::end(m_formats), mime, mimeLessThan);
+    if ( it != std::end(m_formats) && it->mime == mime )
+        *it = ClipboardItemFormat(mime, bytes);
+    else
+        m_formats.insert( it, ClipboardItemFormat(mime, bytes) );
+}
+
+bool ClipboardItem::removeFormat(const QString &mime)
+{
+    const int i = formatIndex(mime);
+    if (i == -1)
+        return false;
+
+    m_formats.remove(i);
+    return true;
+}
+
+void ClipboardItem::invalidateCachedData()
 {
     m_hash = 0;
+    m_serializedData = SerializedItemData();
+    m_text = QString();
+    m_textCached = false;
+    m_dataInBlobs = false;
+}
+
+void ClipboardItem::decodeSerializedData() const
+{
+    DataFormats data;
+    if ( deserializeStoredData(&data, m_serializedData.bytes) ) {
+        m_formats = toFormats(data);
+    } else {
+        m_formats.clear();
+        m_serializedData = SerializedItemData();
+    }
+
+    m_dataDecoded = true;
 }
@@ -20,10 +20,32 @@
 #ifndef CLIPBOARDITEM_H
 #define CLIPBOARDITEM_H
 
+#include "item/serialize.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
 #include <QVariant>
+#include <QVector>
+
+/**
+ * Data of single format in ClipboardItem.
+ */
+struct ClipboardItemFormat {
+    ClipboardItemFormat() = default;
+    ClipboardItemFormat(const QString &mime, const QByteArray &bytes);
+
+    QString mime; ///< Interned MIME type (see internMime()).
+    QByteArray bytes;
+    quint64 hash = 0; ///< Cached hashFormat() of the data.
+
+    bool operator ==(const ClipboardItemFormat &other) const
+    {
+        return hash == other.hash && mime == other.mime && bytes == other.bytes;
+    }
+};
 
-class QByteArray;
-class QString;
+Q_DECLARE_TYPEINFO(ClipboardItemFormat, Q_MOVABLE_TYPE);
 
 /**
  * Class for clipboard items in ClipboardModel.
@@ -55,6 +77,11 @@ public:
      */
     bool setData(const QVariantMap &data);
 
+    /**
+     * Set serialized data which are decoded only when needed.
+     */
+    void setSerializedData(const SerializedItemData &data);
+
     /**
      * Update current data.
      * Clears non-internal data if passed data map contains non-internal data.
@@ -72,16 +99,141 @@ public:
     QVariant data(int role) const;
 
     /** Return data for format. */
-    QByteArray data(const QString &format) const { return m_data.value(format).toByteArray(); }
+    QByteArray data(const QString &format) const
+    {
+        decodeData();
+        const int i = formatIndex(format);
+        return i == -1 ? QByteArray() : m_formats.at(i).bytes;
+    }
 
     /** Return hash for item's data. */
-    unsigned int dataHash() const;
+    quint64 dataHash() const;
+
+    /** Return true if hash is known without decoding data (see dataHash()). */
+    bool hasDataHash() const { return m_hash != 0 || m_dataDecoded; }
+
+    /** Return time when item was created (milliseconds since epoch). */
+    qint64 createdTime() const { return m_createdTime; }
+
+    void setCreatedTime(qint64 time) { m_createdTime = time; }
+
+    /** Return time when item was last used (milliseconds since epoch). */
+    qint64 lastUsedTime() const { return m_lastUsedTime; }
+
+    void setLastUsedTime(qint64 time) { m_lastUsedTime = time; }
+
+    /** Return false if item data are serialized and not decoded yet. */
+    bool isDataDecoded() const { return m_dataDecoded; }
+
+    /**
+     * Free decoded data if the item can be decoded again from unchanged
+     * serialized data (i.e. data loaded from tab file).
+     *
+     * @return true only if data were freed
+     */
+    bool releaseDecodedData();
+
+    /** Return number of characters in cached decoded text. */
+    int cachedTextSize() const { return m_textCached ? m_text.size() : 0; }
+
+    /** Return true only if decoded text is cached. */
+    bool isTextCached() const { return m_textCached; }
+
+    /**
+     * Free cached decoded text, it's decoded from UTF-8 data again when needed.
+     *
+     * @return true only if text was freed
+     */
+    bool releaseCachedText();
+
+    /**
+     * Store formats with at least @a minBlobSize bytes in blob directory and
+     * free decoded data, these are read from the blob files only when needed.
+     *
+     * @return true only if data were moved
+     */
+    bool moveLargeDataToBlobs(int minBlobSize);
+
+    /** Return true if data were moved to blob directory (see moveLargeDataToBlobs()). */
+    bool hasDataInBlobs() const { return m_dataInBlobs; }
+
+    /** Return path to blob file with data of @a mime format (see itemBlobFilePath()). */
+    QString blobFilePath(const QString &mime) const;
+
+    /**
+     * Add number of bytes of decoded data to @a bytesPerFormat for each format.
+     *
+     * Serialized data which are not decoded are added as "(serialized)".
+     * Data are not decoded or read from blob files.
+     */
+    void addDataSizes(QHash<QString, qint64> *bytesPerFormat) const;
 
 private:
-    void invalidateDataHash();
+    using Formats = QVector<ClipboardItemFormat>;
+
+    static Formats toFormats(const QVariantMap &data);
+
+    /** Return formats sorted by MIME type, the last of duplicate formats is used. */
+    static Formats toFormats(const DataFormats &data);
+
+    /** Access formats without detaching shared data. */
+    const Formats &formats() const { return m_formats; }
+
+    QVariantMap toDataMap() const;
+
+    /** Return index of format or -1 if item doesn't contain the format. */
+    int formatIndex(const QString &mime) const;
+
+    bool hasFormat(const QString &mime) const { return formatIndex(mime) != -1; }
+
+    /** Return true if stored format list of serialized data contains the format. */
+    bool hasSerializedFormat(const QString &mime) const;
+
+    QString textData(const QString &mime) const;
+
+    /** Return text/plain or text/uri-list data. */
+    QString textData() const;
+
+    /** Return cached textData(), used often for displaying and filtering items. */
+    const QString &cachedText() const
+    {
+        if (!m_textCached) {
+            m_text = textData();
+            m_textCached = true;
+        }
+        return m_text;
+    }
+
+    void insertFormat(const QString &mime, const QByteArray &bytes);
+
+    bool removeFormat(const QString &mime);
+
+    /** Drop cached hash and serialized data after the data changed. */
+    void invalidateCachedData();
+
+    /** Decode serialized data if not yet decoded. */
+    void decodeData() const
+    {
+        if (!m_dataDecoded)
+            decodeSerializedData();
+    }
+
+    void decodeSerializedData() const;
 
-    QVariantMap m_data;
-    mutable unsigned int m_hash;
+    // Formats are sorted by MIME type. QVariantMap is created only when
+    // requested by contentType::data role, since it takes a lot more memory.
+    mutable Formats m_formats;
+    // Serialized data are kept after decoding so that decoded data can be freed.
+    mutable SerializedItemData m_serializedData;
+    mutable quint64 m_hash;
+    mutable bool m_dataDecoded;
+    // Decoded text is cached until data change or decoded data are released.
+    mutable QString m_text;
+    mutable bool m_textCached = false;
+    bool m_dataInBlobs = false;
+    // Times are kept outside data so these don't change item hash.
+    qint64 m_createdTime;
+    qint64 m_lastUsedTime;
 };
 
 #endif // CLIPBOARDITEM_H
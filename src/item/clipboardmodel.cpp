@@ -20,7 +20,9 @@
 #include "clipboardmodel.h"
 
 #include "common/contenttype.h"
+#include "common/log.h"
 #include "common/mimetypes.h"
+#include "common/timer.h"
 
 #include <QStringList>
 
@@ -29,31 +31,61 @@
 
 namespace {
 
-QList<QPersistentModelIndex> validIndeces(const QModelIndexList &indexList)
-{
-    QList<QPersistentModelIndex> list;
-    list.reserve(indexList.size());
+/// Maximum number of characters of decoded item texts kept in memory.
+const qint64 maxCachedTextSize = 4 * 1024 * 1024;
 
+/// Return sorted unique rows of valid indexes.
+QVector<int> validRows(const QModelIndexList &indexList)
+{
+    QVector<int> rows;
+    rows.reserve( indexList.size() );
     for (const auto &index : indexList) {
         if ( index.isValid() )
-            list.append(index);
+            rows.append( index.row() );
     }
 
-    return list;
+    std::sort( std::begin(rows), std::end(rows) );
+    rows.erase( std::unique(std::begin(rows), std::end(rows)), std::end(rows) );
+    return rows;
 }
 
-int topMostRow(const QList<QPersistentModelIndex> &indexList)
+template <typename Key, typename LessThan>
+QVector<int> sortedOrder(const QVector<Key> &keys, LessThan lessThan)
 {
-    int row = indexList.value(0).row();
+    QVector<int> order( keys.size() );
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = i;
 
-    for (const auto &index : indexList)
-        row = qMin(row, index.row());
+    std::stable_sort( std::begin(order), std::end(order), [&](int lhs, int rhs) {
+        return lessThan(keys[lhs], keys[rhs]);
+    });
 
-    return row;
+    return order;
 }
 
 } // namespace
 
+RowRanges toRowRanges(const QModelIndexList &indexList)
+{
+    const QVector<int> rows = validRows(indexList);
+
+    RowRanges ranges;
+    for (const int row : rows) {
+        if ( !ranges.isEmpty() ) {
+            RowRange &last = ranges.last();
+            if (row < last.row + last.count)
+                continue;
+            if (row == last.row + last.count) {
+                ++last.count;
+                continue;
+            }
+        }
+        ranges.append( RowRange{row, 1} );
+    }
+
+    return ranges;
+}
+
 void ClipboardItemList::move(int from, int count, int to)
 {
     if (to < from) {
@@ -71,6 +103,7 @@ void ClipboardItemList::move(int from, int count, int to)
 ClipboardModel::ClipboardModel(QObject *parent)
     : QAbstractListModel(parent)
 {
+    initSingleShotTimer( &m_timerReleaseItemData, 5000, this, &ClipboardModel::releaseItemData );
 }
 
 int ClipboardModel::rowCount(const QModelIndex&) const
@@ -83,7 +116,23 @@ QVariant ClipboardModel::data(const QModelIndex &index, int role) const
     if (!index.isValid() || index.row() >= m_clipboardList.size())
         return QVariant();
 
-    return m_clipboardList[index.row()].data(role);
+    const int row = index.row();
+    const ClipboardItem &item = m_clipboardList[row];
+    const bool needsData = role != contentType::hash
+            && role != contentType::createdTime
+            && role != contentType::lastUsedTime
+            && role != contentType::serializedData;
+    if ( needsData && !item.isDataDecoded() && !m_timerReleaseItemData.isActive()
+         && (item.hasDataInBlobs() || (m_itemsInMemory > 0 && row >= m_itemsInMemory)) )
+    {
+        m_timerReleaseItemData.start();
+    }
+
+    const bool needsText = role == contentType::text || role == Qt::DisplayRole || role == Qt::EditRole;
+    if ( needsText && !item.isTextCached() && !m_timerReleaseItemData.isActive() )
+        m_timerReleaseItemData.start();
+
+    return item.data(role);
 }
 
 Qt::ItemFlags ClipboardModel::flags(const QModelIndex &index) const
@@ -100,6 +149,7 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
         return false;
 
     int row = index.row();
+    const quint64 oldHash = m_itemHashesCounted ? m_clipboardList[row].dataHash() : 0;
 
     if (role == Qt::EditRole) {
         m_clipboardList[row].setText(value.toString());
@@ -117,6 +167,12 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
         const QVariantMap dataMap = value.toMap();
         if ( !item.setData(dataMap) )
             return false;
+    } else if (role == contentType::serializedData) {
+        m_clipboardList[row].setSerializedData( value.value<SerializedItemData>() );
+    } else if (role == contentType::createdTime) {
+        m_clipboardList[row].setCreatedTime( value.toLongLong() );
+    } else if (role == contentType::lastUsedTime) {
+        m_clipboardList[row].setLastUsedTime( value.toLongLong() );
     } else if (role >= contentType::removeFormats) {
         if ( !m_clipboardList[row].removeData(value.toStringList()) )
             return false;
@@ -124,7 +180,17 @@ bool ClipboardModel::setData(const QModelIndex &index, const QVariant &value, in
         return false;
     }
 
-    emit dataChanged(index, index);
+    removeItemHash(oldHash);
+    addItemHash( m_clipboardList[row] );
+
+    if (m_minItemBlobSize > 0)
+        m_timerReleaseItemData.start();
+
+    // Listeners can skip processing item data if only times change.
+    if (role == contentType::createdTime || role == contentType::lastUsedTime)
+        emit dataChanged(index, index, QVector<int>() << role);
+    else
+        emit dataChanged(index, index);
 
     return true;
 }
@@ -133,12 +199,16 @@ void ClipboardModel::insertItem(const QVariantMap &data, int row)
 {
     ClipboardItem item;
     item.setData(data);
+    addItemHash(item);
 
     beginInsertRows(QModelIndex(), row, row);
 
     m_clipboardList.insert(row, item);
 
     endInsertRows();
+
+    if (m_minItemBlobSize > 0)
+        m_timerReleaseItemData.start();
 }
 
 void ClipboardModel::insertItems(const QList<QVariantMap> &dataList, int row)
@@ -152,11 +222,42 @@ void ClipboardModel::insertItems(const QList<QVariantMap> &dataList, int row)
     beginInsertRows(QModelIndex(), row, row + dataList.size() - 1);
 
     for ( auto it = std::begin(dataList); it != std::end(dataList); ++it ) {
-        m_clipboardList.insert(targetRow, ClipboardItem(*it));
+        const ClipboardItem item(*it);
+        addItemHash(item);
+        m_clipboardList.insert(targetRow, item);
+        ++targetRow;
+    }
+
+    endInsertRows();
+
+    if (m_minItemBlobSize > 0)
+        m_timerReleaseItemData.start();
+}
+
+void ClipboardModel::insertItems(const QVariantList &items, int row)
+{
+    if ( items.isEmpty() )
+        return;
+
+    int targetRow = row;
+    m_clipboardList.reserve( m_clipboardList.size() + items.size() );
+
+    beginInsertRows(QModelIndex(), row, row + items.size() - 1);
+
+    for (const auto &itemData : items) {
+        const bool isSerialized = itemData.userType() == qMetaTypeId<SerializedItemData>();
+        ClipboardItem item( isSerialized ? QVariantMap() : itemData.toMap() );
+        if (isSerialized)
+            item.setSerializedData( itemData.value<SerializedItemData>() );
+        addItemHash(item);
+        m_clipboardList.insert(targetRow, item);
         ++targetRow;
     }
 
     endInsertRows();
+
+    if (m_minItemBlobSize > 0)
+        m_timerReleaseItemData.start();
 }
 
 bool ClipboardModel::insertRows(int position, int rows, const QModelIndex&)
@@ -166,8 +267,11 @@ bool ClipboardModel::insertRows(int position, int rows, const QModelIndex&)
 
     beginInsertRows(QModelIndex(), position, position + rows - 1);
 
-    for (int row = 0; row < rows; ++row)
-        m_clipboardList.insert(position, ClipboardItem());
+    const ClipboardItem item;
+    if (m_itemHashesCounted)
+        m_itemHashCounts[item.dataHash()] += rows;
+
+    m_clipboardList.insert(position, rows, item);
 
     endInsertRows();
 
@@ -183,6 +287,11 @@ bool ClipboardModel::removeRows(int position, int rows, const QModelIndex&)
 
     beginRemoveRows(QModelIndex(), position, last);
 
+    if (m_itemHashesCounted) {
+        for (int row = position; row <= last; ++row)
+            removeItemHash( m_clipboardList[row].dataHash() );
+    }
+
     m_clipboardList.remove(position, last - position + 1);
 
     endRemoveRows();
@@ -190,6 +299,46 @@ bool ClipboardModel::removeRows(int position, int rows, const QModelIndex&)
     return true;
 }
 
+void ClipboardModel::removeRowRanges(const RowRanges &ranges)
+{
+    for (auto it = ranges.crbegin(); it != ranges.crend(); ++it)
+        removeRows(it->row, it->count);
+}
+
+int ClipboardModel::moveRowRanges(const RowRanges &ranges, int targetRow)
+{
+    targetRow = qBound(0, targetRow, rowCount());
+
+    // Move ranges above target row down, from the closest one.
+    int firstRow = targetRow;
+    for (auto it = ranges.crbegin(); it != ranges.crend(); ++it) {
+        if (it->row >= targetRow)
+            continue;
+
+        // Only head of the range which contains target row is moved.
+        const int count = qMin(it->count, targetRow - it->row);
+        const int row = it->row;
+        if (row + count != firstRow)
+            moveRows(QModelIndex(), row, count, QModelIndex(), firstRow);
+        firstRow -= count;
+    }
+
+    // Move ranges below target row up, from the closest one.
+    int nextRow = targetRow;
+    for (const auto &range : ranges) {
+        if (range.row + range.count <= targetRow)
+            continue;
+
+        const int row = qMax(range.row, targetRow);
+        const int count = range.row + range.count - row;
+        if (row != nextRow)
+            moveRows(QModelIndex(), row, count, QModelIndex(), nextRow);
+        nextRow += count;
+    }
+
+    return firstRow;
+}
+
 bool ClipboardModel::moveRows(
         const QModelIndex &sourceParent, int sourceRow, int rows,
         const QModelIndex &destinationParent, int destinationRow)
@@ -214,35 +363,51 @@ bool ClipboardModel::moveRows(
     return true;
 }
 
-void ClipboardModel::sortItems(const QModelIndexList &indexList, CompareItems *compare)
+void ClipboardModel::sortItems(const QModelIndexList &indexList, ItemSortKey key)
 {
-    QList<QPersistentModelIndex> list = validIndeces(indexList);
-    std::sort( list.begin(), list.end(), compare );
+    const QVector<int> rows = validRows(indexList);
+    if ( rows.size() < 2 )
+        return;
 
-    int targetRow = topMostRow(list);
+    QVector<int> order;
+    if (key == ItemSortKey::TextLength) {
+        QVector<int> lengths;
+        lengths.reserve( rows.size() );
+        for (const int row : rows)
+            lengths.append( m_clipboardList[row].data(contentType::text).toString().size() );
+        order = sortedOrder( lengths, std::less<int>() );
+    } else {
+        QVector<QString> texts;
+        texts.reserve( rows.size() );
+        for (const int row : rows)
+            texts.append( m_clipboardList[row].data(contentType::text).toString() );
+        order = sortedOrder( texts, [](const QString &lhs, const QString &rhs) {
+            return lhs.localeAwareCompare(rhs) < 0;
+        });
+    }
 
-    for (const auto &ind : list) {
-        if (ind.isValid()) {
-            const int sourceRow = ind.row();
+    moveSortedRows(rows, order);
+}
 
-            if (targetRow != sourceRow) {
-                beginMoveRows(QModelIndex(), sourceRow, sourceRow, QModelIndex(), targetRow);
-                m_clipboardList.move(sourceRow, targetRow);
-                endMoveRows();
+void ClipboardModel::reverseItems(const QModelIndexList &indexList)
+{
+    const QVector<int> rows = validRows(indexList);
+    if ( rows.size() < 2 )
+        return;
 
-                // If the moved item was removed or moved further (as reaction on moving the item),
-                // stop sorting.
-                if (!ind.isValid() || ind.row() != targetRow)
-                    break;
-            }
+    QVector<int> order( rows.size() );
+    for (int i = 0; i < order.size(); ++i)
+        order[i] = order.size() - i - 1;
 
-            ++targetRow;
-        }
-    }
+    moveSortedRows(rows, order);
 }
 
-int ClipboardModel::findItem(uint itemHash) const
+int ClipboardModel::findItem(quint64 itemHash) const
 {
+    countItemHashes();
+    if ( !m_itemHashCounts.contains(itemHash) )
+        return -1;
+
     for (int i = 0; i < m_clipboardList.size(); ++i) {
         if ( m_clipboardList[i].dataHash() == itemHash )
             return i;
@@ -250,3 +415,178 @@ int ClipboardModel::findItem(uint itemHash) const
 
     return -1;
 }
+
+QVector<int> ClipboardModel::findItems(quint64 itemHash) const
+{
+    QVector<int> rows;
+    countItemHashes();
+    const int count = m_itemHashCounts.value(itemHash, 0);
+    if (count == 0)
+        return rows;
+
+    rows.reserve(count);
+    for (int i = 0; i < m_clipboardList.size() && rows.size() < count; ++i) {
+        if ( m_clipboardList[i].dataHash() == itemHash )
+            rows.append(i);
+    }
+
+    return rows;
+}
+
+QString ClipboardModel::itemBlobFilePath(int row, const QString &mime) const
+{
+    if ( row < 0 || row >= m_clipboardList.size() )
+        return QString();
+    return m_clipboardList[row].blobFilePath(mime);
+}
+
+QVector<ClipboardItem> ClipboardModel::itemsSnapshot() const
+{
+    QVector<ClipboardItem> items;
+    items.reserve( m_clipboardList.size() );
+
+    for (int i = 0; i < m_clipboardList.size(); ++i)
+        items.append( m_clipboardList[i] );
+
+    return items;
+}
+
+QVector<ClipboardItem> ClipboardModel::itemsSnapshot(const QVector<int> &rows) const
+{
+    QVector<ClipboardItem> items;
+    items.reserve( rows.size() );
+
+    for (const int row : rows)
+        items.append( m_clipboardList[row] );
+
+    return items;
+}
+
+void ClipboardModel::setItemsInMemory(int rows)
+{
+    m_itemsInMemory = qMax(0, rows);
+    if (m_itemsInMemory > 0)
+        m_timerReleaseItemData.start();
+    else
+        m_timerReleaseItemData.stop();
+}
+
+void ClipboardModel::setMinItemBlobSize(int bytes)
+{
+    m_minItemBlobSize = qMax(0, bytes);
+    if (m_minItemBlobSize > 0)
+        m_timerReleaseItemData.start();
+}
+
+void ClipboardModel::releaseItemData()
+{
+    int released = 0;
+    int releasedTexts = 0;
+    qint64 cachedTextSize = 0;
+    for (int row = 0; row < m_clipboardList.size(); ++row) {
+        auto &item = m_clipboardList[row];
+        const bool release = item.hasDataInBlobs() || (m_itemsInMemory > 0 && row >= m_itemsInMemory);
+        if ( (release && item.releaseDecodedData()) || item.moveLargeDataToBlobs(m_minItemBlobSize) ) {
+            ++released;
+            continue;
+        }
+
+        // Keep decoded text only for top (recently used) items within the limit.
+        cachedTextSize += item.cachedTextSize();
+        if ( cachedTextSize > maxCachedTextSize && item.releaseCachedText() )
+            ++releasedTexts;
+    }
+
+    if (released > 0)
+        COPYQ_LOG_VERBOSE( QString("Freed data of %1 items").arg(released) );
+    if (releasedTexts > 0)
+        COPYQ_LOG_VERBOSE( QString("Freed decoded text of %1 items").arg(releasedTexts) );
+}
+
+QHash<QString, qint64> ClipboardModel::dataSizes() const
+{
+    QHash<QString, qint64> bytesPerFormat;
+    for (int row = 0; row < m_clipboardList.size(); ++row)
+        m_clipboardList[row].addDataSizes(&bytesPerFormat);
+    return bytesPerFormat;
+}
+
+void ClipboardModel::moveSortedRows(const QVector<int> &rows, const QVector<int> &order)
+{
+    // Sorted items are placed from the top-most row,
+    // other items in between are moved below them.
+    const int firstRow = rows.first();
+    QVector<int> sourceRows;
+    sourceRows.reserve( rows.last() - firstRow + 1 );
+    for (const int i : order)
+        sourceRows.append( rows[i] );
+    for (int i = 1; i < rows.size(); ++i) {
+        for (int row = rows[i - 1] + 1; row < rows[i]; ++row)
+            sourceRows.append(row);
+    }
+
+    emit layoutAboutToBeChanged();
+
+    QVector<ClipboardItem> items;
+    items.reserve( sourceRows.size() );
+    for (const int row : sourceRows)
+        items.append( m_clipboardList[row] );
+    for (int i = 0; i < items.size(); ++i)
+        m_clipboardList[firstRow + i] = items[i];
+
+    QVector<int> newRows( sourceRows.size() );
+    for (int i = 0; i < sourceRows.size(); ++i)
+        newRows[sourceRows[i] - firstRow] = firstRow + i;
+
+    const QModelIndexList oldIndexes = persistentIndexList();
+    QModelIndexList newIndexes;
+    newIndexes.reserve( oldIndexes.size() );
+    for (const auto &oldIndex : oldIndexes) {
+        const int i = oldIndex.row() - firstRow;
+        if (0 <= i && i < newRows.size())
+            newIndexes.append( index(newRows[i]) );
+        else
+            newIndexes.append(oldIndex);
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    emit layoutChanged();
+}
+
+void ClipboardModel::addItemHash(const ClipboardItem &item)
+{
+    if (!m_itemHashesCounted)
+        return;
+
+    // Avoid decoding item, hashes are counted once needed.
+    if ( !item.hasDataHash() ) {
+        m_itemHashCounts.clear();
+        m_itemHashesCounted = false;
+        return;
+    }
+
+    ++m_itemHashCounts[item.dataHash()];
+}
+
+void ClipboardModel::removeItemHash(quint64 itemHash)
+{
+    if (!m_itemHashesCounted)
+        return;
+
+    const auto it = m_itemHashCounts.find(itemHash);
+    Q_ASSERT( it != m_itemHashCounts.end() );
+    if ( it != m_itemHashCounts.end() && --it.value() == 0 )
+        m_itemHashCounts.erase(it);
+}
+
+void ClipboardModel::countItemHashes() const
+{
+    if (m_itemHashesCounted)
+        return;
+
+    // Computed hashes are kept in items and stored in tab file on next save.
+    for (const auto &item : m_clipboardList)
+        ++m_itemHashCounts[item.dataHash()];
+
+    m_itemHashesCounted = true;
+}
@@ -23,69 +23,96 @@
 #include "item/clipboarditem.h"
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QList>
+#include <QTimer>
+#include <QVector>
+
+#include <deque>
 
 /**
  * Container with clipboard items.
  *
- * Item prepending is optimized.
+ * Item prepending and removing items from the end is optimized (constant time).
  */
 class ClipboardItemList {
 public:
     ClipboardItem &operator [](int i)
     {
-        return m_items[i];
+        return m_items[static_cast<size_t>(i)];
     }
 
     const ClipboardItem &operator [](int i) const
     {
-        return m_items[i];
+        return m_items[static_cast<size_t>(i)];
     }
 
     void insert(int row, const ClipboardItem &item)
     {
-        m_items.insert(row, item);
+        m_items.insert(std::begin(m_items) + row, item);
+    }
+
+    void insert(int row, int count, const ClipboardItem &item)
+    {
+        m_items.insert(std::begin(m_items) + row, static_cast<size_t>(count), item);
     }
 
     void remove(int row, int count)
     {
-        const QList<ClipboardItem>::iterator from = m_items.begin() + row;
-        const QList<ClipboardItem>::iterator to = from + count;
+        const auto from = std::begin(m_items) + row;
+        const auto to = from + count;
         m_items.erase(from, to);
     }
 
     int size() const
     {
-        return m_items.size();
+        return static_cast<int>(m_items.size());
     }
 
     void move(int from, int to)
     {
-        const ClipboardItem item = m_items[from];
-        m_items.removeAt(from);
-        m_items.insert(to, item);
+        move(from, 1, to < from ? to : to + 1);
     }
 
     void move(int from, int count, int to);
 
-    void reserve(int maxItems)
+    void reserve(int)
     {
-        m_items.reserve(maxItems);
+        // Allocated in chunks as needed.
     }
 
     void resize(int size)
     {
-        if (size < this->size())
-            remove(size, this->size());
-
-        while (size > this->size())
-            m_items.append(ClipboardItem());
+        m_items.resize( static_cast<size_t>(size) );
     }
 
 private:
-    QList<ClipboardItem> m_items;
+    std::deque<ClipboardItem> m_items;
+};
+
+/// Range of rows in ClipboardModel.
+struct RowRange {
+    int row;
+    int count;
+};
+
+using RowRanges = QVector<RowRange>;
+
+/// Keys for sorting items (see ClipboardModel::sortItems()).
+enum class ItemSortKey {
+    /// Item text compared using current locale.
+    Text,
+    /// Length of item text.
+    TextLength,
 };
 
+/**
+ * Return sorted non-overlapping ranges of valid rows in @a indexList.
+ *
+ * Adjacent rows are merged into single range.
+ */
+RowRanges toRowRanges(const QModelIndexList &indexList);
+
 /**
  * Model containing ClipboardItem objects.
  *
@@ -99,9 +126,6 @@ class ClipboardModel : public QAbstractListModel
     Q_OBJECT
 
 public:
-    /** Return true if @a lhs is less than @a rhs. */
-    using CompareItems = bool (const QModelIndex &, const QModelIndex &);
-
     explicit ClipboardModel(QObject *parent = nullptr);
 
     /** Return number of items in model. */
@@ -128,18 +152,115 @@ public:
     void insertItems(const QList<QVariantMap> &dataList, int row);
 
     /**
-     * Sort items in ascending order.
+     * Insert items with data maps or serialized data (see contentType::serializedData).
+     *
+     * Serialized items are not decoded.
+     */
+    void insertItems(const QVariantList &items, int row);
+
+    /**
+     * Remove rows in sorted non-overlapping ranges (see toRowRanges()).
+     *
+     * Ranges are removed from the bottom so model emits rowsRemoved() only
+     * once per range and no persistent indexes are needed to track rows.
+     */
+    void removeRowRanges(const RowRanges &ranges);
+
+    /**
+     * Move rows in sorted non-overlapping ranges (see toRowRanges())
+     * so they are at @a targetRow (row number before the move) in same order.
+     *
+     * Model emits rowsMoved() only for ranges which are not already in place.
+     *
+     * @return new row of the first moved item
+     */
+    int moveRowRanges(const RowRanges &ranges, int targetRow);
+
+    /**
+     * Sort items in ascending order by @a key.
+     *
+     * Sorted items are placed from the top-most row. Sort key is extracted
+     * only once for each item and items are rearranged with single
+     * layoutChanged() signal.
      */
-    void sortItems(const QModelIndexList &indexList, CompareItems *compare);
+    void sortItems(const QModelIndexList &indexList, ItemSortKey key);
+
+    /** Reverse order of items (same as sortItems() by descending row). */
+    void reverseItems(const QModelIndexList &indexList);
 
     /**
      * Find item with given @a hash.
      * @return Row number with found item or -1 if no item was found.
      */
-    int findItem(uint itemHash) const;
+    int findItem(quint64 itemHash) const;
+
+    /// Return rows of all items with given @a hash.
+    QVector<int> findItems(quint64 itemHash) const;
+
+    /// Return path to blob file with item data in given format (see ClipboardItem::blobFilePath()).
+    QString itemBlobFilePath(int row, const QString &mime) const;
+
+    /**
+     * Return copy of all items.
+     *
+     * Each item is copied so the result can be safely used from other thread.
+     */
+    QVector<ClipboardItem> itemsSnapshot() const;
+
+    /** Return copy of items in given rows. */
+    QVector<ClipboardItem> itemsSnapshot(const QVector<int> &rows) const;
+
+    /**
+     * Set number of top rows which keep decoded item data in memory.
+     *
+     * Data of items in other rows are freed shortly after they are accessed
+     * and decoded again from tab file when needed. Zero keeps all data.
+     */
+    void setItemsInMemory(int rows);
+
+    /**
+     * Set minimum size of item data which are moved from memory to blob files.
+     *
+     * Such data are read again from the files only when needed.
+     * Zero keeps all data of new items in memory.
+     */
+    void setMinItemBlobSize(int bytes);
+
+    /**
+     * Free decoded data of items below rows kept in memory
+     * and move large data of items to blob files.
+     */
+    void releaseItemData();
+
+    /** Return number of bytes of item data in memory for each format. */
+    QHash<QString, qint64> dataSizes() const;
 
 private:
+    /**
+     * Move items in sorted @a rows below the top-most one in given @a order
+     * (item rows[order[0]] will be first).
+     */
+    void moveSortedRows(const QVector<int> &rows, const QVector<int> &order);
+
+    void addItemHash(const ClipboardItem &item);
+    void removeItemHash(quint64 itemHash);
+
+    /// Count hashes of all items if some items were added without known hash.
+    void countItemHashes() const;
+
     ClipboardItemList m_clipboardList;
+
+    int m_itemsInMemory = 0;
+    int m_minItemBlobSize = 0;
+    mutable QTimer m_timerReleaseItemData;
+
+    /**
+     * Number of items with given hash, so missing items are found without scanning all items.
+     *
+     * Items loaded without stored hash are not decoded until an item needs to be found.
+     */
+    mutable QHash<quint64, int> m_itemHashCounts;
+    mutable bool m_itemHashesCounted = true;
 };
 
 #endif // CLIPBOARDMODEL_H
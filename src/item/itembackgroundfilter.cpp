@@ -0,0 +1,177 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itembackgroundfilter.h"
+
+#include "common/log.h"
+#include "item/itemsnapshotmodel.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace {
+
+/// Number of items matched in single task.
+const int chunkSize = 512;
+
+class MatchItemsTask final : public QRunnable
+{
+public:
+    MatchItemsTask(
+            ItemBackgroundFilter *receiver, int jobId, int chunk,
+            const QRegExp &re, const ItemLoaderList &loaders,
+            const QVector<ClipboardItem> &items)
+        : m_receiver(receiver)
+        , m_jobId(jobId)
+        , m_chunk(chunk)
+        , m_re(re)
+        , m_loaders(loaders)
+        , m_items(items)
+    {
+    }
+
+    void run() override
+    {
+        QVector<bool> matched;
+        if ( m_receiver->isCurrentJob(m_jobId) ) {
+            const ItemSnapshotModel model(m_items);
+            QList<QModelIndex> indexes;
+            indexes.reserve( m_items.size() );
+            for (int row = 0; row < m_items.size(); ++row)
+                indexes.append( model.index(row, 0) );
+            matched = ItemFactory::matches(indexes, m_re, m_loaders);
+        }
+
+        m_receiver->taskFinished(m_jobId, m_chunk, matched);
+    }
+
+private:
+    ItemBackgroundFilter *m_receiver;
+    int m_jobId;
+    int m_chunk;
+    // Each task needs own copy, matching changes internal state of QRegExp.
+    QRegExp m_re;
+    ItemLoaderList m_loaders;
+    QVector<ClipboardItem> m_items;
+};
+
+} // namespace
+
+ItemBackgroundFilter::ItemBackgroundFilter(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ItemBackgroundFilter::~ItemBackgroundFilter()
+{
+    cancel();
+
+    QMutexLocker lock(&m_mutex);
+    while (m_runningTasks > 0)
+        m_tasksFinished.wait(&m_mutex);
+}
+
+void ItemBackgroundFilter::start(
+        const QRegExp &re, const ItemLoaderList &loaders,
+        const QVector<int> &rows, const QVector<ClipboardItem> &items)
+{
+    Q_ASSERT(rows.size() == items.size());
+
+    cancel();
+
+    const int jobId = m_jobId.load();
+    const int chunkCount = (rows.size() + chunkSize - 1) / chunkSize;
+
+    COPYQ_LOG_VERBOSE( QString("Matching %1 items in %2 tasks").arg(rows.size()).arg(chunkCount) );
+
+    m_running = true;
+    m_nextChunk = 0;
+    m_chunkRows.clear();
+    m_chunkRows.reserve(chunkCount);
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_runningTasks += chunkCount;
+    }
+
+    for (int chunk = 0; chunk < chunkCount; ++chunk) {
+        const int first = chunk * chunkSize;
+        m_chunkRows.append( rows.mid(first, chunkSize) );
+        QThreadPool::globalInstance()->start(
+                    new MatchItemsTask(this, jobId, chunk, re, loaders, items.mid(first, chunkSize)) );
+    }
+
+    if (chunkCount == 0) {
+        m_running = false;
+        emit finished();
+    }
+}
+
+void ItemBackgroundFilter::cancel()
+{
+    m_jobId.fetchAndAddOrdered(1);
+    m_running = false;
+
+    QMutexLocker lock(&m_mutex);
+    m_results.clear();
+}
+
+void ItemBackgroundFilter::taskFinished(int jobId, int chunk, const QVector<bool> &matched)
+{
+    QMutexLocker lock(&m_mutex);
+    --m_runningTasks;
+
+    if ( isCurrentJob(jobId) ) {
+        m_results.insert(chunk, matched);
+        // Object is valid until the waiting destructor gets the lock.
+        QMetaObject::invokeMethod(this, "onTaskFinished", Qt::QueuedConnection);
+    }
+
+    m_tasksFinished.wakeAll();
+}
+
+void ItemBackgroundFilter::onTaskFinished()
+{
+    const int jobId = m_jobId.load();
+
+    while (m_running) {
+        QVector<bool> matched;
+        {
+            QMutexLocker lock(&m_mutex);
+            if ( !m_results.contains(m_nextChunk) )
+                return;
+            matched = m_results.take(m_nextChunk);
+        }
+
+        const QVector<int> rows = m_chunkRows.value(m_nextChunk);
+        ++m_nextChunk;
+
+        emit rowsMatched(rows, matched);
+
+        // Handler can cancel or restart matching.
+        if ( !isCurrentJob(jobId) )
+            return;
+
+        if ( m_nextChunk == m_chunkRows.size() ) {
+            m_running = false;
+            emit finished();
+        }
+    }
+}
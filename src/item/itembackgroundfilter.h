@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ITEMBACKGROUNDFILTER_H
+#define ITEMBACKGROUNDFILTER_H
+
+#include "item/clipboarditem.h"
+#include "item/itemfactory.h"
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QRegExp>
+#include <QVector>
+#include <QWaitCondition>
+
+/**
+ * Matches items against filter expression in worker threads.
+ *
+ * Items are copied and split to chunks which are matched in parallel.
+ * Results are reported in main thread in row order (see rowsMatched())
+ * so the filter can be applied progressively.
+ *
+ * Can be used only if ItemFactory::canMatchInBackground() is true.
+ */
+class ItemBackgroundFilter final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemBackgroundFilter(QObject *parent = nullptr);
+
+    /** Cancels matching and waits for running tasks. */
+    ~ItemBackgroundFilter();
+
+    /**
+     * Start matching @a items from @a rows (cancels any previous matching).
+     */
+    void start(
+            const QRegExp &re, const ItemLoaderList &loaders,
+            const QVector<int> &rows, const QVector<ClipboardItem> &items);
+
+    /** Stop matching, results of pending tasks are dropped. */
+    void cancel();
+
+    /** Return true if items are being matched (until finished() is emitted). */
+    bool isRunning() const { return m_running; }
+
+    /** Return false if matching with given ID was canceled (thread-safe). */
+    bool isCurrentJob(int jobId) const { return m_jobId.load() == jobId; }
+
+    /** Called from worker thread (do not call directly). */
+    void taskFinished(int jobId, int chunk, const QVector<bool> &matched);
+
+signals:
+    /** Items in @a rows were matched; rows are reported in increasing order. */
+    void rowsMatched(const QVector<int> &rows, const QVector<bool> &matched);
+
+    /** All rows were matched. */
+    void finished();
+
+private:
+    Q_INVOKABLE void onTaskFinished();
+
+    // Accessed only from main thread.
+    bool m_running = false;
+    QVector< QVector<int> > m_chunkRows;
+    int m_nextChunk = 0;
+
+    QAtomicInt m_jobId;
+
+    // Guarded by mutex.
+    QMutex m_mutex;
+    QWaitCondition m_tasksFinished;
+    int m_runningTasks = 0;
+    QHash< int, QVector<bool> > m_results;
+};
+
+#endif // ITEMBACKGROUNDFILTER_H
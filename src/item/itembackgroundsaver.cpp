@@ -0,0 +1,139 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itembackgroundsaver.h"
+
+#include "common/log.h"
+#include "item/clipboardmodel.h"
+#include "item/itemsnapshotmodel.h"
+#include "item/itemstore.h"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+
+namespace {
+
+QThreadPool *saveThreadPool()
+{
+    static QThreadPool pool;
+    pool.setMaxThreadCount(1);
+    return &pool;
+}
+
+class SaveItemsTask final : public QRunnable
+{
+public:
+    SaveItemsTask(
+            ItemBackgroundSaver *receiver, const QString &tabName,
+            const QVector<ClipboardItem> &items, const ItemSaverPtr &saver)
+        : m_receiver(receiver)
+        , m_tabName(tabName)
+        , m_items(items)
+        , m_saver(saver)
+    {
+    }
+
+    void run() override
+    {
+        setCurrentThreadName("save");
+
+        bool saved;
+        {
+            const ItemSnapshotModel model(m_items);
+            saved = saveItems(m_tabName, model, m_saver);
+        }
+
+        m_receiver->taskFinished(saved);
+    }
+
+private:
+    ItemBackgroundSaver *m_receiver;
+    QString m_tabName;
+    QVector<ClipboardItem> m_items;
+    ItemSaverPtr m_saver;
+};
+
+} // namespace
+
+ItemBackgroundSaver::ItemBackgroundSaver(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ItemBackgroundSaver::~ItemBackgroundSaver()
+{
+    QMutexLocker lock(&m_mutex);
+    while (m_taskRunning)
+        m_taskFinished.wait(&m_mutex);
+}
+
+void ItemBackgroundSaver::save(const QString &tabName, const ClipboardModel &model, const ItemSaverPtr &saver)
+{
+    Q_ASSERT(!m_saving);
+
+    COPYQ_LOG( QString("Tab \"%1\": Saving items in background").arg(tabName) );
+
+    m_saving = true;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_taskRunning = true;
+    }
+
+    saveThreadPool()->start( new SaveItemsTask(this, tabName, model.itemsSnapshot(), saver) );
+}
+
+void ItemBackgroundSaver::waitForFinished()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_taskRunning)
+            m_taskFinished.wait(&m_mutex);
+    }
+
+    onTaskFinished();
+}
+
+void ItemBackgroundSaver::taskFinished(bool saved)
+{
+    QMutexLocker lock(&m_mutex);
+    m_saved = saved;
+    m_taskRunning = false;
+
+    // Object is valid until the waiting destructor gets the lock.
+    QMetaObject::invokeMethod(this, "onTaskFinished", Qt::QueuedConnection);
+    m_taskFinished.wakeAll();
+}
+
+void ItemBackgroundSaver::onTaskFinished()
+{
+    if (!m_saving)
+        return;
+
+    bool saved;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_taskRunning)
+            return;
+        saved = m_saved;
+    }
+
+    m_saving = false;
+    emit finished(saved);
+}
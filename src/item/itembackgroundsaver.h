@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMBACKGROUNDSAVER_H
+#define ITEMBACKGROUNDSAVER_H
+
+#include "item/itemwidget.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+
+class ClipboardModel;
+
+/**
+ * Saves items of a tab in a separate thread.
+ *
+ * Items are saved from a copy of the model data, so the model can be
+ * changed while saving. All tabs are saved in single thread, one at a time.
+ *
+ * Can be used only if ItemSaverInterface::canSaveItemsInBackground() is true.
+ */
+class ItemBackgroundSaver final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemBackgroundSaver(QObject *parent = nullptr);
+
+    /** Waits for saving to finish. */
+    ~ItemBackgroundSaver();
+
+    /**
+     * Start saving items.
+     *
+     * Must not be called if isSaving() is true.
+     */
+    void save(const QString &tabName, const ClipboardModel &model, const ItemSaverPtr &saver);
+
+    /** Return true if items are being saved (until finished() is emitted). */
+    bool isSaving() const { return m_saving; }
+
+    /**
+     * Block until saving finishes and emit finished() signal.
+     *
+     * Does nothing if items are not being saved.
+     */
+    void waitForFinished();
+
+    /** Called from saving thread (do not call directly). */
+    void taskFinished(bool saved);
+
+signals:
+    void finished(bool saved);
+
+private:
+    Q_INVOKABLE void onTaskFinished();
+
+    // Accessed only from main thread.
+    bool m_saving = false;
+
+    // Guarded by mutex.
+    QMutex m_mutex;
+    QWaitCondition m_taskFinished;
+    bool m_taskRunning = false;
+    bool m_saved = false;
+};
+
+#endif // ITEMBACKGROUNDSAVER_H
@@ -21,7 +21,9 @@
 
 #include "common/client_server.h"
 #include "common/contenttype.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
+#include "common/textdata.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/iconfactory.h"
 #include "item/itemfactory.h"
@@ -37,6 +39,9 @@
 namespace {
 
 const char propertySelectedItem[] = "CopyQ_selected";
+const char propertySizeOutdated[] = "CopyQ_size_outdated";
+
+const int maxStoredSizeHints = 100000;
 
 } // namespace
 
@@ -55,17 +60,17 @@ ItemDelegate::~ItemDelegate() = default;
 
 QSize ItemDelegate::sizeHint(const QModelIndex &index) const
 {
-    const int row = index.row();
-    if ( static_cast<size_t>(row) < m_cache.size() ) {
-        const ItemWidget *w = cacheOrNull(row);
-        if (w != nullptr) {
-            QWidget *ww = w->widget();
-            const auto margins = m_sharedData->theme.margins();
-            const auto rowNumberSize = m_sharedData->theme.rowNumberSize();
-            return QSize( ww->width() + 2 * margins.width() + rowNumberSize.width(),
-                          qMax(ww->height() + 2 * margins.height(), rowNumberSize.height()) );
-        }
+    const ItemWidget *w = cacheOrNull( index.row() );
+    if (w != nullptr)
+        return widgetSizeHint(w);
+
+    const auto &sizeHints = m_sharedData->itemSizeHints;
+    if ( !sizeHints.isEmpty() ) {
+        const auto it = sizeHints.constFind( sizeHintKey(index) );
+        if ( it != sizeHints.constEnd() )
+            return *it;
     }
+
     return QSize(0, 100);
 }
 
@@ -83,8 +88,10 @@ bool ItemDelegate::eventFilter(QObject *obj, QEvent *event)
         Q_ASSERT(row != -1);
 
         const auto index = m_view->model()->index(row, 0);
-        if ( index.isValid() )
+        if ( index.isValid() ) {
+            storeSizeHint(index);
             emit sizeHintChanged(index);
+        }
     }
 
     return QItemDelegate::eventFilter(obj, event);
@@ -93,57 +100,91 @@ bool ItemDelegate::eventFilter(QObject *obj, QEvent *event)
 void ItemDelegate::dataChanged(const QModelIndex &a, const QModelIndex &b)
 {
     for ( int row = a.row(); row <= b.row(); ++row ) {
-        auto item = &m_cache[row];
-        if (*item) {
-            item->reset();
-            cache( m_view->index(row) );
+        auto w = cacheOrNull(row);
+        if (w == nullptr)
+            continue;
+
+        // Widgets outside the viewport are created again only when needed.
+        const auto index = m_view->index(row);
+        if ( w->widget()->isHidden() && m_view->currentIndex() != index ) {
+            setIndexWidget(index, nullptr);
+        } else {
+            setCachedWidget(index, nullptr);
+            cache(index);
         }
     }
 }
 
 void ItemDelegate::rowsRemoved(const QModelIndex &, int start, int end)
 {
-    m_cache.erase(std::begin(m_cache) + start, std::begin(m_cache) + end + 1);
+    const auto isRemoved = [&](const CachedItemWidget &cached) {
+        const int row = cached.index.row();
+        return start <= row && row <= end;
+    };
+    m_cache.erase(
+        std::remove_if(std::begin(m_cache), std::end(m_cache), isRemoved),
+        std::end(m_cache) );
+    invalidateCachedRows();
 }
 
-void ItemDelegate::rowsMoved(const QModelIndex &, int sourceStart, int sourceEnd,
-                             const QModelIndex &, int destinationRow)
+void ItemDelegate::rowsMoved(const QModelIndex &, int, int, const QModelIndex &, int)
 {
-    auto count = sourceEnd - sourceStart + 1;
-    auto from = sourceStart;
-    auto to = destinationRow;
+    invalidateCachedRows();
+}
 
-    if (to < from) {
-        std::swap(from, to);
-        to += count;
-        count = to - from - count;
-    }
+void ItemDelegate::layoutAboutToBeChanged()
+{
+    invalidateCachedRows();
+}
 
-    const auto start1 = std::begin(m_cache) + from;
-    const auto start2 = start1 + count;
-    const auto end2 = std::begin(m_cache) + to;
-    std::rotate(start1, start2, end2);
+void ItemDelegate::layoutChanged()
+{
+    invalidateCachedRows();
+}
+
+void ItemDelegate::rowsInserted(const QModelIndex &, int, int)
+{
+    invalidateCachedRows();
 }
 
-void ItemDelegate::rowsInserted(const QModelIndex &, int start, int end)
+void ItemDelegate::invalidateCachedRows()
 {
-    const auto count = static_cast<size_t>(end - start + 1);
-    const auto oldSize = m_cache.size();
-    m_cache.resize(oldSize + count);
-    std::rotate( std::begin(m_cache) + start,
-                 std::begin(m_cache) + oldSize,
-                 std::end(m_cache) );
+    m_cachedRows.clear();
+    m_cachedRowsValid = false;
+
+    // Drop widgets for items removed without notifying about rows first (e.g. model reset).
+    const auto isRemoved = [](const CachedItemWidget &cached) {
+        return !cached.index.isValid();
+    };
+    m_cache.erase(
+        std::remove_if(std::begin(m_cache), std::end(m_cache), isRemoved),
+        std::end(m_cache) );
 }
 
 ItemWidget *ItemDelegate::cache(const QModelIndex &index)
 {
     const int row = index.row();
     ItemWidget *w = cacheOrNull(row);
+    countMetric(w == nullptr ? "item_widget_cache_misses" : "item_widget_cache_hits");
     if (w == nullptr) {
         auto data = m_view->itemData(index);
         data.insert(mimeCurrentTab, m_view->tabName());
-        w = updateCache(index, data);
-        emit itemWidgetCreated(PersistentDisplayItem(this, data, w->widget()));
+
+        // Avoid running display commands again for the same data.
+        const auto &displayDataCache = m_sharedData->displayDataCache;
+        const auto it = displayDataCache.isEmpty()
+                ? displayDataCache.constEnd()
+                : displayDataCache.constFind( hash(data) );
+        if ( it != displayDataCache.constEnd() ) {
+            w = updateCache(index, it.value());
+        } else {
+            w = updateCache(index, data);
+            emit itemWidgetCreated(PersistentDisplayItem(this, data, w->widget()));
+        }
+    } else if ( w->widget()->property(propertySizeOutdated).toBool() ) {
+        w->widget()->setProperty(propertySizeOutdated, QVariant());
+        if (m_idealWidth > 0)
+            w->updateSize(m_maxSize, m_idealWidth);
     }
 
     return w;
@@ -159,9 +200,16 @@ void ItemDelegate::updateCache(QObject *widget, const QVariantMap &data)
     updateCache(index, data);
 }
 
+void ItemDelegate::removeCache(const QModelIndex &index)
+{
+    if ( hasCache(index) )
+        setIndexWidget(index, nullptr);
+}
+
 ItemWidget *ItemDelegate::cacheOrNull(int row) const
 {
-    return m_cache[static_cast<size_t>(row)].get();
+    const int i = cachedWidgetPosition(row);
+    return i == -1 ? nullptr : m_cache[static_cast<size_t>(i)].widget.get();
 }
 
 bool ItemDelegate::hasCache(const QModelIndex &index) const
@@ -170,6 +218,11 @@ bool ItemDelegate::hasCache(const QModelIndex &index) const
     return cacheOrNull(row) != nullptr;
 }
 
+int ItemDelegate::cachedItemCount() const
+{
+    return static_cast<int>( m_cache.size() );
+}
+
 void ItemDelegate::setItemSizes(QSize size, int idealWidth)
 {
     const auto margins = m_sharedData->theme.margins();
@@ -179,8 +232,13 @@ void ItemDelegate::setItemSizes(QSize size, int idealWidth)
     m_idealWidth = idealWidth - margin;
 
     if (m_idealWidth > 0) {
-        for (auto &w : m_cache) {
-            if (w != nullptr)
+        // Resize hidden widgets only when needed again (see cache()).
+        for (auto &cached : m_cache) {
+            const auto &w = cached.widget;
+            QWidget *ww = w->widget();
+            if ( ww->isHidden() )
+                ww->setProperty(propertySizeOutdated, true);
+            else
                 w->updateSize(m_maxSize, m_idealWidth);
         }
     }
@@ -207,8 +265,9 @@ ItemEditorWidget *ItemDelegate::createCustomEditor(
         QWidget *parent, const QModelIndex &index, bool editNotes)
 {
     cache(index);
-    const int row = index.row();
-    auto editor = new ItemEditorWidget(m_cache[row], index, editNotes, parent);
+    const int i = cachedWidgetPosition( index.row() );
+    Q_ASSERT(i != -1);
+    auto editor = new ItemEditorWidget(m_cache[static_cast<size_t>(i)].widget, index, editNotes, parent);
     editor->setEditorPalette( m_sharedData->theme.editorPalette() );
     editor->setEditorFont( m_sharedData->theme.editorFont() );
     editor->setSaveOnReturnKey(m_sharedData->saveOnReturnKey);
@@ -248,9 +307,8 @@ void ItemDelegate::setItemWidgetCurrent(const QModelIndex &index, bool isCurrent
         w->updateSize(m_maxSize, m_idealWidth);
 }
 
-void ItemDelegate::setItemWidgetSelected(const QModelIndex &index, bool isSelected)
+void ItemDelegate::setItemWidgetSelected(int row, bool isSelected)
 {
-    const int row = index.row();
     auto w = cacheOrNull(row);
     if (!w)
         return;
@@ -263,8 +321,7 @@ void ItemDelegate::setIndexWidget(const QModelIndex &index, ItemWidget *w)
 {
     const QSize oldSize = sizeHint(index);
 
-    const int row = index.row();
-    m_cache[row].reset(w);
+    setCachedWidget(index, w);
     if (w == nullptr)
         return;
 
@@ -281,6 +338,8 @@ void ItemDelegate::setIndexWidget(const QModelIndex &index, ItemWidget *w)
 
     ww->installEventFilter(this);
 
+    storeSizeHint(index);
+
     if ( oldSize != sizeHint(index) )
         emit sizeHintChanged(index);
 }
@@ -301,15 +360,85 @@ void ItemDelegate::setWidgetSelected(QWidget *ww, bool selected)
 
 int ItemDelegate::findWidgetRow(const QObject *obj) const
 {
-    for (int row = 0; static_cast<size_t>(row) < m_cache.size(); ++row) {
-        auto w = cacheOrNull(row);
-        if (w && w->widget() == obj)
-            return row;
+    for (const auto &cached : m_cache) {
+        if (cached.widget->widget() == obj)
+            return cached.index.row();
     }
 
     return -1;
 }
 
+int ItemDelegate::cachedWidgetPosition(int row) const
+{
+    if (!m_cachedRowsValid) {
+        m_cachedRows.clear();
+        m_cachedRows.reserve( static_cast<int>(m_cache.size()) );
+        for (size_t i = 0; i < m_cache.size(); ++i) {
+            const int cachedRow = m_cache[i].index.row();
+            if (cachedRow != -1)
+                m_cachedRows.insert( cachedRow, static_cast<int>(i) );
+        }
+        m_cachedRowsValid = true;
+    }
+
+    const auto it = m_cachedRows.constFind(row);
+    return it == m_cachedRows.constEnd() ? -1 : it.value();
+}
+
+void ItemDelegate::setCachedWidget(const QModelIndex &index, ItemWidget *w)
+{
+    const int row = index.row();
+    const int i = cachedWidgetPosition(row);
+
+    if (i != -1) {
+        auto &cached = m_cache[static_cast<size_t>(i)];
+        if (w != nullptr) {
+            cached.widget.reset(w);
+        } else {
+            // Keep the old widget alive until the cache is consistent again.
+            const auto oldWidget = std::move(cached.widget);
+            std::swap( cached, m_cache.back() );
+            m_cache.pop_back();
+            m_cachedRows.clear();
+            m_cachedRowsValid = false;
+        }
+    } else if (w != nullptr) {
+        m_cache.push_back( CachedItemWidget{QPersistentModelIndex(index), std::shared_ptr<ItemWidget>(w)} );
+        if (m_cachedRowsValid)
+            m_cachedRows.insert( row, static_cast<int>(m_cache.size() - 1) );
+    }
+}
+
+QSize ItemDelegate::widgetSizeHint(const ItemWidget *w) const
+{
+    QWidget *ww = w->widget();
+    const auto margins = m_sharedData->theme.margins();
+    const auto rowNumberSize = m_sharedData->theme.rowNumberSize();
+    return QSize( ww->width() + 2 * margins.width() + rowNumberSize.width(),
+                  qMax(ww->height() + 2 * margins.height(), rowNumberSize.height()) );
+}
+
+QPair<quint64, int> ItemDelegate::sizeHintKey(const QModelIndex &index) const
+{
+    const quint64 itemHash = index.data(contentType::hash).toULongLong();
+    return qMakePair(itemHash, m_idealWidth);
+}
+
+void ItemDelegate::storeSizeHint(const QModelIndex &index)
+{
+    const ItemWidget *w = cacheOrNull(index.row());
+    if (w == nullptr || m_idealWidth <= 0)
+        return;
+
+    auto &sizeHints = m_sharedData->itemSizeHints;
+
+    // Sizes for old widths are mostly useless after resizing window.
+    if ( sizeHints.size() >= maxStoredSizeHints )
+        sizeHints.clear();
+
+    sizeHints.insert( sizeHintKey(index), widgetSizeHint(w) );
+}
+
 ItemWidget *ItemDelegate::updateCache(const QModelIndex &index, const QVariantMap &data)
 {
     const bool antialiasing = m_sharedData->theme.isAntialiasingEnabled();
@@ -398,6 +527,7 @@ void ItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
     ww->move(offset);
     if ( ww->isHidden() ) {
         ww->show();
+        ww->setProperty(propertySizeOutdated, QVariant());
         if (m_idealWidth > 0)
             w->updateSize(m_maxSize, m_idealWidth);
 
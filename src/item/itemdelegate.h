@@ -22,7 +22,10 @@
 
 #include "gui/clipboardbrowsershared.h"
 
+#include <QHash>
 #include <QItemDelegate>
+#include <QPair>
+#include <QPersistentModelIndex>
 #include <QRegExp>
 
 #include <memory>
@@ -42,6 +45,8 @@ class PersistentDisplayItem;
  *
  * To achieve better performance the first call to get sizeHint() value for
  * an item returns some default value (so it doesn't have to render all items).
+ * Sizes of items rendered before are reused (even in other tabs or after
+ * the tab is reloaded) until the settings change.
  *
  * Before calling paint() for an index item on given index must be cached
  * using cache().
@@ -79,12 +84,18 @@ class ItemDelegate : public QItemDelegate
          */
         void updateCache(QObject *widget, const QVariantMap &data);
 
+        /** Remove item widget, it's created again when needed. */
+        void removeCache(const QModelIndex &index);
+
         /** Return cached item or nullptr. */
         ItemWidget *cacheOrNull(int row) const;
 
         /** Return true only if item at index is already in cache. */
         bool hasCache(const QModelIndex &index) const;
 
+        /** Return number of cached item widgets. */
+        int cachedItemCount() const;
+
         /** Set maximum size for all items. */
         void setItemSizes(QSize size, int idealWidth);
 
@@ -114,13 +125,18 @@ class ItemDelegate : public QItemDelegate
          *
          * This changes item appearace according to current theme/style.
          */
-        void setItemWidgetSelected(const QModelIndex &index, bool isSelected);
+        void setItemWidgetSelected(int row, bool isSelected);
 
         void dataChanged(const QModelIndex &a, const QModelIndex &b);
         void rowsRemoved(const QModelIndex &parent, int start, int end);
         void rowsInserted(const QModelIndex &parent, int start, int end);
         void rowsMoved(const QModelIndex &parent, int sourceStart, int sourceEnd,
                        const QModelIndex &destination, int destinationRow);
+        void layoutAboutToBeChanged();
+        void layoutChanged();
+
+        /** Update rows of cached widgets after model rows changed. */
+        void invalidateCachedRows();
 
     signals:
         void itemWidgetCreated(const PersistentDisplayItem &selection);
@@ -139,6 +155,19 @@ class ItemDelegate : public QItemDelegate
 
         int findWidgetRow(const QObject *obj) const;
 
+        /// Return position of cached widget for a row in m_cache or -1.
+        int cachedWidgetPosition(int row) const;
+
+        /// Replace or remove cached widget for index.
+        void setCachedWidget(const QModelIndex &index, ItemWidget *w);
+
+        QSize widgetSizeHint(const ItemWidget *w) const;
+
+        QPair<quint64, int> sizeHintKey(const QModelIndex &index) const;
+
+        /// Remember size of rendered item so it's known after widget is removed.
+        void storeSizeHint(const QModelIndex &index);
+
         ItemWidget *updateCache(const QModelIndex &index, const QVariantMap &data);
 
         ClipboardBrowser *m_view;
@@ -147,7 +176,22 @@ class ItemDelegate : public QItemDelegate
         QSize m_maxSize;
         int m_idealWidth;
 
-        std::vector<std::shared_ptr<ItemWidget>> m_cache;
+        struct CachedItemWidget {
+            QPersistentModelIndex index;
+            std::shared_ptr<ItemWidget> widget;
+        };
+
+        /**
+         * Cached widgets with their items.
+         *
+         * Persistent indexes are kept up to date by the model so inserting,
+         * moving and removing other rows doesn't touch the cache.
+         */
+        std::vector<CachedItemWidget> m_cache;
+
+        /// Positions in m_cache for rows, rebuilt lazily after model rows change.
+        mutable QHash<int, int> m_cachedRows;
+        mutable bool m_cachedRowsValid = false;
 };
 
 #endif // ITEMDELEGATE_H
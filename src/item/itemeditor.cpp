@@ -26,6 +26,7 @@
 
 #include <QDir>
 #include <QFile>
+#include <QFileSystemWatcher>
 #include <QHash>
 #include <QProcess>
 #include <QTemporaryFile>
@@ -35,6 +36,12 @@
 
 namespace {
 
+/// Delay for reading file after change so editor can finish writing it.
+const int fileChangedDelayMsec = 200;
+
+/// Interval for checking file if it cannot be watched.
+const int fileCheckIntervalMsec = 500;
+
 QString getFileSuffixFromMime(const QString &mime)
 {
     if (mime == mimeText)
@@ -69,6 +76,7 @@ ItemEditor::ItemEditor(const QByteArray &data, const QString &mime, const QStrin
     , m_editorcmd(editor)
     , m_editor(nullptr)
     , m_timer( new QTimer(this) )
+    , m_watcher(nullptr)
     , m_info()
     , m_lastmodified()
     , m_lastSize(0)
@@ -118,10 +126,21 @@ bool ItemEditor::start()
     m_info.setFile(fileName);
     m_lastmodified = m_info.lastModified();
     m_lastSize = m_info.size();
-    m_timer->start(500);
     connect( m_timer, &QTimer::timeout,
              this, &ItemEditor::onTimer );
 
+    m_watcher = new QFileSystemWatcher(this);
+    if ( m_watcher->addPath(fileName) ) {
+        m_timer->setSingleShot(true);
+        m_timer->setInterval(fileChangedDelayMsec);
+        connect( m_watcher, &QFileSystemWatcher::fileChanged,
+                 m_timer, static_cast<void (QTimer::*)()>(&QTimer::start) );
+    } else {
+        delete m_watcher;
+        m_watcher = nullptr;
+        m_timer->start(fileCheckIntervalMsec);
+    }
+
     // create editor process
     m_editor = new QProcess(this);
     connectProcessFinished(m_editor, this, &ItemEditor::close);
@@ -204,5 +223,16 @@ void ItemEditor::onTimer()
     } else {
         m_modified = wasFileModified();
     }
+
+    if (m_watcher) {
+        // Editors can save by replacing the file which stops watching it.
+        const QString fileName = m_info.filePath();
+        const bool watching = m_watcher->files().contains(fileName)
+                || m_watcher->addPath(fileName);
+
+        // Check again until file is fully overwritten or can be watched again.
+        if (m_modified || !watching)
+            m_timer->start();
+    }
 }
 
@@ -26,6 +26,7 @@
 #include <QPersistentModelIndex>
 #include <QString>
 
+class QFileSystemWatcher;
 class QModelIndex;
 class QProcess;
 class QTimer;
@@ -94,6 +95,8 @@ class ItemEditor : public QObject
         QString m_editorcmd;
         QProcess *m_editor;
         QTimer *m_timer;
+        // Watches file for changes or null if file is checked periodically.
+        QFileSystemWatcher *m_watcher;
 
         QFileInfo m_info;
         QDateTime m_lastmodified;
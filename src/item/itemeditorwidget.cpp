@@ -20,6 +20,7 @@
 #include "item/itemeditorwidget.h"
 
 #include "common/contenttype.h"
+#include "common/timer.h"
 #include "item/itemwidget.h"
 
 #include "gui/iconfactory.h"
@@ -31,14 +32,23 @@
 #include <QFontDialog>
 #include <QIcon>
 #include <QPlainTextEdit>
+#include <QScrollBar>
+#include <QTextBlock>
 #include <QTextCharFormat>
 #include <QTextCursor>
 #include <QTextDocument>
+#include <QTextEdit>
 #include <QToolBar>
 #include <QVBoxLayout>
 
 namespace {
 
+const int searchDelayMsec = 100;
+const int highlightDelayMsec = 20;
+
+// Avoid creating too many extra selections for matches in long lines.
+const int maxHighlightedMatches = 1000;
+
 const QIcon iconSave() { return getIcon("document-save", IconSave); }
 const QIcon iconCancel() { return getIcon("document-revert", IconTrash); }
 
@@ -71,6 +81,9 @@ ItemEditorWidget::ItemEditorWidget(
     , m_toolBar(nullptr)
     , m_saveOnReturnKey(false)
 {
+    initSingleShotTimer( &m_timerSearch, searchDelayMsec, this, &ItemEditorWidget::searchFromSelectionStart );
+    initSingleShotTimer( &m_timerHighlight, highlightDelayMsec, this, &ItemEditorWidget::highlightMatches );
+
     m_noteEditor = editNotes ? new QPlainTextEdit(parent) : nullptr;
     QWidget *editor = editNotes ? m_noteEditor : createEditor();
 
@@ -137,13 +150,15 @@ void ItemEditorWidget::setSaveOnReturnKey(bool enabled)
 
 void ItemEditorWidget::search(const QRegExp &re)
 {
-    if ( !re.isValid() || re.isEmpty() )
+    m_searchExpression = re;
+    m_timerHighlight.start();
+
+    if ( !re.isValid() || re.isEmpty() ) {
+        m_timerSearch.stop();
         return;
+    }
 
-    auto tc = textCursor();
-    tc.setPosition(tc.selectionStart());
-    setTextCursor(tc);
-    findNext(re);
+    m_timerSearch.start();
 }
 
 void ItemEditorWidget::findNext(const QRegExp &re)
@@ -475,6 +490,81 @@ QTextCursor ItemEditorWidget::textCursor() const
     return QTextCursor();
 }
 
+void ItemEditorWidget::searchFromSelectionStart()
+{
+    m_timerSearch.stop();
+
+    auto tc = textCursor();
+    tc.setPosition(tc.selectionStart());
+    setTextCursor(tc);
+    findNext(m_searchExpression);
+}
+
+void ItemEditorWidget::highlightMatches()
+{
+    m_timerHighlight.stop();
+
+    auto plainTextEdit = editor<QPlainTextEdit>();
+    if (plainTextEdit) {
+        highlightMatches(plainTextEdit);
+    } else {
+        auto textEdit = editor<QTextEdit>();
+        if (textEdit)
+            highlightMatches(textEdit);
+    }
+}
+
+template <typename TextEdit>
+void ItemEditorWidget::highlightMatches(TextEdit *textEdit)
+{
+    // Update highlighted matches when visible part of document changes.
+    QTextDocument *doc = textEdit->document();
+    if (m_highlightedDocument != doc) {
+        m_highlightedDocument = doc;
+        connect( doc, &QTextDocument::contentsChanged,
+                 &m_timerHighlight, static_cast<void (QTimer::*)()>(&QTimer::start) );
+        connect( textEdit->verticalScrollBar(), &QScrollBar::valueChanged,
+                 &m_timerHighlight, static_cast<void (QTimer::*)()>(&QTimer::start) );
+    }
+
+    QList<QTextEdit::ExtraSelection> selections;
+
+    if ( m_searchExpression.isValid() && !m_searchExpression.isEmpty() ) {
+        const QRect rect = textEdit->viewport()->rect();
+        const int begin = textEdit->cursorForPosition(rect.topLeft()).position();
+        const int end = textEdit->cursorForPosition(rect.bottomRight()).position();
+
+        QColor color = textEdit->palette().color(QPalette::Highlight);
+        color.setAlpha(100);
+        QTextCharFormat format;
+        format.setBackground(color);
+
+        for ( auto block = doc->findBlock(begin);
+              block.isValid() && block.position() <= end && selections.size() < maxHighlightedMatches;
+              block = block.next() )
+        {
+            const QString text = block.text();
+            int i = m_searchExpression.indexIn(text);
+            while ( i != -1 && selections.size() < maxHighlightedMatches ) {
+                const int length = m_searchExpression.matchedLength();
+                if (length <= 0)
+                    break;
+
+                QTextEdit::ExtraSelection selection;
+                selection.cursor = QTextCursor(block);
+                selection.cursor.setPosition(block.position() + i);
+                selection.cursor.setPosition(block.position() + i + length, QTextCursor::KeepAnchor);
+                selection.format = format;
+                selections.append(selection);
+
+                i = m_searchExpression.indexIn(text, i + length);
+            }
+        }
+    }
+
+    textEdit->setExtraSelections(selections);
+}
+
 void ItemEditorWidget::setTextCursor(const QTextCursor &tc)
 {
     auto plainTextEdit = editor<QPlainTextEdit>();
@@ -21,7 +21,9 @@
 #define ITEMEDITORWIDGET_H
 
 #include <QPersistentModelIndex>
+#include <QPointer>
 #include <QRegExp>
+#include <QTimer>
 #include <QWidget>
 
 #include <memory>
@@ -90,6 +92,11 @@ private:
     void initMenuItems();
 
     void search(const QRegExp &re, bool backwards);
+    void searchFromSelectionStart();
+
+    void highlightMatches();
+    template <typename TextEdit>
+    void highlightMatches(TextEdit *textEdit);
 
     template <typename TextEdit>
     TextEdit *editor() const;
@@ -104,6 +111,13 @@ private:
     QPlainTextEdit *m_noteEditor;
     QToolBar *m_toolBar;
     bool m_saveOnReturnKey;
+
+    // Search is postponed while typing and only matches in visible part of
+    // document are highlighted so editing big documents isn't slow.
+    QRegExp m_searchExpression;
+    QTimer m_timerSearch;
+    QTimer m_timerHighlight;
+    QPointer<QTextDocument> m_highlightedDocument;
 };
 
 #endif // ITEMEDITORWIDGET_H
@@ -19,6 +19,7 @@
 
 #include "itemfactory.h"
 
+#include "common/appconfig.h"
 #include "common/command.h"
 #include "common/common.h"
 #include "common/config.h"
@@ -33,6 +34,7 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QFileInfo>
 #include <QIODevice>
 #include <QLabel>
 #include <QMetaObject>
@@ -44,6 +46,15 @@
 
 namespace {
 
+/// Return plugin ID from library file name (e.g. "libitemtext.so" -> "itemtext").
+QString pluginIdFromFileName(const QString &fileName)
+{
+    QString id = QFileInfo(fileName).completeBaseName();
+    if ( id.startsWith("lib") )
+        id.remove(0, 3);
+    return id;
+}
+
 bool findPluginDir(QDir *pluginsDir)
 {
     return createPlatformNativeInterface()->findPluginDir(pluginsDir)
@@ -170,10 +181,24 @@ private:
 class DummySaver : public ItemSaverInterface
 {
 public:
+    explicit DummySaver(bool canSaveItemsToJournal = true)
+        : m_canSaveItemsToJournal(canSaveItemsToJournal)
+        , m_minBlobSize( AppConfig().option<Config::item_data_threshold>() )
+    {
+    }
+
     bool saveItems(const QString & /* tabName */, const QAbstractItemModel &model, QIODevice *file) override
     {
-        return serializeData(model, file);
+        return serializeData(model, file, m_minBlobSize);
     }
+
+    bool canSaveItemsToJournal() const override { return m_canSaveItemsToJournal; }
+
+    bool canSaveItemsInBackground() const override { return true; }
+
+private:
+    bool m_canSaveItemsToJournal;
+    int m_minBlobSize;
 };
 
 class DummyLoader : public ItemLoaderInterface
@@ -193,7 +218,7 @@ public:
 
     bool canSaveItems(const QString &) const override { return true; }
 
-    ItemSaverPtr loadItems(const QString &, QAbstractItemModel *model, QIODevice *file, int maxItems) override
+    ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel *model, QIODevice *file, int maxItems) override
     {
         if ( file->size() > 0 ) {
             if ( !deserializeData(model, file, maxItems) ) {
@@ -202,7 +227,9 @@ public:
             }
         }
 
-        return std::make_shared<DummySaver>();
+        // If journal is corrupted, avoid appending to it and save all items next time.
+        const bool journalLoaded = loadItemJournal(tabName, model, maxItems);
+        return std::make_shared<DummySaver>(journalLoaded);
     }
 
     ItemSaverPtr initializeTab(const QString &, QAbstractItemModel *, int) override
@@ -213,7 +240,7 @@ public:
     bool matches(const QModelIndex &index, const QRegExp &re) const override
     {
         const QString text = index.data(contentType::text).toString();
-        return re.indexIn(text) != -1;
+        return matchesFilter(re, text);
     }
 };
 
@@ -265,7 +292,6 @@ ItemSaverPtr saveWithOther(
     return newSaver;
 }
 
-
 } // namespace
 
 ItemFactory::ItemFactory(QObject *parent)
@@ -275,6 +301,7 @@ ItemFactory::ItemFactory(QObject *parent)
     , m_disabledLoaders()
     , m_loaderChildren()
 {
+    updateEnabledLoaders();
 }
 
 ItemFactory::~ItemFactory()
@@ -355,6 +382,7 @@ QStringList ItemFactory::formatsToSave() const
 void ItemFactory::setPluginPriority(const QStringList &pluginNames)
 {
     std::sort( m_loaders.begin(), m_loaders.end(), PluginSorter(pluginNames) );
+    updateEnabledLoaders();
 }
 
 void ItemFactory::setLoaderEnabled(const ItemLoaderPtr &loader, bool enabled)
@@ -364,6 +392,7 @@ void ItemFactory::setLoaderEnabled(const ItemLoaderPtr &loader, bool enabled)
             m_disabledLoaders.remove( m_disabledLoaders.indexOf(loader) );
         else
             m_disabledLoaders.append(loader);
+        updateEnabledLoaders();
     }
 }
 
@@ -396,6 +425,18 @@ ItemSaverPtr ItemFactory::loadItems(const QString &tabName, QAbstractItemModel *
     return nullptr;
 }
 
+bool ItemFactory::isDefaultItemFormat(QIODevice *file) const
+{
+    for ( const auto &loader : enabledLoaders() ) {
+        file->seek(0);
+        if ( loader != m_dummyLoader && loader->canLoadItems(file) )
+            return false;
+    }
+
+    file->seek(0);
+    return true;
+}
+
 ItemSaverPtr ItemFactory::initializeTab(const QString &tabName, QAbstractItemModel *model, int maxItems)
 {
     const auto loaders = enabledLoaders();
@@ -410,6 +451,11 @@ ItemSaverPtr ItemFactory::initializeTab(const QString &tabName, QAbstractItemMod
 }
 
 bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re) const
+{
+    return matches(index, re, enabledLoaders());
+}
+
+bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re, const ItemLoaderList &loaders)
 {
     // Match formats if the filter expression contains single '/'.
     if (re.pattern().count('/') == 1) {
@@ -420,14 +466,72 @@ bool ItemFactory::matches(const QModelIndex &index, const QRegExp &re) const
         }
     }
 
-    for ( const auto &loader : enabledLoaders() ) {
-        if ( isLoaderEnabled(loader) && loader->matches(index, re) )
+    for ( const auto &loader : loaders ) {
+        if ( loader->matches(index, re) )
             return true;
     }
 
     return false;
 }
 
+QVector<bool> ItemFactory::matches(
+        const QList<QModelIndex> &indexes, const QRegExp &re, const ItemLoaderList &loaders)
+{
+    QVector<bool> matched(indexes.size(), false);
+
+    // Match formats if the filter expression contains single '/'.
+    if (re.pattern().count('/') == 1) {
+        for (int i = 0; i < indexes.size(); ++i) {
+            const QVariantMap data = indexes[i].data(contentType::data).toMap();
+            for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+                if ( re.exactMatch(it.key()) ) {
+                    matched[i] = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    for ( const auto &loader : loaders )
+        loader->matchItems(indexes, re, &matched);
+
+    return matched;
+}
+
+bool ItemFactory::canMatchInBackground() const
+{
+    for ( const auto &loader : enabledLoaders() ) {
+        if ( !loader->canMatchInBackground() )
+            return false;
+    }
+
+    return true;
+}
+
+bool ItemFactory::isFilterNarrowed(const QRegExp &previousRe, const QRegExp &re) const
+{
+    if ( previousRe.caseSensitivity() != re.caseSensitivity()
+         || previousRe.patternSyntax() != re.patternSyntax()
+         || previousRe.isMinimal() != re.isMinimal() )
+    {
+        return false;
+    }
+
+    const QString previousPattern = previousRe.pattern();
+    const QString pattern = re.pattern();
+
+    // Formats are matched if the expression contains single '/' (see matches()).
+    if ( previousPattern.isEmpty() || !pattern.startsWith(previousPattern) || pattern.count('/') == 1 )
+        return false;
+
+    if (re.patternSyntax() == QRegExp::FixedString)
+        return true;
+
+    return (re.patternSyntax() == QRegExp::RegExp || re.patternSyntax() == QRegExp::RegExp2)
+            && splitWordsPattern(previousPattern)
+            && splitWordsPattern(pattern);
+}
+
 QList<ItemScriptable*> ItemFactory::scriptableObjects() const
 {
     QList<ItemScriptable*> scriptables;
@@ -496,7 +600,7 @@ ItemWidget *ItemFactory::otherItemLoader(
     return nullptr;
 }
 
-bool ItemFactory::loadPlugins()
+bool ItemFactory::loadPlugins(const QStringList &skipPluginIds)
 {
 #ifdef COPYQ_PLUGIN_PREFIX
     QDir pluginsDir(COPYQ_PLUGIN_PREFIX);
@@ -510,6 +614,11 @@ bool ItemFactory::loadPlugins()
 
     for (const auto &fileName : pluginsDir.entryList(QDir::Files)) {
         if ( QLibrary::isLibrary(fileName) ) {
+            if ( skipPluginIds.contains(pluginIdFromFileName(fileName)) ) {
+                COPYQ_LOG_VERBOSE( QString("Skipping disabled plugin: %1").arg(fileName) );
+                continue;
+            }
+
             const QString path = pluginsDir.absoluteFilePath(fileName);
             QPluginLoader pluginLoader(path);
             QObject *plugin = pluginLoader.instance();
@@ -527,10 +636,25 @@ bool ItemFactory::loadPlugins()
     }
 
     std::sort(m_loaders.begin(), m_loaders.end(), priorityLessThan);
+    updateEnabledLoaders();
 
     return true;
 }
 
+QStringList ItemFactory::disabledPluginIds(QSettings *settings)
+{
+    QStringList ids;
+
+    settings->beginGroup("Plugins");
+    for ( const auto &id : settings->childGroups() ) {
+        if ( !settings->value(id + "/enabled", true).toBool() )
+            ids.append(id);
+    }
+    settings->endGroup();
+
+    return ids;
+}
+
 void ItemFactory::loadItemFactorySettings(QSettings *settings)
 {
     // load settings for each plugin
@@ -555,18 +679,16 @@ void ItemFactory::loadItemFactorySettings(QSettings *settings)
     setPluginPriority(pluginPriority);
 }
 
-ItemLoaderList ItemFactory::enabledLoaders() const
+void ItemFactory::updateEnabledLoaders()
 {
-    ItemLoaderList enabledLoaders;
+    m_enabledLoaders.clear();
 
     for (auto &loader : m_loaders) {
         if ( isLoaderEnabled(loader) )
-            enabledLoaders.append(loader);
+            m_enabledLoaders.append(loader);
     }
 
-    enabledLoaders.append(m_dummyLoader);
-
-    return enabledLoaders;
+    m_enabledLoaders.append(m_dummyLoader);
 }
 
 ItemWidget *ItemFactory::transformItem(ItemWidget *item, const QVariantMap &data)
@@ -585,6 +707,7 @@ ItemWidget *ItemFactory::transformItem(ItemWidget *item, const QVariantMap &data
 void ItemFactory::addLoader(const ItemLoaderPtr &loader)
 {
     m_loaders.append(loader);
+    updateEnabledLoaders();
     const QObject *signaler = loader->signaler();
     if (signaler) {
         const auto loaderMetaObject = signaler->metaObject();
@@ -119,6 +119,12 @@ public:
      */
     ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel *model, QIODevice *file, int maxItems);
 
+    /**
+     * Return true if items in @a file are not in format of any plugin
+     * so these can be deserialized directly (see deserializeData()).
+     */
+    bool isDefaultItemFormat(QIODevice *file) const;
+
     /**
      * Initialize tab.
      * @return the first plugin (or nullptr) for which ItemLoaderInterface::initializeTab() returned true
@@ -130,6 +136,39 @@ public:
      */
     bool matches(const QModelIndex &index, const QRegExp &re) const;
 
+    /**
+     * Same as above but uses given plugins (see matchingLoaders()).
+     *
+     * Can be called from a different thread if all plugins support it
+     * (see canMatchInBackground()).
+     */
+    static bool matches(const QModelIndex &index, const QRegExp &re, const ItemLoaderList &loaders);
+
+    /**
+     * Same as above but matches multiple items at once.
+     *
+     * Returns list with true for each matching item.
+     */
+    static QVector<bool> matches(
+            const QList<QModelIndex> &indexes, const QRegExp &re, const ItemLoaderList &loaders);
+
+    /** Return plugins used to match items. */
+    ItemLoaderList matchingLoaders() const { return enabledLoaders(); }
+
+    /**
+     * Return true only if all plugins can match items in a different thread
+     * (see ItemLoaderInterface::canMatchInBackground()).
+     */
+    bool canMatchInBackground() const;
+
+    /**
+     * Return true if every item matching @a re also matches @a previousRe.
+     *
+     * This is the case if new filter only appends text to previous one,
+     * so only items matching previous filter need to be checked again.
+     */
+    bool isFilterNarrowed(const QRegExp &previousRe, const QRegExp &re) const;
+
     QList<ItemScriptable*> scriptableObjects() const;
 
     /**
@@ -139,7 +178,19 @@ public:
 
     void emitError(const QString &errorString);
 
-    bool loadPlugins();
+    /**
+     * Load plugins from plugin directory.
+     *
+     * Plugins with IDs in @a skipPluginIds are not loaded.
+     */
+    bool loadPlugins(const QStringList &skipPluginIds = QStringList());
+
+    /**
+     * Return IDs of plugins disabled in configuration.
+     *
+     * Clients can skip loading these since only enabled plugins are used.
+     */
+    static QStringList disabledPluginIds(QSettings *settings);
 
     void loadItemFactorySettings(QSettings *settings);
 
@@ -152,7 +203,10 @@ private:
     void loaderChildDestroyed(QObject *obj);
 
     /** Return enabled plugins with dummy item loader. */
-    ItemLoaderList enabledLoaders() const;
+    const ItemLoaderList &enabledLoaders() const { return m_enabledLoaders; }
+
+    /** Update enabled plugins after plugins, priority or enabled state change. */
+    void updateEnabledLoaders();
 
     /** Calls ItemLoaderInterface::transform() for all plugins in reverse order. */
     ItemWidget *transformItem(ItemWidget *item, const QVariantMap &data);
@@ -162,6 +216,8 @@ private:
     ItemLoaderList m_loaders;
     ItemLoaderPtr m_dummyLoader;
     ItemLoaderList m_disabledLoaders;
+    /// Enabled plugins in priority order, avoids rebuilding the list for each item.
+    ItemLoaderList m_enabledLoaders;
     QMap<QObject *, ItemLoaderPtr> m_loaderChildren;
 };
 
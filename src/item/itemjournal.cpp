@@ -0,0 +1,465 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemjournal.h"
+
+#include "common/contenttype.h"
+#include "item/serialize.h"
+
+#include <QAbstractItemModel>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QIODevice>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+
+const quint32 journalMagic = 0x43514a32; // "CQJ2"
+
+// Journal identifying tab file only by size and checksum of its prefix.
+const quint32 legacyJournalMagic = 0x43514a31; // "CQJ1"
+
+// Size of tab file prefix used to identify the file in legacy journals.
+const qint64 tabFileChecksumSize = 4096;
+
+enum RecordType {
+    RecordInsert = 1,
+    RecordRemove = 2,
+    RecordMove = 3,
+    RecordUpdate = 4,
+    // Created and last used time of items (without item data).
+    RecordTimes = 5,
+    // Hashes of blobs referenced by items in the block (always the first record).
+    RecordBlobs = 6
+};
+
+quint16 tabFileChecksum(QIODevice *tabFile)
+{
+    tabFile->seek(0);
+    const QByteArray bytes = tabFile->read(tabFileChecksumSize);
+    return qChecksum( bytes.constData(), static_cast<uint>(bytes.size()) );
+}
+
+/// Hash of whole tab file content.
+QByteArray tabFileHash(QIODevice *tabFile)
+{
+    tabFile->seek(0);
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    QByteArray bytes;
+    while ( !(bytes = tabFile->read(1024 * 1024)).isEmpty() )
+        hash.addData(bytes);
+    return hash.result();
+}
+
+struct JournalHeader {
+    quint32 magic = 0;
+    qint64 tabFileSize = -1;
+    quint16 tabFileChecksum = 0;
+    QByteArray tabFileHash;
+};
+
+bool readJournalHeader(QDataStream *stream, JournalHeader *header)
+{
+    *stream >> header->magic >> header->tabFileSize;
+    if (header->magic == journalMagic)
+        *stream >> header->tabFileHash;
+    else if (header->magic == legacyJournalMagic)
+        *stream >> header->tabFileChecksum;
+    else
+        return false;
+
+    return stream->status() == QDataStream::Ok;
+}
+
+/// Change record read from journal, applied only after whole block is read and verified.
+struct ReplayRecord {
+    quint8 type = 0;
+    qint32 row = 0;
+    qint32 count = 0;
+    qint32 destinationRow = -1;
+    QVariantList items;
+    QVector<qint64> times;
+};
+
+bool setItems(QAbstractItemModel *model, int row, const QVariantList &items)
+{
+    for (int i = 0; i < items.size(); ++i) {
+        const QModelIndex index = model->index(row + i, 0);
+        if ( !index.isValid() )
+            return false;
+        model->setData( index, items[i], contentType::data );
+    }
+    return true;
+}
+
+bool setTimes(QAbstractItemModel *model, int row, const QVector<qint64> &times)
+{
+    for (int i = 0; 2 * i + 1 < times.size(); ++i) {
+        const QModelIndex index = model->index(row + i, 0);
+        if ( !index.isValid() )
+            return false;
+        model->setData( index, times[2 * i], contentType::createdTime );
+        model->setData( index, times[2 * i + 1], contentType::lastUsedTime );
+    }
+    return true;
+}
+
+bool readRecord(QDataStream *stream, ReplayRecord *record)
+{
+    *stream >> record->type >> record->row >> record->count;
+    if ( stream->status() != QDataStream::Ok || record->row < 0 || record->count <= 0 )
+        return false;
+
+    const qint32 count = record->count;
+    switch (record->type) {
+    case RecordMove:
+        *stream >> record->destinationRow;
+        break;
+    case RecordTimes:
+        record->times.resize(2 * count);
+        for (auto &time : record->times)
+            *stream >> time;
+        break;
+    case RecordBlobs: {
+        QString hash;
+        for (qint32 i = 0; i < count && stream->status() == QDataStream::Ok; ++i)
+            *stream >> hash;
+        break;
+    }
+    case RecordInsert:
+    case RecordUpdate:
+        for (qint32 i = 0; i < count && stream->status() == QDataStream::Ok; ++i) {
+            QVariantMap data;
+            deserializeStoredData(stream, &data);
+            record->items.append(data);
+        }
+        break;
+    case RecordRemove:
+        break;
+    default:
+        return false;
+    }
+
+    return stream->status() == QDataStream::Ok;
+}
+
+/// Returns true only if record can be applied to model with @a rowCount rows and updates the row count.
+bool verifyRecord(const ReplayRecord &record, int *rowCount)
+{
+    const qint64 end = static_cast<qint64>(record.row) + record.count;
+    switch (record.type) {
+    case RecordInsert:
+        if (record.row > *rowCount)
+            return false;
+        *rowCount += record.count;
+        return true;
+    case RecordRemove:
+        if (end > *rowCount)
+            return false;
+        *rowCount -= record.count;
+        return true;
+    case RecordMove:
+        return end <= *rowCount
+            && record.destinationRow >= 0 && record.destinationRow <= *rowCount;
+    case RecordUpdate:
+    case RecordTimes:
+        return end <= *rowCount;
+    case RecordBlobs:
+        return true;
+    }
+
+    return false;
+}
+
+bool applyRecord(QAbstractItemModel *model, const ReplayRecord &record)
+{
+    switch (record.type) {
+    case RecordInsert:
+        return model->insertRows(record.row, record.count) && setItems(model, record.row, record.items);
+    case RecordRemove:
+        return model->removeRows(record.row, record.count);
+    case RecordMove:
+        return model->moveRows(
+                    QModelIndex(), record.row, record.count, QModelIndex(), record.destinationRow);
+    case RecordUpdate:
+        return setItems(model, record.row, record.items);
+    case RecordTimes:
+        return setTimes(model, record.row, record.times);
+    case RecordBlobs:
+        return true;
+    }
+
+    return false;
+}
+
+/// Reads and verifies all records of a block so that invalid block is not partially applied.
+bool readBlock(const QByteArray &block, int rowCount, QVector<ReplayRecord> *records)
+{
+    QDataStream blockStream(block);
+    blockStream.setVersion(QDataStream::Qt_4_7);
+
+    qint32 recordCount;
+    blockStream >> recordCount;
+    if ( blockStream.status() != QDataStream::Ok || recordCount < 0 )
+        return false;
+
+    for (qint32 i = 0; i < recordCount; ++i) {
+        ReplayRecord record;
+        if ( !readRecord(&blockStream, &record) || !verifyRecord(record, &rowCount) )
+            return false;
+        records->append(record);
+    }
+
+    return blockStream.atEnd();
+}
+
+} // namespace
+
+ItemJournal::ItemJournal(QAbstractItemModel *model, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+{
+    connect( model, &QAbstractItemModel::rowsInserted,
+             this, &ItemJournal::onRowsInserted );
+    connect( model, &QAbstractItemModel::rowsRemoved,
+             this, &ItemJournal::onRowsRemoved );
+    connect( model, &QAbstractItemModel::rowsMoved,
+             this, &ItemJournal::onRowsMoved );
+    connect( model, &QAbstractItemModel::dataChanged,
+             this, &ItemJournal::onDataChanged );
+    connect( model, &QAbstractItemModel::modelReset,
+             this, &ItemJournal::invalidate );
+    connect( model, &QAbstractItemModel::layoutChanged,
+             this, &ItemJournal::invalidate );
+}
+
+void ItemJournal::reset()
+{
+    m_records.clear();
+    m_valid = true;
+}
+
+void ItemJournal::invalidate()
+{
+    m_records.clear();
+    m_valid = false;
+}
+
+QByteArray ItemJournal::serializeBlock() const
+{
+    // Blobs in journal must be kept until all items are saved
+    // (see itemJournalBlobReferences()).
+    QSet<QString> blobs;
+    for (const auto &record : m_records) {
+        for (const auto &item : record.items) {
+            if ( item.userType() == qMetaTypeId<SerializedItemData>() )
+                blobs.unite( serializedItemBlobs(item.value<SerializedItemData>().bytes).toSet() );
+        }
+    }
+
+    QByteArray bytes;
+    QDataStream stream(&bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    stream << static_cast<qint32>(m_records.size() + (blobs.isEmpty() ? 0 : 1));
+
+    if ( !blobs.isEmpty() ) {
+        stream << static_cast<quint8>(RecordBlobs)
+               << static_cast<qint32>(0)
+               << static_cast<qint32>(blobs.size());
+        for (const auto &hash : blobs)
+            stream << hash;
+    }
+
+    for (const auto &record : m_records) {
+        stream << static_cast<quint8>(record.type)
+               << static_cast<qint32>(record.row)
+               << static_cast<qint32>(record.count);
+
+        if (record.type == RecordMove)
+            stream << static_cast<qint32>(record.destinationRow);
+
+        for (const auto time : record.times)
+            stream << time;
+
+        for (const auto &item : record.items) {
+            // Serialized items are written as is (blobs are only referenced).
+            if ( item.userType() == qMetaTypeId<SerializedItemData>() ) {
+                const QByteArray bytes = item.value<SerializedItemData>().bytes;
+                stream.writeRawData( bytes.constData(), bytes.size() );
+            } else {
+                serializeStoredData( &stream, item.toMap() );
+            }
+        }
+    }
+
+    return bytes;
+}
+
+void ItemJournal::onRowsInserted(const QModelIndex &, int first, int last)
+{
+    addRecord(RecordInsert, first, last - first + 1);
+    // Replayed items would get current time otherwise.
+    addRecord(RecordTimes, first, last - first + 1);
+}
+
+void ItemJournal::onRowsRemoved(const QModelIndex &, int first, int last)
+{
+    addRecord(RecordRemove, first, last - first + 1);
+}
+
+void ItemJournal::onRowsMoved(const QModelIndex &, int first, int last, const QModelIndex &, int row)
+{
+    addRecord(RecordMove, first, last - first + 1, row);
+}
+
+void ItemJournal::onDataChanged(
+        const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles)
+{
+    // Item data are not stored again if only times change (e.g. item is copied).
+    const bool onlyTimesChanged = !roles.isEmpty() && std::all_of(
+                std::begin(roles), std::end(roles), [](int role) {
+                    return role == contentType::createdTime || role == contentType::lastUsedTime;
+                });
+    const int type = onlyTimesChanged ? RecordTimes : RecordUpdate;
+    addRecord(type, topLeft.row(), bottomRight.row() - topLeft.row() + 1);
+}
+
+void ItemJournal::addRecord(int type, int row, int count, int destinationRow)
+{
+    if (!m_valid || row < 0 || count <= 0)
+        return;
+
+    Record record{type, row, count, destinationRow, QVariantList(), QVector<qint64>()};
+
+    if (type == RecordInsert || type == RecordUpdate) {
+        record.items.reserve(count);
+        for (int i = row; i < row + count; ++i) {
+            const QModelIndex index = m_model->index(i, 0);
+            const QVariant serializedData = index.data(contentType::serializedData);
+            record.items.append(
+                serializedData.isValid() ? serializedData : index.data(contentType::data) );
+        }
+    } else if (type == RecordTimes) {
+        record.times.reserve(2 * count);
+        for (int i = row; i < row + count; ++i) {
+            const QModelIndex index = m_model->index(i, 0);
+            record.times.append( index.data(contentType::createdTime).toLongLong() );
+            record.times.append( index.data(contentType::lastUsedTime).toLongLong() );
+        }
+    }
+
+    m_records.append(record);
+}
+
+void writeItemJournalHeader(QIODevice *journal, QIODevice *tabFile)
+{
+    QDataStream stream(journal);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << journalMagic
+           << static_cast<qint64>(tabFile->size())
+           << tabFileHash(tabFile);
+}
+
+bool isItemJournalValid(QIODevice *journal, QIODevice *tabFile)
+{
+    QDataStream stream(journal);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    JournalHeader header;
+    if ( !readJournalHeader(&stream, &header) || header.tabFileSize != tabFile->size() )
+        return false;
+
+    if (header.magic == legacyJournalMagic)
+        return header.tabFileChecksum == tabFileChecksum(tabFile);
+
+    return header.tabFileHash == tabFileHash(tabFile);
+}
+
+QStringList itemJournalBlobReferences(QIODevice *journal)
+{
+    QDataStream stream(journal);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    JournalHeader header;
+    if ( !readJournalHeader(&stream, &header) )
+        return QStringList();
+
+    QStringList blobs;
+    while ( !stream.atEnd() ) {
+        QByteArray block;
+        stream >> block;
+        if ( stream.status() != QDataStream::Ok )
+            break;
+
+        QDataStream blockStream(block);
+        blockStream.setVersion(QDataStream::Qt_4_7);
+
+        qint32 recordCount;
+        quint8 type;
+        qint32 row;
+        qint32 count;
+        blockStream >> recordCount >> type >> row >> count;
+        if ( blockStream.status() != QDataStream::Ok || recordCount <= 0 || type != RecordBlobs )
+            continue;
+
+        QString hash;
+        for (qint32 i = 0; i < count && blockStream.status() == QDataStream::Ok; ++i) {
+            blockStream >> hash;
+            blobs.append(hash);
+        }
+    }
+
+    return blobs;
+}
+
+bool replayItemJournal(QAbstractItemModel *model, QIODevice *file, int maxItems)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    while ( !stream.atEnd() ) {
+        const qint64 blockStart = file->pos();
+        QByteArray block;
+        stream >> block;
+        if ( stream.status() != QDataStream::Ok ) {
+            file->seek(blockStart);
+            break;
+        }
+
+        QVector<ReplayRecord> records;
+        if ( !readBlock(block, model->rowCount(), &records) )
+            return false;
+
+        for (const auto &record : records) {
+            if ( !applyRecord(model, record) )
+                return false;
+        }
+    }
+
+    const int rowCount = model->rowCount();
+    if (rowCount > maxItems)
+        model->removeRows(maxItems, rowCount - maxItems);
+
+    return true;
+}
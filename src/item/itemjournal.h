@@ -0,0 +1,117 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMJOURNAL_H
+#define ITEMJOURNAL_H
+
+#include <QObject>
+#include <QVariantList>
+#include <QVector>
+
+class QAbstractItemModel;
+class QByteArray;
+class QIODevice;
+class QModelIndex;
+class QStringList;
+
+/**
+ * Records changes in item model so they can be appended to tab journal file
+ * instead of saving all items.
+ *
+ * Journal file starts with header identifying the tab file it belongs to
+ * (see writeItemJournalHeader()) followed by blocks of change records.
+ */
+class ItemJournal final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemJournal(QAbstractItemModel *model, QObject *parent = nullptr);
+
+    /**
+     * Return true only if all changes since last reset() were recorded.
+     *
+     * Changes cannot be recorded if model is reset or its layout changes.
+     */
+    bool isValid() const { return m_valid; }
+
+    /** Return true if there are no recorded changes. */
+    bool isEmpty() const { return m_records.isEmpty(); }
+
+    /** Drop recorded changes and start recording again (items were saved). */
+    void reset();
+
+    /** Drop recorded changes and disable appending to journal until reset(). */
+    void invalidate();
+
+    /** Serialize recorded changes into single journal block. */
+    QByteArray serializeBlock() const;
+
+private:
+    struct Record {
+        int type;
+        int row;
+        int count;
+        int destinationRow;
+        QVariantList items;
+        /// Created and last used time for each item.
+        QVector<qint64> times;
+    };
+
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &parent, int first, int last, const QModelIndex &, int row);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight, const QVector<int> &roles);
+
+    void addRecord(int type, int row, int count, int destinationRow = -1);
+
+    QAbstractItemModel *m_model;
+    QVector<Record> m_records;
+    bool m_valid = true;
+};
+
+/**
+ * Write journal header for tab file with given content @a tabFile.
+ */
+void writeItemJournalHeader(QIODevice *journal, QIODevice *tabFile);
+
+/**
+ * Return true only if journal was created for the tab file.
+ *
+ * Journal header contains size and hash of the whole tab file.
+ */
+bool isItemJournalValid(QIODevice *journal, QIODevice *tabFile);
+
+/**
+ * Return hashes of data stored in blob directory referenced from journal.
+ */
+QStringList itemJournalBlobReferences(QIODevice *journal);
+
+/**
+ * Apply changes from journal blocks to model.
+ *
+ * Each block is read and verified before applying any of its changes.
+ *
+ * Journal device must be positioned after the header.
+ * Incomplete trailing block, e.g. if application crashed while writing it, is skipped
+ * and the device is left positioned at its start.
+ */
+bool replayItemJournal(QAbstractItemModel *model, QIODevice *file, int maxItems);
+
+#endif // ITEMJOURNAL_H
@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsearch.h"
+
+#include "common/contenttype.h"
+#include "item/clipboardmodel.h"
+#include "item/itemfactory.h"
+#include "item/itemstore.h"
+#include "item/itemtextindex.h"
+
+#include <QRegExp>
+
+#include <algorithm>
+
+void addItemSearchHits(
+        const QString &tabName, const QAbstractItemModel &model, const QVector<int> &rows,
+        const QRegExp &re, const ItemFactory &itemFactory, QVector<ItemSearchHit> *hits)
+{
+    for (const int row : rows) {
+        const QModelIndex index = model.index(row, 0);
+        if ( !itemFactory.matches(index, re) )
+            continue;
+
+        const QString text = index.data(contentType::text).toString();
+        const quint64 hash = index.data(contentType::hash).toULongLong();
+        hits->append( ItemSearchHit{tabName, row, hash, re.indexIn(text)} );
+    }
+}
+
+bool searchItemsInTabFile(
+        const QString &tabName, const QRegExp &re, ItemFactory *itemFactory, int maxItems,
+        QVector<ItemSearchHit> *hits)
+{
+    ClipboardModel model;
+    if ( !loadItemsForReading(tabName, &model, itemFactory, maxItems) )
+        return false;
+
+    QVector<int> rows;
+    if ( ItemTextIndex::canFindCandidates(re) ) {
+        ItemTextIndex textIndex(&model);
+        loadItemTextIndex(tabName, &textIndex);
+        textIndex.build();
+        textIndex.candidateRows(re, &rows);
+        // Next search in the tab won't need to decode the items.
+        saveItemTextIndex(tabName, &textIndex);
+    } else {
+        rows.reserve( model.rowCount() );
+        for (int row = 0; row < model.rowCount(); ++row)
+            rows.append(row);
+    }
+
+    addItemSearchHits(tabName, model, rows, re, *itemFactory, hits);
+    return true;
+}
+
+bool findItemsInTabFile(
+        const QString &tabName, quint64 hash, ItemFactory *itemFactory, int maxItems,
+        QVector<ItemSearchHit> *hits)
+{
+    ClipboardModel model;
+    if ( !loadItemsForReading(tabName, &model, itemFactory, maxItems) )
+        return false;
+
+    for ( const int row : model.findItems(hash) )
+        hits->append( ItemSearchHit{tabName, row, hash, -1} );
+    return true;
+}
+
+void sortItemSearchHits(QVector<ItemSearchHit> *hits)
+{
+    // Only match at the beginning is more relevant, other hits keep their order.
+    const auto key = [](const ItemSearchHit &hit) {
+        return hit.position == 0 ? 0 : 1;
+    };
+
+    std::stable_sort( hits->begin(), hits->end(),
+                      [&](const ItemSearchHit &lhs, const ItemSearchHit &rhs) {
+                          return key(lhs) < key(rhs);
+                      } );
+}
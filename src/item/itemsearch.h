@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ITEMSEARCH_H
+#define ITEMSEARCH_H
+
+#include <QString>
+#include <QVector>
+
+class ItemFactory;
+class QAbstractItemModel;
+class QRegExp;
+
+/// Item found by searching in tabs.
+struct ItemSearchHit {
+    QString tabName;
+    int row;
+    quint64 hash;
+    /// Position of the first match in item text or -1 if other data matched.
+    int position;
+};
+
+/**
+ * Append items from @a rows of @a model which match @a re to @a hits.
+ */
+void addItemSearchHits(
+        const QString &tabName, const QAbstractItemModel &model, const QVector<int> &rows,
+        const QRegExp &re, const ItemFactory &itemFactory, QVector<ItemSearchHit> *hits);
+
+/**
+ * Search saved items of tab which is not loaded.
+ *
+ * Items are read into temporary model and only candidates found in text
+ * index of the tab (see ItemTextIndex) are decoded and matched.
+ *
+ * @return false if the tab cannot be searched this way (see loadItemsForReading())
+ */
+bool searchItemsInTabFile(
+        const QString &tabName, const QRegExp &re, ItemFactory *itemFactory, int maxItems,
+        QVector<ItemSearchHit> *hits);
+
+/**
+ * Find items with data @a hash in saved items of tab which is not loaded.
+ *
+ * Item data are not decoded since hashes are stored in tab file.
+ * Position of hits is -1.
+ *
+ * @return false if the tab cannot be searched this way (see loadItemsForReading())
+ */
+bool findItemsInTabFile(
+        const QString &tabName, quint64 hash, ItemFactory *itemFactory, int maxItems,
+        QVector<ItemSearchHit> *hits);
+
+/**
+ * Sort hits from the most relevant.
+ *
+ * Items with match at the beginning of text go first, otherwise order
+ * of tabs and rows is kept.
+ */
+void sortItemSearchHits(QVector<ItemSearchHit> *hits);
+
+#endif // ITEMSEARCH_H
@@ -0,0 +1,38 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemsnapshotmodel.h"
+
+ItemSnapshotModel::ItemSnapshotModel(const QVector<ClipboardItem> &items)
+    : m_items(items)
+{
+}
+
+int ItemSnapshotModel::rowCount(const QModelIndex &) const
+{
+    return m_items.size();
+}
+
+QVariant ItemSnapshotModel::data(const QModelIndex &index, int role) const
+{
+    if ( !index.isValid() || index.row() >= m_items.size() )
+        return QVariant();
+
+    return m_items[index.row()].data(role);
+}
@@ -0,0 +1,47 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef ITEMSNAPSHOTMODEL_H
+#define ITEMSNAPSHOTMODEL_H
+
+#include "item/clipboarditem.h"
+
+#include <QAbstractListModel>
+#include <QVector>
+
+/**
+ * Read-only model with copy of items (see ClipboardModel::itemsSnapshot()).
+ *
+ * Can be used from other thread than the one that created the items.
+ */
+class ItemSnapshotModel final : public QAbstractListModel
+{
+public:
+    explicit ItemSnapshotModel(const QVector<ClipboardItem> &items);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+
+private:
+    QVector<ClipboardItem> m_items;
+};
+
+#endif // ITEMSNAPSHOTMODEL_H
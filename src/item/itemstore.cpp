@@ -23,10 +23,28 @@
 #include "common/log.h"
 #include "common/textdata.h"
 #include "item/itemfactory.h"
+#include "item/itemjournal.h"
+#include "item/itemtextindex.h"
+#include "item/serialize.h"
 
 #include <QAbstractItemModel>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLockFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+
+#ifdef Q_OS_LINUX
+#   include <fcntl.h>
+#endif
 
 namespace {
 
@@ -38,6 +56,27 @@ QString itemFileName(const QString &id)
     return getConfigurationFilePath("_tab_") + part + QString(".dat");
 }
 
+/// @return File name for journal with changes since items were last saved.
+QString itemJournalFileName(const QString &id)
+{
+    return itemFileName(id) + ".log";
+}
+
+/// @return File name for trigram index of item texts.
+QString itemTextIndexFileName(const QString &id)
+{
+    return itemFileName(id) + ".idx";
+}
+
+/// Journal is compacted (all items are saved) once it grows bigger than this fraction of tab file.
+const qint64 journalToTabFileSizeRatio = 2;
+
+/// Small journals are never compacted.
+const qint64 minJournalSizeToCompact = 1024 * 1024;
+
+/// Guards tab and blob files since tabs can be saved in background thread.
+Q_GLOBAL_STATIC(QMutex, itemFileMutex)
+
 bool createItemDirectory()
 {
     QDir settingsDir( settingsDirectoryPath() );
@@ -52,6 +91,249 @@ bool createItemDirectory()
     return true;
 }
 
+/// Unreferenced blobs in shared directory are kept for some time since these can be used by unsaved items of other sessions.
+const qint64 minSharedBlobAgeSeconds = 60 * 60;
+
+/// @return Prefix for file names of tabs of current session.
+QString tabFilePrefix()
+{
+    return getConfigurationFilePath("_tab_");
+}
+
+/// @return Directory where each session sharing blob directory lists its blob references.
+QString sharedBlobReferencesDirectoryPath()
+{
+    return itemBlobDirectoryPath() + "/sessions";
+}
+
+/// @return File with references to shared blobs from current session.
+QString sharedBlobReferencesFileName()
+{
+    const QByteArray id = QCryptographicHash::hash(
+                tabFilePrefix().toUtf8(), QCryptographicHash::Md5).toHex();
+    return sharedBlobReferencesDirectoryPath() + '/' + QString::fromLatin1(id);
+}
+
+/// @return Lock file held by a session while it runs (other sessions use it to detect exited sessions).
+QString sharedBlobReferencesLockFileName(const QString &referencesFileName)
+{
+    return referencesFileName + ".lock";
+}
+
+/**
+ * Lets other sessions know where tab files of current session are and which
+ * blobs are used by items in memory.
+ *
+ * The file is rewritten only if the blobs changed.
+ *
+ * Called with itemFileMutex locked.
+ */
+void updateSharedBlobReferences()
+{
+    if ( !isItemBlobDirectoryShared() )
+        return;
+
+    QStringList blobs = referencedItemBlobs();
+    blobs.sort();
+    static QStringList lastBlobs;
+    static bool saved = false;
+    if ( saved && blobs == lastBlobs )
+        return;
+
+    ItemBlobDirectoryLock directoryLock;
+
+    if ( !QDir().mkpath(sharedBlobReferencesDirectoryPath()) )
+        return;
+
+    const QString fileName = sharedBlobReferencesFileName();
+
+    // Keep the lock until the session exits.
+    static QLockFile sessionLock( sharedBlobReferencesLockFileName(fileName) );
+    if ( !sessionLock.isLocked() )
+        sessionLock.tryLock(0);
+
+    QFile tmpFile(fileName + ".tmp");
+    if ( !tmpFile.open(QIODevice::WriteOnly) ) {
+        log( QString("Cannot save references to shared item data to %1 (%2)")
+             .arg(quoteString(tmpFile.fileName()), tmpFile.errorString()), LogError );
+        return;
+    }
+
+    {
+        QDataStream stream(&tmpFile);
+        stream.setVersion(QDataStream::Qt_4_7);
+        stream << tabFilePrefix() << blobs;
+    }
+
+    tmpFile.close();
+    QFile::remove(fileName);
+    if ( tmpFile.rename(fileName) ) {
+        lastBlobs = blobs;
+        saved = true;
+    }
+}
+
+/// Returns true if any tab file or journal with given prefix exists.
+bool hasTabFiles(const QString &prefix)
+{
+    const QFileInfo prefixInfo(prefix);
+    const QDir tabDir( prefixInfo.absolutePath() );
+    const QStringList filter{
+        prefixInfo.fileName() + "*.dat",
+        prefixInfo.fileName() + "*.dat.log"};
+    return !tabDir.entryList(filter, QDir::Files).isEmpty();
+}
+
+/// Adds blobs referenced from tab files and their journals with given prefix.
+bool addTabFileBlobReferences(const QString &prefix, QSet<QString> *usedBlobs)
+{
+    const QFileInfo prefixInfo(prefix);
+    QDir tabDir( prefixInfo.absolutePath() );
+    const QStringList tabFileFilter(prefixInfo.fileName() + "*.dat");
+
+    for ( const auto &fileName : tabDir.entryList(tabFileFilter, QDir::Files) ) {
+        QFile tabFile( tabDir.absoluteFilePath(fileName) );
+        if ( !tabFile.open(QIODevice::ReadOnly) )
+            return false;
+        usedBlobs->unite( itemBlobReferences(&tabFile).toSet() );
+    }
+
+    // Changes in journal are not yet in tab file.
+    const QStringList journalFilter(prefixInfo.fileName() + "*.dat.log");
+    for ( const auto &fileName : tabDir.entryList(journalFilter, QDir::Files) ) {
+        QFile journalFile( tabDir.absoluteFilePath(fileName) );
+        if ( !journalFile.open(QIODevice::ReadOnly) )
+            return false;
+        usedBlobs->unite( itemJournalBlobReferences(&journalFile).toSet() );
+    }
+
+    return true;
+}
+
+/// Adds blobs referenced from other sessions which share blob directory.
+bool addSharedBlobReferences(QSet<QString> *usedBlobs)
+{
+    QDir referencesDir( sharedBlobReferencesDirectoryPath() );
+    const QString ownFileName = QFileInfo( sharedBlobReferencesFileName() ).fileName();
+
+    for ( const auto &fileName : referencesDir.entryList(QDir::Files) ) {
+        if ( fileName == ownFileName || fileName.endsWith(".tmp") || fileName.endsWith(".lock") )
+            continue;
+
+        const QString filePath = referencesDir.absoluteFilePath(fileName);
+        QFile file(filePath);
+        if ( !file.open(QIODevice::ReadOnly) )
+            return false;
+
+        QDataStream stream(&file);
+        stream.setVersion(QDataStream::Qt_4_7);
+        QString prefix;
+        QStringList blobs;
+        stream >> prefix >> blobs;
+        if ( stream.status() != QDataStream::Ok )
+            return false;
+
+        // Items in memory of exited session are gone but its tab files can be loaded again.
+        QLockFile sessionLock( sharedBlobReferencesLockFileName(filePath) );
+        const bool sessionExited = sessionLock.tryLock(0);
+        if (sessionExited) {
+            if ( !hasTabFiles(prefix) ) {
+                COPYQ_LOG( QString("Removing item data references of exited session %1").arg(prefix) );
+                file.close();
+                QFile::remove(filePath);
+                continue;
+            }
+        } else {
+            usedBlobs->unite( blobs.toSet() );
+        }
+
+        if ( !addTabFileBlobReferences(prefix, usedBlobs) )
+            return false;
+    }
+
+    return true;
+}
+
+/// Removes data from blob directory which are no longer referenced from any tab.
+void removeUnusedItemBlobs()
+{
+    QDir blobDir( itemBlobDirectoryPath() );
+    if ( !blobDir.exists() )
+        return;
+
+    // Other sessions must not reuse blobs while these are being removed.
+    ItemBlobDirectoryLock directoryLock;
+
+    const bool shared = isItemBlobDirectoryShared();
+    if (shared) {
+        if ( !isItemBlobDirectoryLocked() )
+            return;
+        updateSharedBlobReferences();
+    }
+
+    // Keep all blobs if some references are unknown.
+    QSet<QString> usedBlobs;
+    if ( !addTabFileBlobReferences(tabFilePrefix(), &usedBlobs) )
+        return;
+    if ( shared && !addSharedBlobReferences(&usedBlobs) )
+        return;
+
+    const QDateTime now = QDateTime::currentDateTime();
+    for ( const auto &hash : blobDir.entryList(QDir::Files) ) {
+        if ( usedBlobs.contains(hash) )
+            continue;
+
+        if ( shared ) {
+            const QFileInfo blobInfo( blobDir.absoluteFilePath(hash) );
+            if ( blobInfo.lastModified().secsTo(now) < minSharedBlobAgeSeconds )
+                continue;
+        }
+
+        removeUnreferencedItemBlob(hash);
+    }
+}
+
+/// Single thread for preloading so it doesn't occupy threads for other tasks.
+QThreadPool *preloadThreadPool()
+{
+    static QThreadPool *pool = []() {
+        auto pool = new QThreadPool();
+        pool->setMaxThreadCount(1);
+        return pool;
+    }();
+    return pool;
+}
+
+/// Asks the system to cache file content or reads the files as a fallback.
+class PreloadItemsTask final : public QRunnable
+{
+public:
+    explicit PreloadItemsTask(const QStringList &fileNames)
+        : m_fileNames(fileNames)
+    {
+    }
+
+    void run() override
+    {
+        for (const auto &fileName : m_fileNames) {
+            QFile file(fileName);
+            if ( !file.open(QIODevice::ReadOnly) )
+                continue;
+
+#ifdef Q_OS_LINUX
+            if ( posix_fadvise(file.handle(), 0, 0, POSIX_FADV_WILLNEED) == 0 )
+                continue;
+#endif
+
+            const qint64 chunkSize = 1024 * 1024;
+            while ( !file.read(chunkSize).isEmpty() ) {}
+        }
+    }
+
+private:
+    QStringList m_fileNames;
+};
+
 void printItemFileError(
         const QString &action, const QString &id, const QString &fileName, const QFile &file)
 {
@@ -105,6 +387,38 @@ ItemSaverPtr createTab(
     return saver;
 }
 
+/// Journal and its tab file state when the journal was last verified or written.
+struct VerifiedJournal {
+    qint64 journalSize;
+    qint64 tabFileSize;
+    QDateTime tabFileModified;
+};
+
+/// Journals written by this process need to be verified again only if files change.
+QHash<QString, VerifiedJournal> &verifiedJournals()
+{
+    // Guarded by itemFileMutex.
+    static QHash<QString, VerifiedJournal> journals;
+    return journals;
+}
+
+VerifiedJournal journalState(const QFile &journalFile, const QFile &tabFile)
+{
+    return { journalFile.size(), tabFile.size(), QFileInfo(tabFile).lastModified() };
+}
+
+bool isJournalVerified(const QFile &journalFile, const QFile &tabFile)
+{
+    const auto it = verifiedJournals().constFind( journalFile.fileName() );
+    if ( it == verifiedJournals().constEnd() )
+        return false;
+
+    const VerifiedJournal state = journalState(journalFile, tabFile);
+    return it->journalSize == state.journalSize
+        && it->tabFileSize == state.tabFileSize
+        && it->tabFileModified == state.tabFileModified;
+}
+
 } // namespace
 
 ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model, ItemFactory *itemFactory, int maxItems)
@@ -141,8 +455,23 @@ ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model, ItemFa
     return saver;
 }
 
+void preloadItems(const QStringList &tabNames)
+{
+    for (const auto &tabName : tabNames) {
+        const QString tabFileName = itemFileName(tabName);
+        if ( !QFile::exists(tabFileName) )
+            continue;
+
+        const QStringList fileNames{
+            tabFileName, itemJournalFileName(tabName), itemTextIndexFileName(tabName)};
+        preloadThreadPool()->start( new PreloadItemsTask(fileNames) );
+    }
+}
+
 bool saveItems(const QString &tabName, const QAbstractItemModel &model, const ItemSaverPtr &saver)
 {
+    QMutexLocker lock( itemFileMutex() );
+
     const QString tabFileName = itemFileName(tabName);
 
     if ( !createItemDirectory() )
@@ -157,6 +486,10 @@ bool saveItems(const QString &tabName, const QAbstractItemModel &model, const It
 
     COPYQ_LOG( QString("Tab \"%1\": Saving %2 items").arg(tabName).arg(model.rowCount()) );
 
+    // Other sessions must not remove shared blobs while the tab file is being replaced.
+    ItemBlobDirectoryLock directoryLock;
+    updateSharedBlobReferences();
+
     if ( !saver->saveItems(tabName, model, &tmpFile) ) {
         COPYQ_LOG( QString("Tab \"%1\": Failed to save items!").arg(tabName) );
         return false;
@@ -180,25 +513,222 @@ bool saveItems(const QString &tabName, const QAbstractItemModel &model, const It
         return false;
     }
 
+    // 4. Changes in journal are already in the saved file.
+    QFile::remove( itemJournalFileName(tabName) );
+
+    removeUnusedItemBlobs();
+
     COPYQ_LOG( QString("Tab \"%1\": Items saved").arg(tabName) );
 
     return true;
 }
 
+bool saveItemJournal(const QString &tabName, const ItemJournal &journal)
+{
+    if ( !journal.isValid() )
+        return false;
+
+    if ( journal.isEmpty() )
+        return true;
+
+    QMutexLocker lock( itemFileMutex() );
+
+    const QString tabFileName = itemFileName(tabName);
+    QFile tabFile(tabFileName);
+    if ( !tabFile.open(QIODevice::ReadOnly) )
+        return false;
+
+    const QString journalFileName = itemJournalFileName(tabName);
+    QFile journalFile(journalFileName);
+    if ( !journalFile.open(QIODevice::ReadWrite) ) {
+        printSaveItemFileError(tabName, journalFileName, journalFile);
+        return false;
+    }
+
+    // Avoid reading whole tab file to verify journal which was already verified.
+    if ( journalFile.size() == 0 ) {
+        writeItemJournalHeader(&journalFile, &tabFile);
+    } else if ( !isJournalVerified(journalFile, tabFile)
+                && !isItemJournalValid(&journalFile, &tabFile) )
+    {
+        COPYQ_LOG( QString("Tab \"%1\": Ignoring outdated journal").arg(tabName) );
+        return false;
+    }
+
+    const QByteArray block = journal.serializeBlock();
+    const qint64 maxJournalSize =
+            qMax(minJournalSizeToCompact, tabFile.size() / journalToTabFileSizeRatio);
+    if ( journalFile.size() + block.size() > maxJournalSize ) {
+        COPYQ_LOG( QString("Tab \"%1\": Compacting journal").arg(tabName) );
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Appending changes to journal").arg(tabName) );
+
+    ItemBlobDirectoryLock directoryLock;
+    updateSharedBlobReferences();
+
+    const qint64 oldJournalSize = journalFile.size();
+    journalFile.seek(oldJournalSize);
+    QDataStream stream(&journalFile);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << block;
+
+    if ( stream.status() != QDataStream::Ok || !journalFile.flush() ) {
+        printSaveItemFileError(tabName, journalFileName, journalFile);
+        // Drop incomplete block so later blocks can be replayed.
+        journalFile.resize(oldJournalSize);
+        return false;
+    }
+
+    verifiedJournals()[journalFileName] = journalState(journalFile, tabFile);
+
+    return true;
+}
+
+bool loadItemJournal(const QString &tabName, QAbstractItemModel *model, int maxItems)
+{
+    const QString journalFileName = itemJournalFileName(tabName);
+    QFile journalFile(journalFileName);
+    if ( !journalFile.exists() )
+        return true;
+
+    QFile tabFile( itemFileName(tabName) );
+    if ( !journalFile.open(QIODevice::ReadOnly) || !tabFile.open(QIODevice::ReadOnly) ) {
+        printLoadItemFileError(tabName, journalFileName, journalFile);
+        return false;
+    }
+
+    if ( !isItemJournalValid(&journalFile, &tabFile) ) {
+        COPYQ_LOG( QString("Tab \"%1\": Ignoring outdated journal").arg(tabName) );
+        return true;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Replaying journal").arg(tabName) );
+
+    if ( !replayItemJournal(model, &journalFile, maxItems) ) {
+        log( QString("Tab \"%1\": Journal is corrupted").arg(tabName), LogWarning );
+        return false;
+    }
+
+    // Drop incomplete block so changes appended later can be replayed.
+    const qint64 journalSize = journalFile.pos();
+    if ( journalSize < journalFile.size() ) {
+        COPYQ_LOG( QString("Tab \"%1\": Dropping incomplete journal block").arg(tabName) );
+        journalFile.close();
+        if ( !journalFile.resize(journalSize) ) {
+            printSaveItemFileError(tabName, journalFileName, journalFile);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool loadItemsForReading(const QString &tabName, QAbstractItemModel *model, ItemFactory *itemFactory, int maxItems)
+{
+    QMutexLocker lock( itemFileMutex() );
+
+    QFile tabFile( itemFileName(tabName) );
+    if ( !tabFile.exists() )
+        return false;
+
+    if ( !tabFile.open(QIODevice::ReadOnly) ) {
+        printLoadItemFileError(tabName, tabFile.fileName(), tabFile);
+        return false;
+    }
+
+    if ( !itemFactory->isDefaultItemFormat(&tabFile) )
+        return false;
+
+    COPYQ_LOG( QString("Tab \"%1\": Reading items").arg(tabName) );
+
+    if ( tabFile.size() > 0 && !deserializeData(model, &tabFile, maxItems) )
+        return false;
+
+    return loadItemJournal(tabName, model, maxItems);
+}
+
+bool saveItemTextIndex(const QString &tabName, ItemTextIndex *index)
+{
+    if ( !index->isBuilt() || !index->isModified() )
+        return true;
+
+    if ( !createItemDirectory() )
+        return false;
+
+    const QString indexFileName = itemTextIndexFileName(tabName);
+    QFile indexFile(indexFileName);
+    if ( !indexFile.open(QIODevice::WriteOnly) ) {
+        printSaveItemFileError(tabName, indexFileName, indexFile);
+        return false;
+    }
+
+    COPYQ_LOG( QString("Tab \"%1\": Saving text index").arg(tabName) );
+
+    index->save(&indexFile);
+
+    if ( !indexFile.flush() ) {
+        printSaveItemFileError(tabName, indexFileName, indexFile);
+        indexFile.remove();
+        return false;
+    }
+
+    return true;
+}
+
+void loadItemTextIndex(const QString &tabName, ItemTextIndex *index)
+{
+    const QString indexFileName = itemTextIndexFileName(tabName);
+    QFile indexFile(indexFileName);
+    if ( !indexFile.exists() )
+        return;
+
+    if ( !indexFile.open(QIODevice::ReadOnly) ) {
+        printLoadItemFileError(tabName, indexFileName, indexFile);
+        return;
+    }
+
+    if ( !index->load(&indexFile) )
+        COPYQ_LOG( QString("Tab \"%1\": Ignoring corrupted text index").arg(tabName) );
+}
+
 void removeItems(const QString &tabName)
 {
+    QMutexLocker lock( itemFileMutex() );
+
     const QString tabFileName = itemFileName(tabName);
     QFile::remove(tabFileName);
     QFile::remove(tabFileName + ".tmp");
+    QFile::remove( itemJournalFileName(tabName) );
+    QFile::remove( itemTextIndexFileName(tabName) );
+    removeUnusedItemBlobs();
 }
 
 void moveItems(const QString &oldId, const QString &newId)
 {
+    QMutexLocker lock( itemFileMutex() );
+
     const QString oldFileName = itemFileName(oldId);
     const QString newFileName = itemFileName(newId);
 
     if ( oldFileName != newFileName && QFile::copy(oldFileName, newFileName) ) {
         QFile::remove(oldFileName);
+
+        const QString oldJournalFileName = itemJournalFileName(oldId);
+        if ( QFile::exists(oldJournalFileName) ) {
+            const QString newJournalFileName = itemJournalFileName(newId);
+            QFile::remove(newJournalFileName);
+            QFile::copy(oldJournalFileName, newJournalFileName);
+            QFile::remove(oldJournalFileName);
+        }
+
+        const QString oldIndexFileName = itemTextIndexFileName(oldId);
+        if ( QFile::exists(oldIndexFileName) ) {
+            const QString newIndexFileName = itemTextIndexFileName(newId);
+            QFile::remove(newIndexFileName);
+            QFile::rename(oldIndexFileName, newIndexFileName);
+        }
     } else {
         COPYQ_LOG( QString("Failed to move items from \"%1\" (tab \"%2\") to \"%3\" (tab \"%4\")")
                    .arg(oldFileName, oldId,
@@ -23,16 +23,63 @@
 
 class QAbstractItemModel;
 class ItemFactory;
+class ItemJournal;
+class ItemTextIndex;
 class QString;
+class QStringList;
 
 /** Load items from configuration file. */
 ItemSaverPtr loadItems(const QString &tabName, QAbstractItemModel &model //!< Model for items.
         , ItemFactory *itemFactory, int maxItems);
 
+/**
+ * Read files with items for given tabs in background threads.
+ *
+ * This makes the following loadItems() calls faster since the data
+ * no longer needs to be read from disk.
+ */
+void preloadItems(const QStringList &tabNames);
+
 /** Save items to configuration file. */
 bool saveItems(const QString &tabName, const QAbstractItemModel &model //!< Model containing items to save.
         , const ItemSaverPtr &saver);
 
+/**
+ * Append recorded changes to journal file instead of saving all items.
+ *
+ * @return false if items need to be saved using saveItems() (journal is too big or on error)
+ */
+bool saveItemJournal(const QString &tabName, const ItemJournal &journal);
+
+/**
+ * Apply changes from journal file to loaded items.
+ *
+ * Journal is ignored if it was not created for current configuration file for items.
+ */
+bool loadItemJournal(const QString &tabName, QAbstractItemModel *model, int maxItems);
+
+/**
+ * Save trigram index of item texts if it was built and changed.
+ */
+bool saveItemTextIndex(const QString &tabName, ItemTextIndex *index);
+
+/**
+ * Load trigrams of items saved by saveItemTextIndex().
+ *
+ * Trigrams are reused by ItemTextIndex::build() for items which did not change.
+ */
+void loadItemTextIndex(const QString &tabName, ItemTextIndex *index);
+
+/**
+ * Load saved items for reading without plugins.
+ *
+ * Used to read tabs without creating them.
+ *
+ * @return false if there are no saved items or these can be loaded only
+ *         by a plugin (e.g. encrypted or synchronized items)
+ */
+bool loadItemsForReading(const QString &tabName, QAbstractItemModel *model, ItemFactory *itemFactory, int maxItems);
+
 /** Remove configuration file for items. */
 void removeItems(const QString &tabName //!< See ClipboardBrowser::getID().
         );
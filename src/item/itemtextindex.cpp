@@ -0,0 +1,418 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemtextindex.h"
+
+#include "common/contenttype.h"
+#include "common/mimetypes.h"
+#include "common/textdata.h"
+
+#include <QAbstractItemModel>
+#include <QDataStream>
+#include <QIODevice>
+#include <QRegExp>
+#include <QStringList>
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+const quint32 indexMagic = 0x43515831; // "CQX1"
+const qint32 indexVersion = 1;
+
+/// Items with longer text are not indexed (would need too much memory).
+const int maxIndexedTextLength = 20000;
+
+/// Stale item IDs are dropped from index once there is this many more than valid ones.
+const quint32 maxStaleItemIds = 1000;
+
+bool isIndexedFormat(const QString &mime)
+{
+    return mime == mimeText
+            || mime == mimeUriList
+            || mime.startsWith(COPYQ_MIME_PREFIX);
+}
+
+void addTrigrams(const QString &text, QVector<quint32> *trigrams)
+{
+    if (text.size() < 3)
+        return;
+
+    quint32 c1 = text[0].toLower().unicode();
+    quint32 c2 = text[1].toLower().unicode();
+    for (int i = 2; i < text.size(); ++i) {
+        const quint32 c3 = text[i].toLower().unicode();
+        // Collisions only add false candidates.
+        trigrams->append( ((c1 * 0x9E3779B1u) ^ c2) * 0x9E3779B1u ^ c3 );
+        c1 = c2;
+        c2 = c3;
+    }
+}
+
+void sortUnique(QVector<quint32> *values)
+{
+    std::sort(values->begin(), values->end());
+    values->erase( std::unique(values->begin(), values->end()), values->end() );
+}
+
+} // namespace
+
+ItemTextIndex::ItemTextIndex(QAbstractItemModel *model, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+{
+    connect( model, &QAbstractItemModel::rowsInserted,
+             this, &ItemTextIndex::onRowsInserted );
+    connect( model, &QAbstractItemModel::rowsRemoved,
+             this, &ItemTextIndex::onRowsRemoved );
+    connect( model, &QAbstractItemModel::rowsMoved,
+             this, &ItemTextIndex::onRowsMoved );
+    connect( model, &QAbstractItemModel::dataChanged,
+             this, &ItemTextIndex::onDataChanged );
+    connect( model, &QAbstractItemModel::modelAboutToBeReset,
+             this, &ItemTextIndex::invalidate );
+    connect( model, &QAbstractItemModel::layoutAboutToBeChanged,
+             this, &ItemTextIndex::invalidate );
+}
+
+void ItemTextIndex::build()
+{
+    m_rowIds.clear();
+    m_postings.clear();
+    m_notIndexed.clear();
+    m_nextId = 0;
+
+    const int rowCount = m_model->rowCount();
+    m_modified = m_loaded.size() != rowCount;
+
+    for (int row = 0; row < rowCount; ++row) {
+        const quint64 hash = m_model->index(row, 0).data(contentType::hash).toULongLong();
+        const auto it = m_loaded.constFind(hash);
+        if ( hash != 0 && it != m_loaded.constEnd() ) {
+            m_rowIds.push_back( addItem(it.value()) );
+        } else {
+            m_rowIds.push_back( addItem(itemTrigrams(row)) );
+            m_modified = true;
+        }
+    }
+
+    m_loaded.clear();
+    m_built = true;
+}
+
+bool ItemTextIndex::canFindCandidates(const QRegExp &re)
+{
+    const QString pattern = re.pattern();
+
+    // Formats are matched if the expression contains single '/' (see ItemFactory::matches()).
+    if ( pattern.isEmpty() || pattern.count('/') == 1 )
+        return false;
+
+    if (re.patternSyntax() == QRegExp::FixedString)
+        return true;
+
+    return (re.patternSyntax() == QRegExp::RegExp || re.patternSyntax() == QRegExp::RegExp2)
+            && splitWordsPattern(pattern);
+}
+
+bool ItemTextIndex::candidateRows(const QRegExp &re, QVector<int> *rows) const
+{
+    if ( !m_built || !canFindCandidates(re) )
+        return false;
+
+    QStringList words;
+    if (re.patternSyntax() == QRegExp::FixedString)
+        words.append( re.pattern() );
+    else
+        splitWordsPattern( re.pattern(), &words );
+
+    Trigrams trigrams;
+    for (const auto &word : words)
+        addTrigrams(word, &trigrams);
+
+    if ( trigrams.isEmpty() )
+        return false;
+
+    sortUnique(&trigrams);
+
+    // Intersect posting lists starting with the shortest ones.
+    QVector<const QVector<ItemId>*> postings;
+    postings.reserve( trigrams.size() );
+    for (const auto trigram : trigrams) {
+        const auto it = m_postings.constFind(trigram);
+        if ( it == m_postings.constEnd() ) {
+            postings.clear();
+            break;
+        }
+        postings.append( &it.value() );
+    }
+
+    std::sort( postings.begin(), postings.end(),
+               [](const QVector<ItemId> *lhs, const QVector<ItemId> *rhs) {
+                   return lhs->size() < rhs->size();
+               } );
+
+    QVector<ItemId> ids;
+    if ( !postings.isEmpty() ) {
+        ids = *postings[0];
+        for (int i = 1; i < postings.size() && !ids.isEmpty(); ++i) {
+            const auto &posting = *postings[i];
+            QVector<ItemId> intersection;
+            std::set_intersection( ids.begin(), ids.end(), posting.begin(), posting.end(),
+                                   std::back_inserter(intersection) );
+            ids.swap(intersection);
+        }
+    }
+
+    QVector<ItemId> candidates;
+    candidates.reserve( ids.size() + m_notIndexed.size() );
+    std::set_union( ids.begin(), ids.end(), m_notIndexed.begin(), m_notIndexed.end(),
+                    std::back_inserter(candidates) );
+
+    rows->clear();
+    for (int row = 0; row < static_cast<int>(m_rowIds.size()); ++row) {
+        if ( std::binary_search(candidates.begin(), candidates.end(), m_rowIds[row]) )
+            rows->append(row);
+    }
+
+    return true;
+}
+
+void ItemTextIndex::save(QIODevice *file)
+{
+    Q_ASSERT(m_built);
+
+    // Item IDs are same as rows after compacting.
+    compact();
+    QVector<ItemTrigrams> items( static_cast<int>(m_rowIds.size()), ItemTrigrams{true, Trigrams()} );
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        for (const auto id : it.value())
+            items[static_cast<int>(id)].trigrams.append( it.key() );
+    }
+    for (const auto id : m_notIndexed)
+        items[static_cast<int>(id)].indexed = false;
+
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << indexMagic << indexVersion << static_cast<qint32>(items.size());
+    for (int row = 0; row < items.size(); ++row) {
+        const auto &item = items[row];
+        const quint64 hash = m_model->index(row, 0).data(contentType::hash).toULongLong();
+        stream << hash << item.indexed << item.trigrams;
+    }
+
+    m_modified = false;
+}
+
+bool ItemTextIndex::load(QIODevice *file)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    quint32 magic;
+    qint32 version;
+    qint32 count;
+    stream >> magic >> version >> count;
+    if ( stream.status() != QDataStream::Ok || magic != indexMagic || version != indexVersion || count < 0 )
+        return false;
+
+    QHash<quint64, ItemTrigrams> loaded;
+    loaded.reserve(count);
+    for (qint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        quint64 hash;
+        ItemTrigrams item;
+        stream >> hash >> item.indexed >> item.trigrams;
+        loaded.insert(hash, item);
+    }
+
+    if ( stream.status() != QDataStream::Ok )
+        return false;
+
+    m_loaded = loaded;
+    m_modified = false;
+    return true;
+}
+
+qint64 ItemTextIndex::byteCount() const
+{
+    qint64 bytes = static_cast<qint64>( m_rowIds.size() * sizeof(ItemId) )
+            + m_notIndexed.capacity() * static_cast<qint64>(sizeof(ItemId));
+
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it)
+        bytes += sizeof(Trigram) + it.value().capacity() * static_cast<qint64>(sizeof(ItemId));
+
+    for (auto it = m_loaded.constBegin(); it != m_loaded.constEnd(); ++it)
+        bytes += sizeof(quint64) + it.value().trigrams.capacity() * static_cast<qint64>(sizeof(Trigram));
+
+    return bytes;
+}
+
+void ItemTextIndex::onRowsInserted(const QModelIndex &, int first, int last)
+{
+    if (!m_built)
+        return;
+
+    std::deque<ItemId> ids;
+    for (int row = first; row <= last; ++row)
+        ids.push_back( addItem(itemTrigrams(row)) );
+    m_rowIds.insert( m_rowIds.begin() + first, ids.begin(), ids.end() );
+    m_modified = true;
+}
+
+void ItemTextIndex::onRowsRemoved(const QModelIndex &, int first, int last)
+{
+    if (!m_built)
+        return;
+
+    m_rowIds.erase( m_rowIds.begin() + first, m_rowIds.begin() + last + 1 );
+    m_modified = true;
+
+    if ( m_nextId - m_rowIds.size() > m_rowIds.size() + maxStaleItemIds )
+        compact();
+}
+
+void ItemTextIndex::onRowsMoved(const QModelIndex &, int first, int last, const QModelIndex &, int row)
+{
+    if (!m_built)
+        return;
+
+    const auto begin = m_rowIds.begin();
+    if (row > last)
+        std::rotate( begin + first, begin + last + 1, begin + row );
+    else if (row < first)
+        std::rotate( begin + row, begin + first, begin + last + 1 );
+    m_modified = true;
+}
+
+void ItemTextIndex::onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if (!m_built)
+        return;
+
+    // Changed item gets new ID, the old one is removed from index on compacting.
+    for (int row = topLeft.row(); row <= bottomRight.row(); ++row)
+        m_rowIds[row] = addItem(itemTrigrams(row));
+    m_modified = true;
+
+    if ( m_nextId - m_rowIds.size() > m_rowIds.size() + maxStaleItemIds )
+        compact();
+}
+
+void ItemTextIndex::invalidate()
+{
+    if (!m_built)
+        return;
+
+    // Keep trigrams of current items so these are not decoded again on next build().
+    compact();
+    m_loaded.clear();
+    m_loaded.reserve( static_cast<int>(m_rowIds.size()) );
+    for (int row = 0; row < static_cast<int>(m_rowIds.size()); ++row) {
+        const quint64 hash = m_model->index(row, 0).data(contentType::hash).toULongLong();
+        m_loaded.insert( hash, ItemTrigrams{true, Trigrams()} );
+    }
+
+    for (auto it = m_postings.constBegin(); it != m_postings.constEnd(); ++it) {
+        for (const auto id : it.value()) {
+            const quint64 hash = m_model->index(static_cast<int>(id), 0).data(contentType::hash).toULongLong();
+            m_loaded[hash].trigrams.append( it.key() );
+        }
+    }
+
+    for (const auto id : m_notIndexed) {
+        const quint64 hash = m_model->index(static_cast<int>(id), 0).data(contentType::hash).toULongLong();
+        m_loaded[hash].indexed = false;
+    }
+
+    m_rowIds.clear();
+    m_postings.clear();
+    m_notIndexed.clear();
+    m_nextId = 0;
+    m_built = false;
+}
+
+ItemTextIndex::ItemTrigrams ItemTextIndex::itemTrigrams(int row) const
+{
+    const QVariantMap data = m_model->index(row, 0).data(contentType::data).toMap();
+
+    ItemTrigrams item{true, Trigrams()};
+    int textLength = 0;
+    for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
+        if ( !isIndexedFormat(it.key()) )
+            continue;
+
+        const QString text = getTextData( it.value().toByteArray() );
+        textLength += text.size();
+        if (textLength > maxIndexedTextLength)
+            return ItemTrigrams{false, Trigrams()};
+
+        addTrigrams(text, &item.trigrams);
+    }
+
+    sortUnique(&item.trigrams);
+    return item;
+}
+
+ItemTextIndex::ItemId ItemTextIndex::addItem(const ItemTrigrams &item)
+{
+    const ItemId id = m_nextId++;
+
+    if (item.indexed) {
+        for (const auto trigram : item.trigrams)
+            m_postings[trigram].append(id);
+    } else {
+        m_notIndexed.append(id);
+    }
+
+    return id;
+}
+
+void ItemTextIndex::compact()
+{
+    // Renumber items by rows, IDs of removed or changed items are dropped.
+    const ItemId staleId = static_cast<ItemId>(-1);
+    QVector<ItemId> newIds( static_cast<int>(m_nextId), staleId );
+    for (int row = 0; row < static_cast<int>(m_rowIds.size()); ++row) {
+        newIds[static_cast<int>(m_rowIds[row])] = static_cast<ItemId>(row);
+        m_rowIds[row] = static_cast<ItemId>(row);
+    }
+    m_nextId = static_cast<ItemId>(m_rowIds.size());
+
+    const auto renumber = [&](QVector<ItemId> *ids) {
+        auto end = ids->begin();
+        for (const auto id : *ids) {
+            const ItemId newId = newIds[static_cast<int>(id)];
+            if (newId != staleId)
+                *end++ = newId;
+        }
+        ids->erase( end, ids->end() );
+        std::sort( ids->begin(), ids->end() );
+    };
+
+    for (auto it = m_postings.begin(); it != m_postings.end(); ) {
+        renumber( &it.value() );
+        if ( it.value().isEmpty() )
+            it = m_postings.erase(it);
+        else
+            ++it;
+    }
+
+    renumber(&m_notIndexed);
+}
@@ -0,0 +1,125 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMTEXTINDEX_H
+#define ITEMTEXTINDEX_H
+
+#include <QHash>
+#include <QObject>
+#include <QVector>
+
+#include <deque>
+
+class QAbstractItemModel;
+class QIODevice;
+class QModelIndex;
+class QRegExp;
+
+/**
+ * Trigram index of item texts used to quickly find items that can match filter.
+ *
+ * Index is built on first use (see build()) and then kept up to date with
+ * changes in model. Indexed are formats searched by item loaders (plain text,
+ * URIs and internal formats like notes and tags), in lower case.
+ *
+ * Items with very long text are not indexed and are always returned as candidates.
+ */
+class ItemTextIndex final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ItemTextIndex(QAbstractItemModel *model, QObject *parent = nullptr);
+
+    /** Return true if all items are indexed. */
+    bool isBuilt() const { return m_built; }
+
+    /** Return true if index changed since it was last saved or loaded. */
+    bool isModified() const { return m_modified; }
+
+    /**
+     * Index all items.
+     *
+     * Trigrams read by load() are reused for items with same hash
+     * so these don't need to be decoded.
+     */
+    void build();
+
+    /**
+     * Return true if candidateRows() can be used for filter expression.
+     *
+     * Only fixed strings and words joined with ".*" can be looked up
+     * and the expression must not match formats (contain single '/').
+     */
+    static bool canFindCandidates(const QRegExp &re);
+
+    /**
+     * Set @a rows to sorted rows with items which can match filter expression.
+     *
+     * Items not in @a rows certainly do not match.
+     *
+     * @return false if index is not built or the expression cannot be looked up
+     */
+    bool candidateRows(const QRegExp &re, QVector<int> *rows) const;
+
+    /** Serialize trigrams of items (index must be built). */
+    void save(QIODevice *file);
+
+    /** Deserialize trigrams, these are used on next build(). */
+    bool load(QIODevice *file);
+
+    /** Return approximate number of bytes used by the index. */
+    qint64 byteCount() const;
+
+private:
+    using ItemId = quint32;
+    using Trigram = quint32;
+    using Trigrams = QVector<Trigram>;
+
+    struct ItemTrigrams {
+        bool indexed;
+        Trigrams trigrams;
+    };
+
+    void onRowsInserted(const QModelIndex &parent, int first, int last);
+    void onRowsRemoved(const QModelIndex &parent, int first, int last);
+    void onRowsMoved(const QModelIndex &parent, int first, int last, const QModelIndex &, int row);
+    void onDataChanged(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void invalidate();
+
+    ItemTrigrams itemTrigrams(int row) const;
+    ItemId addItem(const ItemTrigrams &item);
+    void compact();
+
+    QAbstractItemModel *m_model;
+
+    /// Item IDs for rows; new IDs are always greater so posting lists stay sorted.
+    std::deque<ItemId> m_rowIds;
+    ItemId m_nextId = 0;
+
+    QHash<Trigram, QVector<ItemId>> m_postings;
+    QVector<ItemId> m_notIndexed;
+
+    QHash<quint64, ItemTrigrams> m_loaded;
+
+    bool m_built = false;
+    bool m_modified = false;
+};
+
+#endif // ITEMTEXTINDEX_H
@@ -300,6 +300,16 @@ bool ItemSaverInterface::saveItems(const QString &, const QAbstractItemModel &,
     return false;
 }
 
+bool ItemSaverInterface::canSaveItemsToJournal() const
+{
+    return false;
+}
+
+bool ItemSaverInterface::canSaveItemsInBackground() const
+{
+    return false;
+}
+
 bool ItemSaverInterface::canRemoveItems(const QList<QModelIndex> &, QString *)
 {
     return true;
@@ -359,6 +369,20 @@ bool ItemLoaderInterface::matches(const QModelIndex &, const QRegExp &) const
     return false;
 }
 
+void ItemLoaderInterface::matchItems(
+        const QList<QModelIndex> &indexes, const QRegExp &re, QVector<bool> *matched) const
+{
+    for (int i = 0; i < indexes.size(); ++i) {
+        if ( !(*matched)[i] && matches(indexes[i], re) )
+            (*matched)[i] = true;
+    }
+}
+
+bool ItemLoaderInterface::canMatchInBackground() const
+{
+    return true;
+}
+
 QObject *ItemLoaderInterface::tests(const TestInterfacePtr &) const
 {
     return nullptr;
@@ -49,7 +49,7 @@ using ItemSaverPtr = std::shared_ptr<ItemSaverInterface>;
 class ItemScriptableFactoryInterface;
 using ItemScriptableFactoryPtr = std::shared_ptr<ItemScriptableFactoryInterface>;
 
-#define COPYQ_PLUGIN_ITEM_LOADER_ID "com.github.hluk.copyq.itemloader/3.7.3"
+#define COPYQ_PLUGIN_ITEM_LOADER_ID "com.github.hluk.copyq.itemloader/3.8.0"
 
 /**
  * Handles item in list.
@@ -250,6 +250,23 @@ public:
      */
     virtual bool saveItems(const QString &tabName, const QAbstractItemModel &model, QIODevice *file);
 
+    /**
+     * Return true if changes can be appended to journal instead of saving all items.
+     *
+     * Journal is replayed only if items are loaded in default format (see serializeData()).
+     * Returns false by default.
+     */
+    virtual bool canSaveItemsToJournal() const;
+
+    /**
+     * Return true if saveItems() can be called from a different thread.
+     *
+     * The model passed to saveItems() is then a read-only copy of the items
+     * and saveItems() must not access any other data shared with the main thread.
+     * Returns false by default.
+     */
+    virtual bool canSaveItemsInBackground() const;
+
     /**
      * Called before items are deleted by user.
      * @return true if items can be removed, false to cancel the removal
@@ -404,6 +421,27 @@ public:
      */
     virtual bool matches(const QModelIndex &index, const QRegExp &re) const;
 
+    /**
+     * Set items in @a matched to true if regular expression matches content
+     * of items with corresponding @a indexes.
+     *
+     * Items already marked as matched can be skipped.
+     * By default, matches() is called for each item not matched yet,
+     * plugins can override this to match multiple items more efficiently.
+     */
+    virtual void matchItems(
+            const QList<QModelIndex> &indexes, const QRegExp &re, QVector<bool> *matched) const;
+
+    /**
+     * Return true if matches() can be called from a different thread.
+     *
+     * The index passed to matches() then belongs to a read-only copy of the items
+     * and matches() must not access any other data shared with the main thread.
+     * Returns true by default (plugins, that override matches() with code
+     * that is not thread-safe, must return false).
+     */
+    virtual bool canMatchInBackground() const;
+
     /**
      * Return object with tests.
      *
@@ -19,88 +19,360 @@
 
 #include "serialize.h"
 
+#include "common/config.h"
 #include "common/contenttype.h"
 #include "common/log.h"
 #include "common/mimetypes.h"
 
 #include <QAbstractItemModel>
 #include <QByteArray>
+#include <QCryptographicHash>
 #include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QHash>
 #include <QIODevice>
 #include <QList>
+#include <QLockFile>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QObject>
 #include <QPair>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSet>
 #include <QStringList>
+#include <QtEndian>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
 
-#include <unordered_map>
+#include <algorithm>
 
 namespace {
 
-const std::unordered_map<int, QString> &idToMime()
-{
-    static const std::unordered_map<int, QString> map({
-        {1, QString(mimeWindowTitle)},
-        {2, QString(mimeItemNotes)},
+/// MIME type prefixes replaced with their index in serialized data (0 is for no prefix).
+const char *const mimePrefixes[] = {
+    "",
 
-        {3, QString(COPYQ_MIME_PREFIX)},
+    mimeWindowTitle,
+    mimeItemNotes,
 
-        {4, QString(mimeText)},
-        {5, QString(mimeHtml)},
-        {6, QString(mimeUriList)},
+    COPYQ_MIME_PREFIX,
 
-        {7, QString("image/")},
-        {8, QString("text/")},
-        {9, QString("application/")},
-        {10, QString("audio/")},
-        {11, QString("video/")}
-    });
-    return map;
+    mimeText,
+    mimeHtml,
+    mimeUriList,
+
+    "image/",
+    "text/",
+    "application/",
+    "audio/",
+    "video/",
+};
+const int mimePrefixCount = sizeof(mimePrefixes) / sizeof(mimePrefixes[0]);
+
+/// Caches compressed and decompressed MIME types since item formats repeat a lot.
+class MimeCache final {
+public:
+    bool find(const QString &key, QString *value)
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_map.constFind(key);
+        if ( it == m_map.constEnd() )
+            return false;
+        *value = it.value();
+        return true;
+    }
+
+    void insert(const QString &key, const QString &value)
+    {
+        QMutexLocker lock(&m_mutex);
+        // Avoid growing without limit if unique formats are used.
+        if ( m_map.size() < maxSize )
+            m_map.insert( internMime(key), value );
+    }
+
+private:
+    static const int maxSize = 4096;
+    QMutex m_mutex;
+    QHash<QString, QString> m_map;
+};
+
+QString decompressMime(const QString &compressedMime, bool *ok)
+{
+    static MimeCache cache;
+    QString mime;
+    if ( cache.find(compressedMime, &mime) ) {
+        *ok = true;
+        return mime;
+    }
+
+    const int id = compressedMime.midRef(0, 1).toInt(ok, 16);
+    if ( !*ok || id >= mimePrefixCount ) {
+        *ok = false;
+        return QString();
+    }
+    mime = QString::fromLatin1(mimePrefixes[id]) + compressedMime.mid(1);
+
+    mime = internMime(mime);
+    cache.insert(compressedMime, mime);
+    return mime;
 }
 
 QString decompressMime(QDataStream *out)
 {
-    QString mime;
-    *out >> mime;
+    QString compressedMime;
+    *out >> compressedMime;
     if ( out->status() != QDataStream::Ok )
         return QString();
 
     bool ok;
-    const int id = mime.midRef(0, 1).toInt(&ok, 16);
-    if (!ok) {
+    const QString mime = decompressMime(compressedMime, &ok);
+    if (!ok)
         out->setStatus(QDataStream::ReadCorruptData);
-        return QString();
+    return mime;
+}
+
+QString compressMime(const QString &mime)
+{
+    static MimeCache cache;
+    QString compressedMime;
+    if ( cache.find(mime, &compressedMime) )
+        return compressedMime;
+
+    // Use the longest matching prefix.
+    int prefixId = 0;
+    int prefixSize = 0;
+    for (int id = 1; id < mimePrefixCount; ++id) {
+        const QLatin1String prefix(mimePrefixes[id]);
+        if ( prefix.size() > prefixSize && mime.startsWith(prefix) ) {
+            prefixId = id;
+            prefixSize = prefix.size();
+        }
+    }
+
+    compressedMime = QString::number(prefixId, 16) + mime.mid(prefixSize);
+    cache.insert(mime, compressedMime);
+    return compressedMime;
+}
+
+// Smaller data are not worth compressing.
+const int minSizeToCompress = 512;
+
+// Fast compression level (zlib levels are 1 to 9).
+const int compressionLevel = 1;
+
+/**
+ * Returns true if data in given format should be compressed.
+ *
+ * Most image, audio and video formats are already compressed.
+ */
+bool shouldCompress(const QString &mime, int size)
+{
+    if (size < minSizeToCompress)
+        return false;
+
+    if ( mime.startsWith("text/") || mime.startsWith(COPYQ_MIME_PREFIX) )
+        return true;
+
+    static const QStringList compressibleFormats = {
+        "image/bmp",
+        "image/svg+xml",
+        "image/x-inkscape-svg",
+        "application/json",
+        "application/xml",
+        "application/x-qt-image",
+    };
+    return compressibleFormats.contains(mime)
+        || mime.endsWith("+xml");
+}
+
+// Formats with this prefix contain hash of data stored in blob directory.
+const QString blobMimePrefix = QStringLiteral(COPYQ_MIME_PREFIX "blob:");
+
+/// Returns true if @a hash is a name of a blob file (SHA-256 in lowercase hex).
+bool isValidBlobHash(const QString &hash)
+{
+    if ( hash.size() != 64 )
+        return false;
+
+    for (const auto &c : hash) {
+        const ushort u = c.unicode();
+        if ( !(u >= '0' && u <= '9') && !(u >= 'a' && u <= 'f') )
+            return false;
     }
 
-    if (id == 0)
-        return mime.mid(1);
+    return true;
+}
 
-    const auto it = idToMime().find(id);
-    if ( it != std::end(idToMime()) )
-        return it->second + mime.mid(1);
+QString blobFilePath(const QString &hash)
+{
+    return itemBlobDirectoryPath() + '/' + hash;
+}
 
-    out->setStatus(QDataStream::ReadCorruptData);
-    return QString();
+/// Guards blobs referenced from item data in memory.
+QMutex &blobReferencesMutex()
+{
+    static QMutex mutex;
+    return mutex;
 }
 
-QString compressMime(const QString &mime)
+/// Reference counts of blobs used by item data in memory.
+QHash<QString, int> &blobReferenceCounts()
 {
-    for (const auto &idMime : idToMime()) {
-        if ( mime.startsWith(idMime.second) ) {
-            const auto prefixSize = idMime.second.size();
-            return QString::number(idMime.first, 16) + mime.mid(prefixSize);
+    static QHash<QString, int> counts;
+    return counts;
+}
+
+/// Keeps blobs used by serialized item data (see serializeItemData()).
+class BlobReferences final {
+public:
+    explicit BlobReferences(const QSet<QString> &blobs)
+        : m_blobs(blobs)
+    {
+        // Called with the mutex locked.
+        auto &counts = blobReferenceCounts();
+        for (const auto &hash : m_blobs)
+            ++counts[hash];
+    }
+
+    ~BlobReferences()
+    {
+        QMutexLocker lock(&blobReferencesMutex());
+        auto &counts = blobReferenceCounts();
+        for (const auto &hash : m_blobs) {
+            auto it = counts.find(hash);
+            if ( it != counts.end() && --it.value() <= 0 )
+                counts.erase(it);
         }
     }
 
-    return "0" + mime;
+    BlobReferences(const BlobReferences &) = delete;
+    BlobReferences &operator=(const BlobReferences &) = delete;
+
+private:
+    QSet<QString> m_blobs;
+};
+
+/// Keeps content of tab file with items and blobs referenced from it.
+class IndexedItemsOwner final {
+public:
+    IndexedItemsOwner(const std::shared_ptr<const void> &content, const QSet<QString> &blobs)
+        : m_content(content)
+        , m_blobs(blobs)
+    {
+    }
+
+private:
+    std::shared_ptr<const void> m_content;
+    BlobReferences m_blobs;
+};
+
+QByteArray readBlob(const QString &hash)
+{
+    if ( !isValidBlobHash(hash) )
+        return QByteArray();
+
+    QFile file( blobFilePath(hash) );
+    if ( !file.open(QIODevice::ReadOnly) )
+        return QByteArray();
+    return file.readAll();
 }
 
-bool deserializeDataV2(QDataStream *out, QVariantMap *data)
+/**
+ * Updates modification time of existing blob.
+ *
+ * Other sessions keep recently modified blobs in shared directory since these
+ * can be referenced only from unsaved items.
+ */
+void touchBlob(const QString &path)
+{
+    QFile file(path);
+    if ( !file.open(QIODevice::ReadWrite) )
+        return;
+
+    const QByteArray firstByte = file.read(1);
+    if ( !firstByte.isEmpty() && file.seek(0) )
+        file.write(firstByte);
+}
+
+/// Stores data in blob directory (unless already stored) and returns its hash.
+QString writeBlob(const QByteArray &bytes)
+{
+    const QString hash = QString::fromLatin1(
+                QCryptographicHash::hash(bytes, QCryptographicHash::Sha256).toHex() );
+    const QString path = blobFilePath(hash);
+
+    // Items can be encoded in parallel and share the same data.
+    static QMutex mutex;
+    QMutexLocker lock(&mutex);
+
+    // Other sessions must not remove the blob between checking and touching it.
+    ItemBlobDirectoryLock directoryLock;
+
+    if ( QFile::exists(path) ) {
+        if ( isItemBlobDirectoryShared() )
+            touchBlob(path);
+        return hash;
+    }
+
+    if ( !QDir().mkpath(itemBlobDirectoryPath()) )
+        return QString();
+
+    QFile file(path + ".tmp");
+    if ( !file.open(QIODevice::WriteOnly)
+         || file.write(bytes) != bytes.size()
+         || !file.flush() )
+    {
+        log( QString("Failed to store item data to %1: %2").arg(path, file.errorString()), LogError );
+        file.remove();
+        return QString();
+    }
+
+    file.close();
+    if ( !file.rename(path) && !QFile::exists(path) ) {
+        file.remove();
+        return QString();
+    }
+
+    return hash;
+}
+
+void logMissingBlob(const QString &hash)
+{
+    if ( isValidBlobHash(hash) )
+        log( QString("Failed to read item data from %1").arg(blobFilePath(hash)), LogError );
+    else
+        log( "Failed to read item data with invalid reference", LogError );
+}
+
+/**
+ * Lists formats with data missing in blob directory in the item
+ * so the data loss is visible and the formats are not silently dropped.
+ */
+template <typename InsertFormat>
+void insertMissingFormats(const QStringList &missingFormats, InsertFormat insertFormat)
+{
+    insertFormat( QString::fromLatin1(mimeMissingData), missingFormats.join("\n").toUtf8() );
+}
+
+/**
+ * Reads formats of item data.
+ *
+ * Formats with data in blob directory are loaded only if @a readBlobs is true,
+ * i.e. if the data come from own tab or journal file. Otherwise these are
+ * dropped so external data cannot refer to local files.
+ */
+template <typename InsertFormat>
+bool readFormatsV2(QDataStream *out, bool readBlobs, InsertFormat insertFormat)
 {
     qint32 size;
     *out >> size;
 
     QByteArray tmpBytes;
     bool compress;
+    QStringList missingFormats;
     for (qint32 i = 0; i < size && out->status() == QDataStream::Ok; ++i) {
         const QString mime = decompressMime(out);
         if ( out->status() != QDataStream::Ok )
@@ -117,32 +389,545 @@ bool deserializeDataV2(QDataStream *out, QVariantMap *data)
                 return false;
             }
         }
-        data->insert(mime, tmpBytes);
+
+        if ( mime.startsWith(blobMimePrefix) ) {
+            if (!readBlobs)
+                continue;
+            const QString hash = QString::fromLatin1(tmpBytes);
+            tmpBytes = readBlob(hash);
+            if ( tmpBytes.isNull() ) {
+                logMissingBlob(hash);
+                missingFormats.append( mime.mid(blobMimePrefix.size()) );
+                continue;
+            }
+            insertFormat( mime.mid(blobMimePrefix.size()), tmpBytes );
+        } else {
+            insertFormat(mime, tmpBytes);
+        }
     }
 
+    if ( !missingFormats.isEmpty() )
+        insertMissingFormats(missingFormats, insertFormat);
+
     return out->status() == QDataStream::Ok;
 }
 
-} // namespace
+/**
+ * Reads values written by QDataStream (version Qt_4_7) directly from memory.
+ *
+ * Avoids QIODevice calls and temporary allocations in QDataStream when
+ * decoding many items from tab file mapped to memory.
+ */
+class DataReader final {
+public:
+    explicit DataReader(const QByteArray &bytes)
+        : m_data(bytes.constData())
+        , m_end(bytes.constData() + bytes.size())
+    {
+    }
 
-void serializeData(QDataStream *stream, const QVariantMap &data)
+    bool ok() const { return m_ok; }
+
+    qint32 readInt32()
+    {
+        const char *data = take(sizeof(qint32));
+        return data ? qFromBigEndian<qint32>(reinterpret_cast<const uchar*>(data)) : 0;
+    }
+
+    bool readBool()
+    {
+        const char *data = take(1);
+        return data && *data != 0;
+    }
+
+    /// Returns data pointer and size of next QByteArray (nullptr if null or invalid).
+    const char *readBytes(int *size)
+    {
+        *size = 0;
+        const quint32 length = static_cast<quint32>( readInt32() );
+        if ( !m_ok || length == 0xffffffff )
+            return nullptr;
+
+        const char *data = take(length);
+        if (data)
+            *size = static_cast<int>(length);
+        return data;
+    }
+
+    QString readString()
+    {
+        const quint32 length = static_cast<quint32>( readInt32() );
+        if ( !m_ok || length == 0xffffffff )
+            return QString();
+
+        const char *data = take(length);
+        if ( !data || length % 2 != 0 ) {
+            m_ok = false;
+            return QString();
+        }
+
+        const int size = static_cast<int>(length / 2);
+        QString text(size, Qt::Uninitialized);
+        const auto source = reinterpret_cast<const uchar*>(data);
+        for (int i = 0; i < size; ++i)
+            text[i] = QChar( qFromBigEndian<quint16>(source + 2 * i) );
+        return text;
+    }
+
+private:
+    const char *take(quint32 size)
+    {
+        if ( !m_ok || size > static_cast<quint32>(m_end - m_data) ) {
+            m_ok = false;
+            return nullptr;
+        }
+
+        const char *data = m_data;
+        m_data += size;
+        return data;
+    }
+
+    const char *m_data;
+    const char *m_end;
+    bool m_ok = true;
+};
+
+template <typename InsertFormat>
+bool readFormatsV2(DataReader *reader, bool readBlobs, InsertFormat insertFormat)
+{
+    const qint32 size = reader->readInt32();
+
+    QStringList missingFormats;
+    for (qint32 i = 0; i < size && reader->ok(); ++i) {
+        bool ok;
+        const QString mime = decompressMime(reader->readString(), &ok);
+        if ( !ok || !reader->ok() )
+            return false;
+
+        const bool compress = reader->readBool();
+        int bytesSize;
+        const char *bytesData = reader->readBytes(&bytesSize);
+        if ( !reader->ok() )
+            return false;
+
+        QByteArray bytes;
+        if (compress) {
+            bytes = qUncompress(reinterpret_cast<const uchar*>(bytesData), bytesSize);
+            if ( bytes.isEmpty() )
+                return false;
+        } else if (bytesData) {
+            // Copy the data since these can outlive the mapped tab file.
+            bytes = QByteArray(bytesData, bytesSize);
+        }
+
+        if ( mime.startsWith(blobMimePrefix) ) {
+            if (!readBlobs)
+                continue;
+            const QString hash = QString::fromLatin1(bytes);
+            bytes = readBlob(hash);
+            if ( bytes.isNull() ) {
+                logMissingBlob(hash);
+                missingFormats.append( mime.mid(blobMimePrefix.size()) );
+                continue;
+            }
+            insertFormat( mime.mid(blobMimePrefix.size()), bytes );
+        } else {
+            insertFormat(mime, bytes);
+        }
+    }
+
+    if ( !missingFormats.isEmpty() )
+        insertMissingFormats(missingFormats, insertFormat);
+
+    return reader->ok();
+}
+
+bool deserializeDataV2(QDataStream *out, bool readBlobs, QVariantMap *data)
+{
+    return readFormatsV2(out, readBlobs, [data](const QString &mime, const QByteArray &bytes) {
+        data->insert(mime, bytes);
+    });
+}
+
+/**
+ * Serializes item data.
+ *
+ * Data are compressed only if @a compressData is set (for files), compressing
+ * data passed to other processes or dragged would just slow it down.
+ */
+void serializeItem(
+        QDataStream *stream, const QVariantMap &data, bool compressData, int minBlobSize,
+        QSet<QString> *blobs, QVector<SerializedFormatInfo> *formats)
 {
     *stream << static_cast<qint32>(-2);
 
-    const qint32 size = data.size();
+    // Formats referring to blob directory can be only created here.
+    qint32 size = data.size();
+    for (auto it = data.lowerBound(blobMimePrefix);
+         it != data.constEnd() && it.key().startsWith(blobMimePrefix); ++it)
+    {
+        --size;
+    }
     *stream << size;
 
+    if (formats)
+        formats->reserve(size);
+
     QByteArray bytes;
     for (auto it = data.constBegin(); it != data.constEnd(); ++it) {
         const auto &mime = it.key();
-        bytes = data[mime].toByteArray();
+        if ( mime.startsWith(blobMimePrefix) )
+            continue;
+
+        bytes = it.value().toByteArray();
+
+        SerializedFormatInfo formatInfo;
+        formatInfo.mime = mime;
+        formatInfo.size = bytes.size();
+
+        if ( minBlobSize > 0 && bytes.size() >= minBlobSize ) {
+            const QString hash = writeBlob(bytes);
+            if ( !hash.isEmpty() ) {
+                blobs->insert(hash);
+                *stream << compressMime(blobMimePrefix + mime)
+                        << /* compressData = */ false
+                        << hash.toLatin1();
+                if (formats) {
+                    formatInfo.flags = SerializedFormatInfo::InBlob;
+                    formats->append(formatInfo);
+                }
+                continue;
+            }
+        }
+
+        bool compress = compressData && shouldCompress(mime, bytes.size());
+        if (compress) {
+            const QByteArray compressedBytes = qCompress(bytes, compressionLevel);
+            // Keep uncompressed data if compression doesn't help much.
+            compress = compressedBytes.size() < bytes.size() - bytes.size() / 8;
+            if (compress)
+                bytes = compressedBytes;
+        }
+
         *stream << compressMime(mime)
-                << /* compressData = */ false
+                << compress
                 << bytes;
+
+        if (formats) {
+            if (compress)
+                formatInfo.flags = SerializedFormatInfo::Compressed;
+            formats->append(formatInfo);
+        }
     }
 }
 
-void deserializeData(QDataStream *stream, QVariantMap *data)
+/// Number of items encoded in single task when saving tab.
+const int encodeChunkSize = 256;
+
+/// Items encoded with serializeItem() in a separate thread.
+struct EncodedItems {
+    QVector<QVariantMap> items;
+    /// Data of unmodified items stored as they are (bytes are null for other items).
+    QVector<SerializedItemData> serializedItems;
+    QByteArray bytes;
+    /// Offsets of items in bytes.
+    QVector<qint64> offsets;
+    QSet<QString> blobs;
+    /// Formats of each item.
+    QVector<QVector<SerializedFormatInfo>> formats;
+};
+
+QThreadPool *encodeThreadPool()
+{
+    static QThreadPool pool;
+    return &pool;
+}
+
+void encodeItems(EncodedItems *encoded, int minBlobSize)
+{
+    QDataStream stream(&encoded->bytes, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    encoded->offsets.reserve( encoded->items.size() );
+    encoded->formats.resize( encoded->items.size() );
+    for (int i = 0; i < encoded->items.size(); ++i) {
+        encoded->offsets.append( stream.device()->pos() );
+        const SerializedItemData &serializedData = encoded->serializedItems[i];
+        if ( serializedData.bytes.isNull() ) {
+            serializeItem(&stream, encoded->items[i], true, minBlobSize, &encoded->blobs, &encoded->formats[i]);
+        } else {
+            stream.writeRawData( serializedData.bytes.constData(), serializedData.bytes.size() );
+            for ( const auto &hash : serializedItemBlobs(serializedData.bytes) )
+                encoded->blobs.insert(hash);
+            encoded->formats[i] = serializedData.formats;
+        }
+    }
+
+    // Free item data early, these can take lot of memory.
+    encoded->items = QVector<QVariantMap>();
+    encoded->serializedItems = QVector<SerializedItemData>();
+}
+
+class EncodeItemsTask final : public QRunnable
+{
+public:
+    EncodeItemsTask(EncodedItems *encoded, int minBlobSize, QSemaphore *finished)
+        : m_encoded(encoded)
+        , m_minBlobSize(minBlobSize)
+        , m_finished(finished)
+    {
+    }
+
+    void run() override
+    {
+        encodeItems(m_encoded, m_minBlobSize);
+        m_finished->release();
+    }
+
+private:
+    EncodedItems *m_encoded;
+    int m_minBlobSize;
+    QSemaphore *m_finished;
+};
+
+// Marks file with item offset table (see serializeData(const QAbstractItemModel &, QIODevice *)).
+const qint32 indexedItemsVersion = -3;
+
+// Marks item hashes stored after blob references (64-bit hashes from hashFormat()).
+const qint32 itemHashVersion = -1;
+
+// Marks item creation and last use times stored after item hashes.
+const qint32 itemTimesVersion = -1;
+
+// Marks item formats with sizes and flags stored after item times.
+const qint32 itemFormatsVersion = -1;
+
+/**
+ * Returns beginning of the file content in memory.
+ *
+ * File is memory mapped if possible (@a mapped is set), otherwise it's read
+ * to a buffer. The returned owner keeps the memory valid.
+ */
+const char *fileContent(QIODevice *file, std::shared_ptr<const void> *owner, bool *mapped)
+{
+    *mapped = false;
+
+#ifndef Q_OS_WIN
+    // On Windows, a mapped file cannot be removed or replaced when saving items.
+    const auto inputFile = qobject_cast<QFile*>(file);
+    if (inputFile) {
+        const auto mappedFile = std::make_shared<QFile>( inputFile->fileName() );
+        if ( mappedFile->open(QIODevice::ReadOnly) ) {
+            const uchar *bytes = mappedFile->map( 0, mappedFile->size() );
+            // Mapping remains valid until file object is destroyed.
+            mappedFile->close();
+            if (bytes) {
+                *owner = mappedFile;
+                *mapped = true;
+                return reinterpret_cast<const char*>(bytes);
+            }
+        }
+    }
+#endif
+
+    if ( !file->seek(0) )
+        return nullptr;
+
+    const auto buffer = std::make_shared<QByteArray>( file->readAll() );
+    if ( buffer->size() != file->size() )
+        return nullptr;
+
+    *owner = buffer;
+    return buffer->constData();
+}
+
+/**
+ * Returns item hashes stored after item data and blob references
+ * or empty list if hashes are not available.
+ *
+ * Referenced blobs are stored in @a blobs.
+ *
+ * Stream must be positioned after item data.
+ */
+QVector<quint64> readItemHashes(QDataStream *stream, qint32 length, QStringList *blobs)
+{
+    qint32 hashVersion;
+    *stream >> *blobs >> hashVersion;
+
+    // Older versions stored hashes which depend on Qt version.
+    if ( stream->status() != QDataStream::Ok || hashVersion != itemHashVersion ) {
+        stream->resetStatus();
+        return QVector<quint64>();
+    }
+
+    QVector<quint64> hashes(length);
+    for (auto &hash : hashes)
+        *stream >> hash;
+
+    if ( stream->status() != QDataStream::Ok ) {
+        stream->resetStatus();
+        return QVector<quint64>();
+    }
+
+    return hashes;
+}
+
+/**
+ * Returns item creation and last use times (pair of values for each item)
+ * stored after item hashes or empty list if times are not available.
+ *
+ * Stream must be positioned after item hashes.
+ */
+QVector<qint64> readItemTimes(QDataStream *stream, qint32 length)
+{
+    qint32 timesVersion;
+    *stream >> timesVersion;
+
+    if ( stream->status() != QDataStream::Ok || timesVersion != itemTimesVersion ) {
+        stream->resetStatus();
+        return QVector<qint64>();
+    }
+
+    QVector<qint64> times(2 * length);
+    for (auto &time : times)
+        *stream >> time;
+
+    if ( stream->status() != QDataStream::Ok ) {
+        stream->resetStatus();
+        return QVector<qint64>();
+    }
+
+    return times;
+}
+
+/**
+ * Returns formats of each item stored after item times
+ * or empty list if formats are not available.
+ *
+ * Stream must be positioned after item times.
+ */
+QVector<QVector<SerializedFormatInfo>> readItemFormats(QDataStream *stream, qint32 length)
+{
+    qint32 formatsVersion;
+    *stream >> formatsVersion;
+
+    if ( stream->status() != QDataStream::Ok || formatsVersion != itemFormatsVersion ) {
+        stream->resetStatus();
+        return QVector<QVector<SerializedFormatInfo>>();
+    }
+
+    QVector<QVector<SerializedFormatInfo>> itemFormats(length);
+    for (auto &formats : itemFormats) {
+        qint32 formatCount;
+        *stream >> formatCount;
+        if ( stream->status() != QDataStream::Ok || formatCount < 0 )
+            break;
+
+        formats.resize(formatCount);
+        for (auto &format : formats) {
+            qint32 flags;
+            format.mime = decompressMime(stream);
+            *stream >> format.size >> flags;
+            format.flags = flags;
+        }
+    }
+
+    if ( stream->status() != QDataStream::Ok ) {
+        stream->resetStatus();
+        return QVector<QVector<SerializedFormatInfo>>();
+    }
+
+    return itemFormats;
+}
+
+bool deserializeIndexedItems(QAbstractItemModel *model, QDataStream *stream, int maxItems)
+{
+    qint32 length;
+    *stream >> length;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    QIODevice *file = stream->device();
+    if ( length < 0 || static_cast<qint64>(length) * 8 > file->size() ) {
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    QVector<qint64> offsets(length + 1);
+    for (auto &offset : offsets)
+        *stream >> offset;
+
+    if ( stream->status() != QDataStream::Ok )
+        return false;
+
+    const qint64 dataStart = file->pos();
+    if ( !std::is_sorted(std::begin(offsets), std::end(offsets))
+         || offsets.first() < dataStart || offsets.last() > file->size() )
+    {
+        stream->setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    file->seek( offsets.last() );
+    QStringList blobs;
+    const QVector<quint64> hashes = readItemHashes(stream, length, &blobs);
+    const QVector<qint64> times = hashes.isEmpty() ? QVector<qint64>() : readItemTimes(stream, length);
+    const QVector<QVector<SerializedFormatInfo>> formats =
+            times.isEmpty() ? QVector<QVector<SerializedFormatInfo>>() : readItemFormats(stream, length);
+
+    std::shared_ptr<const void> content;
+    bool mapped;
+    const char *contentData = fileContent(file, &content, &mapped);
+    if (!contentData) {
+        stream->setStatus(QDataStream::ReadPastEnd);
+        return false;
+    }
+
+    // Items share mapped file content. Otherwise each item gets a copy of
+    // its data so the whole file buffer is not kept until all items are
+    // decoded or the file is rewritten.
+    std::shared_ptr<const void> owner;
+    if (mapped)
+        owner = content;
+
+    // Blobs referenced from the file are kept until all its items are released
+    // (items can be also dragged to other tabs without decoding).
+    if ( !blobs.isEmpty() ) {
+        QMutexLocker lock(&blobReferencesMutex());
+        owner = std::make_shared<IndexedItemsOwner>(owner, blobs.toSet());
+    }
+
+    // Limit the loaded number of items to model's maximum.
+    length = qMin(length, maxItems - model->rowCount());
+
+    if ( length > 0 && !model->insertRows(0, length) )
+        return false;
+
+    for (qint32 i = 0; i < length; ++i) {
+        const qint64 offset = offsets[i];
+        const int size = static_cast<int>(offsets[i + 1] - offset);
+        SerializedItemData itemData;
+        itemData.owner = owner;
+        itemData.bytes = mapped
+                ? QByteArray::fromRawData(contentData + offset, size)
+                : QByteArray(contentData + offset, size);
+        itemData.hash = hashes.value(i);
+        itemData.createdTime = times.value(2 * i);
+        itemData.lastUsedTime = times.value(2 * i + 1);
+        if ( !formats.isEmpty() ) {
+            itemData.formats = formats[i];
+            itemData.hasFormats = true;
+        }
+        model->setData( model->index(i, 0), QVariant::fromValue(itemData), contentType::serializedData );
+    }
+
+    file->seek( offsets.last() );
+
+    return true;
+}
+
+void readData(QDataStream *stream, QVariantMap *data, bool readBlobs)
 {
     try {
         qint32 length;
@@ -152,7 +937,7 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
             return;
 
         if (length == -2) {
-            deserializeDataV2(stream, data);
+            deserializeDataV2(stream, readBlobs, data);
             return;
         }
 
@@ -174,7 +959,8 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
                     break;
                 }
             }
-            data->insert(mime, tmpBytes);
+            if ( !mime.startsWith(blobMimePrefix) )
+                data->insert(mime, tmpBytes);
         }
     } catch (const std::exception &e) {
         log( QObject::tr("Data deserialization failed: %1").arg(e.what()), LogError );
@@ -182,6 +968,58 @@ void deserializeData(QDataStream *stream, QVariantMap *data)
     }
 }
 
+bool readData(QVariantMap *data, const QByteArray &bytes, bool readBlobs)
+{
+    QDataStream out(bytes);
+    readData(&out, data, readBlobs);
+    return out.status() == QDataStream::Ok;
+}
+
+bool readData(DataFormats *formats, const QByteArray &bytes, bool readBlobs)
+{
+    DataReader reader(bytes);
+    const qint32 length = reader.readInt32();
+    if ( !reader.ok() )
+        return false;
+
+    if (length != -2) {
+        QVariantMap data;
+        if ( !readData(&data, bytes, readBlobs) )
+            return false;
+
+        formats->reserve( data.size() );
+        for (auto it = data.constBegin(); it != data.constEnd(); ++it)
+            formats->append( qMakePair(it.key(), it.value().toByteArray()) );
+        return true;
+    }
+
+    try {
+        return readFormatsV2(&reader, readBlobs, [formats](const QString &mime, const QByteArray &bytes) {
+            formats->append( qMakePair(mime, bytes) );
+        });
+    } catch (const std::exception &e) {
+        log( QObject::tr("Data deserialization failed: %1").arg(e.what()), LogError );
+        return false;
+    }
+}
+
+} // namespace
+
+void serializeData(QDataStream *stream, const QVariantMap &data)
+{
+    serializeItem(stream, data, false, 0, nullptr, nullptr);
+}
+
+void serializeStoredData(QDataStream *stream, const QVariantMap &data)
+{
+    serializeItem(stream, data, true, 0, nullptr, nullptr);
+}
+
+void deserializeData(QDataStream *stream, QVariantMap *data)
+{
+    readData(stream, data, false);
+}
+
 QByteArray serializeData(const QVariantMap &data)
 {
     QByteArray bytes;
@@ -192,9 +1030,27 @@ QByteArray serializeData(const QVariantMap &data)
 
 bool deserializeData(QVariantMap *data, const QByteArray &bytes)
 {
-    QDataStream out(bytes);
-    deserializeData(&out, data);
-    return out.status() == QDataStream::Ok;
+    return readData(data, bytes, false);
+}
+
+bool deserializeData(DataFormats *formats, const QByteArray &bytes)
+{
+    return readData(formats, bytes, false);
+}
+
+void deserializeStoredData(QDataStream *stream, QVariantMap *data)
+{
+    readData(stream, data, true);
+}
+
+bool deserializeStoredData(QVariantMap *data, const QByteArray &bytes)
+{
+    return readData(data, bytes, true);
+}
+
+bool deserializeStoredData(DataFormats *formats, const QByteArray &bytes)
+{
+    return readData(formats, bytes, true);
 }
 
 bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
@@ -203,7 +1059,7 @@ bool serializeData(const QAbstractItemModel &model, QDataStream *stream)
     *stream << length;
 
     for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i)
-        serializeData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
+        serializeStoredData( stream, model.data(model.index(i, 0), contentType::data).toMap() );
 
     return stream->status() == QDataStream::Ok;
 }
@@ -222,9 +1078,9 @@ bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItem
     }
 
     // Limit the loaded number of items to model's maximum.
-    length = qMin(length, maxItems) - model->rowCount();
+    length = qMin(length, maxItems - model->rowCount());
 
-    if ( length != 0 && !model->insertRows(0, length) )
+    if ( length > 0 && !model->insertRows(0, length) )
         return false;
 
     for(qint32 i = 0; i < length && stream->status() == QDataStream::Ok; ++i) {
@@ -236,16 +1092,352 @@ bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItem
     return stream->status() == QDataStream::Ok;
 }
 
-bool serializeData(const QAbstractItemModel &model, QIODevice *file)
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, int minBlobSize)
 {
     QDataStream stream(file);
     stream.setVersion(QDataStream::Qt_4_7);
-    return serializeData(model, &stream);
+
+    if ( file->isSequential() )
+        return serializeData(model, &stream);
+
+    const qint32 length = model.rowCount();
+    stream << indexedItemsVersion << length;
+
+    // Reserve space for offset table (includes end of the last item).
+    const qint64 offsetTablePosition = file->pos();
+    for (qint32 i = 0; i <= length; ++i)
+        stream << static_cast<qint64>(0);
+
+    QVector<qint64> offsets;
+    offsets.reserve(length + 1);
+    QVector<quint64> hashes;
+    hashes.reserve(length);
+    QVector<qint64> times;
+    times.reserve(2 * length);
+    QVector<QVector<SerializedFormatInfo>> formats;
+    formats.reserve(length);
+    QSet<QString> blobs;
+
+    // Item data are read from model in this thread, encoding and compression
+    // runs in parallel in chunks which are written to the file in order.
+    const int maxChunks = 2 * qMax(1, QThread::idealThreadCount());
+    QVector<EncodedItems> chunks;
+    QSemaphore chunksFinished;
+    for (qint32 i = 0; i < length && stream.status() == QDataStream::Ok; ) {
+        chunks.clear();
+        for ( ; i < length && chunks.size() < maxChunks; ) {
+            EncodedItems chunk;
+            const int chunkEnd = qMin(length, i + encodeChunkSize);
+            chunk.items.reserve(chunkEnd - i);
+            chunk.serializedItems.reserve(chunkEnd - i);
+            for ( ; i < chunkEnd; ++i ) {
+                const QModelIndex index = model.index(i, 0);
+                // Unmodified items are written as loaded without decoding them.
+                auto serializedData = model.data(index, contentType::serializedData).value<SerializedItemData>();
+                if ( serializedData.hasFormats ) {
+                    chunk.items.append( QVariantMap() );
+                } else {
+                    serializedData = SerializedItemData();
+                    chunk.items.append( model.data(index, contentType::data).toMap() );
+                }
+                chunk.serializedItems.append(serializedData);
+                hashes.append( model.data(index, contentType::hash).toULongLong() );
+                times.append( model.data(index, contentType::createdTime).toLongLong() );
+                times.append( model.data(index, contentType::lastUsedTime).toLongLong() );
+            }
+            chunks.append(chunk);
+        }
+
+        if ( chunks.size() == 1 ) {
+            encodeItems(&chunks[0], minBlobSize);
+        } else {
+            for (auto &chunk : chunks)
+                encodeThreadPool()->start( new EncodeItemsTask(&chunk, minBlobSize, &chunksFinished) );
+            chunksFinished.acquire( chunks.size() );
+        }
+
+        for (const auto &chunk : chunks) {
+            const qint64 chunkPosition = file->pos();
+            for (const auto offset : chunk.offsets)
+                offsets.append(chunkPosition + offset);
+            blobs.unite(chunk.blobs);
+            formats += chunk.formats;
+            if ( file->write(chunk.bytes) != chunk.bytes.size() ) {
+                stream.setStatus(QDataStream::WriteFailed);
+                break;
+            }
+        }
+    }
+    offsets.append( file->pos() );
+
+    // Referenced blobs are listed after items (see itemBlobReferences()).
+    QStringList blobList = blobs.toList();
+    blobList.sort();
+    stream << blobList;
+
+    // Item hashes follow (see readItemHashes()).
+    stream << itemHashVersion;
+    for (const auto hash : hashes)
+        stream << hash;
+
+    // Item times follow (see readItemTimes()).
+    stream << itemTimesVersion;
+    for (const auto time : times)
+        stream << time;
+
+    // Item formats follow (see readItemFormats()).
+    stream << itemFormatsVersion;
+    for (const auto &itemFormats : formats) {
+        stream << static_cast<qint32>(itemFormats.size());
+        for (const auto &format : itemFormats) {
+            stream << compressMime(format.mime)
+                   << format.size
+                   << static_cast<qint32>(format.flags);
+        }
+    }
+
+    const qint64 end = file->pos();
+
+    if ( stream.status() != QDataStream::Ok || !file->seek(offsetTablePosition) )
+        return false;
+
+    for (const auto offset : offsets)
+        stream << offset;
+
+    return stream.status() == QDataStream::Ok && file->seek(end);
+}
+
+QStringList itemBlobReferences(QIODevice *file)
+{
+    QDataStream stream(file);
+    stream.setVersion(QDataStream::Qt_4_7);
+
+    qint32 version;
+    qint32 length;
+    stream >> version >> length;
+    if ( stream.status() != QDataStream::Ok || version != indexedItemsVersion || length < 0 )
+        return QStringList();
+
+    // Skip to end of the offset table and read end of the last item.
+    if ( !file->seek(file->pos() + static_cast<qint64>(length) * 8) )
+        return QStringList();
+
+    qint64 end;
+    stream >> end;
+    if ( stream.status() != QDataStream::Ok || !file->seek(end) )
+        return QStringList();
+
+    QStringList blobs;
+    stream >> blobs;
+    return blobs;
+}
+
+SerializedItemData serializeItemData(const QVariantMap &data, int minBlobSize)
+{
+    SerializedItemData serializedData;
+    QSet<QString> blobs;
+
+    // Blobs are written without holding the lock so other items are not blocked.
+    const auto serialize = [&]() {
+        serializedData.bytes.clear();
+        serializedData.formats.clear();
+        blobs.clear();
+        QDataStream stream(&serializedData.bytes, QIODevice::WriteOnly);
+        serializeItem(&stream, data, true, minBlobSize, &blobs, &serializedData.formats);
+        serializedData.hasFormats = true;
+    };
+
+    serialize();
+
+    // Blob could be removed before it's referenced, so write missing blobs
+    // again once these are referenced and cannot be removed.
+    for (int attempt = 0; attempt < 2 && !blobs.isEmpty(); ++attempt) {
+        bool blobsExist = true;
+        std::shared_ptr<BlobReferences> references;
+        {
+            QMutexLocker lock(&blobReferencesMutex());
+            references = std::make_shared<BlobReferences>(blobs);
+            for (const auto &hash : blobs) {
+                if ( !QFile::exists(blobFilePath(hash)) ) {
+                    blobsExist = false;
+                    break;
+                }
+            }
+        }
+        // Previous references are released without the lock.
+        serializedData.owner = references;
+
+        if (blobsExist)
+            break;
+
+        const auto oldBlobs = blobs;
+        serialize();
+        if (blobs == oldBlobs)
+            break;
+    }
+
+    return serializedData;
+}
+
+QString itemBlobFilePath(const QByteArray &bytes, const QString &mime)
+{
+    QDataStream stream(bytes);
+    qint32 length;
+    stream >> length;
+    if (length != -2)
+        return QString();
+
+    qint32 size;
+    stream >> size;
+
+    const QString blobMime = blobMimePrefix + mime;
+    QByteArray tmpBytes;
+    bool compress;
+    for (qint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i) {
+        const QString format = decompressMime(&stream);
+        stream >> compress >> tmpBytes;
+        if ( stream.status() == QDataStream::Ok && format == blobMime ) {
+            const QString hash = QString::fromLatin1(tmpBytes);
+            return isValidBlobHash(hash) ? blobFilePath(hash) : QString();
+        }
+    }
+
+    return QString();
+}
+
+QStringList serializedItemBlobs(const QByteArray &bytes)
+{
+    QDataStream stream(bytes);
+    qint32 length;
+    stream >> length;
+    if (length != -2)
+        return QStringList();
+
+    qint32 size;
+    stream >> size;
+
+    QStringList blobs;
+    QByteArray tmpBytes;
+    bool compress;
+    for (qint32 i = 0; i < size && stream.status() == QDataStream::Ok; ++i) {
+        const QString format = decompressMime(&stream);
+        stream >> compress >> tmpBytes;
+        if ( stream.status() == QDataStream::Ok && format.startsWith(blobMimePrefix) ) {
+            const QString hash = QString::fromLatin1(tmpBytes);
+            if ( isValidBlobHash(hash) )
+                blobs.append(hash);
+        }
+    }
+
+    return blobs;
+}
+
+void removeUnreferencedItemBlob(const QString &hash)
+{
+    if ( !isValidBlobHash(hash) )
+        return;
+
+    QMutexLocker lock(&blobReferencesMutex());
+    if ( blobReferenceCounts().contains(hash) )
+        return;
+
+    COPYQ_LOG_VERBOSE( QString("Removing unused item data %1").arg(hash) );
+    QFile::remove( blobFilePath(hash) );
+}
+
+QStringList referencedItemBlobs()
+{
+    QMutexLocker lock(&blobReferencesMutex());
+    return blobReferenceCounts().keys();
+}
+
+QString itemBlobDirectoryPath()
+{
+    static const QString path = isItemBlobDirectoryShared()
+            ? QDir::cleanPath( QString::fromLocal8Bit(qgetenv("COPYQ_SHARED_ITEM_DATA_PATH")) )
+            : getConfigurationFilePath("_blobs");
+    return path;
+}
+
+bool isItemBlobDirectoryShared()
+{
+    static const bool shared = !qgetenv("COPYQ_SHARED_ITEM_DATA_PATH").isEmpty();
+    return shared;
+}
+
+namespace {
+
+/// Guards lock file shared by all ItemBlobDirectoryLock instances.
+QMutex &blobDirectoryLockMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+int blobDirectoryLockCount = 0;
+QLockFile *blobDirectoryLockFile = nullptr;
+
+/// Lock is not considered stale while session saves items.
+const int blobDirectoryStaleLockTimeMs = 10 * 60 * 1000;
+
+/// Waiting for other sessions is abandoned after the timeout (this can keep unused blobs).
+const int blobDirectoryLockTimeoutMs = 30000;
+
+} // namespace
+
+ItemBlobDirectoryLock::ItemBlobDirectoryLock()
+{
+    if ( !isItemBlobDirectoryShared() )
+        return;
+
+    QMutexLocker lock(&blobDirectoryLockMutex());
+    ++blobDirectoryLockCount;
+    if (blobDirectoryLockCount != 1)
+        return;
+
+    QDir().mkpath(itemBlobDirectoryPath());
+    blobDirectoryLockFile = new QLockFile(itemBlobDirectoryPath() + "/lock");
+    blobDirectoryLockFile->setStaleLockTime(blobDirectoryStaleLockTimeMs);
+    if ( !blobDirectoryLockFile->tryLock(blobDirectoryLockTimeoutMs) ) {
+        log( QString("Failed to lock shared item data directory %1")
+             .arg(itemBlobDirectoryPath()), LogWarning );
+    }
+}
+
+ItemBlobDirectoryLock::~ItemBlobDirectoryLock()
+{
+    if ( !isItemBlobDirectoryShared() )
+        return;
+
+    QMutexLocker lock(&blobDirectoryLockMutex());
+    --blobDirectoryLockCount;
+    if (blobDirectoryLockCount != 0)
+        return;
+
+    delete blobDirectoryLockFile;
+    blobDirectoryLockFile = nullptr;
+}
+
+bool isItemBlobDirectoryLocked()
+{
+    QMutexLocker lock(&blobDirectoryLockMutex());
+    return blobDirectoryLockFile && blobDirectoryLockFile->isLocked();
 }
 
 bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems)
 {
     QDataStream stream(file);
     stream.setVersion(QDataStream::Qt_4_7);
+
+    if ( !file->isSequential() ) {
+        qint32 version;
+        stream >> version;
+        if ( stream.status() == QDataStream::Ok && version == indexedItemsVersion )
+            return deserializeIndexedItems(model, &stream, maxItems);
+
+        stream.resetStatus();
+        file->seek(0);
+    }
+
     return deserializeData(model, &stream, maxItems);
 }
@@ -20,21 +20,184 @@
 #ifndef SERIALIZE_H
 #define SERIALIZE_H
 
+#include <QByteArray>
+#include <QMetaType>
+#include <QPair>
+#include <QStringList>
 #include <QVariantMap>
+#include <QVector>
+
+#include <memory>
 
 class QAbstractItemModel;
-class QByteArray;
 class QDataStream;
 class QIODevice;
 
+/**
+ * Stored metadata of single item format, available without decoding item data.
+ */
+struct SerializedFormatInfo {
+    enum Flag {
+        /// Data are compressed in tab file.
+        Compressed = 1,
+        /// Data are stored in blob directory.
+        InBlob = 2,
+    };
+
+    QString mime;
+    /// Size of decoded data in bytes.
+    qint64 size = 0;
+    int flags = 0;
+};
+
+/**
+ * Item data serialized with serializeData(), decoded only when needed.
+ *
+ * Bytes can point to memory mapped tab file or shared buffer kept alive by owner.
+ */
+struct SerializedItemData {
+    std::shared_ptr<const void> owner;
+    QByteArray bytes;
+    /// Stored hash of item data (see contentType::hash) or 0 if unknown.
+    quint64 hash = 0;
+    /// Stored item times (see contentType::createdTime) or 0 if unknown.
+    qint64 createdTime = 0;
+    qint64 lastUsedTime = 0;
+    /// Stored formats in order as serialized (valid only if hasFormats is set).
+    QVector<SerializedFormatInfo> formats;
+    bool hasFormats = false;
+};
+
+Q_DECLARE_METATYPE(SerializedItemData)
+
 void serializeData(QDataStream *stream, const QVariantMap &data);
 void deserializeData(QDataStream *stream, QVariantMap *data);
 QByteArray serializeData(const QVariantMap &data);
 bool deserializeData(QVariantMap *data, const QByteArray &bytes);
 
+/// Item data formats (MIME type and data) in order as stored.
+using DataFormats = QVector<QPair<QString, QByteArray>>;
+
+/**
+ * Decode item data without creating QVariantMap.
+ *
+ * Avoids allocating map node and variant for each format when decoding
+ * many items. Formats are in stored order and may contain duplicates.
+ */
+bool deserializeData(DataFormats *formats, const QByteArray &bytes);
+
+/**
+ * Decode item data read from own tab or journal file.
+ *
+ * Unlike deserializeData(), which drops formats referring to blob directory,
+ * this loads the data from blob directory. Don't use it for data from other
+ * sources (clipboard, imported files, scripts or other processes).
+ */
+void deserializeStoredData(QDataStream *stream, QVariantMap *data);
+bool deserializeStoredData(QVariantMap *data, const QByteArray &bytes);
+bool deserializeStoredData(DataFormats *formats, const QByteArray &bytes);
+
+/**
+ * Serialize item data for own tab or journal file.
+ *
+ * Unlike serializeData(), this compresses data in suitable formats.
+ */
+void serializeStoredData(QDataStream *stream, const QVariantMap &data);
+
 bool serializeData(const QAbstractItemModel &model, QDataStream *stream);
 bool deserializeData(QAbstractItemModel *model, QDataStream *stream, int maxItems);
-bool serializeData(const QAbstractItemModel &model, QIODevice *file);
+/**
+ * Save items to file with offset table so items can be loaded lazily.
+ *
+ * Hashes of items (contentType::hash role) are stored too so that finding
+ * duplicate items doesn't require decoding item data. Same goes for list
+ * of formats with sizes (see SerializedFormatInfo).
+ *
+ * If @a minBlobSize is positive, data of at least this size are stored in
+ * directory shared by all tabs (see itemBlobDirectoryPath()) and file contains
+ * only hash of the data.
+ */
+bool serializeData(const QAbstractItemModel &model, QIODevice *file, int minBlobSize = 0);
+
+/**
+ * Load items from file.
+ *
+ * If the file contains offset table, item data are decoded only when needed
+ * (file is memory mapped if possible).
+ */
 bool deserializeData(QAbstractItemModel *model, QIODevice *file, int maxItems);
 
+/**
+ * Return hashes of data stored in blob directory referenced from tab file.
+ */
+QStringList itemBlobReferences(QIODevice *file);
+
+/**
+ * Serialize item data so these can be decoded later (see SerializedItemData).
+ *
+ * Data of at least @a minBlobSize bytes are stored in blob directory.
+ * These blobs are not removed until the returned owner is destroyed
+ * (see removeUnreferencedItemBlob()).
+ */
+SerializedItemData serializeItemData(const QVariantMap &data, int minBlobSize);
+
+/**
+ * Return path to blob file with @a mime format of serialized item data @a bytes
+ * or empty string if the format is not stored in blob directory.
+ *
+ * Data in blob file can be read directly without decoding the item.
+ */
+QString itemBlobFilePath(const QByteArray &bytes, const QString &mime);
+
+/**
+ * Return hashes of data stored in blob directory referenced from serialized item data @a bytes.
+ */
+QStringList serializedItemBlobs(const QByteArray &bytes);
+
+/**
+ * Remove data from blob directory unless referenced from serialized item data in memory.
+ */
+void removeUnreferencedItemBlob(const QString &hash);
+
+/**
+ * Return hashes of blobs referenced from serialized item data in memory.
+ */
+QStringList referencedItemBlobs();
+
+/**
+ * Return path to directory with data shared by tabs (file names are SHA-256 hashes).
+ *
+ * Directory can be shared by multiple sessions if COPYQ_SHARED_ITEM_DATA_PATH
+ * environment variable is set (see isItemBlobDirectoryShared()).
+ */
+QString itemBlobDirectoryPath();
+
+/**
+ * Return true if blob directory is shared by multiple sessions.
+ */
+bool isItemBlobDirectoryShared();
+
+/**
+ * Locks blob directory shared by multiple sessions.
+ *
+ * Unused blobs are removed only while holding the lock so other sessions
+ * cannot remove blobs which are being reused until the files referencing
+ * them are written. Locks in the same process (even in different threads)
+ * share single lock file. Does nothing if blob directory is not shared.
+ */
+class ItemBlobDirectoryLock final {
+public:
+    ItemBlobDirectoryLock();
+    ~ItemBlobDirectoryLock();
+
+    ItemBlobDirectoryLock(const ItemBlobDirectoryLock &) = delete;
+    ItemBlobDirectoryLock &operator=(const ItemBlobDirectoryLock &) = delete;
+};
+
+/**
+ * Return true only if current process holds lock for shared blob directory
+ * (see ItemBlobDirectoryLock).
+ */
+bool isItemBlobDirectoryLocked();
+
 #endif // SERIALIZE_H
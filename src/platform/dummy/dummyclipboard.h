@@ -36,6 +36,8 @@ public:
 
     void setData(ClipboardMode mode, const QVariantMap &dataMap) override;
 
+    void setSelectionSettleInterval(int) override {}
+
 protected:
     virtual void onChanged(int mode);
 
@@ -32,11 +32,20 @@
 #include <Cocoa/Cocoa.h>
 #include <Carbon/Carbon.h>
 
+namespace {
+
+/// Interval for checking pasteboard after it changed.
+const int minCheckClipboardIntervalMs = 250;
+/// Interval for checking pasteboard after it hasn't changed for a while.
+const int maxCheckClipboardIntervalMs = 1000;
+
+} // namespace
+
 MacClipboard::MacClipboard():
         m_prevChangeCount(0)
         , m_clipboardCheckTimer(new MacTimer(this)) {
 
-    m_clipboardCheckTimer->setInterval(250);
+    m_clipboardCheckTimer->setInterval(minCheckClipboardIntervalMs);
     m_clipboardCheckTimer->setTolerance(500);
 
     connect(m_clipboardCheckTimer, SIGNAL(timeout()), this, SLOT(clipboardTimeout()));
@@ -61,6 +70,9 @@ void MacClipboard::setData(ClipboardMode mode, const QVariantMap &dataMap)
         }
     }
 
+    // Check for changes often again in case other apps react to the new data.
+    m_clipboardCheckTimer->setInterval(minCheckClipboardIntervalMs);
+
     return DummyClipboard::setData(mode, dataMapForMac);
 }
 
@@ -71,6 +83,12 @@ void MacClipboard::clipboardTimeout() {
 
     if (newCount != m_prevChangeCount) {
         m_prevChangeCount = newCount;
+        m_clipboardCheckTimer->setInterval(minCheckClipboardIntervalMs);
         emit changed(ClipboardMode::Clipboard);
+    } else {
+        // Poll less often while pasteboard is idle.
+        const int interval = m_clipboardCheckTimer->interval();
+        if (interval < maxCheckClipboardIntervalMs)
+            m_clipboardCheckTimer->setInterval( qMin(maxCheckClipboardIntervalMs, interval + interval / 2) );
     }
 }
@@ -47,6 +47,13 @@ public:
      */
     virtual void setData(ClipboardMode mode, const QVariantMap &dataMap) = 0;
 
+    /**
+     * Set time to wait for selection to stop changing before fetching it.
+     *
+     * Only the last selection is fetched if it changes more often.
+     */
+    virtual void setSelectionSettleInterval(int ms) = 0;
+
 signals:
     /// Notifies about clipboard changes.
     void changed(ClipboardMode mode);
@@ -21,26 +21,42 @@
 
 #include <QTimer>
 
+namespace {
+
+/// Interval for checking clipboard after it changed.
+const int minCheckClipboardIntervalMs = 200;
+/// Interval for checking clipboard after it hasn't changed for a while.
+const int maxCheckClipboardIntervalMs = 1000;
+
+} // namespace
+
 WinPlatformClipboard::WinPlatformClipboard()
     : DummyClipboard(false)
     , m_lastClipboardSequenceNumber(-1)
+    , m_timerCheckClipboard(new QTimer(this))
 {
     /* Clipboard needs to be checked in intervals since
      * the QClipboard::changed() signal is not emitted in some cases on Windows.
      */
-    QTimer *timer = new QTimer(this);
-    timer->setInterval(200);
-    connect( timer, SIGNAL(timeout()),
+    m_timerCheckClipboard->setInterval(minCheckClipboardIntervalMs);
+    connect( m_timerCheckClipboard, SIGNAL(timeout()),
              this, SLOT(checkClipboard()) );
-    timer->start();
+    m_timerCheckClipboard->start();
 }
 
 void WinPlatformClipboard::checkClipboard()
 {
+    // Clipboard data are fetched only if the sequence number changes.
     const DWORD newClipboardSequenceNumber = GetClipboardSequenceNumber();
-    if (newClipboardSequenceNumber == m_lastClipboardSequenceNumber)
+    if (newClipboardSequenceNumber == m_lastClipboardSequenceNumber) {
+        // Check less often while clipboard is idle.
+        const int interval = m_timerCheckClipboard->interval();
+        if (interval < maxCheckClipboardIntervalMs)
+            m_timerCheckClipboard->setInterval( qMin(maxCheckClipboardIntervalMs, interval + interval / 2) );
         return;
+    }
 
+    m_timerCheckClipboard->setInterval(minCheckClipboardIntervalMs);
     m_lastClipboardSequenceNumber = newClipboardSequenceNumber;
     emit changed(ClipboardMode::Clipboard);
 }
@@ -24,6 +24,8 @@
 
 #include <qt_windows.h>
 
+class QTimer;
+
 class WinPlatformClipboard : public DummyClipboard
 {
     Q_OBJECT
@@ -35,6 +37,7 @@ private slots:
 
 private:
     DWORD m_lastClipboardSequenceNumber;
+    QTimer *m_timerCheckClipboard;
 };
 
 #endif // WINPLATFORMCLIPBOARD_H
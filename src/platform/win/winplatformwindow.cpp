@@ -21,6 +21,7 @@
 #include "winplatformwindow.h"
 
 #include "common/log.h"
+#include "common/sleeptimer.h"
 
 #include <QApplication>
 #include <QElapsedTimer>
@@ -139,7 +140,8 @@ void WinPlatformWindow::pasteClipboard()
         sendKeyPress(VK_LSHIFT, VK_INSERT);
 
     // Don't do anything hasty until the content is actually pasted.
-    Sleep(150);
+    // Process events meanwhile so the target can ask for the clipboard data.
+    waitFor(150);
 }
 
 void WinPlatformWindow::copy()
@@ -159,7 +161,9 @@ void WinPlatformWindow::sendKeyPress(WORD modifier, WORD key)
      if (!raiseWindow(m_window))
         return;
 
-    Sleep(150);
+    // Wait for the window to get focus before sending keys to it.
+    SleepTimer t(150);
+    while ( GetForegroundWindow() != m_window && t.sleep() ) {}
 
     QVector<INPUT> input1;
     QVector<INPUT> input2;
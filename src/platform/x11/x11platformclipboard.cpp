@@ -27,18 +27,23 @@
 #include "common/timer.h"
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
+#include "platform/x11/x11platformwindow.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
 
+#include <QAbstractNativeEventFilter>
 #include <QClipboard>
 #include <QMimeData>
 #include <QX11Info>
 
+#include <xcb/xcb.h>
+
 namespace {
 
 constexpr auto minCheckAgainIntervalMs = 50;
 constexpr auto maxCheckAgainIntervalMs = 500;
+constexpr auto fallbackCheckIntervalMs = 5000;
 
 /// Return true only if selection is incomplete, i.e. mouse button or shift key is pressed.
 bool isSelectionIncomplete()
@@ -59,9 +64,118 @@ bool isSelectionIncomplete()
     return event.xbutton.state & (Button1Mask | ShiftMask);
 }
 
+/**
+ * Return native window which owns the clipboard or selection.
+ *
+ * Unlike fetching data or TIMESTAMP target, this doesn't need to ask the
+ * owning application and can be called often.
+ */
+unsigned long selectionOwner(ClipboardMode mode)
+{
+    if (!QX11Info::isPlatformX11())
+        return 0;
+
+    auto display = QX11Info::display();
+    static const Atom clipboardAtom = XInternAtom(display, "CLIPBOARD", False);
+    const Atom selection = mode == ClipboardMode::Clipboard ? clipboardAtom : XA_PRIMARY;
+    return XGetSelectionOwner(display, selection);
+}
+
+/// Start receiving property changes of a window without overriding other events.
+void selectPropertyChanges(Display *display, Window window)
+{
+    XWindowAttributes attributes{};
+    if ( XGetWindowAttributes(display, window, &attributes) == 0 )
+        return;
+
+    if ( (attributes.your_event_mask & PropertyChangeMask) == 0 )
+        XSelectInput(display, window, attributes.your_event_mask | PropertyChangeMask);
+}
+
 } // namespace
 
+/**
+ * Title of the active window.
+ *
+ * The title is fetched again only after the active window or its title
+ * changes, which is signaled by PropertyNotify events.
+ */
+class ActiveWindowTitleCache final : public QAbstractNativeEventFilter {
+public:
+    ActiveWindowTitleCache()
+    {
+        if (!QX11Info::isPlatformX11())
+            return;
+
+        auto display = QX11Info::display();
+        m_rootWindow = DefaultRootWindow(display);
+        m_atomActiveWindow = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
+        m_atomName = XInternAtom(display, "_NET_WM_NAME", False);
+        selectPropertyChanges(display, m_rootWindow);
+
+        qApp->installNativeEventFilter(this);
+    }
+
+    ~ActiveWindowTitleCache()
+    {
+        if (m_rootWindow != 0)
+            qApp->removeNativeEventFilter(this);
+    }
+
+    /// Returns title of the active window or nullptr if there is no active window.
+    const QByteArray *title()
+    {
+        if (m_rootWindow == 0 || !m_valid) {
+            X11PlatformWindow window;
+            m_hasWindow = window.isValid();
+            m_title = m_hasWindow ? window.getTitle().toUtf8() : QByteArray();
+
+            if ( m_rootWindow != 0 && window.winId() != m_window ) {
+                m_window = window.winId();
+                if (m_window != 0)
+                    selectPropertyChanges(QX11Info::display(), m_window);
+            }
+
+            m_valid = true;
+        }
+
+        return m_hasWindow ? &m_title : nullptr;
+    }
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *) override
+    {
+        if (!m_valid || eventType != "xcb_generic_event_t")
+            return false;
+
+        const auto event = static_cast<xcb_generic_event_t *>(message);
+        if ( (event->response_type & ~0x80) != XCB_PROPERTY_NOTIFY )
+            return false;
+
+        const auto propertyEvent = static_cast<xcb_property_notify_event_t *>(message);
+        const auto atom = static_cast<Atom>(propertyEvent->atom);
+        if (propertyEvent->window == m_rootWindow) {
+            if (atom == m_atomActiveWindow)
+                m_valid = false;
+        } else if (propertyEvent->window == m_window) {
+            if (atom == m_atomName || atom == XA_WM_NAME)
+                m_valid = false;
+        }
+
+        return false;
+    }
+
+private:
+    Window m_rootWindow = 0;
+    Window m_window = 0;
+    Atom m_atomActiveWindow = 0;
+    Atom m_atomName = 0;
+    QByteArray m_title;
+    bool m_hasWindow = false;
+    bool m_valid = false;
+};
+
 X11PlatformClipboard::X11PlatformClipboard()
+    : m_activeWindowTitle(new ActiveWindowTitleCache())
 {
     m_clipboardData.mode = ClipboardMode::Clipboard;
     m_selectionData.mode = ClipboardMode::Selection;
@@ -86,8 +200,26 @@ X11PlatformClipboard::X11PlatformClipboard()
 
         useNewClipboardData(&m_selectionData);
     } );
+
+    initSingleShotTimer( &m_timerSelectionSettle, 0, this, [this](){
+        // Keep waiting until user finishes selecting text.
+        if ( isSelectionIncomplete() ) {
+            m_timerSelectionSettle.start();
+            return;
+        }
+
+        COPYQ_LOG("Selection settled");
+        checkAgainLater(true, 0);
+    } );
+
+    m_timerFallbackCheck.setInterval(fallbackCheckIntervalMs);
+    connect( &m_timerFallbackCheck, &QTimer::timeout,
+             this, &X11PlatformClipboard::checkFallback );
+    m_timerFallbackCheck.start();
 }
 
+X11PlatformClipboard::~X11PlatformClipboard() = default;
+
 void X11PlatformClipboard::setFormats(const QStringList &formats)
 {
     m_clipboardData.formats = formats;
@@ -115,24 +247,41 @@ void X11PlatformClipboard::setData(ClipboardMode mode, const QVariantMap &dataMa
     DummyClipboard::setData(mode, dataMap);
 }
 
+void X11PlatformClipboard::setSelectionSettleInterval(int ms)
+{
+    m_timerSelectionSettle.setInterval(ms);
+}
+
 void X11PlatformClipboard::onChanged(int mode)
 {
+    auto &clipboardData = mode == QClipboard::Clipboard ? m_clipboardData : m_selectionData;
+
+    // Fetch data on next check and verify them once more later in case
+    // the owner haven't provided new data yet.
+    clipboardData.pendingChecks = 2;
+
     // Store the current window title right after the clipboard/selection changes.
     // This makes sure that the title points to the correct clipboard/selection
     // owner most of the times.
-    PlatformPtr platform = createPlatformNativeInterface();
-    PlatformWindowPtr currentWindow = platform->getCurrentWindow();
-    if (currentWindow) {
-        const auto currentWindowTitle = currentWindow->getTitle().toUtf8();
-        auto &newOwner = mode == QClipboard::Clipboard ? m_clipboardData.newOwner : m_selectionData.newOwner;
-        if (currentWindowTitle != newOwner) {
+    const QByteArray *currentWindowTitle = m_activeWindowTitle->title();
+    if (currentWindowTitle) {
+        auto &newOwner = clipboardData.newOwner;
+        if (*currentWindowTitle != newOwner) {
             COPYQ_LOG( QString("New %1 owner: \"%2\"")
                        .arg(mode == QClipboard::Clipboard ? "clipboard" : "selection")
-                       .arg(QString::fromUtf8(currentWindowTitle)) );
-            newOwner = currentWindowTitle;
+                       .arg(QString::fromUtf8(*currentWindowTitle)) );
+            newOwner = *currentWindowTitle;
         }
     }
 
+    // Fetch only the last selection after it stops changing,
+    // intermediate selections are dropped without asking owner for data.
+    if ( mode == QClipboard::Selection && m_timerSelectionSettle.interval() > 0 ) {
+        m_selectionData.timerEmitChange.stop();
+        m_timerSelectionSettle.start();
+        return;
+    }
+
     // Omit checking selection too fast.
     if ( mode == QClipboard::Selection && m_timerCheckAgain.isActive() ) {
         COPYQ_LOG("Postponing fast selection change");
@@ -151,8 +300,18 @@ void X11PlatformClipboard::check()
 
     const auto changed =
         // Prioritize checking clipboard before selection.
-        updateClipboardData(&m_clipboardData)
-        || updateClipboardData(&m_selectionData);
+        updateClipboardDataIfNeeded(&m_clipboardData)
+        || updateClipboardDataIfNeeded(&m_selectionData);
+
+    // Wait for next change signal if data are up to date.
+    // Settling selection is checked once the settle timer times out.
+    const bool selectionPending =
+        m_selectionData.pendingChecks != 0 && !m_timerSelectionSettle.isActive();
+    if (!changed && m_clipboardData.pendingChecks == 0 && !selectionPending) {
+        m_timerCheckAgain.setInterval(0);
+        COPYQ_LOG("Clipboard and selection unchanged.");
+        return;
+    }
 
     // Check clipboard and selection again if some signals where
     // not delivered or older data was received after new one.
@@ -160,8 +319,40 @@ void X11PlatformClipboard::check()
     checkAgainLater(changed, interval);
 }
 
+void X11PlatformClipboard::checkFallback()
+{
+    // Regular checks are already scheduled.
+    if ( m_timerCheckAgain.isActive() || m_timerSelectionSettle.isActive() )
+        return;
+
+    // Unchanged data are not copied again thanks to TIMESTAMP target.
+    for (auto clipboardData : {&m_clipboardData, &m_selectionData})
+        clipboardData->pendingChecks = qMax(1, clipboardData->pendingChecks);
+
+    check();
+}
+
+bool X11PlatformClipboard::updateClipboardDataIfNeeded(X11PlatformClipboard::ClipboardData *clipboardData)
+{
+    if ( clipboardData->mode == ClipboardMode::Selection && m_timerSelectionSettle.isActive() )
+        return false;
+
+    // Avoid asking the owner for data again unless a change was signaled,
+    // the owner changed or the last fetched data still need to be verified.
+    const auto ownerWindow = selectionOwner(clipboardData->mode);
+    if (ownerWindow != clipboardData->ownerWindow)
+        clipboardData->pendingChecks = qMax(1, clipboardData->pendingChecks);
+
+    if (clipboardData->pendingChecks == 0)
+        return false;
+
+    return updateClipboardData(clipboardData);
+}
+
 bool X11PlatformClipboard::updateClipboardData(X11PlatformClipboard::ClipboardData *clipboardData)
 {
+    clipboardData->ownerWindow = selectionOwner(clipboardData->mode);
+
     const auto data = ::clipboardData(clipboardData->mode);
     if (!data) {
         m_timerCheckAgain.start(maxCheckAgainIntervalMs);
@@ -174,9 +365,12 @@ bool X11PlatformClipboard::updateClipboardData(X11PlatformClipboard::ClipboardDa
         clipboardData->newData = cloneData(*data, clipboardData->formats);
     }
 
-    if (clipboardData->data == clipboardData->newData)
+    if (clipboardData->data == clipboardData->newData) {
+        clipboardData->pendingChecks = qMax(0, clipboardData->pendingChecks - 1);
         return false;
+    }
 
+    clipboardData->pendingChecks = qMax(1, clipboardData->pendingChecks);
     clipboardData->timerEmitChange.start();
     return true;
 }
@@ -28,18 +28,24 @@
 
 #include <memory>
 
+class ActiveWindowTitleCache;
+
 class X11PlatformClipboard : public DummyClipboard
 {
     Q_OBJECT
 public:
     X11PlatformClipboard();
 
+    ~X11PlatformClipboard();
+
     void setFormats(const QStringList &formats) override;
 
     QVariantMap data(ClipboardMode mode, const QStringList &formats) const override;
 
     void setData(ClipboardMode mode, const QVariantMap &dataMap) override;
 
+    void setSelectionSettleInterval(int ms) override;
+
 protected:
     void onChanged(int mode) override;
 
@@ -53,9 +59,15 @@ private:
         QStringList formats;
         QByteArray newDataTimestamp;
         ClipboardMode mode;
+        /// Native owner window of the selection when data were last fetched.
+        unsigned long ownerWindow = 0;
+        /// Number of checks needed to make sure the data are up to date.
+        int pendingChecks = 2;
     };
 
     void check();
+    void checkFallback();
+    bool updateClipboardDataIfNeeded(ClipboardData *clipboardData);
     bool updateClipboardData(ClipboardData *clipboardData);
     void useNewClipboardData(ClipboardData *clipboardData);
     void checkAgainLater(bool clipboardChanged, int interval);
@@ -63,8 +75,16 @@ private:
     QTimer m_timerCheckAgain;
     int m_checkAgainIntervalMs = 0;
 
+    /// Postpones fetching selection until it stops changing.
+    QTimer m_timerSelectionSettle;
+
+    /// Fetches data occasionally in case a change was not signaled.
+    QTimer m_timerFallbackCheck;
+
     ClipboardData m_clipboardData;
     ClipboardData m_selectionData;
+
+    std::unique_ptr<ActiveWindowTitleCache> m_activeWindowTitle;
 };
 
 #endif // X11PLATFORMCLIPBOARD_H
@@ -23,6 +23,9 @@
 #include "platform/platformcommon.h"
 #include "x11platformwindow.h"
 
+#include <QAbstractNativeEventFilter>
+#include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QX11Info>
 
 #include <X11/Xlib.h>
@@ -33,6 +36,8 @@
 #   include <X11/extensions/XTest.h>
 #endif
 
+#include <xcb/xcb.h>
+
 #include <unistd.h> // usleep()
 
 namespace {
@@ -40,6 +45,56 @@ namespace {
 const int waitForModsReleaseMs = 25;
 const int maxWaitForModsReleaseMs = 2000;
 
+/// Time without new clipboard requests after which pasting is considered finished.
+const int pasteSettleMs = 20;
+
+/**
+ * Watches for requests for clipboard data from other applications.
+ */
+class SelectionRequestSpy final : public QAbstractNativeEventFilter {
+public:
+    SelectionRequestSpy()
+    {
+        qApp->installNativeEventFilter(this);
+    }
+
+    ~SelectionRequestSpy()
+    {
+        qApp->removeNativeEventFilter(this);
+    }
+
+    /**
+     * Wait until target application receives the clipboard data.
+     *
+     * Returns after the first request for data is followed by a short period
+     * without requests or after @a ms milliseconds if there was no request
+     * (e.g. if clipboard is owned by another process).
+     */
+    void wait(int ms)
+    {
+        SleepTimer t(ms);
+        while ( t.sleep() ) {
+            if ( m_lastRequest.isValid() && m_lastRequest.elapsed() >= pasteSettleMs )
+                return;
+        }
+    }
+
+    bool nativeEventFilter(const QByteArray &eventType, void *message, long *) override
+    {
+        if (eventType != "xcb_generic_event_t")
+            return false;
+
+        const auto event = static_cast<xcb_generic_event_t *>(message);
+        if ( (event->response_type & ~0x80) == XCB_SELECTION_REQUEST )
+            m_lastRequest.start();
+
+        return false;
+    }
+
+private:
+    QElapsedTimer m_lastRequest;
+};
+
 class KeyPressTester {
 public:
     explicit KeyPressTester(Display *display)
@@ -272,13 +327,15 @@ void X11PlatformWindow::raise()
 
 void X11PlatformWindow::pasteClipboard()
 {
+    SelectionRequestSpy spy;
+
     if ( pasteWithCtrlV(*this) )
         sendKeyPress(XK_Control_L, XK_V);
     else
         sendKeyPress(XK_Shift_L, XK_Insert);
 
     // Don't do anything hasty until the content is actually pasted.
-    usleep(150000);
+    spy.wait(150);
 }
 
 void X11PlatformWindow::copy()
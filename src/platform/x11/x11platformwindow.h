@@ -45,6 +45,8 @@ public:
 
     bool isValid() const;
 
+    Window winId() const { return m_window; }
+
 private:
     bool waitForFocus(int ms);
 
@@ -179,6 +179,9 @@ QList<CommandHelp> commandHelp()
                                           "Arguments are accessible using with \"arguments[0..N]\"."))
                .addArg("[" + Scriptable::tr("SCRIPT") + "]")
                .addArg("[" + Scriptable::tr("ARGUMENTS") + "]...")
+            << CommandHelp("evalLines",
+                           Scriptable::tr("\nEvaluate ECMAScript programs read from standard input, one per line.\n"
+                                          "Output of each program is terminated by null character."))
             << CommandHelp("session, -s, --session",
                            Scriptable::tr("\nStarts or connects to application instance with given session name."))
                .addArg(Scriptable::tr("SESSION"))
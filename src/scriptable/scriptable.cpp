@@ -30,6 +30,7 @@
 #include "common/version.h"
 #include "common/textdata.h"
 #include "gui/icons.h"
+#include "item/clipboardmodel.h"
 #include "item/itemfactory.h"
 #include "item/serialize.h"
 #include "platform/platformclipboard.h"
@@ -61,8 +62,11 @@
 #include <QUrl>
 #include <QVector>
 #include <QTextCodec>
+#include <QThread>
 #include <QTimer>
 
+#include <limits>
+
 Q_DECLARE_METATYPE(QByteArray*)
 Q_DECLARE_METATYPE(QFile*)
 
@@ -71,6 +75,11 @@ namespace {
 const char *const programName = "CopyQ Clipboard Manager";
 const char *const mimeIgnore = COPYQ_MIME_PREFIX "ignore";
 
+const int maxCachedPrograms = 100;
+
+// Items are fetched from server in pages to keep messages reasonably small.
+const int itemsPageSize = 100;
+
 QString helpHead()
 {
     return Scriptable::tr("Usage: copyq [%1]").arg(Scriptable::tr("COMMAND")) + "\n\n"
@@ -106,6 +115,49 @@ QFile *getFile(const QScriptValue &value, const Scriptable *scriptable)
     return nullptr;
 }
 
+/**
+ * Returns content of file passed to script as item data.
+ *
+ * The file is memory mapped if possible so the data are copied only once.
+ * Data written by script but still buffered are flushed first.
+ */
+bool readFileContent(QFile *scriptFile, QByteArray *bytes)
+{
+    if ( scriptFile->isOpen() && scriptFile->isWritable() && !scriptFile->flush() )
+        return false;
+
+    QFile file( scriptFile->fileName() );
+    if ( !file.open(QIODevice::ReadOnly) )
+        return false;
+
+    const qint64 size = file.size();
+    if (size == 0) {
+        *bytes = QByteArray("");
+        return true;
+    }
+
+    if ( size < std::numeric_limits<int>::max() ) {
+        const uchar *data = file.map(0, size);
+        if (data) {
+            *bytes = QByteArray(reinterpret_cast<const char*>(data), static_cast<int>(size));
+            file.unmap(const_cast<uchar*>(data));
+            return true;
+        }
+    }
+
+    *bytes = file.readAll();
+    return file.error() == QFile::NoError;
+}
+
+/// Returns error message if item data cannot be created from script value.
+QString itemDataError(const QScriptValue &value, const Scriptable *scriptable)
+{
+    const QFile *file = getFile(value, scriptable);
+    if (file)
+        return QString("Failed to read file \"%1\"").arg(file->fileName());
+    return QString("Invalid item data");
+}
+
 QString toString(const QScriptValue &value, const Scriptable *scriptable)
 {
     QByteArray *bytes = getByteArray(value, scriptable);
@@ -289,6 +341,8 @@ struct ScriptValueFactory<Command> {
         value.setProperty("globalShortcuts", ::toScriptValue(command.globalShortcuts, scriptable));
         value.setProperty("tab", command.tab);
         value.setProperty("outputTab", command.outputTab);
+        value.setProperty("persistent", command.persistent);
+        value.setProperty("parallel", command.parallel);
 
         return value;
     }
@@ -320,6 +374,8 @@ struct ScriptValueFactory<Command> {
         ::fromScriptValueIfValid( value.property("globalShortcuts"), scriptable, &command.globalShortcuts );
         ::fromScriptValueIfValid( value.property("tab"), scriptable, &command.tab );
         ::fromScriptValueIfValid( value.property("outputTab"), scriptable, &command.outputTab );
+        ::fromScriptValueIfValid( value.property("persistent"), scriptable, &command.persistent );
+        ::fromScriptValueIfValid( value.property("parallel"), scriptable, &command.parallel );
 
         return command;
     }
@@ -387,21 +443,95 @@ void addScriptableClass(QScriptValue *rootObject, ScriptableClass *cls)
     rootObject->setProperty( cls->name(), cls->constructor() );
 }
 
-QByteArray readReply(QNetworkReply *reply, const Scriptable &scriptable)
+QByteArray readReply(QNetworkReply *reply, Scriptable *scriptable)
 {
-    QByteArray data;
-    while ( !reply->isFinished() ) {
-        if ( !scriptable.canContinue() )
-            return QByteArray();
-        waitFor(100);
-        if ( reply->waitForReadyRead(100) )
-            data.append(reply->readAll());
+    // Wait for reply to finish without polling (other replies continue in background).
+    if ( !reply->isFinished() && scriptable->canContinue() ) {
+        QEventLoop loop;
+        QObject::connect(reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+        QObject::connect(scriptable, &Scriptable::finished, &loop, &QEventLoop::quit);
+        QObject::connect(scriptable, &Scriptable::stop, &loop, &QEventLoop::quit);
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
     }
-    data.append(reply->readAll());
 
-    return data;
+    if ( !reply->isFinished() )
+        return QByteArray();
+
+    return reply->readAll();
+}
+
+/**
+ * Returns true if automatic command can run in parallel with others.
+ *
+ * Command must be explicitly marked as parallel since whether it changes
+ * data (e.g. by calling copyq) cannot be reliably guessed.
+ */
+bool isIndependentCommand(const Command &command)
+{
+    return command.parallel
+        && !command.remove
+        && !command.transform;
 }
 
+/**
+ * Keeps independent commands running in parallel with others
+ * and waits for them when leaving the scope.
+ */
+class ParallelActions final {
+public:
+    explicit ParallelActions(const Scriptable *scriptable)
+        : m_scriptable(scriptable)
+    {
+    }
+
+    ~ParallelActions()
+    {
+        waitForFinished();
+    }
+
+    ParallelActions(const ParallelActions &) = delete;
+    ParallelActions &operator=(const ParallelActions &) = delete;
+
+    void start(Action *action)
+    {
+        m_actions.append(action);
+        action->setEnvironment( m_scriptable->environment() );
+        action->start();
+    }
+
+    /**
+     * Waits for all started actions to finish and releases them.
+     *
+     * Returns name of first action which failed to start or empty string.
+     */
+    QString waitForFinished()
+    {
+        QString failedToStart;
+        for (auto action : m_actions) {
+            while ( !action->waitForFinished(5000) && m_scriptable->canContinue() ) {}
+
+            if ( action->isRunning() && !action->waitForFinished(5000) )
+                action->terminate();
+
+            if ( action->actionFailed() ) {
+                if ( failedToStart.isEmpty() && action->startLatencyMs() < 0 )
+                    failedToStart = action->name();
+                COPYQ_LOG( QString("Automatic command \"%1\": Failed: %2")
+                           .arg(action->name(), action->errorString()) );
+            }
+        }
+
+        qDeleteAll(m_actions);
+        m_actions.clear();
+
+        return failedToStart;
+    }
+
+private:
+    const Scriptable *m_scriptable;
+    QList<Action*> m_actions;
+};
+
 QByteArray serializeScriptValue(const QScriptValue &value)
 {
     QByteArray data;
@@ -458,13 +588,9 @@ QString parseCommandLineArgument(const QString &arg)
     return result;
 }
 
-bool matchData(const QRegExp &re, const QVariantMap &data, const QString &format)
+bool matchData(const QRegExp &re, const QString &text)
 {
-    if ( re.isEmpty() )
-        return true;
-
-    const QString text = getTextData(data, format);
-    return re.indexIn(text) != -1;
+    return re.isEmpty() || re.indexIn(text) != -1;
 }
 
 bool isInternalDataFormat(const QString &format)
@@ -493,10 +619,9 @@ QVariantMap copyWithoutInternalData(const QVariantMap &data) {
 
 QStringList monitorFormatsToSave(const Commands &&automaticCommands)
 {
-    ItemFactory factory;
-    factory.loadPlugins();
-
     QSettings settings;
+    ItemFactory factory;
+    factory.loadPlugins( ItemFactory::disabledPluginIds(&settings) );
     factory.loadItemFactorySettings(&settings);
 
     QStringList formats = factory.formatsToSave();
@@ -513,13 +638,6 @@ QStringList monitorFormatsToSave(const Commands &&automaticCommands)
     return formats;
 }
 
-QScriptValue checksumForArgument(Scriptable *scriptable, QCryptographicHash::Algorithm method)
-{
-    const auto data = scriptable->makeByteArray(scriptable->argument(0));
-    const QByteArray hash = QCryptographicHash::hash(data, method).toHex();
-    return QString::fromUtf8(hash);
-}
-
 } // namespace
 
 Scriptable::Scriptable(
@@ -536,6 +654,7 @@ Scriptable::Scriptable(
     , m_temporaryFileClass(nullptr)
     , m_inputSeparator("\n")
     , m_input()
+    , m_environment(QProcessEnvironment::systemEnvironment())
 {
     const QScriptEngine::QObjectWrapOptions opts =
               QScriptEngine::ExcludeChildObjects
@@ -642,7 +761,16 @@ QByteArray Scriptable::makeByteArray(const QScriptValue &value) const
 
 bool Scriptable::toItemData(const QScriptValue &value, const QString &mime, QVariantMap *data) const
 {
+    // Pass file content to item directly without creating script value.
+    QFile *file = getFile(value, this);
+    QByteArray fileContent;
+    if ( file && !readFileContent(file, &fileContent) )
+        return false;
+
     if (mime == mimeItems) {
+        if (file)
+            return deserializeData(data, fileContent);
+
         const QByteArray *itemData = getByteArray(value, this);
         if (!itemData)
             return false;
@@ -650,7 +778,9 @@ bool Scriptable::toItemData(const QScriptValue &value, const QString &mime, QVar
         return deserializeData(data, *itemData);
     }
 
-    if (value.isUndefined())
+    if (file)
+        data->insert(mime, fileContent);
+    else if (value.isUndefined())
         data->insert( mime, QVariant() );
     else if (!mime.startsWith("text/") && value.scriptClass() == m_baClass)
         data->insert( mime, *getByteArray(value, this) );
@@ -723,10 +853,9 @@ QScriptValue Scriptable::getPlugins()
 {
     // Load plugins on demand.
     if ( !m_plugins.isValid() ) {
-        ItemFactory factory;
-        factory.loadPlugins();
-
         QSettings settings;
+        ItemFactory factory;
+        factory.loadPlugins( ItemFactory::disabledPluginIds(&settings) );
         factory.loadItemFactorySettings(&settings);
 
         const auto scriptableObjects = factory.scriptableObjects();
@@ -1030,6 +1159,38 @@ QScriptValue Scriptable::tab()
     return QScriptValue();
 }
 
+QScriptValue Scriptable::searchAllTabs()
+{
+    m_skipArguments = 3;
+
+    int offset = 0;
+    int count = -1;
+    if ( argumentCount() < 1
+         || (argumentCount() > 1 && !toInt(argument(1), &offset))
+         || (argumentCount() > 2 && !toInt(argument(2), &count)) )
+    {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    const auto re = fromScriptValue<QRegExp>( argument(0), this );
+    return toScriptValue( m_proxy->searchAllTabs(re, offset, count), this );
+}
+
+QScriptValue Scriptable::findItem()
+{
+    m_skipArguments = 1;
+
+    bool ok;
+    const quint64 hash = arg(0).toULongLong(&ok, 16);
+    if (!ok) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    return toScriptValue( m_proxy->findItem(hash), this );
+}
+
 void Scriptable::removeTab()
 {
     m_skipArguments = 1;
@@ -1065,6 +1226,22 @@ QScriptValue Scriptable::tabIcon()
     return QScriptValue();
 }
 
+QScriptValue Scriptable::tabExpiry()
+{
+    m_skipArguments = 2;
+
+    if (argumentCount() == 1)
+        return m_proxy->tabExpiry(arg(0));
+
+    int days;
+    if ( argumentCount() >= 2 && toInt(argument(1), &days) && days >= 0 )
+        m_proxy->setTabExpiry(arg(0), days);
+    else
+        throwError(argumentError());
+
+    return QScriptValue();
+}
+
 QScriptValue Scriptable::length()
 {
     m_skipArguments = 0;
@@ -1117,6 +1294,34 @@ void Scriptable::remove()
         throwError(error);
 }
 
+void Scriptable::sortItems()
+{
+    m_skipArguments = -1;
+
+    const QString key = arg(0);
+    ItemSortKey sortKey;
+    if (key == "text") {
+        sortKey = ItemSortKey::Text;
+    } else if (key == "length") {
+        sortKey = ItemSortKey::TextLength;
+    } else {
+        throwError( QString("Unknown sort key \"%1\" (expected \"text\" or \"length\")").arg(key) );
+        return;
+    }
+
+    QVector<int> rows;
+    for ( int i = 1; i < argumentCount(); ++i ) {
+        int row;
+        if ( !toInt(argument(i), &row) ) {
+            throwError(argumentError());
+            return;
+        }
+        rows.append(row);
+    }
+
+    m_proxy->browserSortItems(m_tabName, rows, static_cast<int>(sortKey));
+}
+
 void Scriptable::edit()
 {
     m_skipArguments = -1;
@@ -1156,27 +1361,47 @@ QScriptValue Scriptable::read()
 {
     m_skipArguments = -1;
 
-    QByteArray result;
     QString mime(mimeText);
-    QScriptValue value;
+    QVector<int> rows;
+    QStringList mimes;
 
-    bool used = false;
     for ( int i = 0; i < argumentCount(); ++i ) {
-        value = argument(i);
+        const QScriptValue value = argument(i);
         int row;
         if ( toInt(value, &row) ) {
-            if (used)
-                result.append( m_inputSeparator.toUtf8() );
-            used = true;
-            result.append( row >= 0 ? m_proxy->browserItemData(m_tabName, row, mime)
-                                    : m_proxy->getClipboardData(mime) );
+            rows.append(row);
+            mimes.append(mime);
         } else {
             mime = toString(value, this);
         }
     }
 
-    if (!used)
-        result.append( m_proxy->getClipboardData(mime) );
+    if ( rows.isEmpty() )
+        return newByteArray( m_proxy->getClipboardData(mime) );
+
+    // Fetch data of all items at once to avoid calling server for each item.
+    const QByteArray separator = m_inputSeparator.toUtf8();
+    const QVariantList itemsData = m_proxy->browserItemsData(m_tabName, rows, mimes);
+    QByteArray result;
+    for (int i = 0; i < itemsData.size(); ++i) {
+        if (i != 0)
+            result.append(separator);
+
+        const QVariant &itemData = itemsData[i];
+        if ( itemData.userType() == qMetaTypeId<ScriptablePath>() ) {
+            const auto path = itemData.value<ScriptablePath>().path;
+            QFile file(path);
+            if ( file.open(QIODevice::ReadOnly) ) {
+                result.append( file.readAll() );
+            } else {
+                // Blob could have been removed in the meantime.
+                log( QString("Failed to read item data from %1").arg(path), LogWarning );
+                result.append( m_proxy->browserItemData(m_tabName, rows[i]).value(mimes[i]).toByteArray() );
+            }
+        } else {
+            result.append( itemData.toByteArray() );
+        }
+    }
 
     return newByteArray(result);
 }
@@ -1319,23 +1544,27 @@ void Scriptable::importTab()
 
 void Scriptable::importData()
 {
-    m_skipArguments = 1;
+    m_skipArguments = 2;
 
     const auto filePath = arg(0);
-    if ( filePath.isNull() )
+    const auto mode = arg(1);
+    if ( filePath.isNull() || (!mode.isEmpty() && mode != "merge") )
         throwError(argumentError());
-    else if ( !m_proxy->importData(getAbsoluteFilePath(filePath)) )
+    else if ( !m_proxy->importData(getAbsoluteFilePath(filePath), mode == "merge") )
         throwImportError(filePath);
 }
 
 void Scriptable::exportData()
 {
-    m_skipArguments = 1;
+    m_skipArguments = 2;
 
     const auto filePath = arg(0);
+    const auto baseFilePath = arg(1);
     if ( filePath.isNull() )
         throwError(argumentError());
-    else if ( !m_proxy->exportData(getAbsoluteFilePath(filePath)) )
+    else if ( !m_proxy->exportData(
+                  getAbsoluteFilePath(filePath),
+                  baseFilePath.isEmpty() ? QString() : getAbsoluteFilePath(baseFilePath)) )
         throwSaveError(filePath);
 }
 
@@ -1478,6 +1707,25 @@ QScriptValue Scriptable::info()
                 );
 
     const QString name = arg(0);
+
+    // Function call timing and transfer statistics collected by server
+    // (fetched only if requested, each needs a call to server).
+    if (m_proxy) {
+        const auto isRequested = [&name](const QString &key) {
+            return name.isEmpty() || name == key;
+        };
+        if ( isRequested("ipc") )
+            info.insert("ipc", m_proxy->functionCallStatistics());
+        if ( isRequested("commands") )
+            info.insert("commands", m_proxy->commandStatistics());
+        if ( isRequested("startup") )
+            info.insert("startup", m_proxy->startupPhases());
+        if ( isRequested("memory") )
+            info.insert("memory", m_proxy->memoryUsage());
+        if ( isRequested("metrics") )
+            info.insert("metrics", m_proxy->metrics());
+    }
+
     if (!name.isEmpty())
         return info.value(name);
 
@@ -1497,6 +1745,42 @@ QScriptValue Scriptable::eval()
     return result;
 }
 
+void Scriptable::evalLines()
+{
+    // Reuse the connection and script engine, with already sourced script
+    // commands, for many commands instead of starting new client process for each.
+    QFile in;
+    in.open(stdin, QIODevice::ReadOnly);
+
+    while ( canContinue() ) {
+        const QByteArray line = in.readLine();
+        if ( line.isEmpty() )
+            break;
+
+        const QString script = getTextData(line).trimmed();
+        QByteArray output;
+        if ( !script.isEmpty() ) {
+            // Evaluate each script in new context so variables declared in
+            // it are dropped afterwards and engine can be reused warm.
+            engine()->pushContext();
+            const auto result = eval(script);
+            engine()->popContext();
+            if ( m_engine->hasUncaughtException() ) {
+                const auto exceptionText = processUncaughtException(QString());
+                printError( createScriptErrorMessage(exceptionText).toUtf8() );
+                m_engine->clearExceptions();
+            } else {
+                output = serializeScriptValue(result);
+            }
+        }
+
+        output.append('\0');
+        print(output);
+    }
+
+    m_skipArguments = -1;
+}
+
 QScriptValue Scriptable::source()
 {
     const auto scriptFilePath = arg(0);
@@ -1613,8 +1897,10 @@ QScriptValue Scriptable::setData()
     m_skipArguments = 2;
 
     const QString mime = arg(0);
-    if ( !toItemData(argument(1), mime, &m_data) )
+    if ( !toItemData(argument(1), mime, &m_data) ) {
+        throwError( itemDataError(argument(1), this) );
         return false;
+    }
 
     m_proxy->setSelectedItemsData(mime, m_data.value(mime));
     return true;
@@ -1832,6 +2118,76 @@ QScriptValue Scriptable::getItem()
     return toScriptValue( m_proxy->browserItemData(m_tabName, row), this );
 }
 
+QScriptValue Scriptable::getItems()
+{
+    m_skipArguments = -1;
+
+    int row = 0;
+    int count = -1;
+    QStringList mimes;
+
+    int i = 0;
+    if ( i < argumentCount() && toInt(argument(i), &row) ) {
+        ++i;
+        if ( i < argumentCount() && toInt(argument(i), &count) )
+            ++i;
+    }
+
+    for ( ; i < argumentCount(); ++i )
+        mimes.append( toString(argument(i), this) );
+
+    QScriptValue result = engine()->newArray();
+    quint32 resultLength = 0;
+    while ( count != 0 && canContinue() ) {
+        const int pageCount = count < 0 ? itemsPageSize : qMin(count, itemsPageSize);
+        const auto items = m_proxy->browserItemsDataRange(m_tabName, row, pageCount, mimes);
+        for (const auto &item : items)
+            result.setProperty( resultLength++, toScriptValue(item, this) );
+
+        if (items.size() < pageCount)
+            break;
+
+        row += pageCount;
+        if (count > 0)
+            count -= pageCount;
+    }
+
+    return result;
+}
+
+QScriptValue Scriptable::snapshot()
+{
+    m_skipArguments = -1;
+
+    QStringList tabNames;
+    for ( int i = 0; i < argumentCount(); ++i )
+        tabNames.append( toString(argument(i), this) );
+    if ( tabNames.isEmpty() )
+        tabNames.append(m_tabName);
+
+    // Server copies all items at once; pages are then read from the copy.
+    const QStringList snapshotTabNames = m_proxy->createTabSnapshot(tabNames);
+
+    QScriptValue result = engine()->newObject();
+    for (const auto &tabName : snapshotTabNames) {
+        QScriptValue items = engine()->newArray();
+        quint32 length = 0;
+        for ( int row = 0; canContinue(); row += itemsPageSize ) {
+            const auto page = m_proxy->tabSnapshotItems(tabName, row, itemsPageSize);
+            for (const auto &item : page)
+                items.setProperty( length++, toScriptValue(item, this) );
+
+            if (page.size() < itemsPageSize)
+                break;
+        }
+        result.setProperty(tabName, items);
+    }
+
+    m_proxy->releaseTabSnapshot();
+
+    return result;
+}
+
 void Scriptable::setItem()
 {
     insert(2);
@@ -1851,22 +2207,35 @@ QScriptValue Scriptable::fromBase64()
 
 QScriptValue Scriptable::md5sum()
 {
-    return checksumForArgument(this, QCryptographicHash::Md5);
+    return checksumForArgument(QCryptographicHash::Md5);
 }
 
 QScriptValue Scriptable::sha1sum()
 {
-    return checksumForArgument(this, QCryptographicHash::Sha1);
+    return checksumForArgument(QCryptographicHash::Sha1);
 }
 
 QScriptValue Scriptable::sha256sum()
 {
-    return checksumForArgument(this, QCryptographicHash::Sha256);
+    return checksumForArgument(QCryptographicHash::Sha256);
 }
 
 QScriptValue Scriptable::sha512sum()
 {
-    return checksumForArgument(this, QCryptographicHash::Sha512);
+    return checksumForArgument(QCryptographicHash::Sha512);
+}
+
+QScriptValue Scriptable::itemHash()
+{
+    m_skipArguments = 1;
+
+    int row;
+    if ( !toInt(argument(0), &row) ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    return QString::number( m_proxy->browserItemHash(m_tabName, row), 16 );
 }
 
 QScriptValue Scriptable::open()
@@ -1908,6 +2277,7 @@ QScriptValue Scriptable::execute()
 
     action.setCommand(args);
     action.setReadOutput(true);
+    action.setEnvironment(m_environment);
 
     connect( &action, &Action::actionOutput,
              this, &Scriptable::onExecuteOutput );
@@ -2069,7 +2439,7 @@ QScriptValue Scriptable::env()
 {
     m_skipArguments = 1;
     const QString name = arg(0);
-    const QByteArray value = qgetenv(name.toUtf8().constData());
+    const QByteArray value = m_environment.value(name).toLocal8Bit();
     return newByteArray(value);
 }
 
@@ -2078,7 +2448,11 @@ QScriptValue Scriptable::setEnv()
     m_skipArguments = 2;
     const QString name = arg(0);
     const QByteArray value = makeByteArray(argument(1));
-    return qputenv(name.toUtf8().constData(), value);
+    if ( name.isEmpty() || name.contains('=') )
+        return false;
+
+    m_environment.insert( name, QString::fromLocal8Bit(value) );
+    return true;
 }
 
 void Scriptable::sleep()
@@ -2153,6 +2527,24 @@ void Scriptable::afterMilliseconds()
     new TimedFunctionCall(msec, fn, this);
 }
 
+QScriptValue Scriptable::transaction()
+{
+    m_skipArguments = 1;
+
+    const auto fn = argument(0);
+    if ( !fn.isFunction() ) {
+        throwError(argumentError());
+        return QScriptValue();
+    }
+
+    // Commit even if the function throws, the exception is kept.
+    m_proxy->beginTransaction();
+    const auto result = fn.call();
+    m_proxy->commitTransaction();
+
+    return result;
+}
+
 QVariant Scriptable::call(const QString &method, const QVariantList &arguments)
 {
     if ( m_engine->hasUncaughtException() )
@@ -2667,7 +3059,11 @@ QScriptValue Scriptable::copy(ClipboardMode mode)
             QString mime = toString(argument(i), this);
 
             // DATA
-            toItemData(argument(++i), mime, &data);
+            const QScriptValue value = argument(++i);
+            if ( !toItemData(value, mime, &data) ) {
+                throwError( itemDataError(value, this) );
+                return false;
+            }
         }
 
         m_proxy->setClipboard(data, mode);
@@ -2683,6 +3079,15 @@ void Scriptable::stopEventLoops()
     emit stop();
 }
 
+void Scriptable::requestAbort()
+{
+    m_abortRequested.store(1);
+    m_engine->abortEvaluation();
+
+    // Signal is queued to event loops in script thread.
+    emit stop();
+}
+
 void Scriptable::abortEvaluation(Abort abort)
 {
     m_abort = abort;
@@ -2718,7 +3123,11 @@ void Scriptable::changeItem(bool create)
         // MIME
         const QString mime = toString(argument(i), this);
         // DATA
-        toItemData( argument(i + 1), mime, &data );
+        const QScriptValue value = argument(i + 1);
+        if ( !toItemData(value, mime, &data) ) {
+            throwError( itemDataError(value, this) );
+            return;
+        }
     }
 
     if (create) {
@@ -2766,17 +3175,31 @@ QScriptValue Scriptable::screenshot(bool select)
 
 QScriptValue Scriptable::eval(const QString &script, const QString &fileName)
 {
-    const auto syntaxResult = QScriptEngine::checkSyntax(script);
-    if (syntaxResult.state() != QScriptSyntaxCheckResult::Valid) {
-        throwError( QString("%1:%2:%3: syntax error: %4")
-                    .arg(fileName)
-                    .arg(syntaxResult.errorLineNumber())
-                    .arg(syntaxResult.errorColumnNumber())
-                    .arg(syntaxResult.errorMessage()) );
-        return QScriptValue();
+    // Avoid parsing same scripts again, program text is the key
+    // so modified commands are compiled again.
+    QScriptProgram program = m_programs.value(script);
+    if ( program.isNull() || program.fileName() != fileName ) {
+        const auto syntaxResult = QScriptEngine::checkSyntax(script);
+        if (syntaxResult.state() != QScriptSyntaxCheckResult::Valid) {
+            throwError( QString("%1:%2:%3: syntax error: %4")
+                        .arg(fileName)
+                        .arg(syntaxResult.errorLineNumber())
+                        .arg(syntaxResult.errorColumnNumber())
+                        .arg(syntaxResult.errorMessage()) );
+            return QScriptValue();
+        }
+
+        if ( m_programs.size() >= maxCachedPrograms )
+            m_programs.clear();
+
+        program = QScriptProgram(script, fileName);
+        m_programs.insert(script, program);
     }
 
-    const auto result = engine()->evaluate(script, fileName);
+    const auto result = engine()->evaluate(program);
+
+    if ( m_abortRequested.load() != 0 )
+        m_abort = Abort::AllEvaluations;
 
     if (m_abort != Abort::None) {
         engine()->clearExceptions();
@@ -2858,6 +3281,7 @@ bool Scriptable::runAction(Action *action)
     setActionData();
 
     action->setWorkingDirectory( m_dirClass->getCurrentPath() );
+    action->setEnvironment(m_environment);
     action->start();
 
     if ( !action->waitForStarted(5000) ) {
@@ -2891,14 +3315,76 @@ bool Scriptable::runCommands(CommandType::CommandType type)
             : m_proxy->displayCommands();
     const QString tabName = getTextData(m_data, mimeCurrentTab);
 
+    // Decode text and window title for matching all commands only once.
+    // Data needs to be decoded again only after a command runs and possibly changes them.
+    QString text;
+    QString windowTitle;
+    bool needsDecodeData = true;
+
+    // Independent automatic commands don't need to wait for each other,
+    // so the processing takes as long as the slowest one instead of all of them.
+    ParallelActions parallelActions(this);
+
     for (auto &command : commands) {
         if ( command.outputTab.isEmpty() )
             command.outputTab = tabName;
 
-        if ( !canExecuteCommand(command) )
+        if (needsDecodeData) {
+            text = getTextData(m_data, mimeText);
+            windowTitle = getTextData(m_data, mimeWindowTitle);
+            needsDecodeData = false;
+        }
+
+        const bool canExecute = canExecuteCommand(command, text, windowTitle);
+
+        // Filter command could have changed data.
+        needsDecodeData = !command.matchCmd.isEmpty();
+
+        if (!canExecute)
             continue;
 
-        if ( canContinue() && !command.cmd.isEmpty() ) {
+        if ( canContinue() && !command.cmd.isEmpty() && command.persistent ) {
+            // Program kept running by server gets the item without starting a new process.
+            const QString inputFormat = command.input.isEmpty() ? QString(mimeText) : command.input;
+            const QByteArray input = inputFormat == mimeItems
+                    ? serializeData(m_data)
+                    : m_data.value(inputFormat).toByteArray();
+            const QVariantMap result = processWithPersistentCommand(command.cmd, input);
+            if ( result.contains("error") ) {
+                throwError( QString(label).arg(command.name, result.value("error").toString()) );
+                return false;
+            }
+
+            // Non-empty reply replaces the input data.
+            const QByteArray output = result.value("output").toByteArray();
+            if ( !output.isEmpty() ) {
+                needsDecodeData = true;
+                if (inputFormat == mimeItems) {
+                    QVariantMap data;
+                    if ( !deserializeData(&data, output) ) {
+                        throwError( QString(label).arg(command.name, "Invalid item data in reply") );
+                        return false;
+                    }
+                    m_data = data;
+                } else {
+                    m_data.insert(inputFormat, output);
+                }
+            }
+
+            COPYQ_LOG_VERBOSE( QString(label).arg(command.name, "Processed by running program") );
+        } else if ( canContinue() && !command.cmd.isEmpty()
+                    && type == CommandType::Automatic && isIndependentCommand(command) )
+        {
+            auto action = new Action();
+            action->setCommand( command.cmd, QStringList(getTextData(m_data)) );
+            action->setInputWithFormat(m_data, command.input);
+            action->setName(command.name);
+            action->setData(m_data);
+            action->setWorkingDirectory( m_dirClass->getCurrentPath() );
+            COPYQ_LOG_VERBOSE( QString(label).arg(command.name, "Started in parallel") );
+            parallelActions.start(action);
+        } else if ( canContinue() && !command.cmd.isEmpty() ) {
+            needsDecodeData = true;
             Action action;
             action.setCommand( command.cmd, QStringList(getTextData(m_data)) );
             action.setInputWithFormat(m_data, command.input);
@@ -2936,10 +3422,16 @@ bool Scriptable::runCommands(CommandType::CommandType type)
         COPYQ_LOG_VERBOSE( QString(label).arg(command.name, "Finished") );
     }
 
+    const QString failedCommandName = parallelActions.waitForFinished();
+    if ( !failedCommandName.isEmpty() && canContinue() ) {
+        throwError( QString(label).arg(failedCommandName, "Failed to start") );
+        return false;
+    }
+
     return true;
 }
 
-bool Scriptable::canExecuteCommand(const Command &command)
+bool Scriptable::canExecuteCommand(const Command &command, const QString &text, const QString &windowTitle)
 {
     // Verify that data for given MIME is available.
     if ( !command.input.isEmpty() ) {
@@ -2953,16 +3445,39 @@ bool Scriptable::canExecuteCommand(const Command &command)
     }
 
     // Verify that and text matches given regexp.
-    if ( !matchData(command.re, m_data, mimeText) )
+    if ( !matchData(command.re, text) )
         return false;
 
     // Verify that window title matches given regexp.
-    if ( !matchData(command.wndre, m_data, mimeWindowTitle) )
+    if ( !matchData(command.wndre, windowTitle) )
         return false;
 
     return canExecuteCommandFilter(command.matchCmd);
 }
 
+QVariantMap Scriptable::processWithPersistentCommand(const QString &commandLine, const QByteArray &input)
+{
+    const int requestId = m_proxy->startPersistentCommand(commandLine, input);
+
+    QVariantMap result;
+    if ( m_proxy->takePersistentCommandResult(requestId, &result) )
+        return result;
+
+    QEventLoop loop;
+    connect(this, &Scriptable::finished, &loop, &QEventLoop::quit);
+    connect(this, &Scriptable::stop, &loop, &QEventLoop::quit);
+    connect( m_proxy, &ScriptableProxy::persistentCommandFinished,
+             &loop, [&](int finishedRequestId) {
+                 if (finishedRequestId == requestId)
+                     loop.quit();
+             });
+    loop.exec();
+
+    // Result is empty if interrupted.
+    m_proxy->takePersistentCommandResult(requestId, &result);
+    return result;
+}
+
 bool Scriptable::canExecuteCommandFilter(const QString &matchCommand)
 {
     if ( matchCommand.isEmpty() )
@@ -2982,11 +3497,17 @@ bool Scriptable::canExecuteCommandFilter(const QString &matchCommand)
 
 bool Scriptable::verifyClipboardAccess()
 {
-    if ( qobject_cast<QGuiApplication*>(qApp) != nullptr )
-        return true;
+    if ( qobject_cast<QGuiApplication*>(qApp) == nullptr ) {
+        throwError("Cannot access system clipboard with QCoreApplication");
+        return false;
+    }
 
-    throwError("Cannot access system clipboard with QCoreApplication");
-    return false;
+    if ( QThread::currentThread() != qApp->thread() ) {
+        throwError("Cannot access system clipboard outside main thread");
+        return false;
+    }
+
+    return true;
 }
 
 void Scriptable::provideClipboard(ClipboardMode mode)
@@ -3025,6 +3546,38 @@ void Scriptable::provideClipboard(ClipboardMode mode)
                .arg(mode == ClipboardMode::Clipboard ? "clipboard" : "selection") );
 }
 
+QScriptValue Scriptable::checksumForArgument(QCryptographicHash::Algorithm method)
+{
+    QCryptographicHash hash(method);
+
+    // Hash item data without passing these through script engine (possibly
+    // reading large data directly from blob file).
+    int row;
+    if ( argumentCount() == 2 && toInt(argument(0), &row) ) {
+        m_skipArguments = 2;
+        const QString mime = toString(argument(1), this);
+        const QVariant itemData =
+                m_proxy->browserItemsData(m_tabName, QVector<int>() << row, QStringList() << mime).value(0);
+        if ( itemData.userType() == qMetaTypeId<ScriptablePath>() ) {
+            const auto path = itemData.value<ScriptablePath>().path;
+            QFile file(path);
+            if ( !file.open(QIODevice::ReadOnly) || !hash.addData(&file) ) {
+                // Blob could have been removed in the meantime.
+                log( QString("Failed to read item data from %1").arg(path), LogWarning );
+                hash.reset();
+                hash.addData( m_proxy->browserItemData(m_tabName, row).value(mime).toByteArray() );
+            }
+        } else {
+            hash.addData( itemData.toByteArray() );
+        }
+    } else {
+        m_skipArguments = 1;
+        hash.addData( makeByteArray(argument(0)) );
+    }
+
+    return QString::fromUtf8( hash.result().toHex() );
+}
+
 void Scriptable::insert(int argumentsEnd)
 {
     int row;
@@ -3174,7 +3727,8 @@ void Scriptable::saveData(const QString &tab)
     const auto clipboardMode = isClipboardData(m_data)
             ? ClipboardMode::Clipboard
             : ClipboardMode::Selection;
-    m_proxy->saveData(tab, data, clipboardMode);
+    // Hash data in client so the server can find duplicate item quickly.
+    m_proxy->saveData( tab, data, clipboardMode, hash(data) );
 }
 
 QScriptValue NetworkReply::get(const QString &url, Scriptable *scriptable)
@@ -3202,7 +3756,7 @@ QScriptValue NetworkReply::data()
     if (m_data.isValid())
         return m_data;
 
-    const QByteArray data = readReply(m_reply, *m_scriptable);
+    const QByteArray data = readReply(m_reply, m_scriptable);
     m_data = m_scriptable->newByteArray(data);
 
     return m_data;
@@ -3280,6 +3834,6 @@ void NetworkReply::fetchHeaders()
         m_replyHead = m_reply;
     } else {
         m_replyHead = m_manager->head(m_reply->request());
-        readReply(m_replyHead, *m_scriptable);
+        readReply(m_replyHead, m_scriptable);
     }
 }
@@ -24,9 +24,14 @@
 #include "common/command.h"
 #include "common/mimetypes.h"
 
+#include <QAtomicInt>
+#include <QCryptographicHash>
+#include <QHash>
 #include <QObject>
+#include <QProcessEnvironment>
 #include <QString>
 #include <QScriptable>
+#include <QScriptProgram>
 #include <QScriptValue>
 #include <QVariantMap>
 #include <QVector>
@@ -124,7 +129,10 @@ public:
 
     QScriptEngine *engine() const { return m_engine; }
 
-    bool canContinue() const { return m_abort == Abort::None && !m_failed; }
+    bool canContinue() const
+    {
+        return m_abort == Abort::None && !m_failed && m_abortRequested.load() == 0;
+    }
 
     QScriptValue getMimeText() const { return mimeText; }
     QScriptValue getMimeHtml() const { return mimeHtml; }
@@ -157,10 +165,33 @@ public:
     void setActionName(const QString &actionName);
     int executeArguments(const QStringList &args);
 
+    /**
+     * Run action and wait for it to finish.
+     *
+     * Single CopyQ command (e.g. "copyq eval -- SCRIPT") is executed
+     * in current engine instead of in new process.
+     */
+    bool runAction(Action *action);
+
     void stopEventLoops();
 
     void abortEvaluation(Abort abort = Abort::AllEvaluations);
 
+    /**
+     * Abort all evaluations and stop event loops.
+     *
+     * Unlike other functions, this can be called from any thread.
+     */
+    void requestAbort();
+
+    /**
+     * Environment used by env(), setEnv() and processes started by script.
+     *
+     * Default is system environment.
+     */
+    void setEnvironment(const QProcessEnvironment &environment) { m_environment = environment; }
+    const QProcessEnvironment &environment() const { return m_environment; }
+
 public slots:
     void setInput(const QByteArray &input);
 
@@ -193,6 +224,11 @@ public slots:
     void paste();
 
     QScriptValue tab();
+    QScriptValue searchAllTabs();
+    QScriptValue searchalltabs() { return searchAllTabs(); }
+
+    QScriptValue findItem();
+    QScriptValue finditem() { return findItem(); }
     void removeTab();
     void removetab() { removeTab(); }
     void renameTab();
@@ -200,6 +236,9 @@ public slots:
     QScriptValue tabIcon();
     QScriptValue tabicon() { return tabIcon(); }
 
+    QScriptValue tabExpiry();
+    QScriptValue tabexpiry() { return tabExpiry(); }
+
     QScriptValue length();
     QScriptValue size() { return length(); }
     QScriptValue count() { return length(); }
@@ -211,6 +250,8 @@ public slots:
     void insert();
     void remove();
     void edit();
+    void sortItems();
+    void sortitems() { sortItems(); }
 
     QScriptValue read();
     void write();
@@ -235,6 +276,7 @@ public slots:
     QScriptValue info();
 
     QScriptValue eval();
+    void evalLines();
 
     QScriptValue source();
 
@@ -284,6 +326,8 @@ public slots:
 
     QScriptValue getItem();
     QScriptValue getitem() { return getItem(); }
+    QScriptValue getItems();
+    QScriptValue snapshot();
     void setItem();
     void setitem() { setItem(); }
 
@@ -297,6 +341,9 @@ public slots:
     QScriptValue sha256sum();
     QScriptValue sha512sum();
 
+    QScriptValue itemHash();
+    QScriptValue itemhash() { return itemHash(); }
+
     QScriptValue open();
     QScriptValue execute();
 
@@ -323,6 +370,8 @@ public slots:
     void sleep();
     void afterMilliseconds();
 
+    QScriptValue transaction();
+
     // Call scriptable method.
     QVariant call(const QString &method, const QVariantList &arguments);
 
@@ -389,11 +438,12 @@ private:
     QByteArray serialize(const QScriptValue &value);
     QScriptValue eval(const QString &script);
     QTextCodec *codecFromNameOrThrow(const QScriptValue &codecName);
-    bool runAction(Action *action);
     bool runCommands(CommandType::CommandType type);
-    bool canExecuteCommand(const Command &command);
+    bool canExecuteCommand(const Command &command, const QString &text, const QString &windowTitle);
     bool canExecuteCommandFilter(const QString &matchCommand);
+    QVariantMap processWithPersistentCommand(const QString &commandLine, const QByteArray &input);
     bool verifyClipboardAccess();
+    QScriptValue checksumForArgument(QCryptographicHash::Algorithm method);
     void provideClipboard(ClipboardMode mode);
 
     void insert(int argumentsEnd);
@@ -424,8 +474,11 @@ private:
     int m_actionId = -1;
     QString m_actionName;
     Abort m_abort = Abort::None;
+    QAtomicInt m_abortRequested;
     int m_skipArguments = 0;
 
+    QProcessEnvironment m_environment;
+
     // FIXME: Parameters for execute() shouldn't be global.
     QByteArray m_executeStdoutData;
     QString m_executeStdoutLastLine;
@@ -435,6 +488,9 @@ private:
 
     QScriptValue m_plugins;
 
+    // Compiled scripts (e.g. script commands sourced for each nested command).
+    QHash<QString, QScriptProgram> m_programs;
+
     Action *m_action = nullptr;
     bool m_failed = false;
 
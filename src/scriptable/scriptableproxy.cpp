@@ -29,9 +29,13 @@
 #include "common/contenttype.h"
 #include "common/display.h"
 #include "common/log.h"
+#include "common/metrics.h"
 #include "common/mimetypes.h"
+#include "common/persistentprocess.h"
 #include "common/settings.h"
+#include "common/startupphases.h"
 #include "common/textdata.h"
+#include "common/timer.h"
 #include "gui/clipboardbrowser.h"
 #include "gui/filedialog.h"
 #include "gui/iconfactory.h"
@@ -40,6 +44,7 @@
 #include "gui/notification.h"
 #include "gui/tabicons.h"
 #include "gui/windowgeometryguard.h"
+#include "item/itemsearch.h"
 #include "item/serialize.h"
 #include "platform/platformnativeinterface.h"
 #include "platform/platformwindow.h"
@@ -58,8 +63,12 @@
 #include <QDesktopServices>
 #include <QDesktopWidget>
 #include <QDialogButtonBox>
+#include <QElapsedTimer>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
+#include <QFont>
+#include <QImageWriter>
 #include <QWidget>
 #include <QLabel>
 #include <QLineEdit>
@@ -72,16 +81,22 @@
 #include <QPen>
 #include <QPixmap>
 #include <QPushButton>
+#include <QRunnable>
 #include <QScreen>
+#include <QSemaphore>
 #include <QShortcut>
 #include <QSpinBox>
 #include <QTextEdit>
+#include <QThreadPool>
 #include <QUrl>
 
 #ifdef HAS_TESTS
 #   include <QTest>
 #endif
 
+#include <algorithm>
+#include <iterator>
+#include <memory>
 #include <type_traits>
 
 const quint32 serializedFunctionCallMagicNumber = 0x58746908;
@@ -192,7 +207,9 @@ QDataStream &operator<<(QDataStream &out, const Command &command)
         << command.shortcuts
         << command.globalShortcuts
         << command.tab
-        << command.outputTab;
+        << command.outputTab
+        << command.persistent
+        << command.parallel;
     Q_ASSERT(out.status() == QDataStream::Ok);
     return out;
 }
@@ -221,7 +238,9 @@ QDataStream &operator>>(QDataStream &in, Command &command)
        >> command.shortcuts
        >> command.globalShortcuts
        >> command.tab
-       >> command.outputTab;
+       >> command.outputTab
+       >> command.persistent
+       >> command.parallel;
     Q_ASSERT(in.status() == QDataStream::Ok);
     return in;
 }
@@ -277,6 +296,39 @@ struct InputDialog {
     QString defaultChoice; /// Default text for list widgets.
 };
 
+/**
+ * Returns approximate size of serialized value.
+ *
+ * Used to reserve message size so that big item data are copied to message
+ * only once instead of on each reallocation while serializing.
+ */
+int serializedSizeHint(const QVariant &value)
+{
+    // Space for type and size of each value.
+    int size = 16;
+
+    const int type = value.userType();
+    if (type == QMetaType::QByteArray) {
+        size += value.toByteArray().size();
+    } else if (type == QMetaType::QString) {
+        size += 2 * value.toString().size();
+    } else if (type == QMetaType::QVariantMap) {
+        const auto map = value.toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+            size += 2 * it.key().size() + serializedSizeHint(it.value());
+    } else if (type == QMetaType::QVariantList) {
+        const auto list = value.toList();
+        for (const auto &item : list)
+            size += serializedSizeHint(item);
+    } else if ( type == qMetaTypeId<QVector<QVariantMap>>() ) {
+        const auto list = value.value<QVector<QVariantMap>>();
+        for (const auto &item : list)
+            size += serializedSizeHint(item);
+    }
+
+    return size;
+}
+
 template<typename ...Ts>
 class SlotArguments;
 
@@ -312,12 +364,18 @@ public:
         QByteArray args = SlotArguments<Ts...>::arguments();
         args.chop(1);
         setSlotArgumentTypes(args);
+        m_args.reserve( static_cast<int>(sizeof...(Ts)) );
         return *this;
     }
 
     QByteArray serializeAndClear(int functionCallId)
     {
+        int sizeHint = m_slotName.size();
+        for (const auto &arg : m_args)
+            sizeHint += serializedSizeHint(arg);
+
         QByteArray bytes;
+        bytes.reserve(sizeHint);
         QDataStream stream(&bytes, QIODevice::WriteOnly);
         stream.setVersion(QDataStream::Qt_5_0);
         stream << serializedFunctionCallMagicNumber << serializedFunctionCallVersion
@@ -350,6 +408,80 @@ private:
     QByteArray m_slotName;
 };
 
+/// Result of ImageEncoderTask, shared with the task since it can outlive the caller's event loop.
+struct EncodedImage {
+    QByteArray bytes;
+    QSemaphore finished;
+};
+
+/// Encodes image in background so big screenshots don't block the GUI thread.
+class ImageEncoderTask final : public QRunnable
+{
+public:
+    ImageEncoderTask(
+            const QImage &image, const QByteArray &format, int quality,
+            const std::shared_ptr<EncodedImage> &result, QEventLoop *loop)
+        : m_image(image)
+        , m_format(format)
+        , m_quality(quality)
+        , m_result(result)
+        , m_loop(loop)
+    {
+    }
+
+    void run() override
+    {
+        {
+            QBuffer buffer(&m_result->bytes);
+            buffer.open(QIODevice::WriteOnly);
+            QImageWriter writer(&buffer, m_format);
+            writer.setQuality(m_quality);
+            if ( !writer.write(m_image) )
+                m_result->bytes.clear();
+        }
+
+        QMetaObject::invokeMethod(m_loop, "quit", Qt::QueuedConnection);
+        m_result->finished.release();
+    }
+
+private:
+    QImage m_image;
+    QByteArray m_format;
+    int m_quality;
+    std::shared_ptr<EncodedImage> m_result;
+    QEventLoop *m_loop;
+};
+
+/**
+ * Encodes image with given format ("FORMAT" or "FORMAT:QUALITY").
+ *
+ * Events are processed while waiting for the image to be encoded.
+ */
+QByteArray encodeImage(const QImage &image, const QString &format)
+{
+    const int separatorIndex = format.indexOf(':');
+    const QByteArray formatName = format.left(separatorIndex).toUtf8();
+
+    int quality = -1;
+    if (separatorIndex != -1) {
+        bool ok;
+        quality = format.mid(separatorIndex + 1).toInt(&ok);
+        if (!ok || quality < 0 || quality > 100)
+            return QByteArray();
+    }
+
+    const auto result = std::make_shared<EncodedImage>();
+    QEventLoop loop;
+    QThreadPool::globalInstance()->start(
+        new ImageEncoderTask(image, formatName, quality, result, &loop) );
+    loop.exec();
+
+    // Event loop can exit early (e.g. on application exit); wait for the task to finish.
+    result->finished.acquire();
+
+    return result->bytes;
+}
+
 class ScreenshotRectWidget : public QLabel {
 public:
     explicit ScreenshotRectWidget(const QPixmap &pixmap)
@@ -634,6 +766,174 @@ void raiseWindow(QPointer<QWidget> window)
         platformWindow->raise();
 }
 
+struct FunctionCallStatistics {
+    int calls = 0;
+    qint64 totalWaitUs = 0;
+    qint64 maxWaitUs = 0;
+    qint64 totalExecUs = 0;
+    qint64 maxExecUs = 0;
+    qint64 bytesReceived = 0;
+    qint64 bytesSent = 0;
+};
+
+// Upper bounds (in milliseconds) for latency histogram buckets.
+const int latencyHistogramBoundsMs[] = {1, 10, 100, 1000};
+const int latencyHistogramSize = sizeof(latencyHistogramBoundsMs) / sizeof(int) + 1;
+
+// Statistics are collected for all clients in server process.
+QHash<QByteArray, FunctionCallStatistics> &functionCallStatistics()
+{
+    static QHash<QByteArray, FunctionCallStatistics> statistics;
+    return statistics;
+}
+
+int *latencyHistogram()
+{
+    static int histogram[latencyHistogramSize] = {};
+    return histogram;
+}
+
+qint64 elapsedUs()
+{
+    static QElapsedTimer timer;
+    if ( !timer.isValid() )
+        timer.start();
+    return timer.nsecsElapsed() / 1000;
+}
+
+void addFunctionCallStatistics(
+        const QByteArray &slotName, qint64 waitUs, qint64 execUs, int bytesReceived, int bytesSent)
+{
+    auto &stats = functionCallStatistics()[slotName];
+    ++stats.calls;
+    stats.totalWaitUs += waitUs;
+    stats.maxWaitUs = qMax(stats.maxWaitUs, waitUs);
+    stats.totalExecUs += execUs;
+    stats.maxExecUs = qMax(stats.maxExecUs, execUs);
+    stats.bytesReceived += bytesReceived;
+    stats.bytesSent += bytesSent;
+
+    const auto latencyMs = (waitUs + execUs) / 1000;
+    int bucket = 0;
+    while ( bucket < latencyHistogramSize - 1 && latencyMs >= latencyHistogramBoundsMs[bucket] )
+        ++bucket;
+    ++latencyHistogram()[bucket];
+
+    COPYQ_LOG_VERBOSE(
+        QString("Function call \"%1\": wait %2 us, exec %3 us, received %4 B, sent %5 B")
+        .arg(QString::fromLatin1(slotName))
+        .arg(waitUs)
+        .arg(execUs)
+        .arg(bytesReceived)
+        .arg(bytesSent) );
+}
+
+/// Time spent by clients run by a command.
+struct CommandStatistics {
+    int runs = 0;
+    qint64 totalUs = 0;
+    qint64 maxUs = 0;
+    qint64 totalWaitUs = 0;
+    qint64 totalExecUs = 0;
+};
+
+QHash<QString, CommandStatistics> &commandStatistics()
+{
+    static QHash<QString, CommandStatistics> statistics;
+    return statistics;
+}
+
+void addCommandStatistics(const QString &commandName, qint64 us, qint64 waitUs, qint64 execUs)
+{
+    auto &stats = commandStatistics()[commandName];
+    ++stats.runs;
+    stats.totalUs += us;
+    stats.maxUs = qMax(stats.maxUs, us);
+    stats.totalWaitUs += waitUs;
+    stats.totalExecUs += execUs;
+}
+
+QString msText(qint64 us)
+{
+    return QString::number(us / 1000.0, 'f', 2) + "ms";
+}
+
+QString functionCallStatisticsText(const FunctionCallStatistics &stats)
+{
+    return QString("calls=%1 wait=%2/%3 exec=%4/%5 received=%6B sent=%7B")
+            .arg(stats.calls)
+            .arg( msText(stats.totalWaitUs / qMax(1, stats.calls)), msText(stats.maxWaitUs) )
+            .arg( msText(stats.totalExecUs / qMax(1, stats.calls)), msText(stats.maxExecUs) )
+            .arg(stats.bytesReceived)
+            .arg(stats.bytesSent);
+}
+
+QString commandStatisticsText(const CommandStatistics &stats)
+{
+    const qint64 callsUs = stats.totalWaitUs + stats.totalExecUs;
+    return QString("runs=%1 time=%2/%3 script=%4 wait=%5 exec=%6")
+            .arg(stats.runs)
+            .arg( msText(stats.totalUs / qMax(1, stats.runs)), msText(stats.maxUs) )
+            .arg( msText(qMax(0LL, stats.totalUs - callsUs) / qMax(1, stats.runs)) )
+            .arg( msText(stats.totalWaitUs / qMax(1, stats.runs)) )
+            .arg( msText(stats.totalExecUs / qMax(1, stats.runs)) );
+}
+
+/// Content of clipboard notification, reused if the same data are shown again.
+struct DataNotificationPreview {
+    quint64 dataHash = 0;
+    int width = 0;
+    int maxLines = 0;
+    QFont font;
+    QString message;
+    Qt::TextFormat format = Qt::PlainText;
+    QPixmap pixmap;
+};
+
+DataNotificationPreview createDataNotificationPreview(
+        const QVariantMap &data, const QFont &font, int width, int maxLines)
+{
+    DataNotificationPreview preview;
+
+    const QStringList formats = data.keys();
+    const int imageIndex = formats.indexOf(QRegExp("^image/.*"));
+    const bool isHidden = data.contains(mimeHidden);
+
+    if ( !isHidden && data.contains(mimeText) ) {
+        QString text = getTextData(data);
+        const int n = text.count('\n') + 1;
+
+        QString format;
+        if (n > 1) {
+            format = QObject::tr("%1<div align=\"right\"><small>&mdash; %n lines &mdash;</small></div>",
+                                 "Notification label for multi-line text in clipboard", n);
+        } else {
+            format = QObject::tr("%1", "Notification label for single-line text in clipboard");
+        }
+
+        text = elideText(text, font, QString(), false, width, maxLines);
+        text = escapeHtml(text);
+        text.replace( QString("\n"), QString("<br />") );
+        preview.message = format.arg(text);
+        preview.format = Qt::RichText;
+    } else if (!isHidden && imageIndex != -1) {
+        QPixmap pix;
+        const QString &imageFormat = formats[imageIndex];
+        pix.loadFromData( data[imageFormat].toByteArray(), imageFormat.toLatin1() );
+
+        const int height = maxLines * QFontMetrics(font).lineSpacing();
+        if (pix.width() > width || pix.height() > height)
+            pix = pix.scaled(QSize(width, height), Qt::KeepAspectRatio);
+
+        preview.pixmap = pix;
+    } else {
+        preview.message = textLabelForData(data, font, QString(), false, width, maxLines);
+        preview.format = Qt::PlainText;
+    }
+
+    return preview;
+}
+
 } // namespace
 
 #ifdef HAS_TESTS
@@ -814,17 +1114,25 @@ private:
 ScriptableProxy::ScriptableProxy(MainWindow *mainWindow, QObject *parent)
     : QObject(parent)
     , m_wnd(mainWindow)
-{
-    qRegisterMetaType< QPointer<QWidget> >("QPointer<QWidget>");
-    qRegisterMetaTypeStreamOperators<ClipboardMode>("ClipboardMode");
-    qRegisterMetaTypeStreamOperators<Command>("Command");
-    qRegisterMetaTypeStreamOperators<NamedValueList>("NamedValueList");
-    qRegisterMetaTypeStreamOperators<NotificationButtons>("NotificationButtons");
-    qRegisterMetaTypeStreamOperators<ScriptablePath>("ScriptablePath");
-    qRegisterMetaTypeStreamOperators<QVector<int>>("QVector<int>");
-    qRegisterMetaTypeStreamOperators<QVector<Command>>("QVector<Command>");
-    qRegisterMetaTypeStreamOperators<QVector<QVariantMap>>("QVector<QVariantMap>");
-    qRegisterMetaTypeStreamOperators<Qt::KeyboardModifiers>("Qt::KeyboardModifiers");
+    , m_createdAtUs( elapsedUs() )
+{
+    // Proxy is created for each client, register types only once.
+    static const bool registered = []() {
+        qRegisterMetaType< QPointer<QWidget> >("QPointer<QWidget>");
+        qRegisterMetaTypeStreamOperators<ClipboardMode>("ClipboardMode");
+        qRegisterMetaTypeStreamOperators<Command>("Command");
+        qRegisterMetaTypeStreamOperators<NamedValueList>("NamedValueList");
+        qRegisterMetaTypeStreamOperators<NotificationButtons>("NotificationButtons");
+        qRegisterMetaTypeStreamOperators<ScriptablePath>("ScriptablePath");
+        qRegisterMetaTypeStreamOperators<QVector<int>>("QVector<int>");
+        qRegisterMetaTypeStreamOperators<QVector<Command>>("QVector<Command>");
+        qRegisterMetaTypeStreamOperators<QVector<QVariantMap>>("QVector<QVariantMap>");
+        qRegisterMetaTypeStreamOperators<Qt::KeyboardModifiers>("Qt::KeyboardModifiers");
+        return true;
+    }();
+    Q_UNUSED(registered);
+
+    initSingleShotTimer( &m_timerCallPendingFunctions, 0, this, &ScriptableProxy::callPendingFunctions );
 }
 
 void ScriptableProxy::callFunction(const QByteArray &serializedFunctionCall)
@@ -832,23 +1140,31 @@ void ScriptableProxy::callFunction(const QByteArray &serializedFunctionCall)
     if (m_shouldBeDeleted)
         return;
 
+    // Calls are handled later (outside socket handlers) using single timer for
+    // all pending calls instead of allocating a timer for each call.
     ++m_functionCallStack;
-    auto t = new QTimer(this);
-    t->setSingleShot(true);
-    QObject::connect( t, &QTimer::timeout, this, [=]() {
-        const auto result = callFunctionHelper(serializedFunctionCall);
-        emit sendMessage(result, CommandFunctionCallReturnValue);
-        t->deleteLater();
+    m_pendingFunctionCalls.append( PendingFunctionCall{serializedFunctionCall, elapsedUs()} );
+    m_timerCallPendingFunctions.start();
+}
 
+void ScriptableProxy::callPendingFunctions()
+{
+    // Calls can be handled recursively if a call starts an event loop.
+    while ( !m_pendingFunctionCalls.isEmpty() ) {
+        const PendingFunctionCall call = m_pendingFunctionCalls.takeFirst();
+        const auto result = callFunctionHelper(call.serializedFunctionCall, call.queuedAtUs);
+        emit sendMessage(result, CommandFunctionCallReturnValue);
         --m_functionCallStack;
-        if (m_shouldBeDeleted && m_functionCallStack == 0)
-            deleteLater();
-    });
-    t->start(0);
+    }
+
+    if (m_shouldBeDeleted && m_functionCallStack == 0)
+        deleteLater();
 }
 
-QByteArray ScriptableProxy::callFunctionHelper(const QByteArray &serializedFunctionCall)
+QByteArray ScriptableProxy::callFunctionHelper(const QByteArray &serializedFunctionCall, qint64 queuedAtUs)
 {
+    const qint64 startUs = elapsedUs();
+
     QVector<QVariant> arguments;
     QByteArray slotName;
     int functionCallId;
@@ -899,12 +1215,19 @@ QByteArray ScriptableProxy::callFunctionHelper(const QByteArray &serializedFunct
         }
     }
 
-    const auto slotIndex = metaObject()->indexOfSlot(slotName);
-    if (slotIndex == -1) {
-        log("Failed to find scriptable proxy slot: " + slotName, LogError);
-        Q_ASSERT(false);
-        return QByteArray();
+    // Looking up slot by signature scans all methods, remember found slots.
+    static QHash<QByteArray, int> slotIndexes;
+    auto slotIndexIt = slotIndexes.constFind(slotName);
+    if ( slotIndexIt == slotIndexes.constEnd() ) {
+        const auto slotIndex = metaObject()->indexOfSlot(slotName);
+        if (slotIndex == -1) {
+            log("Failed to find scriptable proxy slot: " + slotName, LogError);
+            Q_ASSERT(false);
+            return QByteArray();
+        }
+        slotIndexIt = slotIndexes.insert(slotName, slotIndex);
     }
+    const auto slotIndex = slotIndexIt.value();
 
     const auto metaMethod = metaObject()->method(slotIndex);
     const auto typeId = metaMethod.returnType();
@@ -950,11 +1273,19 @@ QByteArray ScriptableProxy::callFunctionHelper(const QByteArray &serializedFunct
     }
 
     QByteArray bytes;
+    bytes.reserve( serializedSizeHint(returnValue) );
     {
         QDataStream stream(&bytes, QIODevice::WriteOnly);
         stream << functionCallId << returnValue;
     }
 
+    const qint64 waitUs = startUs - queuedAtUs;
+    const qint64 execUs = elapsedUs() - startUs;
+    m_functionCallWaitUs += waitUs;
+    m_functionCallExecUs += execUs;
+    addFunctionCallStatistics(
+        slotName, waitUs, execUs, serializedFunctionCall.size(), bytes.size() );
+
     return bytes;
 }
 
@@ -986,6 +1317,76 @@ void ScriptableProxy::setInputDialogResult(const QByteArray &bytes)
     emit inputDialogFinished(dialogId, result);
 }
 
+void ScriptableProxy::setPersistentCommandResult(const QByteArray &bytes)
+{
+    QDataStream stream(bytes);
+    int requestId;
+    QVariantMap result;
+    stream >> requestId >> result;
+    if (stream.status() != QDataStream::Ok) {
+        log("Failed to read result of program kept running", LogError);
+        Q_ASSERT(false);
+        return;
+    }
+
+    // Result can arrive before the client gets the request ID.
+    m_persistentCommandResults.insert(requestId, result);
+    emit persistentCommandFinished(requestId);
+}
+
+bool ScriptableProxy::takePersistentCommandResult(int requestId, QVariantMap *result)
+{
+    const auto it = m_persistentCommandResults.find(requestId);
+    if ( it == m_persistentCommandResults.end() )
+        return false;
+
+    *result = it.value();
+    m_persistentCommandResults.erase(it);
+    return true;
+}
+
+void ScriptableProxy::onPersistentCommandItemProcessed(
+        int processRequestId, bool ok, const QByteArray &output, const QString &error)
+{
+    const auto it = m_persistentCommandRequests.find(processRequestId);
+    if ( it == m_persistentCommandRequests.end() )
+        return;
+
+    const int requestId = it.value();
+    m_persistentCommandRequests.erase(it);
+
+    QVariantMap result;
+    if (ok)
+        result.insert("output", output);
+    else
+        result.insert("error", error);
+    sendPersistentCommandResult(requestId, result);
+}
+
+void ScriptableProxy::sendPersistentCommandResult(int requestId, const QVariantMap &result)
+{
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream << requestId << result;
+    }
+
+    emit sendMessage(bytes, CommandPersistentCommandFinished);
+}
+
+ScriptableProxy::~ScriptableProxy()
+{
+    // Finish transaction if client exits without committing.
+    commitBrowserTransactions();
+
+    // Statistics are collected only in server for finished clients.
+    if (m_wnd) {
+        const QString commandName = m_actionName.isEmpty() ? QString("-") : m_actionName;
+        addCommandStatistics(
+            commandName, elapsedUs() - m_createdAtUs, m_functionCallWaitUs, m_functionCallExecUs);
+    }
+}
+
 void ScriptableProxy::safeDeleteLater()
 {
     m_shouldBeDeleted = true;
@@ -998,6 +1399,7 @@ QVariantMap ScriptableProxy::getActionData(int id)
     INVOKE_NO_SNIP(getActionData, (id));
     m_actionData = m_wnd->actionData(id);
     m_actionId = id;
+    m_actionName = m_wnd->actionName(id);
 
     auto data = m_actionData;
     data.remove(mimeSelectedItems);
@@ -1135,6 +1537,18 @@ void ScriptableProxy::setTabIcon(const QString &tabName, const QString &icon)
     m_wnd->setTabIcon(tabName, icon);
 }
 
+int ScriptableProxy::tabExpiry(const QString &tabName)
+{
+    INVOKE_NO_SNIP(tabExpiry, (tabName));
+    return tabItemExpiryDays().value(tabName, 0);
+}
+
+void ScriptableProxy::setTabExpiry(const QString &tabName, int days)
+{
+    INVOKE2(setTabExpiry, (tabName, days));
+    m_wnd->setTabItemExpiryDays(tabName, days);
+}
+
 bool ScriptableProxy::showBrowser(const QString &tabName)
 {
     INVOKE(showBrowser, (tabName));
@@ -1163,7 +1577,31 @@ void ScriptableProxy::runInternalAction(const QVariantMap &data, const QString &
     auto action = new Action();
     action->setCommand(command);
     action->setData(data);
-    m_wnd->runInternalAction(action);
+    m_wnd->queueInternalAction(action);
+}
+
+int ScriptableProxy::startPersistentCommand(const QString &commandLine, const QByteArray &input)
+{
+    INVOKE_NO_SNIP(startPersistentCommand, (commandLine, input));
+
+    const int requestId = ++m_lastPersistentCommandId;
+
+    QString error;
+    PersistentProcess *process = m_wnd->persistentProcess(commandLine, &error);
+    if (!process) {
+        QVariantMap result;
+        result.insert("error", error);
+        sendPersistentCommandResult(requestId, result);
+        return requestId;
+    }
+
+    // Reply is passed to client later so server doesn't wait for the program.
+    connect( process, &PersistentProcess::itemProcessed,
+             this, &ScriptableProxy::onPersistentCommandItemProcessed,
+             Qt::UniqueConnection );
+    m_persistentCommandRequests.insert( process->process(input), requestId );
+
+    return requestId;
 }
 
 void ScriptableProxy::showMessage(const QString &title,
@@ -1220,6 +1658,8 @@ QString ScriptableProxy::browserRemoveRows(const QString &tabName, QVector<int>
     if (!c)
         return QString("Invalid tab");
 
+    ClipboardBrowserTransaction transaction(c);
+
     qSort( rows.begin(), rows.end(), qGreater<int>() );
 
     QModelIndexList indexes;
@@ -1247,6 +1687,27 @@ QString ScriptableProxy::browserRemoveRows(const QString &tabName, QVector<int>
     return QString();
 }
 
+void ScriptableProxy::browserSortItems(const QString &tabName, const QVector<int> &rows, int sortKey)
+{
+    INVOKE2(browserSortItems, (tabName, rows, sortKey));
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    if (!c)
+        return;
+
+    QModelIndexList indexes;
+    if ( rows.isEmpty() ) {
+        indexes.reserve( c->length() );
+        for (int row = 0; row < c->length(); ++row)
+            indexes.append( c->index(row) );
+    } else {
+        indexes.reserve( rows.size() );
+        for (int row : rows)
+            indexes.append( c->index(row) );
+    }
+
+    c->sortItems( indexes, static_cast<ItemSortKey>(sortKey) );
+}
+
 void ScriptableProxy::browserEditRow(const QString &tabName, int arg1)
 {
     INVOKE2(browserEditRow, (tabName, arg1));
@@ -1259,12 +1720,60 @@ void ScriptableProxy::browserEditNew(const QString &tabName, const QString &arg1
     BROWSER(tabName, editNew(arg1, changeClipboard));
 }
 
+void ScriptableProxy::beginTransaction()
+{
+    INVOKE2(beginTransaction, ());
+    ++m_transactionDepth;
+}
+
+void ScriptableProxy::commitTransaction()
+{
+    INVOKE2(commitTransaction, ());
+    if (m_transactionDepth > 0 && --m_transactionDepth == 0)
+        commitBrowserTransactions();
+}
+
 QStringList ScriptableProxy::tabs()
 {
     INVOKE(tabs, ());
     return m_wnd->tabs();
 }
 
+QVector<QVariantMap> ScriptableProxy::searchAllTabs(const QRegExp &re, int offset, int count)
+{
+    INVOKE(searchAllTabs, (re, offset, count));
+
+    const auto hits = m_wnd->searchItems(re);
+
+    QVector<QVariantMap> result;
+    const int end = count < 0 ? hits.size() : qMin(hits.size(), offset + count);
+    for (int i = qMax(0, offset); i < end; ++i) {
+        const auto &hit = hits[i];
+        QVariantMap item;
+        item["tab"] = hit.tabName;
+        item["row"] = hit.row;
+        item["hash"] = QString::number(hit.hash, 16);
+        result.append(item);
+    }
+
+    return result;
+}
+
+QVector<QVariantMap> ScriptableProxy::findItem(quint64 hash)
+{
+    INVOKE(findItem, (hash));
+
+    QVector<QVariantMap> result;
+    for ( const auto &hit : m_wnd->findItems(hash) ) {
+        QVariantMap item;
+        item["tab"] = hit.tabName;
+        item["row"] = hit.row;
+        result.append(item);
+    }
+
+    return result;
+}
+
 bool ScriptableProxy::toggleVisible()
 {
     INVOKE(toggleVisible, ());
@@ -1312,16 +1821,16 @@ bool ScriptableProxy::saveTab(const QString &tabName, const QString &arg1)
     return m_wnd->saveTab(arg1, i);
 }
 
-bool ScriptableProxy::importData(const QString &fileName)
+bool ScriptableProxy::importData(const QString &fileName, bool merge)
 {
-    INVOKE(importData, (fileName));
-    return m_wnd->importDataFrom(fileName, ImportOptions::All);
+    INVOKE(importData, (fileName, merge));
+    return m_wnd->importDataFrom(fileName, merge ? ImportOptions::Merge : ImportOptions::All);
 }
 
-bool ScriptableProxy::exportData(const QString &fileName)
+bool ScriptableProxy::exportData(const QString &fileName, const QString &baseFileName)
 {
-    INVOKE(exportData, (fileName));
-    return m_wnd->exportAllData(fileName);
+    INVOKE(exportData, (fileName, baseFileName));
+    return m_wnd->exportAllData(fileName, baseFileName);
 }
 
 QVariant ScriptableProxy::config(const QStringList &nameValue)
@@ -1390,13 +1899,23 @@ QString ScriptableProxy::browserInsert(const QString &tabName, int row, const QV
     if (!c)
         return "Invalid tab";
 
+    ClipboardBrowserTransaction transaction(c);
+
     if ( !c->allocateSpaceForNewItems(items.size()) )
         return "Tab is full (cannot remove any items)";
 
-    for (const auto &item : items) {
-        if ( !c->add(item, row) )
-            return "Failed to new add items";
-    }
+    // Items are inserted at once, last item ends up at the target row
+    // unless the items are appended.
+    const bool append = row < 0 || row > c->length();
+    QList<QVariantMap> dataList;
+    dataList.reserve( items.size() );
+    if (append)
+        std::copy( std::begin(items), std::end(items), std::back_inserter(dataList) );
+    else
+        std::copy( items.rbegin(), items.rend(), std::back_inserter(dataList) );
+
+    if ( !c->add(dataList, row) )
+        return "Failed to new add items";
 
     return QString();
 }
@@ -1432,6 +1951,114 @@ QVariantMap ScriptableProxy::browserItemData(const QString &tabName, int arg1)
     return itemData(tabName, arg1);
 }
 
+quint64 ScriptableProxy::browserItemHash(const QString &tabName, int row)
+{
+    INVOKE(browserItemHash, (tabName, row));
+
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    if (!c)
+        return 0;
+
+    const QModelIndex index = c->index(row);
+    return index.isValid() ? index.data(contentType::hash).toULongLong() : 0;
+}
+
+QVariantList ScriptableProxy::browserItemsData(const QString &tabName, const QVector<int> &rows, const QStringList &mimes)
+{
+    INVOKE(browserItemsData, (tabName, rows, mimes));
+
+    QVariantList result;
+    result.reserve( rows.size() );
+    for (int i = 0; i < rows.size(); ++i) {
+        const int row = rows[i];
+        const QString mime = mimes.value(i);
+        if (row < 0) {
+            result.append( getClipboardData(mime) );
+            continue;
+        }
+
+        // Client reads big data stored in blob file directly.
+        ClipboardBrowser *c = fetchBrowser(tabName);
+        const QString blobPath = c ? c->itemBlobFilePath(row, mime) : QString();
+        if ( blobPath.isEmpty() )
+            result.append( itemData(tabName, row, mime) );
+        else
+            result.append( QVariant::fromValue(ScriptablePath{blobPath}) );
+    }
+    return result;
+}
+
+QVector<QVariantMap> ScriptableProxy::browserItemsDataRange(const QString &tabName, int row, int count, const QStringList &mimes)
+{
+    INVOKE(browserItemsDataRange, (tabName, row, count, mimes));
+
+    QVector<QVariantMap> result;
+    ClipboardBrowser *c = fetchBrowser(tabName);
+    if (!c)
+        return result;
+
+    const int first = qMax(0, row);
+    const int end = count < 0 ? c->length() : qMin(c->length(), first + count);
+    if (first < end)
+        result.reserve(end - first);
+
+    for (int i = first; i < end; ++i) {
+        QVariantMap data = c->copyIndex( c->index(i) );
+        if ( !mimes.isEmpty() ) {
+            for (auto it = data.begin(); it != data.end(); ) {
+                if ( mimes.contains(it.key()) )
+                    ++it;
+                else
+                    it = data.erase(it);
+            }
+        }
+        result.append(data);
+    }
+
+    return result;
+}
+
+QStringList ScriptableProxy::createTabSnapshot(const QStringList &tabNames)
+{
+    INVOKE(createTabSnapshot, (tabNames));
+
+    m_tabSnapshots.clear();
+
+    QStringList snapshotTabNames;
+    for (const auto &tabName : tabNames) {
+        ClipboardBrowser *c = fetchBrowser(tabName);
+        if (!c)
+            continue;
+
+        // Item data are implicitly shared so this doesn't copy the data itself.
+        QVector<QVariantMap> items;
+        items.reserve( c->length() );
+        for (int i = 0; i < c->length(); ++i)
+            items.append( c->copyIndex(c->index(i)) );
+
+        snapshotTabNames.append( c->tabName() );
+        m_tabSnapshots.insert( c->tabName(), items );
+    }
+
+    return snapshotTabNames;
+}
+
+QVector<QVariantMap> ScriptableProxy::tabSnapshotItems(const QString &tabName, int row, int count)
+{
+    INVOKE(tabSnapshotItems, (tabName, row, count));
+
+    const auto items = m_tabSnapshots.value(tabName);
+    const int first = qBound(0, row, items.size());
+    const int end = count < 0 ? items.size() : qMin(items.size(), first + count);
+    return items.mid(first, end - first);
+}
+
+void ScriptableProxy::releaseTabSnapshot()
+{
+    INVOKE2(releaseTabSnapshot, ());
+    m_tabSnapshots.clear();
+}
+
 void ScriptableProxy::setCurrentTab(const QString &tabName)
 {
     INVOKE2(setCurrentTab, (tabName));
@@ -1836,15 +2463,7 @@ QByteArray ScriptableProxy::screenshot(const QString &format, const QString &scr
         }
     }
 
-    QByteArray bytes;
-    {
-        QBuffer buffer(&bytes);
-        buffer.open(QIODevice::WriteOnly);
-        if ( !pixmap.save(&buffer, format.toUtf8().constData()) )
-            return QByteArray();
-    }
-
-    return bytes;
+    return encodeImage(pixmap.toImage(), format);
 }
 
 QStringList ScriptableProxy::screenNames()
@@ -1873,6 +2492,75 @@ QString ScriptableProxy::pluginsPath()
     return ::pluginsPath();
 }
 
+QString ScriptableProxy::startupPhases()
+{
+    INVOKE_NO_SNIP(startupPhases, ());
+    return startupPhasesText();
+}
+
+QString ScriptableProxy::memoryUsage()
+{
+    INVOKE_NO_SNIP(memoryUsage, ());
+    return m_wnd->memoryUsage();
+}
+
+QString ScriptableProxy::metrics()
+{
+    INVOKE_NO_SNIP(metrics, ());
+    return metricsText();
+}
+
+QString ScriptableProxy::commandStatistics()
+{
+    INVOKE_NO_SNIP(commandStatistics, ());
+
+    QStringList commandNames = ::commandStatistics().keys();
+    const auto &statistics = ::commandStatistics();
+    std::sort( commandNames.begin(), commandNames.end(), [&](const QString &lhs, const QString &rhs) {
+        return statistics.value(lhs).totalUs > statistics.value(rhs).totalUs;
+    });
+
+    QStringList result;
+    for (const auto &commandName : commandNames) {
+        result.append(
+            quoteString(commandName) + ": " + commandStatisticsText(statistics.value(commandName)) );
+    }
+
+    return result.join("\n");
+}
+
+QString ScriptableProxy::functionCallStatistics()
+{
+    INVOKE_NO_SNIP(functionCallStatistics, ());
+
+    QList<QByteArray> slotNames = ::functionCallStatistics().keys();
+    const auto &statistics = ::functionCallStatistics();
+    std::sort( slotNames.begin(), slotNames.end(), [&](const QByteArray &lhs, const QByteArray &rhs) {
+        const auto a = statistics.value(lhs);
+        const auto b = statistics.value(rhs);
+        return a.totalExecUs + a.totalWaitUs > b.totalExecUs + b.totalWaitUs;
+    });
+
+    QStringList result;
+
+    QStringList histogram;
+    for (int i = 0; i < latencyHistogramSize; ++i) {
+        const auto label = i < latencyHistogramSize - 1
+                ? QString("<%1ms").arg(latencyHistogramBoundsMs[i])
+                : QString(">=%1ms").arg(latencyHistogramBoundsMs[i - 1]);
+        histogram.append( QString("%1=%2").arg(label).arg(latencyHistogram()[i]) );
+    }
+    result.append( "latency: " + histogram.join(" ") );
+
+    for (const auto &slotName : slotNames) {
+        result.append(
+            QString::fromLatin1(slotName) + ": "
+            + functionCallStatisticsText(statistics.value(slotName)) );
+    }
+
+    return result.join("\n");
+}
+
 QString ScriptableProxy::themesPath()
 {
     INVOKE_NO_SNIP(themesPath, ());
@@ -1969,13 +2657,13 @@ void ScriptableProxy::setTitleForData(const QVariantMap &data)
     setTitle(clipboardContent);
 }
 
-void ScriptableProxy::saveData(const QString &tab, const QVariantMap &data, ClipboardMode mode)
+void ScriptableProxy::saveData(const QString &tab, const QVariantMap &data, ClipboardMode mode, quint64 dataHash)
 {
-    INVOKE2(saveData, (tab, data, mode));
+    INVOKE2(saveData, (tab, data, mode, dataHash));
 
     auto c = m_wnd->tab(tab);
     if (c) {
-        c->addUnique(data, mode);
+        c->addUnique(data, mode, dataHash);
         c->setCurrent(0);
     }
 }
@@ -2000,43 +2688,28 @@ void ScriptableProxy::showDataNotification(const QVariantMap &data)
     const int maximumWidthPoints = appConfig.option<Config::notification_maximum_width>();
     const int width = pointsToPixels(maximumWidthPoints) - 16 - 8;
 
-    const QStringList formats = data.keys();
-    const int imageIndex = formats.indexOf(QRegExp("^image/.*"));
     const QFont &font = notification->font();
-    const bool isHidden = data.contains(mimeHidden);
 
-    if (data.isEmpty()) {
+    if (data.isEmpty())
         notification->setInterval(0);
-    } if ( !isHidden && data.contains(mimeText) ) {
-        QString text = getTextData(data);
-        const int n = text.count('\n') + 1;
-
-        QString format;
-        if (n > 1) {
-            format = QObject::tr("%1<div align=\"right\"><small>&mdash; %n lines &mdash;</small></div>",
-                                 "Notification label for multi-line text in clipboard", n);
-        } else {
-            format = QObject::tr("%1", "Notification label for single-line text in clipboard");
-        }
-
-        text = elideText(text, font, QString(), false, width, maxLines);
-        text = escapeHtml(text);
-        text.replace( QString("\n"), QString("<br />") );
-        notification->setMessage( format.arg(text), Qt::RichText );
-    } else if (!isHidden && imageIndex != -1) {
-        QPixmap pix;
-        const QString &imageFormat = formats[imageIndex];
-        pix.loadFromData( data[imageFormat].toByteArray(), imageFormat.toLatin1() );
-
-        const int height = maxLines * QFontMetrics(font).lineSpacing();
-        if (pix.width() > width || pix.height() > height)
-            pix = pix.scaled(QSize(width, height), Qt::KeepAspectRatio);
 
-        notification->setPixmap(pix);
-    } else {
-        const QString text = textLabelForData(data, font, QString(), false, width, maxLines);
-        notification->setMessage(text, Qt::PlainText);
+    // Avoid eliding text and scaling images again if the data didn't change.
+    static DataNotificationPreview preview;
+    const quint64 dataHash = ::hash(data);
+    if ( preview.dataHash != dataHash || preview.width != width
+         || preview.maxLines != maxLines || preview.font != font )
+    {
+        preview = createDataNotificationPreview(data, font, width, maxLines);
+        preview.dataHash = dataHash;
+        preview.width = width;
+        preview.maxLines = maxLines;
+        preview.font = font;
     }
+
+    if ( preview.pixmap.isNull() )
+        notification->setMessage(preview.message, preview.format);
+    else
+        notification->setPixmap(preview.pixmap);
 }
 
 QStringList ScriptableProxy::menuItemMatchCommands(int actionId)
@@ -2089,16 +2762,40 @@ bool ScriptableProxy::openUrls(const QStringList &urls)
 }
 
 ClipboardBrowser *ScriptableProxy::fetchBrowser(const QString &tabName)
+{
+    ClipboardBrowser *c = fetchBrowserHelper(tabName);
+
+    // Tabs accessed in a transaction defer notifications until it's committed.
+    if (c && m_transactionDepth > 0 && !m_transactionBrowsers.contains(c)) {
+        c->beginTransaction();
+        m_transactionBrowsers.append(c);
+    }
+
+    return c;
+}
+
+ClipboardBrowser *ScriptableProxy::fetchBrowserHelper(const QString &tabName)
 {
     if (tabName.isEmpty()) {
         const QString defaultTabName = m_actionData.value(mimeCurrentTab).toString();
         if (!defaultTabName.isEmpty())
-            return fetchBrowser(defaultTabName);
+            return fetchBrowserHelper(defaultTabName);
     }
 
     return tabName.isEmpty() ? m_wnd->browser(0) : m_wnd->tab(tabName);
 }
 
+void ScriptableProxy::commitBrowserTransactions()
+{
+    m_transactionDepth = 0;
+    const auto browsers = m_transactionBrowsers;
+    m_transactionBrowsers.clear();
+    for (const auto &browser : browsers) {
+        if (browser)
+            browser->commitTransaction();
+    }
+}
+
 QVariantMap ScriptableProxy::itemData(const QString &tabName, int i)
 {
     auto c = fetchBrowser(tabName);
@@ -28,7 +28,9 @@
 #include <QMetaObject>
 #include <QObject>
 #include <QPoint>
+#include <QPointer>
 #include <QRect>
+#include <QTimer>
 #include <QVariant>
 #include <QVector>
 
@@ -81,6 +83,7 @@ class ScriptableProxy : public QObject
 
 public:
     explicit ScriptableProxy(MainWindow* mainWindow, QObject *parent = nullptr);
+    ~ScriptableProxy();
 
     void callFunction(const QByteArray &serializedFunctionCall);
 
@@ -88,6 +91,14 @@ public:
 
     void setFunctionCallReturnValue(const QByteArray &bytes);
     void setInputDialogResult(const QByteArray &bytes);
+    void setPersistentCommandResult(const QByteArray &bytes);
+
+    /**
+     * Take result of startPersistentCommand() if already received (client only).
+     *
+     * Result is map with "output" or "error".
+     */
+    bool takePersistentCommandResult(int requestId, QVariantMap *result);
 
     void safeDeleteLater();
 
@@ -114,6 +125,8 @@ public slots:
     QString removeTab(const QString &arg1);
 
     QString tabIcon(const QString &tabName);
+    int tabExpiry(const QString &tabName);
+    void setTabExpiry(const QString &tabName, int days);
     void setTabIcon(const QString &tabName, const QString &icon);
 
     bool showBrowser(const QString &tabName);
@@ -123,6 +136,14 @@ public slots:
 
     void runInternalAction(const QVariantMap &data, const QString &command);
 
+    /**
+     * Queue input for program of a command kept running by server.
+     *
+     * Returns request ID. The result is passed later to client
+     * (see persistentCommandFinished() and takePersistentCommandResult()).
+     */
+    int startPersistentCommand(const QString &commandLine, const QByteArray &input);
+
     void showMessage(const QString &title,
             const QString &msg,
             const QString &icon,
@@ -134,11 +155,17 @@ public slots:
     void browserMoveToClipboard(const QString &tabName, int row);
     void browserSetCurrent(const QString &tabName, int arg1);
     QString browserRemoveRows(const QString &tabName, QVector<int> rows);
+    void browserSortItems(const QString &tabName, const QVector<int> &rows, int sortKey);
 
     void browserEditRow(const QString &tabName, int arg1);
     void browserEditNew(const QString &tabName, const QString &arg1, bool changeClipboard);
 
     QStringList tabs();
+    QVector<QVariantMap> searchAllTabs(const QRegExp &re, int offset, int count);
+    QVector<QVariantMap> findItem(quint64 hash);
+
+    void beginTransaction();
+    void commitTransaction();
     bool toggleVisible();
     bool toggleMenu(const QString &tabName, int maxItemCount, QPoint position);
     bool toggleCurrentMenu();
@@ -149,8 +176,8 @@ public slots:
     bool loadTab(const QString &arg1);
     bool saveTab(const QString &tabName, const QString &arg1);
 
-    bool importData(const QString &fileName);
-    bool exportData(const QString &fileName);
+    bool importData(const QString &fileName, bool merge);
+    bool exportData(const QString &fileName, const QString &baseFileName);
 
     QVariant config(const QStringList &nameValue);
     QVariant toggleConfig(const QString &optionName);
@@ -166,6 +193,18 @@ public slots:
 
     QByteArray browserItemData(const QString &tabName, int arg1, const QString &arg2);
     QVariantMap browserItemData(const QString &tabName, int arg1);
+    quint64 browserItemHash(const QString &tabName, int row);
+    /**
+     * Return data in given formats of items in given rows (or clipboard for negative rows).
+     *
+     * This needs only single call to server for many items.
+     */
+    QVariantList browserItemsData(const QString &tabName, const QVector<int> &rows, const QStringList &mimes);
+    QVector<QVariantMap> browserItemsDataRange(const QString &tabName, int row, int count, const QStringList &mimes);
+
+    QStringList createTabSnapshot(const QStringList &tabNames);
+    QVector<QVariantMap> tabSnapshotItems(const QString &tabName, int row, int count);
+    void releaseTabSnapshot();
 
     void setCurrentTab(const QString &tabName);
 
@@ -213,6 +252,11 @@ public slots:
     Qt::KeyboardModifiers queryKeyboardModifiers();
 
     QString pluginsPath();
+    QString functionCallStatistics();
+    QString commandStatistics();
+    QString startupPhases();
+    QString memoryUsage();
+    QString metrics();
     QString themesPath();
     QString translationsPath();
 
@@ -228,7 +272,7 @@ public slots:
     void setClipboardData(const QVariantMap &data);
     void setTitle(const QString &title);
     void setTitleForData(const QVariantMap &data);
-    void saveData(const QString &tab, const QVariantMap &data, ClipboardMode mode);
+    void saveData(const QString &tab, const QVariantMap &data, ClipboardMode mode, quint64 dataHash);
     void showDataNotification(const QVariantMap &data);
 
     QStringList menuItemMatchCommands(int actionId);
@@ -245,11 +289,19 @@ public slots:
 signals:
     void functionCallFinished(int functionCallId, const QVariant &returnValue);
     void inputDialogFinished(int dialogId, const NamedValueList &result);
+    void persistentCommandFinished(int requestId);
     void sendMessage(const QByteArray &message, int messageCode);
     void clientDisconnected();
 
 private:
     ClipboardBrowser *fetchBrowser(const QString &tabName);
+    ClipboardBrowser *fetchBrowserHelper(const QString &tabName);
+
+    void commitBrowserTransactions();
+
+    void onPersistentCommandItemProcessed(
+            int processRequestId, bool ok, const QByteArray &output, const QString &error);
+    void sendPersistentCommandResult(int requestId, const QVariantMap &result);
 
     QVariantMap itemData(const QString &tabName, int i);
     QByteArray itemData(const QString &tabName, int i, const QString &mime);
@@ -259,7 +311,13 @@ private:
 
     QVariant waitForFunctionCallFinished(int functionId);
 
-    QByteArray callFunctionHelper(const QByteArray &serializedFunctionCall);
+    struct PendingFunctionCall {
+        QByteArray serializedFunctionCall;
+        qint64 queuedAtUs;
+    };
+
+    QByteArray callFunctionHelper(const QByteArray &serializedFunctionCall, qint64 queuedAtUs);
+    void callPendingFunctions();
 
 #ifdef HAS_TESTS
     KeyClicker *keyClicker();
@@ -269,12 +327,34 @@ private:
     MainWindow* m_wnd;
     QVariantMap m_actionData;
     int m_actionId = -1;
+    QString m_actionName;
+
+    // Item data of tabs copied at once so client reads consistent data (server only).
+    QHash<QString, QVector<QVariantMap>> m_tabSnapshots;
+
+    // Time spent by client and in its function calls (server only).
+    qint64 m_createdAtUs = 0;
+    qint64 m_functionCallWaitUs = 0;
+    qint64 m_functionCallExecUs = 0;
 
     int m_lastFunctionCallId = -1;
     int m_lastInputDialogId = -1;
+    int m_lastPersistentCommandId = -1;
+
+    // Maps requests of programs kept running to client requests (server only).
+    QHash<int, int> m_persistentCommandRequests;
+    // Results of requests passed to client but not taken yet (client only).
+    QHash<int, QVariantMap> m_persistentCommandResults;
 
     int m_functionCallStack = 0;
     bool m_shouldBeDeleted = false;
+
+    // Tabs changed in script transaction (server only).
+    int m_transactionDepth = 0;
+    QList<QPointer<ClipboardBrowser>> m_transactionBrowsers;
+
+    QList<PendingFunctionCall> m_pendingFunctionCalls;
+    QTimer m_timerCallPendingFunctions;
 };
 
 QString pluginsPath();
@@ -0,0 +1,209 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "scriptableworker.h"
+
+#include "common/action.h"
+#include "common/commandstatus.h"
+#include "common/log.h"
+#include "scriptable/scriptable.h"
+#include "scriptable/scriptableproxy.h"
+
+#include <QMutexLocker>
+#include <QScriptEngine>
+#include <QThread>
+
+namespace {
+
+const int abortTimeoutMs = 5000;
+
+} // namespace
+
+ScriptableWorkerRunner::ScriptableWorkerRunner(
+        ScriptableProxy *mainProxy, const QStringList &arguments, const QByteArray &input,
+        int actionId, const QString &actionName)
+    : m_mainProxy(mainProxy)
+    , m_arguments(arguments)
+    , m_input(input)
+    , m_actionId(actionId)
+    , m_actionName(actionName)
+{
+}
+
+void ScriptableWorkerRunner::run()
+{
+    int exitCode = CommandFinished;
+    QByteArray errorOutput;
+
+    QMutexLocker lock(&m_scriptableMutex);
+    if (!m_aborted) {
+        QScriptEngine engine;
+        ScriptableProxy scriptableProxy(nullptr, nullptr);
+        Scriptable scriptable(&engine, &scriptableProxy);
+
+        connect( &scriptableProxy, &ScriptableProxy::sendMessage,
+                 m_mainProxy, &ScriptableProxy::callFunction );
+        connect( this, &ScriptableWorkerRunner::functionCallResultReceived,
+                 &scriptableProxy, &ScriptableProxy::setFunctionCallReturnValue );
+        connect( this, &ScriptableWorkerRunner::inputDialogFinished,
+                 &scriptableProxy, &ScriptableProxy::setInputDialogResult );
+        connect( this, &ScriptableWorkerRunner::persistentCommandFinished,
+                 &scriptableProxy, &ScriptableProxy::setPersistentCommandResult );
+        connect( &scriptable, &Scriptable::finished,
+                 &scriptableProxy, &ScriptableProxy::clientDisconnected );
+
+        // Script output is passed to the action in main thread.
+        Action action;
+        action.setCommand(m_arguments);
+        action.setInput(m_input);
+        connect( &action, &Action::actionOutput,
+                 this, &ScriptableWorkerRunner::output );
+
+        // Environment changes are private to the script.
+        QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+        environment.insert("COPYQ_ACTION_ID", QString::number(m_actionId));
+        if ( !m_actionName.isEmpty() )
+            environment.insert("COPYQ_ACTION_NAME", m_actionName);
+        scriptable.setEnvironment(environment);
+
+        m_scriptable = &scriptable;
+        lock.unlock();
+
+        scriptable.setActionId(m_actionId);
+        scriptable.setActionName(m_actionName);
+        if ( scriptable.runAction(&action) ) {
+            exitCode = action.exitCode();
+            errorOutput = action.errorOutput();
+        } else {
+            exitCode = CommandError;
+        }
+
+        lock.relock();
+        m_scriptable = nullptr;
+    }
+    lock.unlock();
+
+    emit finished(exitCode, errorOutput);
+    QThread::currentThread()->quit();
+}
+
+void ScriptableWorkerRunner::abort()
+{
+    QMutexLocker lock(&m_scriptableMutex);
+    m_aborted = true;
+    if (m_scriptable)
+        m_scriptable->requestAbort();
+}
+
+void ScriptableWorkerRunner::onMessageReceived(const QByteArray &data, int messageCode)
+{
+    switch (messageCode) {
+    case CommandFunctionCallReturnValue:
+        emit functionCallResultReceived(data);
+        break;
+
+    case CommandInputDialogFinished:
+        emit inputDialogFinished(data);
+        break;
+
+    case CommandPersistentCommandFinished:
+        emit persistentCommandFinished(data);
+        break;
+
+    default:
+        log( QString("Unhandled message for script worker: %1").arg(messageCode), LogError );
+        break;
+    }
+}
+
+bool ScriptableWorker::canRunAction(const Action &action)
+{
+    const auto &cmd = action.command();
+    if ( cmd.size() != 1 || cmd[0].size() != 1 )
+        return false;
+
+    const auto &args = cmd[0][0];
+    return args.size() >= 3
+        && args[0] == "copyq"
+        && (args[1] == "eval" || args[1] == "-e");
+}
+
+ScriptableWorker::ScriptableWorker(MainWindow *mainWindow, Action *action)
+    : QObject(action)
+    , m_action(action)
+    , m_proxy(new ScriptableProxy(mainWindow))
+    , m_runner(new ScriptableWorkerRunner(
+                   m_proxy, action->command()[0][0], action->input(),
+                   action->id(), action->name()))
+    , m_thread(new QThread(this))
+{
+    m_runner->moveToThread(m_thread);
+
+    connect( m_thread, &QThread::started,
+             m_runner, &ScriptableWorkerRunner::run );
+    connect( m_proxy, &ScriptableProxy::sendMessage,
+             m_runner, &ScriptableWorkerRunner::onMessageReceived );
+    connect( m_runner, &ScriptableWorkerRunner::output,
+             m_action, &Action::appendOutput );
+    connect( m_runner, &ScriptableWorkerRunner::finished,
+             m_proxy, &ScriptableProxy::clientDisconnected );
+    connect( m_runner, &ScriptableWorkerRunner::finished,
+             this, &ScriptableWorker::onFinished );
+    // Script thread is busy evaluating so abort must be called directly.
+    connect( m_action, &Action::terminationRequested,
+             m_runner, &ScriptableWorkerRunner::abort, Qt::DirectConnection );
+    connect( this, &ScriptableWorker::abortRequested,
+             m_runner, &ScriptableWorkerRunner::abort, Qt::DirectConnection );
+}
+
+ScriptableWorker::~ScriptableWorker()
+{
+    if ( m_thread->isRunning() ) {
+        emit abortRequested();
+        if ( !m_thread->wait(abortTimeoutMs) ) {
+            // Let the script finish in background and clean up afterwards.
+            log("Script is still running after abort", LogWarning);
+            auto thread = m_thread;
+            auto runner = m_runner;
+            auto proxy = m_proxy;
+            thread->setParent(nullptr);
+            connect( thread, &QThread::finished, thread, [thread, runner, proxy]() {
+                delete runner;
+                proxy->safeDeleteLater();
+                thread->deleteLater();
+            });
+            return;
+        }
+    }
+
+    delete m_runner;
+    m_proxy->safeDeleteLater();
+}
+
+void ScriptableWorker::start()
+{
+    m_action->startWithoutProcess();
+    m_thread->start();
+}
+
+void ScriptableWorker::onFinished(int exitCode, const QByteArray &errorOutput)
+{
+    m_action->appendErrorOutput(errorOutput);
+    m_action->finishWithoutProcess(exitCode);
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SCRIPTABLEWORKER_H
+#define SCRIPTABLEWORKER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class Action;
+class MainWindow;
+class QThread;
+class Scriptable;
+class ScriptableProxy;
+
+/**
+ * Runs script of an action in separate thread of the server.
+ *
+ * Lives in the worker thread. Messages are passed between scriptable proxy of
+ * the script and the proxy in the main thread same way as with client process.
+ */
+class ScriptableWorkerRunner final : public QObject
+{
+    Q_OBJECT
+public:
+    ScriptableWorkerRunner(
+            ScriptableProxy *mainProxy, const QStringList &arguments, const QByteArray &input,
+            int actionId, const QString &actionName);
+
+    void run();
+
+    /// Abort script. Can be called from any thread.
+    void abort();
+
+    void onMessageReceived(const QByteArray &data, int messageCode);
+
+signals:
+    void functionCallResultReceived(const QByteArray &returnValue);
+    void inputDialogFinished(const QByteArray &data);
+    void persistentCommandFinished(const QByteArray &data);
+    void output(const QByteArray &output);
+    void finished(int exitCode, const QByteArray &errorOutput);
+
+private:
+    ScriptableProxy *m_mainProxy;
+    QStringList m_arguments;
+    QByteArray m_input;
+    int m_actionId;
+    QString m_actionName;
+    QMutex m_scriptableMutex;
+    Scriptable *m_scriptable = nullptr;
+    bool m_aborted = false;
+};
+
+/**
+ * Executes script of an action ("copyq eval -- SCRIPT") in the server
+ * without spawning new client process.
+ *
+ * Action is passed output and exit code of the script. Worker is destroyed
+ * with the action.
+ */
+class ScriptableWorker final : public QObject
+{
+    Q_OBJECT
+public:
+    /// Return true only if action is a script which can be run by the worker.
+    static bool canRunAction(const Action &action);
+
+    ScriptableWorker(MainWindow *mainWindow, Action *action);
+
+    ~ScriptableWorker();
+
+    void start();
+
+signals:
+    void abortRequested();
+
+private:
+    void onFinished(int exitCode, const QByteArray &errorOutput);
+
+    Action *m_action;
+    ScriptableProxy *m_proxy;
+    ScriptableWorkerRunner *m_runner;
+    QThread *m_thread;
+};
+
+#endif // SCRIPTABLEWORKER_H
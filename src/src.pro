@@ -41,6 +41,7 @@ HEADERS += \
     common/contenttype.h \
     common/globalshortcutcommands.h \
     common/option.h \
+    common/persistentprocess.h \
     common/predefinedcommands.h \
     common/server.h \
     common/temporaryfile.h \
@@ -79,10 +80,16 @@ HEADERS += \
     gui/traymenu.h \
     item/clipboarditem.h \
     item/clipboardmodel.h \
+    item/itembackgroundfilter.h \
+    item/itembackgroundsaver.h \
     item/itemdelegate.h \
     item/itemeditor.h \
     item/itemeditorwidget.h \
     item/itemfactory.h \
+    item/itemjournal.h \
+    item/itemsearch.h \
+    item/itemsnapshotmodel.h \
+    item/itemtextindex.h \
     item/itemwidget.h \
     item/persistentdisplayitem.h \
     item/serialize.h \
@@ -96,6 +103,7 @@ HEADERS += \
     scriptable/scriptableclass.h \
     scriptable/scriptable.h \
     scriptable/scriptableproxy.h \
+    scriptable/scriptableworker.h \
     scriptable/temporaryfileclass.h \
     scriptable/temporaryfileprototype.h \
     tests/testinterface.h \
@@ -118,6 +126,8 @@ HEADERS += \
     gui/addcommanddialog.h \
     gui/filtercompleter.h \
     common/sleeptimer.h \
+    common/startupphases.h \
+    common/metrics.h \
     tests/test_utils.h \
     gui/filedialog.h \
     gui/windowgeometryguard.h \
@@ -143,10 +153,13 @@ SOURCES += \
     common/display.cpp \
     common/globalshortcutcommands.cpp \
     common/messagehandlerforqt.cpp \
+    common/metrics.cpp \
     common/option.cpp \
+    common/persistentprocess.cpp \
     common/predefinedcommands.cpp \
     common/server.cpp \
     common/shortcuts.cpp \
+    common/startupphases.cpp \
     common/temporaryfile.cpp \
     common/textdata.cpp \
     gui/aboutdialog.cpp \
@@ -183,10 +196,16 @@ SOURCES += \
     gui/traymenu.cpp \
     item/clipboarditem.cpp \
     item/clipboardmodel.cpp \
+    item/itembackgroundfilter.cpp \
+    item/itembackgroundsaver.cpp \
     item/itemdelegate.cpp \
     item/itemeditor.cpp \
     item/itemeditorwidget.cpp \
     item/itemfactory.cpp \
+    item/itemjournal.cpp \
+    item/itemsearch.cpp \
+    item/itemsnapshotmodel.cpp \
+    item/itemtextindex.cpp \
     item/itemwidget.cpp \
     item/persistentdisplayitem.cpp \
     item/serialize.cpp \
@@ -199,6 +218,7 @@ SOURCES += \
     scriptable/scriptableclass.cpp \
     scriptable/scriptable.cpp \
     scriptable/scriptableproxy.cpp \
+    scriptable/scriptableworker.cpp \
     scriptable/temporaryfileclass.cpp \
     scriptable/temporaryfileprototype.cpp \
     common/mimetypes.cpp \
@@ -246,8 +266,14 @@ CONFIG(debug, debug|release) {
 CONFIG(tests) {
     DEFINES += HAS_TESTS
     QT += testlib
-    SOURCES += tests/tests.cpp
-    HEADERS += tests/tests.h
+    SOURCES += tests/tests.cpp \
+        tests/benchmarks.cpp \
+        tests/clientbenchmarks.cpp \
+        tests/stresstests.cpp
+    HEADERS += tests/tests.h \
+        tests/benchmarks.h \
+        tests/clientbenchmarks.h \
+        tests/stresstests.h
 }
 
 include(platform/platform.pri)
@@ -0,0 +1,449 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "benchmarks.h"
+
+#include "common/contenttype.h"
+#include "common/log.h"
+#include "common/mimetypes.h"
+#include "common/textdata.h"
+#include "gui/clipboardbrowser.h"
+#include "gui/clipboardbrowsershared.h"
+#include "item/clipboardmodel.h"
+#include "item/itemfactory.h"
+#include "item/serialize.h"
+
+#include <QApplication>
+#include <QBuffer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QScrollBar>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QXmlStreamReader>
+
+#include <memory>
+
+namespace {
+
+QList<QVariantMap> createItems(int count)
+{
+    QList<QVariantMap> items;
+    items.reserve(count);
+
+    for (int i = 0; i < count; ++i) {
+        QVariantMap data;
+        data.insert( mimeText, QString("Item %1: The quick brown fox jumps over the lazy dog.").arg(i).toUtf8() );
+        if (i % 10 == 0)
+            data.insert( mimeHtml, QString("<p>Item <b>%1</b></p>").arg(i).toUtf8() );
+        if (i % 100 == 0)
+            data.insert( mimeItemNotes, QString("Notes for item %1").arg(i).toUtf8() );
+        items.append(data);
+    }
+
+    return items;
+}
+
+void addItemCountRows()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+    QTest::newRow("100k") << 100000;
+}
+
+void addBrowserItemCountRows()
+{
+    QTest::addColumn<int>("itemCount");
+    QTest::newRow("1k") << 1000;
+    QTest::newRow("10k") << 10000;
+}
+
+/// Shown browser with items for benchmarking rendering.
+class BrowserFixture final {
+public:
+    explicit BrowserFixture(int itemCount)
+        : m_sharedData(std::make_shared<ClipboardBrowserShared>())
+    {
+        m_sharedData->itemFactory = &m_itemFactory;
+        m_sharedData->maxItems = itemCount;
+
+        m_browser.reset( new ClipboardBrowser(QString(), m_sharedData) );
+        auto model = qobject_cast<ClipboardModel*>( m_browser->model() );
+        if (model)
+            model->insertItems( createItems(itemCount), 0 );
+
+        m_browser->resize(400, 600);
+        m_browser->show();
+        QApplication::processEvents();
+    }
+
+    ClipboardBrowser *browser() const { return m_browser.get(); }
+
+    /// Render pending changes.
+    void render() const
+    {
+        QApplication::processEvents();
+        m_browser->viewport()->repaint();
+    }
+
+    ~BrowserFixture()
+    {
+        // Print number of item widgets and memory used by items.
+        log( m_browser->memoryUsage(), LogNote );
+    }
+
+private:
+    ItemFactory m_itemFactory;
+    ClipboardBrowserSharedPtr m_sharedData;
+    std::unique_ptr<ClipboardBrowser> m_browser;
+};
+
+QByteArray serializedItems(int itemCount)
+{
+    ClipboardModel model;
+    model.insertItems( createItems(itemCount), 0 );
+
+    QBuffer buffer;
+    buffer.open(QIODevice::WriteOnly);
+    serializeData(model, &buffer);
+    return buffer.data();
+}
+
+/// Converts benchmark results from QTest XML output to JSON.
+bool writeBenchmarkResults(QIODevice *xmlFile, const QString &jsonFileName)
+{
+    QJsonArray results;
+    QString functionName;
+
+    QXmlStreamReader xml(xmlFile);
+    while ( !xml.atEnd() ) {
+        if ( !xml.readNextStartElement() )
+            continue;
+
+        const auto attributes = xml.attributes();
+        if ( xml.name() == "TestFunction" ) {
+            functionName = attributes.value("name").toString();
+        } else if ( xml.name() == "BenchmarkResult" ) {
+            const double value = attributes.value("value").toDouble();
+            const int iterations = qMax(1, attributes.value("iterations").toInt());
+            QJsonObject result;
+            result["name"] = functionName;
+            result["tag"] = attributes.value("tag").toString();
+            result["metric"] = attributes.value("metric").toString();
+            result["value"] = value / iterations;
+            result["iterations"] = iterations;
+            results.append(result);
+        }
+    }
+
+    if ( xml.hasError() ) {
+        log( QString("Failed to parse benchmark results: %1").arg(xml.errorString()), LogError );
+        return false;
+    }
+
+    QFile jsonFile(jsonFileName);
+    if ( !jsonFile.open(QIODevice::WriteOnly) ) {
+        log( QString("Failed to write benchmark results: %1").arg(jsonFile.errorString()), LogError );
+        return false;
+    }
+
+    jsonFile.write( QJsonDocument(results).toJson() );
+    return true;
+}
+
+} // namespace
+
+Benchmarks::Benchmarks(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void Benchmarks::serializeItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::serializeItems()
+{
+    QFETCH(int, itemCount);
+
+    ClipboardModel model;
+    model.insertItems( createItems(itemCount), 0 );
+
+    QBENCHMARK {
+        QBuffer buffer;
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY( serializeData(model, &buffer) );
+    }
+}
+
+void Benchmarks::deserializeItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::deserializeItems()
+{
+    QFETCH(int, itemCount);
+
+    QByteArray bytes = serializedItems(itemCount);
+
+    QBENCHMARK {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        ClipboardModel model;
+        QVERIFY( deserializeData(&model, &buffer, itemCount) );
+        QCOMPARE( model.rowCount(), itemCount );
+    }
+}
+
+void Benchmarks::decodeItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::decodeItems()
+{
+    QFETCH(int, itemCount);
+
+    QByteArray bytes = serializedItems(itemCount);
+
+    QBENCHMARK {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::ReadOnly);
+        ClipboardModel model;
+        QVERIFY( deserializeData(&model, &buffer, itemCount) );
+
+        // Items are decoded lazily when accessed.
+        for (int row = 0; row < itemCount; ++row)
+            model.index(row).data(contentType::text);
+    }
+}
+
+void Benchmarks::insertItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::insertItems()
+{
+    QFETCH(int, itemCount);
+
+    const auto items = createItems(itemCount);
+
+    QBENCHMARK {
+        ClipboardModel model;
+        model.insertItems(items, 0);
+    }
+}
+
+void Benchmarks::findItem_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::findItem()
+{
+    QFETCH(int, itemCount);
+
+    const auto items = createItems(itemCount);
+    ClipboardModel model;
+    model.insertItems(items, 0);
+
+    const quint64 lastItemHash = hash(items.last());
+
+    QBENCHMARK {
+        QCOMPARE( model.findItem(lastItemHash), itemCount - 1 );
+    }
+}
+
+void Benchmarks::moveRows_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::moveRows()
+{
+    QFETCH(int, itemCount);
+
+    ClipboardModel model;
+    model.insertItems( createItems(itemCount), 0 );
+
+    QBENCHMARK {
+        // Move the last item to top.
+        QVERIFY( model.moveRows(QModelIndex(), itemCount - 1, 1, QModelIndex(), 0) );
+    }
+}
+
+void Benchmarks::filterItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::filterItems()
+{
+    QFETCH(int, itemCount);
+
+    ItemFactory itemFactory;
+    const auto sharedData = std::make_shared<ClipboardBrowserShared>();
+    sharedData->itemFactory = &itemFactory;
+    sharedData->maxItems = itemCount;
+
+    ClipboardBrowser browser(QString(), sharedData);
+    auto model = qobject_cast<ClipboardModel*>( browser.model() );
+    QVERIFY(model != nullptr);
+    model->insertItems( createItems(itemCount), 0 );
+
+    const QRegExp re("Item 1.*fox", Qt::CaseInsensitive);
+
+    QBENCHMARK {
+        browser.filterItems(re);
+        browser.filterItems(QRegExp());
+    }
+}
+
+void Benchmarks::matchItems_data()
+{
+    addItemCountRows();
+}
+
+void Benchmarks::matchItems()
+{
+    QFETCH(int, itemCount);
+
+    ItemFactory itemFactory;
+    ClipboardModel model;
+    model.insertItems( createItems(itemCount), 0 );
+
+    const QRegExp re("Item 1.*fox", Qt::CaseInsensitive);
+
+    QBENCHMARK {
+        int matchCount = 0;
+        for (int row = 0; row < itemCount; ++row) {
+            if ( itemFactory.matches(model.index(row), re) )
+                ++matchCount;
+        }
+        QVERIFY(matchCount > 0);
+    }
+}
+
+void Benchmarks::scrollItems_data()
+{
+    addBrowserItemCountRows();
+}
+
+void Benchmarks::scrollItems()
+{
+    QFETCH(int, itemCount);
+
+    BrowserFixture fixture(itemCount);
+    QScrollBar *scrollBar = fixture.browser()->verticalScrollBar();
+
+    // Scroll by pages from top to bottom (only part of the list for many items).
+    QBENCHMARK {
+        scrollBar->setValue(0);
+        fixture.render();
+        for (int i = 0; i < 100 && scrollBar->value() < scrollBar->maximum(); ++i) {
+            scrollBar->setValue( scrollBar->value() + scrollBar->pageStep() );
+            fixture.render();
+        }
+    }
+}
+
+void Benchmarks::resizeItems_data()
+{
+    addBrowserItemCountRows();
+}
+
+void Benchmarks::resizeItems()
+{
+    QFETCH(int, itemCount);
+
+    BrowserFixture fixture(itemCount);
+    ClipboardBrowser *browser = fixture.browser();
+
+    QBENCHMARK {
+        browser->resize(300, 600);
+        fixture.render();
+        browser->resize(400, 600);
+        fixture.render();
+    }
+}
+
+void Benchmarks::selectItems_data()
+{
+    addBrowserItemCountRows();
+}
+
+void Benchmarks::selectItems()
+{
+    QFETCH(int, itemCount);
+
+    BrowserFixture fixture(itemCount);
+    ClipboardBrowser *browser = fixture.browser();
+
+    QBENCHMARK {
+        browser->selectAll();
+        fixture.render();
+        browser->clearSelection();
+        fixture.render();
+    }
+}
+
+int runBenchmarks(int argc, char *argv[], const QString &jsonFileName)
+{
+    QApplication app(argc, argv);
+    Q_UNUSED(app);
+
+    const QString session = "copyq.benchmarks";
+    QCoreApplication::setOrganizationName(session);
+    QCoreApplication::setApplicationName(session);
+
+    Benchmarks benchmarks;
+    return execBenchmarks(&benchmarks, argc, argv, jsonFileName);
+}
+
+int execBenchmarks(QObject *benchmarks, int argc, char *argv[], const QString &jsonFileName)
+{
+    if ( jsonFileName.isEmpty() )
+        return QTest::qExec(benchmarks, argc, argv);
+
+    QTemporaryFile xmlFile;
+    if ( !xmlFile.open() ) {
+        log( QString("Failed to create file for benchmark results: %1").arg(xmlFile.errorString()), LogError );
+        return 1;
+    }
+
+    QStringList arguments;
+    for (int i = 0; i < argc; ++i)
+        arguments.append( QString::fromUtf8(argv[i]) );
+    arguments << "-o" << "-,txt" << "-o" << xmlFile.fileName() + ",xml";
+
+    const int exitCode = QTest::qExec(benchmarks, arguments);
+
+    xmlFile.seek(0);
+    if ( !writeBenchmarkResults(&xmlFile, jsonFileName) )
+        return qMax(exitCode, 1);
+
+    return exitCode;
+}
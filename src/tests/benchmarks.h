@@ -0,0 +1,88 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QObject>
+
+class QString;
+
+/**
+ * Benchmarks for performance critical code.
+ *
+ * Unlike Tests, these run in the same process without server.
+ */
+class Benchmarks final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Benchmarks(QObject *parent = nullptr);
+
+private slots:
+    void serializeItems_data();
+    void serializeItems();
+
+    void deserializeItems_data();
+    void deserializeItems();
+
+    void decodeItems_data();
+    void decodeItems();
+
+    void insertItems_data();
+    void insertItems();
+
+    void findItem_data();
+    void findItem();
+
+    void moveRows_data();
+    void moveRows();
+
+    void filterItems_data();
+    void filterItems();
+
+    void matchItems_data();
+    void matchItems();
+
+    void scrollItems_data();
+    void scrollItems();
+
+    void resizeItems_data();
+    void resizeItems();
+
+    void selectItems_data();
+    void selectItems();
+};
+
+/**
+ * Run benchmarks.
+ *
+ * If @a jsonFileName is not empty, results are also written to the file in JSON format.
+ */
+int runBenchmarks(int argc, char *argv[], const QString &jsonFileName);
+
+/**
+ * Run benchmarks in @a benchmarks object (application must be already created).
+ *
+ * If @a jsonFileName is not empty, results are also written to the file in JSON format.
+ */
+int execBenchmarks(QObject *benchmarks, int argc, char *argv[], const QString &jsonFileName);
+
+#endif // BENCHMARKS_H
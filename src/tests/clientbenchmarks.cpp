@@ -0,0 +1,127 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "clientbenchmarks.h"
+
+#include "tests/test_utils.h"
+
+#include <QProcess>
+
+#include <memory>
+#include <vector>
+
+ClientBenchmarks::ClientBenchmarks(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+void ClientBenchmarks::initTestCase()
+{
+    TEST(m_test->initTestCase());
+}
+
+void ClientBenchmarks::cleanupTestCase()
+{
+    TEST(m_test->cleanupTestCase());
+}
+
+void ClientBenchmarks::init()
+{
+    TEST(m_test->init());
+
+    // Avoid keeping many large items in memory.
+    RUN("config" << "maxitems" << "10", "10\n");
+    RUN("add" << "A", "");
+}
+
+void ClientBenchmarks::cleanup()
+{
+    TEST( m_test->cleanup() );
+}
+
+void ClientBenchmarks::command_data()
+{
+    QTest::addColumn<QStringList>("arguments");
+
+    QTest::newRow("size") << QStringList("size");
+    QTest::newRow("read") << (QStringList() << "read" << "0");
+    QTest::newRow("eval") << (QStringList() << "eval" << "1");
+    // Many calls to server from single client.
+    QTest::newRow("batched 100 calls")
+            << (QStringList() << "eval" << "for (var i = 0; i < 100; ++i) size()");
+}
+
+void ClientBenchmarks::command()
+{
+    QFETCH(QStringList, arguments);
+
+    QBENCHMARK {
+        QCOMPARE( m_test->run(arguments), 0 );
+    }
+}
+
+void ClientBenchmarks::write_data()
+{
+    QTest::addColumn<int>("size");
+
+    QTest::newRow("1KB") << 1024;
+    QTest::newRow("1MB") << 1024 * 1024;
+    QTest::newRow("100MB") << 100 * 1024 * 1024;
+}
+
+void ClientBenchmarks::write()
+{
+    QFETCH(int, size);
+
+    const QByteArray data(size, 'x');
+
+    QBENCHMARK {
+        QCOMPARE( m_test->run(Args() << "write" << "text/plain" << "-", nullptr, nullptr, data), 0 );
+    }
+}
+
+void ClientBenchmarks::concurrentClients_data()
+{
+    QTest::addColumn<int>("clientCount");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("4") << 4;
+    QTest::newRow("16") << 16;
+}
+
+void ClientBenchmarks::concurrentClients()
+{
+    QFETCH(int, clientCount);
+
+    QBENCHMARK {
+        std::vector<std::unique_ptr<QProcess>> clients;
+        for (int i = 0; i < clientCount; ++i) {
+            clients.emplace_back(new QProcess);
+            QVERIFY( m_test->startClient(clients.back().get(), Args() << "read" << "0") );
+            clients.back()->closeWriteChannel();
+        }
+
+        for (auto &client : clients) {
+            QVERIFY( client->waitForFinished(30000) );
+            QCOMPARE( client->exitCode(), 0 );
+        }
+    }
+}
@@ -0,0 +1,239 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "stresstests.h"
+
+#include "common/mimetypes.h"
+#include "tests/test_utils.h"
+
+#include <QClipboard>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QMimeData>
+#include <QRegExp>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+
+namespace {
+
+const int waitForChangesMs = 60000;
+
+/// Mostly small texts, some larger ones and rarely data of megabyte size.
+QMimeData *createStressData(int i)
+{
+    const int size = i % 100 == 0 ? 1024 * 1024
+                   : i % 10 == 0 ? 10 * 1024
+                   : 32;
+    QByteArray text = "STRESS " + QByteArray::number(i) + " ";
+    text.append( QByteArray(qMax(0, size - text.size()), 'x') );
+
+    auto data = new QMimeData();
+    data->setData(mimeText, text);
+    if (i % 3 == 0)
+        data->setData(mimeHtml, "<b>" + text + "</b>");
+    return data;
+}
+
+void setClipboard(QMimeData *data)
+{
+    QGuiApplication::clipboard()->setMimeData(data);
+    // Provide data to clipboard monitor.
+    QCoreApplication::processEvents();
+}
+
+void printResult(const QString &name, qint64 value, const QString &unit)
+{
+    QTextStream out(stdout);
+    out << "STRESS " << QTest::currentTestFunction();
+    if ( QTest::currentDataTag() )
+        out << ":" << QTest::currentDataTag();
+    out << ": " << name << ": " << value << " " << unit << "\n";
+}
+
+qint64 percentile(QVector<qint64> values, int p)
+{
+    if ( values.isEmpty() )
+        return 0;
+
+    std::sort( values.begin(), values.end() );
+    const int i = qMin( values.size() - 1, values.size() * p / 100 );
+    return values[i];
+}
+
+qint64 metricValue(const QByteArray &metrics, const QString &name)
+{
+    QRegExp re("(?:^|\n)" + QRegExp::escape(name) + " (\\d+)");
+    if ( re.indexIn(QString::fromUtf8(metrics)) == -1 )
+        return 0;
+    return re.cap(1).toLongLong();
+}
+
+} // namespace
+
+StressTests::StressTests(const TestInterfacePtr &test, QObject *parent)
+    : QObject(parent)
+    , m_test(test)
+{
+}
+
+void StressTests::initTestCase()
+{
+    TEST(m_test->initTestCase());
+}
+
+void StressTests::cleanupTestCase()
+{
+    TEST(m_test->cleanupTestCase());
+}
+
+void StressTests::init()
+{
+    TEST(m_test->init());
+
+    RUN("config" << "maxitems" << "10000", "10000\n");
+
+    // Automatic command is run for each change.
+    RUN("setCommands([{automatic: true, input: 'text/plain', cmd: 'copyq: setData(\"application/x-copyq-stress\", \"1\")'}])", "");
+}
+
+void StressTests::cleanup()
+{
+    TEST( m_test->cleanup() );
+}
+
+void StressTests::clipboardFlood_data()
+{
+    QTest::addColumn<int>("changeCount");
+    QTest::addColumn<int>("intervalMs");
+
+    QTest::newRow("1k changes") << 1000 << 0;
+    QTest::newRow("1k changes, 1ms apart") << 1000 << 1;
+    QTest::newRow("200 changes, 10ms apart") << 200 << 10;
+}
+
+void StressTests::clipboardFlood()
+{
+    QFETCH(int, changeCount);
+    QFETCH(int, intervalMs);
+
+    const qint64 residentKbBefore = serverResidentKb();
+
+    // Probe server responsiveness while changing clipboard.
+    const int probeEvery = qMax(1, changeCount / 20);
+    QVector<qint64> roundTripMs;
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (int i = 0; i < changeCount; ++i) {
+        setClipboard( createStressData(i) );
+
+        if (intervalMs > 0) {
+            QElapsedTimer wait;
+            wait.start();
+            while ( wait.elapsed() < intervalMs )
+                QCoreApplication::processEvents();
+        }
+
+        if (i % probeEvery == 0)
+            roundTripMs.append( clientRoundTripMs() );
+    }
+    const qint64 floodMs = elapsed.elapsed();
+
+    // Wait for the last change to be stored.
+    const QByteArray lastText = "STRESS " + QByteArray::number(changeCount - 1) + " ";
+    SleepTimer t(waitForChangesMs);
+    QByteArray top;
+    do {
+        top = clientOutput(Args() << "read" << "0").left(lastText.size());
+    } while (top != lastText && t.sleep());
+    const qint64 drainMs = elapsed.elapsed() - floodMs;
+    QCOMPARE( top, lastText );
+
+    const QByteArray metrics = clientOutput(Args() << "info" << "metrics");
+    const qint64 received = metricValue(metrics, "copyq_clipboard_changes_total");
+    const qint64 residentKbAfter = serverResidentKb();
+
+    printResult("changes", changeCount, "");
+    printResult("changes received", received, "");
+    printResult("changes dropped or coalesced", changeCount - received, "");
+    printResult("flood time", floodMs, "ms");
+    printResult("time to store last change", drainMs, "ms");
+    printResult("client round-trip p50", percentile(roundTripMs, 50), "ms");
+    printResult("client round-trip p90", percentile(roundTripMs, 90), "ms");
+    printResult("client round-trip max", percentile(roundTripMs, 100), "ms");
+    printResult("server memory growth", residentKbAfter - residentKbBefore, "kB");
+}
+
+void StressTests::clipboardLatency()
+{
+    // Latency from clipboard change to stored item (measured by polling).
+    QVector<qint64> latencyMs;
+    for (int i = 0; i < 50; ++i) {
+        const QByteArray text = "LATENCY " + QByteArray::number(i);
+        auto data = new QMimeData();
+        data->setData(mimeText, text);
+
+        QElapsedTimer elapsed;
+        elapsed.start();
+        setClipboard(data);
+
+        SleepTimer t(waitForChangesMs);
+        QByteArray top;
+        do {
+            top = clientOutput(Args() << "read" << "0");
+        } while (top != text && t.sleep());
+        QCOMPARE(top, text);
+
+        latencyMs.append( elapsed.elapsed() );
+    }
+
+    printResult("change to stored p50", percentile(latencyMs, 50), "ms");
+    printResult("change to stored p90", percentile(latencyMs, 90), "ms");
+    printResult("change to stored p99", percentile(latencyMs, 99), "ms");
+    printResult("change to stored max", percentile(latencyMs, 100), "ms");
+}
+
+QByteArray StressTests::clientOutput(const QStringList &arguments)
+{
+    QByteArray out;
+    m_test->run(arguments, &out);
+    return out;
+}
+
+qint64 StressTests::serverResidentKb()
+{
+    // See "VmRSS" in "copyq info memory" (available only on Linux).
+    const QByteArray memory = clientOutput(Args() << "info" << "memory");
+    QRegExp re("VmRSS: (\\d+) kB");
+    if ( re.indexIn(QString::fromUtf8(memory)) == -1 )
+        return 0;
+    return re.cap(1).toLongLong();
+}
+
+qint64 StressTests::clientRoundTripMs()
+{
+    QElapsedTimer elapsed;
+    elapsed.start();
+    clientOutput(Args() << "eval" << "1");
+    return elapsed.elapsed();
+}
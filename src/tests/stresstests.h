@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2019, Lukas Holecek <hluk@email.cz>
+
+    This file is part of CopyQ.
+
+    CopyQ is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    CopyQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with CopyQ.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef STRESSTESTS_H
+#define STRESSTESTS_H
+
+#include "tests/testinterface.h"
+
+#include <QObject>
+
+class QByteArray;
+
+/**
+ * Stress tests for clipboard monitor and server pipeline.
+ *
+ * Clipboard is changed quickly with data of mixed sizes and formats
+ * while automatic commands are enabled. Dropped changes, latency, memory
+ * growth of server and client round-trip times (GUI thread stalls) are
+ * printed to standard output.
+ */
+class StressTests final : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StressTests(const TestInterfacePtr &test, QObject *parent = nullptr);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+
+    void clipboardFlood_data();
+    void clipboardFlood();
+
+    void clipboardLatency();
+
+private:
+    QByteArray clientOutput(const QStringList &arguments);
+    qint64 serverResidentKb();
+    qint64 clientRoundTripMs();
+
+    TestInterfacePtr m_test;
+};
+
+#endif // STRESSTESTS_H
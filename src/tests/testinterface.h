@@ -27,6 +27,8 @@
 
 #include <memory>
 
+class QProcess;
+
 /**
  * Interface for tests.
  */
@@ -62,6 +64,9 @@ public:
                     QByteArray *stderrData = nullptr, const QByteArray &in = QByteArray(),
                     const QStringList &environment = QStringList()) = 0;
 
+    /// Start client with given @a arguments without waiting for it to finish.
+    virtual bool startClient(QProcess *process, const QStringList &arguments) = 0;
+
     /// Run client with given @a arguments and read all errors/warnings.
     virtual QByteArray runClient(const QStringList &arguments, const QByteArray &stdoutExpected,
                                  const QByteArray &input = QByteArray()) = 0;
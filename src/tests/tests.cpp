@@ -19,6 +19,9 @@
 
 #include "tests.h"
 #include "test_utils.h"
+#include "tests/benchmarks.h"
+#include "tests/clientbenchmarks.h"
+#include "tests/stresstests.h"
 
 #include "common/appconfig.h"
 #include "common/client_server.h"
@@ -29,14 +32,19 @@
 #include "common/shortcuts.h"
 #include "common/textdata.h"
 #include "common/version.h"
+#include "item/clipboardmodel.h"
 #include "item/itemfactory.h"
+#include "item/itemjournal.h"
+#include "item/itemstore.h"
 #include "item/itemwidget.h"
 #include "item/serialize.h"
 #include "gui/configtabshortcuts.h"
 #include "gui/tabicons.h"
 #include "platform/platformnativeinterface.h"
 
+#include <QBuffer>
 #include <QClipboard>
+#include <QDataStream>
 #include <QDebug>
 #include <QDir>
 #include <QElapsedTimer>
@@ -327,6 +335,11 @@ public:
                 + readServerErrors(ReadAllStderr);
     }
 
+    bool startClient(QProcess *process, const QStringList &arguments) override
+    {
+        return startTestProcess(process, arguments);
+    }
+
     QByteArray runClient(const QStringList &arguments, const QByteArray &stdoutExpected,
                          const QByteArray &input = QByteArray()) override
     {
@@ -462,6 +475,22 @@ public:
         // Omit using dangerous QDir::removeRecursively().
         for ( const auto &fileName : settingsDir.entryList(settingsFileFilters) ) {
             const auto path = settingsDir.absoluteFilePath(fileName);
+
+            // Remove directory with item data shared by tabs.
+            if ( QFileInfo(path).isDir() ) {
+                QDir dataDir(path);
+                for ( const auto &dataFileName : dataDir.entryList(QDir::Files) ) {
+                    if ( !dataDir.remove(dataFileName) ) {
+                        return QString("Failed to remove item data file \"%1\"")
+                            .arg(dataDir.absoluteFilePath(dataFileName))
+                            .toUtf8();
+                    }
+                }
+                if ( !settingsDir.rmdir(fileName) )
+                    return QString("Failed to remove directory \"%1\"").arg(path).toUtf8();
+                continue;
+            }
+
             QFile settingsFile(path);
             if ( !settingsFile.remove() ) {
                 return QString("Failed to remove settings file \"%1\": %2")
@@ -601,6 +630,61 @@ QString keyNameFor(QKeySequence::StandardKey standardKey)
     return QKeySequence(standardKey).toString();
 }
 
+/// Return path to file with saved items of a tab.
+QString itemFilePath(const QString &tabName)
+{
+    QString part( tabName.toUtf8().toBase64() );
+    part.replace( QChar('/'), QString('-') );
+    return getConfigurationFilePath("_tab_") + part + QString(".dat");
+}
+
+/// Return path to journal file with changes of saved items of a tab.
+QString itemJournalFilePath(const QString &tabName)
+{
+    return itemFilePath(tabName) + ".log";
+}
+
+/// Return texts of all items in model separated by comma.
+QString itemTexts(const ClipboardModel &model)
+{
+    QStringList texts;
+    for (int row = 0; row < model.rowCount(); ++row)
+        texts.append( model.data(model.index(row, 0), contentType::text).toString() );
+    return texts.join(',');
+}
+
+/// Generate text which cannot be compressed much.
+QByteArray generateIncompressibleData(int size)
+{
+    QByteArray bytes;
+    bytes.reserve(size);
+    for (int i = 0; i < size; ++i)
+        bytes.append( static_cast<char>(qrand() % 256) );
+    return bytes.toBase64().left(size);
+}
+
+/// Add items with small, compressible and binary data to model.
+void createTestItems(ClipboardModel *model)
+{
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("A") );
+    model->insertItem(data, 0);
+
+    data.insert( mimeText, QByteArray(10000, 'x') );
+    data.insert( "image/png", generateIncompressibleData(1000) );
+    model->insertItem(data, 0);
+
+    data.clear();
+    data.insert( mimeHtml, QByteArray("<b>C</b>") );
+    model->insertItem(data, 0);
+
+    for (int row = 0; row < model->rowCount(); ++row) {
+        const QModelIndex index = model->index(row, 0);
+        const qint64 createdTime = model->data(index, contentType::createdTime).toLongLong();
+        model->setData( index, createdTime + 1000 * (row + 1), contentType::lastUsedTime );
+    }
+}
+
 } // namespace
 
 Tests::Tests(const TestInterfacePtr &test, QObject *parent)
@@ -736,6 +820,18 @@ void Tests::commandEvalArguments()
         "Test 1, Test 2\n");
 }
 
+void Tests::commandEvalLines()
+{
+    const QByteArray input = "1\n'TEST'\n\nprint('X')\n";
+    const QByteArray output("1\n\0TEST\n\0\0X\0", 12);
+    TEST( m_test->runClient(Args("evalLines"), output, input) );
+
+    // Variables declared in a line are not visible in following lines.
+    const QByteArray input2 = "var x = 1\ntypeof x\n";
+    const QByteArray output2("\0undefined\n\0", 12);
+    TEST( m_test->runClient(Args("evalLines"), output2, input2) );
+}
+
 void Tests::commandPrint()
 {
     RUN("print" << "1", "1");
@@ -853,6 +949,23 @@ void Tests::commandsAddRead()
     RUN("read" << "3", "A");
 }
 
+void Tests::commandsAddMany()
+{
+    const auto script = R"(
+        var items = [];
+        for (var i = 0; i < 100; ++i)
+            items.push('item' + i);
+        add.apply(this, items);
+        )";
+    RUN("eval" << script, "");
+    RUN("size", "100\n");
+    RUN("read" << "0" << "1" << "99", "item99\nitem98\nitem0");
+
+    RUN("insert" << "1" << "X" << "Y", "");
+    RUN("size", "102\n");
+    RUN("read" << "0" << "1" << "2" << "3", "item99\nY\nX\nitem98");
+}
+
 void Tests::commandsWriteRead()
 {
     const QByteArray input("\x00\x01\x02\x03\x04", 5);
@@ -1073,12 +1186,51 @@ void Tests::commandsGetSetItem()
     RUN(args << "eval" << "print(getitem(1)['text/html'])", "<b>HTML text 2</b>");
 }
 
+void Tests::commandsGetItems()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab;
+    RUN(args << "add" << "C" << "B" << "A", "");
+    RUN(args << "write" << "0" << "text/plain" << "D" << "text/html" << "<b>D</b>", "");
+
+    RUN(args << "eval" << "getItems().length", "4\n");
+    RUN(args << "eval" << "getItems(2).length", "2\n");
+    RUN(args << "eval" << "getItems(1, 2).map(function(item) { return str(item[mimeText]) })", "A\nB\n");
+    RUN(args << "eval" << "getItems(10).length", "0\n");
+    RUN(args << "eval" << "Object.keys(getItems(0, 1, mimeHtml)[0])", "text/html\n");
+}
+
+void Tests::commandSnapshot()
+{
+    const QString tab1 = testTab(1);
+    const QString tab2 = testTab(2);
+    RUN("tab" << tab1 << "add" << "B" << "A", "");
+    RUN("tab" << tab2 << "add" << "C", "");
+
+    const QString script = QString(
+        "var tabs = snapshot('%1', '%2');"
+        "print(tabs['%1'].map(function(item) { return str(item[mimeText]) }) + ';' + tabs['%2'].length)"
+    ).arg(tab1, tab2);
+    RUN(script, "A,B;1");
+
+    RUN("tab" << tab1 << "eval" << "snapshot()['" + tab1 + "'].length", "2\n");
+}
+
 void Tests::commandsChecksums()
 {
     RUN("md5sum" << "TEST", "033bd94b1168d7e4f0d644c3c95e35bf\n");
     RUN("sha1sum" << "TEST", "984816fd329622876e14907634264e6f332e9fb3\n");
     RUN("sha256sum" << "TEST", "94ee059335e587e501cc4bf90613e0814f00a7b08bc7c648fd865a2af6a22cc2\n");
     RUN("sha512sum" << "TEST", "7bfa95a688924c47c7d22381f20cc926f524beacb13f84e203d4bd8cb6ba2fce81c57a5f059bf3d509926487bde925b3bcee0635e4f7baeba054e5dba696b2bf\n");
+
+    // Checksum of item data.
+    RUN("add" << "TEST", "");
+    RUN("md5sum" << "0" << "text/plain", "033bd94b1168d7e4f0d644c3c95e35bf\n");
+    RUN("sha1sum" << "0" << "text/plain", "984816fd329622876e14907634264e6f332e9fb3\n");
+
+    // Item hash can be used to find the item.
+    RUN("eval" << "findItem(itemHash(0))[0].row", "0\n");
+    RUN("eval" << "itemHash(0) == searchAllTabs(/^TEST$/)[0].hash", "true\n");
 }
 
 void Tests::commandEscapeHTML()
@@ -1302,6 +1454,62 @@ void Tests::commandsExportImport()
     RUN("tab" << tab2 << "read" << "0", "1");
 }
 
+void Tests::commandsExportImportIncremental()
+{
+    const auto tab = testTab(1);
+    const auto args = Args("tab") << tab;
+    RUN(args << "add" << "B" << "A", "");
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto fullFileName = dir.path() + "/full.cpq";
+    const auto incrementalFileName = dir.path() + "/incremental.cpq";
+
+    RUN("exportData" << fullFileName, "");
+
+    RUN(args << "add" << "C", "");
+    RUN("exportData" << incrementalFileName << fullFileName, "");
+
+    RUN("removetab" << tab, "");
+    RUN("importData" << incrementalFileName, "");
+    RUN(args << "read" << "0" << "1" << "2", "C\nA\nB");
+
+    // Export cannot overwrite its base or files the base depends on.
+    RUN_EXPECT_ERROR("exportData" << fullFileName << fullFileName, CommandException);
+    RUN_EXPECT_ERROR("exportData" << fullFileName << incrementalFileName, CommandException);
+    RUN("removetab" << tab, "");
+    RUN("importData" << incrementalFileName, "");
+    RUN(args << "read" << "0" << "1" << "2", "C\nA\nB");
+
+    // Import fails without base export.
+    QVERIFY( QFile::remove(fullFileName) );
+    RUN("removetab" << tab, "");
+    RUN_EXPECT_ERROR("importData" << incrementalFileName, CommandException);
+}
+
+void Tests::commandsImportDataMerge()
+{
+    const auto tab = testTab(1);
+    const auto args = Args("tab") << tab;
+    RUN(args << "add" << "C" << "B" << "A", "");
+
+    QTemporaryFile tmp;
+    QVERIFY(tmp.open());
+    tmp.close();
+    const auto fileName = tmp.fileName();
+    RUN("exportData" << fileName, "");
+
+    RUN(args << "remove" << "1", "");
+    RUN(args << "add" << "D", "");
+    RUN(args << "read" << "0" << "1" << "2", "D\nA\nC");
+
+    RUN("importData" << fileName << "merge", "");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "B\nD\nA\nC");
+    RUN(args << "size", "4\n");
+
+    RUN_EXPECT_ERROR("importData" << fileName << "xxx", CommandException);
+}
+
 void Tests::commandsGetSetCommands()
 {
     RUN("commands().length", "0\n");
@@ -1338,6 +1546,8 @@ void Tests::commandsImportExportCommands()
 void Tests::commandScreenshot()
 {
     RUN("screenshot().size() > 0", "true\n")
+    RUN("screenshot('png:100').size() > 0", "true\n")
+    RUN("screenshot('bmp').size() > 0", "true\n")
 }
 
 void Tests::commandNotification()
@@ -1474,6 +1684,18 @@ void Tests::classByteArray()
 void Tests::classFile()
 {
     RUN("var f = new File('/copyq_missing_file'); f.exists()", "false\n");
+
+    // Store file content in item.
+    RUN("var f = new TemporaryFile(); f.open(); f.write('TEST'); f.close()"
+        "; write(0, 'text/plain', f); str(read(0))", "TEST\n");
+    RUN_EXPECT_ERROR("write(0, 'text/plain', new File('/copyq_missing_file'))", CommandException);
+
+    // Data written to file but not yet flushed are stored too.
+    RUN("var f = new TemporaryFile(); f.open(); f.write('TEST2')"
+        "; write(0, 'text/plain', f); str(read(0))", "TEST2\n");
+
+    RUN_EXPECT_ERROR("copy('text/plain', new File('/copyq_missing_file'))", CommandException);
+    RUN_EXPECT_ERROR("setData('text/plain', new File('/copyq_missing_file'))", CommandException);
 }
 
 void Tests::classDir()
@@ -1786,6 +2008,75 @@ void Tests::moveItems()
     RUN(args << "testSelected", tab + " 1 0 1\n");
 }
 
+void Tests::sortItems()
+{
+    const auto args = Args() << "separator" << " ";
+    RUN(args << "add" << "ccc" << "a" << "bb" << "d", "");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "d bb a ccc");
+
+    RUN(args << "sortItems" << "text", "");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "a bb ccc d");
+
+    RUN(args << "sortItems" << "length" << "1" << "2" << "3", "");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "a d bb ccc");
+
+    RUN_EXPECT_ERROR_WITH_STDERR("sortItems" << "xxx", CommandException, "xxx");
+}
+
+void Tests::searchAllTabs()
+{
+    const auto tab1 = testTab(1);
+    RUN("tab" << tab1 << "add" << "xyz" << "abc x" << "x abc", "");
+    const auto tab2 = testTab(2);
+    RUN("tab" << tab2 << "add" << "abc" << "other", "");
+
+    const auto script = QString(
+            "searchAllTabs(/abc/%1).map(function(hit){ return hit.tab + ':' + hit.row }).join(',')");
+    RUN("eval" << script.arg(""), tab1 + ":1," + tab2 + ":1," + tab1 + ":0\n");
+    RUN("eval" << script.arg(", 1, 1"), tab2 + ":1\n");
+}
+
+void Tests::findItem()
+{
+    const auto tab1 = testTab(1);
+    RUN("tab" << tab1 << "add" << "abc" << "xyz", "");
+    const auto tab2 = testTab(2);
+    RUN("tab" << tab2 << "add" << "xyz" << "other", "");
+
+    const auto script = QString(
+            "findItem(searchAllTabs(/^%1$/)[0].hash)"
+            ".map(function(hit){ return hit.tab + ':' + hit.row }).join(',')");
+    RUN("eval" << script.arg("xyz"), tab1 + ":0," + tab2 + ":1\n");
+    RUN("eval" << script.arg("abc"), tab1 + ":1\n");
+
+    RUN("eval" << "findItem('ffff').length", "0\n");
+    RUN_EXPECT_ERROR("findItem" << "xxx", CommandException);
+}
+
+void Tests::transaction()
+{
+    const auto tab = testTab(1);
+    const auto args = Args("tab") << tab << "separator" << ",";
+
+    const auto script =
+            "transaction(function() {"
+            "  for (var i = 0; i < 5; ++i) add(i);"
+            "  remove(1);"
+            "  return size();"
+            "})";
+    RUN(args << "eval" << script, "4\n");
+    RUN(args << "read" << "0" << "1" << "2" << "3", "4,2,1,0");
+
+    // Transaction is finished even if function throws.
+    RUN_EXPECT_ERROR_WITH_STDERR(
+        args << "eval" << "transaction(function() { add('X'); throw 'TEST ERROR'; })",
+        CommandException, "TEST ERROR");
+    RUN(args << "read" << "0", "X");
+    RUN(args << "add" << "Y" << "size", "6\n");
+
+    RUN_EXPECT_ERROR("transaction" << "1", CommandException);
+}
+
 void Tests::deleteItems()
 {
     const auto tab = QString(clipboardTabName);
@@ -1809,6 +2100,38 @@ void Tests::searchItems()
     RUN("testSelected", QString(clipboardTabName) + " 1 1\n");
 }
 
+void Tests::searchItemsIncrementally()
+{
+    RUN("add" << "abc" << "ab" << "a" << "xb", "");
+
+    // Narrow filter by typing, then widen it by removing characters.
+    RUN("keys" << ":abx" << "BACKSPACE" << "BACKSPACE" << "TAB" << "CTRL+A", "");
+    RUN("testSelected", QString(clipboardTabName) + " 1 1 2 3\n");
+}
+
+void Tests::searchItemsWithTextIndex()
+{
+    const auto tab = QString(clipboardTabName);
+    RUN("add" << "world" << "Say HELLO" << "hello world", "");
+
+    RUN("keys" << ":hello" << "TAB" << "CTRL+A", "");
+    RUN("testSelected", tab + " 0 0 1\n");
+
+    // Index is updated when item changes.
+    RUN("change" << "2" << "text/plain" << "Hello again", "");
+    RUN("keys" << "ESCAPE" << ":hello" << "TAB" << "CTRL+A", "");
+    RUN("testSelected", tab + " 0 0 1 2\n");
+}
+
+void Tests::searchItemsInBackground()
+{
+    // Items in big tabs are matched in background.
+    RUN("eval" << "var items = []; for (var i = 0; i < 2500; ++i) items.push('item ' + i); add.apply(this, items)", "");
+
+    RUN("keys" << ":item 1234", "");
+    WAIT_ON_OUTPUT("testSelected", QString(clipboardTabName) + " 1265 1265\n");
+}
+
 void Tests::searchRowNumber()
 {
     RUN("add" << "d2" << "c" << "b2" << "a", "");
@@ -1932,6 +2255,30 @@ void Tests::toggleClipboardMonitoring()
     WAIT_ON_OUTPUT("read" << "0", data3);
 }
 
+void Tests::ignoredWindows()
+{
+    const QByteArray data1 = generateData();
+    TEST( m_test->setClipboard(data1) );
+    WAIT_ON_OUTPUT("read" << "0", data1);
+
+    // Ignore clipboard changes from any window.
+    RUN("config" << "ignored_windows" << ".*", ".*\n");
+    waitFor(waitMsSetClipboard);
+
+    const QByteArray data2 = generateData();
+    TEST( m_test->setClipboard(data2) );
+    RUN("clipboard", data2);
+    waitFor(waitMsSetClipboard);
+    RUN("read" << "0", data1);
+
+    RUN("config" << "ignored_windows" << "", "\n");
+    waitFor(waitMsSetClipboard);
+
+    const QByteArray data3 = generateData();
+    TEST( m_test->setClipboard(data3) );
+    WAIT_ON_OUTPUT("read" << "0", data3);
+}
+
 void Tests::clipboardToItem()
 {
     TEST( m_test->setClipboard("TEXT1") );
@@ -2023,6 +2370,693 @@ void Tests::tabIcon()
     RUN("tabicon" << tab, "\n");
 }
 
+void Tests::tabExpiry()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << ",";
+
+    RUN(args << "add" << "B" << "A", "");
+    RUN("tabExpiry" << tab, "0\n");
+    RUN("tabexpiry" << tab << "30", "");
+    RUN("tabExpiry" << tab, "30\n");
+
+    // Recently added items are kept.
+    RUN(args << "read" << "0" << "1", "A,B");
+
+    const QString tab2 = testTab(2);
+    RUN("renameTab" << tab << tab2, "");
+    RUN("tabExpiry" << tab2, "30\n");
+    RUN("tabExpiry" << tab, "0\n");
+
+    RUN("tabExpiry" << tab2 << "0", "");
+    RUN("tabExpiry" << tab2, "0\n");
+
+    RUN_EXPECT_ERROR("tabExpiry" << tab2 << "-1", CommandException);
+}
+
+void Tests::tabJournal()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << ",";
+
+    // New tab is saved completely.
+    RUN(args << "add" << "C", "");
+    TEST( m_test->stopServer() );
+    QVERIFY( QFile::exists(itemFilePath(tab)) );
+    QVERIFY( !QFile::exists(itemJournalFilePath(tab)) );
+
+    // Changes in saved tab are appended to journal.
+    TEST( m_test->startServer() );
+    RUN(args << "add" << "B" << "A", "");
+    TEST( m_test->stopServer() );
+    QVERIFY( QFile::exists(itemJournalFilePath(tab)) );
+
+    TEST( m_test->startServer() );
+    RUN(args << "read" << "0" << "1" << "2", "A,B,C");
+
+    // Replayed journal is appended to.
+    RUN(args << "remove" << "1", "");
+    RUN(args << "change" << "0" << "text/plain" << "X", "");
+    RUN(args << "insert" << "1" << "Y", "");
+    RUN("setCurrentTab" << tab, "");
+    RUN(args << "selectItems" << "2", "true\n");
+    RUN(args << "keys" << clipboardBrowserId << "CTRL+HOME", "");
+    RUN(args << "read" << "0" << "1" << "2", "C,X,Y");
+
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "size", "3\n");
+    RUN(args << "read" << "0" << "1" << "2", "C,X,Y");
+}
+
+void Tests::tabJournalOutdated()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << ",";
+
+    RUN(args << "add" << "A", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "add" << "B", "");
+    TEST( m_test->stopServer() );
+
+    // Change size of tab file stored in journal header (after 32-bit magic number).
+    QFile journalFile( itemJournalFilePath(tab) );
+    QVERIFY( journalFile.open(QIODevice::ReadWrite) );
+    QVERIFY( journalFile.seek(4 + 7) );
+    char c;
+    QVERIFY( journalFile.getChar(&c) );
+    QVERIFY( journalFile.seek(4 + 7) );
+    QVERIFY( journalFile.putChar(static_cast<char>(c + 1)) );
+    journalFile.close();
+
+    // Journal created for different tab file is ignored.
+    TEST( m_test->startServer() );
+    RUN(args << "size", "1\n");
+    RUN(args << "read" << "0", "A");
+
+    // Outdated journal is replaced.
+    RUN(args << "add" << "C", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "read" << "0" << "1" << "2", "C,A,");
+}
+
+void Tests::tabJournalIncompleteBlock()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << ",";
+
+    RUN(args << "add" << "A", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "add" << "B", "");
+    TEST( m_test->stopServer() );
+
+    // Simulate crash while writing the last journal block.
+    QFile journalFile( itemJournalFilePath(tab) );
+    QVERIFY( journalFile.resize(journalFile.size() - 1) );
+
+    TEST( m_test->startServer() );
+    RUN(args << "size", "1\n");
+    RUN(args << "read" << "0", "A");
+
+    // Changes appended after the incomplete block are not lost.
+    RUN(args << "add" << "C", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "read" << "0" << "1" << "2", "C,A,");
+}
+
+void Tests::tabJournalCompaction()
+{
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab << "separator" << ",";
+
+    // Store big data in tab file instead of separate files.
+    RUN("config" << "item_data_threshold" << "0", "0\n");
+
+    RUN(args << "add" << "A", "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN(args << "add" << "B", "");
+    TEST( m_test->stopServer() );
+
+    const QString journalFileName = itemJournalFilePath(tab);
+    QVERIFY( QFile::exists(journalFileName) );
+    const qint64 tabFileSize = QFileInfo( itemFilePath(tab) ).size();
+
+    // All items are saved instead of appending big changes to journal.
+    TEST( m_test->startServer() );
+    const QByteArray data = generateIncompressibleData(2 * 1024 * 1024);
+    RUN_WITH_INPUT(args << "add" << "-", "", data);
+    TEST( m_test->stopServer() );
+    QVERIFY( !QFile::exists(journalFileName) );
+    QVERIFY( QFileInfo(itemFilePath(tab)).size() > tabFileSize );
+
+    TEST( m_test->startServer() );
+    RUN(args << "size", "3\n");
+    RUN(args << "read" << "1" << "2", "B,A");
+    RUN(args << "read(0).size()", QByteArray::number(data.size()) + "\n");
+}
+
+void Tests::tabBackgroundSave()
+{
+    // Store big data in tab file so saving takes a while.
+    RUN("config" << "item_data_threshold" << "0", "0\n");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    const QString tab = testTab(1);
+    const Args args = Args("tab") << tab;
+
+    const QByteArray data = generateIncompressibleData(512 * 1024);
+    RUN_WITH_INPUT(args << "eval" << "var data = input(); for (var i = 0; i < 8; ++i) add(data)", "", data);
+    RUN(args << "add" << "A", "");
+
+    // Pasting items saves the tab immediately in background.
+    TEST( m_test->setClipboard("B") );
+    RUN("setCurrentTab" << tab, "");
+    RUN("keys" << clipboardBrowserId << keyNameFor(QKeySequence::Paste), "");
+
+    // Items change while previous changes are being saved.
+    RUN(args << "add" << "C", "");
+    RUN(args << "eval" << "remove(size() - 1)", "");
+
+    const QString script =
+            "var items = [];"
+            "for (var i = 0; i < size(); ++i)"
+            "  items.push(read(i).size() < 100 ? str(read(i)) : 'D');"
+            "items.join(',')";
+    QByteArray items;
+    TEST( m_test->getClientOutput(args << "eval" << script, &items) );
+    QCOMPARE( items.count('D'), 7 );
+    QVERIFY( items.contains('A') );
+    QVERIFY( items.contains('B') );
+    QVERIFY( items.contains('C') );
+
+    // Exit waits for the running save and saves the latest changes.
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    QByteArray savedItems;
+    TEST( m_test->getClientOutput(args << "eval" << script, &savedItems) );
+    QCOMPARE( savedItems, items );
+    RUN(args << "read(size() - 1).size()", QByteArray::number(data.size()) + "\n");
+}
+
+void Tests::itemHashesCountedLazily()
+{
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("A") );
+    ClipboardModel referenceModel;
+    referenceModel.insertItem(data, 0);
+    const quint64 hash = referenceModel.data(referenceModel.index(0, 0), contentType::hash).toULongLong();
+
+    // Item loaded without stored hash is not decoded when added.
+    SerializedItemData serializedData = serializeItemData(data, 0);
+    serializedData.hash = 0;
+    ClipboardModel model;
+    model.insertItems( QVariantList() << QVariant::fromValue(serializedData), 0 );
+    QVERIFY( !model.itemsSnapshot().value(0).isDataDecoded() );
+
+    // Hashes are computed once an item needs to be found.
+    QCOMPARE( model.findItem(hash), 0 );
+    QCOMPARE( model.findItems(hash), QVector<int>() << 0 );
+    QCOMPARE( model.findItem(hash + 1), -1 );
+}
+
+void Tests::tabJournalTabFileHash()
+{
+    // Tab files differ only after the first few kilobytes.
+    QByteArray tabData(10000, 'x');
+    QBuffer tabFile(&tabData);
+    QVERIFY( tabFile.open(QIODevice::ReadOnly) );
+
+    QBuffer journalFile;
+    QVERIFY( journalFile.open(QIODevice::ReadWrite) );
+    writeItemJournalHeader(&journalFile, &tabFile);
+
+    QVERIFY( journalFile.seek(0) );
+    QVERIFY( isItemJournalValid(&journalFile, &tabFile) );
+
+    QByteArray otherTabData = tabData;
+    otherTabData[9000] = 'y';
+    QBuffer otherTabFile(&otherTabData);
+    QVERIFY( otherTabFile.open(QIODevice::ReadOnly) );
+    QVERIFY( journalFile.seek(0) );
+    QVERIFY( !isItemJournalValid(&journalFile, &otherTabFile) );
+}
+
+void Tests::tabJournalInvalidBlock()
+{
+    ClipboardModel model;
+    createTestItems(&model);
+    ItemJournal journal(&model);
+
+    // Removed rows exist only in the original model, not in the empty target model.
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("D") );
+    model.insertItem(data, 0);
+    model.removeRows(0, model.rowCount());
+    const QByteArray block = journal.serializeBlock();
+
+    QBuffer journalFile;
+    QVERIFY( journalFile.open(QIODevice::ReadWrite) );
+    {
+        QDataStream stream(&journalFile);
+        stream.setVersion(QDataStream::Qt_4_7);
+        stream << block;
+    }
+
+    // No change from invalid block is applied.
+    ClipboardModel model2;
+    QVERIFY( journalFile.seek(0) );
+    QVERIFY( !replayItemJournal(&model2, &journalFile, 100) );
+    QCOMPARE( model2.rowCount(), 0 );
+}
+
+void Tests::tabJournalTimes()
+{
+    ClipboardModel model;
+    ItemJournal journal(&model);
+    createTestItems(&model);
+
+    // Times set after inserting are recorded in separate small records.
+    const QByteArray insertBlock = journal.serializeBlock();
+    journal.reset();
+    const QModelIndex index = model.index(1, 0);
+    const qint64 lastUsedTime = model.data(index, contentType::lastUsedTime).toLongLong() + 1000;
+    model.setData(index, lastUsedTime, contentType::lastUsedTime);
+    const QByteArray timesBlock = journal.serializeBlock();
+    QVERIFY( timesBlock.size() < 100 );
+
+    QBuffer journalFile;
+    QVERIFY( journalFile.open(QIODevice::ReadWrite) );
+    {
+        QDataStream stream(&journalFile);
+        stream.setVersion(QDataStream::Qt_4_7);
+        stream << insertBlock << timesBlock;
+    }
+
+    ClipboardModel model2;
+    QVERIFY( journalFile.seek(0) );
+    QVERIFY( replayItemJournal(&model2, &journalFile, 100) );
+    QCOMPARE( model2.rowCount(), model.rowCount() );
+
+    for (int row = 0; row < model.rowCount(); ++row) {
+        const QModelIndex index1 = model.index(row, 0);
+        const QModelIndex index2 = model2.index(row, 0);
+        QCOMPARE( model2.data(index2, contentType::createdTime).toLongLong(),
+                  model.data(index1, contentType::createdTime).toLongLong() );
+        QCOMPARE( model2.data(index2, contentType::lastUsedTime).toLongLong(),
+                  model.data(index1, contentType::lastUsedTime).toLongLong() );
+        QCOMPARE( model2.data(index2, contentType::data).toMap(),
+                  model.data(index1, contentType::data).toMap() );
+    }
+    QCOMPARE( model2.data(model2.index(1, 0), contentType::lastUsedTime).toLongLong(), lastUsedTime );
+}
+
+void Tests::indexedTabFile()
+{
+    ClipboardModel model;
+    createTestItems(&model);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file) );
+    QCOMPARE( itemBlobReferences(&file), QStringList() );
+
+    ClipboardModel model2;
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&model2, &file, 100) );
+    QCOMPARE( model2.rowCount(), model.rowCount() );
+
+    for (int row = 0; row < model.rowCount(); ++row) {
+        const QModelIndex index = model.index(row, 0);
+        const QModelIndex index2 = model2.index(row, 0);
+
+        // Hash, times and formats are available without decoding item data.
+        const auto itemData = model2.data(index2, contentType::serializedData).value<SerializedItemData>();
+        QVERIFY( !itemData.bytes.isEmpty() );
+        QVERIFY( itemData.hasFormats );
+        QVERIFY( itemData.hash != 0 );
+        QCOMPARE( itemData.hash, model.data(index, contentType::hash).toULongLong() );
+        QCOMPARE( itemData.createdTime, model.data(index, contentType::createdTime).toLongLong() );
+        QCOMPARE( itemData.lastUsedTime, model.data(index, contentType::lastUsedTime).toLongLong() );
+
+        const QVariantMap data = model.data(index, contentType::data).toMap();
+        QCOMPARE( itemData.formats.size(), data.size() );
+        int i = 0;
+        for (auto it = data.constBegin(); it != data.constEnd(); ++it, ++i) {
+            const auto &format = itemData.formats[i];
+            QCOMPARE( format.mime, it.key() );
+            QCOMPARE( format.size, static_cast<qint64>(it.value().toByteArray().size()) );
+            const bool compressed = it.key() == mimeText && format.size > 1000;
+            QCOMPARE( format.flags, compressed ? int(SerializedFormatInfo::Compressed) : 0 );
+        }
+
+        // Item data are decoded lazily.
+        QCOMPARE( model2.data(index2, contentType::data).toMap(), data );
+    }
+
+    // Model limits number of loaded items.
+    ClipboardModel model3;
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&model3, &file, 2) );
+    QCOMPARE( model3.rowCount(), 2 );
+    QCOMPARE( model3.data(model3.index(1, 0), contentType::data).toMap(),
+              model.data(model.index(1, 0), contentType::data).toMap() );
+
+    // Unmodified items are saved as loaded.
+    ClipboardModel model4;
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&model4, &file, 100) );
+    QTemporaryFile file2;
+    QVERIFY( file2.open() );
+    QVERIFY( serializeData(model4, &file2) );
+    QVERIFY( file.seek(0) );
+    QVERIFY( file2.seek(0) );
+    QCOMPARE( file2.readAll(), file.readAll() );
+}
+
+void Tests::indexedTabFileCorrupted()
+{
+    ClipboardModel model;
+    createTestItems(&model);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file) );
+
+    // Offset table follows format version and number of items.
+    const qint64 secondOffsetPosition = 4 + 4 + 8;
+    QVERIFY( file.seek(secondOffsetPosition) );
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_7);
+    stream << file.size() + 1;
+    QCOMPARE( stream.status(), QDataStream::Ok );
+
+    QVERIFY( file.seek(0) );
+    ClipboardModel model2;
+    QVERIFY( !deserializeData(&model2, &file, 100) );
+    QCOMPARE( model2.rowCount(), 0 );
+
+    // Offsets out of order.
+    QVERIFY( file.seek(secondOffsetPosition) );
+    stream << static_cast<qint64>(0);
+    QVERIFY( file.seek(0) );
+    QVERIFY( !deserializeData(&model2, &file, 100) );
+    QCOMPARE( model2.rowCount(), 0 );
+}
+
+void Tests::itemBlobs()
+{
+    const QByteArray bytes = generateIncompressibleData(2000);
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("A") );
+    data.insert( "image/png", bytes );
+
+    ClipboardModel model;
+    model.insertItem(data, 0);
+
+    // Big data are stored in blob directory and referenced by hash.
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file, 1000) );
+    QVERIFY( file.size() < bytes.size() );
+
+    QVERIFY( file.seek(0) );
+    const QStringList blobs = itemBlobReferences(&file);
+    QCOMPARE( blobs.size(), 1 );
+    const QString blobPath = itemBlobDirectoryPath() + '/' + blobs[0];
+    QFile blobFile(blobPath);
+    QVERIFY( blobFile.open(QIODevice::ReadOnly) );
+    QCOMPARE( blobFile.readAll(), bytes );
+    blobFile.close();
+
+    {
+        ClipboardModel model2;
+        QVERIFY( file.seek(0) );
+        QVERIFY( deserializeData(&model2, &file, 100) );
+        QCOMPARE( model2.rowCount(), 1 );
+        QCOMPARE( model2.itemBlobFilePath(0, "image/png"), blobPath );
+        QCOMPARE( model2.itemBlobFilePath(0, mimeText), QString() );
+
+        const auto itemData = model2.data(model2.index(0, 0), contentType::serializedData).value<SerializedItemData>();
+        QCOMPARE( itemData.formats.size(), 2 );
+        QCOMPARE( itemData.formats[0].flags, int(SerializedFormatInfo::InBlob) );
+        QCOMPARE( itemData.formats[0].size, static_cast<qint64>(bytes.size()) );
+        QCOMPARE( itemData.formats[1].flags, 0 );
+
+        QCOMPARE( model2.data(model2.index(0, 0), contentType::data).toMap(), data );
+    }
+
+    // Blobs referenced from item data in memory are not removed.
+    SerializedItemData serializedData = serializeItemData(data, 1000);
+    QVERIFY( serializedData.owner != nullptr );
+    QCOMPARE( itemBlobFilePath(serializedData.bytes, "image/png"), blobPath );
+    removeUnreferencedItemBlob(blobs[0]);
+    QVERIFY( QFile::exists(blobPath) );
+
+    serializedData = SerializedItemData();
+    removeUnreferencedItemBlob(blobs[0]);
+    QVERIFY( !QFile::exists(blobPath) );
+}
+
+void Tests::itemBlobMissing()
+{
+    QVariantMap data;
+    data.insert( mimeText, QByteArray("A") );
+    data.insert( "image/png", generateIncompressibleData(2000) );
+
+    ClipboardModel model;
+    model.insertItem(data, 0);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file, 1000) );
+
+    QVERIFY( file.seek(0) );
+    const QStringList blobs = itemBlobReferences(&file);
+    QCOMPARE( blobs.size(), 1 );
+    QVERIFY( QFile::remove(itemBlobDirectoryPath() + '/' + blobs[0]) );
+
+    // Item is loaded and lists formats with missing data.
+    ClipboardModel model2;
+    QVERIFY( file.seek(0) );
+    QVERIFY( deserializeData(&model2, &file, 100) );
+    QCOMPARE( model2.rowCount(), 1 );
+
+    QVariantMap expectedData;
+    expectedData.insert( mimeText, QByteArray("A") );
+    expectedData.insert( mimeMissingData, QByteArray("image/png") );
+    QCOMPARE( model2.data(model2.index(0, 0), contentType::data).toMap(), expectedData );
+
+    // Same for items decoded without model.
+    const auto itemData = model2.data(model2.index(0, 0), contentType::serializedData).value<SerializedItemData>();
+    QVariantMap decodedData;
+    QVERIFY( deserializeStoredData(&decodedData, itemData.bytes) );
+    QCOMPARE( decodedData, expectedData );
+}
+
+void Tests::itemBlobReferenceFromExternalData()
+{
+    QTemporaryFile secretFile;
+    QVERIFY( secretFile.open() );
+    QVERIFY( secretFile.write("SECRET") != -1 );
+    QVERIFY( secretFile.flush() );
+
+    // Item data with format referring to a file outside blob directory.
+    const QString blobMime = COPYQ_MIME_PREFIX "blob:image/png";
+    const QString secretPath = QDir( itemBlobDirectoryPath() ).relativeFilePath( secretFile.fileName() );
+    QByteArray bytes;
+    {
+        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        stream << static_cast<qint32>(-2) << static_cast<qint32>(2)
+               << QString("0" + QString(mimeText)) << false << QByteArray("A")
+               << QString("0" + blobMime) << false << secretPath.toLatin1();
+    }
+
+    QVariantMap expectedData;
+    expectedData.insert( mimeText, QByteArray("A") );
+
+    // Blob formats from clipboard, scripts or imported files are dropped.
+    QVariantMap data;
+    QVERIFY( deserializeData(&data, bytes) );
+    QCOMPARE( data, expectedData );
+
+    // Invalid blob references in own files are not followed.
+    data.clear();
+    QVERIFY( deserializeStoredData(&data, bytes) );
+    QVERIFY( !data.values().contains(QByteArray("SECRET")) );
+    QCOMPARE( data.value(mimeMissingData).toByteArray(), QByteArray("image/png") );
+
+    // Blob formats cannot be stored from item data.
+    QVariantMap dataWithBlob = expectedData;
+    dataWithBlob.insert( blobMime, QByteArray(64, 'a') );
+    data.clear();
+    QVERIFY( deserializeStoredData(&data, serializeData(dataWithBlob)) );
+    QCOMPARE( data, expectedData );
+}
+
+void Tests::itemBlobsRemovedWithTabs()
+{
+    RUN("config" << "item_data_threshold" << "1000", "1000\n");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+
+    const QByteArray data = generateIncompressibleData(2000);
+    const Args args1 = Args("tab") << testTab(1);
+    const Args args2 = Args("tab") << testTab(2);
+    RUN_WITH_INPUT(args1 << "add" << "-", "", data);
+    RUN_WITH_INPUT(args2 << "add" << "-", "", data);
+    RUN("tab" << testTab(3) << "add" << "X", "");
+    TEST( m_test->stopServer() );
+
+    // Same data are stored once.
+    QDir blobDir( itemBlobDirectoryPath() );
+    QCOMPARE( blobDir.entryList(QDir::Files).size(), 1 );
+
+    TEST( m_test->startServer() );
+    RUN(args1 << "read" << "0", data);
+
+    // Data are kept while other tab uses them.
+    RUN("removeTab" << testTab(1), "");
+    QCOMPARE( blobDir.entryList(QDir::Files).size(), 1 );
+    RUN(args2 << "read" << "0", data);
+
+    // Unused data are removed when tab items are saved or removed.
+    // Items of removed tab can be still in memory so restart first.
+    RUN("removeTab" << testTab(2), "");
+    TEST( m_test->stopServer() );
+    TEST( m_test->startServer() );
+    RUN("removeTab" << testTab(3), "");
+    QCOMPARE( blobDir.entryList(QDir::Files), QStringList() );
+}
+
+void Tests::itemBlobsReferencedFromLoadedItems()
+{
+    ClipboardModel model;
+    createTestItems(&model);
+
+    QTemporaryFile file;
+    QVERIFY( file.open() );
+    QVERIFY( serializeData(model, &file, 1000) );
+    QVERIFY( file.seek(0) );
+    const QStringList blobs = itemBlobReferences(&file);
+    QCOMPARE( blobs.size(), 2 );
+
+    // Loaded item dragged to other tab keeps blobs after the source tab is unloaded.
+    ClipboardModel model3;
+    {
+        ClipboardModel model2;
+        QVERIFY( file.seek(0) );
+        QVERIFY( deserializeData(&model2, &file, 100) );
+
+        // Blobs are kept while tab is loaded.
+        for (const auto &hash : blobs) {
+            removeUnreferencedItemBlob(hash);
+            QVERIFY( QFile::exists(itemBlobDirectoryPath() + '/' + hash) );
+        }
+
+        QVERIFY( model3.insertRows(0, 1) );
+        const QVariant serializedData = model2.data(model2.index(1, 0), contentType::serializedData);
+        QVERIFY( model3.setData(model3.index(0, 0), serializedData, contentType::serializedData) );
+    }
+    file.close();
+    QVERIFY( file.remove() );
+
+    for (const auto &hash : blobs) {
+        removeUnreferencedItemBlob(hash);
+        QVERIFY( QFile::exists(itemBlobDirectoryPath() + '/' + hash) );
+    }
+
+    QCOMPARE( model3.data(model3.index(0, 0), contentType::data).toMap(),
+              model.data(model.index(1, 0), contentType::data).toMap() );
+}
+
+void Tests::itemBlobsReferencedFromJournal()
+{
+    const QString blobDirPath = itemBlobDirectoryPath();
+    ClipboardModel model;
+    createTestItems(&model);
+
+    const auto saveTab = [](const QString &tabName, const ClipboardModel &tabModel) {
+        QFile tabFile( itemFilePath(tabName) );
+        return tabFile.open(QIODevice::WriteOnly) && serializeData(tabModel, &tabFile, 1000);
+    };
+    QVERIFY( saveTab(testTab(1), model) );
+
+    QStringList blobs;
+    {
+        // Tab is loaded after restart and item is dragged to other tab.
+        QFile tabFile( itemFilePath(testTab(1)) );
+        QVERIFY( tabFile.open(QIODevice::ReadOnly) );
+        blobs = itemBlobReferences(&tabFile);
+        QCOMPARE( blobs.size(), 2 );
+        ClipboardModel model2;
+        QVERIFY( tabFile.seek(0) );
+        QVERIFY( deserializeData(&model2, &tabFile, 100) );
+
+        ClipboardModel model3;
+        QVERIFY( saveTab(testTab(2), model3) );
+        ItemJournal journal(&model3);
+        QVERIFY( model3.insertRows(0, 1) );
+        const QVariant serializedData = model2.data(model2.index(1, 0), contentType::serializedData);
+        QVERIFY( model3.setData(model3.index(0, 0), serializedData, contentType::serializedData) );
+
+        // Target tab is saved to journal.
+        QFile tabFile2( itemFilePath(testTab(2)) );
+        QVERIFY( tabFile2.open(QIODevice::ReadOnly) );
+        QFile journalFile( itemJournalFilePath(testTab(2)) );
+        QVERIFY( journalFile.open(QIODevice::WriteOnly) );
+        writeItemJournalHeader(&journalFile, &tabFile2);
+        QDataStream stream(&journalFile);
+        stream.setVersion(QDataStream::Qt_4_7);
+        stream << journal.serializeBlock();
+    }
+
+    // Source tab no longer references the blobs and items are not in memory.
+    model.removeRows(1, 1);
+    QVERIFY( saveTab(testTab(1), model) );
+
+    // Saving other tab keeps blobs referenced from journal.
+    removeItems( testTab(3) );
+    for (const auto &hash : blobs)
+        QVERIFY( QFile::exists(blobDirPath + '/' + hash) );
+
+    QFile journalFile( itemJournalFilePath(testTab(2)) );
+    QVERIFY( journalFile.open(QIODevice::ReadOnly) );
+    QCOMPARE( itemJournalBlobReferences(&journalFile).toSet(), blobs.toSet() );
+    journalFile.close();
+
+    QVERIFY( QFile::remove(journalFile.fileName()) );
+    removeItems( testTab(3) );
+    for (const auto &hash : blobs)
+        QVERIFY( !QFile::exists(blobDirPath + '/' + hash) );
+}
+
+void Tests::moveRowRanges()
+{
+    ClipboardModel model;
+    for (int i = 7; i >= 0; --i)
+        model.insertItem( createDataMap(mimeText, QString::number(i)), 0 );
+    QCOMPARE( itemTexts(model), QString("0,1,2,3,4,5,6,7") );
+
+    // Moving range to one of its rows keeps the order.
+    QCOMPARE( model.moveRowRanges(RowRanges() << RowRange{2, 5}, 4), 2 );
+    QCOMPARE( itemTexts(model), QString("0,1,2,3,4,5,6,7") );
+
+    QCOMPARE( model.moveRowRanges(RowRanges() << RowRange{1, 1} << RowRange{3, 3}, 4), 2 );
+    QCOMPARE( itemTexts(model), QString("0,2,1,3,4,5,6,7") );
+
+    QCOMPARE( model.moveRowRanges(RowRanges() << RowRange{1, 2} << RowRange{5, 1}, 0), 0 );
+    QCOMPARE( itemTexts(model), QString("2,1,5,0,3,4,6,7") );
+
+    QCOMPARE( model.moveRowRanges(RowRanges() << RowRange{0, 1} << RowRange{3, 2}, 8), 5 );
+    QCOMPARE( itemTexts(model), QString("1,5,4,6,7,2,0,3") );
+}
+
 void Tests::action()
 {
     const Args args = Args("tab") << testTab(1);
@@ -2525,6 +3559,19 @@ void Tests::configPathEnvVariable()
     QCOMPARE( out.left(expectedOut.size()), expectedOut );
 }
 
+void Tests::infoMetrics()
+{
+    RUN("info('metrics').indexOf('copyq_script_executions_total') != -1", "true\n");
+    RUN("info('metrics').indexOf('copyq_timer_wakeups_total') != -1", "true\n");
+}
+
+void Tests::infoCommands()
+{
+    // Statistics are available after previous client finishes.
+    RUN("print" << "TEST", "TEST");
+    RUN("info('commands').indexOf(': runs=') != -1", "true\n");
+}
+
 void Tests::shortcutCommand()
 {
     RUN("setCommands([{name: 'test', inMenu: true, shortcuts: ['Ctrl+F1'], cmd: 'copyq add OK'}])", "");
@@ -2697,6 +3744,58 @@ void Tests::shortcutCommandSelectedAndCurrent()
     WAIT_ON_OUTPUT("tab" << tab1 << "read(0)", "1,2|2|" + tab1.toUtf8());
 }
 
+void Tests::shortcutCommandScriptInServer()
+{
+    // Script commands are run in the server without new client process.
+    const auto tab1 = testTab(1);
+    const auto script = R"(
+        setCommands([{
+            name: 'Script with input and output',
+            inMenu: true,
+            shortcuts: ['Ctrl+F1'],
+            input: 'text/plain',
+            output: 'text/plain',
+            outputTab: ')" + tab1 + R"(',
+            cmd: 'copyq: sleep(100);'
+               + 'var result = execute("copyq", "read", "1");'
+               + 'print(str(input()).toUpperCase() + "," + str(result.stdout))'
+        }])
+        )";
+    RUN(script, "");
+
+    RUN("add" << "b" << "a", "");
+    RUN("keys" << "CTRL+F1", "");
+    WAIT_ON_OUTPUT("tab" << tab1 << "read" << "0", "A,b");
+}
+
+void Tests::shortcutCommandScriptEnvironment()
+{
+    // Environment set by script run in the server is not shared with other scripts.
+    const auto script = R"(
+        setCommands([
+            {
+                name: 'Set environment',
+                inMenu: true,
+                shortcuts: ['Ctrl+F1'],
+                cmd: 'copyq: setEnv("COPYQ_TEST_VARIABLE", "SET"); add("1:" + str(env("COPYQ_TEST_VARIABLE")))'
+            },
+            {
+                name: 'Get environment',
+                inMenu: true,
+                shortcuts: ['Ctrl+F2'],
+                cmd: 'copyq: add("2:" + str(env("COPYQ_TEST_VARIABLE")))'
+            },
+        ])
+        )";
+    RUN(script, "");
+
+    RUN("keys" << "CTRL+F1", "");
+    WAIT_ON_OUTPUT("read" << "0", "1:SET");
+
+    RUN("keys" << "CTRL+F2", "");
+    WAIT_ON_OUTPUT("read" << "0", "2:");
+}
+
 void Tests::automaticCommandIgnore()
 {
     const auto script = R"(
@@ -2861,6 +3960,106 @@ void Tests::automaticCommandIgnoreSpecialFormat()
     WAIT_ON_OUTPUT("separator" << "," << "read" << "0" << "1" << "2" << "3", "SHOULD NOT BE IGNORED,CMD2,CMD1,");
 }
 
+void Tests::automaticCommandPersistent()
+{
+#ifndef Q_OS_WIN
+    QTemporaryDir tmpDir;
+    QVERIFY( tmpDir.isValid() );
+    const QString logPath = tmpDir.path() + "/log";
+
+    // Program logs received items with its process ID and replies with empty data.
+    const auto script = QString(R"(
+        setCommands([{
+            automatic: true,
+            persistent: true,
+            cmd: 'sh:while read size; do head -c "$size" >> "%1"; echo " $$" >> "%1"; echo 0; done'
+        }])
+        )").arg(logPath);
+    RUN(script, "");
+
+    const auto readLog = [&](int lineCount) {
+        QStringList lines;
+        SleepTimer t(8000);
+        do {
+            QFile logFile(logPath);
+            if ( logFile.open(QIODevice::ReadOnly) )
+                lines = QString::fromUtf8(logFile.readAll()).split('\n', QString::SkipEmptyParts);
+        } while (lines.size() < lineCount && t.sleep());
+        return lines;
+    };
+
+    TEST( m_test->setClipboard("A") );
+    WAIT_ON_OUTPUT("read" << "0", "A");
+    QCOMPARE( readLog(1).size(), 1 );
+
+    // Same process receives next item.
+    TEST( m_test->setClipboard("B") );
+    WAIT_ON_OUTPUT("read" << "0", "B");
+    const QStringList lines = readLog(2);
+    QCOMPARE( lines.size(), 2 );
+    QVERIFY( lines[0].startsWith("A ") );
+    QVERIFY( lines[1].startsWith("B ") );
+    QCOMPARE( lines[0].mid(2), lines[1].mid(2) );
+#endif
+}
+
+void Tests::automaticCommandParallel()
+{
+#ifndef Q_OS_WIN
+    QTemporaryDir tmpDir;
+    QVERIFY( tmpDir.isValid() );
+    const QString logPath = tmpDir.path() + "/log";
+
+    // Second command doesn't wait for the first one.
+    const auto script = QString(R"(
+        setCommands([
+            {
+                automatic: true,
+                parallel: true,
+                cmd: 'sh:sleep 1; echo parallel >> "%1"'
+            },
+            {
+                automatic: true,
+                cmd: 'sh:echo serial >> "%1"'
+            },
+        ])
+        )").arg(logPath);
+    RUN(script, "");
+
+    RUN("commands()[0].parallel", "true\n");
+    RUN("commands()[1].parallel", "false\n");
+
+    TEST( m_test->setClipboard("A") );
+    WAIT_ON_OUTPUT("read" << "0", "A");
+
+    QFile logFile(logPath);
+    QVERIFY( logFile.open(QIODevice::ReadOnly) );
+    QCOMPARE( logFile.readAll().data(), QByteArray("serial\nparallel\n").data() );
+#endif
+}
+
+void Tests::automaticCommandPersistentReply()
+{
+#ifndef Q_OS_WIN
+    // Program replies with upper-case text which replaces the item text.
+    const auto script = R"(
+        setCommands([{
+            automatic: true,
+            persistent: true,
+            cmd: 'sh:while read size; do data=$(head -c "$size" | tr a-z A-Z); echo "${#data}"; printf %s "$data"; done'
+        }])
+        )";
+    RUN(script, "");
+
+    TEST( m_test->setClipboard("abc") );
+    WAIT_ON_OUTPUT("read" << "0", "ABC");
+
+    TEST( m_test->setClipboard("def") );
+    WAIT_ON_OUTPUT("read" << "0", "DEF");
+    RUN("size", "2\n");
+#endif
+}
+
 void Tests::scriptCommandLoaded()
 {
     const auto script = R"(
@@ -3217,10 +4416,30 @@ int runTests(int argc, char *argv[])
 {
     QRegExp onlyPlugins;
     bool runPluginTests = true;
+    bool runStressTests = false;
+    bool runClientBenchmarks = false;
+    QString benchmarkResultsFileName;
 
     if (argc > 1) {
         QString arg = argv[1];
-        if (arg.startsWith("PLUGINS:")) {
+        if (arg.startsWith("BENCHMARKS")) {
+            arg.remove(QRegExp("^BENCHMARKS:?"));
+            return runBenchmarks(argc - 1, argv + 1, arg);
+        }
+
+        if (arg.startsWith("CLIENT_BENCHMARKS")) {
+            arg.remove(QRegExp("^CLIENT_BENCHMARKS:?"));
+            benchmarkResultsFileName = arg;
+            runClientBenchmarks = true;
+            runPluginTests = false;
+            --argc;
+            ++argv;
+        } else if (arg == "STRESS") {
+            runStressTests = true;
+            runPluginTests = false;
+            --argc;
+            ++argv;
+        } else if (arg.startsWith("PLUGINS:")) {
             arg.remove(QRegExp("^PLUGINS:"));
             onlyPlugins.setPattern(arg);
             onlyPlugins.setCaseSensitivity(Qt::CaseInsensitive);
@@ -3246,7 +4465,15 @@ int runTests(int argc, char *argv[])
     std::shared_ptr<TestInterfaceImpl> test(new TestInterfaceImpl);
     Tests tc(test);
 
-    if (onlyPlugins.isEmpty()) {
+    if (runClientBenchmarks) {
+        ClientBenchmarks clientBenchmarks(test);
+        test->setupTest("CORE", QVariant());
+        exitCode = execBenchmarks(&clientBenchmarks, argc, argv, benchmarkResultsFileName);
+    } else if (runStressTests) {
+        StressTests stressTests(test);
+        test->setupTest("CORE", QVariant());
+        exitCode = QTest::qExec(&stressTests, argc, argv);
+    } else if (onlyPlugins.isEmpty()) {
         test->setupTest("CORE", QVariant());
         exitCode = QTest::qExec(&tc, argc, argv);
     }
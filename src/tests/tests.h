@@ -54,6 +54,7 @@ private slots:
     void commandEvalThrows();
     void commandEvalSyntaxError();
     void commandEvalArguments();
+    void commandEvalLines();
     void commandPrint();
     void commandAbort();
     void commandFail();
@@ -69,6 +70,7 @@ private slots:
     void commandsUnicode();
 
     void commandsAddRead();
+    void commandsAddMany();
     void commandsWriteRead();
     void commandChange();
 
@@ -84,6 +86,8 @@ private slots:
     void commandsBase64();
     void commandsGetSetItem();
 
+    void commandsGetItems();
+    void commandSnapshot();
     void commandsChecksums();
 
     void commandEscapeHTML();
@@ -111,6 +115,8 @@ private slots:
     void commandSelectItems();
 
     void commandsExportImport();
+    void commandsExportImportIncremental();
+    void commandsImportDataMerge();
 
     void commandsGetSetCommands();
 
@@ -150,8 +156,15 @@ private slots:
     void selectItems();
 
     void moveItems();
+    void sortItems();
+    void searchAllTabs();
+    void findItem();
+    void transaction();
     void deleteItems();
     void searchItems();
+    void searchItemsIncrementally();
+    void searchItemsWithTextIndex();
+    void searchItemsInBackground();
     void searchRowNumber();
     void copyItems();
 
@@ -164,12 +177,32 @@ private slots:
     void editNotes();
 
     void toggleClipboardMonitoring();
+    void ignoredWindows();
 
     void clipboardToItem();
     void itemToClipboard();
     void tabAdd();
     void tabRemove();
     void tabIcon();
+    void tabExpiry();
+    void tabJournal();
+    void tabJournalOutdated();
+    void tabJournalIncompleteBlock();
+    void tabJournalCompaction();
+    void tabJournalTimes();
+    void tabJournalTabFileHash();
+    void itemHashesCountedLazily();
+    void tabJournalInvalidBlock();
+    void tabBackgroundSave();
+    void indexedTabFile();
+    void indexedTabFileCorrupted();
+    void itemBlobs();
+    void itemBlobMissing();
+    void itemBlobReferenceFromExternalData();
+    void itemBlobsRemovedWithTabs();
+    void itemBlobsReferencedFromLoadedItems();
+    void itemBlobsReferencedFromJournal();
+    void moveRowRanges();
     void action();
     void insertRemoveItems();
     void renameTab();
@@ -202,6 +235,10 @@ private slots:
 
     void configPathEnvVariable();
 
+    void infoMetrics();
+
+    void infoCommands();
+
     void shortcutCommand();
     void shortcutCommandOverrideEnter();
     void shortcutCommandMatchInput();
@@ -212,6 +249,8 @@ private slots:
     void shortcutCommandSelectedItemsData();
     void shortcutCommandSetSelectedItemsData();
     void shortcutCommandSelectedAndCurrent();
+    void shortcutCommandScriptInServer();
+    void shortcutCommandScriptEnvironment();
 
     void automaticCommandIgnore();
     void automaticCommandRemove();
@@ -224,6 +263,9 @@ private slots:
     void automaticCommandCopyToTab();
     void automaticCommandStoreSpecialFormat();
     void automaticCommandIgnoreSpecialFormat();
+    void automaticCommandPersistent();
+    void automaticCommandPersistentReply();
+    void automaticCommandParallel();
 
     void scriptCommandLoaded();
     void scriptCommandAddFunction();